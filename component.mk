@@ -5,11 +5,89 @@
 COMPONENT_SRCDIRS := wolfssl/src wolfssl/wolfcrypt/src
 COMPONENT_SRCDIRS += wolfssl/wolfcrypt/src/port/Espressif
 COMPONENT_SRCDIRS += wolfssl/wolfcrypt/src/port/atmel
+COMPONENT_SRCDIRS += port
 
 COMPONENT_ADD_INCLUDEDIRS := port wolfssl
+COMPONENT_ADD_LDFRAGMENTS += linker.lf
 
 CFLAGS +=-DWOLFSSL_USER_SETTINGS -Wno-cpp -Wno-maybe-uninitialized
 
+# Hardware acceleration counters, see port/esp_wolfssl_hw_metrics.c
+ifdef CONFIG_WOLFSSL_HW_METRICS_API
+WOLFSSL_HW_METRICS_WRAP := esp_CryptHwMutexLock esp_sha_try_hw_lock \
+                           esp_sha_process esp_sha256_process \
+                           esp_sha512_process wc_esp32AesSupportedKeyLen \
+                           wc_esp32AesEncrypt wc_esp32AesDecrypt \
+                           wc_esp32AesCbcEncrypt wc_esp32AesCbcDecrypt \
+                           esp_mp_mul esp_mp_mulmod esp_mp_exptmod
+COMPONENT_ADD_LDFLAGS += $(foreach sym,$(WOLFSSL_HW_METRICS_WRAP),-Wl,--wrap=$(sym))
+endif
+
+# Accounting domain per context and connection, see port/esp_wolfssl_mem.c
+ifdef CONFIG_WOLFSSL_MEM_ACCOUNTING_AUTO
+WOLFSSL_MEM_AUTO_WRAP := wolfSSL_CTX_new wolfSSL_new \
+                         wolfSSL_CTX_free wolfSSL_free \
+                         wolfSSL_connect wolfSSL_accept \
+                         wolfSSL_read wolfSSL_write wolfSSL_shutdown
+COMPONENT_ADD_LDFLAGS += $(foreach sym,$(WOLFSSL_MEM_AUTO_WRAP),-Wl,--wrap=$(sym))
+endif
+
+# OCSP response cache, see port/esp_wolfssl_ocsp_cache.c
+ifdef CONFIG_WOLFSSL_OCSP_CACHE
+COMPONENT_ADD_LDFLAGS += -Wl,--wrap=OcspResponseDecode
+endif
+
+# Hybrid key share and cipher order for every context, see
+# port/esp_wolfssl_pq.c and port/esp_wolfssl_hw_order.c
+ifneq ($(CONFIG_WOLFSSL_MLKEM_DEFAULT)$(CONFIG_WOLFSSL_HW_ORDER_DEFAULT),)
+COMPONENT_ADD_LDFLAGS += -Wl,--wrap=wolfSSL_CTX_new
+endif
+
+# Raw public keys for every connection, see port/esp_wolfssl_rpk.c
+ifdef CONFIG_WOLFSSL_RPK_DEFAULT
+COMPONENT_ADD_LDFLAGS += -Wl,--wrap=wolfSSL_new
+endif
+
+# Pre-generated ephemeral keys, see port/esp_wolfssl_keypool.c
+ifdef CONFIG_WOLFSSL_KEYPOOL
+COMPONENT_ADD_LDFLAGS += -Wl,--wrap=wc_ecc_make_key_ex -Wl,--wrap=wc_curve25519_make_key
+endif
+
+# Buffered random pool, see port/esp_wolfssl_rng.c
+ifdef CONFIG_WOLFSSL_RNG_POOL
+COMPONENT_ADD_LDFLAGS += -Wl,--wrap=wc_RNG_GenerateBlock
+endif
+
+# CA stores shared by esp-tls contexts, see port/esp_wolfssl_ctx_cache.c
+ifdef CONFIG_WOLFSSL_CTX_CACHE_ESP_TLS
+COMPONENT_ADD_LDFLAGS += -Wl,--wrap=wolfSSL_CTX_load_verify_buffer
+endif
+
+# Cached HMAC key states, see port/esp_wolfssl_hmac_cache.c
+ifdef CONFIG_WOLFSSL_HMAC_CACHE
+WOLFSSL_HMAC_CACHE_WRAP := wc_HmacUpdate wc_HmacFinal wolfSSL_free
+COMPONENT_ADD_LDFLAGS += $(foreach sym,$(WOLFSSL_HMAC_CACHE_WRAP),-Wl,--wrap=$(sym))
+endif
+
+# ECC peripheral, see port/esp_wolfssl_ecc_hw.c
+ifdef CONFIG_WOLFSSL_ECC_HW
+WOLFSSL_ECC_HW_WRAP := wc_ecc_make_key_ex wc_ecc_shared_secret \
+                       wc_ecc_verify_hash
+COMPONENT_ADD_LDFLAGS += $(foreach sym,$(WOLFSSL_ECC_HW_WRAP),-Wl,--wrap=$(sym))
+endif
+
+# Handshake tracing hooks, see port/esp_wolfssl_trace.c
+ifdef CONFIG_WOLFSSL_TRACE
+WOLFSSL_TRACE_WRAP := wolfSSL_connect wolfSSL_accept lwip_recv lwip_send \
+                      ParseCertRelative wc_RNG_GenerateBlock \
+                      wc_ecc_make_key_ex wc_ecc_shared_secret \
+                      wc_ecc_sign_hash wc_ecc_verify_hash \
+                      wc_curve25519_make_key wc_curve25519_shared_secret_ex \
+                      wc_RsaSSL_VerifyInline wc_RsaSSL_Sign \
+                      wc_RsaPSS_VerifyInline wc_RsaPSS_Sign
+COMPONENT_ADD_LDFLAGS += $(foreach sym,$(WOLFSSL_TRACE_WRAP),-Wl,--wrap=$(sym))
+endif
+
 COMPONENT_OBJEXCLUDE := wolfssl/wolfcrypt/src/aes_asm.o
 COMPONENT_OBJEXCLUDE += wolfssl/wolfcrypt/src/evp.o
 COMPONENT_OBJEXCLUDE += wolfssl/wolfcrypt/src/misc.o
@@ -0,0 +1,143 @@
+/* bench_arena.c
+ *
+ * Copyright (C) 2006-2024 wolfSSL Inc.
+ *
+ * This file is part of wolfSSL.
+ *
+ * wolfSSL is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfSSL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335, USA
+ */
+
+/* Allocations and time per TLS 1.3 handshake with WOLFSSL_SMALL_STACK,
+ * with the temporaries on the heap and in the per-task scratch arena of
+ * esp_wolfssl_arena.h. Both ends of an in-memory loopback run in this
+ * task, so they share its arena. Each handshake is one arena scope;
+ * reported are the allocations passed on to the heap and the ones served
+ * from the arena per handshake, the temporaries that did not fit, and the
+ * highest arena top.
+ *
+ * On the device, enable Example Configuration -> Benchmark scratch arena.
+ * On a Linux host, against a wolfSSL built with configure --enable-static
+ * --enable-smallstack CFLAGS="-DXMALLOC_USER
+ * -DXMALLOC=esp_wolfssl_arena_malloc -DXFREE=esp_wolfssl_arena_free
+ * -DXREALLOC=esp_wolfssl_arena_realloc":
+ *
+ *   gcc -O2 -DBENCH_ARENA_HOST_MAIN -DWOLFSSL_ESP_ARENA \
+ *       -include wolfssl/options.h -Imain/include -I../../port \
+ *       main/bench_arena.c main/tls_loopback.c ../../port/esp_wolfssl_arena.c \
+ *       -l:libwolfssl.a -lm -o arena
+ *   ./arena
+ */
+
+#include "bench_common.h"
+
+#if (defined(CONFIG_BENCH_ARENA) || defined(BENCH_ARENA_HOST_MAIN)) && \
+    defined(WOLFSSL_ESP_ARENA)
+
+#include <wolfssl/ssl.h>
+#include <wolfssl/wolfcrypt/error-crypt.h>
+
+#include "tls_loopback.h"
+#include "esp_wolfssl_arena.h"
+#include "main.h"
+
+#ifndef CONFIG_BENCH_ARENA_COUNT
+    #define CONFIG_BENCH_ARENA_COUNT 20
+#endif
+
+static const char* const TAG = "bench_arena";
+
+static int bench_arena_run(tls_loopback* lb, const char* name, int arena)
+{
+    esp_wolfssl_arena_stats_t stats;
+    int64_t total_us = 0;
+    int ret = 0;
+    int i;
+
+    esp_wolfssl_arena_set_enabled(arena);
+    esp_wolfssl_arena_reset_stats();
+
+    for (i = 0; ret == 0 && i < CONFIG_BENCH_ARENA_COUNT; i++) {
+        esp_wolfssl_arena_begin();
+        ret = tls_loopback_connect(lb);
+        esp_wolfssl_arena_end();
+        if (ret == 0) {
+            total_us += lb->stats.handshake_us;
+            tls_loopback_close(lb);
+        }
+    }
+    if (ret == 0) {
+        esp_wolfssl_arena_get_stats(&stats);
+        ESP_LOGI(TAG, "%-5s %6u heap and %6u arena allocations per "
+                      "handshake, %u overflows, peak %u bytes, %u scopes "
+                      "left blocks; %7lld us per handshake", name,
+                 (unsigned)(stats.heap_allocs / CONFIG_BENCH_ARENA_COUNT),
+                 (unsigned)(stats.arena_allocs / CONFIG_BENCH_ARENA_COUNT),
+                 (unsigned)stats.overflows, (unsigned)stats.peak_bytes,
+                 (unsigned)stats.held_over,
+                 (long long)(total_us / CONFIG_BENCH_ARENA_COUNT));
+    }
+    return ret;
+}
+
+int bench_arena(void)
+{
+    tls_loopback lb;
+    tls_loopback_cfg cfg;
+    int ret;
+
+    /* reference counted; the wolfCrypt benchmark cleans up after itself */
+    ret = wolfSSL_Init();
+    if (ret != WOLFSSL_SUCCESS) {
+        return ret;
+    }
+
+    XMEMSET(&cfg, 0, sizeof(cfg));
+    cfg.version = TLS_LOOPBACK_VERSION_13;
+    ret = tls_loopback_init(&lb, &cfg);
+    if (ret != 0) {
+        wolfSSL_Cleanup();
+        return ret;
+    }
+
+    ESP_LOGI(TAG, "TLS 1.3, %d handshakes per mode, arena of %d bytes",
+             CONFIG_BENCH_ARENA_COUNT, ESP_WOLFSSL_ARENA_SZ);
+    ret = bench_arena_run(&lb, "heap", 0);
+    if (ret != 0) {
+        ESP_LOGE(TAG, "without arena: %d", ret);
+    }
+    if (ret == 0) {
+        ret = bench_arena_run(&lb, "arena", 1);
+        if (ret != 0) {
+            ESP_LOGE(TAG, "with arena: %d", ret);
+        }
+    }
+    esp_wolfssl_arena_set_enabled(1);
+
+    tls_loopback_free(&lb);
+    if (esp_wolfssl_arena_release() != 0) {
+        ESP_LOGW(TAG, "arena still holds blocks");
+    }
+    wolfSSL_Cleanup();
+    return ret;
+}
+
+#ifdef BENCH_ARENA_HOST_MAIN
+int main(void)
+{
+    return (bench_arena() == 0) ? 0 : 1;
+}
+#endif
+
+#endif /* (CONFIG_BENCH_ARENA || BENCH_ARENA_HOST_MAIN) && WOLFSSL_ESP_ARENA */
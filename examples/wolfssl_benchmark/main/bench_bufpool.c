@@ -0,0 +1,134 @@
+/* bench_bufpool.c
+ *
+ * Copyright (C) 2006-2024 wolfSSL Inc.
+ *
+ * This file is part of wolfSSL.
+ *
+ * wolfSSL is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfSSL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335, USA
+ */
+
+/* Heap held by many open TLS 1.3 connections with and without the shared
+ * record-buffer pool of esp_wolfssl_bufpool.h. Connections are opened one
+ * by one over in-memory loopbacks, each exchanges a short echo and then
+ * stays idle; after each one the heap they hold together, and the largest
+ * free block, is reported. The contexts and pipes of the loopbacks are set
+ * up before and not counted. */
+
+#include "bench_common.h"
+
+#include "main.h"
+
+#if defined(CONFIG_BENCH_BUFPOOL) && defined(WOLFSSL_ESP_BUFPOOL)
+
+#include <string.h>
+
+#include <esp_heap_caps.h>
+
+#include <wolfssl/ssl.h>
+#include <wolfssl/wolfcrypt/error-crypt.h>
+
+#include "tls_loopback.h"
+#include "esp_wolfssl_bufpool.h"
+
+static const char* const TAG = "bench_bufpool";
+
+static tls_loopback bench_lb[CONFIG_BENCH_BUFPOOL_CONNS];
+
+static int bench_bufpool_run(const char* name, int pool)
+{
+    esp_wolfssl_bufpool_stats_t stats;
+    size_t heap_before;
+    size_t held;
+    int n = 0;
+    int ret = 0;
+    int i;
+
+    esp_wolfssl_bufpool_set_enabled(pool);
+    esp_wolfssl_bufpool_trim();
+    esp_wolfssl_bufpool_reset_stats();
+
+    for (i = 0; ret == 0 && i < CONFIG_BENCH_BUFPOOL_CONNS; i++) {
+        ret = tls_loopback_init(&bench_lb[i], NULL);
+        if (ret == 0) {
+            n++;
+        }
+    }
+
+    heap_before = heap_caps_get_free_size(MALLOC_CAP_DEFAULT);
+    heap_caps_monitor_local_minimum_free_size_start();
+
+    for (i = 0; ret == 0 && i < n; i++) {
+        ret = tls_loopback_connect(&bench_lb[i]);
+        if (ret == 0) {
+            ret = tls_loopback_echo(&bench_lb[i],
+                                    CONFIG_BENCH_BUFPOOL_ECHO_SIZE);
+        }
+        if (ret == 0) {
+            held = heap_before - heap_caps_get_free_size(MALLOC_CAP_DEFAULT);
+            ESP_LOGI(TAG, "%-8s %2d connections: %6u bytes held, %5u per "
+                          "connection, largest free block %6u", name, i + 1,
+                     (unsigned)held, (unsigned)(held / (size_t)(i + 1)),
+                     (unsigned)heap_caps_get_largest_free_block(
+                                                   MALLOC_CAP_DEFAULT));
+        }
+    }
+    if (ret == 0) {
+        esp_wolfssl_bufpool_get_stats(&stats);
+        ESP_LOGI(TAG, "%-8s peak %u bytes; pool %u buffers, %u borrowed at "
+                      "most, %u borrows, %u from the heap", name,
+                 (unsigned)(heap_before
+                    - heap_caps_get_minimum_free_size(MALLOC_CAP_DEFAULT)),
+                 (unsigned)stats.buffers, (unsigned)stats.peak_in_use,
+                 (unsigned)stats.borrows, (unsigned)stats.fallbacks);
+    }
+    heap_caps_monitor_local_minimum_free_size_stop();
+
+    for (i = 0; i < n; i++) {
+        tls_loopback_close(&bench_lb[i]);
+        tls_loopback_free(&bench_lb[i]);
+    }
+    return ret;
+}
+
+int bench_bufpool_compare(void)
+{
+    int ret;
+
+    /* reference counted; the wolfCrypt benchmark cleans up after itself */
+    ret = wolfSSL_Init();
+    if (ret != WOLFSSL_SUCCESS) {
+        return ret;
+    }
+
+    ESP_LOGI(TAG, "TLS 1.3, %d byte echo per connection, pool of %d x %d "
+                  "bytes", CONFIG_BENCH_BUFPOOL_ECHO_SIZE,
+             ESP_WOLFSSL_BUFPOOL_BUFFERS, ESP_WOLFSSL_BUFPOOL_BUFFER_SZ);
+    ret = bench_bufpool_run("heap", 0);
+    if (ret != 0) {
+        ESP_LOGE(TAG, "without pool: %d", ret);
+    }
+    if (ret == 0) {
+        ret = bench_bufpool_run("pool", 1);
+        if (ret != 0) {
+            ESP_LOGE(TAG, "with pool: %d", ret);
+        }
+    }
+    esp_wolfssl_bufpool_set_enabled(1);
+
+    wolfSSL_Cleanup();
+    return ret;
+}
+
+#endif /* CONFIG_BENCH_BUFPOOL && WOLFSSL_ESP_BUFPOOL */
@@ -0,0 +1,500 @@
+/* bench_cert.c
+ *
+ * Copyright (C) 2006-2024 wolfSSL Inc.
+ *
+ * This file is part of wolfSSL.
+ *
+ * wolfSSL is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfSSL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335, USA
+ */
+
+/* Certificate parsing: every certificate of a corpus of real chains is
+ * parsed CONFIG_BENCH_CERT_COUNT times by wolfSSL's ParseCert() into a
+ * DecodedCert, and into a lazy certificate view (esp_wolfssl_cert_view.h)
+ * that then decodes what a chain check reads: validity, basic constraints,
+ * key usage and the subject CN. Reports time per parse and peak heap of
+ * both, and checks each chain once with esp_wolfssl_cert_view_verify_chain().
+ * The built-in corpus is the public roots of cert_corpus.h and the test
+ * chain of ocsp_test_data.h.
+ *
+ * The same source is a host harness for other corpora, against an
+ * installed wolfSSL:
+ *
+ *   gcc -O2 -DBENCH_CERT_HOST_MAIN -Imain/include -I../../port \
+ *       main/bench_cert.c ../../port/esp_wolfssl_cert_view.c \
+ *       ../../port/esp_wolfssl_der.c -lwolfssl -o cert_parse
+ *   ./cert_parse                               (the built-in corpus)
+ *   ./cert_parse [count=N] chain.pem ...       (PEM or DER, leaf first)
+ *
+ * with chains saved from servers, e.g.
+ *
+ *   openssl s_client -connect example.com:443 -showcerts \
+ *       </dev/null >example.pem
+ *
+ * The last certificate of a chain file is its trust anchor. The exit
+ * status is 0 when every certificate parsed both ways. */
+
+#include "bench_common.h"
+
+#include "main.h"
+
+#if defined(CONFIG_BENCH_CERT) || defined(BENCH_CERT_HOST_MAIN)
+
+#include <string.h>
+#include <sys/time.h>
+#include <time.h>
+
+#ifdef ESP_PLATFORM
+    #include <esp_heap_caps.h>
+#else
+    #include <stdlib.h>
+#endif
+
+#include <wolfssl/ssl.h>
+#include <wolfssl/wolfcrypt/types.h>
+#include <wolfssl/wolfcrypt/error-crypt.h>
+#include <wolfssl/wolfcrypt/asn.h>
+#include <wolfssl/wolfcrypt/asn_public.h>
+#include <wolfssl/wolfcrypt/memory.h>
+
+#include "esp_wolfssl_cert_view.h"
+
+#include "cert_corpus.h"
+#include "ocsp_test_data.h"
+
+#ifndef CONFIG_BENCH_CERT_COUNT
+    #define CONFIG_BENCH_CERT_COUNT 100
+#endif
+
+#define BENCH_CERT_CHAIN_MAX 8
+
+/* after the notBefore of ocsp_ca_der: 2026-10-20 */
+#define BENCH_CERT_MIN_TIME 1792540800
+
+static const char* const TAG = "bench_cert";
+
+typedef struct bench_cert_chain {
+    const char*          name;
+    int                  n;
+    const unsigned char* der[BENCH_CERT_CHAIN_MAX];
+    word32               sz[BENCH_CERT_CHAIN_MAX];
+} bench_cert_chain;
+
+typedef struct bench_cert_result {
+    int64_t wolf_us;
+    int64_t view_us;
+    size_t  wolf_heap;
+    size_t  view_heap;
+    int     certs;
+    int     failed;
+} bench_cert_result;
+
+#ifdef ESP_PLATFORM
+static size_t bench_cert_heap_free;
+
+static void bench_cert_heap_start(void)
+{
+    bench_cert_heap_free = heap_caps_get_free_size(MALLOC_CAP_DEFAULT);
+    heap_caps_monitor_local_minimum_free_size_start();
+}
+
+static size_t bench_cert_heap_peak(void)
+{
+    size_t peak = bench_cert_heap_free
+                - heap_caps_get_minimum_free_size(MALLOC_CAP_DEFAULT);
+
+    heap_caps_monitor_local_minimum_free_size_stop();
+    return peak;
+}
+#elif defined(USE_WOLFSSL_MEMORY) && !defined(WOLFSSL_STATIC_MEMORY) && \
+      !defined(WOLFSSL_DEBUG_MEMORY)
+/* wolfSSL's allocations only, through its allocator hooks; each block
+ * carries its size in front */
+#define BENCH_CERT_HDR 16
+
+static wolfSSL_Malloc_cb  bench_cert_malloc_prev;
+static wolfSSL_Free_cb    bench_cert_free_prev;
+static wolfSSL_Realloc_cb bench_cert_realloc_prev;
+static size_t bench_cert_cur;
+static size_t bench_cert_peak;
+
+static void* bench_cert_malloc(size_t sz)
+{
+    byte* p = (byte*)malloc(sz + BENCH_CERT_HDR);
+
+    if (p == NULL) {
+        return NULL;
+    }
+    memcpy(p, &sz, sizeof(sz));
+    bench_cert_cur += sz;
+    if (bench_cert_cur > bench_cert_peak) {
+        bench_cert_peak = bench_cert_cur;
+    }
+    return p + BENCH_CERT_HDR;
+}
+
+static void bench_cert_free(void* ptr)
+{
+    byte* p = (byte*)ptr;
+    size_t sz;
+
+    if (p != NULL) {
+        p -= BENCH_CERT_HDR;
+        memcpy(&sz, p, sizeof(sz));
+        bench_cert_cur -= sz;
+        free(p);
+    }
+}
+
+static void* bench_cert_realloc(void* ptr, size_t sz)
+{
+    byte* p = (byte*)bench_cert_malloc(sz);
+    size_t old;
+
+    if (p != NULL && ptr != NULL) {
+        memcpy(&old, (byte*)ptr - BENCH_CERT_HDR, sizeof(old));
+        memcpy(p, ptr, (old < sz) ? old : sz);
+        bench_cert_free(ptr);
+    }
+    return p;
+}
+
+static void bench_cert_heap_start(void)
+{
+    bench_cert_cur = 0;
+    bench_cert_peak = 0;
+    wolfSSL_GetAllocators(&bench_cert_malloc_prev, &bench_cert_free_prev,
+                          &bench_cert_realloc_prev);
+    wolfSSL_SetAllocators(bench_cert_malloc, bench_cert_free,
+                          bench_cert_realloc);
+}
+
+static size_t bench_cert_heap_peak(void)
+{
+    wolfSSL_SetAllocators(bench_cert_malloc_prev, bench_cert_free_prev,
+                          bench_cert_realloc_prev);
+    return bench_cert_peak;
+}
+#else
+static void bench_cert_heap_start(void)
+{
+}
+
+static size_t bench_cert_heap_peak(void)
+{
+    return 0;
+}
+#endif
+
+/* what a chain check reads from a certificate */
+static int bench_cert_view_once(const unsigned char* der, word32 sz)
+{
+    static const uint8_t cn_oid[] = { 0x55, 0x04, 0x03 };
+    esp_wolfssl_cert_view_t v;
+    esp_wolfssl_der_t cn;
+    int64_t not_before;
+    int64_t not_after;
+    unsigned usage;
+    int path_len;
+    int ca;
+    int ret;
+
+    ret = esp_wolfssl_cert_view_parse(der, sz, &v);
+    if (ret == 0) {
+        ret = esp_wolfssl_cert_view_validity(&v, &not_before, &not_after);
+    }
+    if (ret == 0 && (esp_wolfssl_cert_view_basic_constraints(&v, &ca,
+                                                             &path_len) < 0
+                     || esp_wolfssl_cert_view_key_usage(&v, &usage) < 0
+                     || esp_wolfssl_cert_view_name_attr(&v.subject, cn_oid,
+                                                        sizeof(cn_oid),
+                                                        &cn) < 0)) {
+        ret = ASN_PARSE_E;
+    }
+    return ret;
+}
+
+static int bench_cert_one(const unsigned char* der, word32 sz, int count,
+                          DecodedCert* cert, bench_cert_result* res)
+{
+    int64_t wolf_us;
+    int64_t view_us;
+    size_t wolf_heap;
+    size_t view_heap;
+    int64_t t0;
+    int ret = 0;
+    int i;
+
+    /* the first parse of each kind is watched for heap, then timed */
+    bench_cert_heap_start();
+    wc_InitDecodedCert(cert, der, sz, NULL);
+    ret = wc_ParseCert(cert, CERT_TYPE, NO_VERIFY, NULL);
+    wc_FreeDecodedCert(cert);
+    wolf_heap = bench_cert_heap_peak();
+    t0 = esp_timer_get_time();
+    for (i = 0; ret == 0 && i < count; i++) {
+        wc_InitDecodedCert(cert, der, sz, NULL);
+        ret = wc_ParseCert(cert, CERT_TYPE, NO_VERIFY, NULL);
+        wc_FreeDecodedCert(cert);
+    }
+    wolf_us = esp_timer_get_time() - t0;
+    if (ret != 0) {
+        ESP_LOGE(TAG, "ParseCert failed: %d", ret);
+        return ret;
+    }
+
+    bench_cert_heap_start();
+    ret = bench_cert_view_once(der, sz);
+    view_heap = bench_cert_heap_peak();
+    t0 = esp_timer_get_time();
+    for (i = 0; ret == 0 && i < count; i++) {
+        ret = bench_cert_view_once(der, sz);
+    }
+    view_us = esp_timer_get_time() - t0;
+    if (ret != 0) {
+        ESP_LOGE(TAG, "certificate view failed: %d", ret);
+        return ret;
+    }
+
+    ESP_LOGI(TAG, "  %5u bytes  ParseCert %7.1f us %6u B heap, view "
+                  "%6.1f us %4u B heap, %5.1fx",
+             (unsigned)sz, (double)wolf_us / count, (unsigned)wolf_heap,
+             (double)view_us / count, (unsigned)view_heap,
+             (view_us > 0) ? (double)wolf_us / (double)view_us : 0);
+    res->wolf_us += wolf_us;
+    res->view_us += view_us;
+    if (wolf_heap > res->wolf_heap) {
+        res->wolf_heap = wolf_heap;
+    }
+    if (view_heap > res->view_heap) {
+        res->view_heap = view_heap;
+    }
+    res->certs++;
+    return 0;
+}
+
+static void bench_cert_run_chain(const bench_cert_chain* chain, int count,
+                                 DecodedCert* cert, bench_cert_result* res)
+{
+    esp_wolfssl_cert_view_t views[BENCH_CERT_CHAIN_MAX];
+    int64_t t0;
+    int ret = 0;
+    int i;
+
+    ESP_LOGI(TAG, "%s, %d certificate%s", chain->name, chain->n,
+             (chain->n == 1) ? "" : "s");
+    for (i = 0; i < chain->n; i++) {
+        if (bench_cert_one(chain->der[i], chain->sz[i], count, cert,
+                           res) != 0) {
+            res->failed++;
+            return;
+        }
+    }
+
+    for (i = 0; ret == 0 && i < chain->n; i++) {
+        ret = esp_wolfssl_cert_view_parse(chain->der[i], chain->sz[i],
+                                          &views[i]);
+    }
+    t0 = esp_timer_get_time();
+    if (ret == 0) {
+        ret = esp_wolfssl_cert_view_verify_chain(views, (size_t)chain->n,
+                                                 &views[chain->n - 1]);
+    }
+    ESP_LOGI(TAG, "  chain check with the view %s (%d), %lld us",
+             (ret == 0) ? "ok" : "FAILED", ret,
+             (long long)(esp_timer_get_time() - t0));
+}
+
+static int bench_cert_run(const bench_cert_chain* chains, int n, int count)
+{
+    bench_cert_result res;
+    DecodedCert* cert;
+    int i;
+
+    memset(&res, 0, sizeof(res));
+    cert = (DecodedCert*)XMALLOC(sizeof(DecodedCert), NULL,
+                                 DYNAMIC_TYPE_DCERT);
+    if (cert == NULL) {
+        return MEMORY_E;
+    }
+
+    /* reference counted; the wolfCrypt benchmark cleans up after itself */
+    if (wolfSSL_Init() != WOLFSSL_SUCCESS) {
+        XFREE(cert, NULL, DYNAMIC_TYPE_DCERT);
+        return WOLFSSL_FATAL_ERROR;
+    }
+    ESP_LOGI(TAG, "parse %d times per certificate; DecodedCert %u bytes, "
+                  "view %u bytes", count, (unsigned)sizeof(DecodedCert),
+             (unsigned)sizeof(esp_wolfssl_cert_view_t));
+    for (i = 0; i < n; i++) {
+        bench_cert_run_chain(&chains[i], count, cert, &res);
+    }
+    wolfSSL_Cleanup();
+    XFREE(cert, NULL, DYNAMIC_TYPE_DCERT);
+
+    if (res.certs > 0) {
+        ESP_LOGI(TAG, "%d certificates: ParseCert %.1f us, view %.1f us per "
+                      "certificate on average (%.1fx); peak heap %u and %u "
+                      "bytes", res.certs,
+                 (double)res.wolf_us / ((double)res.certs * count),
+                 (double)res.view_us / ((double)res.certs * count),
+                 (res.view_us > 0) ? (double)res.wolf_us /
+                                     (double)res.view_us : 0,
+                 (unsigned)res.wolf_heap, (unsigned)res.view_heap);
+    }
+    return (res.failed == 0) ? 0 : ASN_PARSE_E;
+}
+
+int bench_cert_parse(void)
+{
+    static const bench_cert_chain corpus[] = {
+        { "ISRG Root X1", 1,
+          { cert_isrg_root_x1 }, { sizeof(cert_isrg_root_x1) } },
+        { "ISRG Root X2", 1,
+          { cert_isrg_root_x2 }, { sizeof(cert_isrg_root_x2) } },
+        { "DigiCert Global Root G2", 1,
+          { cert_digicert_global_root_g2 },
+          { sizeof(cert_digicert_global_root_g2) } },
+        { "Amazon Root CA 3", 1,
+          { cert_amazon_root_ca_3 }, { sizeof(cert_amazon_root_ca_3) } },
+        { "test server chain", 2,
+          { ocsp_server_cert_der, ocsp_ca_der },
+          { sizeof(ocsp_server_cert_der), sizeof(ocsp_ca_der) } },
+    };
+    struct timeval tv;
+
+    /* the test chain's dates are checked against the clock */
+    if (time(NULL) < BENCH_CERT_MIN_TIME) {
+        tv.tv_sec = BENCH_CERT_MIN_TIME;
+        tv.tv_usec = 0;
+        settimeofday(&tv, NULL);
+        ESP_LOGW(TAG, "clock not set, set to 2026-10-20 for the test "
+                      "certificates");
+    }
+
+    return bench_cert_run(corpus, (int)(sizeof(corpus) / sizeof(*corpus)),
+                          CONFIG_BENCH_CERT_COUNT);
+}
+
+#ifdef BENCH_CERT_HOST_MAIN
+static byte* bench_cert_load(const char* path, long* sz)
+{
+    FILE* f = fopen(path, "rb");
+    byte* data = NULL;
+
+    if (f == NULL) {
+        return NULL;
+    }
+    if (fseek(f, 0, SEEK_END) == 0 && (*sz = ftell(f)) > 0 &&
+        fseek(f, 0, SEEK_SET) == 0) {
+        data = (byte*)malloc((size_t)*sz + 1);
+        if (data != NULL && fread(data, 1, (size_t)*sz, f) != (size_t)*sz) {
+            free(data);
+            data = NULL;
+        }
+    }
+    fclose(f);
+    if (data != NULL) {
+        data[*sz] = '\0';
+    }
+    return data;
+}
+
+/* the certificates of a PEM or DER file, converted in place */
+static int bench_cert_split(byte* data, long sz, bench_cert_chain* chain)
+{
+    static const char begin[] = "-----BEGIN CERTIFICATE-----";
+    static const char end[] = "-----END CERTIFICATE-----";
+    char* p = (char*)data;
+    char* e;
+    byte* out = data;
+    int len;
+
+    if (strstr(p, begin) == NULL) {
+        chain->der[0] = data;
+        chain->sz[0] = (word32)sz;
+        chain->n = 1;
+        return 0;
+    }
+    /* DER is shorter than its PEM, so it fits where the PEM was */
+    while (chain->n < BENCH_CERT_CHAIN_MAX && (p = strstr(p, begin)) != NULL
+           && (e = strstr(p, end)) != NULL) {
+        e += sizeof(end) - 1;
+        len = wc_CertPemToDer((const unsigned char*)p, (int)(e - p), out,
+                              (int)(e - p), CERT_TYPE);
+        if (len <= 0) {
+            return ASN_PARSE_E;
+        }
+        chain->der[chain->n] = out;
+        chain->sz[chain->n] = (word32)len;
+        chain->n++;
+        out += len;
+        p = e;
+    }
+    return (chain->n > 0) ? 0 : ASN_PARSE_E;
+}
+
+int main(int argc, char** argv)
+{
+    bench_cert_chain* chains;
+    byte** files;
+    int count = CONFIG_BENCH_CERT_COUNT;
+    int n = 0;
+    long sz;
+    int ret = 0;
+    int i;
+
+    if (argc == 1) {
+        return (bench_cert_parse() == 0) ? 0 : 1;
+    }
+
+    chains = (bench_cert_chain*)calloc((size_t)argc, sizeof(*chains));
+    files = (byte**)calloc((size_t)argc, sizeof(*files));
+    for (i = 1; chains != NULL && files != NULL && i < argc; i++) {
+        if (strncmp(argv[i], "count=", 6) == 0) {
+            count = atoi(argv[i] + 6);
+            continue;
+        }
+        files[n] = bench_cert_load(argv[i], &sz);
+        if (files[n] == NULL
+            || bench_cert_split(files[n], sz, &chains[n]) != 0) {
+            fprintf(stderr, "%s: not a certificate file\n", argv[i]);
+            free(files[n]);
+            files[n] = NULL;
+            memset(&chains[n], 0, sizeof(chains[n]));
+            ret = ASN_PARSE_E;
+            continue;
+        }
+        chains[n].name = argv[i];
+        n++;
+    }
+    if (chains == NULL || files == NULL || count < 1) {
+        fprintf(stderr, "usage: %s [count=N] chain.pem ...\n", argv[0]);
+        ret = BAD_FUNC_ARG;
+    }
+    else if (n > 0 && bench_cert_run(chains, n, count) != 0) {
+        ret = ASN_PARSE_E;
+    }
+    printf("%s (%d)\n", (ret == 0) ? "OK" : "FAILED", ret);
+
+    for (i = 0; files != NULL && i < argc; i++) {
+        free(files[i]);
+    }
+    free(files);
+    free(chains);
+    return (ret == 0) ? 0 : 1;
+}
+#endif /* BENCH_CERT_HOST_MAIN */
+
+#endif /* CONFIG_BENCH_CERT || BENCH_CERT_HOST_MAIN */
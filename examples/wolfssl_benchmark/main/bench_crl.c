@@ -0,0 +1,403 @@
+/* bench_crl.c
+ *
+ * Copyright (C) 2006-2024 wolfSSL Inc.
+ *
+ * This file is part of wolfSSL.
+ *
+ * wolfSSL is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfSSL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335, USA
+ */
+
+/* Revocation checking against a large CRL: wolfSSL's CRL list, if
+ * HAVE_CRL, and the compact index of port/esp_wolfssl_crl_index.h. The
+ * CRL is made up here with CONFIG_BENCH_CRL_ENTRIES serial numbers and
+ * signed with the test CA of ocsp_test_data.h, so load time includes the
+ * signature verification in both cases. Reports load time, heap kept and
+ * certificate checks per second, plus raw index lookups per second. */
+
+#include "bench_common.h"
+
+#include "main.h"
+
+#if defined(CONFIG_BENCH_CRL) && defined(WOLFSSL_ESP_CRL_INDEX) && \
+    defined(HAVE_ECC)
+
+#include <string.h>
+
+#include <wolfssl/ssl.h>
+#include <wolfssl/wolfcrypt/types.h>
+#include <wolfssl/wolfcrypt/error-crypt.h>
+#include <wolfssl/wolfcrypt/random.h>
+#include <wolfssl/wolfcrypt/hash.h>
+#include <wolfssl/wolfcrypt/ecc.h>
+#include <wolfssl/wolfcrypt/asn_public.h>
+
+#ifdef ESP_PLATFORM
+    #include <esp_heap_caps.h>
+#else
+    #include <malloc.h>
+#endif
+
+#include "esp_wolfssl_der.h"
+#include "esp_wolfssl_crl_index.h"
+#include "ocsp_test_data.h"
+
+static const char* const TAG = "bench_crl";
+
+#define BENCH_CRL_SERIAL_SZ 8
+/* SEQUENCE { INTEGER serial, UTCTime revocationDate } */
+#define BENCH_CRL_ENTRY_SZ  (2 + 2 + BENCH_CRL_SERIAL_SZ + 2 + 13)
+
+static const byte bench_crl_sig_alg[] = {
+    0x30, 0x0A, 0x06, 0x08, 0x2A, 0x86, 0x48, 0xCE, 0x3D, 0x04, 0x03, 0x02
+};
+static const char bench_crl_revoked[] = "261019000000Z";
+static const char bench_crl_this[]    = "261019000000Z";
+static const char bench_crl_next[]    = "361016000000Z";
+
+/* Serial numbers i < entries are revoked, the others are not; the first
+ * byte keeps the INTEGER positive and minimal. */
+static void bench_crl_serial(uint32_t i, byte* serial)
+{
+    memset(serial, 0, BENCH_CRL_SERIAL_SZ);
+    serial[0] = 0x40;
+    serial[4] = (byte)(i >> 24);
+    serial[5] = (byte)(i >> 16);
+    serial[6] = (byte)(i >> 8);
+    serial[7] = (byte)i;
+}
+
+static size_t bench_crl_hdr_sz(size_t len)
+{
+    return len < 0x80 ? 2 : len < 0x100 ? 3 : len < 0x10000 ? 4 : 5;
+}
+
+static byte* bench_crl_hdr(byte* p, byte tag, size_t len)
+{
+    size_t n = bench_crl_hdr_sz(len) - 2;
+
+    *p++ = tag;
+    if (n == 0) {
+        *p++ = (byte)len;
+        return p;
+    }
+    *p++ = (byte)(0x80 | n);
+    while (n-- > 0) {
+        *p++ = (byte)(len >> (8 * n));
+    }
+    return p;
+}
+
+static byte* bench_crl_put(byte* p, byte tag, const void* val, size_t len)
+{
+    p = bench_crl_hdr(p, tag, len);
+    memcpy(p, val, len);
+    return p + len;
+}
+
+/* CertificateList v2 with the given number of entries, signed with
+ * ocsp_ca_key_der; the caller frees *crl */
+static int bench_crl_make(uint32_t entries, byte** crl, size_t* crl_sz)
+{
+    static const byte version = 1;
+    esp_wolfssl_der_t d;
+    esp_wolfssl_der_t issuer;
+    size_t revoked_sz = (size_t)entries * BENCH_CRL_ENTRY_SZ;
+    size_t tbs_sz;
+    size_t max;
+    byte hash[WC_SHA256_DIGEST_SIZE];
+    byte sig[ECC_MAX_SIG_SIZE + 1];
+    word32 sig_sz = ECC_MAX_SIG_SIZE;
+    byte* buf;
+    byte* p;
+    byte* tbs;
+    ecc_key key;
+    WC_RNG rng;
+    word32 idx = 0;
+    uint32_t i;
+    int ret;
+
+    /* issuer: the CA's subject, the 6th element of its tbsCertificate */
+    esp_wolfssl_der_init(&d, ocsp_ca_der, sizeof_ocsp_ca_der);
+    if (esp_wolfssl_der_expect(&d, ESP_WOLFSSL_DER_SEQUENCE, &d) != 0
+        || esp_wolfssl_der_expect(&d, ESP_WOLFSSL_DER_SEQUENCE, &d) != 0) {
+        return ASN_PARSE_E;
+    }
+    (void)esp_wolfssl_der_skip_optional(&d, ESP_WOLFSSL_DER_CONTEXT(0));
+    for (i = 0; i < 5; i++) {
+        if (esp_wolfssl_der_next(&d, NULL, NULL, &issuer) != 0) {
+            return ASN_PARSE_E;
+        }
+    }
+
+    tbs_sz = 3 + sizeof(bench_crl_sig_alg) + issuer.len + 2 * 15
+           + bench_crl_hdr_sz(revoked_sz) + revoked_sz;
+    max = tbs_sz + bench_crl_hdr_sz(tbs_sz) + sizeof(bench_crl_sig_alg)
+        + 3 + ECC_MAX_SIG_SIZE + 1;
+    max += bench_crl_hdr_sz(max);
+
+    buf = (byte*)XMALLOC(max, NULL, DYNAMIC_TYPE_TMP_BUFFER);
+    if (buf == NULL) {
+        return MEMORY_E;
+    }
+
+    /* the outer header goes in front once the signature size is known */
+    tbs = buf + bench_crl_hdr_sz(max);
+    p = bench_crl_hdr(tbs, ESP_WOLFSSL_DER_SEQUENCE, tbs_sz);
+    p = bench_crl_put(p, ESP_WOLFSSL_DER_INTEGER, &version, 1);
+    memcpy(p, bench_crl_sig_alg, sizeof(bench_crl_sig_alg));
+    p += sizeof(bench_crl_sig_alg);
+    memcpy(p, issuer.p, issuer.len);
+    p += issuer.len;
+    p = bench_crl_put(p, ESP_WOLFSSL_DER_UTC_TIME, bench_crl_this, 13);
+    p = bench_crl_put(p, ESP_WOLFSSL_DER_UTC_TIME, bench_crl_next, 13);
+    p = bench_crl_hdr(p, ESP_WOLFSSL_DER_SEQUENCE, revoked_sz);
+    for (i = 0; i < entries; i++) {
+        byte serial[BENCH_CRL_SERIAL_SZ];
+
+        bench_crl_serial(i, serial);
+        p = bench_crl_hdr(p, ESP_WOLFSSL_DER_SEQUENCE,
+                          BENCH_CRL_ENTRY_SZ - 2);
+        p = bench_crl_put(p, ESP_WOLFSSL_DER_INTEGER, serial, sizeof(serial));
+        p = bench_crl_put(p, ESP_WOLFSSL_DER_UTC_TIME, bench_crl_revoked, 13);
+    }
+
+    ret = wc_Sha256Hash(tbs, (word32)(p - tbs), hash);
+    if (ret == 0) {
+        ret = wc_InitRng(&rng);
+        if (ret == 0) {
+            ret = wc_ecc_init(&key);
+            if (ret == 0) {
+                ret = wc_EccPrivateKeyDecode(ocsp_ca_key_der, &idx, &key,
+                                             sizeof_ocsp_ca_key_der);
+                if (ret == 0) {
+                    ret = wc_ecc_sign_hash(hash, sizeof(hash), sig + 1,
+                                           &sig_sz, &rng, &key);
+                }
+                wc_ecc_free(&key);
+            }
+            wc_FreeRng(&rng);
+        }
+    }
+    if (ret == 0) {
+        sig[0] = 0;     /* unused bits */
+        memcpy(p, bench_crl_sig_alg, sizeof(bench_crl_sig_alg));
+        p += sizeof(bench_crl_sig_alg);
+        p = bench_crl_put(p, ESP_WOLFSSL_DER_BIT_STRING, sig, sig_sz + 1);
+
+        /* CertificateList header right in front of tbsCertList */
+        *crl_sz = (size_t)(p - tbs);
+        *crl = tbs - bench_crl_hdr_sz(*crl_sz);
+        bench_crl_hdr(*crl, ESP_WOLFSSL_DER_SEQUENCE, *crl_sz);
+        *crl_sz += bench_crl_hdr_sz(*crl_sz);
+        memmove(buf, *crl, *crl_sz);
+        *crl = buf;
+    }
+    else {
+        XFREE(buf, NULL, DYNAMIC_TYPE_TMP_BUFFER);
+    }
+
+    return ret;
+}
+
+static size_t bench_crl_heap_used(void)
+{
+#ifdef ESP_PLATFORM
+    return heap_caps_get_total_size(MALLOC_CAP_8BIT)
+         - heap_caps_get_free_size(MALLOC_CAP_8BIT);
+#else
+    return mallinfo2().uordblks;
+#endif
+}
+
+static void bench_crl_log(const char* name, int64_t load_us, size_t heap,
+                          uint32_t checks, int64_t check_us)
+{
+    ESP_LOGI(TAG, "%-14s load %8lld us, heap %7u bytes, "
+                  "%7.0f certificate checks/s",
+             name, (long long)load_us, (unsigned)heap,
+             check_us > 0 ? checks * 1e6 / check_us : 0.0);
+}
+
+#ifdef HAVE_CRL
+static int bench_crl_wolfssl(const byte* crl, size_t crl_sz)
+{
+    WOLFSSL_CERT_MANAGER* cm;
+    size_t heap = 0;
+    int64_t start;
+    int64_t load_us = 0;
+    int64_t check_us;
+    uint32_t i;
+    int ret;
+
+    cm = wolfSSL_CertManagerNew();
+    if (cm == NULL) {
+        return MEMORY_E;
+    }
+    ret = wolfSSL_CertManagerLoadCABuffer(cm, ocsp_ca_der,
+                                          sizeof_ocsp_ca_der,
+                                          WOLFSSL_FILETYPE_ASN1);
+    if (ret == WOLFSSL_SUCCESS) {
+        ret = wolfSSL_CertManagerEnableCRL(cm, 0);
+    }
+    if (ret == WOLFSSL_SUCCESS) {
+        heap = bench_crl_heap_used();
+        start = esp_timer_get_time();
+        ret = wolfSSL_CertManagerLoadCRLBuffer(cm, crl, (long)crl_sz,
+                                               WOLFSSL_FILETYPE_ASN1);
+        load_us = esp_timer_get_time() - start;
+        heap = bench_crl_heap_used() - heap;
+    }
+    /* the server certificate is not revoked: the worst case, every entry
+     * is compared */
+    start = esp_timer_get_time();
+    for (i = 0; ret == WOLFSSL_SUCCESS && i < CONFIG_BENCH_CRL_CHECKS; i++) {
+        ret = wolfSSL_CertManagerCheckCRL(cm, ocsp_server_cert_der,
+                                          sizeof_ocsp_server_cert_der);
+    }
+    check_us = esp_timer_get_time() - start;
+    wolfSSL_CertManagerFree(cm);
+
+    if (ret != WOLFSSL_SUCCESS) {
+        ESP_LOGE(TAG, "wolfSSL CRL failed: %d", ret);
+        return ret;
+    }
+    bench_crl_log("wolfSSL CRL", load_us, heap, CONFIG_BENCH_CRL_CHECKS,
+                  check_us);
+    return 0;
+}
+#endif /* HAVE_CRL */
+
+static int bench_crl_index(const byte* crl, size_t crl_sz)
+{
+    esp_wolfssl_crl_index_t* idx = NULL;
+    esp_wolfssl_crl_index_t* mapped = NULL;
+    esp_wolfssl_crl_index_info_t info;
+    byte serial[BENCH_CRL_SERIAL_SZ];
+    const void* blob;
+    size_t blob_sz;
+    size_t heap;
+    int64_t start;
+    int64_t load_us;
+    int64_t open_us;
+    int64_t check_us;
+    int64_t lookup_us;
+    uint32_t entries = CONFIG_BENCH_CRL_ENTRIES;
+    uint32_t hits = 0;
+    uint32_t false_hits = 0;
+    uint32_t i;
+    int ret;
+
+    heap = bench_crl_heap_used();
+    start = esp_timer_get_time();
+    ret = esp_wolfssl_crl_index_build(crl, crl_sz, ocsp_ca_der,
+                                      sizeof_ocsp_ca_der, &idx);
+    load_us = esp_timer_get_time() - start;
+    heap = bench_crl_heap_used() - heap;
+    if (ret != 0) {
+        ESP_LOGE(TAG, "CRL index build failed: %d", ret);
+        return ret;
+    }
+
+    /* what a prebuilt index in flash costs to open: the order check */
+    blob = esp_wolfssl_crl_index_blob(idx, &blob_sz);
+    start = esp_timer_get_time();
+    ret = esp_wolfssl_crl_index_open(blob, blob_sz, &mapped);
+    open_us = esp_timer_get_time() - start;
+
+    if (ret == 0) {
+        ret = esp_wolfssl_crl_index_register(idx);
+    }
+    start = esp_timer_get_time();
+    for (i = 0; ret == 0 && i < CONFIG_BENCH_CRL_CHECKS; i++) {
+        ret = esp_wolfssl_crl_index_check_cert(ocsp_server_cert_der,
+                                               sizeof_ocsp_server_cert_der);
+    }
+    check_us = esp_timer_get_time() - start;
+    esp_wolfssl_crl_index_unregister(idx);
+
+    /* half revoked, half not */
+    start = esp_timer_get_time();
+    for (i = 0; ret == 0 && i < CONFIG_BENCH_CRL_CHECKS; i++) {
+        uint32_t n = (i & 1) ? entries + i : i % entries;
+
+        bench_crl_serial(n, serial);
+        if (esp_wolfssl_crl_index_lookup(idx, serial, sizeof(serial))) {
+            if (n < entries) {
+                hits++;
+            }
+            else {
+                false_hits++;
+            }
+        }
+    }
+    lookup_us = esp_timer_get_time() - start;
+
+    if (ret == 0) {
+        esp_wolfssl_crl_index_get_info(idx, &info);
+        bench_crl_log("CRL index", load_us, heap, CONFIG_BENCH_CRL_CHECKS,
+                      check_us);
+        ESP_LOGI(TAG, "%-14s %u entries of %u bytes, %u bytes, "
+                      "opened in place in %lld us",
+                 "", (unsigned)info.count, (unsigned)info.hash_sz,
+                 (unsigned)info.size, (long long)open_us);
+        ESP_LOGI(TAG, "%-14s %7.0f lookups/s, %u of %u revoked found, "
+                      "%u false positives",
+                 "", lookup_us > 0 ? CONFIG_BENCH_CRL_CHECKS * 1e6 / lookup_us
+                                   : 0.0,
+                 (unsigned)hits, (unsigned)(CONFIG_BENCH_CRL_CHECKS + 1) / 2,
+                 (unsigned)false_hits);
+    }
+    else {
+        ESP_LOGE(TAG, "CRL index check failed: %d", ret);
+    }
+
+    esp_wolfssl_crl_index_free(mapped);
+    esp_wolfssl_crl_index_free(idx);
+    return ret;
+}
+
+int bench_crl_compare(void)
+{
+    byte* crl = NULL;
+    size_t crl_sz = 0;
+    int ret;
+
+    /* reference counted; the wolfCrypt benchmark cleans up after itself */
+    ret = wolfSSL_Init();
+    if (ret != WOLFSSL_SUCCESS) {
+        return ret;
+    }
+
+    ret = bench_crl_make(CONFIG_BENCH_CRL_ENTRIES, &crl, &crl_sz);
+    if (ret != 0) {
+        ESP_LOGE(TAG, "making the CRL failed: %d", ret);
+    }
+    else {
+        ESP_LOGI(TAG, "CRL with %u entries, %u bytes DER, P-256",
+                 (unsigned)CONFIG_BENCH_CRL_ENTRIES, (unsigned)crl_sz);
+#ifdef HAVE_CRL
+        ret = bench_crl_wolfssl(crl, crl_sz);
+#endif
+        if (ret == 0) {
+            ret = bench_crl_index(crl, crl_sz);
+        }
+        XFREE(crl, NULL, DYNAMIC_TYPE_TMP_BUFFER);
+    }
+
+    wolfSSL_Cleanup();
+    return ret;
+}
+
+#endif /* CONFIG_BENCH_CRL && WOLFSSL_ESP_CRL_INDEX && HAVE_ECC */
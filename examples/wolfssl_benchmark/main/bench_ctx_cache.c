@@ -0,0 +1,228 @@
+/* bench_ctx_cache.c
+ *
+ * Copyright (C) 2006-2024 wolfSSL Inc.
+ *
+ * This file is part of wolfSSL.
+ *
+ * wolfSSL is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfSSL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335, USA
+ */
+
+/* Reconnects of a TLS client over the in-memory loopback with a context
+ * built for every connection, as esp-tls does, and with the shared
+ * contexts of esp_wolfssl_ctx_cache.h; with Kconfig
+ * WOLFSSL_CTX_CACHE_ESP_TLS also with a context per connection that
+ * attaches to the shared CA store. Reports per connection the time to set
+ * up the context, the handshake time, and the heap the context holds,
+ * which is what a shared context saves on every reconnect. The CA set is
+ * the single RSA-2048 test CA; a PEM bundle of many CAs saves accordingly
+ * more. */
+
+#include "bench_common.h"
+
+#include "main.h"
+
+#if defined(CONFIG_BENCH_CTX_CACHE) && defined(WOLFSSL_ESP_CTX_CACHE)
+
+#include <string.h>
+
+#include <esp_heap_caps.h>
+
+#include <wolfssl/ssl.h>
+#include <wolfssl/wolfcrypt/error-crypt.h>
+#include <wolfssl/certs_test.h>
+
+#include "tls_loopback.h"
+#include "esp_wolfssl_ctx_cache.h"
+
+static const char* const TAG = "bench_ctx_cache";
+
+enum {
+    BENCH_CC_PER_CONN,      /* context per connection */
+    BENCH_CC_STORE,         /* context per connection, shared CA store */
+    BENCH_CC_SHARED         /* shared context */
+};
+
+typedef struct bench_cc_result {
+    int64_t setup_us;
+    int64_t handshake_us;
+    size_t  held;           /* by the context after its setup */
+    size_t  peak;           /* of a whole connection */
+} bench_cc_result;
+
+static const esp_wolfssl_ctx_cfg_t bench_cc_cfg = {
+    .ca        = ca_cert_der_2048,
+    .ca_sz     = sizeof(ca_cert_der_2048),
+    .ca_format = WOLFSSL_FILETYPE_ASN1,
+};
+
+/* the esp-tls way, through the wrapped CA load */
+static WOLFSSL_CTX* bench_cc_esp_tls_ctx(void)
+{
+    WOLFSSL_CTX* ctx = wolfSSL_CTX_new(wolfSSLv23_client_method());
+
+    if (ctx != NULL &&
+        wolfSSL_CTX_load_verify_buffer(ctx, bench_cc_cfg.ca,
+                                       (long)bench_cc_cfg.ca_sz,
+                                       bench_cc_cfg.ca_format)
+            != WOLFSSL_SUCCESS) {
+        wolfSSL_CTX_free(ctx);
+        return NULL;
+    }
+    if (ctx != NULL) {
+        wolfSSL_CTX_set_verify(ctx, WOLFSSL_VERIFY_PEER, NULL);
+    }
+    return ctx;
+}
+
+static int bench_cc_run(tls_loopback* lb, int mode, bench_cc_result* res)
+{
+    WOLFSSL_CTX* ctx;
+    WOLFSSL* ssl;
+    size_t heap_before;
+    size_t held;
+    int64_t start;
+    int ret = 0;
+    int i;
+
+    memset(res, 0, sizeof(*res));
+    esp_wolfssl_ctx_cache_set_enabled(mode != BENCH_CC_PER_CONN);
+    esp_wolfssl_ctx_cache_flush();
+    if (mode == BENCH_CC_SHARED) {
+        /* the first connection builds the context, as after boot */
+        ctx = esp_wolfssl_ctx_cache_get(&bench_cc_cfg);
+        if (ctx == NULL) {
+            return MEMORY_E;
+        }
+        esp_wolfssl_ctx_cache_put(ctx);
+    }
+    esp_wolfssl_ctx_cache_reset_stats();
+
+    heap_before = heap_caps_get_free_size(MALLOC_CAP_DEFAULT);
+    heap_caps_monitor_local_minimum_free_size_start();
+    for (i = 0; ret == 0 && i < CONFIG_BENCH_CTX_CACHE_COUNT; i++) {
+        start = esp_timer_get_time();
+        if (mode == BENCH_CC_STORE) {
+            ctx = bench_cc_esp_tls_ctx();
+        }
+        else {
+            ctx = esp_wolfssl_ctx_cache_get(&bench_cc_cfg);
+        }
+        if (ctx == NULL) {
+            ret = MEMORY_E;
+            break;
+        }
+        tls_loopback_set_io(ctx, 0);
+        res->setup_us += esp_timer_get_time() - start;
+        held = heap_before - heap_caps_get_free_size(MALLOC_CAP_DEFAULT);
+        res->held += held;
+
+        ssl = (mode == BENCH_CC_STORE) ? wolfSSL_new(ctx)
+                                       : esp_wolfssl_ctx_cache_new_ssl(ctx);
+        ret = (ssl != NULL) ? tls_loopback_connect_with(lb, ssl) : MEMORY_E;
+        if (ret == 0) {
+            res->handshake_us += lb->stats.handshake_us;
+        }
+        tls_loopback_close(lb);
+
+        if (mode == BENCH_CC_STORE) {
+            wolfSSL_CTX_free(ctx);
+        }
+        else {
+            esp_wolfssl_ctx_cache_put(ctx);
+        }
+    }
+    res->peak = heap_before
+                - heap_caps_get_minimum_free_size(MALLOC_CAP_DEFAULT);
+    heap_caps_monitor_local_minimum_free_size_stop();
+    return ret;
+}
+
+static void bench_cc_log(const char* name, const bench_cc_result* res)
+{
+    ESP_LOGI(TAG, "%-22s setup %6lld us, handshake %8lld us, context holds "
+                  "%6u bytes, peak %6u",
+             name, (long long)(res->setup_us / CONFIG_BENCH_CTX_CACHE_COUNT),
+             (long long)(res->handshake_us / CONFIG_BENCH_CTX_CACHE_COUNT),
+             (unsigned)(res->held / CONFIG_BENCH_CTX_CACHE_COUNT),
+             (unsigned)res->peak);
+}
+
+int bench_ctx_cache_compare(void)
+{
+    esp_wolfssl_ctx_cache_stats_t stats;
+    bench_cc_result per_conn;
+    bench_cc_result shared;
+    tls_loopback lb;
+    int ret;
+#ifdef WOLFSSL_ESP_CTX_CACHE_STORES
+    bench_cc_result store;
+#endif
+
+    /* reference counted; the wolfCrypt benchmark cleans up after itself */
+    ret = wolfSSL_Init();
+    if (ret != WOLFSSL_SUCCESS) {
+        return ret;
+    }
+    /* the server end and the pipes, set up once */
+    ret = tls_loopback_init(&lb, NULL);
+    if (ret != 0) {
+        wolfSSL_Cleanup();
+        return ret;
+    }
+
+    ESP_LOGI(TAG, "%d reconnects per mode, RSA-2048 test CA",
+             CONFIG_BENCH_CTX_CACHE_COUNT);
+    ret = bench_cc_run(&lb, BENCH_CC_PER_CONN, &per_conn);
+    if (ret == 0) {
+        bench_cc_log("context per connection", &per_conn);
+    }
+#ifdef WOLFSSL_ESP_CTX_CACHE_STORES
+    if (ret == 0) {
+        ret = bench_cc_run(&lb, BENCH_CC_STORE, &store);
+    }
+    if (ret == 0) {
+        esp_wolfssl_ctx_cache_get_stats(&stats);
+        bench_cc_log("esp-tls, shared CAs", &store);
+        ESP_LOGI(TAG, "%u CA loads from the shared store, %u decoded",
+                 (unsigned)stats.store_hits, (unsigned)stats.store_misses);
+    }
+#endif
+    if (ret == 0) {
+        ret = bench_cc_run(&lb, BENCH_CC_SHARED, &shared);
+    }
+    if (ret == 0) {
+        esp_wolfssl_ctx_cache_get_stats(&stats);
+        bench_cc_log("shared context", &shared);
+        ESP_LOGI(TAG, "%u hits, %u contexts built; saved per reconnect: "
+                      "%lld us, %d bytes", (unsigned)stats.hits,
+                 (unsigned)stats.misses,
+                 (long long)((per_conn.setup_us + per_conn.handshake_us
+                              - shared.setup_us - shared.handshake_us)
+                             / CONFIG_BENCH_CTX_CACHE_COUNT),
+                 (int)(((int64_t)per_conn.held - (int64_t)shared.held)
+                       / CONFIG_BENCH_CTX_CACHE_COUNT));
+    }
+    else {
+        ESP_LOGE(TAG, "failed: %d", ret);
+    }
+
+    esp_wolfssl_ctx_cache_set_enabled(1);
+    esp_wolfssl_ctx_cache_flush();
+    tls_loopback_free(&lb);
+    wolfSSL_Cleanup();
+    return ret;
+}
+
+#endif /* CONFIG_BENCH_CTX_CACHE && WOLFSSL_ESP_CTX_CACHE */
@@ -0,0 +1,215 @@
+/* bench_dtls.c
+ *
+ * Copyright (C) 2006-2024 wolfSSL Inc.
+ *
+ * This file is part of wolfSSL.
+ *
+ * wolfSSL is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfSSL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335, USA
+ */
+
+/* DTLS 1.3 with Connection IDs versus TLS 1.3 over TCP, for a battery
+ * powered sensor that wakes up, sends a report and sleeps again.
+ *
+ * Both run in memory through tls_loopback; handshake bytes, flights and
+ * datagrams are measured, radio-on time and charge are modeled from the
+ * round trip time, link rate and radio current set in menuconfig:
+ *
+ *   radio on = round trips * RTT + (payload + headers) * 8 / link rate
+ *
+ * with one round trip per two flights, per packet IPv4 + UDP (28 bytes) or
+ * IPv4 + TCP (40 bytes) headers, and for TCP one more round trip and three
+ * packets for the connection setup. After the NAT binding expired, TLS over
+ * TCP needs a new connection and handshake for the next report; DTLS 1.3
+ * with a Connection ID only sends the report. */
+
+#include "bench_common.h"
+
+#include "main.h"
+
+#if defined(CONFIG_BENCH_DTLS_COMPARE) && defined(WOLFSSL_DTLS13)
+
+#include <string.h>
+
+#include <wolfssl/ssl.h>
+#include <wolfssl/wolfcrypt/error-crypt.h>
+
+#include "tls_loopback.h"
+#include "esp_wolfssl_dtls.h"
+
+static const char* const TAG = "bench_dtls";
+
+#define BENCH_UDP_HDR       28
+#define BENCH_TCP_HDR       40
+#define BENCH_TCP_SETUP_PKT 3   /* SYN, SYN-ACK, ACK */
+
+typedef struct bench_dtls_result {
+    const char* name;
+    int         tcp;
+    uint32_t    hs_bytes;       /* both directions */
+    uint32_t    hs_flights;
+    uint32_t    hs_packets;
+    int64_t     hs_us;          /* CPU time of both ends */
+    uint32_t    rpt_bytes;      /* one report and its echo */
+    uint32_t    rpt_flights;
+    uint32_t    rpt_packets;
+    unsigned    cid_sz;         /* Connection ID bytes per record */
+} bench_dtls_result;
+
+static int bench_dtls_setup(WOLFSSL* ssl, int server)
+{
+    (void)server;
+    return esp_wolfssl_dtls_setup(ssl, NULL, 0);
+}
+
+static int bench_dtls_one(bench_dtls_result* r, const tls_loopback_cfg* cfg)
+{
+    tls_loopback lb;
+    tls_loopback_stats hs;
+    int ret;
+    int i;
+
+    ret = tls_loopback_init(&lb, cfg);
+    if (ret != 0) {
+        return ret;
+    }
+
+    for (i = 0; ret == 0 && i < CONFIG_BENCH_DTLS_COUNT; i++) {
+        ret = tls_loopback_connect(&lb);
+        if (ret != 0) {
+            break;
+        }
+        hs = lb.stats;
+        r->hs_bytes = hs.client_bytes + hs.server_bytes;
+        r->hs_flights = hs.flights;
+        r->hs_packets = hs.packets;
+        r->hs_us += hs.handshake_us;
+
+    #ifdef WOLFSSL_DTLS_CID
+        if (cfg->datagram) {
+            unsigned int sz = 0;
+            if (wolfSSL_dtls_cid_get_tx_size(lb.client, &sz)
+                                                    == WOLFSSL_SUCCESS) {
+                r->cid_sz = sz;
+            }
+        }
+    #endif
+
+        memset(&lb.stats, 0, sizeof(lb.stats));
+        lb.last_sender = 0;
+        ret = tls_loopback_echo(&lb, CONFIG_BENCH_DTLS_REPORT_SIZE);
+        r->rpt_bytes = lb.stats.client_bytes + lb.stats.server_bytes;
+        r->rpt_flights = lb.stats.flights;
+        r->rpt_packets = lb.stats.packets;
+        tls_loopback_close(&lb);
+    }
+    r->hs_us /= CONFIG_BENCH_DTLS_COUNT;
+
+    tls_loopback_free(&lb);
+    return ret;
+}
+
+/* modeled radio-on time in microseconds */
+static int64_t bench_radio_us(const bench_dtls_result* r, uint32_t bytes,
+                              uint32_t flights, uint32_t packets, int setup)
+{
+    uint32_t rtts = (flights + 1) / 2;
+    uint32_t air = bytes + packets * (r->tcp ? BENCH_TCP_HDR : BENCH_UDP_HDR);
+
+    if (setup && r->tcp) {
+        rtts += 1;
+        air += BENCH_TCP_SETUP_PKT * BENCH_TCP_HDR;
+    }
+    /* kbit/s is bits per millisecond */
+    return (int64_t)rtts * CONFIG_BENCH_DTLS_RTT_MS * 1000
+           + (int64_t)air * 8 * 1000 / CONFIG_BENCH_DTLS_LINK_KBPS;
+}
+
+static void bench_dtls_log(const bench_dtls_result* r, int wake_handshake)
+{
+    int64_t hs_radio = bench_radio_us(r, r->hs_bytes, r->hs_flights,
+                                      r->hs_packets, 1);
+    int64_t rpt_radio = bench_radio_us(r, r->rpt_bytes, r->rpt_flights,
+                                       r->rpt_packets, 0);
+    int64_t wake_radio = rpt_radio + (wake_handshake ? hs_radio : 0);
+
+    ESP_LOGI(TAG, "%-16s handshake %5u bytes %2u flights %2u packets "
+                  "%6lld us cpu, radio %6lld us",
+             r->name, (unsigned)r->hs_bytes, (unsigned)r->hs_flights,
+             (unsigned)r->hs_packets, (long long)r->hs_us,
+             (long long)hs_radio);
+    ESP_LOGI(TAG, "%-16s report    %5u bytes %2u flights, cid %u bytes",
+             r->name, (unsigned)r->rpt_bytes, (unsigned)r->rpt_flights,
+             r->cid_sz);
+    /* mA * us / 3600 = nAh */
+    ESP_LOGI(TAG, "%-16s wakeup after NAT rebinding: radio %6lld us, "
+                  "%lld nAh%s", r->name, (long long)wake_radio,
+             (long long)(wake_radio * CONFIG_BENCH_DTLS_RADIO_MA / 3600),
+             wake_handshake ? " (full handshake)" : "");
+}
+
+int bench_dtls_compare(void)
+{
+    tls_loopback_cfg cfg;
+    bench_dtls_result tls;
+    bench_dtls_result dtls;
+    int ret;
+
+    memset(&tls, 0, sizeof(tls));
+    memset(&dtls, 0, sizeof(dtls));
+    tls.name = "TLS 1.3 / TCP";
+    tls.tcp = 1;
+#ifdef WOLFSSL_DTLS_CID
+    dtls.name = "DTLS 1.3 + CID";
+#else
+    dtls.name = "DTLS 1.3";
+#endif
+
+    ESP_LOGI(TAG, "model: RTT %d ms, link %d kbit/s, radio %d mA, "
+                  "report %d bytes", CONFIG_BENCH_DTLS_RTT_MS,
+             CONFIG_BENCH_DTLS_LINK_KBPS, CONFIG_BENCH_DTLS_RADIO_MA,
+             CONFIG_BENCH_DTLS_REPORT_SIZE);
+
+    /* reference counted; the wolfCrypt benchmark cleans up after itself */
+    ret = wolfSSL_Init();
+    if (ret != WOLFSSL_SUCCESS) {
+        return ret;
+    }
+
+    memset(&cfg, 0, sizeof(cfg));
+    cfg.version = TLS_LOOPBACK_VERSION_13;
+    ret = bench_dtls_one(&tls, &cfg);
+    if (ret != 0) {
+        ESP_LOGE(TAG, "TLS 1.3 loopback failed: %d", ret);
+    }
+
+    if (ret == 0) {
+        cfg.datagram = 1;
+        cfg.setup = bench_dtls_setup;
+        ret = bench_dtls_one(&dtls, &cfg);
+        if (ret != 0) {
+            ESP_LOGE(TAG, "DTLS 1.3 loopback failed: %d", ret);
+        }
+    }
+
+    if (ret == 0) {
+        bench_dtls_log(&tls, 1);
+        bench_dtls_log(&dtls, dtls.cid_sz == 0);
+    }
+
+    wolfSSL_Cleanup();
+    return ret;
+}
+
+#endif /* CONFIG_BENCH_DTLS_COMPARE && WOLFSSL_DTLS13 */
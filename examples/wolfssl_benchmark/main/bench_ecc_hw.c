@@ -0,0 +1,254 @@
+/* bench_ecc_hw.c
+ *
+ * Copyright (C) 2006-2024 wolfSSL Inc.
+ *
+ * This file is part of wolfSSL.
+ *
+ * wolfSSL is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfSSL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335, USA
+ */
+
+/* ECC on the point-multiplication peripheral of esp_wolfssl_ecc_hw.h
+ * against wolfCrypt in software: the known-answer self test, then raw
+ * P-256 point multiplications, and P-256 key generation, ECDH and ECDSA
+ * verification through the wolfCrypt API with the driver off and on.
+ * Reported are operations per second and the driver statistics.
+ *
+ * On the device, enable Example Configuration -> Benchmark ECC peripheral.
+ * On a Linux host, where a register model stands in for the peripheral
+ * (so the rates compare the model, not the hardware), against a static
+ * wolfSSL with ECC key import and export:
+ *
+ *   gcc -O2 -DBENCH_ECC_HW_HOST_MAIN -DWOLFSSL_ESP_ECC_HW \
+ *       -DESP_WOLFSSL_ECC_HW_SECRET=1 \
+ *       -include wolfssl/options.h -Imain/include -I../../port \
+ *       main/bench_ecc_hw.c ../../port/esp_wolfssl_ecc_hw.c \
+ *       -l:libwolfssl.a -lm -Wl,--wrap=wc_ecc_make_key_ex \
+ *       -Wl,--wrap=wc_ecc_shared_secret,--wrap=wc_ecc_verify_hash \
+ *       -o ecc_hw
+ *   ./ecc_hw
+ */
+
+#include "bench_common.h"
+
+#if (defined(CONFIG_BENCH_ECC_HW) || defined(BENCH_ECC_HW_HOST_MAIN)) && \
+    defined(WOLFSSL_ESP_ECC_HW) && defined(HAVE_ECC)
+
+#include <wolfssl/wolfcrypt/ecc.h>
+#include <wolfssl/wolfcrypt/random.h>
+#include <wolfssl/wolfcrypt/error-crypt.h>
+
+#include "esp_wolfssl_ecc_hw.h"
+#include "main.h"
+
+#ifndef CONFIG_BENCH_ECC_HW_COUNT
+    #define CONFIG_BENCH_ECC_HW_COUNT 20
+#endif
+
+static const char* const TAG = "bench_ecc_hw";
+
+static const char* const bench_ecc_hw_modes[2] = { "sw", "periph" };
+
+static void bench_ecc_hw_report(const char* what, int hw, int64_t us)
+{
+    esp_wolfssl_ecc_hw_stats_t stats;
+
+    esp_wolfssl_ecc_hw_get_stats(&stats);
+    ESP_LOGI(TAG, "%-12s %-6s %8.1f per s; %u point muls, %u verifies, "
+                  "%u to software", what, bench_ecc_hw_modes[hw],
+             (us > 0) ? (double)CONFIG_BENCH_ECC_HW_COUNT * 1000000.0
+                        / (double)us : 0.0,
+             (unsigned)stats.point_muls, (unsigned)stats.verifies,
+             (unsigned)stats.fallbacks);
+    esp_wolfssl_ecc_hw_reset_stats();
+}
+
+/* k G on the peripheral, k changing every time */
+static int bench_ecc_hw_raw(void)
+{
+    static const byte gx[32] = {
+        0x6B, 0x17, 0xD1, 0xF2, 0xE1, 0x2C, 0x42, 0x47,
+        0xF8, 0xBC, 0xE6, 0xE5, 0x63, 0xA4, 0x40, 0xF2,
+        0x77, 0x03, 0x7D, 0x81, 0x2D, 0xEB, 0x33, 0xA0,
+        0xF4, 0xA1, 0x39, 0x45, 0xD8, 0x98, 0xC2, 0x96
+    };
+    static const byte gy[32] = {
+        0x4F, 0xE3, 0x42, 0xE2, 0xFE, 0x1A, 0x7F, 0x9B,
+        0x8E, 0xE7, 0xEB, 0x4A, 0x7C, 0x0F, 0x9E, 0x16,
+        0x2B, 0xCE, 0x33, 0x57, 0x6B, 0x31, 0x5E, 0xCE,
+        0xCB, 0xB6, 0x40, 0x68, 0x37, 0xBF, 0x51, 0xF5
+    };
+    byte k[32];
+    byte x[32];
+    byte y[32];
+    int64_t start;
+    int ret = 0;
+    int i;
+
+    XMEMSET(k, 0x5a, sizeof(k));
+    start = esp_timer_get_time();
+    for (i = 0; ret == 0 && i < CONFIG_BENCH_ECC_HW_COUNT; i++) {
+        k[31] = (byte)i;
+        ret = esp_wolfssl_ecc_hw_mul(ECC_SECP256R1, k, gx, gy, x, y, 0);
+    }
+    if (ret == 0) {
+        bench_ecc_hw_report("k G", 1, esp_timer_get_time() - start);
+    }
+    return ret;
+}
+
+static int bench_ecc_hw_api(WC_RNG* rng, int hw)
+{
+    byte hash[32];
+    byte sig[ECC_MAX_SIG_SIZE];
+    byte secret[32];
+    word32 siglen = sizeof(sig);
+    word32 len;
+    ecc_key a;
+    ecc_key b;
+    int64_t start;
+    int verified = 0;
+    int ret;
+    int i;
+
+    XMEMSET(hash, 0x3c, sizeof(hash));
+    esp_wolfssl_ecc_hw_set_enabled(hw);
+    esp_wolfssl_ecc_hw_reset_stats();
+
+    ret = wc_ecc_init_ex(&a, NULL, INVALID_DEVID);
+    if (ret == 0) {
+        ret = wc_ecc_init_ex(&b, NULL, INVALID_DEVID);
+        if (ret != 0) {
+            wc_ecc_free(&a);
+        }
+    }
+    if (ret != 0) {
+        return ret;
+    }
+
+    /* a new key each time, as for an ephemeral key share */
+    start = esp_timer_get_time();
+    for (i = 0; ret == 0 && i < CONFIG_BENCH_ECC_HW_COUNT; i++) {
+        wc_ecc_free(&a);
+        ret = wc_ecc_init_ex(&a, NULL, INVALID_DEVID);
+        if (ret == 0) {
+            ret = wc_ecc_make_key_ex(rng, 32, &a, ECC_SECP256R1);
+        }
+    }
+    if (ret == 0) {
+        bench_ecc_hw_report("keygen", hw, esp_timer_get_time() - start);
+        ret = wc_ecc_make_key_ex(rng, 32, &b, ECC_SECP256R1);
+    }
+
+#ifdef HAVE_ECC_DHE
+    if (ret == 0) {
+        esp_wolfssl_ecc_hw_reset_stats();
+        start = esp_timer_get_time();
+        for (i = 0; ret == 0 && i < CONFIG_BENCH_ECC_HW_COUNT; i++) {
+            len = sizeof(secret);
+            ret = wc_ecc_shared_secret(&a, &b, secret, &len);
+        }
+        if (ret == 0) {
+            bench_ecc_hw_report("ECDH", hw, esp_timer_get_time() - start);
+        }
+    }
+#else
+    (void)secret;
+    (void)len;
+#endif
+
+#if defined(HAVE_ECC_SIGN) && defined(HAVE_ECC_VERIFY)
+    if (ret == 0) {
+        ret = wc_ecc_sign_hash(hash, sizeof(hash), sig, &siglen, rng, &a);
+    }
+    if (ret == 0) {
+        esp_wolfssl_ecc_hw_reset_stats();
+        start = esp_timer_get_time();
+        for (i = 0; ret == 0 && i < CONFIG_BENCH_ECC_HW_COUNT; i++) {
+            ret = wc_ecc_verify_hash(sig, siglen, hash, sizeof(hash),
+                                     &verified, &a);
+            if (ret == 0 && !verified) {
+                ret = SIG_VERIFY_E;
+            }
+        }
+        if (ret == 0) {
+            bench_ecc_hw_report("ECDSA verify", hw,
+                                esp_timer_get_time() - start);
+        }
+    }
+    if (ret == 0) {
+        /* and a wrong signature still fails */
+        hash[0] ^= 1;
+        ret = wc_ecc_verify_hash(sig, siglen, hash, sizeof(hash), &verified,
+                                 &a);
+        if (ret == 0 && verified) {
+            ret = SIG_VERIFY_E;
+        }
+    }
+#else
+    (void)sig;
+    (void)siglen;
+    (void)verified;
+#endif
+
+    wc_ecc_free(&b);
+    wc_ecc_free(&a);
+    return ret;
+}
+
+int bench_ecc_hw(void)
+{
+    WC_RNG rng;
+    int hw;
+    int ret;
+
+    ret = esp_wolfssl_ecc_hw_self_test();
+    if (ret != 0) {
+        ESP_LOGE(TAG, "self test: %d", ret);
+        return ret;
+    }
+    ESP_LOGI(TAG, "self test passed; %d operations each, private keys on "
+                  "the peripheral: %s", CONFIG_BENCH_ECC_HW_COUNT,
+             ESP_WOLFSSL_ECC_HW_SECRET ? "yes" : "no");
+    esp_wolfssl_ecc_hw_reset_stats();
+
+    ret = bench_ecc_hw_raw();
+    if (ret != 0) {
+        ESP_LOGE(TAG, "k G: %d", ret);
+        return ret;
+    }
+
+    ret = wc_InitRng(&rng);
+    if (ret != 0) {
+        return ret;
+    }
+    for (hw = 0; ret == 0 && hw < 2; hw++) {
+        ret = bench_ecc_hw_api(&rng, hw);
+        if (ret != 0) {
+            ESP_LOGE(TAG, "wolfCrypt %s: %d", bench_ecc_hw_modes[hw], ret);
+        }
+    }
+    esp_wolfssl_ecc_hw_set_enabled(1);
+    wc_FreeRng(&rng);
+    return ret;
+}
+
+#ifdef BENCH_ECC_HW_HOST_MAIN
+int main(void)
+{
+    return (bench_ecc_hw() == 0) ? 0 : 1;
+}
+#endif
+
+#endif /* CONFIG_BENCH_ECC_HW || BENCH_ECC_HW_HOST_MAIN */
@@ -0,0 +1,201 @@
+/* bench_hmac.c
+ *
+ * Copyright (C) 2006-2024 wolfSSL Inc.
+ *
+ * This file is part of wolfSSL.
+ *
+ * wolfSSL is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfSSL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335, USA
+ */
+
+/* HMAC with and without the cached key states of esp_wolfssl_hmac_cache.h:
+ * HMAC-SHA256 record MACs of short messages with one key, and TLS 1.2
+ * records of a CBC cipher suite with an HMAC-SHA256 record MAC over an
+ * in-memory loopback. Reported are operations per second and the cache
+ * statistics.
+ *
+ * On the device, enable Example Configuration -> Benchmark HMAC key state
+ * cache. On a Linux host, against a static wolfSSL:
+ *
+ *   gcc -O2 -DBENCH_HMAC_HOST_MAIN -DWOLFSSL_ESP_HMAC_CACHE \
+ *       -include wolfssl/options.h -Imain/include -I../../port \
+ *       main/bench_hmac.c main/tls_loopback.c \
+ *       ../../port/esp_wolfssl_hmac_cache.c -l:libwolfssl.a -lm \
+ *       -Wl,--wrap=wc_HmacUpdate,--wrap=wc_HmacFinal \
+ *       -Wl,--wrap=wolfSSL_free -o hmac
+ *   ./hmac
+ */
+
+#include "bench_common.h"
+
+#if (defined(CONFIG_BENCH_HMAC) || defined(BENCH_HMAC_HOST_MAIN)) && \
+    defined(WOLFSSL_ESP_HMAC_CACHE)
+
+#include <wolfssl/ssl.h>
+#include <wolfssl/wolfcrypt/hmac.h>
+#include <wolfssl/wolfcrypt/error-crypt.h>
+
+#include "tls_loopback.h"
+#include "esp_wolfssl_hmac_cache.h"
+#include "main.h"
+
+#ifndef CONFIG_BENCH_HMAC_COUNT
+    #define CONFIG_BENCH_HMAC_COUNT       2000
+#endif
+#ifndef CONFIG_BENCH_HMAC_RECORD_SIZE
+    #define CONFIG_BENCH_HMAC_RECORD_SIZE 64
+#endif
+#define BENCH_HMAC_MSG_SZ 64
+/* sequence number and record header, WOLFSSL_TLS_HMAC_INNER_SZ */
+#define BENCH_HMAC_HEADER_SZ 13
+
+static const char* const TAG = "bench_hmac";
+
+static const char* const bench_hmac_modes[2] = { "off", "cached" };
+
+static void bench_hmac_stats(const char* what, int cached, int64_t us,
+                             int count)
+{
+    esp_wolfssl_hmac_cache_stats_t stats;
+
+    esp_wolfssl_hmac_cache_get_stats(&stats);
+    ESP_LOGI(TAG, "%-10s %-6s %8.1f per s; cache: %u inner, %u outer hits, "
+                  "%u misses", what, bench_hmac_modes[cached],
+             (us > 0) ? (double)count * 1000000.0 / (double)us : 0.0,
+             (unsigned)stats.inner_hits, (unsigned)stats.outer_hits,
+             (unsigned)stats.misses);
+}
+
+static void bench_hmac_mode(int cached)
+{
+    esp_wolfssl_hmac_cache_set_enabled(cached);
+    esp_wolfssl_hmac_cache_clear();
+    esp_wolfssl_hmac_cache_reset_stats();
+}
+
+static int bench_hmac_raw(int cached)
+{
+    static const byte key[32] = { 0x0b, 0x0b, 0x0b, 0x0b };
+    byte header[BENCH_HMAC_HEADER_SZ];
+    byte msg[BENCH_HMAC_MSG_SZ];
+    byte mac[WC_SHA256_DIGEST_SIZE];
+    Hmac hmac;
+    int64_t start;
+    int ret;
+    int i;
+
+    XMEMSET(header, 0, sizeof(header));
+    XMEMSET(msg, 0x5a, sizeof(msg));
+    bench_hmac_mode(cached);
+    ret = wc_HmacInit(&hmac, NULL, INVALID_DEVID);
+    if (ret != 0) {
+        return ret;
+    }
+    start = esp_timer_get_time();
+    for (i = 0; ret == 0 && i < CONFIG_BENCH_HMAC_COUNT; i++) {
+        /* as TLS does per record */
+        ret = wc_HmacSetKey(&hmac, WC_SHA256, key, sizeof(key));
+        if (ret == 0) {
+            ret = wc_HmacUpdate(&hmac, header, sizeof(header));
+        }
+        if (ret == 0) {
+            ret = wc_HmacUpdate(&hmac, msg, sizeof(msg));
+        }
+        if (ret == 0) {
+            ret = wc_HmacFinal(&hmac, mac);
+        }
+    }
+    if (ret == 0) {
+        bench_hmac_stats("record MAC", cached, esp_timer_get_time() - start,
+                         CONFIG_BENCH_HMAC_COUNT);
+    }
+    wc_HmacFree(&hmac);
+    return ret;
+}
+
+static int bench_hmac_records(int cached)
+{
+    tls_loopback lb;
+    tls_loopback_cfg cfg;
+    int64_t start;
+    int ret;
+    int i;
+
+    XMEMSET(&cfg, 0, sizeof(cfg));
+    cfg.version = TLS_LOOPBACK_VERSION_12;
+    cfg.cipher_list = "ECDHE-RSA-AES128-SHA256:ECDHE-ECDSA-AES128-SHA256";
+    ret = tls_loopback_init(&lb, &cfg);
+    if (ret != 0) {
+        return ret;
+    }
+    ret = tls_loopback_connect(&lb);
+    if (ret == 0) {
+        bench_hmac_mode(cached);
+        start = esp_timer_get_time();
+        for (i = 0; ret == 0 && i < CONFIG_BENCH_HMAC_COUNT; i++) {
+            ret = tls_loopback_echo(&lb, CONFIG_BENCH_HMAC_RECORD_SIZE);
+        }
+        if (ret == 0) {
+            /* a record each way per echo */
+            bench_hmac_stats("records", cached, esp_timer_get_time() - start,
+                             2 * CONFIG_BENCH_HMAC_COUNT);
+        }
+        tls_loopback_close(&lb);
+    }
+    tls_loopback_free(&lb);
+    return ret;
+}
+
+int bench_hmac(void)
+{
+    int cached;
+    int ret;
+
+    /* reference counted; the wolfCrypt benchmark cleans up after itself */
+    ret = wolfSSL_Init();
+    if (ret != WOLFSSL_SUCCESS) {
+        return ret;
+    }
+
+    ESP_LOGI(TAG, "%d record MACs of %d bytes, %d echoes of %d bytes",
+             CONFIG_BENCH_HMAC_COUNT, BENCH_HMAC_MSG_SZ,
+             CONFIG_BENCH_HMAC_COUNT, CONFIG_BENCH_HMAC_RECORD_SIZE);
+    for (cached = 0; ret == 0 && cached < 2; cached++) {
+        ret = bench_hmac_raw(cached);
+        if (ret != 0) {
+            ESP_LOGE(TAG, "HMAC %s: %d", bench_hmac_modes[cached], ret);
+        }
+    }
+    for (cached = 0; ret == 0 && cached < 2; cached++) {
+        ret = bench_hmac_records(cached);
+        if (ret != 0) {
+            ESP_LOGE(TAG, "TLS 1.2 records %s: %d", bench_hmac_modes[cached],
+                     ret);
+        }
+    }
+    esp_wolfssl_hmac_cache_set_enabled(1);
+    esp_wolfssl_hmac_cache_clear();
+
+    wolfSSL_Cleanup();
+    return ret;
+}
+
+#ifdef BENCH_HMAC_HOST_MAIN
+int main(void)
+{
+    return (bench_hmac() == 0) ? 0 : 1;
+}
+#endif
+
+#endif /* CONFIG_BENCH_HMAC || BENCH_HMAC_HOST_MAIN */
@@ -0,0 +1,234 @@
+/* bench_hw_order.c
+ *
+ * Copyright (C) 2006-2024 wolfSSL Inc.
+ *
+ * This file is part of wolfSSL.
+ *
+ * wolfSSL is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfSSL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335, USA
+ */
+
+/* TLS 1.3 handshakes and bulk transfer over the in-memory loopback for
+ * each pairing of AEAD (AES-128-GCM, ChaCha20-Poly1305) and key-exchange
+ * group (X25519, P-256), with the pairing esp_wolfssl_hw_order.h picks for
+ * the running chip marked. Reports the measurement it made at init,
+ * handshake time and echo throughput, so the effect of the order can be
+ * compared across targets. */
+
+/* ESP-IDF */
+#include "sdkconfig.h"
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+/* wolfSSL */
+#include <wolfssl/wolfcrypt/settings.h>
+#include <wolfssl/ssl.h>
+#include <wolfssl/wolfcrypt/error-crypt.h>
+
+#include "main.h"
+
+#if defined(CONFIG_BENCH_HW_ORDER) && defined(WOLFSSL_ESP_HW_ORDER) && \
+    defined(WOLFSSL_TLS13) && defined(HAVE_AESGCM) && \
+    !defined(NO_WOLFSSL_CLIENT) && !defined(NO_WOLFSSL_SERVER)
+
+#include <string.h>
+
+#include "tls_loopback.h"
+#include "esp_wolfssl_hw_order.h"
+
+static const char* const TAG = "bench_hw_order";
+
+#define BENCH_HW_ORDER_TASK_STACK_SIZE (16 * 1024)
+
+typedef struct bench_hw_order_case {
+    const char* name;
+    int         aead;
+    const char* cipher_list;
+    int         group;
+} bench_hw_order_case;
+
+static const bench_hw_order_case bench_hw_order_cases[] = {
+#ifdef HAVE_CURVE25519
+    { "AES-128-GCM X25519", ESP_WOLFSSL_HW_ORDER_AES_GCM,
+      "TLS13-AES128-GCM-SHA256", WOLFSSL_ECC_X25519 },
+#endif
+#ifdef HAVE_ECC
+    { "AES-128-GCM P-256", ESP_WOLFSSL_HW_ORDER_AES_GCM,
+      "TLS13-AES128-GCM-SHA256", WOLFSSL_ECC_SECP256R1 },
+#endif
+#if defined(HAVE_CHACHA) && defined(HAVE_POLY1305)
+    #ifdef HAVE_CURVE25519
+    { "ChaCha20 X25519", ESP_WOLFSSL_HW_ORDER_CHACHA,
+      "TLS13-CHACHA20-POLY1305-SHA256", WOLFSSL_ECC_X25519 },
+    #endif
+    #ifdef HAVE_ECC
+    { "ChaCha20 P-256", ESP_WOLFSSL_HW_ORDER_CHACHA,
+      "TLS13-CHACHA20-POLY1305-SHA256", WOLFSSL_ECC_SECP256R1 },
+    #endif
+#endif
+};
+
+#define BENCH_HW_ORDER_CASES \
+    (sizeof(bench_hw_order_cases) / sizeof(bench_hw_order_cases[0]))
+
+typedef struct bench_hw_order_result {
+    int64_t handshake_us;
+    int64_t bulk_us;
+} bench_hw_order_result;
+
+typedef struct bench_hw_order_ctx {
+    TaskHandle_t          parent;
+    int                   ret;
+    bench_hw_order_result res[BENCH_HW_ORDER_CASES];
+} bench_hw_order_ctx;
+
+static int bench_hw_order_group;
+
+static int bench_hw_order_setup(WOLFSSL* ssl, int server)
+{
+    int group = bench_hw_order_group;
+    int ret = wolfSSL_set_groups(ssl, &group, 1);
+
+    if (ret == WOLFSSL_SUCCESS && !server) {
+        ret = wolfSSL_UseKeyShare(ssl, (word16)group);
+    }
+    return (ret == WOLFSSL_SUCCESS) ? 0 : ret;
+}
+
+static int bench_hw_order_case_run(const bench_hw_order_case* c,
+                                   bench_hw_order_result* res)
+{
+    tls_loopback_cfg cfg;
+    tls_loopback lb;
+    int64_t start;
+    size_t done;
+    int ret;
+    int i;
+
+    memset(&cfg, 0, sizeof(cfg));
+    cfg.version = TLS_LOOPBACK_VERSION_13;
+    cfg.cipher_list = c->cipher_list;
+    cfg.setup = bench_hw_order_setup;
+    bench_hw_order_group = c->group;
+
+    ret = tls_loopback_init(&lb, &cfg);
+    if (ret != 0) {
+        return ret;
+    }
+    for (i = 0; ret == 0 && i < CONFIG_BENCH_HW_ORDER_COUNT; i++) {
+        ret = tls_loopback_connect(&lb);
+        if (ret == 0) {
+            res->handshake_us += lb.stats.handshake_us;
+            start = esp_timer_get_time();
+            for (done = 0; ret == 0 &&
+                           done < CONFIG_BENCH_HW_ORDER_BULK_KB * 1024;
+                 done += TLS_LOOPBACK_MAX_WRITE) {
+                ret = tls_loopback_echo(&lb, TLS_LOOPBACK_MAX_WRITE);
+            }
+            res->bulk_us += esp_timer_get_time() - start;
+        }
+        tls_loopback_close(&lb);
+    }
+    tls_loopback_free(&lb);
+    return ret;
+}
+
+static void bench_hw_order_task(void* arg)
+{
+    bench_hw_order_ctx* ctx = (bench_hw_order_ctx*)arg;
+    size_t i;
+    int ret = 0;
+
+    for (i = 0; ret == 0 && i < BENCH_HW_ORDER_CASES; i++) {
+        ret = bench_hw_order_case_run(&bench_hw_order_cases[i], &ctx->res[i]);
+        if (ret != 0) {
+            ESP_LOGE(TAG, "%s failed: %d", bench_hw_order_cases[i].name, ret);
+        }
+    }
+
+    ctx->ret = ret;
+    xTaskNotifyGive(ctx->parent);
+    vTaskDelete(NULL);
+}
+
+int bench_hw_order(void)
+{
+    static bench_hw_order_ctx ctx;
+    esp_wolfssl_hw_order_t order;
+    const bench_hw_order_case* c;
+    int64_t init_us;
+    int ret;
+    size_t i;
+
+    /* reference counted; the wolfCrypt benchmark cleans up after itself */
+    ret = wolfSSL_Init();
+    if (ret != WOLFSSL_SUCCESS) {
+        return ret;
+    }
+
+    init_us = esp_timer_get_time();
+    ret = esp_wolfssl_hw_order_init();
+    init_us = esp_timer_get_time() - init_us;
+    esp_wolfssl_hw_order_get(&order);
+    if (order.measured) {
+        ESP_LOGI(TAG, "measured in %lld us: 1 KB record AES-128-GCM %u us, "
+                      "ChaCha20-Poly1305 %u us; shared secret P-256 %u us, "
+                      "X25519 %u us", (long long)init_us,
+                 (unsigned)order.aes_gcm_us, (unsigned)order.chacha_us,
+                 (unsigned)order.p256_us, (unsigned)order.x25519_us);
+    }
+    else {
+        ESP_LOGI(TAG, "per-chip table%s", (ret != 0) ? ", measurement failed"
+                                                     : "");
+    }
+    if (esp_wolfssl_hw_order_cipher_list() != NULL) {
+        ESP_LOGI(TAG, "cipher list %s", esp_wolfssl_hw_order_cipher_list());
+    }
+
+    memset(&ctx, 0, sizeof(ctx));
+    ctx.parent = xTaskGetCurrentTaskHandle();
+    if (xTaskCreate(bench_hw_order_task, "bench_hw_order",
+                    BENCH_HW_ORDER_TASK_STACK_SIZE, &ctx,
+                    uxTaskPriorityGet(NULL), NULL) != pdPASS) {
+        wolfSSL_Cleanup();
+        return MEMORY_E;
+    }
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    ret = ctx.ret;
+
+    ESP_LOGI(TAG, "TLS 1.3, %d connections each, %d KB echoed per "
+                  "connection", CONFIG_BENCH_HW_ORDER_COUNT,
+             CONFIG_BENCH_HW_ORDER_BULK_KB);
+    for (i = 0; ret == 0 && i < BENCH_HW_ORDER_CASES; i++) {
+        c = &bench_hw_order_cases[i];
+        /* both directions pass through the AEAD */
+        ESP_LOGI(TAG, "%-18s handshake %8lld us, bulk %6lld KB/s%s",
+                 c->name,
+                 (long long)(ctx.res[i].handshake_us
+                             / CONFIG_BENCH_HW_ORDER_COUNT),
+                 (long long)((int64_t)CONFIG_BENCH_HW_ORDER_BULK_KB * 2
+                             * CONFIG_BENCH_HW_ORDER_COUNT * 1000000
+                             / (ctx.res[i].bulk_us > 0 ? ctx.res[i].bulk_us
+                                                       : 1)),
+                 (c->aead == order.aead_first &&
+                  c->group == order.group_first) ? "  <- chosen" : "");
+    }
+
+    wolfSSL_Cleanup();
+    return ret;
+}
+
+#endif /* CONFIG_BENCH_HW_ORDER && WOLFSSL_ESP_HW_ORDER && ... */
@@ -0,0 +1,157 @@
+/* bench_keypool.c
+ *
+ * Copyright (C) 2006-2024 wolfSSL Inc.
+ *
+ * This file is part of wolfSSL.
+ *
+ * wolfSSL is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfSSL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335, USA
+ */
+
+/* TLS 1.3 handshakes over the in-memory loopback with the ephemeral keys
+ * of both ends generated on the spot and taken from the key pool of
+ * esp_wolfssl_keypool.h, for each pooled group. Between connects the task
+ * sleeps, like a device that idles before it connects, which lets the
+ * refill task top the pool up. Reports handshake latency and how many
+ * keys came from the pool. */
+
+/* ESP-IDF */
+#include "sdkconfig.h"
+#include <esp_log.h>
+
+/* wolfSSL */
+#include <wolfssl/wolfcrypt/settings.h>
+#include <wolfssl/ssl.h>
+#include <wolfssl/wolfcrypt/error-crypt.h>
+
+#include "main.h"
+
+#if defined(CONFIG_BENCH_KEYPOOL) && defined(WOLFSSL_ESP_KEYPOOL) && \
+    defined(WOLFSSL_TLS13) && \
+    !defined(NO_WOLFSSL_CLIENT) && !defined(NO_WOLFSSL_SERVER)
+
+#include <string.h>
+
+#include "tls_loopback.h"
+#include "esp_wolfssl_keypool.h"
+
+static const char* const TAG = "bench_keypool";
+
+#define BENCH_KEYPOOL_TASK_STACK_SIZE (16 * 1024)
+
+static int bench_keypool_group;
+
+static int bench_keypool_setup(WOLFSSL* ssl, int server)
+{
+    int group = bench_keypool_group;
+    int ret = wolfSSL_set_groups(ssl, &group, 1);
+
+    if (ret == WOLFSSL_SUCCESS && !server) {
+        ret = wolfSSL_UseKeyShare(ssl, (word16)group);
+    }
+    return (ret == WOLFSSL_SUCCESS) ? 0 : ret;
+}
+
+static int bench_keypool_run(tls_loopback_bench* b,
+                             esp_wolfssl_keypool_stats_t* stats, int group,
+                             int pool)
+{
+    tls_loopback_cfg cfg;
+    int ret;
+
+    memset(&cfg, 0, sizeof(cfg));
+    cfg.version = TLS_LOOPBACK_VERSION_13;
+    cfg.setup = bench_keypool_setup;
+    bench_keypool_group = group;
+
+    memset(b, 0, sizeof(*b));
+    b->cfg = &cfg;
+    b->count = CONFIG_BENCH_KEYPOOL_COUNT;
+    b->idle_ms = CONFIG_BENCH_KEYPOOL_IDLE_MS;
+    b->stack_size = BENCH_KEYPOOL_TASK_STACK_SIZE;
+
+    esp_wolfssl_keypool_set_enabled(pool);
+    if (pool) {
+        (void)esp_wolfssl_keypool_start();
+    }
+    esp_wolfssl_keypool_reset_stats();
+    ret = tls_loopback_bench_run(b);
+    esp_wolfssl_keypool_get_stats(stats);
+    return ret;
+}
+
+static void bench_keypool_log(const char* name, const char* mode,
+                              const tls_loopback_bench* b,
+                              const esp_wolfssl_keypool_stats_t* stats)
+{
+    ESP_LOGI(TAG, "%-6s %-8s %8lld us avg, %8lld min, %8lld max, "
+                  "%u keys from the pool, %u generated on the spot",
+             name, mode, (long long)tls_loopback_timing_avg(&b->timing),
+             (long long)b->timing.min_us, (long long)b->timing.max_us,
+             (unsigned)stats->hits, (unsigned)stats->misses);
+}
+
+static int bench_keypool_group_run(const char* name, int group)
+{
+    tls_loopback_bench off;
+    tls_loopback_bench on;
+    esp_wolfssl_keypool_stats_t off_stats;
+    esp_wolfssl_keypool_stats_t on_stats;
+    int ret;
+
+    ret = bench_keypool_run(&off, &off_stats, group, 0);
+    if (ret == 0) {
+        ret = bench_keypool_run(&on, &on_stats, group, 1);
+    }
+    if (ret != 0) {
+        ESP_LOGE(TAG, "%s handshake failed: %d", name, ret);
+        return ret;
+    }
+    bench_keypool_log(name, "no pool", &off, &off_stats);
+    bench_keypool_log(name, "pool", &on, &on_stats);
+    ESP_LOGI(TAG, "%-6s the pool saves %lld us per handshake", name,
+             (long long)(tls_loopback_timing_avg(&off.timing)
+                         - tls_loopback_timing_avg(&on.timing)));
+    return 0;
+}
+
+int bench_keypool_compare(void)
+{
+    int ret;
+
+    /* reference counted; the wolfCrypt benchmark cleans up after itself */
+    ret = wolfSSL_Init();
+    if (ret != WOLFSSL_SUCCESS) {
+        return ret;
+    }
+
+    ESP_LOGI(TAG, "TLS 1.3, %d handshakes each, %d ms idle before each, "
+                  "client and server", CONFIG_BENCH_KEYPOOL_COUNT,
+             CONFIG_BENCH_KEYPOOL_IDLE_MS);
+    ret = 0;
+#if defined(HAVE_CURVE25519) && defined(CONFIG_WOLFSSL_KEYPOOL_X25519)
+    ret = bench_keypool_group_run("X25519", WOLFSSL_ECC_X25519);
+#endif
+#if defined(HAVE_ECC) && defined(CONFIG_WOLFSSL_KEYPOOL_P256)
+    if (ret == 0) {
+        ret = bench_keypool_group_run("P-256", WOLFSSL_ECC_SECP256R1);
+    }
+#endif
+    esp_wolfssl_keypool_set_enabled(1);
+
+    wolfSSL_Cleanup();
+    return ret;
+}
+
+#endif /* CONFIG_BENCH_KEYPOOL && WOLFSSL_ESP_KEYPOOL && ... */
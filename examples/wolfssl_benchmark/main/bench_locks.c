@@ -0,0 +1,247 @@
+/* bench_locks.c
+ *
+ * Copyright (C) 2006-2024 wolfSSL Inc.
+ *
+ * This file is part of wolfSSL.
+ *
+ * wolfSSL is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfSSL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335, USA
+ */
+
+/* Cost of a short critical section under a wolfSSL mutex, under the
+ * esp_wolfssl_spin_t of esp_wolfssl_lock.h, and as a single atomic add,
+ * with one thread and with several contending for the same counter. Each
+ * operation increments a shared counter, which is checked at the end.
+ *
+ * On the device, enable Example Configuration -> Benchmark lock
+ * contention; on a dual-core chip the second task runs on the other core.
+ * On a Linux host, where a wolfSSL mutex is a pthread mutex:
+ *
+ *   gcc -O2 -DBENCH_LOCKS_HOST_MAIN -DWOLFSSL_ESP_LIGHT_LOCKS \
+ *       -include wolfssl/options.h -Imain/include -I../../port \
+ *       main/bench_locks.c -lwolfssl -lpthread -o locks
+ *   ./locks
+ */
+
+#include "bench_common.h"
+
+#if defined(CONFIG_BENCH_LOCKS) || defined(BENCH_LOCKS_HOST_MAIN)
+
+#include <string.h>
+
+#include <wolfssl/wolfcrypt/types.h>
+#include <wolfssl/wolfcrypt/error-crypt.h>
+#include <wolfssl/wolfcrypt/wc_port.h>
+
+#ifdef ESP_PLATFORM
+    #include <freertos/FreeRTOS.h>
+    #include <freertos/task.h>
+#else
+    #include <pthread.h>
+    #include <sched.h>
+#endif
+
+#include "esp_wolfssl_lock.h"
+#include "main.h"
+
+#ifndef CONFIG_BENCH_LOCKS_ITERATIONS
+    #define CONFIG_BENCH_LOCKS_ITERATIONS 100000
+#endif
+#ifdef ESP_PLATFORM
+    /* spread over the cores; on a single core they preempt each other */
+    #define BENCH_LOCKS_THREADS 2
+#else
+    #define BENCH_LOCKS_THREADS 4
+#endif
+
+#define BENCH_LOCKS_TASK_STACK_SIZE 2048
+
+static const char* const TAG = "bench_locks";
+
+enum {
+    BENCH_LOCKS_MUTEX,
+    BENCH_LOCKS_SPIN,
+    BENCH_LOCKS_ATOMIC,
+    BENCH_LOCKS_MODES
+};
+
+static const char* const bench_locks_names[BENCH_LOCKS_MODES] = {
+    "wolfSSL mutex", "esp_wolfssl_spin", "atomic add"
+};
+
+static wolfSSL_Mutex bench_locks_mutex;
+static esp_wolfssl_spin_t bench_locks_spin;
+static volatile uint32_t bench_locks_counter;
+static int bench_locks_mode;
+static int bench_locks_go;
+static int bench_locks_failed;
+
+static void bench_locks_work(void)
+{
+    int i;
+
+    /* all threads start together */
+    while (!__atomic_load_n(&bench_locks_go, __ATOMIC_ACQUIRE)) {
+#ifdef ESP_PLATFORM
+        taskYIELD();
+#else
+        sched_yield();
+#endif
+    }
+
+    for (i = 0; i < CONFIG_BENCH_LOCKS_ITERATIONS; i++) {
+        switch (bench_locks_mode) {
+            case BENCH_LOCKS_MUTEX:
+                if (wc_LockMutex(&bench_locks_mutex) != 0) {
+                    __atomic_store_n(&bench_locks_failed, 1,
+                                     __ATOMIC_RELAXED);
+                    return;
+                }
+                bench_locks_counter++;
+                wc_UnLockMutex(&bench_locks_mutex);
+                break;
+            case BENCH_LOCKS_SPIN:
+                if (!esp_wolfssl_spin_lock(&bench_locks_spin)) {
+                    __atomic_store_n(&bench_locks_failed, 1,
+                                     __ATOMIC_RELAXED);
+                    return;
+                }
+                bench_locks_counter++;
+                esp_wolfssl_spin_unlock(&bench_locks_spin);
+                break;
+            default:
+                __atomic_add_fetch(&bench_locks_counter, 1, __ATOMIC_RELAXED);
+                break;
+        }
+    }
+}
+
+#ifdef ESP_PLATFORM
+static TaskHandle_t bench_locks_parent;
+
+static void bench_locks_task(void* arg)
+{
+    (void)arg;
+    bench_locks_work();
+    xTaskNotifyGive(bench_locks_parent);
+    vTaskDelete(NULL);
+}
+#else
+static void* bench_locks_thread(void* arg)
+{
+    (void)arg;
+    bench_locks_work();
+    return NULL;
+}
+#endif
+
+/* ns per operation, or -1 */
+static int64_t bench_locks_run(int mode, int threads)
+{
+#ifndef ESP_PLATFORM
+    pthread_t tid[BENCH_LOCKS_THREADS];
+#endif
+    int64_t start;
+    int64_t elapsed;
+    int started = 0;
+    int i;
+
+    bench_locks_mode = mode;
+    bench_locks_counter = 0;
+    bench_locks_failed = 0;
+    __atomic_store_n(&bench_locks_go, 0, __ATOMIC_RELEASE);
+
+    for (i = 0; i < threads; i++) {
+#ifdef ESP_PLATFORM
+        bench_locks_parent = xTaskGetCurrentTaskHandle();
+        if (xTaskCreatePinnedToCore(bench_locks_task, "bench_locks",
+                                    BENCH_LOCKS_TASK_STACK_SIZE, NULL,
+                                    uxTaskPriorityGet(NULL), NULL,
+                                    i % portNUM_PROCESSORS) != pdPASS) {
+            break;
+        }
+#else
+        if (pthread_create(&tid[i], NULL, bench_locks_thread, NULL) != 0) {
+            break;
+        }
+#endif
+        started++;
+    }
+
+    start = esp_timer_get_time();
+    __atomic_store_n(&bench_locks_go, 1, __ATOMIC_RELEASE);
+    for (i = 0; i < started; i++) {
+#ifdef ESP_PLATFORM
+        ulTaskNotifyTake(pdFALSE, portMAX_DELAY);
+#else
+        pthread_join(tid[i], NULL);
+#endif
+    }
+    elapsed = esp_timer_get_time() - start;
+
+    if (started != threads || bench_locks_failed ||
+        bench_locks_counter
+            != (uint32_t)threads * CONFIG_BENCH_LOCKS_ITERATIONS) {
+        ESP_LOGE(TAG, "%s, %d threads: counter %u of %u",
+                 bench_locks_names[mode], threads,
+                 (unsigned)bench_locks_counter,
+                 (unsigned)(threads * CONFIG_BENCH_LOCKS_ITERATIONS));
+        return -1;
+    }
+    return elapsed * 1000 / ((int64_t)threads * CONFIG_BENCH_LOCKS_ITERATIONS);
+}
+
+int bench_locks(void)
+{
+    int64_t ns[2];
+    int ret;
+    int mode;
+
+    ret = wc_InitMutex(&bench_locks_mutex);
+    if (ret != 0) {
+        return ret;
+    }
+    ret = esp_wolfssl_spin_init(&bench_locks_spin);
+
+    ESP_LOGI(TAG, "%d increments per thread, %s", CONFIG_BENCH_LOCKS_ITERATIONS,
+#ifdef WOLFSSL_ESP_LIGHT_LOCKS
+             "esp_wolfssl_spin is a spinlock"
+#else
+             "esp_wolfssl_spin is a wolfSSL mutex"
+#endif
+             );
+    for (mode = 0; ret == 0 && mode < BENCH_LOCKS_MODES; mode++) {
+        ns[0] = bench_locks_run(mode, 1);
+        ns[1] = (ns[0] < 0) ? -1 : bench_locks_run(mode, BENCH_LOCKS_THREADS);
+        if (ns[1] < 0) {
+            ret = BAD_STATE_E;
+            break;
+        }
+        ESP_LOGI(TAG, "%-16s 1 thread %6lld ns, %d threads %6lld ns per op",
+                 bench_locks_names[mode], (long long)ns[0],
+                 BENCH_LOCKS_THREADS, (long long)ns[1]);
+    }
+
+    wc_FreeMutex(&bench_locks_mutex);
+    return ret;
+}
+
+#ifdef BENCH_LOCKS_HOST_MAIN
+int main(void)
+{
+    return (bench_locks() == 0) ? 0 : 1;
+}
+#endif
+
+#endif /* CONFIG_BENCH_LOCKS || BENCH_LOCKS_HOST_MAIN */
@@ -0,0 +1,409 @@
+/* bench_nonblock.c
+ *
+ * Copyright (C) 2006-2024 wolfSSL Inc.
+ *
+ * This file is part of wolfSSL.
+ *
+ * wolfSSL is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfSSL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335, USA
+ */
+
+/* Longest slice and total time of the time-sliced ECC and RSA operations of
+ * esp_wolfssl_nonblock.h against the blocking ones, and of TLS handshakes
+ * over an in-memory loopback with and without its PK callbacks, for a P-256
+ * and an RSA-2048 certificate. For handshakes the longest stretch between
+ * two calls of the hook is reported as well, which also covers the work
+ * that is not sliced, such as key generation and the shared secret.
+ *
+ * On the device, enable Example Configuration -> Benchmark time-sliced ECC
+ * and RSA. On a Linux host, against a wolfSSL built with the incremental
+ * paths, e.g. configure --enable-fastmath --enable-sp=nonblock
+ * --enable-ecc=nonblock --enable-pkcallbacks CFLAGS=-DWC_RSA_NONBLOCK:
+ *
+ *   gcc -O2 -DBENCH_NONBLOCK_HOST_MAIN -DWOLFSSL_ESP_NONBLOCK \
+ *       -include wolfssl/options.h -Imain/include -I../../port \
+ *       main/bench_nonblock.c main/tls_loopback.c \
+ *       ../../port/esp_wolfssl_nonblock.c -lwolfssl -o nonblock
+ *   ./nonblock
+ */
+
+#include "bench_common.h"
+
+#if (defined(CONFIG_BENCH_NONBLOCK) || defined(BENCH_NONBLOCK_HOST_MAIN)) && \
+    defined(WOLFSSL_ESP_NONBLOCK)
+
+#include <string.h>
+
+#include <wolfssl/wolfcrypt/types.h>
+#include <wolfssl/wolfcrypt/error-crypt.h>
+#include <wolfssl/wolfcrypt/random.h>
+#include <wolfssl/wolfcrypt/asn_public.h>
+#include <wolfssl/wolfcrypt/wc_port.h>
+
+/* host builds: ESP-IDF user_settings.h defines these */
+#if !defined(USE_CERT_BUFFERS_2048) && !defined(USE_CERT_BUFFERS_1024)
+    #define USE_CERT_BUFFERS_2048
+    #define USE_CERT_BUFFERS_256
+#endif
+#include <wolfssl/certs_test.h>
+
+#include "esp_wolfssl_nonblock.h"
+#include "main.h"
+
+#if defined(HAVE_PK_CALLBACKS) && !defined(WOLFCRYPT_ONLY) && \
+    !defined(NO_WOLFSSL_CLIENT) && !defined(NO_WOLFSSL_SERVER)
+    #define BENCH_NB_HANDSHAKES
+    #include "tls_loopback.h"
+#endif
+
+#ifndef CONFIG_BENCH_NONBLOCK_COUNT
+    #define CONFIG_BENCH_NONBLOCK_COUNT 5
+#endif
+
+static const char* const TAG = "bench_nonblock";
+
+/* the longest stretch between two calls of the hook */
+static int64_t bench_nb_last;
+static int64_t bench_nb_max_gap;
+
+static void bench_nb_gap(void)
+{
+    int64_t now = esp_timer_get_time();
+
+    if (now - bench_nb_last > bench_nb_max_gap) {
+        bench_nb_max_gap = now - bench_nb_last;
+    }
+    bench_nb_last = now;
+}
+
+static void bench_nb_hook(void* arg)
+{
+    (void)arg;
+    bench_nb_gap();
+}
+
+static void bench_nb_gap_start(void)
+{
+    bench_nb_last = esp_timer_get_time();
+    bench_nb_max_gap = 0;
+}
+
+static void bench_nb_report(const char* name, int64_t blocking_us,
+                            int64_t sliced_us)
+{
+    esp_wolfssl_nb_stats_t stats;
+
+    esp_wolfssl_nb_get_stats(&stats);
+    ESP_LOGI(TAG, "%-18s blocking %8lld us, sliced %8lld us in %4u slices, "
+                  "longest slice %6u us",
+             name, (long long)(blocking_us / CONFIG_BENCH_NONBLOCK_COUNT),
+             (long long)(sliced_us / CONFIG_BENCH_NONBLOCK_COUNT),
+             (unsigned)(stats.slices / CONFIG_BENCH_NONBLOCK_COUNT),
+             (unsigned)stats.max_slice_us);
+}
+
+#ifdef WC_ECC_NONBLOCK
+static int bench_nb_ecc(WC_RNG* rng)
+{
+    ecc_key* key;
+    byte hash[32];
+    byte sig[ECC_MAX_SIG_SIZE];
+    word32 sig_sz = 0;
+    word32 idx = 0;
+    int64_t start;
+    int64_t blocking_us;
+    int64_t sliced_us;
+    int verified = 0;
+    int ret;
+    int i;
+
+    XMEMSET(hash, 0xA5, sizeof(hash));
+    key = (ecc_key*)XMALLOC(sizeof(*key), NULL, DYNAMIC_TYPE_ECC);
+    if (key == NULL) {
+        return MEMORY_E;
+    }
+    ret = wc_ecc_init(key);
+    if (ret != 0) {
+        XFREE(key, NULL, DYNAMIC_TYPE_ECC);
+        return ret;
+    }
+    ret = wc_EccPrivateKeyDecode(ecc_key_der_256, &idx, key,
+                                 sizeof_ecc_key_der_256);
+
+    blocking_us = 0;
+    sliced_us = 0;
+    esp_wolfssl_nb_reset_stats();
+    for (i = 0; ret == 0 && i < CONFIG_BENCH_NONBLOCK_COUNT; i++) {
+        sig_sz = sizeof(sig);
+        start = esp_timer_get_time();
+        ret = wc_ecc_sign_hash(hash, sizeof(hash), sig, &sig_sz, rng, key);
+        blocking_us += esp_timer_get_time() - start;
+        if (ret == 0) {
+            sig_sz = sizeof(sig);
+            start = esp_timer_get_time();
+            ret = esp_wolfssl_nb_ecc_sign_hash(hash, sizeof(hash), sig,
+                                               &sig_sz, rng, key);
+            sliced_us += esp_timer_get_time() - start;
+        }
+    }
+    if (ret == 0) {
+        bench_nb_report("ECC P-256 sign", blocking_us, sliced_us);
+    }
+
+    blocking_us = 0;
+    sliced_us = 0;
+    esp_wolfssl_nb_reset_stats();
+    for (i = 0; ret == 0 && i < CONFIG_BENCH_NONBLOCK_COUNT; i++) {
+        start = esp_timer_get_time();
+        ret = wc_ecc_verify_hash(sig, sig_sz, hash, sizeof(hash), &verified,
+                                 key);
+        blocking_us += esp_timer_get_time() - start;
+        if (ret == 0 && verified == 1) {
+            verified = 0;
+            start = esp_timer_get_time();
+            ret = esp_wolfssl_nb_ecc_verify_hash(sig, sig_sz, hash,
+                                                 sizeof(hash), &verified,
+                                                 key);
+            sliced_us += esp_timer_get_time() - start;
+        }
+        if (ret == 0 && verified != 1) {
+            ret = SIG_VERIFY_E;
+        }
+    }
+    if (ret == 0) {
+        bench_nb_report("ECC P-256 verify", blocking_us, sliced_us);
+    }
+
+    wc_ecc_free(key);
+    XFREE(key, NULL, DYNAMIC_TYPE_ECC);
+    return ret;
+}
+#endif /* WC_ECC_NONBLOCK */
+
+#ifdef WC_RSA_NONBLOCK
+static int bench_nb_rsa(WC_RNG* rng)
+{
+    RsaKey* key;
+    byte msg[32];
+    byte sig[256];
+    byte tmp[256];
+    byte* out;
+    int sig_sz = 0;
+    word32 idx = 0;
+    int64_t start;
+    int64_t blocking_us;
+    int64_t sliced_us;
+    int ret;
+    int i;
+
+    XMEMSET(msg, 0xA5, sizeof(msg));
+    key = (RsaKey*)XMALLOC(sizeof(*key), NULL, DYNAMIC_TYPE_RSA);
+    if (key == NULL) {
+        return MEMORY_E;
+    }
+    ret = wc_InitRsaKey(key, NULL);
+    if (ret != 0) {
+        XFREE(key, NULL, DYNAMIC_TYPE_RSA);
+        return ret;
+    }
+    ret = wc_RsaPrivateKeyDecode(client_key_der_2048, &idx, key,
+                                 sizeof_client_key_der_2048);
+#ifdef WC_RSA_BLINDING
+    if (ret == 0) {
+        ret = wc_RsaSetRNG(key, rng);
+    }
+#endif
+
+    blocking_us = 0;
+    sliced_us = 0;
+    esp_wolfssl_nb_reset_stats();
+    for (i = 0; ret == 0 && i < CONFIG_BENCH_NONBLOCK_COUNT; i++) {
+        start = esp_timer_get_time();
+        ret = wc_RsaSSL_Sign(msg, sizeof(msg), sig, sizeof(sig), key, rng);
+        blocking_us += esp_timer_get_time() - start;
+        if (ret > 0) {
+            start = esp_timer_get_time();
+            ret = esp_wolfssl_nb_rsa_sign(msg, sizeof(msg), sig, sizeof(sig),
+                                          key, rng);
+            sliced_us += esp_timer_get_time() - start;
+        }
+        if (ret > 0) {
+            sig_sz = ret;
+            ret = 0;
+        }
+    }
+    if (ret == 0) {
+        bench_nb_report("RSA-2048 sign", blocking_us, sliced_us);
+    }
+
+    blocking_us = 0;
+    sliced_us = 0;
+    esp_wolfssl_nb_reset_stats();
+    for (i = 0; ret == 0 && i < CONFIG_BENCH_NONBLOCK_COUNT; i++) {
+        XMEMCPY(tmp, sig, (size_t)sig_sz);
+        start = esp_timer_get_time();
+        ret = wc_RsaSSL_VerifyInline(tmp, (word32)sig_sz, &out, key);
+        blocking_us += esp_timer_get_time() - start;
+        if (ret > 0) {
+            XMEMCPY(tmp, sig, (size_t)sig_sz);
+            start = esp_timer_get_time();
+            ret = esp_wolfssl_nb_rsa_verify_inline(tmp, (word32)sig_sz, &out,
+                                                   key);
+            sliced_us += esp_timer_get_time() - start;
+        }
+        if (ret > 0) {
+            ret = (ret == (int)sizeof(msg) &&
+                   XMEMCMP(out, msg, sizeof(msg)) == 0) ? 0 : SIG_VERIFY_E;
+        }
+    }
+    if (ret == 0) {
+        bench_nb_report("RSA-2048 verify", blocking_us, sliced_us);
+    }
+
+    wc_FreeRsaKey(key);
+    XFREE(key, NULL, DYNAMIC_TYPE_RSA);
+    return ret;
+}
+#endif /* WC_RSA_NONBLOCK */
+
+#ifdef BENCH_NB_HANDSHAKES
+static int bench_nb_ctx_setup(WOLFSSL_CTX* ctx, int server)
+{
+    (void)server;
+    return esp_wolfssl_nb_ctx_setup(ctx);
+}
+
+static int bench_nb_handshakes(const char* name, tls_loopback_cfg* cfg,
+                               int sliced)
+{
+    esp_wolfssl_nb_stats_t stats;
+    tls_loopback lb;
+    int64_t total_us = 0;
+    int64_t max_gap = 0;
+    int ret;
+    int i;
+
+    cfg->ctx_setup = sliced ? bench_nb_ctx_setup : NULL;
+    ret = tls_loopback_init(&lb, cfg);
+    if (ret != 0) {
+        return ret;
+    }
+    esp_wolfssl_nb_reset_stats();
+    for (i = 0; ret == 0 && i < CONFIG_BENCH_NONBLOCK_COUNT; i++) {
+        bench_nb_gap_start();
+        ret = tls_loopback_connect(&lb);
+        bench_nb_gap();
+        if (ret == 0) {
+            total_us += lb.stats.handshake_us;
+            if (bench_nb_max_gap > max_gap) {
+                max_gap = bench_nb_max_gap;
+            }
+        }
+        tls_loopback_close(&lb);
+    }
+    esp_wolfssl_nb_get_stats(&stats);
+    tls_loopback_free(&lb);
+
+    if (ret == 0) {
+        ESP_LOGI(TAG, "%-7s handshake %-8s %8lld us avg, longest slice "
+                      "%6u us, longest without the hook %8lld us",
+                 name, sliced ? "sliced" : "blocking",
+                 (long long)(total_us / CONFIG_BENCH_NONBLOCK_COUNT),
+                 (unsigned)stats.max_slice_us, (long long)max_gap);
+    }
+    return ret;
+}
+#endif /* BENCH_NB_HANDSHAKES */
+
+int bench_nonblock(void)
+{
+    WC_RNG rng;
+    int ret;
+#ifdef BENCH_NB_HANDSHAKES
+    tls_loopback_cfg cfg;
+#endif
+
+#ifdef BENCH_NB_HANDSHAKES
+    /* reference counted; the wolfCrypt benchmark cleans up after itself */
+    ret = (wolfSSL_Init() == WOLFSSL_SUCCESS) ? 0 : WC_INIT_E;
+#else
+    ret = wolfCrypt_Init();
+#endif
+    if (ret != 0) {
+        return ret;
+    }
+
+    ESP_LOGI(TAG, "slices of %u us, %d runs each",
+             (unsigned)ESP_WOLFSSL_NB_SLICE_US, CONFIG_BENCH_NONBLOCK_COUNT);
+    esp_wolfssl_nb_set_hook(bench_nb_hook, NULL);
+
+    ret = wc_InitRng(&rng);
+    if (ret == 0) {
+#ifdef WC_ECC_NONBLOCK
+        ret = bench_nb_ecc(&rng);
+#endif
+#ifdef WC_RSA_NONBLOCK
+        if (ret == 0) {
+            ret = bench_nb_rsa(&rng);
+        }
+#endif
+        wc_FreeRng(&rng);
+    }
+
+#ifdef BENCH_NB_HANDSHAKES
+    /* the ECC handshake uses the P-256 test certificates */
+    XMEMSET(&cfg, 0, sizeof(cfg));
+    cfg.ca = ca_ecc_cert_der_256;
+    cfg.ca_sz = (int)sizeof_ca_ecc_cert_der_256;
+    cfg.server_cert = serv_ecc_der_256;
+    cfg.server_cert_sz = (int)sizeof_serv_ecc_der_256;
+    cfg.server_key = ecc_key_der_256;
+    cfg.server_key_sz = (int)sizeof_ecc_key_der_256;
+#ifdef WC_ECC_NONBLOCK
+    if (ret == 0) {
+        ret = bench_nb_handshakes("ECC", &cfg, 0);
+    }
+    if (ret == 0) {
+        ret = bench_nb_handshakes("ECC", &cfg, 1);
+    }
+#endif
+#ifdef WC_RSA_NONBLOCK
+    XMEMSET(&cfg, 0, sizeof(cfg));
+    if (ret == 0) {
+        ret = bench_nb_handshakes("RSA", &cfg, 0);
+    }
+    if (ret == 0) {
+        ret = bench_nb_handshakes("RSA", &cfg, 1);
+    }
+#endif
+    wolfSSL_Cleanup();
+#else
+    wolfCrypt_Cleanup();
+#endif
+
+    esp_wolfssl_nb_set_hook(NULL, NULL);
+    if (ret != 0) {
+        ESP_LOGE(TAG, "failed: %d", ret);
+    }
+    return ret;
+}
+
+#ifdef BENCH_NONBLOCK_HOST_MAIN
+int main(void)
+{
+    return (bench_nonblock() == 0) ? 0 : 1;
+}
+#endif
+
+#endif /* CONFIG_BENCH_NONBLOCK || BENCH_NONBLOCK_HOST_MAIN */
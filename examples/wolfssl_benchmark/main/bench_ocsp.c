@@ -0,0 +1,242 @@
+/* bench_ocsp.c
+ *
+ * Copyright (C) 2006-2024 wolfSSL Inc.
+ *
+ * This file is part of wolfSSL.
+ *
+ * wolfSSL is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfSSL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335, USA
+ */
+
+/* TLS 1.3 handshakes over the in-memory loopback with OCSP stapling off,
+ * on without the OCSP response cache, and on with it. The server's OCSP
+ * responder is a callback that returns a canned response (ocsp_test_data.h),
+ * so the numbers are the CPU cost of stapling, not the network. */
+
+#include "bench_common.h"
+
+#include "main.h"
+
+#if defined(CONFIG_BENCH_OCSP) && defined(HAVE_OCSP) && \
+    defined(HAVE_CERTIFICATE_STATUS_REQUEST) && defined(HAVE_ECC)
+
+#include <string.h>
+#include <sys/time.h>
+#include <time.h>
+
+#include <wolfssl/ssl.h>
+#include <wolfssl/wolfcrypt/error-crypt.h>
+
+#include "tls_loopback.h"
+#include "ocsp_test_data.h"
+#ifdef WOLFSSL_ESP_OCSP_CACHE
+    #include "esp_wolfssl_ocsp_cache.h"
+#endif
+
+static const char* const TAG = "bench_ocsp";
+
+/* after the thisUpdate of ocsp_response_der: 2026-10-20 */
+#define BENCH_OCSP_MIN_TIME 1792540800
+
+typedef struct bench_ocsp_result {
+    const char* name;
+    int64_t     avg_us;
+    int64_t     min_us;
+    int64_t     max_us;
+    uint32_t    bytes;          /* server to client, one handshake */
+    uint32_t    fetches;
+} bench_ocsp_result;
+
+static uint32_t bench_ocsp_fetches;
+
+/* stands in for the HTTP request to the OCSP responder */
+static int bench_ocsp_fetch(void* ctx, const char* url, int urlSz,
+                            unsigned char* req, int reqSz,
+                            unsigned char** resp)
+{
+    (void)ctx;
+    (void)url;
+    (void)urlSz;
+    (void)req;
+    (void)reqSz;
+
+    *resp = (unsigned char*)XMALLOC(sizeof_ocsp_response_der, NULL,
+                                    DYNAMIC_TYPE_OCSP);
+    if (*resp == NULL) {
+        return MEMORY_E;
+    }
+    memcpy(*resp, ocsp_response_der, sizeof_ocsp_response_der);
+    bench_ocsp_fetches++;
+    return sizeof_ocsp_response_der;
+}
+
+static void bench_ocsp_fetch_free(void* ctx, unsigned char* resp)
+{
+    (void)ctx;
+    XFREE(resp, NULL, DYNAMIC_TYPE_OCSP);
+}
+
+static int bench_ocsp_ctx_setup(WOLFSSL_CTX* ctx, int server)
+{
+    int ret = wolfSSL_CTX_EnableOCSPStapling(ctx);
+
+    if (ret == WOLFSSL_SUCCESS && server) {
+        /* the server needs the issuer to build the OCSP request */
+        ret = wolfSSL_CTX_load_verify_buffer(ctx, ocsp_ca_der,
+                                             sizeof_ocsp_ca_der,
+                                             WOLFSSL_FILETYPE_ASN1);
+        if (ret == WOLFSSL_SUCCESS) {
+    #ifdef WOLFSSL_ESP_OCSP_CACHE
+            ret = esp_wolfssl_ocsp_cache_set_io(ctx, bench_ocsp_fetch,
+                                                bench_ocsp_fetch_free, NULL);
+    #else
+            ret = wolfSSL_CTX_SetOCSP_Cb(ctx, bench_ocsp_fetch,
+                                         bench_ocsp_fetch_free, NULL);
+    #endif
+        }
+    }
+    else if (ret == WOLFSSL_SUCCESS) {
+        ret = wolfSSL_CTX_UseOCSPStapling(ctx, WOLFSSL_CSR_OCSP, 0);
+        if (ret == WOLFSSL_SUCCESS) {
+            /* fail the handshake if the server does not staple */
+            ret = wolfSSL_CTX_EnableOCSPMustStaple(ctx);
+        }
+    }
+
+    return (ret == WOLFSSL_SUCCESS) ? 0 : ret;
+}
+
+static int bench_ocsp_run(bench_ocsp_result* r, int stapling)
+{
+    tls_loopback_cfg cfg;
+    tls_loopback lb;
+    int ret;
+    int i;
+
+    memset(&cfg, 0, sizeof(cfg));
+    cfg.version = TLS_LOOPBACK_VERSION_13;
+    cfg.ca = ocsp_ca_der;
+    cfg.ca_sz = sizeof_ocsp_ca_der;
+    cfg.server_cert = ocsp_server_cert_der;
+    cfg.server_cert_sz = sizeof_ocsp_server_cert_der;
+    cfg.server_key = ocsp_server_key_der;
+    cfg.server_key_sz = sizeof_ocsp_server_key_der;
+    cfg.ctx_setup = stapling ? bench_ocsp_ctx_setup : NULL;
+
+    ret = tls_loopback_init(&lb, &cfg);
+    if (ret != 0) {
+        return ret;
+    }
+
+    bench_ocsp_fetches = 0;
+    r->min_us = INT64_MAX;
+    /* the first handshake fills the cache and is not counted */
+    for (i = 0; ret == 0 && i <= CONFIG_BENCH_OCSP_COUNT; i++) {
+        ret = tls_loopback_connect(&lb);
+        if (ret == 0 && i > 0) {
+            r->avg_us += lb.stats.handshake_us;
+            if (lb.stats.handshake_us < r->min_us) {
+                r->min_us = lb.stats.handshake_us;
+            }
+            if (lb.stats.handshake_us > r->max_us) {
+                r->max_us = lb.stats.handshake_us;
+            }
+            r->bytes = lb.stats.server_bytes;
+        }
+        tls_loopback_close(&lb);
+    }
+    r->avg_us /= CONFIG_BENCH_OCSP_COUNT;
+    r->fetches = bench_ocsp_fetches;
+
+    tls_loopback_free(&lb);
+    return ret;
+}
+
+static void bench_ocsp_log(const bench_ocsp_result* r)
+{
+    ESP_LOGI(TAG, "%-22s %8lld us avg, %8lld min, %8lld max, "
+                  "%5u bytes to client, %2u responder fetches",
+             r->name, (long long)r->avg_us, (long long)r->min_us,
+             (long long)r->max_us, (unsigned)r->bytes,
+             (unsigned)r->fetches);
+}
+
+int bench_ocsp_compare(void)
+{
+    bench_ocsp_result res[3];
+    struct timeval tv;
+    int n = 0;
+    int ret;
+    int i;
+
+    memset(res, 0, sizeof(res));
+    res[0].name = "OCSP off";
+    res[1].name = "stapling";
+    res[2].name = "stapling + cache";
+
+    /* OCSP dates are checked against the clock */
+    if (time(NULL) < BENCH_OCSP_MIN_TIME) {
+        tv.tv_sec = BENCH_OCSP_MIN_TIME;
+        tv.tv_usec = 0;
+        settimeofday(&tv, NULL);
+        ESP_LOGW(TAG, "clock not set, set to 2026-10-20 for the test "
+                      "OCSP response");
+    }
+
+    /* reference counted; the wolfCrypt benchmark cleans up after itself */
+    ret = wolfSSL_Init();
+    if (ret != WOLFSSL_SUCCESS) {
+        return ret;
+    }
+
+    ret = bench_ocsp_run(&res[n++], 0);
+#ifdef WOLFSSL_ESP_OCSP_CACHE
+    if (ret == 0) {
+        esp_wolfssl_ocsp_cache_set_enabled(0);
+        ret = bench_ocsp_run(&res[n++], 1);
+        esp_wolfssl_ocsp_cache_set_enabled(1);
+    }
+    if (ret == 0) {
+        esp_wolfssl_ocsp_cache_stats_t stats;
+
+        esp_wolfssl_ocsp_cache_clear();
+        ret = bench_ocsp_run(&res[n++], 1);
+        esp_wolfssl_ocsp_cache_get_stats(&stats);
+        ESP_LOGI(TAG, "cache: %u verified, %u verifications skipped, "
+                      "%u stapled from memory",
+                 (unsigned)stats.verified, (unsigned)stats.verify_skipped,
+                 (unsigned)stats.staple_hits);
+    }
+#else
+    if (ret == 0) {
+        ret = bench_ocsp_run(&res[n++], 1);
+    }
+#endif
+
+    if (ret != 0) {
+        ESP_LOGE(TAG, "%s handshake failed: %d", res[n - 1].name, ret);
+    }
+    else {
+        ESP_LOGI(TAG, "TLS 1.3, P-256, %d handshakes each",
+                 CONFIG_BENCH_OCSP_COUNT);
+        for (i = 0; i < n; i++) {
+            bench_ocsp_log(&res[i]);
+        }
+    }
+
+    wolfSSL_Cleanup();
+    return ret;
+}
+
+#endif /* CONFIG_BENCH_OCSP && HAVE_OCSP && ... */
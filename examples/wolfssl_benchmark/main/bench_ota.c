@@ -0,0 +1,376 @@
+/* bench_ota.c
+ *
+ * Copyright (C) 2006-2024 wolfSSL Inc.
+ *
+ * This file is part of wolfSSL.
+ *
+ * wolfSSL is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfSSL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335, USA
+ */
+
+/* Streaming OTA image verification (port/esp_wolfssl_ota_verify.h): a
+ * made-up image of CONFIG_BENCH_OTA_IMAGE_KB is signed with a fresh P-256
+ * key and fed to the verifier in CONFIG_BENCH_OTA_CHUNK byte chunks, as an
+ * OTA download would. Reports hashing throughput while streaming and the
+ * time of the final signature check, and on the device what reading the
+ * image back from flash to hash it, the flow it replaces, would add.
+ *
+ * The same source is a host harness that streams a file through the
+ * verifier, against an installed wolfSSL:
+ *
+ *   gcc -O2 -DBENCH_OTA_HOST_MAIN -DWOLFSSL_ESP_OTA_VERIFY \
+ *       -Imain/include -I../../port main/bench_ota.c \
+ *       ../../port/esp_wolfssl_ota_verify.c -lwolfssl -o ota_verify
+ *   ./ota_verify                                 (the benchmark)
+ *   ./ota_verify image.bin image.sig pub.der     (ECDSA, see the header)
+ *   ./ota_verify image.bin image.sig pub.lms lms (needs wolfSSL with LMS
+ *                                                 and -DWOLFSSL_HAVE_LMS)
+ *
+ * The exit status is 0 for a good signature. */
+
+#include "bench_common.h"
+
+#include "main.h"
+
+#if (defined(CONFIG_BENCH_OTA) || defined(BENCH_OTA_HOST_MAIN)) && \
+    defined(WOLFSSL_ESP_OTA_VERIFY) && defined(HAVE_ECC)
+
+#include <string.h>
+
+#include <wolfssl/wolfcrypt/types.h>
+#include <wolfssl/wolfcrypt/error-crypt.h>
+#include <wolfssl/wolfcrypt/random.h>
+#include <wolfssl/wolfcrypt/sha256.h>
+#include <wolfssl/wolfcrypt/ecc.h>
+#include <wolfssl/wolfcrypt/asn_public.h>
+#include <wolfssl/wolfcrypt/wc_port.h>
+
+#ifdef ESP_PLATFORM
+    #include <esp_ota_ops.h>
+    #include <esp_partition.h>
+#else
+    #include <stdlib.h>
+#endif
+
+#include "esp_wolfssl_ota_verify.h"
+
+#ifndef CONFIG_BENCH_OTA_IMAGE_KB
+    #define CONFIG_BENCH_OTA_IMAGE_KB 1024
+#endif
+#ifndef CONFIG_BENCH_OTA_CHUNK
+    #define CONFIG_BENCH_OTA_CHUNK    4096
+#endif
+
+static const char* const TAG = "bench_ota";
+
+/* chunk i of the made-up image */
+static void bench_ota_chunk(byte* buf, uint32_t i)
+{
+    buf[0] = (byte)(i >> 24);
+    buf[1] = (byte)(i >> 16);
+    buf[2] = (byte)(i >> 8);
+    buf[3] = (byte)i;
+}
+
+static double bench_ota_mbps(uint64_t bytes, int64_t us)
+{
+    return (us > 0) ? (double)bytes / (double)us : 0;
+}
+
+/* Streams the made-up image through a verifier; tamper flips one byte of
+ * the middle chunk. Returns the result of esp_wolfssl_ota_verify_final(). */
+static int bench_ota_stream(const byte* pub, word32 pub_sz,
+                            const byte* sig, word32 sig_sz, byte* buf,
+                            int tamper, int64_t* stream_us,
+                            int64_t* final_us)
+{
+    const uint32_t chunks = CONFIG_BENCH_OTA_IMAGE_KB * 1024 /
+                            CONFIG_BENCH_OTA_CHUNK;
+    esp_wolfssl_ota_verify_t* v;
+    int64_t t0;
+    uint32_t i;
+    int ret;
+
+    ret = esp_wolfssl_ota_verify_new(ESP_WOLFSSL_OTA_SIG_ECDSA, pub, pub_sz,
+                                     &v);
+    if (ret != 0) {
+        return ret;
+    }
+
+    t0 = esp_timer_get_time();
+    for (i = 0; ret == 0 && i < chunks; i++) {
+        bench_ota_chunk(buf, i);
+        if (tamper && i == chunks / 2) {
+            buf[4] ^= 1;
+        }
+        ret = esp_wolfssl_ota_verify_update(v, buf, CONFIG_BENCH_OTA_CHUNK);
+        if (tamper && i == chunks / 2) {
+            buf[4] ^= 1;
+        }
+    }
+    *stream_us = esp_timer_get_time() - t0;
+
+    if (ret == 0) {
+        t0 = esp_timer_get_time();
+        ret = esp_wolfssl_ota_verify_final(v, sig, sig_sz, NULL);
+        *final_us = esp_timer_get_time() - t0;
+    }
+
+    esp_wolfssl_ota_verify_free(v);
+    return ret;
+}
+
+#ifdef ESP_PLATFORM
+/* what the replaced flow spends after the download: read the image back
+ * from flash (here: the running app, for the same size) and hash it */
+static int bench_ota_readback(byte* buf, int64_t* us)
+{
+    const esp_partition_t* part = esp_ota_get_running_partition();
+    size_t size = CONFIG_BENCH_OTA_IMAGE_KB * 1024;
+    byte hash[WC_SHA256_DIGEST_SIZE];
+    wc_Sha256 sha;
+    int64_t t0;
+    size_t off;
+    int ret;
+
+    if (part == NULL) {
+        return BAD_STATE_E;
+    }
+    if (size > part->size) {
+        size = part->size;
+    }
+
+    ret = wc_InitSha256(&sha);
+    if (ret != 0) {
+        return ret;
+    }
+    t0 = esp_timer_get_time();
+    for (off = 0; ret == 0 && off + CONFIG_BENCH_OTA_CHUNK <= size;
+         off += CONFIG_BENCH_OTA_CHUNK) {
+        if (esp_partition_read(part, off, buf,
+                               CONFIG_BENCH_OTA_CHUNK) != ESP_OK) {
+            ret = BAD_STATE_E;
+        }
+        else {
+            ret = wc_Sha256Update(&sha, buf, CONFIG_BENCH_OTA_CHUNK);
+        }
+    }
+    if (ret == 0) {
+        ret = wc_Sha256Final(&sha, hash);
+    }
+    *us = esp_timer_get_time() - t0;
+    wc_Sha256Free(&sha);
+    return ret;
+}
+#endif
+
+int bench_ota_verify(void)
+{
+    const uint32_t chunks = CONFIG_BENCH_OTA_IMAGE_KB * 1024 /
+                            CONFIG_BENCH_OTA_CHUNK;
+    const uint64_t bytes = (uint64_t)chunks * CONFIG_BENCH_OTA_CHUNK;
+    byte hash[WC_SHA256_DIGEST_SIZE];
+    byte sig[ECC_MAX_SIG_SIZE];
+    byte pub[128];
+    word32 sig_sz = sizeof(sig);
+    int pub_sz = 0;
+    int64_t stream_us = 0;
+    int64_t final_us = 0;
+    wc_Sha256 sha;
+    ecc_key key;
+    WC_RNG rng;
+    byte* buf;
+    uint32_t i;
+    int ret;
+
+    buf = (byte*)XMALLOC(CONFIG_BENCH_OTA_CHUNK, NULL,
+                         DYNAMIC_TYPE_TMP_BUFFER);
+    if (buf == NULL) {
+        return MEMORY_E;
+    }
+    for (i = 0; i < CONFIG_BENCH_OTA_CHUNK; i++) {
+        buf[i] = (byte)(i * 7);
+    }
+
+    /* reference counted; the wolfCrypt benchmark cleans up after itself */
+    ret = wolfCrypt_Init();
+    if (ret != 0) {
+        XFREE(buf, NULL, DYNAMIC_TYPE_TMP_BUFFER);
+        return ret;
+    }
+
+    /* sign the image */
+    ret = wc_InitRng(&rng);
+    if (ret == 0) {
+        ret = wc_ecc_init(&key);
+        if (ret == 0) {
+            ret = wc_ecc_make_key(&rng, 32, &key);
+        }
+        if (ret == 0) {
+            ret = wc_InitSha256(&sha);
+            for (i = 0; ret == 0 && i < chunks; i++) {
+                bench_ota_chunk(buf, i);
+                ret = wc_Sha256Update(&sha, buf, CONFIG_BENCH_OTA_CHUNK);
+            }
+            if (ret == 0) {
+                ret = wc_Sha256Final(&sha, hash);
+            }
+            wc_Sha256Free(&sha);
+        }
+        if (ret == 0) {
+            ret = wc_ecc_sign_hash(hash, sizeof(hash), sig, &sig_sz, &rng,
+                                   &key);
+        }
+        if (ret == 0) {
+            pub_sz = wc_EccPublicKeyToDer(&key, pub, sizeof(pub), 1);
+            ret = (pub_sz > 0) ? 0 : pub_sz;
+        }
+        wc_ecc_free(&key);
+        wc_FreeRng(&rng);
+    }
+
+    if (ret == 0) {
+        ret = bench_ota_stream(pub, (word32)pub_sz, sig, sig_sz, buf, 0,
+                               &stream_us, &final_us);
+        if (ret != 0) {
+            ESP_LOGE(TAG, "verification failed: %d", ret);
+        }
+    }
+    if (ret == 0) {
+        int64_t us0;
+        int64_t us1;
+
+        ESP_LOGI(TAG, "%u KB image in %u byte chunks, ECDSA P-256",
+                 (unsigned)(bytes / 1024), (unsigned)CONFIG_BENCH_OTA_CHUNK);
+        ESP_LOGI(TAG, "streaming hash   %8lld us, %6.2f MB/s",
+                 (long long)stream_us, bench_ota_mbps(bytes, stream_us));
+        ESP_LOGI(TAG, "signature check  %8lld us", (long long)final_us);
+
+        if (bench_ota_stream(pub, (word32)pub_sz, sig, sig_sz, buf, 1,
+                             &us0, &us1) != SIG_VERIFY_E) {
+            ESP_LOGE(TAG, "tampered image was not rejected");
+            ret = SIG_VERIFY_E;
+        }
+    }
+#ifdef ESP_PLATFORM
+    if (ret == 0) {
+        int64_t us = 0;
+
+        if (bench_ota_readback(buf, &us) == 0) {
+            ESP_LOGI(TAG, "flash read back  %8lld us, %6.2f MB/s, saved "
+                          "before the reboot",
+                     (long long)us, bench_ota_mbps(bytes, us));
+        }
+    }
+#endif
+
+    wolfCrypt_Cleanup();
+    XFREE(buf, NULL, DYNAMIC_TYPE_TMP_BUFFER);
+    return ret;
+}
+
+#ifdef BENCH_OTA_HOST_MAIN
+static byte* bench_ota_load(const char* path, long* sz)
+{
+    FILE* f = fopen(path, "rb");
+    byte* data = NULL;
+
+    if (f == NULL) {
+        return NULL;
+    }
+    if (fseek(f, 0, SEEK_END) == 0 && (*sz = ftell(f)) > 0 &&
+        fseek(f, 0, SEEK_SET) == 0) {
+        data = (byte*)malloc((size_t)*sz);
+        if (data != NULL && fread(data, 1, (size_t)*sz, f) != (size_t)*sz) {
+            free(data);
+            data = NULL;
+        }
+    }
+    fclose(f);
+    return data;
+}
+
+static int bench_ota_file(const char* image, const char* sig_path,
+                          const char* pub_path, esp_wolfssl_ota_sig_t type)
+{
+    esp_wolfssl_ota_verify_t* v = NULL;
+    byte digest[WC_SHA256_DIGEST_SIZE];
+    byte buf[CONFIG_BENCH_OTA_CHUNK];
+    long sig_sz = 0;
+    long pub_sz = 0;
+    byte* sig = bench_ota_load(sig_path, &sig_sz);
+    byte* pub = bench_ota_load(pub_path, &pub_sz);
+    FILE* f = fopen(image, "rb");
+    int64_t t0;
+    size_t n;
+    int ret = BAD_FUNC_ARG;
+    int i;
+
+    if (f != NULL && sig != NULL && pub != NULL) {
+        ret = esp_wolfssl_ota_verify_new(type, pub, (size_t)pub_sz, &v);
+    }
+    t0 = esp_timer_get_time();
+    while (ret == 0 && (n = fread(buf, 1, sizeof(buf), f)) > 0) {
+        ret = esp_wolfssl_ota_verify_update(v, buf, n);
+    }
+    if (ret == 0) {
+        ret = esp_wolfssl_ota_verify_final(v, sig, (size_t)sig_sz, digest);
+        t0 = esp_timer_get_time() - t0;
+        printf("sha256 ");
+        for (i = 0; i < (int)sizeof(digest); i++) {
+            printf("%02x", digest[i]);
+        }
+        printf("\n%llu bytes in %lld us, %.2f MB/s\n",
+               (unsigned long long)esp_wolfssl_ota_verify_size(v),
+               (long long)t0,
+               bench_ota_mbps(esp_wolfssl_ota_verify_size(v), t0));
+    }
+    printf("%s (%d)\n", (ret == 0) ? "signature OK" : "REJECTED", ret);
+
+    esp_wolfssl_ota_verify_free(v);
+    if (f != NULL) {
+        fclose(f);
+    }
+    free(sig);
+    free(pub);
+    return ret;
+}
+
+int main(int argc, char** argv)
+{
+    int ret;
+
+    if (argc == 1) {
+        ret = bench_ota_verify();
+    }
+    else if (argc == 4 || argc == 5) {
+        ret = wolfCrypt_Init();
+        if (ret == 0) {
+            ret = bench_ota_file(argv[1], argv[2], argv[3],
+                                 (argc == 5 && strcmp(argv[4], "lms") == 0)
+                                     ? ESP_WOLFSSL_OTA_SIG_LMS
+                                     : ESP_WOLFSSL_OTA_SIG_ECDSA);
+            wolfCrypt_Cleanup();
+        }
+    }
+    else {
+        fprintf(stderr, "usage: %s [image sig pub [ecdsa|lms]]\n", argv[0]);
+        ret = BAD_FUNC_ARG;
+    }
+
+    return (ret == 0) ? 0 : 1;
+}
+#endif
+
+#endif /* (CONFIG_BENCH_OTA || BENCH_OTA_HOST_MAIN) && ... */
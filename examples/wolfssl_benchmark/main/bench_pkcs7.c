@@ -0,0 +1,399 @@
+/* bench_pkcs7.c
+ *
+ * Copyright (C) 2006-2024 wolfSSL Inc.
+ *
+ * This file is part of wolfSSL.
+ *
+ * wolfSSL is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfSSL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335, USA
+ */
+
+/* Streaming PKCS#7 decoding (port/esp_wolfssl_pkcs7_stream.h): a
+ * SignedData bundle of CONFIG_BENCH_PKCS7_KB content is signed with the
+ * test server key of ocsp_test_data.h, its content never in RAM as a
+ * whole, and streamed through the decoder in CONFIG_BENCH_PKCS7_CHUNK byte
+ * chunks. Reports throughput and the peak heap the decoder held, which
+ * does not grow with the bundle.
+ *
+ * The same source is a host harness that streams bundle files, against an
+ * installed wolfSSL built with PKCS#7:
+ *
+ *   gcc -O2 -DBENCH_PKCS7_HOST_MAIN -DWOLFSSL_ESP_PKCS7_STREAM \
+ *       -Imain/include -I../../port main/bench_pkcs7.c \
+ *       ../../port/esp_wolfssl_pkcs7_stream.c ../../port/esp_wolfssl_der.c \
+ *       -lwolfssl -o pkcs7_stream
+ *   ./pkcs7_stream                                    (the benchmark)
+ *   ./pkcs7_stream verify fw.p7s ca.der [out] [cap=bytes]
+ *   ./pkcs7_stream decrypt fw.p7e dev.der dev.key [out] [cap=bytes]
+ *
+ * with bundles from, e.g.
+ *
+ *   openssl cms -sign -binary -nodetach -outform DER -md sha256 \
+ *       -in fw.bin -signer signer.pem -inkey signer.key -out fw.p7s
+ *   openssl cms -encrypt -binary -outform DER -aes-256-cbc \
+ *       -in fw.bin -out fw.p7e dev.pem
+ *
+ * The exit status is 0 when the bundle decoded and verified and the
+ * decoder's peak heap stayed within cap, if given. */
+
+#include "bench_common.h"
+
+#include "main.h"
+
+#if (defined(CONFIG_BENCH_PKCS7) || defined(BENCH_PKCS7_HOST_MAIN)) && \
+    defined(WOLFSSL_ESP_PKCS7_STREAM)
+
+#include <string.h>
+#include <sys/time.h>
+#include <time.h>
+
+#include <wolfssl/ssl.h>
+#include <wolfssl/wolfcrypt/types.h>
+#include <wolfssl/wolfcrypt/error-crypt.h>
+
+#ifdef BENCH_PKCS7_HOST_MAIN
+    #include <stdlib.h>
+#endif
+
+#include "esp_wolfssl_pkcs7_stream.h"
+
+#ifndef CONFIG_BENCH_PKCS7_KB
+    #define CONFIG_BENCH_PKCS7_KB    4096
+#endif
+#ifndef CONFIG_BENCH_PKCS7_CHUNK
+    #define CONFIG_BENCH_PKCS7_CHUNK 4096
+#endif
+
+static const char* const TAG = "bench_pkcs7";
+
+static double bench_pkcs7_mbps(uint64_t bytes, int64_t us)
+{
+    return (us > 0) ? (double)bytes / (double)us : 0;
+}
+
+#if defined(HAVE_PKCS7) && defined(HAVE_ECC) && !defined(NO_SHA256)
+
+#include <wolfssl/wolfcrypt/random.h>
+#include <wolfssl/wolfcrypt/hash.h>
+#include <wolfssl/wolfcrypt/pkcs7.h>
+
+#include "ocsp_test_data.h"
+
+/* after the notBefore of ocsp_server_cert_der: 2026-10-20 */
+#define BENCH_PKCS7_MIN_TIME 1792540800
+
+/* chunk i of the made-up content */
+static void bench_pkcs7_chunk(byte* buf, uint32_t i)
+{
+    buf[0] = (byte)(i >> 24);
+    buf[1] = (byte)(i >> 16);
+    buf[2] = (byte)(i >> 8);
+    buf[3] = (byte)i;
+}
+
+static int bench_pkcs7_null_out(void* arg, const unsigned char* data,
+                                size_t len)
+{
+    (void)data;
+    *(uint64_t*)arg += len;
+    return 0;
+}
+
+/* head and foot of a SignedData over chunks chunks of buf, with the
+ * content left out as for wc_PKCS7_VerifySignedData_ex() */
+static int bench_pkcs7_sign(byte* buf, uint32_t chunks, byte* head,
+                            word32* head_sz, byte* foot, word32* foot_sz)
+{
+    byte hash[WC_SHA256_DIGEST_SIZE];
+    wc_Sha256 sha;
+    PKCS7* pkcs7;
+    WC_RNG rng;
+    uint32_t i;
+    int ret;
+
+    ret = wc_InitSha256(&sha);
+    for (i = 0; ret == 0 && i < chunks; i++) {
+        bench_pkcs7_chunk(buf, i);
+        ret = wc_Sha256Update(&sha, buf, CONFIG_BENCH_PKCS7_CHUNK);
+    }
+    if (ret == 0) {
+        ret = wc_Sha256Final(&sha, hash);
+    }
+    wc_Sha256Free(&sha);
+    if (ret != 0) {
+        return ret;
+    }
+
+    ret = wc_InitRng(&rng);
+    if (ret != 0) {
+        return ret;
+    }
+    pkcs7 = wc_PKCS7_New(NULL, INVALID_DEVID);
+    if (pkcs7 == NULL) {
+        ret = MEMORY_E;
+    }
+    else {
+        ret = wc_PKCS7_InitWithCert(pkcs7, (byte*)ocsp_server_cert_der,
+                                    sizeof_ocsp_server_cert_der);
+    }
+    if (ret == 0) {
+        /* not read: the hash is given */
+        pkcs7->content = buf;
+        pkcs7->contentSz = chunks * CONFIG_BENCH_PKCS7_CHUNK;
+        pkcs7->privateKey = (byte*)ocsp_server_key_der;
+        pkcs7->privateKeySz = sizeof_ocsp_server_key_der;
+        pkcs7->encryptOID = ECDSAk;
+        pkcs7->hashOID = SHA256h;
+        pkcs7->rng = &rng;
+        ret = wc_PKCS7_EncodeSignedData_ex(pkcs7, hash, sizeof(hash),
+                                           head, head_sz, foot, foot_sz);
+    }
+    wc_PKCS7_Free(pkcs7);
+    wc_FreeRng(&rng);
+    return ret;
+}
+
+int bench_pkcs7_stream(void)
+{
+    const uint32_t chunks = CONFIG_BENCH_PKCS7_KB * 1024 /
+                            CONFIG_BENCH_PKCS7_CHUNK;
+    esp_wolfssl_pkcs7_stream_stats_t stats;
+    esp_wolfssl_pkcs7_stream_t* s = NULL;
+    uint64_t content = 0;
+    word32 head_sz = 512;
+    word32 foot_sz = 2048;
+    struct timeval tv;
+    byte* head;
+    byte* foot;
+    byte* buf;
+    int64_t t0;
+    int64_t us = 0;
+    uint32_t i;
+    int ret;
+
+    /* the signer's certificate dates are checked against the clock */
+    if (time(NULL) < BENCH_PKCS7_MIN_TIME) {
+        tv.tv_sec = BENCH_PKCS7_MIN_TIME;
+        tv.tv_usec = 0;
+        settimeofday(&tv, NULL);
+        ESP_LOGW(TAG, "clock not set, set to 2026-10-20 for the test "
+                      "certificates");
+    }
+
+    head = (byte*)XMALLOC(head_sz + foot_sz + CONFIG_BENCH_PKCS7_CHUNK, NULL,
+                          DYNAMIC_TYPE_TMP_BUFFER);
+    if (head == NULL) {
+        return MEMORY_E;
+    }
+    foot = head + head_sz;
+    buf = foot + foot_sz;
+    for (i = 0; i < CONFIG_BENCH_PKCS7_CHUNK; i++) {
+        buf[i] = (byte)(i * 7);
+    }
+
+    /* reference counted; the wolfCrypt benchmark cleans up after itself */
+    ret = wolfSSL_Init();
+    if (ret != WOLFSSL_SUCCESS) {
+        XFREE(head, NULL, DYNAMIC_TYPE_TMP_BUFFER);
+        return ret;
+    }
+
+    ret = bench_pkcs7_sign(buf, chunks, head, &head_sz, foot, &foot_sz);
+    if (ret == 0) {
+        ret = esp_wolfssl_pkcs7_stream_verify_new(ocsp_ca_der,
+                                                  sizeof_ocsp_ca_der,
+                                                  bench_pkcs7_null_out,
+                                                  &content, &s);
+    }
+    if (ret == 0) {
+        t0 = esp_timer_get_time();
+        ret = esp_wolfssl_pkcs7_stream_update(s, head, head_sz);
+        for (i = 0; ret == 0 && i < chunks; i++) {
+            bench_pkcs7_chunk(buf, i);
+            ret = esp_wolfssl_pkcs7_stream_update(s, buf,
+                                                  CONFIG_BENCH_PKCS7_CHUNK);
+        }
+        if (ret == 0) {
+            ret = esp_wolfssl_pkcs7_stream_update(s, foot, foot_sz);
+        }
+        if (ret == 0) {
+            ret = esp_wolfssl_pkcs7_stream_final(s);
+        }
+        us = esp_timer_get_time() - t0;
+    }
+
+    if (ret != 0) {
+        ESP_LOGE(TAG, "signed bundle failed: %d", ret);
+    }
+    else {
+        esp_wolfssl_pkcs7_stream_get_stats(s, &stats);
+        ESP_LOGI(TAG, "SignedData, ECDSA P-256 / SHA-256, %u KB content in "
+                      "%u byte chunks",
+                 (unsigned)(content / 1024),
+                 (unsigned)CONFIG_BENCH_PKCS7_CHUNK);
+        ESP_LOGI(TAG, "decode + verify %8lld us, %6.2f MB/s, decoder peak "
+                      "heap %u bytes for a %llu byte bundle",
+                 (long long)us, bench_pkcs7_mbps(stats.in, us),
+                 (unsigned)stats.mem_peak, (unsigned long long)stats.in);
+    }
+
+    esp_wolfssl_pkcs7_stream_free(s);
+    wolfSSL_Cleanup();
+    XFREE(head, NULL, DYNAMIC_TYPE_TMP_BUFFER);
+    return ret;
+}
+
+#else
+
+int bench_pkcs7_stream(void)
+{
+    ESP_LOGW(TAG, "needs PKCS#7, ECC and SHA-256");
+    return NOT_COMPILED_IN;
+}
+
+#endif /* HAVE_PKCS7 && HAVE_ECC && !NO_SHA256 */
+
+#ifdef BENCH_PKCS7_HOST_MAIN
+static byte* bench_pkcs7_load(const char* path, long* sz)
+{
+    FILE* f = fopen(path, "rb");
+    byte* data = NULL;
+
+    if (f == NULL) {
+        return NULL;
+    }
+    if (fseek(f, 0, SEEK_END) == 0 && (*sz = ftell(f)) > 0 &&
+        fseek(f, 0, SEEK_SET) == 0) {
+        data = (byte*)malloc((size_t)*sz);
+        if (data != NULL && fread(data, 1, (size_t)*sz, f) != (size_t)*sz) {
+            free(data);
+            data = NULL;
+        }
+    }
+    fclose(f);
+    return data;
+}
+
+static int bench_pkcs7_write(void* arg, const unsigned char* data,
+                             size_t len)
+{
+    if (arg != NULL && fwrite(data, 1, len, (FILE*)arg) != len) {
+        return BUFFER_E;
+    }
+    return 0;
+}
+
+int main(int argc, char** argv)
+{
+    esp_wolfssl_pkcs7_stream_stats_t stats;
+    esp_wolfssl_pkcs7_stream_t* s = NULL;
+    byte buf[CONFIG_BENCH_PKCS7_CHUNK];
+    const char* out_path = NULL;
+    size_t cap = 0;
+    long cert_sz = 0;
+    long key_sz = 0;
+    byte* cert = NULL;
+    byte* key = NULL;
+    FILE* in = NULL;
+    FILE* out = NULL;
+    int decrypt;
+    int args;
+    int64_t t0;
+    size_t n;
+    int ret;
+    int i;
+
+    if (argc == 1) {
+        return (bench_pkcs7_stream() == 0) ? 0 : 1;
+    }
+
+    decrypt = (strcmp(argv[1], "decrypt") == 0);
+    args = decrypt ? 5 : 4;
+    if ((!decrypt && strcmp(argv[1], "verify") != 0) || argc < args) {
+        fprintf(stderr, "usage: %s verify bundle ca.der [out] [cap=bytes]\n"
+                        "       %s decrypt bundle cert.der key.der [out] "
+                        "[cap=bytes]\n", argv[0], argv[0]);
+        return 2;
+    }
+    for (i = args; i < argc; i++) {
+        if (strncmp(argv[i], "cap=", 4) == 0) {
+            cap = (size_t)strtoul(argv[i] + 4, NULL, 10);
+        }
+        else {
+            out_path = argv[i];
+        }
+    }
+
+    in = fopen(argv[2], "rb");
+    cert = bench_pkcs7_load(argv[3], &cert_sz);
+    if (decrypt) {
+        key = bench_pkcs7_load(argv[4], &key_sz);
+    }
+    if (out_path != NULL) {
+        out = fopen(out_path, "wb");
+    }
+    if (in == NULL || cert == NULL || (decrypt && key == NULL) ||
+        (out_path != NULL && out == NULL)) {
+        fprintf(stderr, "cannot open the input or output files\n");
+        ret = BAD_FUNC_ARG;
+    }
+    else if ((ret = wolfSSL_Init()) == WOLFSSL_SUCCESS) {
+        if (decrypt) {
+            ret = esp_wolfssl_pkcs7_stream_decrypt_new(cert, (size_t)cert_sz,
+                                                       key, (size_t)key_sz,
+                                                       bench_pkcs7_write,
+                                                       out, &s);
+        }
+        else {
+            ret = esp_wolfssl_pkcs7_stream_verify_new(cert, (size_t)cert_sz,
+                                                      bench_pkcs7_write,
+                                                      out, &s);
+        }
+        t0 = esp_timer_get_time();
+        while (ret == 0 && (n = fread(buf, 1, sizeof(buf), in)) > 0) {
+            ret = esp_wolfssl_pkcs7_stream_update(s, buf, n);
+        }
+        if (ret == 0) {
+            ret = esp_wolfssl_pkcs7_stream_final(s);
+        }
+        t0 = esp_timer_get_time() - t0;
+
+        esp_wolfssl_pkcs7_stream_get_stats(s, &stats);
+        printf("%llu bytes in, %llu bytes content, %lld us, %.2f MB/s, "
+               "decoder peak heap %u bytes\n",
+               (unsigned long long)stats.in,
+               (unsigned long long)stats.content, (long long)t0,
+               bench_pkcs7_mbps(stats.in, t0), (unsigned)stats.mem_peak);
+        if (ret == 0 && cap > 0 && stats.mem_peak > cap) {
+            printf("peak heap over the cap of %u bytes\n", (unsigned)cap);
+            ret = BUFFER_E;
+        }
+        esp_wolfssl_pkcs7_stream_free(s);
+        wolfSSL_Cleanup();
+    }
+    printf("%s (%d)\n", (ret == 0) ? "OK" : "FAILED", ret);
+
+    if (in != NULL) {
+        fclose(in);
+    }
+    if (out != NULL) {
+        fclose(out);
+    }
+    free(cert);
+    free(key);
+    return (ret == 0) ? 0 : 1;
+}
+#endif /* BENCH_PKCS7_HOST_MAIN */
+
+#endif /* (CONFIG_BENCH_PKCS7 || BENCH_PKCS7_HOST_MAIN) && ... */
@@ -0,0 +1,147 @@
+/* bench_pq.c
+ *
+ * Copyright (C) 2006-2024 wolfSSL Inc.
+ *
+ * This file is part of wolfSSL.
+ *
+ * wolfSSL is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfSSL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335, USA
+ */
+
+/* TLS 1.3 handshakes with a classical key share (X25519, or P-256 without
+ * Curve25519) against the hybrid ML-KEM-768 group of esp_wolfssl_pq.h, over
+ * the in-memory loopback. Reports handshake latency, ClientHello size, and
+ * peak heap and stack. Client and server run in the same task, so the peaks
+ * are those of both ends together. */
+
+/* ESP-IDF */
+#include "sdkconfig.h"
+#include <esp_log.h>
+
+/* wolfSSL */
+#include <wolfssl/wolfcrypt/settings.h>
+#include <wolfssl/ssl.h>
+#include <wolfssl/wolfcrypt/error-crypt.h>
+
+#include "main.h"
+
+#if defined(CONFIG_BENCH_PQ) && defined(WOLFSSL_ESP_PQ) && \
+    !defined(NO_WOLFSSL_CLIENT) && !defined(NO_WOLFSSL_SERVER)
+
+#include <string.h>
+
+#include "tls_loopback.h"
+#include "esp_wolfssl_pq.h"
+
+static const char* const TAG = "bench_pq";
+
+#define BENCH_PQ_TASK_STACK_SIZE (16 * 1024)
+
+#ifdef HAVE_CURVE25519
+    #define BENCH_PQ_CLASSIC ESP_WOLFSSL_GROUP_X25519
+#else
+    #define BENCH_PQ_CLASSIC ESP_WOLFSSL_GROUP_SECP256R1
+#endif
+
+static int bench_pq_setup_classic(WOLFSSL* ssl, int server)
+{
+    int group = BENCH_PQ_CLASSIC;
+    int ret = wolfSSL_set_groups(ssl, &group, 1);
+
+    if (ret == WOLFSSL_SUCCESS && !server) {
+        ret = wolfSSL_UseKeyShare(ssl, (word16)group);
+    }
+    return (ret == WOLFSSL_SUCCESS) ? 0 : ret;
+}
+
+static int bench_pq_setup_hybrid(WOLFSSL* ssl, int server)
+{
+    int ret = server ? esp_wolfssl_pq_set_groups(ssl)
+                     : esp_wolfssl_pq_use_hybrid(ssl);
+
+    return (ret == WOLFSSL_SUCCESS) ? 0 : ret;
+}
+
+static int bench_pq_run(tls_loopback_bench* b, int hybrid)
+{
+    tls_loopback_cfg cfg;
+
+    memset(&cfg, 0, sizeof(cfg));
+    cfg.version = TLS_LOOPBACK_VERSION_13;
+    cfg.setup = hybrid ? bench_pq_setup_hybrid : bench_pq_setup_classic;
+
+    memset(b, 0, sizeof(*b));
+    b->cfg = &cfg;
+    b->count = CONFIG_BENCH_PQ_COUNT;
+    b->stack_size = BENCH_PQ_TASK_STACK_SIZE;
+    return tls_loopback_bench_run(b);
+}
+
+static void bench_pq_log(const char* name, const tls_loopback_bench* b)
+{
+    ESP_LOGI(TAG, "%-22s %8lld us avg, %8lld min, %8lld max, "
+                  "ClientHello %5u bytes, %u flights",
+             name, (long long)tls_loopback_timing_avg(&b->timing),
+             (long long)b->timing.min_us, (long long)b->timing.max_us,
+             (unsigned)b->last.client_hello, (unsigned)b->last.flights);
+    ESP_LOGI(TAG, "%-22s peak heap %u bytes, peak stack %u bytes", name,
+             (unsigned)b->measure.heap_peak,
+             (unsigned)b->measure.stack_peak);
+}
+
+int bench_pq_compare(void)
+{
+    tls_loopback_bench classic;
+    tls_loopback_bench hybrid;
+    int group;
+    int ret;
+
+    /* reference counted; the wolfCrypt benchmark cleans up after itself */
+    ret = wolfSSL_Init();
+    if (ret != WOLFSSL_SUCCESS) {
+        return ret;
+    }
+
+    group = esp_wolfssl_pq_hybrid_group();
+    if (group < 0) {
+        ESP_LOGE(TAG, "no hybrid group supported by this wolfSSL: %d",
+                 group);
+        wolfSSL_Cleanup();
+        return group;
+    }
+
+    ret = bench_pq_run(&classic, 0);
+    if (ret != 0) {
+        ESP_LOGE(TAG, "%s handshake failed: %d",
+                 esp_wolfssl_pq_group_name(BENCH_PQ_CLASSIC), ret);
+    }
+    if (ret == 0) {
+        ret = bench_pq_run(&hybrid, 1);
+        if (ret != 0) {
+            ESP_LOGE(TAG, "%s handshake failed: %d",
+                     esp_wolfssl_pq_group_name(group), ret);
+        }
+    }
+    if (ret == 0) {
+        ESP_LOGI(TAG, "TLS 1.3, %d handshakes each, client and server",
+                 CONFIG_BENCH_PQ_COUNT);
+        bench_pq_log(esp_wolfssl_pq_group_name(BENCH_PQ_CLASSIC), &classic);
+        bench_pq_log(esp_wolfssl_pq_group_name(group), &hybrid);
+    }
+
+    wolfSSL_Cleanup();
+    return ret;
+}
+
+#endif /* CONFIG_BENCH_PQ && WOLFSSL_ESP_PQ && ... */
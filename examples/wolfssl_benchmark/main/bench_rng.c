@@ -0,0 +1,190 @@
+/* bench_rng.c
+ *
+ * Copyright (C) 2006-2024 wolfSSL Inc.
+ *
+ * This file is part of wolfSSL.
+ *
+ * wolfSSL is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfSSL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335, USA
+ */
+
+/* Random number throughput of the buffered pool of esp_wolfssl_rng.h and
+ * of direct Hash_DRBG requests, for request sizes typical of a handshake,
+ * and the random requests and time of TLS handshakes with both.
+ *
+ * On the device, enable Example Configuration -> Benchmark the buffered
+ * random number pool. On a Linux host, against an installed wolfSSL:
+ *
+ *   gcc -O2 -DBENCH_RNG_HOST_MAIN -DWOLFSSL_ESP_RNG_POOL \
+ *       -include wolfssl/options.h -Imain/include -I../../port \
+ *       main/bench_rng.c main/tls_loopback.c ../../port/esp_wolfssl_rng.c \
+ *       -Wl,--wrap=wc_RNG_GenerateBlock -lwolfssl -o rng
+ *   ./rng
+ */
+
+#include "bench_common.h"
+
+#if (defined(CONFIG_BENCH_RNG) || defined(BENCH_RNG_HOST_MAIN)) && \
+    defined(WOLFSSL_ESP_RNG_POOL)
+
+#include <string.h>
+
+#include <wolfssl/wolfcrypt/types.h>
+#include <wolfssl/wolfcrypt/error-crypt.h>
+#include <wolfssl/wolfcrypt/random.h>
+#include <wolfssl/wolfcrypt/wc_port.h>
+
+#include "esp_wolfssl_rng.h"
+#include "main.h"
+
+#if !defined(WOLFCRYPT_ONLY) && \
+    !defined(NO_WOLFSSL_CLIENT) && !defined(NO_WOLFSSL_SERVER)
+    #define BENCH_RNG_HANDSHAKES
+    #include "tls_loopback.h"
+#endif
+
+#ifndef CONFIG_BENCH_RNG_KB
+    #define CONFIG_BENCH_RNG_KB    256
+#endif
+#ifndef CONFIG_BENCH_RNG_COUNT
+    #define CONFIG_BENCH_RNG_COUNT 10
+#endif
+
+static const char* const TAG = "bench_rng";
+
+static const word32 bench_rng_sizes[] = { 16, 32, 64, 1024 };
+
+/* through the pool, or straight to rng while it is disabled */
+static int bench_rng_rate(const char* name, WC_RNG* rng)
+{
+    byte buf[1024];
+    word32 total = (word32)CONFIG_BENCH_RNG_KB * 1024;
+    word32 done;
+    int64_t start;
+    int64_t us;
+    size_t i;
+    int ret = 0;
+
+    for (i = 0; ret == 0
+                && i < sizeof(bench_rng_sizes) / sizeof(bench_rng_sizes[0]);
+         i++) {
+        word32 sz = bench_rng_sizes[i];
+
+        start = esp_timer_get_time();
+        for (done = 0; ret == 0 && done < total; done += sz) {
+            ret = esp_wolfssl_rng_generate_block(rng, buf, sz);
+        }
+        us = esp_timer_get_time() - start;
+        if (ret == 0 && us > 0) {
+            ESP_LOGI(TAG, "%-10s %5u byte requests: %8.1f KB/s, %9.0f "
+                          "requests/s",
+                     name, (unsigned)sz, (double)total * 1e6 / 1024.0 / us,
+                     (double)(total / sz) * 1e6 / us);
+        }
+    }
+    return ret;
+}
+
+#ifdef BENCH_RNG_HANDSHAKES
+static int bench_rng_handshakes(const char* name)
+{
+    esp_wolfssl_rng_stats_t stats;
+    tls_loopback lb;
+    int64_t total_us = 0;
+    int ret;
+    int i;
+
+    ret = tls_loopback_init(&lb, NULL);
+    if (ret != 0) {
+        return ret;
+    }
+    esp_wolfssl_rng_reset_stats();
+    for (i = 0; ret == 0 && i < CONFIG_BENCH_RNG_COUNT; i++) {
+        ret = tls_loopback_connect(&lb);
+        if (ret == 0) {
+            total_us += lb.stats.handshake_us;
+        }
+        tls_loopback_close(&lb);
+    }
+    esp_wolfssl_rng_get_stats(&stats);
+    tls_loopback_free(&lb);
+
+    if (ret == 0) {
+        ESP_LOGI(TAG, "%-10s handshake %8lld us avg, %u random requests, "
+                      "%u bytes, %u refills by the caller, %u by the task",
+                 name, (long long)(total_us / CONFIG_BENCH_RNG_COUNT),
+                 (unsigned)(stats.requests / CONFIG_BENCH_RNG_COUNT),
+                 (unsigned)(stats.bytes / CONFIG_BENCH_RNG_COUNT),
+                 (unsigned)stats.refills, (unsigned)stats.bg_refills);
+    }
+    return ret;
+}
+#endif
+
+int bench_rng(void)
+{
+    WC_RNG rng;
+    int ret;
+
+#ifdef BENCH_RNG_HANDSHAKES
+    /* reference counted; the wolfCrypt benchmark cleans up after itself */
+    ret = (wolfSSL_Init() == WOLFSSL_SUCCESS) ? 0 : WC_INIT_E;
+#else
+    ret = wolfCrypt_Init();
+#endif
+    if (ret != 0) {
+        return ret;
+    }
+
+    ESP_LOGI(TAG, "%u KB per request size, pool of %u bytes",
+             (unsigned)CONFIG_BENCH_RNG_KB, (unsigned)ESP_WOLFSSL_RNG_POOL_SZ);
+    ret = wc_InitRng(&rng);
+    if (ret == 0) {
+        esp_wolfssl_rng_set_enabled(0);
+        ret = bench_rng_rate("Hash_DRBG", &rng);
+        esp_wolfssl_rng_set_enabled(1);
+        if (ret == 0) {
+            ret = bench_rng_rate("pool", &rng);
+        }
+        wc_FreeRng(&rng);
+    }
+
+#ifdef BENCH_RNG_HANDSHAKES
+    if (ret == 0) {
+        esp_wolfssl_rng_set_enabled(0);
+        ret = bench_rng_handshakes("Hash_DRBG");
+        esp_wolfssl_rng_set_enabled(1);
+    }
+    if (ret == 0) {
+        ret = bench_rng_handshakes("pool");
+    }
+    wolfSSL_Cleanup();
+#else
+    wolfCrypt_Cleanup();
+#endif
+
+    if (ret != 0) {
+        ESP_LOGE(TAG, "failed: %d", ret);
+    }
+    return ret;
+}
+
+#ifdef BENCH_RNG_HOST_MAIN
+int main(void)
+{
+    return (bench_rng() == 0) ? 0 : 1;
+}
+#endif
+
+#endif /* (CONFIG_BENCH_RNG || BENCH_RNG_HOST_MAIN) && WOLFSSL_ESP_RNG_POOL */
@@ -0,0 +1,170 @@
+/* bench_rpk.c
+ *
+ * Copyright (C) 2006-2024 wolfSSL Inc.
+ *
+ * This file is part of wolfSSL.
+ *
+ * wolfSSL is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfSSL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335, USA
+ */
+
+/* TLS 1.3 handshakes with a one-level X.509 chain, a P-256 server
+ * certificate signed by the CA the client trusts, against the same server
+ * key sent as an RFC 7250 raw public key that the client has pinned, over
+ * the in-memory loopback. Reports handshake latency, bytes from the server,
+ * and peak heap and stack of client and server together. */
+
+/* ESP-IDF */
+#include "sdkconfig.h"
+#include <esp_log.h>
+
+/* wolfSSL */
+#include <wolfssl/wolfcrypt/settings.h>
+#include <wolfssl/ssl.h>
+#include <wolfssl/wolfcrypt/error-crypt.h>
+
+#include "main.h"
+
+#if defined(CONFIG_BENCH_RPK) && defined(WOLFSSL_ESP_RPK) && \
+    defined(HAVE_ECC) && \
+    !defined(NO_WOLFSSL_CLIENT) && !defined(NO_WOLFSSL_SERVER)
+
+#include <string.h>
+
+#include "tls_loopback.h"
+#include "ocsp_test_data.h"
+#include "esp_wolfssl_rpk.h"
+
+static const char* const TAG = "bench_rpk";
+
+#define BENCH_RPK_TASK_STACK_SIZE (16 * 1024)
+
+static int bench_rpk_ctx_setup(WOLFSSL_CTX* ctx, int server)
+{
+    int ret;
+
+    if (server) {
+        ret = esp_wolfssl_rpk_ctx_use(ctx, 1, ocsp_server_cert_der,
+                                      sizeof_ocsp_server_cert_der);
+    }
+    else {
+        ret = esp_wolfssl_rpk_ctx_use(ctx, 0, NULL, 0);
+        if (ret == WOLFSSL_SUCCESS) {
+            wolfSSL_CTX_set_verify(ctx, WOLFSSL_VERIFY_PEER,
+                                   esp_wolfssl_rpk_verify_cb);
+        }
+    }
+    return (ret == WOLFSSL_SUCCESS) ? 0 : ret;
+}
+
+/* a server that fell back to X.509 would skew the numbers */
+static int bench_rpk_check(tls_loopback* lb, void* arg)
+{
+    (void)arg;
+    return (esp_wolfssl_rpk_peer_type(lb->client)
+            == ESP_WOLFSSL_CERT_TYPE_RPK) ? 0 : NOT_COMPILED_IN;
+}
+
+static int bench_rpk_run(tls_loopback_bench* b, int rpk)
+{
+    tls_loopback_cfg cfg;
+    const unsigned char* spki = NULL;
+    size_t spki_sz = 0;
+    int ret;
+
+    memset(&cfg, 0, sizeof(cfg));
+    cfg.version = TLS_LOOPBACK_VERSION_13;
+    cfg.ca = ocsp_ca_der;
+    cfg.ca_sz = sizeof_ocsp_ca_der;
+    cfg.server_cert = ocsp_server_cert_der;
+    cfg.server_cert_sz = sizeof_ocsp_server_cert_der;
+    cfg.server_key = ocsp_server_key_der;
+    cfg.server_key_sz = sizeof_ocsp_server_key_der;
+    if (rpk) {
+        ret = esp_wolfssl_rpk_spki(ocsp_server_cert_der,
+                                   sizeof_ocsp_server_cert_der, &spki,
+                                   &spki_sz);
+        if (ret != 0) {
+            return ret;
+        }
+        cfg.server_cert = spki;
+        cfg.server_cert_sz = (int)spki_sz;
+        cfg.ctx_setup = bench_rpk_ctx_setup;
+    }
+
+    memset(b, 0, sizeof(*b));
+    b->cfg = &cfg;
+    b->count = CONFIG_BENCH_RPK_COUNT;
+    b->stack_size = BENCH_RPK_TASK_STACK_SIZE;
+    b->check = rpk ? bench_rpk_check : NULL;
+    return tls_loopback_bench_run(b);
+}
+
+static void bench_rpk_log(const char* name, const tls_loopback_bench* b)
+{
+    ESP_LOGI(TAG, "%-16s %8lld us avg, %8lld min, %8lld max, "
+                  "%5u bytes to client",
+             name, (long long)tls_loopback_timing_avg(&b->timing),
+             (long long)b->timing.min_us, (long long)b->timing.max_us,
+             (unsigned)b->last.server_bytes);
+    ESP_LOGI(TAG, "%-16s peak heap %u bytes, peak stack %u bytes", name,
+             (unsigned)b->measure.heap_peak,
+             (unsigned)b->measure.stack_peak);
+}
+
+int bench_rpk_compare(void)
+{
+    tls_loopback_bench x509;
+    tls_loopback_bench rpk;
+    int ret;
+
+    /* reference counted; the wolfCrypt benchmark cleans up after itself */
+    ret = wolfSSL_Init();
+    if (ret != WOLFSSL_SUCCESS) {
+        return ret;
+    }
+
+    ret = bench_rpk_run(&x509, 0);
+    if (ret != 0) {
+        ESP_LOGE(TAG, "X.509 handshake failed: %d", ret);
+    }
+    if (ret == 0) {
+        ret = esp_wolfssl_rpk_pin_add(ocsp_server_cert_der,
+                                      sizeof_ocsp_server_cert_der);
+    }
+    if (ret == 0) {
+        ret = bench_rpk_run(&rpk, 1);
+        esp_wolfssl_rpk_pin_clear();
+        if (ret != 0) {
+            ESP_LOGE(TAG, "raw public key handshake failed: %d", ret);
+        }
+    }
+    if (ret == 0) {
+        ESP_LOGI(TAG, "TLS 1.3, P-256, %d handshakes each, client and server",
+                 CONFIG_BENCH_RPK_COUNT);
+        bench_rpk_log("X.509, 1 level", &x509);
+        bench_rpk_log("raw public key", &rpk);
+        ESP_LOGI(TAG, "raw public key saves %lld us, %d bytes, %d bytes "
+                      "peak heap per handshake",
+                 (long long)(tls_loopback_timing_avg(&x509.timing)
+                             - tls_loopback_timing_avg(&rpk.timing)),
+                 (int)x509.last.server_bytes - (int)rpk.last.server_bytes,
+                 (int)x509.measure.heap_peak - (int)rpk.measure.heap_peak);
+    }
+
+    wolfSSL_Cleanup();
+    return ret;
+}
+
+#endif /* CONFIG_BENCH_RPK && WOLFSSL_ESP_RPK && ... */
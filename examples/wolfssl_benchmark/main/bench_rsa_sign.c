@@ -0,0 +1,181 @@
+/* bench_rsa_sign.c
+ *
+ * Copyright (C) 2006-2024 wolfSSL Inc.
+ *
+ * This file is part of wolfSSL.
+ *
+ * wolfSSL is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfSSL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335, USA
+ */
+
+/* RSA-2048 sign latency, peak heap and peak stack for the RSA private-key
+ * profile selected in menuconfig (RSA_LOW_MEM or CRT with blinding).
+ *
+ * Build once per profile and compare the two reports. */
+
+/* ESP-IDF */
+#include "sdkconfig.h"
+#include <esp_log.h>
+#include <esp_timer.h>
+
+/* wolfSSL */
+#include <wolfssl/wolfcrypt/settings.h>
+#include <wolfssl/wolfcrypt/types.h>
+#include <wolfssl/wolfcrypt/random.h>
+#include <wolfssl/wolfcrypt/rsa.h>
+#include <wolfssl/wolfcrypt/error-crypt.h>
+
+#include "main.h"
+#ifdef WOLFSSL_ESP_HW_METRICS
+    #include "esp_wolfssl_hw_metrics.h"
+#endif
+
+#if defined(CONFIG_BENCH_RSA_SIGN_PROFILE) && !defined(NO_RSA)
+
+#include <wolfssl/certs_test.h>
+
+#include "tls_loopback.h"
+
+static const char* const TAG = "bench_rsa_sign";
+
+#ifdef RSA_LOW_MEM
+    #define BENCH_RSA_PROFILE_NAME "RSA_LOW_MEM"
+#else
+    #define BENCH_RSA_PROFILE_NAME "CRT + blinding"
+#endif
+
+/* The sign runs in its own task so the stack high water mark is not
+ * polluted by whatever ran before in app_main. */
+#define BENCH_RSA_TASK_STACK_SIZE (12 * 1024)
+
+static int bench_rsa_sign_task(tls_loopback_measure* m, void* arg)
+{
+    tls_loopback_timing* timing = (tls_loopback_timing*)arg;
+    RsaKey  key;
+    WC_RNG  rng;
+    word32  idx = 0;
+    byte    msg[32];
+    byte    sig[256];
+    byte    plain[sizeof(msg)];
+    int     ret;
+    int     i;
+    int64_t start;
+    int64_t elapsed;
+
+    XMEMSET(msg, 0xA5, sizeof(msg));
+
+    ret = wc_InitRng(&rng);
+    if (ret == 0) {
+        ret = wc_InitRsaKey(&key, NULL);
+        if (ret == 0) {
+            ret = wc_RsaPrivateKeyDecode(client_key_der_2048, &idx, &key,
+                                         sizeof_client_key_der_2048);
+        }
+        if (ret == 0) {
+            ret = wc_RsaSetRNG(&key, &rng);
+        }
+
+        /* Only the sign itself is accounted; key decode is a one-off */
+        tls_loopback_heap_start(m);
+
+        for (i = 0; ret == 0 && i < CONFIG_BENCH_RSA_SIGN_COUNT; i++) {
+            start = esp_timer_get_time();
+            ret = wc_RsaSSL_Sign(msg, sizeof(msg), sig, sizeof(sig),
+                                 &key, &rng);
+            elapsed = esp_timer_get_time() - start;
+            if (ret > 0) {
+                ret = 0;
+                tls_loopback_timing_add(timing, elapsed);
+            }
+        }
+        tls_loopback_heap_stop(m);
+
+        /* sanity check the last signature */
+        if (ret == 0) {
+            ret = wc_RsaSSL_Verify(sig, wc_RsaEncryptSize(&key),
+                                   plain, sizeof(plain), &key);
+            if (ret == (int)sizeof(msg)
+                && XMEMCMP(plain, msg, sizeof(msg)) == 0) {
+                ret = 0;
+            }
+            else if (ret >= 0) {
+                ret = SIG_VERIFY_E;
+            }
+        }
+
+        wc_FreeRsaKey(&key);
+        wc_FreeRng(&rng);
+    }
+
+    return ret;
+}
+
+int bench_rsa_sign_profile(void)
+{
+    tls_loopback_timing timing;
+    tls_loopback_measure measure;
+    int ret;
+#ifdef WOLFSSL_ESP_HW_METRICS
+    esp_wolfssl_hw_metrics_t hw0;
+    esp_wolfssl_hw_metrics_t hw1;
+    int i;
+#endif
+
+    XMEMSET(&timing, 0, sizeof(timing));
+
+    ESP_LOGI(TAG, "RSA-2048 sign, profile: %s", BENCH_RSA_PROFILE_NAME);
+
+    ret = wolfCrypt_Init();
+    if (ret != 0) {
+        ESP_LOGE(TAG, "wolfCrypt_Init failed: %d", ret);
+        return ret;
+    }
+
+#ifdef WOLFSSL_ESP_HW_METRICS
+    esp_wolfssl_hw_metrics_get(&hw0);
+#endif
+    ret = tls_loopback_run_task("bench_rsa_sign", BENCH_RSA_TASK_STACK_SIZE,
+                                bench_rsa_sign_task, &timing, &measure);
+#ifdef WOLFSSL_ESP_HW_METRICS
+    esp_wolfssl_hw_metrics_get(&hw1);
+#endif
+
+    wolfCrypt_Cleanup();
+
+    if (ret != 0 || timing.count == 0) {
+        ESP_LOGE(TAG, "RSA sign benchmark failed: %d", ret);
+        return ret != 0 ? ret : -1;
+    }
+
+    ESP_LOGI(TAG, "%-16s %u ops, avg %lld us, min %lld us, max %lld us",
+             BENCH_RSA_PROFILE_NAME, (unsigned)timing.count,
+             (long long)tls_loopback_timing_avg(&timing),
+             (long long)timing.min_us, (long long)timing.max_us);
+    ESP_LOGI(TAG, "%-16s peak heap %u bytes, peak stack %u bytes",
+             BENCH_RSA_PROFILE_NAME, (unsigned)measure.heap_peak,
+             (unsigned)measure.stack_peak);
+#ifdef WOLFSSL_ESP_HW_METRICS
+    /* did the big-number operations actually reach the MPI accelerator? */
+    for (i = ESP_WOLFSSL_HW_MP_MUL; i <= ESP_WOLFSSL_HW_MP_EXPTMOD; i++) {
+        ESP_LOGI(TAG, "%-16s %-10s hw %lu, sw %lu", BENCH_RSA_PROFILE_NAME,
+                 esp_wolfssl_hw_alg_name((esp_wolfssl_hw_alg_id_t)i),
+                 (unsigned long)(hw1.alg[i].hw - hw0.alg[i].hw),
+                 (unsigned long)(hw1.alg[i].sw - hw0.alg[i].sw));
+    }
+#endif
+
+    return 0;
+}
+
+#endif /* CONFIG_BENCH_RSA_SIGN_PROFILE && !NO_RSA */
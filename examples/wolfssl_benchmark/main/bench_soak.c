@@ -0,0 +1,588 @@
+/* bench_soak.c
+ *
+ * Copyright (C) 2006-2024 wolfSSL Inc.
+ *
+ * This file is part of wolfSSL.
+ *
+ * wolfSSL is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfSSL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335, USA
+ */
+
+/* Soak mode: a mixed crypto and TLS workload for hours, with periodic
+ * samples of throughput, free heap, largest free block, fragmentation and
+ * hardware lock contention, and a trend check over the whole run.
+ *
+ * On the device, select Example Configuration -> Benchmark mode -> Soak.
+ * For a fast soak on a Linux host, against an installed wolfSSL:
+ *
+ *   gcc -O2 -DBENCH_SOAK_HOST_MAIN -Imain/include \
+ *       main/bench_soak.c main/tls_loopback.c -lwolfssl -lm -o soak
+ *   ./soak <minutes> <interval seconds>
+ *
+ * Each sample is logged as a SOAK line (CSV after the prefix):
+ *   SOAK,<s>,<handshakes/s>,<crypto ops/s>,<free>,<min free>,<largest>,
+ *        <fragmentation %>,<lock contended>,<lock wait us>
+ * The exit status / return value is non-zero when a trend was flagged.
+ */
+
+#include "bench_common.h"
+
+#if defined(CONFIG_BENCH_MODE_SOAK) || defined(BENCH_SOAK_HOST_MAIN)
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <wolfssl/wolfcrypt/types.h>
+#include <wolfssl/wolfcrypt/error-crypt.h>
+#include <wolfssl/wolfcrypt/random.h>
+#include <wolfssl/wolfcrypt/sha256.h>
+#ifdef HAVE_AESGCM
+    #include <wolfssl/wolfcrypt/aes.h>
+#endif
+#ifdef HAVE_ECC
+    #include <wolfssl/wolfcrypt/ecc.h>
+#endif
+
+#include "tls_loopback.h"
+
+#ifdef ESP_PLATFORM
+    #include <freertos/FreeRTOS.h>
+    #include <freertos/task.h>
+    #include <esp_heap_caps.h>
+#elif defined(__GLIBC__)
+    #include <malloc.h>
+#endif
+
+#ifdef WOLFSSL_ESP_HW_METRICS
+    #include "esp_wolfssl_hw_metrics.h"
+#endif
+
+#include "main.h"
+
+#if !defined(WOLFCRYPT_ONLY) && !defined(NO_WOLFSSL_CLIENT) && \
+    !defined(NO_WOLFSSL_SERVER)
+    #define SOAK_HAVE_TLS
+    #define SOAK_INIT()    (wolfSSL_Init() == WOLFSSL_SUCCESS ? 0 : -1)
+    #define SOAK_CLEANUP() wolfSSL_Cleanup()
+#else
+    #define SOAK_INIT()    wolfCrypt_Init()
+    #define SOAK_CLEANUP() wolfCrypt_Cleanup()
+#endif
+
+#ifndef CONFIG_BENCH_SOAK_DURATION_MIN
+    #define CONFIG_BENCH_SOAK_DURATION_MIN 10
+#endif
+#ifndef CONFIG_BENCH_SOAK_INTERVAL_S
+    #define CONFIG_BENCH_SOAK_INTERVAL_S 10
+#endif
+#ifndef CONFIG_BENCH_SOAK_TREND_PCT
+    #define CONFIG_BENCH_SOAK_TREND_PCT 10
+#endif
+
+/* history kept for the trend check; halved by averaging pairs when full,
+ * so a run of any length is covered with bounded memory */
+#define SOAK_HISTORY     64
+/* samples skipped at the start: caches, lazy allocations */
+#define SOAK_WARMUP      1
+#define SOAK_MIN_SAMPLES 4
+
+#define SOAK_SHA_OPS     8
+#define SOAK_AES_OPS     4
+#define SOAK_DATA_SZ     1024
+
+static const char* const TAG = "bench_soak";
+
+typedef struct soak_sample {
+    double t_s;
+    double hs_rate;         /* TLS handshakes per second */
+    double ops_rate;        /* crypto operations per second */
+    double free_b;
+    double largest_b;
+    double frag_pct;        /* 100 * (1 - largest / free) */
+} soak_sample;
+
+typedef struct soak_heap {
+    size_t free_b;
+    size_t min_free_b;
+    size_t largest_b;
+} soak_heap;
+
+typedef struct soak_state {
+    tls_loopback lb;
+    int          lb_ok;
+    WC_RNG       rng;
+#ifdef HAVE_ECC
+    ecc_key      ecc;
+    int          ecc_ok;
+#endif
+    byte         data[SOAK_DATA_SZ];
+    uint32_t     lcg;
+    uint32_t     handshakes;
+    uint32_t     ops;
+    uint32_t     errors;
+    soak_sample  hist[SOAK_HISTORY];
+    int          hist_len;
+    int          hist_stride;   /* intervals per history entry */
+    int          stride_fill;   /* intervals merged into the pending entry */
+} soak_state;
+
+static void soak_heap_get(soak_heap* h)
+{
+    memset(h, 0, sizeof(*h));
+#ifdef ESP_PLATFORM
+    h->free_b     = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+    h->min_free_b = heap_caps_get_minimum_free_size(MALLOC_CAP_8BIT);
+    h->largest_b  = heap_caps_get_largest_free_block(MALLOC_CAP_8BIT);
+#elif defined(__GLIBC__) && \
+      (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+    /* glibc: free bytes in the arena, and the largest free chunk as seen
+     * in the malloc_info() bins or the top chunk */
+    struct mallinfo2 mi = mallinfo2();
+    char* xml = NULL;
+    size_t xmlSz = 0;
+    FILE* f;
+    const char* p;
+    unsigned long to;
+    unsigned long count;
+
+    h->free_b = mi.fordblks;
+    h->largest_b = mi.keepcost;
+    f = open_memstream(&xml, &xmlSz);
+    if (f != NULL) {
+        malloc_info(0, f);
+        fclose(f);
+        for (p = xml; p != NULL && (p = strstr(p, "<size from=")) != NULL;
+             p++) {
+            if (sscanf(p, "<size from=\"%*u\" to=\"%lu\" total=\"%*u\" "
+                          "count=\"%lu\"", &to, &count) == 2
+                && count > 0 && to > h->largest_b) {
+                h->largest_b = to;
+            }
+        }
+        free(xml);
+    }
+    if (h->largest_b > h->free_b) {
+        h->largest_b = h->free_b;
+    }
+    h->min_free_b = h->free_b;
+#endif
+}
+
+static uint32_t soak_rand(soak_state* s)
+{
+    s->lcg = s->lcg * 1664525u + 1013904223u;
+    return s->lcg >> 8;
+}
+
+static int soak_crypto(soak_state* s)
+{
+    byte digest[WC_SHA256_DIGEST_SIZE];
+    wc_Sha256 sha;
+    int ret = 0;
+    int i;
+#ifdef HAVE_AESGCM
+    Aes aes;
+    byte key[16];
+    byte iv[12];
+    byte tag[16];
+    byte out[SOAK_DATA_SZ];
+#endif
+#ifdef HAVE_ECC
+    byte sig[ECC_MAX_SIG_SIZE];
+    word32 sigSz;
+    int verified = 0;
+#endif
+
+    for (i = 0; ret == 0 && i < SOAK_SHA_OPS; i++) {
+        ret = wc_InitSha256(&sha);
+        if (ret == 0) {
+            ret = wc_Sha256Update(&sha, s->data, sizeof(s->data));
+        }
+        if (ret == 0) {
+            ret = wc_Sha256Final(&sha, digest);
+        }
+        wc_Sha256Free(&sha);
+        if (ret == 0) {
+            s->ops++;
+        }
+    }
+
+#ifdef HAVE_AESGCM
+    memcpy(key, digest, sizeof(key));
+    memcpy(iv, digest + sizeof(key), sizeof(iv));
+    if (ret == 0) {
+        ret = wc_AesInit(&aes, NULL, INVALID_DEVID);
+    }
+    if (ret == 0) {
+        ret = wc_AesGcmSetKey(&aes, key, sizeof(key));
+        for (i = 0; ret == 0 && i < SOAK_AES_OPS; i++) {
+            ret = wc_AesGcmEncrypt(&aes, out, s->data, sizeof(s->data),
+                                   iv, sizeof(iv), tag, sizeof(tag), NULL, 0);
+            if (ret == 0) {
+                s->ops++;
+            }
+        }
+        wc_AesFree(&aes);
+    }
+#endif
+
+#ifdef HAVE_ECC
+    if (ret == 0 && s->ecc_ok) {
+        sigSz = sizeof(sig);
+        ret = wc_ecc_sign_hash(digest, sizeof(digest), sig, &sigSz, &s->rng,
+                               &s->ecc);
+        if (ret == 0) {
+            ret = wc_ecc_verify_hash(sig, sigSz, digest, sizeof(digest),
+                                     &verified, &s->ecc);
+        }
+        if (ret == 0 && !verified) {
+            ret = SIG_VERIFY_E;
+        }
+        if (ret == 0) {
+            s->ops += 2;
+        }
+    }
+#endif
+
+    return ret;
+}
+
+static int soak_tls(soak_state* s)
+{
+    int ret = 0;
+
+#ifdef SOAK_HAVE_TLS
+    if (!s->lb_ok) {
+        return 0;
+    }
+    ret = tls_loopback_connect(&s->lb);
+    if (ret == 0) {
+        /* varying record sizes, as a device sees */
+        ret = tls_loopback_echo(&s->lb, 256 + soak_rand(s) % 3841);
+    }
+    tls_loopback_close(&s->lb);
+    if (ret == 0) {
+        s->handshakes++;
+    }
+#else
+    (void)s;
+#endif
+    return ret;
+}
+
+static void soak_history_add(soak_state* s, const soak_sample* x)
+{
+    soak_sample* last;
+    int i;
+
+    if (s->stride_fill > 0) {
+        /* running mean into the pending entry */
+        last = &s->hist[s->hist_len - 1];
+        s->stride_fill++;
+        last->t_s        = x->t_s;
+        last->hs_rate   += (x->hs_rate - last->hs_rate) / s->stride_fill;
+        last->ops_rate  += (x->ops_rate - last->ops_rate) / s->stride_fill;
+        last->free_b    += (x->free_b - last->free_b) / s->stride_fill;
+        last->largest_b += (x->largest_b - last->largest_b) / s->stride_fill;
+        last->frag_pct  += (x->frag_pct - last->frag_pct) / s->stride_fill;
+        if (s->stride_fill >= s->hist_stride) {
+            s->stride_fill = 0;
+        }
+        return;
+    }
+
+    if (s->hist_len == SOAK_HISTORY) {
+        /* keep the warmup entry as is, merge the rest in pairs */
+        for (i = SOAK_WARMUP; 2 * i - SOAK_WARMUP + 1 < SOAK_HISTORY; i++) {
+            const soak_sample* a = &s->hist[2 * i - SOAK_WARMUP];
+            const soak_sample* b = &s->hist[2 * i - SOAK_WARMUP + 1];
+            s->hist[i].t_s       = b->t_s;
+            s->hist[i].hs_rate   = (a->hs_rate + b->hs_rate) / 2;
+            s->hist[i].ops_rate  = (a->ops_rate + b->ops_rate) / 2;
+            s->hist[i].free_b    = (a->free_b + b->free_b) / 2;
+            s->hist[i].largest_b = (a->largest_b + b->largest_b) / 2;
+            s->hist[i].frag_pct  = (a->frag_pct + b->frag_pct) / 2;
+        }
+        s->hist_len = i;
+        s->hist_stride *= 2;
+    }
+
+    s->hist[s->hist_len++] = *x;
+    if (s->hist_stride > 1) {
+        s->stride_fill = 1;
+    }
+}
+
+/* Least squares slope of one field against time, after the warmup. */
+static double soak_slope(const soak_state* s, size_t off, double* mean)
+{
+    double st = 0, sy = 0, stt = 0, sty = 0;
+    double t, y, d;
+    int n = 0;
+    int i;
+
+    for (i = SOAK_WARMUP; i < s->hist_len; i++) {
+        t = s->hist[i].t_s;
+        y = *(const double*)((const byte*)&s->hist[i] + off);
+        st += t;
+        sy += y;
+        stt += t * t;
+        sty += t * y;
+        n++;
+    }
+    *mean = (n > 0) ? sy / n : 0;
+    d = n * stt - st * st;
+    return (n < 2 || d == 0) ? 0 : (n * sty - st * sy) / d;
+}
+
+/* Logs the trends; returns the number of metrics that degrade by more
+ * than CONFIG_BENCH_SOAK_TREND_PCT over the run. */
+static int soak_trends(const soak_state* s, int final)
+{
+    static const struct {
+        const char* name;
+        size_t      off;
+        int         absolute;   /* compare in percent points */
+        int         sign;       /* direction that is bad */
+        const char* flag;
+    } metrics[] = {
+        { "handshakes/s", offsetof(soak_sample, hs_rate),   0, -1,
+          "THROUGHPUT DROP" },
+        { "crypto ops/s", offsetof(soak_sample, ops_rate),  0, -1,
+          "THROUGHPUT DROP" },
+        { "free heap",    offsetof(soak_sample, free_b),    0, -1,
+          "LEAK" },
+        { "largest block", offsetof(soak_sample, largest_b), 0, -1,
+          "FRAGMENTATION" },
+        { "fragmentation", offsetof(soak_sample, frag_pct),  1, +1,
+          "FRAGMENTATION" },
+    };
+    double span;
+    double mean;
+    double slope;
+    double change;
+    int flagged = 0;
+    size_t i;
+
+    if (s->hist_len - SOAK_WARMUP < SOAK_MIN_SAMPLES) {
+        return 0;
+    }
+    span = s->hist[s->hist_len - 1].t_s - s->hist[SOAK_WARMUP].t_s;
+
+    for (i = 0; i < sizeof(metrics) / sizeof(metrics[0]); i++) {
+        slope = soak_slope(s, metrics[i].off, &mean);
+        /* projected change over the run, relative or in points */
+        change = slope * span;
+        if (!metrics[i].absolute) {
+            change = (mean != 0) ? 100.0 * change / mean : 0;
+        }
+        if (change * metrics[i].sign > CONFIG_BENCH_SOAK_TREND_PCT) {
+            flagged++;
+            ESP_LOGW(TAG, "trend %-13s %+.1f%s over %.0f s: %s",
+                     metrics[i].name, change,
+                     metrics[i].absolute ? " points" : "%", span,
+                     metrics[i].flag);
+        }
+        else if (final) {
+            ESP_LOGI(TAG, "trend %-13s %+.1f%s over %.0f s: ok",
+                     metrics[i].name, change,
+                     metrics[i].absolute ? " points" : "%", span);
+        }
+    }
+
+    return flagged;
+}
+
+static int soak_setup(soak_state* s)
+{
+    int ret;
+    size_t i;
+
+    memset(s, 0, sizeof(*s));
+    s->lcg = 0x50A1;
+    s->hist_stride = 1;
+    for (i = 0; i < sizeof(s->data); i++) {
+        s->data[i] = (byte)i;
+    }
+
+    ret = wc_InitRng(&s->rng);
+    if (ret != 0) {
+        return ret;
+    }
+#ifdef HAVE_ECC
+    if (wc_ecc_init(&s->ecc) == 0) {
+        s->ecc_ok = (wc_ecc_make_key(&s->rng, 32, &s->ecc) == 0);
+    }
+#endif
+
+#ifdef SOAK_HAVE_TLS
+    s->lb_ok = (tls_loopback_init(&s->lb, NULL) == 0);
+#endif
+    if (!s->lb_ok) {
+        ESP_LOGW(TAG, "TLS loopback unavailable, crypto workload only");
+    }
+
+    return 0;
+}
+
+static void soak_cleanup(soak_state* s)
+{
+#ifdef SOAK_HAVE_TLS
+    if (s->lb_ok) {
+        tls_loopback_free(&s->lb);
+    }
+#endif
+#ifdef HAVE_ECC
+    wc_ecc_free(&s->ecc);
+#endif
+    wc_FreeRng(&s->rng);
+}
+
+int bench_soak_run(uint32_t duration_s, uint32_t interval_s)
+{
+    soak_state* s;
+    soak_sample x;
+    soak_heap heap;
+    int64_t start;
+    int64_t last;
+    int64_t now;
+    uint32_t hs0 = 0;
+    uint32_t ops0 = 0;
+    double dt;
+    int flagged = 0;
+    int ret;
+#ifdef WOLFSSL_ESP_HW_METRICS
+    esp_wolfssl_hw_metrics_t hw;
+    uint32_t contended0 = 0;
+    uint64_t wait0 = 0;
+#endif
+    uint32_t contended = 0;
+    uint64_t wait_us = 0;
+
+    if (interval_s == 0) {
+        interval_s = 1;
+    }
+
+    /* reference counted; the wolfCrypt benchmark cleans up after itself */
+    ret = SOAK_INIT();
+    if (ret != 0) {
+        return ret;
+    }
+    /* the history is too big for a task stack */
+    s = (soak_state*)XMALLOC(sizeof(*s), NULL, DYNAMIC_TYPE_TMP_BUFFER);
+    if (s == NULL) {
+        SOAK_CLEANUP();
+        return MEMORY_E;
+    }
+    ret = soak_setup(s);
+    if (ret != 0) {
+        XFREE(s, NULL, DYNAMIC_TYPE_TMP_BUFFER);
+        SOAK_CLEANUP();
+        return ret;
+    }
+
+    ESP_LOGI(TAG, "soak for %u s, sample every %u s, trend limit %d%%",
+             (unsigned)duration_s, (unsigned)interval_s,
+             CONFIG_BENCH_SOAK_TREND_PCT);
+    ESP_LOGI(TAG, "SOAK,s,handshakes_per_s,ops_per_s,free,min_free,largest,"
+                  "frag_pct,lock_contended,lock_wait_us");
+
+    start = last = esp_timer_get_time();
+    do {
+        ret = soak_crypto(s);
+        if (ret == 0) {
+            ret = soak_tls(s);
+        }
+        if (ret != 0) {
+            s->errors++;
+            ESP_LOGE(TAG, "workload error %d", ret);
+            ret = 0;
+        }
+
+        now = esp_timer_get_time();
+        if (now - last < (int64_t)interval_s * 1000000) {
+#ifdef ESP_PLATFORM
+            /* let the idle task run, e.g. to free deleted task stacks */
+            vTaskDelay(1);
+#endif
+            continue;
+        }
+
+        dt = (double)(now - last) / 1e6;
+        soak_heap_get(&heap);
+#ifdef WOLFSSL_ESP_HW_METRICS
+        esp_wolfssl_hw_metrics_get(&hw);
+        contended = hw.lock.contended - contended0;
+        wait_us = hw.lock.wait_total_us - wait0;
+        contended0 = hw.lock.contended;
+        wait0 = hw.lock.wait_total_us;
+#endif
+
+        x.t_s       = (double)(now - start) / 1e6;
+        x.hs_rate   = (s->handshakes - hs0) / dt;
+        x.ops_rate  = (s->ops - ops0) / dt;
+        x.free_b    = (double)heap.free_b;
+        x.largest_b = (double)heap.largest_b;
+        x.frag_pct  = (heap.free_b > 0) ?
+                       100.0 * (1.0 - x.largest_b / x.free_b) : 0;
+        hs0 = s->handshakes;
+        ops0 = s->ops;
+        last = now;
+
+        ESP_LOGI(TAG, "SOAK,%.0f,%.2f,%.1f,%u,%u,%u,%.1f,%u,%llu", x.t_s,
+                 x.hs_rate, x.ops_rate, (unsigned)heap.free_b,
+                 (unsigned)heap.min_free_b, (unsigned)heap.largest_b,
+                 x.frag_pct, (unsigned)contended,
+                 (unsigned long long)wait_us);
+
+        soak_history_add(s, &x);
+        flagged = soak_trends(s, 0);
+    } while (duration_s == 0 || now - start < (int64_t)duration_s * 1000000);
+
+    ESP_LOGI(TAG, "soak done: %u handshakes, %u crypto ops, %u errors",
+             (unsigned)s->handshakes, (unsigned)s->ops, (unsigned)s->errors);
+    flagged = soak_trends(s, 1);
+    if (flagged > 0 || s->errors > 0) {
+        ESP_LOGW(TAG, "soak FAILED: %d degrading metric(s), %u errors",
+                 flagged, (unsigned)s->errors);
+        ret = -1;
+    }
+
+    soak_cleanup(s);
+    XFREE(s, NULL, DYNAMIC_TYPE_TMP_BUFFER);
+    SOAK_CLEANUP();
+    return ret;
+}
+
+#ifdef BENCH_SOAK_HOST_MAIN
+int main(int argc, char** argv)
+{
+    uint32_t minutes = CONFIG_BENCH_SOAK_DURATION_MIN;
+    uint32_t interval = CONFIG_BENCH_SOAK_INTERVAL_S;
+    int ret;
+
+    if (argc > 1) {
+        minutes = (uint32_t)strtoul(argv[1], NULL, 10);
+    }
+    if (argc > 2) {
+        interval = (uint32_t)strtoul(argv[2], NULL, 10);
+    }
+
+    ret = bench_soak_run(minutes * 60, interval);
+
+    return (ret == 0) ? 0 : 1;
+}
+#endif
+
+#endif /* CONFIG_BENCH_MODE_SOAK || BENCH_SOAK_HOST_MAIN */
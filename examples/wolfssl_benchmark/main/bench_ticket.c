@@ -0,0 +1,219 @@
+/* bench_ticket.c
+ *
+ * Copyright (C) 2006-2024 wolfSSL Inc.
+ *
+ * This file is part of wolfSSL.
+ *
+ * wolfSSL is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfSSL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335, USA
+ */
+
+/* TLS 1.3 handshakes against a server with the session ticket engine of
+ * esp_wolfssl_ticket.h over the in-memory loopback: full handshakes, and
+ * resumptions where the client presents the ticket of its last connection.
+ * Reports handshake latency and rate, bytes from the server, and checks
+ * that a ticket presented a second time gets a full handshake. Session
+ * tickets keep no state on the server, so the rate of resumptions is what
+ * a server with many returning clients sustains. */
+
+/* ESP-IDF */
+#include "sdkconfig.h"
+#include <esp_log.h>
+
+/* wolfSSL */
+#include <wolfssl/wolfcrypt/settings.h>
+#include <wolfssl/ssl.h>
+#include <wolfssl/error-ssl.h>
+#include <wolfssl/wolfcrypt/error-crypt.h>
+
+#include "main.h"
+
+#if defined(CONFIG_BENCH_TICKET) && defined(WOLFSSL_ESP_TICKET) && \
+    defined(WOLFSSL_TLS13) && \
+    !defined(NO_WOLFSSL_CLIENT) && !defined(NO_WOLFSSL_SERVER)
+
+#include <string.h>
+
+#include "tls_loopback.h"
+#include "ocsp_test_data.h"
+#include "esp_wolfssl_ticket.h"
+
+static const char* const TAG = "bench_ticket";
+
+#define BENCH_TICKET_TASK_STACK_SIZE (16 * 1024)
+
+typedef struct bench_ticket_state {
+    int              rotate;    /* resumptions: keep each new ticket */
+    int              warmup;    /* handshakes before the first resumption */
+    int              n;         /* handshakes checked */
+    int              resumed;   /* of the last handshake */
+    WOLFSSL_SESSION* used;      /* the ticket presented last */
+} bench_ticket_state;
+
+/* the session the next client offers, NULL for a full handshake */
+static WOLFSSL_SESSION* bench_ticket_session;
+
+static int bench_ticket_ctx_setup(WOLFSSL_CTX* ctx, int server)
+{
+    int ret;
+
+    if (!server) {
+        return 0;
+    }
+    ret = esp_wolfssl_ticket_ctx_setup(ctx);
+    return (ret == WOLFSSL_SUCCESS) ? 0 : ret;
+}
+
+static int bench_ticket_setup(WOLFSSL* ssl, int server)
+{
+    int ret;
+
+    if (server || bench_ticket_session == NULL) {
+        return 0;
+    }
+    ret = wolfSSL_set_session(ssl, bench_ticket_session);
+    return (ret == WOLFSSL_SUCCESS) ? 0 : ret;
+}
+
+/* the client keeps the ticket it got, which a TLS 1.3 server sends after
+ * the handshake and the echo reads; every resumption presents the ticket
+ * of the connection before */
+static int bench_ticket_check(tls_loopback* lb, void* arg)
+{
+    bench_ticket_state* st = (bench_ticket_state*)arg;
+    WOLFSSL_SESSION* next;
+    int ret;
+
+    st->resumed = wolfSSL_session_reused(lb->client);
+    ret = tls_loopback_echo(lb, 1);
+    if (ret != 0 || !st->rotate) {
+        return ret;
+    }
+    if (st->n++ >= st->warmup && !st->resumed) {
+        ESP_LOGE(TAG, "ticket %d not accepted", st->n - 1 - st->warmup);
+        return SESSION_TICKET_EXPECT_E;
+    }
+    next = wolfSSL_get1_session(lb->client);
+    if (next == NULL) {
+        return MEMORY_E;
+    }
+    wolfSSL_SESSION_free(st->used);
+    st->used = bench_ticket_session;
+    bench_ticket_session = next;
+    return 0;
+}
+
+static int bench_ticket_run(tls_loopback_bench* b, bench_ticket_state* st,
+                            int count)
+{
+    tls_loopback_cfg cfg;
+
+    memset(&cfg, 0, sizeof(cfg));
+    cfg.version = TLS_LOOPBACK_VERSION_13;
+    cfg.ca = ocsp_ca_der;
+    cfg.ca_sz = sizeof_ocsp_ca_der;
+    cfg.server_cert = ocsp_server_cert_der;
+    cfg.server_cert_sz = sizeof_ocsp_server_cert_der;
+    cfg.server_key = ocsp_server_key_der;
+    cfg.server_key_sz = sizeof_ocsp_server_key_der;
+    cfg.ctx_setup = bench_ticket_ctx_setup;
+    cfg.setup = bench_ticket_setup;
+
+    memset(b, 0, sizeof(*b));
+    b->cfg = &cfg;
+    b->count = count;
+    b->warmup = st->warmup;
+    b->stack_size = BENCH_TICKET_TASK_STACK_SIZE;
+    b->check = bench_ticket_check;
+    b->arg = st;
+    return tls_loopback_bench_run(b);
+}
+
+static void bench_ticket_log(const char* name, const tls_loopback_bench* b)
+{
+    int64_t avg = tls_loopback_timing_avg(&b->timing);
+
+    ESP_LOGI(TAG, "%-10s %8lld us avg, %8lld min, %8lld max, %6.1f /s, "
+                  "%5u bytes to client",
+             name, (long long)avg, (long long)b->timing.min_us,
+             (long long)b->timing.max_us,
+             avg > 0 ? 1000000.0 / (double)avg : 0.0,
+             (unsigned)b->last.server_bytes);
+}
+
+int bench_ticket(void)
+{
+    tls_loopback_bench full;
+    tls_loopback_bench resumed;
+    tls_loopback_bench replay;
+    bench_ticket_state st;
+    esp_wolfssl_ticket_stats_t stats;
+    int replay_resumed = 0;
+    int ret;
+
+    /* reference counted; the wolfCrypt benchmark cleans up after itself */
+    ret = wolfSSL_Init();
+    if (ret != WOLFSSL_SUCCESS) {
+        return ret;
+    }
+
+    memset(&st, 0, sizeof(st));
+    bench_ticket_session = NULL;
+    ret = bench_ticket_run(&full, &st, CONFIG_BENCH_TICKET_COUNT);
+
+    /* one full handshake for the first ticket, then resumptions */
+    if (ret == 0) {
+        st.rotate = 1;
+        st.warmup = 1;
+        ret = bench_ticket_run(&resumed, &st, CONFIG_BENCH_TICKET_COUNT);
+    }
+
+    /* the ticket of the last resumption again, still in the replay window */
+    wolfSSL_SESSION_free(bench_ticket_session);
+    bench_ticket_session = st.used;
+    if (ret == 0) {
+        memset(&st, 0, sizeof(st));
+        ret = bench_ticket_run(&replay, &st, 1);
+        replay_resumed = st.resumed;
+    }
+    wolfSSL_SESSION_free(bench_ticket_session);
+    bench_ticket_session = NULL;
+
+    if (ret != 0) {
+        ESP_LOGE(TAG, "handshake failed: %d", ret);
+    }
+    else {
+        esp_wolfssl_ticket_get_stats(&stats);
+        ESP_LOGI(TAG, "TLS 1.3, P-256, %d handshakes each, client and "
+                      "server together", CONFIG_BENCH_TICKET_COUNT);
+        bench_ticket_log("full", &full);
+        bench_ticket_log("resumed", &resumed);
+        ESP_LOGI(TAG, "replayed ticket: %s",
+                 replay_resumed ? "RESUMED, replay not detected"
+                                : "full handshake");
+        ESP_LOGI(TAG, "tickets issued %u, accepted %u, replayed %u, "
+                      "unknown key %u, bad tag %u",
+                 (unsigned)stats.issued, (unsigned)stats.accepted,
+                 (unsigned)stats.replayed, (unsigned)stats.unknown_key,
+                 (unsigned)stats.bad_tag);
+        if (replay_resumed && ESP_WOLFSSL_TICKET_REPLAY > 0) {
+            ret = SESSION_TICKET_EXPECT_E;
+        }
+    }
+
+    wolfSSL_Cleanup();
+    return ret;
+}
+
+#endif /* CONFIG_BENCH_TICKET && WOLFSSL_ESP_TICKET && ... */
@@ -0,0 +1,58 @@
+/* bench_common.h
+ *
+ * Copyright (C) 2006-2024 wolfSSL Inc.
+ *
+ * This file is part of wolfSSL.
+ *
+ * wolfSSL is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfSSL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335, USA
+ */
+
+/* Shared by the benchmark sources that also build on a Linux host against
+ * an installed wolfSSL (see bench_soak.c). ESP_PLATFORM is set by the
+ * ESP-IDF build system. */
+
+#ifndef _BENCH_COMMON_H_
+#define _BENCH_COMMON_H_
+
+#ifdef ESP_PLATFORM
+    #include "sdkconfig.h"
+    #include <esp_log.h>
+    #include <esp_timer.h>
+#else
+    #include <stdint.h>
+    #include <stdio.h>
+    #include <time.h>
+    #ifndef WOLFSSL_USER_SETTINGS
+        #include <wolfssl/options.h>
+    #endif
+
+    #define ESP_LOGE(tag, fmt, ...) \
+                fprintf(stderr, "E %s: " fmt "\n", tag, ##__VA_ARGS__)
+    #define ESP_LOGW(tag, fmt, ...) \
+                fprintf(stderr, "W %s: " fmt "\n", tag, ##__VA_ARGS__)
+    #define ESP_LOGI(tag, fmt, ...) \
+                printf("I %s: " fmt "\n", tag, ##__VA_ARGS__)
+
+    static inline int64_t esp_timer_get_time(void)
+    {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+    }
+#endif
+
+#include <wolfssl/wolfcrypt/settings.h>
+
+#endif /* _BENCH_COMMON_H_ */
@@ -0,0 +1,333 @@
+/* cert_corpus.h
+ *
+ * Copyright (C) 2006-2024 wolfSSL Inc.
+ *
+ * This file is part of wolfSSL.
+ *
+ * wolfSSL is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfSSL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335, USA
+ */
+
+/* Real certificates for the certificate parse benchmark (bench_cert.c),
+ * public roots of the Mozilla CA store in different shapes:
+ *
+ *   cert_isrg_root_x1             RSA-4096, SHA-256, 1391 bytes
+ *   cert_isrg_root_x2             P-384, ECDSA SHA-384, 543 bytes
+ *   cert_digicert_global_root_g2  RSA-2048, SHA-256, 914 bytes
+ *   cert_amazon_root_ca_3         P-256, ECDSA SHA-256, 442 bytes
+ *
+ * Converted from the PEM files of the ca-certificates package:
+ *   openssl x509 -in /etc/ssl/certs/ISRG_Root_X1.pem -outform DER
+ */
+
+#ifndef _CERT_CORPUS_H_
+#define _CERT_CORPUS_H_
+
+static const unsigned char cert_isrg_root_x1[] =
+{
+    0x30, 0x82, 0x05, 0x6B, 0x30, 0x82, 0x03, 0x53, 0xA0, 0x03, 0x02, 0x01,
+    0x02, 0x02, 0x11, 0x00, 0x82, 0x10, 0xCF, 0xB0, 0xD2, 0x40, 0xE3, 0x59,
+    0x44, 0x63, 0xE0, 0xBB, 0x63, 0x82, 0x8B, 0x00, 0x30, 0x0D, 0x06, 0x09,
+    0x2A, 0x86, 0x48, 0x86, 0xF7, 0x0D, 0x01, 0x01, 0x0B, 0x05, 0x00, 0x30,
+    0x4F, 0x31, 0x0B, 0x30, 0x09, 0x06, 0x03, 0x55, 0x04, 0x06, 0x13, 0x02,
+    0x55, 0x53, 0x31, 0x29, 0x30, 0x27, 0x06, 0x03, 0x55, 0x04, 0x0A, 0x13,
+    0x20, 0x49, 0x6E, 0x74, 0x65, 0x72, 0x6E, 0x65, 0x74, 0x20, 0x53, 0x65,
+    0x63, 0x75, 0x72, 0x69, 0x74, 0x79, 0x20, 0x52, 0x65, 0x73, 0x65, 0x61,
+    0x72, 0x63, 0x68, 0x20, 0x47, 0x72, 0x6F, 0x75, 0x70, 0x31, 0x15, 0x30,
+    0x13, 0x06, 0x03, 0x55, 0x04, 0x03, 0x13, 0x0C, 0x49, 0x53, 0x52, 0x47,
+    0x20, 0x52, 0x6F, 0x6F, 0x74, 0x20, 0x58, 0x31, 0x30, 0x1E, 0x17, 0x0D,
+    0x31, 0x35, 0x30, 0x36, 0x30, 0x34, 0x31, 0x31, 0x30, 0x34, 0x33, 0x38,
+    0x5A, 0x17, 0x0D, 0x33, 0x35, 0x30, 0x36, 0x30, 0x34, 0x31, 0x31, 0x30,
+    0x34, 0x33, 0x38, 0x5A, 0x30, 0x4F, 0x31, 0x0B, 0x30, 0x09, 0x06, 0x03,
+    0x55, 0x04, 0x06, 0x13, 0x02, 0x55, 0x53, 0x31, 0x29, 0x30, 0x27, 0x06,
+    0x03, 0x55, 0x04, 0x0A, 0x13, 0x20, 0x49, 0x6E, 0x74, 0x65, 0x72, 0x6E,
+    0x65, 0x74, 0x20, 0x53, 0x65, 0x63, 0x75, 0x72, 0x69, 0x74, 0x79, 0x20,
+    0x52, 0x65, 0x73, 0x65, 0x61, 0x72, 0x63, 0x68, 0x20, 0x47, 0x72, 0x6F,
+    0x75, 0x70, 0x31, 0x15, 0x30, 0x13, 0x06, 0x03, 0x55, 0x04, 0x03, 0x13,
+    0x0C, 0x49, 0x53, 0x52, 0x47, 0x20, 0x52, 0x6F, 0x6F, 0x74, 0x20, 0x58,
+    0x31, 0x30, 0x82, 0x02, 0x22, 0x30, 0x0D, 0x06, 0x09, 0x2A, 0x86, 0x48,
+    0x86, 0xF7, 0x0D, 0x01, 0x01, 0x01, 0x05, 0x00, 0x03, 0x82, 0x02, 0x0F,
+    0x00, 0x30, 0x82, 0x02, 0x0A, 0x02, 0x82, 0x02, 0x01, 0x00, 0xAD, 0xE8,
+    0x24, 0x73, 0xF4, 0x14, 0x37, 0xF3, 0x9B, 0x9E, 0x2B, 0x57, 0x28, 0x1C,
+    0x87, 0xBE, 0xDC, 0xB7, 0xDF, 0x38, 0x90, 0x8C, 0x6E, 0x3C, 0xE6, 0x57,
+    0xA0, 0x78, 0xF7, 0x75, 0xC2, 0xA2, 0xFE, 0xF5, 0x6A, 0x6E, 0xF6, 0x00,
+    0x4F, 0x28, 0xDB, 0xDE, 0x68, 0x86, 0x6C, 0x44, 0x93, 0xB6, 0xB1, 0x63,
+    0xFD, 0x14, 0x12, 0x6B, 0xBF, 0x1F, 0xD2, 0xEA, 0x31, 0x9B, 0x21, 0x7E,
+    0xD1, 0x33, 0x3C, 0xBA, 0x48, 0xF5, 0xDD, 0x79, 0xDF, 0xB3, 0xB8, 0xFF,
+    0x12, 0xF1, 0x21, 0x9A, 0x4B, 0xC1, 0x8A, 0x86, 0x71, 0x69, 0x4A, 0x66,
+    0x66, 0x6C, 0x8F, 0x7E, 0x3C, 0x70, 0xBF, 0xAD, 0x29, 0x22, 0x06, 0xF3,
+    0xE4, 0xC0, 0xE6, 0x80, 0xAE, 0xE2, 0x4B, 0x8F, 0xB7, 0x99, 0x7E, 0x94,
+    0x03, 0x9F, 0xD3, 0x47, 0x97, 0x7C, 0x99, 0x48, 0x23, 0x53, 0xE8, 0x38,
+    0xAE, 0x4F, 0x0A, 0x6F, 0x83, 0x2E, 0xD1, 0x49, 0x57, 0x8C, 0x80, 0x74,
+    0xB6, 0xDA, 0x2F, 0xD0, 0x38, 0x8D, 0x7B, 0x03, 0x70, 0x21, 0x1B, 0x75,
+    0xF2, 0x30, 0x3C, 0xFA, 0x8F, 0xAE, 0xDD, 0xDA, 0x63, 0xAB, 0xEB, 0x16,
+    0x4F, 0xC2, 0x8E, 0x11, 0x4B, 0x7E, 0xCF, 0x0B, 0xE8, 0xFF, 0xB5, 0x77,
+    0x2E, 0xF4, 0xB2, 0x7B, 0x4A, 0xE0, 0x4C, 0x12, 0x25, 0x0C, 0x70, 0x8D,
+    0x03, 0x29, 0xA0, 0xE1, 0x53, 0x24, 0xEC, 0x13, 0xD9, 0xEE, 0x19, 0xBF,
+    0x10, 0xB3, 0x4A, 0x8C, 0x3F, 0x89, 0xA3, 0x61, 0x51, 0xDE, 0xAC, 0x87,
+    0x07, 0x94, 0xF4, 0x63, 0x71, 0xEC, 0x2E, 0xE2, 0x6F, 0x5B, 0x98, 0x81,
+    0xE1, 0x89, 0x5C, 0x34, 0x79, 0x6C, 0x76, 0xEF, 0x3B, 0x90, 0x62, 0x79,
+    0xE6, 0xDB, 0xA4, 0x9A, 0x2F, 0x26, 0xC5, 0xD0, 0x10, 0xE1, 0x0E, 0xDE,
+    0xD9, 0x10, 0x8E, 0x16, 0xFB, 0xB7, 0xF7, 0xA8, 0xF7, 0xC7, 0xE5, 0x02,
+    0x07, 0x98, 0x8F, 0x36, 0x08, 0x95, 0xE7, 0xE2, 0x37, 0x96, 0x0D, 0x36,
+    0x75, 0x9E, 0xFB, 0x0E, 0x72, 0xB1, 0x1D, 0x9B, 0xBC, 0x03, 0xF9, 0x49,
+    0x05, 0xD8, 0x81, 0xDD, 0x05, 0xB4, 0x2A, 0xD6, 0x41, 0xE9, 0xAC, 0x01,
+    0x76, 0x95, 0x0A, 0x0F, 0xD8, 0xDF, 0xD5, 0xBD, 0x12, 0x1F, 0x35, 0x2F,
+    0x28, 0x17, 0x6C, 0xD2, 0x98, 0xC1, 0xA8, 0x09, 0x64, 0x77, 0x6E, 0x47,
+    0x37, 0xBA, 0xCE, 0xAC, 0x59, 0x5E, 0x68, 0x9D, 0x7F, 0x72, 0xD6, 0x89,
+    0xC5, 0x06, 0x41, 0x29, 0x3E, 0x59, 0x3E, 0xDD, 0x26, 0xF5, 0x24, 0xC9,
+    0x11, 0xA7, 0x5A, 0xA3, 0x4C, 0x40, 0x1F, 0x46, 0xA1, 0x99, 0xB5, 0xA7,
+    0x3A, 0x51, 0x6E, 0x86, 0x3B, 0x9E, 0x7D, 0x72, 0xA7, 0x12, 0x05, 0x78,
+    0x59, 0xED, 0x3E, 0x51, 0x78, 0x15, 0x0B, 0x03, 0x8F, 0x8D, 0xD0, 0x2F,
+    0x05, 0xB2, 0x3E, 0x7B, 0x4A, 0x1C, 0x4B, 0x73, 0x05, 0x12, 0xFC, 0xC6,
+    0xEA, 0xE0, 0x50, 0x13, 0x7C, 0x43, 0x93, 0x74, 0xB3, 0xCA, 0x74, 0xE7,
+    0x8E, 0x1F, 0x01, 0x08, 0xD0, 0x30, 0xD4, 0x5B, 0x71, 0x36, 0xB4, 0x07,
+    0xBA, 0xC1, 0x30, 0x30, 0x5C, 0x48, 0xB7, 0x82, 0x3B, 0x98, 0xA6, 0x7D,
+    0x60, 0x8A, 0xA2, 0xA3, 0x29, 0x82, 0xCC, 0xBA, 0xBD, 0x83, 0x04, 0x1B,
+    0xA2, 0x83, 0x03, 0x41, 0xA1, 0xD6, 0x05, 0xF1, 0x1B, 0xC2, 0xB6, 0xF0,
+    0xA8, 0x7C, 0x86, 0x3B, 0x46, 0xA8, 0x48, 0x2A, 0x88, 0xDC, 0x76, 0x9A,
+    0x76, 0xBF, 0x1F, 0x6A, 0xA5, 0x3D, 0x19, 0x8F, 0xEB, 0x38, 0xF3, 0x64,
+    0xDE, 0xC8, 0x2B, 0x0D, 0x0A, 0x28, 0xFF, 0xF7, 0xDB, 0xE2, 0x15, 0x42,
+    0xD4, 0x22, 0xD0, 0x27, 0x5D, 0xE1, 0x79, 0xFE, 0x18, 0xE7, 0x70, 0x88,
+    0xAD, 0x4E, 0xE6, 0xD9, 0x8B, 0x3A, 0xC6, 0xDD, 0x27, 0x51, 0x6E, 0xFF,
+    0xBC, 0x64, 0xF5, 0x33, 0x43, 0x4F, 0x02, 0x03, 0x01, 0x00, 0x01, 0xA3,
+    0x42, 0x30, 0x40, 0x30, 0x0E, 0x06, 0x03, 0x55, 0x1D, 0x0F, 0x01, 0x01,
+    0xFF, 0x04, 0x04, 0x03, 0x02, 0x01, 0x06, 0x30, 0x0F, 0x06, 0x03, 0x55,
+    0x1D, 0x13, 0x01, 0x01, 0xFF, 0x04, 0x05, 0x30, 0x03, 0x01, 0x01, 0xFF,
+    0x30, 0x1D, 0x06, 0x03, 0x55, 0x1D, 0x0E, 0x04, 0x16, 0x04, 0x14, 0x79,
+    0xB4, 0x59, 0xE6, 0x7B, 0xB6, 0xE5, 0xE4, 0x01, 0x73, 0x80, 0x08, 0x88,
+    0xC8, 0x1A, 0x58, 0xF6, 0xE9, 0x9B, 0x6E, 0x30, 0x0D, 0x06, 0x09, 0x2A,
+    0x86, 0x48, 0x86, 0xF7, 0x0D, 0x01, 0x01, 0x0B, 0x05, 0x00, 0x03, 0x82,
+    0x02, 0x01, 0x00, 0x55, 0x1F, 0x58, 0xA9, 0xBC, 0xB2, 0xA8, 0x50, 0xD0,
+    0x0C, 0xB1, 0xD8, 0x1A, 0x69, 0x20, 0x27, 0x29, 0x08, 0xAC, 0x61, 0x75,
+    0x5C, 0x8A, 0x6E, 0xF8, 0x82, 0xE5, 0x69, 0x2F, 0xD5, 0xF6, 0x56, 0x4B,
+    0xB9, 0xB8, 0x73, 0x10, 0x59, 0xD3, 0x21, 0x97, 0x7E, 0xE7, 0x4C, 0x71,
+    0xFB, 0xB2, 0xD2, 0x60, 0xAD, 0x39, 0xA8, 0x0B, 0xEA, 0x17, 0x21, 0x56,
+    0x85, 0xF1, 0x50, 0x0E, 0x59, 0xEB, 0xCE, 0xE0, 0x59, 0xE9, 0xBA, 0xC9,
+    0x15, 0xEF, 0x86, 0x9D, 0x8F, 0x84, 0x80, 0xF6, 0xE4, 0xE9, 0x91, 0x90,
+    0xDC, 0x17, 0x9B, 0x62, 0x1B, 0x45, 0xF0, 0x66, 0x95, 0xD2, 0x7C, 0x6F,
+    0xC2, 0xEA, 0x3B, 0xEF, 0x1F, 0xCF, 0xCB, 0xD6, 0xAE, 0x27, 0xF1, 0xA9,
+    0xB0, 0xC8, 0xAE, 0xFD, 0x7D, 0x7E, 0x9A, 0xFA, 0x22, 0x04, 0xEB, 0xFF,
+    0xD9, 0x7F, 0xEA, 0x91, 0x2B, 0x22, 0xB1, 0x17, 0x0E, 0x8F, 0xF2, 0x8A,
+    0x34, 0x5B, 0x58, 0xD8, 0xFC, 0x01, 0xC9, 0x54, 0xB9, 0xB8, 0x26, 0xCC,
+    0x8A, 0x88, 0x33, 0x89, 0x4C, 0x2D, 0x84, 0x3C, 0x82, 0xDF, 0xEE, 0x96,
+    0x57, 0x05, 0xBA, 0x2C, 0xBB, 0xF7, 0xC4, 0xB7, 0xC7, 0x4E, 0x3B, 0x82,
+    0xBE, 0x31, 0xC8, 0x22, 0x73, 0x73, 0x92, 0xD1, 0xC2, 0x80, 0xA4, 0x39,
+    0x39, 0x10, 0x33, 0x23, 0x82, 0x4C, 0x3C, 0x9F, 0x86, 0xB2, 0x55, 0x98,
+    0x1D, 0xBE, 0x29, 0x86, 0x8C, 0x22, 0x9B, 0x9E, 0xE2, 0x6B, 0x3B, 0x57,
+    0x3A, 0x82, 0x70, 0x4D, 0xDC, 0x09, 0xC7, 0x89, 0xCB, 0x0A, 0x07, 0x4D,
+    0x6C, 0xE8, 0x5D, 0x8E, 0xC9, 0xEF, 0xCE, 0xAB, 0xC7, 0xBB, 0xB5, 0x2B,
+    0x4E, 0x45, 0xD6, 0x4A, 0xD0, 0x26, 0xCC, 0xE5, 0x72, 0xCA, 0x08, 0x6A,
+    0xA5, 0x95, 0xE3, 0x15, 0xA1, 0xF7, 0xA4, 0xED, 0xC9, 0x2C, 0x5F, 0xA5,
+    0xFB, 0xFF, 0xAC, 0x28, 0x02, 0x2E, 0xBE, 0xD7, 0x7B, 0xBB, 0xE3, 0x71,
+    0x7B, 0x90, 0x16, 0xD3, 0x07, 0x5E, 0x46, 0x53, 0x7C, 0x37, 0x07, 0x42,
+    0x8C, 0xD3, 0xC4, 0x96, 0x9C, 0xD5, 0x99, 0xB5, 0x2A, 0xE0, 0x95, 0x1A,
+    0x80, 0x48, 0xAE, 0x4C, 0x39, 0x07, 0xCE, 0xCC, 0x47, 0xA4, 0x52, 0x95,
+    0x2B, 0xBA, 0xB8, 0xFB, 0xAD, 0xD2, 0x33, 0x53, 0x7D, 0xE5, 0x1D, 0x4D,
+    0x6D, 0xD5, 0xA1, 0xB1, 0xC7, 0x42, 0x6F, 0xE6, 0x40, 0x27, 0x35, 0x5C,
+    0xA3, 0x28, 0xB7, 0x07, 0x8D, 0xE7, 0x8D, 0x33, 0x90, 0xE7, 0x23, 0x9F,
+    0xFB, 0x50, 0x9C, 0x79, 0x6C, 0x46, 0xD5, 0xB4, 0x15, 0xB3, 0x96, 0x6E,
+    0x7E, 0x9B, 0x0C, 0x96, 0x3A, 0xB8, 0x52, 0x2D, 0x3F, 0xD6, 0x5B, 0xE1,
+    0xFB, 0x08, 0xC2, 0x84, 0xFE, 0x24, 0xA8, 0xA3, 0x89, 0xDA, 0xAC, 0x6A,
+    0xE1, 0x18, 0x2A, 0xB1, 0xA8, 0x43, 0x61, 0x5B, 0xD3, 0x1F, 0xDC, 0x3B,
+    0x8D, 0x76, 0xF2, 0x2D, 0xE8, 0x8D, 0x75, 0xDF, 0x17, 0x33, 0x6C, 0x3D,
+    0x53, 0xFB, 0x7B, 0xCB, 0x41, 0x5F, 0xFF, 0xDC, 0xA2, 0xD0, 0x61, 0x38,
+    0xE1, 0x96, 0xB8, 0xAC, 0x5D, 0x8B, 0x37, 0xD7, 0x75, 0xD5, 0x33, 0xC0,
+    0x99, 0x11, 0xAE, 0x9D, 0x41, 0xC1, 0x72, 0x75, 0x84, 0xBE, 0x02, 0x41,
+    0x42, 0x5F, 0x67, 0x24, 0x48, 0x94, 0xD1, 0x9B, 0x27, 0xBE, 0x07, 0x3F,
+    0xB9, 0xB8, 0x4F, 0x81, 0x74, 0x51, 0xE1, 0x7A, 0xB7, 0xED, 0x9D, 0x23,
+    0xE2, 0xBE, 0xE0, 0xD5, 0x28, 0x04, 0x13, 0x3C, 0x31, 0x03, 0x9E, 0xDD,
+    0x7A, 0x6C, 0x8F, 0xC6, 0x07, 0x18, 0xC6, 0x7F, 0xDE, 0x47, 0x8E, 0x3F,
+    0x28, 0x9E, 0x04, 0x06, 0xCF, 0xA5, 0x54, 0x34, 0x77, 0xBD, 0xEC, 0x89,
+    0x9B, 0xE9, 0x17, 0x43, 0xDF, 0x5B, 0xDB, 0x5F, 0xFE, 0x8E, 0x1E, 0x57,
+    0xA2, 0xCD, 0x40, 0x9D, 0x7E, 0x62, 0x22, 0xDA, 0xDE, 0x18, 0x27,
+};
+static const int sizeof_cert_isrg_root_x1 = sizeof(cert_isrg_root_x1);
+
+static const unsigned char cert_isrg_root_x2[] =
+{
+    0x30, 0x82, 0x02, 0x1B, 0x30, 0x82, 0x01, 0xA1, 0xA0, 0x03, 0x02, 0x01,
+    0x02, 0x02, 0x10, 0x41, 0xD2, 0x9D, 0xD1, 0x72, 0xEA, 0xEE, 0xA7, 0x80,
+    0xC1, 0x2C, 0x6C, 0xE9, 0x2F, 0x87, 0x52, 0x30, 0x0A, 0x06, 0x08, 0x2A,
+    0x86, 0x48, 0xCE, 0x3D, 0x04, 0x03, 0x03, 0x30, 0x4F, 0x31, 0x0B, 0x30,
+    0x09, 0x06, 0x03, 0x55, 0x04, 0x06, 0x13, 0x02, 0x55, 0x53, 0x31, 0x29,
+    0x30, 0x27, 0x06, 0x03, 0x55, 0x04, 0x0A, 0x13, 0x20, 0x49, 0x6E, 0x74,
+    0x65, 0x72, 0x6E, 0x65, 0x74, 0x20, 0x53, 0x65, 0x63, 0x75, 0x72, 0x69,
+    0x74, 0x79, 0x20, 0x52, 0x65, 0x73, 0x65, 0x61, 0x72, 0x63, 0x68, 0x20,
+    0x47, 0x72, 0x6F, 0x75, 0x70, 0x31, 0x15, 0x30, 0x13, 0x06, 0x03, 0x55,
+    0x04, 0x03, 0x13, 0x0C, 0x49, 0x53, 0x52, 0x47, 0x20, 0x52, 0x6F, 0x6F,
+    0x74, 0x20, 0x58, 0x32, 0x30, 0x1E, 0x17, 0x0D, 0x32, 0x30, 0x30, 0x39,
+    0x30, 0x34, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x5A, 0x17, 0x0D, 0x34,
+    0x30, 0x30, 0x39, 0x31, 0x37, 0x31, 0x36, 0x30, 0x30, 0x30, 0x30, 0x5A,
+    0x30, 0x4F, 0x31, 0x0B, 0x30, 0x09, 0x06, 0x03, 0x55, 0x04, 0x06, 0x13,
+    0x02, 0x55, 0x53, 0x31, 0x29, 0x30, 0x27, 0x06, 0x03, 0x55, 0x04, 0x0A,
+    0x13, 0x20, 0x49, 0x6E, 0x74, 0x65, 0x72, 0x6E, 0x65, 0x74, 0x20, 0x53,
+    0x65, 0x63, 0x75, 0x72, 0x69, 0x74, 0x79, 0x20, 0x52, 0x65, 0x73, 0x65,
+    0x61, 0x72, 0x63, 0x68, 0x20, 0x47, 0x72, 0x6F, 0x75, 0x70, 0x31, 0x15,
+    0x30, 0x13, 0x06, 0x03, 0x55, 0x04, 0x03, 0x13, 0x0C, 0x49, 0x53, 0x52,
+    0x47, 0x20, 0x52, 0x6F, 0x6F, 0x74, 0x20, 0x58, 0x32, 0x30, 0x76, 0x30,
+    0x10, 0x06, 0x07, 0x2A, 0x86, 0x48, 0xCE, 0x3D, 0x02, 0x01, 0x06, 0x05,
+    0x2B, 0x81, 0x04, 0x00, 0x22, 0x03, 0x62, 0x00, 0x04, 0xCD, 0x9B, 0xD5,
+    0x9F, 0x80, 0x83, 0x0A, 0xEC, 0x09, 0x4A, 0xF3, 0x16, 0x4A, 0x3E, 0x5C,
+    0xCF, 0x77, 0xAC, 0xDE, 0x67, 0x05, 0x0D, 0x1D, 0x07, 0xB6, 0xDC, 0x16,
+    0xFB, 0x5A, 0x8B, 0x14, 0xDB, 0xE2, 0x71, 0x60, 0xC4, 0xBA, 0x45, 0x95,
+    0x11, 0x89, 0x8E, 0xEA, 0x06, 0xDF, 0xF7, 0x2A, 0x16, 0x1C, 0xA4, 0xB9,
+    0xC5, 0xC5, 0x32, 0xE0, 0x03, 0xE0, 0x1E, 0x82, 0x18, 0x38, 0x8B, 0xD7,
+    0x45, 0xD8, 0x0A, 0x6A, 0x6E, 0xE6, 0x00, 0x77, 0xFB, 0x02, 0x51, 0x7D,
+    0x22, 0xD8, 0x0A, 0x6E, 0x9A, 0x5B, 0x77, 0xDF, 0xF0, 0xFA, 0x41, 0xEC,
+    0x39, 0xDC, 0x75, 0xCA, 0x68, 0x07, 0x0C, 0x1F, 0xEA, 0xA3, 0x42, 0x30,
+    0x40, 0x30, 0x0E, 0x06, 0x03, 0x55, 0x1D, 0x0F, 0x01, 0x01, 0xFF, 0x04,
+    0x04, 0x03, 0x02, 0x01, 0x06, 0x30, 0x0F, 0x06, 0x03, 0x55, 0x1D, 0x13,
+    0x01, 0x01, 0xFF, 0x04, 0x05, 0x30, 0x03, 0x01, 0x01, 0xFF, 0x30, 0x1D,
+    0x06, 0x03, 0x55, 0x1D, 0x0E, 0x04, 0x16, 0x04, 0x14, 0x7C, 0x42, 0x96,
+    0xAE, 0xDE, 0x4B, 0x48, 0x3B, 0xFA, 0x92, 0xF8, 0x9E, 0x8C, 0xCF, 0x6D,
+    0x8B, 0xA9, 0x72, 0x37, 0x95, 0x30, 0x0A, 0x06, 0x08, 0x2A, 0x86, 0x48,
+    0xCE, 0x3D, 0x04, 0x03, 0x03, 0x03, 0x68, 0x00, 0x30, 0x65, 0x02, 0x30,
+    0x7B, 0x79, 0x4E, 0x46, 0x50, 0x84, 0xC2, 0x44, 0x87, 0x46, 0x1B, 0x45,
+    0x70, 0xFF, 0x58, 0x99, 0xDE, 0xF4, 0xFD, 0xA4, 0xD2, 0x55, 0xA6, 0x20,
+    0x2D, 0x74, 0xD6, 0x34, 0xBC, 0x41, 0xA3, 0x50, 0x5F, 0x01, 0x27, 0x56,
+    0xB4, 0xBE, 0x27, 0x75, 0x06, 0xAF, 0x12, 0x2E, 0x75, 0x98, 0x8D, 0xFC,
+    0x02, 0x31, 0x00, 0x8B, 0xF5, 0x77, 0x6C, 0xD4, 0xC8, 0x65, 0xAA, 0xE0,
+    0x0B, 0x2C, 0xEE, 0x14, 0x9D, 0x27, 0x37, 0xA4, 0xF9, 0x53, 0xA5, 0x51,
+    0xE4, 0x29, 0x83, 0xD7, 0xF8, 0x90, 0x31, 0x5B, 0x42, 0x9F, 0x0A, 0xF5,
+    0xFE, 0xAE, 0x00, 0x68, 0xE7, 0x8C, 0x49, 0x0F, 0xB6, 0x6F, 0x5B, 0x5B,
+    0x15, 0xF2, 0xE7,
+};
+static const int sizeof_cert_isrg_root_x2 = sizeof(cert_isrg_root_x2);
+
+static const unsigned char cert_digicert_global_root_g2[] =
+{
+    0x30, 0x82, 0x03, 0x8E, 0x30, 0x82, 0x02, 0x76, 0xA0, 0x03, 0x02, 0x01,
+    0x02, 0x02, 0x10, 0x03, 0x3A, 0xF1, 0xE6, 0xA7, 0x11, 0xA9, 0xA0, 0xBB,
+    0x28, 0x64, 0xB1, 0x1D, 0x09, 0xFA, 0xE5, 0x30, 0x0D, 0x06, 0x09, 0x2A,
+    0x86, 0x48, 0x86, 0xF7, 0x0D, 0x01, 0x01, 0x0B, 0x05, 0x00, 0x30, 0x61,
+    0x31, 0x0B, 0x30, 0x09, 0x06, 0x03, 0x55, 0x04, 0x06, 0x13, 0x02, 0x55,
+    0x53, 0x31, 0x15, 0x30, 0x13, 0x06, 0x03, 0x55, 0x04, 0x0A, 0x13, 0x0C,
+    0x44, 0x69, 0x67, 0x69, 0x43, 0x65, 0x72, 0x74, 0x20, 0x49, 0x6E, 0x63,
+    0x31, 0x19, 0x30, 0x17, 0x06, 0x03, 0x55, 0x04, 0x0B, 0x13, 0x10, 0x77,
+    0x77, 0x77, 0x2E, 0x64, 0x69, 0x67, 0x69, 0x63, 0x65, 0x72, 0x74, 0x2E,
+    0x63, 0x6F, 0x6D, 0x31, 0x20, 0x30, 0x1E, 0x06, 0x03, 0x55, 0x04, 0x03,
+    0x13, 0x17, 0x44, 0x69, 0x67, 0x69, 0x43, 0x65, 0x72, 0x74, 0x20, 0x47,
+    0x6C, 0x6F, 0x62, 0x61, 0x6C, 0x20, 0x52, 0x6F, 0x6F, 0x74, 0x20, 0x47,
+    0x32, 0x30, 0x1E, 0x17, 0x0D, 0x31, 0x33, 0x30, 0x38, 0x30, 0x31, 0x31,
+    0x32, 0x30, 0x30, 0x30, 0x30, 0x5A, 0x17, 0x0D, 0x33, 0x38, 0x30, 0x31,
+    0x31, 0x35, 0x31, 0x32, 0x30, 0x30, 0x30, 0x30, 0x5A, 0x30, 0x61, 0x31,
+    0x0B, 0x30, 0x09, 0x06, 0x03, 0x55, 0x04, 0x06, 0x13, 0x02, 0x55, 0x53,
+    0x31, 0x15, 0x30, 0x13, 0x06, 0x03, 0x55, 0x04, 0x0A, 0x13, 0x0C, 0x44,
+    0x69, 0x67, 0x69, 0x43, 0x65, 0x72, 0x74, 0x20, 0x49, 0x6E, 0x63, 0x31,
+    0x19, 0x30, 0x17, 0x06, 0x03, 0x55, 0x04, 0x0B, 0x13, 0x10, 0x77, 0x77,
+    0x77, 0x2E, 0x64, 0x69, 0x67, 0x69, 0x63, 0x65, 0x72, 0x74, 0x2E, 0x63,
+    0x6F, 0x6D, 0x31, 0x20, 0x30, 0x1E, 0x06, 0x03, 0x55, 0x04, 0x03, 0x13,
+    0x17, 0x44, 0x69, 0x67, 0x69, 0x43, 0x65, 0x72, 0x74, 0x20, 0x47, 0x6C,
+    0x6F, 0x62, 0x61, 0x6C, 0x20, 0x52, 0x6F, 0x6F, 0x74, 0x20, 0x47, 0x32,
+    0x30, 0x82, 0x01, 0x22, 0x30, 0x0D, 0x06, 0x09, 0x2A, 0x86, 0x48, 0x86,
+    0xF7, 0x0D, 0x01, 0x01, 0x01, 0x05, 0x00, 0x03, 0x82, 0x01, 0x0F, 0x00,
+    0x30, 0x82, 0x01, 0x0A, 0x02, 0x82, 0x01, 0x01, 0x00, 0xBB, 0x37, 0xCD,
+    0x34, 0xDC, 0x7B, 0x6B, 0xC9, 0xB2, 0x68, 0x90, 0xAD, 0x4A, 0x75, 0xFF,
+    0x46, 0xBA, 0x21, 0x0A, 0x08, 0x8D, 0xF5, 0x19, 0x54, 0xC9, 0xFB, 0x88,
+    0xDB, 0xF3, 0xAE, 0xF2, 0x3A, 0x89, 0x91, 0x3C, 0x7A, 0xE6, 0xAB, 0x06,
+    0x1A, 0x6B, 0xCF, 0xAC, 0x2D, 0xE8, 0x5E, 0x09, 0x24, 0x44, 0xBA, 0x62,
+    0x9A, 0x7E, 0xD6, 0xA3, 0xA8, 0x7E, 0xE0, 0x54, 0x75, 0x20, 0x05, 0xAC,
+    0x50, 0xB7, 0x9C, 0x63, 0x1A, 0x6C, 0x30, 0xDC, 0xDA, 0x1F, 0x19, 0xB1,
+    0xD7, 0x1E, 0xDE, 0xFD, 0xD7, 0xE0, 0xCB, 0x94, 0x83, 0x37, 0xAE, 0xEC,
+    0x1F, 0x43, 0x4E, 0xDD, 0x7B, 0x2C, 0xD2, 0xBD, 0x2E, 0xA5, 0x2F, 0xE4,
+    0xA9, 0xB8, 0xAD, 0x3A, 0xD4, 0x99, 0xA4, 0xB6, 0x25, 0xE9, 0x9B, 0x6B,
+    0x00, 0x60, 0x92, 0x60, 0xFF, 0x4F, 0x21, 0x49, 0x18, 0xF7, 0x67, 0x90,
+    0xAB, 0x61, 0x06, 0x9C, 0x8F, 0xF2, 0xBA, 0xE9, 0xB4, 0xE9, 0x92, 0x32,
+    0x6B, 0xB5, 0xF3, 0x57, 0xE8, 0x5D, 0x1B, 0xCD, 0x8C, 0x1D, 0xAB, 0x95,
+    0x04, 0x95, 0x49, 0xF3, 0x35, 0x2D, 0x96, 0xE3, 0x49, 0x6D, 0xDD, 0x77,
+    0xE3, 0xFB, 0x49, 0x4B, 0xB4, 0xAC, 0x55, 0x07, 0xA9, 0x8F, 0x95, 0xB3,
+    0xB4, 0x23, 0xBB, 0x4C, 0x6D, 0x45, 0xF0, 0xF6, 0xA9, 0xB2, 0x95, 0x30,
+    0xB4, 0xFD, 0x4C, 0x55, 0x8C, 0x27, 0x4A, 0x57, 0x14, 0x7C, 0x82, 0x9D,
+    0xCD, 0x73, 0x92, 0xD3, 0x16, 0x4A, 0x06, 0x0C, 0x8C, 0x50, 0xD1, 0x8F,
+    0x1E, 0x09, 0xBE, 0x17, 0xA1, 0xE6, 0x21, 0xCA, 0xFD, 0x83, 0xE5, 0x10,
+    0xBC, 0x83, 0xA5, 0x0A, 0xC4, 0x67, 0x28, 0xF6, 0x73, 0x14, 0x14, 0x3D,
+    0x46, 0x76, 0xC3, 0x87, 0x14, 0x89, 0x21, 0x34, 0x4D, 0xAF, 0x0F, 0x45,
+    0x0C, 0xA6, 0x49, 0xA1, 0xBA, 0xBB, 0x9C, 0xC5, 0xB1, 0x33, 0x83, 0x29,
+    0x85, 0x02, 0x03, 0x01, 0x00, 0x01, 0xA3, 0x42, 0x30, 0x40, 0x30, 0x0F,
+    0x06, 0x03, 0x55, 0x1D, 0x13, 0x01, 0x01, 0xFF, 0x04, 0x05, 0x30, 0x03,
+    0x01, 0x01, 0xFF, 0x30, 0x0E, 0x06, 0x03, 0x55, 0x1D, 0x0F, 0x01, 0x01,
+    0xFF, 0x04, 0x04, 0x03, 0x02, 0x01, 0x86, 0x30, 0x1D, 0x06, 0x03, 0x55,
+    0x1D, 0x0E, 0x04, 0x16, 0x04, 0x14, 0x4E, 0x22, 0x54, 0x20, 0x18, 0x95,
+    0xE6, 0xE3, 0x6E, 0xE6, 0x0F, 0xFA, 0xFA, 0xB9, 0x12, 0xED, 0x06, 0x17,
+    0x8F, 0x39, 0x30, 0x0D, 0x06, 0x09, 0x2A, 0x86, 0x48, 0x86, 0xF7, 0x0D,
+    0x01, 0x01, 0x0B, 0x05, 0x00, 0x03, 0x82, 0x01, 0x01, 0x00, 0x60, 0x67,
+    0x28, 0x94, 0x6F, 0x0E, 0x48, 0x63, 0xEB, 0x31, 0xDD, 0xEA, 0x67, 0x18,
+    0xD5, 0x89, 0x7D, 0x3C, 0xC5, 0x8B, 0x4A, 0x7F, 0xE9, 0xBE, 0xDB, 0x2B,
+    0x17, 0xDF, 0xB0, 0x5F, 0x73, 0x77, 0x2A, 0x32, 0x13, 0x39, 0x81, 0x67,
+    0x42, 0x84, 0x23, 0xF2, 0x45, 0x67, 0x35, 0xEC, 0x88, 0xBF, 0xF8, 0x8F,
+    0xB0, 0x61, 0x0C, 0x34, 0xA4, 0xAE, 0x20, 0x4C, 0x84, 0xC6, 0xDB, 0xF8,
+    0x35, 0xE1, 0x76, 0xD9, 0xDF, 0xA6, 0x42, 0xBB, 0xC7, 0x44, 0x08, 0x86,
+    0x7F, 0x36, 0x74, 0x24, 0x5A, 0xDA, 0x6C, 0x0D, 0x14, 0x59, 0x35, 0xBD,
+    0xF2, 0x49, 0xDD, 0xB6, 0x1F, 0xC9, 0xB3, 0x0D, 0x47, 0x2A, 0x3D, 0x99,
+    0x2F, 0xBB, 0x5C, 0xBB, 0xB5, 0xD4, 0x20, 0xE1, 0x99, 0x5F, 0x53, 0x46,
+    0x15, 0xDB, 0x68, 0x9B, 0xF0, 0xF3, 0x30, 0xD5, 0x3E, 0x31, 0xE2, 0x8D,
+    0x84, 0x9E, 0xE3, 0x8A, 0xDA, 0xDA, 0x96, 0x3E, 0x35, 0x13, 0xA5, 0x5F,
+    0xF0, 0xF9, 0x70, 0x50, 0x70, 0x47, 0x41, 0x11, 0x57, 0x19, 0x4E, 0xC0,
+    0x8F, 0xAE, 0x06, 0xC4, 0x95, 0x13, 0x17, 0x2F, 0x1B, 0x25, 0x9F, 0x75,
+    0xF2, 0xB1, 0x8E, 0x99, 0xA1, 0x6F, 0x13, 0xB1, 0x41, 0x71, 0xFE, 0x88,
+    0x2A, 0xC8, 0x4F, 0x10, 0x20, 0x55, 0xD7, 0xF3, 0x14, 0x45, 0xE5, 0xE0,
+    0x44, 0xF4, 0xEA, 0x87, 0x95, 0x32, 0x93, 0x0E, 0xFE, 0x53, 0x46, 0xFA,
+    0x2C, 0x9D, 0xFF, 0x8B, 0x22, 0xB9, 0x4B, 0xD9, 0x09, 0x45, 0xA4, 0xDE,
+    0xA4, 0xB8, 0x9A, 0x58, 0xDD, 0x1B, 0x7D, 0x52, 0x9F, 0x8E, 0x59, 0x43,
+    0x88, 0x81, 0xA4, 0x9E, 0x26, 0xD5, 0x6F, 0xAD, 0xDD, 0x0D, 0xC6, 0x37,
+    0x7D, 0xED, 0x03, 0x92, 0x1B, 0xE5, 0x77, 0x5F, 0x76, 0xEE, 0x3C, 0x8D,
+    0xC4, 0x5D, 0x56, 0x5B, 0xA2, 0xD9, 0x66, 0x6E, 0xB3, 0x35, 0x37, 0xE5,
+    0x32, 0xB6,
+};
+static const int sizeof_cert_digicert_global_root_g2 = sizeof(cert_digicert_global_root_g2);
+
+static const unsigned char cert_amazon_root_ca_3[] =
+{
+    0x30, 0x82, 0x01, 0xB6, 0x30, 0x82, 0x01, 0x5B, 0xA0, 0x03, 0x02, 0x01,
+    0x02, 0x02, 0x13, 0x06, 0x6C, 0x9F, 0xD5, 0x74, 0x97, 0x36, 0x66, 0x3F,
+    0x3B, 0x0B, 0x9A, 0xD9, 0xE8, 0x9E, 0x76, 0x03, 0xF2, 0x4A, 0x30, 0x0A,
+    0x06, 0x08, 0x2A, 0x86, 0x48, 0xCE, 0x3D, 0x04, 0x03, 0x02, 0x30, 0x39,
+    0x31, 0x0B, 0x30, 0x09, 0x06, 0x03, 0x55, 0x04, 0x06, 0x13, 0x02, 0x55,
+    0x53, 0x31, 0x0F, 0x30, 0x0D, 0x06, 0x03, 0x55, 0x04, 0x0A, 0x13, 0x06,
+    0x41, 0x6D, 0x61, 0x7A, 0x6F, 0x6E, 0x31, 0x19, 0x30, 0x17, 0x06, 0x03,
+    0x55, 0x04, 0x03, 0x13, 0x10, 0x41, 0x6D, 0x61, 0x7A, 0x6F, 0x6E, 0x20,
+    0x52, 0x6F, 0x6F, 0x74, 0x20, 0x43, 0x41, 0x20, 0x33, 0x30, 0x1E, 0x17,
+    0x0D, 0x31, 0x35, 0x30, 0x35, 0x32, 0x36, 0x30, 0x30, 0x30, 0x30, 0x30,
+    0x30, 0x5A, 0x17, 0x0D, 0x34, 0x30, 0x30, 0x35, 0x32, 0x36, 0x30, 0x30,
+    0x30, 0x30, 0x30, 0x30, 0x5A, 0x30, 0x39, 0x31, 0x0B, 0x30, 0x09, 0x06,
+    0x03, 0x55, 0x04, 0x06, 0x13, 0x02, 0x55, 0x53, 0x31, 0x0F, 0x30, 0x0D,
+    0x06, 0x03, 0x55, 0x04, 0x0A, 0x13, 0x06, 0x41, 0x6D, 0x61, 0x7A, 0x6F,
+    0x6E, 0x31, 0x19, 0x30, 0x17, 0x06, 0x03, 0x55, 0x04, 0x03, 0x13, 0x10,
+    0x41, 0x6D, 0x61, 0x7A, 0x6F, 0x6E, 0x20, 0x52, 0x6F, 0x6F, 0x74, 0x20,
+    0x43, 0x41, 0x20, 0x33, 0x30, 0x59, 0x30, 0x13, 0x06, 0x07, 0x2A, 0x86,
+    0x48, 0xCE, 0x3D, 0x02, 0x01, 0x06, 0x08, 0x2A, 0x86, 0x48, 0xCE, 0x3D,
+    0x03, 0x01, 0x07, 0x03, 0x42, 0x00, 0x04, 0x29, 0x97, 0xA7, 0xC6, 0x41,
+    0x7F, 0xC0, 0x0D, 0x9B, 0xE8, 0x01, 0x1B, 0x56, 0xC6, 0xF2, 0x52, 0xA5,
+    0xBA, 0x2D, 0xB2, 0x12, 0xE8, 0xD2, 0x2E, 0xD7, 0xFA, 0xC9, 0xC5, 0xD8,
+    0xAA, 0x6D, 0x1F, 0x73, 0x81, 0x3B, 0x3B, 0x98, 0x6B, 0x39, 0x7C, 0x33,
+    0xA5, 0xC5, 0x4E, 0x86, 0x8E, 0x80, 0x17, 0x68, 0x62, 0x45, 0x57, 0x7D,
+    0x44, 0x58, 0x1D, 0xB3, 0x37, 0xE5, 0x67, 0x08, 0xEB, 0x66, 0xDE, 0xA3,
+    0x42, 0x30, 0x40, 0x30, 0x0F, 0x06, 0x03, 0x55, 0x1D, 0x13, 0x01, 0x01,
+    0xFF, 0x04, 0x05, 0x30, 0x03, 0x01, 0x01, 0xFF, 0x30, 0x0E, 0x06, 0x03,
+    0x55, 0x1D, 0x0F, 0x01, 0x01, 0xFF, 0x04, 0x04, 0x03, 0x02, 0x01, 0x86,
+    0x30, 0x1D, 0x06, 0x03, 0x55, 0x1D, 0x0E, 0x04, 0x16, 0x04, 0x14, 0xAB,
+    0xB6, 0xDB, 0xD7, 0x06, 0x9E, 0x37, 0xAC, 0x30, 0x86, 0x07, 0x91, 0x70,
+    0xC7, 0x9C, 0xC4, 0x19, 0xB1, 0x78, 0xC0, 0x30, 0x0A, 0x06, 0x08, 0x2A,
+    0x86, 0x48, 0xCE, 0x3D, 0x04, 0x03, 0x02, 0x03, 0x49, 0x00, 0x30, 0x46,
+    0x02, 0x21, 0x00, 0xE0, 0x85, 0x92, 0xA3, 0x17, 0xB7, 0x8D, 0xF9, 0x2B,
+    0x06, 0xA5, 0x93, 0xAC, 0x1A, 0x98, 0x68, 0x61, 0x72, 0xFA, 0xE1, 0xA1,
+    0xD0, 0xFB, 0x1C, 0x78, 0x60, 0xA6, 0x43, 0x99, 0xC5, 0xB8, 0xC4, 0x02,
+    0x21, 0x00, 0x9C, 0x02, 0xEF, 0xF1, 0x94, 0x9C, 0xB3, 0x96, 0xF9, 0xEB,
+    0xC6, 0x2A, 0xF8, 0xB6, 0x2C, 0xFE, 0x3A, 0x90, 0x14, 0x16, 0xD7, 0x8C,
+    0x63, 0x24, 0x48, 0x1C, 0xDF, 0x30, 0x7D, 0xD5, 0x68, 0x3B,
+};
+static const int sizeof_cert_amazon_root_ca_3 = sizeof(cert_amazon_root_ca_3);
+
+#endif /* _CERT_CORPUS_H_ */
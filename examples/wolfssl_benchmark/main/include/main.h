@@ -22,9 +22,74 @@
 #ifndef _MAIN_
 #define _MAIN_
 
+#include <stdint.h>
+
 void app_main(void);
 
 /* see wolfssl/wolfcrypt/benchmark/benchmark.h */
 extern void wolf_benchmark_task();
 
+/* see bench_rsa_sign.c */
+int bench_rsa_sign_profile(void);
+
+/* see bench_soak.c; duration_s 0 runs forever */
+int bench_soak_run(uint32_t duration_s, uint32_t interval_s);
+
+/* see bench_dtls.c */
+int bench_dtls_compare(void);
+
+/* see bench_ocsp.c */
+int bench_ocsp_compare(void);
+
+/* see bench_crl.c */
+int bench_crl_compare(void);
+
+/* see bench_pq.c */
+int bench_pq_compare(void);
+
+/* see bench_ota.c */
+int bench_ota_verify(void);
+
+/* see bench_pkcs7.c */
+int bench_pkcs7_stream(void);
+
+/* see bench_cert.c */
+int bench_cert_parse(void);
+
+/* see bench_rpk.c */
+int bench_rpk_compare(void);
+
+/* see bench_bufpool.c */
+int bench_bufpool_compare(void);
+
+/* see bench_ticket.c */
+int bench_ticket(void);
+
+/* see bench_rng.c */
+int bench_rng(void);
+
+/* see bench_keypool.c */
+int bench_keypool_compare(void);
+
+/* see bench_nonblock.c */
+int bench_nonblock(void);
+
+/* see bench_ctx_cache.c */
+int bench_ctx_cache_compare(void);
+
+/* see bench_hw_order.c */
+int bench_hw_order(void);
+
+/* see bench_locks.c */
+int bench_locks(void);
+
+/* see bench_arena.c */
+int bench_arena(void);
+
+/* see bench_hmac.c */
+int bench_hmac(void);
+
+/* see bench_ecc_hw.c */
+int bench_ecc_hw(void);
+
 #endif
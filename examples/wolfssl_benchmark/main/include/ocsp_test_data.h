@@ -0,0 +1,208 @@
+/* ocsp_test_data.h
+ *
+ * Copyright (C) 2006-2024 wolfSSL Inc.
+ *
+ * This file is part of wolfSSL.
+ *
+ * wolfSSL is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfSSL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335, USA
+ */
+
+/* P-256 test PKI for the OCSP benchmark, valid until October 2036:
+ *
+ *   ocsp_ca_der          CA, signs the server certificate and the response
+ *   ocsp_ca_key_der      its private key, also signs the CRLs of bench_crl.c
+ *   ocsp_server_cert_der CN=localhost, serial 0x1001, OCSP responder URL
+ *                        http://127.0.0.1:22220 (never contacted)
+ *   ocsp_server_key_der  its private key, also signs the bundles of
+ *                        bench_pkcs7.c
+ *   ocsp_response_der    "good" for the server certificate, signed by the CA,
+ *                        nextUpdate 2036-10-16
+ *
+ * Made with OpenSSL:
+ *   openssl req -x509 -new -key ca.key -sha256 -days 7300 -out ca.pem \
+ *       -addext "basicConstraints=critical,CA:TRUE"
+ *   openssl x509 -req -in srv.csr -CA ca.pem -CAkey ca.key -set_serial 0x1001 \
+ *       -days 7300 -extfile ext.cnf -out srv.pem
+ *       (ext.cnf: authorityInfoAccess=OCSP;URI:http://127.0.0.1:22220)
+ *   openssl ocsp -issuer ca.pem -cert srv.pem -no_nonce -reqout req.der
+ *   openssl ocsp -index index.txt -rsigner ca.pem -rkey ca.key -CA ca.pem \
+ *       -reqin req.der -respout resp.der -ndays 3650 -rmd sha256 -resp_no_certs
+ */
+
+#ifndef _OCSP_TEST_DATA_H_
+#define _OCSP_TEST_DATA_H_
+
+static const unsigned char ocsp_ca_der[] =
+{
+    0x30, 0x82, 0x01, 0xE9, 0x30, 0x82, 0x01, 0x8F, 0xA0, 0x03, 0x02, 0x01,
+    0x02, 0x02, 0x14, 0x50, 0x7C, 0x51, 0x08, 0x81, 0x41, 0xC6, 0x84, 0x47,
+    0x34, 0xA4, 0x5A, 0x86, 0xA9, 0xF2, 0xAA, 0x24, 0x7D, 0x6F, 0x38, 0x30,
+    0x0A, 0x06, 0x08, 0x2A, 0x86, 0x48, 0xCE, 0x3D, 0x04, 0x03, 0x02, 0x30,
+    0x42, 0x31, 0x0B, 0x30, 0x09, 0x06, 0x03, 0x55, 0x04, 0x06, 0x13, 0x02,
+    0x55, 0x53, 0x31, 0x10, 0x30, 0x0E, 0x06, 0x03, 0x55, 0x04, 0x0A, 0x0C,
+    0x07, 0x77, 0x6F, 0x6C, 0x66, 0x53, 0x53, 0x4C, 0x31, 0x21, 0x30, 0x1F,
+    0x06, 0x03, 0x55, 0x04, 0x03, 0x0C, 0x18, 0x65, 0x73, 0x70, 0x2D, 0x77,
+    0x6F, 0x6C, 0x66, 0x73, 0x73, 0x6C, 0x20, 0x4F, 0x43, 0x53, 0x50, 0x20,
+    0x74, 0x65, 0x73, 0x74, 0x20, 0x43, 0x41, 0x30, 0x1E, 0x17, 0x0D, 0x32,
+    0x36, 0x31, 0x30, 0x31, 0x39, 0x30, 0x39, 0x31, 0x38, 0x31, 0x38, 0x5A,
+    0x17, 0x0D, 0x34, 0x36, 0x31, 0x30, 0x31, 0x34, 0x30, 0x39, 0x31, 0x38,
+    0x31, 0x38, 0x5A, 0x30, 0x42, 0x31, 0x0B, 0x30, 0x09, 0x06, 0x03, 0x55,
+    0x04, 0x06, 0x13, 0x02, 0x55, 0x53, 0x31, 0x10, 0x30, 0x0E, 0x06, 0x03,
+    0x55, 0x04, 0x0A, 0x0C, 0x07, 0x77, 0x6F, 0x6C, 0x66, 0x53, 0x53, 0x4C,
+    0x31, 0x21, 0x30, 0x1F, 0x06, 0x03, 0x55, 0x04, 0x03, 0x0C, 0x18, 0x65,
+    0x73, 0x70, 0x2D, 0x77, 0x6F, 0x6C, 0x66, 0x73, 0x73, 0x6C, 0x20, 0x4F,
+    0x43, 0x53, 0x50, 0x20, 0x74, 0x65, 0x73, 0x74, 0x20, 0x43, 0x41, 0x30,
+    0x59, 0x30, 0x13, 0x06, 0x07, 0x2A, 0x86, 0x48, 0xCE, 0x3D, 0x02, 0x01,
+    0x06, 0x08, 0x2A, 0x86, 0x48, 0xCE, 0x3D, 0x03, 0x01, 0x07, 0x03, 0x42,
+    0x00, 0x04, 0x13, 0x93, 0xDF, 0x65, 0x23, 0xB9, 0x34, 0x16, 0xF9, 0x82,
+    0xE5, 0x59, 0x27, 0x0C, 0x00, 0x60, 0xF6, 0xA9, 0x7A, 0x8F, 0x48, 0xCA,
+    0x72, 0x5F, 0x2F, 0x69, 0xF3, 0x16, 0x2D, 0x83, 0xA2, 0x93, 0xB1, 0x7F,
+    0xF3, 0xB9, 0x49, 0x20, 0xB9, 0x8F, 0x31, 0x72, 0xFC, 0x09, 0x73, 0xC2,
+    0xCF, 0x7B, 0xD4, 0xA0, 0xBC, 0x78, 0xD3, 0x92, 0xAF, 0xB3, 0xC3, 0x7E,
+    0x67, 0x0F, 0xDE, 0xA8, 0xD3, 0x17, 0xA3, 0x63, 0x30, 0x61, 0x30, 0x1D,
+    0x06, 0x03, 0x55, 0x1D, 0x0E, 0x04, 0x16, 0x04, 0x14, 0xE0, 0x59, 0x16,
+    0x7A, 0xC1, 0x7D, 0x57, 0xB5, 0x92, 0x05, 0x8F, 0xEA, 0x30, 0xB9, 0x0E,
+    0xEA, 0xFF, 0x24, 0x95, 0xD1, 0x30, 0x1F, 0x06, 0x03, 0x55, 0x1D, 0x23,
+    0x04, 0x18, 0x30, 0x16, 0x80, 0x14, 0xE0, 0x59, 0x16, 0x7A, 0xC1, 0x7D,
+    0x57, 0xB5, 0x92, 0x05, 0x8F, 0xEA, 0x30, 0xB9, 0x0E, 0xEA, 0xFF, 0x24,
+    0x95, 0xD1, 0x30, 0x0F, 0x06, 0x03, 0x55, 0x1D, 0x13, 0x01, 0x01, 0xFF,
+    0x04, 0x05, 0x30, 0x03, 0x01, 0x01, 0xFF, 0x30, 0x0E, 0x06, 0x03, 0x55,
+    0x1D, 0x0F, 0x01, 0x01, 0xFF, 0x04, 0x04, 0x03, 0x02, 0x01, 0x86, 0x30,
+    0x0A, 0x06, 0x08, 0x2A, 0x86, 0x48, 0xCE, 0x3D, 0x04, 0x03, 0x02, 0x03,
+    0x48, 0x00, 0x30, 0x45, 0x02, 0x21, 0x00, 0x8E, 0x51, 0x78, 0x46, 0x89,
+    0xAC, 0x87, 0xA0, 0xAD, 0x5F, 0xC7, 0xD0, 0xF9, 0x7E, 0x96, 0x1F, 0xF0,
+    0xA7, 0x23, 0xFE, 0x53, 0x8D, 0x7F, 0xD7, 0x73, 0xCA, 0x40, 0xA5, 0x5B,
+    0x7C, 0x25, 0x19, 0x02, 0x20, 0x36, 0x71, 0xFA, 0x51, 0x3F, 0x74, 0x50,
+    0x85, 0xE5, 0xC2, 0x69, 0x39, 0x2E, 0xA9, 0x1C, 0x91, 0xC6, 0xD6, 0x49,
+    0x8D, 0xEF, 0x2B, 0x0C, 0x0B, 0x7C, 0xF6, 0x97, 0x55, 0x56, 0xEE, 0xA8,
+    0xC5,
+};
+static const int sizeof_ocsp_ca_der = sizeof(ocsp_ca_der);
+
+static const unsigned char ocsp_ca_key_der[] =
+{
+    0x30, 0x77, 0x02, 0x01, 0x01, 0x04, 0x20, 0xCF, 0xC0, 0x6B, 0x3B, 0x81,
+    0xC9, 0x25, 0x9F, 0x22, 0x64, 0x92, 0xC0, 0x2E, 0x17, 0x4C, 0xEE, 0xF8,
+    0xD6, 0x75, 0x50, 0xAA, 0x72, 0x7E, 0x5C, 0x41, 0xD5, 0x7D, 0xE4, 0xC5,
+    0x2D, 0x33, 0xF8, 0xA0, 0x0A, 0x06, 0x08, 0x2A, 0x86, 0x48, 0xCE, 0x3D,
+    0x03, 0x01, 0x07, 0xA1, 0x44, 0x03, 0x42, 0x00, 0x04, 0x13, 0x93, 0xDF,
+    0x65, 0x23, 0xB9, 0x34, 0x16, 0xF9, 0x82, 0xE5, 0x59, 0x27, 0x0C, 0x00,
+    0x60, 0xF6, 0xA9, 0x7A, 0x8F, 0x48, 0xCA, 0x72, 0x5F, 0x2F, 0x69, 0xF3,
+    0x16, 0x2D, 0x83, 0xA2, 0x93, 0xB1, 0x7F, 0xF3, 0xB9, 0x49, 0x20, 0xB9,
+    0x8F, 0x31, 0x72, 0xFC, 0x09, 0x73, 0xC2, 0xCF, 0x7B, 0xD4, 0xA0, 0xBC,
+    0x78, 0xD3, 0x92, 0xAF, 0xB3, 0xC3, 0x7E, 0x67, 0x0F, 0xDE, 0xA8, 0xD3,
+    0x17,
+};
+static const int sizeof_ocsp_ca_key_der = sizeof(ocsp_ca_key_der);
+
+static const unsigned char ocsp_server_cert_der[] =
+{
+    0x30, 0x82, 0x02, 0x23, 0x30, 0x82, 0x01, 0xC9, 0xA0, 0x03, 0x02, 0x01,
+    0x02, 0x02, 0x02, 0x10, 0x01, 0x30, 0x0A, 0x06, 0x08, 0x2A, 0x86, 0x48,
+    0xCE, 0x3D, 0x04, 0x03, 0x02, 0x30, 0x42, 0x31, 0x0B, 0x30, 0x09, 0x06,
+    0x03, 0x55, 0x04, 0x06, 0x13, 0x02, 0x55, 0x53, 0x31, 0x10, 0x30, 0x0E,
+    0x06, 0x03, 0x55, 0x04, 0x0A, 0x0C, 0x07, 0x77, 0x6F, 0x6C, 0x66, 0x53,
+    0x53, 0x4C, 0x31, 0x21, 0x30, 0x1F, 0x06, 0x03, 0x55, 0x04, 0x03, 0x0C,
+    0x18, 0x65, 0x73, 0x70, 0x2D, 0x77, 0x6F, 0x6C, 0x66, 0x73, 0x73, 0x6C,
+    0x20, 0x4F, 0x43, 0x53, 0x50, 0x20, 0x74, 0x65, 0x73, 0x74, 0x20, 0x43,
+    0x41, 0x30, 0x1E, 0x17, 0x0D, 0x32, 0x36, 0x31, 0x30, 0x31, 0x39, 0x30,
+    0x39, 0x31, 0x38, 0x31, 0x38, 0x5A, 0x17, 0x0D, 0x34, 0x36, 0x31, 0x30,
+    0x31, 0x34, 0x30, 0x39, 0x31, 0x38, 0x31, 0x38, 0x5A, 0x30, 0x33, 0x31,
+    0x0B, 0x30, 0x09, 0x06, 0x03, 0x55, 0x04, 0x06, 0x13, 0x02, 0x55, 0x53,
+    0x31, 0x10, 0x30, 0x0E, 0x06, 0x03, 0x55, 0x04, 0x0A, 0x0C, 0x07, 0x77,
+    0x6F, 0x6C, 0x66, 0x53, 0x53, 0x4C, 0x31, 0x12, 0x30, 0x10, 0x06, 0x03,
+    0x55, 0x04, 0x03, 0x0C, 0x09, 0x6C, 0x6F, 0x63, 0x61, 0x6C, 0x68, 0x6F,
+    0x73, 0x74, 0x30, 0x59, 0x30, 0x13, 0x06, 0x07, 0x2A, 0x86, 0x48, 0xCE,
+    0x3D, 0x02, 0x01, 0x06, 0x08, 0x2A, 0x86, 0x48, 0xCE, 0x3D, 0x03, 0x01,
+    0x07, 0x03, 0x42, 0x00, 0x04, 0x18, 0xE2, 0xFF, 0x91, 0x36, 0x3A, 0xEA,
+    0x83, 0x57, 0x8C, 0x20, 0x2D, 0x1D, 0x29, 0x8B, 0x9F, 0xC1, 0x3E, 0xF5,
+    0x0E, 0xDA, 0xE7, 0x18, 0x2A, 0xF7, 0xF5, 0xB8, 0x8F, 0xA6, 0x51, 0xD2,
+    0x92, 0x41, 0x85, 0xDE, 0x66, 0xAA, 0x0B, 0x6D, 0xDE, 0x77, 0x0E, 0x14,
+    0x97, 0xC7, 0x4C, 0x38, 0x56, 0x0C, 0x2D, 0x3E, 0xCF, 0x0D, 0x1D, 0xED,
+    0x2F, 0x37, 0x27, 0x64, 0xA8, 0xE6, 0x5C, 0x8F, 0xA4, 0xA3, 0x81, 0xBD,
+    0x30, 0x81, 0xBA, 0x30, 0x09, 0x06, 0x03, 0x55, 0x1D, 0x13, 0x04, 0x02,
+    0x30, 0x00, 0x30, 0x0E, 0x06, 0x03, 0x55, 0x1D, 0x0F, 0x01, 0x01, 0xFF,
+    0x04, 0x04, 0x03, 0x02, 0x07, 0x80, 0x30, 0x13, 0x06, 0x03, 0x55, 0x1D,
+    0x25, 0x04, 0x0C, 0x30, 0x0A, 0x06, 0x08, 0x2B, 0x06, 0x01, 0x05, 0x05,
+    0x07, 0x03, 0x01, 0x30, 0x14, 0x06, 0x03, 0x55, 0x1D, 0x11, 0x04, 0x0D,
+    0x30, 0x0B, 0x82, 0x09, 0x6C, 0x6F, 0x63, 0x61, 0x6C, 0x68, 0x6F, 0x73,
+    0x74, 0x30, 0x32, 0x06, 0x08, 0x2B, 0x06, 0x01, 0x05, 0x05, 0x07, 0x01,
+    0x01, 0x04, 0x26, 0x30, 0x24, 0x30, 0x22, 0x06, 0x08, 0x2B, 0x06, 0x01,
+    0x05, 0x05, 0x07, 0x30, 0x01, 0x86, 0x16, 0x68, 0x74, 0x74, 0x70, 0x3A,
+    0x2F, 0x2F, 0x31, 0x32, 0x37, 0x2E, 0x30, 0x2E, 0x30, 0x2E, 0x31, 0x3A,
+    0x32, 0x32, 0x32, 0x32, 0x30, 0x30, 0x1D, 0x06, 0x03, 0x55, 0x1D, 0x0E,
+    0x04, 0x16, 0x04, 0x14, 0xE0, 0xF9, 0xF5, 0xC1, 0x5E, 0x7A, 0x26, 0x75,
+    0xCD, 0x80, 0x43, 0xD8, 0x5D, 0x98, 0x23, 0x80, 0x08, 0x92, 0xDD, 0x37,
+    0x30, 0x1F, 0x06, 0x03, 0x55, 0x1D, 0x23, 0x04, 0x18, 0x30, 0x16, 0x80,
+    0x14, 0xE0, 0x59, 0x16, 0x7A, 0xC1, 0x7D, 0x57, 0xB5, 0x92, 0x05, 0x8F,
+    0xEA, 0x30, 0xB9, 0x0E, 0xEA, 0xFF, 0x24, 0x95, 0xD1, 0x30, 0x0A, 0x06,
+    0x08, 0x2A, 0x86, 0x48, 0xCE, 0x3D, 0x04, 0x03, 0x02, 0x03, 0x48, 0x00,
+    0x30, 0x45, 0x02, 0x21, 0x00, 0xED, 0xCB, 0x9B, 0x14, 0x9D, 0xD9, 0x4D,
+    0x0B, 0xE6, 0x59, 0xB0, 0x89, 0x1A, 0xFC, 0x9B, 0x19, 0xBE, 0x29, 0x83,
+    0xFF, 0x13, 0x96, 0xA3, 0xAE, 0x2A, 0x5F, 0x20, 0x47, 0xC2, 0x9D, 0x65,
+    0xF0, 0x02, 0x20, 0x06, 0x7C, 0xD4, 0xFC, 0xC9, 0x2D, 0x29, 0x90, 0xA1,
+    0x88, 0xA8, 0x92, 0xEC, 0x90, 0xE6, 0xF7, 0x95, 0x59, 0x09, 0xD8, 0x33,
+    0x40, 0x44, 0xA2, 0x56, 0x10, 0xAE, 0x5A, 0x3A, 0xE1, 0xD5, 0xB8,
+};
+static const int sizeof_ocsp_server_cert_der = sizeof(ocsp_server_cert_der);
+
+static const unsigned char ocsp_server_key_der[] =
+{
+    0x30, 0x77, 0x02, 0x01, 0x01, 0x04, 0x20, 0xBA, 0x69, 0x09, 0x10, 0xFB,
+    0x1C, 0xCF, 0x7E, 0x71, 0x06, 0xBB, 0x98, 0x6F, 0xD1, 0xEC, 0x3C, 0xCD,
+    0xD4, 0x10, 0x0E, 0x2E, 0xA7, 0x8B, 0x1E, 0xFD, 0xC5, 0x95, 0x2A, 0x8C,
+    0x71, 0xA6, 0x05, 0xA0, 0x0A, 0x06, 0x08, 0x2A, 0x86, 0x48, 0xCE, 0x3D,
+    0x03, 0x01, 0x07, 0xA1, 0x44, 0x03, 0x42, 0x00, 0x04, 0x18, 0xE2, 0xFF,
+    0x91, 0x36, 0x3A, 0xEA, 0x83, 0x57, 0x8C, 0x20, 0x2D, 0x1D, 0x29, 0x8B,
+    0x9F, 0xC1, 0x3E, 0xF5, 0x0E, 0xDA, 0xE7, 0x18, 0x2A, 0xF7, 0xF5, 0xB8,
+    0x8F, 0xA6, 0x51, 0xD2, 0x92, 0x41, 0x85, 0xDE, 0x66, 0xAA, 0x0B, 0x6D,
+    0xDE, 0x77, 0x0E, 0x14, 0x97, 0xC7, 0x4C, 0x38, 0x56, 0x0C, 0x2D, 0x3E,
+    0xCF, 0x0D, 0x1D, 0xED, 0x2F, 0x37, 0x27, 0x64, 0xA8, 0xE6, 0x5C, 0x8F,
+    0xA4,
+};
+static const int sizeof_ocsp_server_key_der = sizeof(ocsp_server_key_der);
+
+static const unsigned char ocsp_response_der[] =
+{
+    0x30, 0x82, 0x01, 0x34, 0x0A, 0x01, 0x00, 0xA0, 0x82, 0x01, 0x2D, 0x30,
+    0x82, 0x01, 0x29, 0x06, 0x09, 0x2B, 0x06, 0x01, 0x05, 0x05, 0x07, 0x30,
+    0x01, 0x01, 0x04, 0x82, 0x01, 0x1A, 0x30, 0x82, 0x01, 0x16, 0x30, 0x81,
+    0xBE, 0xA1, 0x44, 0x30, 0x42, 0x31, 0x0B, 0x30, 0x09, 0x06, 0x03, 0x55,
+    0x04, 0x06, 0x13, 0x02, 0x55, 0x53, 0x31, 0x10, 0x30, 0x0E, 0x06, 0x03,
+    0x55, 0x04, 0x0A, 0x0C, 0x07, 0x77, 0x6F, 0x6C, 0x66, 0x53, 0x53, 0x4C,
+    0x31, 0x21, 0x30, 0x1F, 0x06, 0x03, 0x55, 0x04, 0x03, 0x0C, 0x18, 0x65,
+    0x73, 0x70, 0x2D, 0x77, 0x6F, 0x6C, 0x66, 0x73, 0x73, 0x6C, 0x20, 0x4F,
+    0x43, 0x53, 0x50, 0x20, 0x74, 0x65, 0x73, 0x74, 0x20, 0x43, 0x41, 0x18,
+    0x0F, 0x32, 0x30, 0x32, 0x36, 0x31, 0x30, 0x31, 0x39, 0x30, 0x39, 0x31,
+    0x38, 0x32, 0x37, 0x5A, 0x30, 0x65, 0x30, 0x63, 0x30, 0x3B, 0x30, 0x09,
+    0x06, 0x05, 0x2B, 0x0E, 0x03, 0x02, 0x1A, 0x05, 0x00, 0x04, 0x14, 0x62,
+    0x4A, 0x8D, 0x8D, 0x33, 0x93, 0x1C, 0x16, 0x74, 0xBA, 0x25, 0xE2, 0x83,
+    0xC4, 0x6D, 0x1E, 0x71, 0xD7, 0xE4, 0x71, 0x04, 0x14, 0xE0, 0x59, 0x16,
+    0x7A, 0xC1, 0x7D, 0x57, 0xB5, 0x92, 0x05, 0x8F, 0xEA, 0x30, 0xB9, 0x0E,
+    0xEA, 0xFF, 0x24, 0x95, 0xD1, 0x02, 0x02, 0x10, 0x01, 0x80, 0x00, 0x18,
+    0x0F, 0x32, 0x30, 0x32, 0x36, 0x31, 0x30, 0x31, 0x39, 0x30, 0x39, 0x31,
+    0x38, 0x32, 0x37, 0x5A, 0xA0, 0x11, 0x18, 0x0F, 0x32, 0x30, 0x33, 0x36,
+    0x31, 0x30, 0x31, 0x36, 0x30, 0x39, 0x31, 0x38, 0x32, 0x37, 0x5A, 0x30,
+    0x0A, 0x06, 0x08, 0x2A, 0x86, 0x48, 0xCE, 0x3D, 0x04, 0x03, 0x02, 0x03,
+    0x47, 0x00, 0x30, 0x44, 0x02, 0x20, 0x63, 0x3D, 0x7F, 0x37, 0x62, 0xE1,
+    0xE0, 0x08, 0x22, 0xFD, 0x71, 0xAF, 0xD0, 0x03, 0xBA, 0x7F, 0x7C, 0xBF,
+    0x9F, 0x2E, 0x51, 0x2B, 0x96, 0x85, 0xFC, 0x7A, 0x37, 0x98, 0x94, 0x04,
+    0xD7, 0x8B, 0x02, 0x20, 0x09, 0xFB, 0x13, 0xB2, 0xE6, 0x39, 0x7B, 0x7C,
+    0x5E, 0xB4, 0x89, 0x59, 0x1C, 0x25, 0xB5, 0xA6, 0x8C, 0xB1, 0x81, 0xEC,
+    0x8F, 0x0B, 0x2D, 0xFE, 0x35, 0x84, 0x97, 0x70, 0x72, 0x3F, 0x42, 0x6E,
+};
+static const int sizeof_ocsp_response_der = sizeof(ocsp_response_der);
+
+#endif /* _OCSP_TEST_DATA_H_ */
@@ -0,0 +1,167 @@
+/* tls_loopback.h
+ *
+ * Copyright (C) 2006-2024 wolfSSL Inc.
+ *
+ * This file is part of wolfSSL.
+ *
+ * wolfSSL is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfSSL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335, USA
+ */
+
+/* In-memory TLS client and server in one task, for benchmarks that need a
+ * real handshake without a network. Both ends use the test certificates
+ * from wolfssl/certs_test.h and exchange records through two byte pipes,
+ * or, for DTLS, two datagram queues that keep message boundaries.
+ */
+
+#ifndef _TLS_LOOPBACK_H_
+#define _TLS_LOOPBACK_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "bench_common.h"
+#include <wolfssl/ssl.h>
+
+/* Bytes buffered per direction; holds a full handshake flight or one
+ * TLS_LOOPBACK_MAX_WRITE record. */
+#ifndef TLS_LOOPBACK_PIPE_SZ
+    #define TLS_LOOPBACK_PIPE_SZ  8192
+#endif
+#define TLS_LOOPBACK_MAX_WRITE    4096
+/* DTLS application records must fit one datagram */
+#define TLS_LOOPBACK_DTLS_MAX_WRITE 1024
+
+#define TLS_LOOPBACK_VERSION_ANY  0   /* highest version both support */
+#define TLS_LOOPBACK_VERSION_12   12
+#define TLS_LOOPBACK_VERSION_13   13
+
+typedef struct tls_loopback_cfg {
+    int         version;        /* TLS_LOOPBACK_VERSION_* */
+    const char* cipher_list;    /* NULL for the library default */
+    int         mutual_auth;    /* client presents a certificate */
+    int         datagram;       /* DTLS of the given version */
+    /* DER CA and server certificate and key, NULL for the wolfSSL test
+     * certificates */
+    const unsigned char* ca;
+    int                  ca_sz;
+    const unsigned char* server_cert;
+    int                  server_cert_sz;
+    const unsigned char* server_key;
+    int                  server_key_sz;
+    /* called for both contexts after the certificates are loaded, and for
+     * each new WOLFSSL before the handshake; may be NULL */
+    int       (*ctx_setup)(WOLFSSL_CTX* ctx, int server);
+    int       (*setup)(WOLFSSL* ssl, int server);
+} tls_loopback_cfg;
+
+typedef struct tls_loopback_pipe {
+    unsigned char* buf;
+    size_t         head;
+    size_t         len;
+} tls_loopback_pipe;
+
+typedef struct tls_loopback_stats {
+    uint32_t client_bytes;      /* client to server */
+    uint32_t server_bytes;      /* server to client */
+    uint32_t flights;           /* changes of sending direction */
+    uint32_t packets;           /* send calls: datagrams, or TCP writes */
+    uint32_t client_hello;      /* client bytes before the server's first */
+    int64_t  handshake_us;
+} tls_loopback_stats;
+
+typedef struct tls_loopback {
+    WOLFSSL_CTX*       client_ctx;
+    WOLFSSL_CTX*       server_ctx;
+    WOLFSSL*           client;
+    WOLFSSL*           server;
+    tls_loopback_pipe  to_server;
+    tls_loopback_pipe  to_client;
+    int                last_sender;  /* 0 none, 1 client, 2 server */
+    int                datagram;
+    int              (*setup)(WOLFSSL* ssl, int server);
+    tls_loopback_stats stats;        /* of the current connection */
+} tls_loopback;
+
+/* Creates both WOLFSSL_CTX and the pipes. cfg may be NULL. */
+int  tls_loopback_init(tls_loopback* lb, const tls_loopback_cfg* cfg);
+void tls_loopback_free(tls_loopback* lb);
+
+/* New client / server pair and full handshake; fills lb->stats. */
+int  tls_loopback_connect(tls_loopback* lb);
+
+/* Installs the loopback I/O callbacks on a context made elsewhere. */
+void tls_loopback_set_io(WOLFSSL_CTX* ctx, int server);
+
+/* Like tls_loopback_connect(), with a client made elsewhere, from a
+ * context with the loopback I/O callbacks; freed with the pair. */
+int  tls_loopback_connect_with(tls_loopback* lb, WOLFSSL* client);
+
+/* Client writes sz bytes, server reads and echoes them back. */
+int  tls_loopback_echo(tls_loopback* lb, size_t sz);
+
+/* close_notify both ways and free the pair. */
+void tls_loopback_close(tls_loopback* lb);
+
+/* Latency over repeated runs */
+typedef struct tls_loopback_timing {
+    uint32_t count;
+    int64_t  total_us;
+    int64_t  min_us;
+    int64_t  max_us;
+} tls_loopback_timing;
+
+void    tls_loopback_timing_add(tls_loopback_timing* t, int64_t us);
+int64_t tls_loopback_timing_avg(const tls_loopback_timing* t);
+
+/* Peak heap between tls_loopback_heap_start() and _stop(), and peak stack
+ * of the task made by tls_loopback_run_task(). Both stay 0 on a host. */
+typedef struct tls_loopback_measure {
+    size_t   heap_before;
+    size_t   heap_peak;
+    uint32_t stack_peak;
+} tls_loopback_measure;
+
+void tls_loopback_heap_start(tls_loopback_measure* m);
+void tls_loopback_heap_stop(tls_loopback_measure* m);
+
+/* Runs fn in a task of its own with stack_size bytes of stack, so that
+ * the stack peak is that of fn alone, and waits for it; on a host fn runs
+ * in the caller. Returns what fn returns. */
+int  tls_loopback_run_task(const char* name, uint32_t stack_size,
+                           int (*fn)(tls_loopback_measure* m, void* arg),
+                           void* arg, tls_loopback_measure* m);
+
+/* Repeated handshakes over one loopback, in a task of their own */
+typedef struct tls_loopback_bench {
+    const tls_loopback_cfg* cfg;  /* may be NULL */
+    int        count;             /* handshakes timed */
+    int        warmup;            /* handshakes before, not timed */
+    uint32_t   idle_ms;           /* sleep before each handshake */
+    uint32_t   stack_size;
+    /* after each handshake, before the close; may be NULL. Non-zero stops
+     * the run with that error. */
+    int      (*check)(tls_loopback* lb, void* arg);
+    void*      arg;
+
+    tls_loopback_timing  timing;
+    tls_loopback_stats   last;    /* of the last handshake, after check */
+    tls_loopback_measure measure; /* heap of the handshakes only */
+} tls_loopback_bench;
+
+/* The contexts and pipes are set up once and not accounted. Clears the
+ * results first. Returns 0 or the first error. */
+int  tls_loopback_bench_run(tls_loopback_bench* b);
+
+#endif /* _TLS_LOOPBACK_H_ */
@@ -47,7 +47,24 @@
 
 /* set to 0 for one benchmark,
 ** set to 1 for continuous benchmark loop */
-#define BENCHMARK_LOOP 0
+#ifdef CONFIG_BENCH_MODE_LOOP
+    #define BENCHMARK_LOOP 1
+#else
+    #define BENCHMARK_LOOP 0
+#endif
+
+/* runs one of the comparison benchmarks in app_main(), keeping the first
+** error in ret so that a later success does not hide it */
+#define BENCH_RUN(call)                                          \
+    do {                                                         \
+        int bench_ret_ = (call);                                 \
+        if (bench_ret_ != 0) {                                   \
+            ESP_LOGE(TAG, "%s failed: %d", #call, bench_ret_);   \
+            if (ret == 0) {                                      \
+                ret = bench_ret_;                                \
+            }                                                    \
+        }                                                        \
+    } while (0)
 
 #define THIS_MONITOR_UART_RX_BUFFER_SIZE 200
 
@@ -79,6 +96,9 @@
 */
 
 #include "main.h"
+#ifdef WOLFSSL_ESP_HW_METRICS
+    #include "esp_wolfssl_hw_metrics.h"
+#endif
 
 static const char* const TAG = "wolfssl_benchmark";
 
@@ -282,13 +302,103 @@ void app_main(void)
         ESP_LOGI(TAG, "Stack used: %d\n",
                       stack_start - uxTaskGetStackHighWaterMark(NULL));
 
-        #if defined(WOLFSSL_HW_METRICS) && defined(WOLFSSL_HAS_METRICS)
+        #if defined(WOLFSSL_ESP_HW_METRICS)
+            esp_wolfssl_hw_metrics_log(NULL);
+        #elif defined(WOLFSSL_HW_METRICS) && defined(WOLFSSL_HAS_METRICS)
             esp_hw_show_metrics();
         #endif
+        #if defined(WOLFSSL_ESP_MEM_ACCOUNTING)
+            esp_wolfssl_mem_log(ESP_WOLFSSL_MEM_DOMAIN_GLOBAL);
+        #endif
     } while (BENCHMARK_LOOP);
     /* Reminder: wolfCrypt_Cleanup should always be called at completion,
     ** and is called in wolf_benchmark_task().  */
 
+#ifdef CONFIG_BENCH_RSA_SIGN_PROFILE
+    BENCH_RUN(bench_rsa_sign_profile());
+#endif
+
+#ifdef CONFIG_BENCH_DTLS_COMPARE
+    BENCH_RUN(bench_dtls_compare());
+#endif
+
+#ifdef CONFIG_BENCH_OCSP
+    BENCH_RUN(bench_ocsp_compare());
+#endif
+
+#ifdef CONFIG_BENCH_CRL
+    BENCH_RUN(bench_crl_compare());
+#endif
+
+#ifdef CONFIG_BENCH_PQ
+    BENCH_RUN(bench_pq_compare());
+#endif
+
+#ifdef CONFIG_BENCH_OTA
+    BENCH_RUN(bench_ota_verify());
+#endif
+
+#ifdef CONFIG_BENCH_PKCS7
+    BENCH_RUN(bench_pkcs7_stream());
+#endif
+
+#ifdef CONFIG_BENCH_CERT
+    BENCH_RUN(bench_cert_parse());
+#endif
+
+#ifdef CONFIG_BENCH_RPK
+    BENCH_RUN(bench_rpk_compare());
+#endif
+
+#ifdef CONFIG_BENCH_BUFPOOL
+    BENCH_RUN(bench_bufpool_compare());
+#endif
+
+#ifdef CONFIG_BENCH_TICKET
+    BENCH_RUN(bench_ticket());
+#endif
+
+#ifdef CONFIG_BENCH_RNG
+    BENCH_RUN(bench_rng());
+#endif
+
+#ifdef CONFIG_BENCH_KEYPOOL
+    BENCH_RUN(bench_keypool_compare());
+#endif
+
+#ifdef CONFIG_BENCH_NONBLOCK
+    BENCH_RUN(bench_nonblock());
+#endif
+
+#ifdef CONFIG_BENCH_CTX_CACHE
+    BENCH_RUN(bench_ctx_cache_compare());
+#endif
+
+#ifdef CONFIG_BENCH_HW_ORDER
+    BENCH_RUN(bench_hw_order());
+#endif
+
+#ifdef CONFIG_BENCH_LOCKS
+    BENCH_RUN(bench_locks());
+#endif
+
+#ifdef CONFIG_BENCH_ARENA
+    BENCH_RUN(bench_arena());
+#endif
+
+#ifdef CONFIG_BENCH_HMAC
+    BENCH_RUN(bench_hmac());
+#endif
+
+#ifdef CONFIG_BENCH_ECC_HW
+    BENCH_RUN(bench_ecc_hw());
+#endif
+
+#ifdef CONFIG_BENCH_MODE_SOAK
+    BENCH_RUN(bench_soak_run(CONFIG_BENCH_SOAK_DURATION_MIN * 60,
+                             CONFIG_BENCH_SOAK_INTERVAL_S));
+#endif
+
 #if defined(SINGLE_THREADED)
     /* need stack monitor for single thread */
 #else
@@ -0,0 +1,748 @@
+/* tls_loopback.c
+ *
+ * Copyright (C) 2006-2024 wolfSSL Inc.
+ *
+ * This file is part of wolfSSL.
+ *
+ * wolfSSL is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfSSL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335, USA
+ */
+
+#include "bench_common.h"
+
+#include <string.h>
+
+#ifdef ESP_PLATFORM
+    #include <freertos/FreeRTOS.h>
+    #include <freertos/task.h>
+    #include <esp_heap_caps.h>
+#endif
+
+#include <wolfssl/ssl.h>
+#include <wolfssl/wolfcrypt/error-crypt.h>
+
+#include "tls_loopback.h"
+
+void tls_loopback_timing_add(tls_loopback_timing* t, int64_t us)
+{
+    if (t->count == 0 || us < t->min_us) {
+        t->min_us = us;
+    }
+    if (t->count == 0 || us > t->max_us) {
+        t->max_us = us;
+    }
+    t->total_us += us;
+    t->count++;
+}
+
+int64_t tls_loopback_timing_avg(const tls_loopback_timing* t)
+{
+    return (t->count > 0) ? t->total_us / (int64_t)t->count : 0;
+}
+
+/* wolfSSL allocates straight from the native heap, so the peak is the
+ * drop of the heap low-water mark */
+void tls_loopback_heap_start(tls_loopback_measure* m)
+{
+#ifdef ESP_PLATFORM
+    m->heap_before = heap_caps_get_free_size(MALLOC_CAP_DEFAULT);
+    heap_caps_monitor_local_minimum_free_size_start();
+#else
+    (void)m;
+#endif
+}
+
+void tls_loopback_heap_stop(tls_loopback_measure* m)
+{
+#ifdef ESP_PLATFORM
+    m->heap_peak = m->heap_before
+                 - heap_caps_get_minimum_free_size(MALLOC_CAP_DEFAULT);
+    heap_caps_monitor_local_minimum_free_size_stop();
+#else
+    (void)m;
+#endif
+}
+
+#ifdef ESP_PLATFORM
+typedef struct lb_task {
+    TaskHandle_t          parent;
+    uint32_t              stack_size;
+    int                 (*fn)(tls_loopback_measure* m, void* arg);
+    void*                 arg;
+    tls_loopback_measure* m;
+    int                   ret;
+} lb_task;
+
+static void lb_task_main(void* arg)
+{
+    lb_task* t = (lb_task*)arg;
+
+    t->ret = t->fn(t->m, t->arg);
+    t->m->stack_peak = t->stack_size
+                     - (uint32_t)uxTaskGetStackHighWaterMark(NULL);
+    xTaskNotifyGive(t->parent);
+    vTaskDelete(NULL);
+}
+#endif
+
+int tls_loopback_run_task(const char* name, uint32_t stack_size,
+                          int (*fn)(tls_loopback_measure* m, void* arg),
+                          void* arg, tls_loopback_measure* m)
+{
+#ifdef ESP_PLATFORM
+    lb_task t;
+
+    memset(m, 0, sizeof(*m));
+    t.parent = xTaskGetCurrentTaskHandle();
+    t.stack_size = stack_size;
+    t.fn = fn;
+    t.arg = arg;
+    t.m = m;
+    t.ret = 0;
+    if (xTaskCreate(lb_task_main, name, stack_size, &t,
+                    uxTaskPriorityGet(NULL), NULL) != pdPASS) {
+        return MEMORY_E;
+    }
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    return t.ret;
+#else
+    (void)name;
+    (void)stack_size;
+    memset(m, 0, sizeof(*m));
+    return fn(m, arg);
+#endif
+}
+
+#if !defined(WOLFCRYPT_ONLY) && !defined(NO_WOLFSSL_CLIENT) && \
+    !defined(NO_WOLFSSL_SERVER)
+
+/* host builds: ESP-IDF user_settings.h defines these */
+#if !defined(USE_CERT_BUFFERS_2048) && !defined(USE_CERT_BUFFERS_1024)
+    #define USE_CERT_BUFFERS_2048
+    #define USE_CERT_BUFFERS_256
+#endif
+#include <wolfssl/certs_test.h>
+
+static const char* const TAG = "tls_loopback";
+
+/* RSA-2048 test certificates by default, P-256 when RSA is disabled */
+#ifndef NO_RSA
+    #define LB_CA_CERT       ca_cert_der_2048
+    #define LB_CA_CERT_SZ    sizeof_ca_cert_der_2048
+    #define LB_SERVER_CERT   server_cert_der_2048
+    #define LB_SERVER_CERT_SZ sizeof_server_cert_der_2048
+    #define LB_SERVER_KEY    server_key_der_2048
+    #define LB_SERVER_KEY_SZ sizeof_server_key_der_2048
+    #define LB_CLIENT_CERT   client_cert_der_2048
+    #define LB_CLIENT_CERT_SZ sizeof_client_cert_der_2048
+    #define LB_CLIENT_KEY    client_key_der_2048
+    #define LB_CLIENT_KEY_SZ sizeof_client_key_der_2048
+#elif defined(HAVE_ECC)
+    #define LB_CA_CERT       ca_ecc_cert_der_256
+    #define LB_CA_CERT_SZ    sizeof_ca_ecc_cert_der_256
+    #define LB_SERVER_CERT   serv_ecc_der_256
+    #define LB_SERVER_CERT_SZ sizeof_serv_ecc_der_256
+    #define LB_SERVER_KEY    ecc_key_der_256
+    #define LB_SERVER_KEY_SZ sizeof_ecc_key_der_256
+    #define LB_CLIENT_CERT   cliecc_cert_der_256
+    #define LB_CLIENT_CERT_SZ sizeof_cliecc_cert_der_256
+    #define LB_CLIENT_KEY    ecc_clikey_der_256
+    #define LB_CLIENT_KEY_SZ sizeof_ecc_clikey_der_256
+#else
+    #error "tls_loopback needs RSA or ECC"
+#endif
+
+/* handshake and echo give up after this many rounds without progress */
+#define LB_MAX_ROUNDS 1000
+
+#define LB_CLIENT 1
+#define LB_SERVER 2
+
+static void lb_ring_put(tls_loopback_pipe* p, const unsigned char* data,
+                        size_t n)
+{
+    size_t tail = (p->head + p->len) % TLS_LOOPBACK_PIPE_SZ;
+    size_t first = TLS_LOOPBACK_PIPE_SZ - tail;
+
+    if (first > n) {
+        first = n;
+    }
+    memcpy(p->buf + tail, data, first);
+    memcpy(p->buf, data + first, n - first);
+    p->len += n;
+}
+
+/* data NULL drops the bytes */
+static void lb_ring_get(tls_loopback_pipe* p, unsigned char* data, size_t n)
+{
+    size_t first = TLS_LOOPBACK_PIPE_SZ - p->head;
+
+    if (first > n) {
+        first = n;
+    }
+    if (data != NULL) {
+        memcpy(data, p->buf + p->head, first);
+        memcpy(data + first, p->buf, n - first);
+    }
+    p->head = (p->head + n) % TLS_LOOPBACK_PIPE_SZ;
+    p->len -= n;
+}
+
+/* Stream: as much as fits. Datagram: all or nothing, behind a 2 byte
+ * length. */
+static int lb_pipe_write(tls_loopback* lb, tls_loopback_pipe* p,
+                         const char* data, int sz)
+{
+    size_t space = TLS_LOOPBACK_PIPE_SZ - p->len;
+    size_t n = (size_t)sz;
+    unsigned char hdr[2];
+
+    if (lb->datagram) {
+        if (n + sizeof(hdr) > space) {
+            return WOLFSSL_CBIO_ERR_WANT_WRITE;
+        }
+        hdr[0] = (unsigned char)(n >> 8);
+        hdr[1] = (unsigned char)n;
+        lb_ring_put(p, hdr, sizeof(hdr));
+    }
+    else {
+        if (space == 0) {
+            return WOLFSSL_CBIO_ERR_WANT_WRITE;
+        }
+        if (n > space) {
+            n = space;
+        }
+    }
+    lb_ring_put(p, (const unsigned char*)data, n);
+
+    return (int)n;
+}
+
+/* Stream: up to sz bytes. Datagram: one datagram, the part that does not
+ * fit into sz is lost as with a UDP socket. */
+static int lb_pipe_read(tls_loopback* lb, tls_loopback_pipe* p, char* data,
+                        int sz)
+{
+    unsigned char hdr[2];
+    size_t dlen;
+    size_t n;
+
+    if (p->len == 0) {
+        return WOLFSSL_CBIO_ERR_WANT_READ;
+    }
+    if (lb->datagram) {
+        lb_ring_get(p, hdr, sizeof(hdr));
+        dlen = ((size_t)hdr[0] << 8) | hdr[1];
+        n = ((size_t)sz < dlen) ? (size_t)sz : dlen;
+        lb_ring_get(p, (unsigned char*)data, n);
+        lb_ring_get(p, NULL, dlen - n);
+    }
+    else {
+        n = ((size_t)sz < p->len) ? (size_t)sz : p->len;
+        lb_ring_get(p, (unsigned char*)data, n);
+    }
+
+    return (int)n;
+}
+
+static int lb_client_send(WOLFSSL* ssl, char* buf, int sz, void* ctx)
+{
+    tls_loopback* lb = (tls_loopback*)ctx;
+    int ret = lb_pipe_write(lb, &lb->to_server, buf, sz);
+
+    (void)ssl;
+    if (ret > 0) {
+        if (lb->last_sender != LB_CLIENT) {
+            lb->stats.flights++;
+            lb->last_sender = LB_CLIENT;
+        }
+        lb->stats.client_bytes += (uint32_t)ret;
+        if (lb->stats.server_bytes == 0) {
+            lb->stats.client_hello += (uint32_t)ret;
+        }
+        lb->stats.packets++;
+    }
+    return ret;
+}
+
+static int lb_client_recv(WOLFSSL* ssl, char* buf, int sz, void* ctx)
+{
+    tls_loopback* lb = (tls_loopback*)ctx;
+
+    (void)ssl;
+    return lb_pipe_read(lb, &lb->to_client, buf, sz);
+}
+
+static int lb_server_send(WOLFSSL* ssl, char* buf, int sz, void* ctx)
+{
+    tls_loopback* lb = (tls_loopback*)ctx;
+    int ret = lb_pipe_write(lb, &lb->to_client, buf, sz);
+
+    (void)ssl;
+    if (ret > 0) {
+        if (lb->last_sender != LB_SERVER) {
+            lb->stats.flights++;
+            lb->last_sender = LB_SERVER;
+        }
+        lb->stats.server_bytes += (uint32_t)ret;
+        lb->stats.packets++;
+    }
+    return ret;
+}
+
+static int lb_server_recv(WOLFSSL* ssl, char* buf, int sz, void* ctx)
+{
+    tls_loopback* lb = (tls_loopback*)ctx;
+
+    (void)ssl;
+    return lb_pipe_read(lb, &lb->to_server, buf, sz);
+}
+
+/* The test certificates have a fixed validity period, and a device without
+ * SNTP is at 1970: only the date checks are overridden. */
+static int lb_verify_cb(int preverify, WOLFSSL_X509_STORE_CTX* store)
+{
+    if (preverify) {
+        return 1;
+    }
+    return (store != NULL && (store->error == ASN_BEFORE_DATE_E
+                              || store->error == ASN_AFTER_DATE_E));
+}
+
+#ifdef WOLFSSL_DTLS
+static WOLFSSL_METHOD* lb_dtls_method(int version, int server)
+{
+    switch (version) {
+    #ifdef WOLFSSL_DTLS13
+        case TLS_LOOPBACK_VERSION_13:
+            return server ? wolfDTLSv1_3_server_method() :
+                            wolfDTLSv1_3_client_method();
+    #endif
+    #ifndef WOLFSSL_NO_TLS12
+        case TLS_LOOPBACK_VERSION_12:
+            return server ? wolfDTLSv1_2_server_method() :
+                            wolfDTLSv1_2_client_method();
+    #endif
+        case TLS_LOOPBACK_VERSION_ANY:
+            return server ? wolfDTLS_server_method() :
+                            wolfDTLS_client_method();
+        default:
+            return NULL;
+    }
+}
+#endif
+
+static WOLFSSL_METHOD* lb_method(int version, int datagram, int server)
+{
+    if (datagram) {
+#ifdef WOLFSSL_DTLS
+        return lb_dtls_method(version, server);
+#else
+        return NULL;
+#endif
+    }
+
+    switch (version) {
+#ifdef WOLFSSL_TLS13
+        case TLS_LOOPBACK_VERSION_13:
+            return server ? wolfTLSv1_3_server_method() :
+                            wolfTLSv1_3_client_method();
+#endif
+#ifndef WOLFSSL_NO_TLS12
+        case TLS_LOOPBACK_VERSION_12:
+            return server ? wolfTLSv1_2_server_method() :
+                            wolfTLSv1_2_client_method();
+#endif
+        case TLS_LOOPBACK_VERSION_ANY:
+            return server ? wolfSSLv23_server_method() :
+                            wolfSSLv23_client_method();
+        default:
+            return NULL;
+    }
+}
+
+static int lb_is_blocked(WOLFSSL* ssl, int ret)
+{
+    int err = wolfSSL_get_error(ssl, ret);
+
+    return (err == WOLFSSL_ERROR_WANT_READ || err == WOLFSSL_ERROR_WANT_WRITE);
+}
+
+int tls_loopback_init(tls_loopback* lb, const tls_loopback_cfg* cfg)
+{
+    static const tls_loopback_cfg defaults;
+    int ret = WOLFSSL_SUCCESS;
+    WOLFSSL_METHOD* cm;
+    WOLFSSL_METHOD* sm;
+
+    if (lb == NULL) {
+        return BAD_FUNC_ARG;
+    }
+    if (cfg == NULL) {
+        cfg = &defaults;
+    }
+    memset(lb, 0, sizeof(*lb));
+
+    cm = lb_method(cfg->version, cfg->datagram, 0);
+    sm = lb_method(cfg->version, cfg->datagram, 1);
+    if (cm == NULL || sm == NULL) {
+        return NOT_COMPILED_IN;
+    }
+    lb->datagram = cfg->datagram;
+    lb->setup = cfg->setup;
+
+    lb->to_server.buf = (unsigned char*)XMALLOC(TLS_LOOPBACK_PIPE_SZ, NULL,
+                                                DYNAMIC_TYPE_TMP_BUFFER);
+    lb->to_client.buf = (unsigned char*)XMALLOC(TLS_LOOPBACK_PIPE_SZ, NULL,
+                                                DYNAMIC_TYPE_TMP_BUFFER);
+    lb->client_ctx = wolfSSL_CTX_new(cm);
+    lb->server_ctx = wolfSSL_CTX_new(sm);
+    if (lb->to_server.buf == NULL || lb->to_client.buf == NULL
+        || lb->client_ctx == NULL || lb->server_ctx == NULL) {
+        tls_loopback_free(lb);
+        return MEMORY_E;
+    }
+
+    tls_loopback_set_io(lb->client_ctx, 0);
+    tls_loopback_set_io(lb->server_ctx, 1);
+
+    if (cfg->ca != NULL) {
+        ret = wolfSSL_CTX_load_verify_buffer(lb->client_ctx, cfg->ca,
+                                             cfg->ca_sz,
+                                             WOLFSSL_FILETYPE_ASN1);
+    }
+    else {
+        ret = wolfSSL_CTX_load_verify_buffer(lb->client_ctx, LB_CA_CERT,
+                                             LB_CA_CERT_SZ,
+                                             WOLFSSL_FILETYPE_ASN1);
+    }
+    if (ret == WOLFSSL_SUCCESS) {
+        wolfSSL_CTX_set_verify(lb->client_ctx, WOLFSSL_VERIFY_PEER,
+                               lb_verify_cb);
+        if (cfg->server_cert != NULL && cfg->server_key != NULL) {
+            ret = wolfSSL_CTX_use_certificate_buffer(lb->server_ctx,
+                                                     cfg->server_cert,
+                                                     cfg->server_cert_sz,
+                                                     WOLFSSL_FILETYPE_ASN1);
+            if (ret == WOLFSSL_SUCCESS) {
+                ret = wolfSSL_CTX_use_PrivateKey_buffer(lb->server_ctx,
+                                                        cfg->server_key,
+                                                        cfg->server_key_sz,
+                                                        WOLFSSL_FILETYPE_ASN1);
+            }
+        }
+        else {
+            ret = wolfSSL_CTX_use_certificate_buffer(lb->server_ctx,
+                                                     LB_SERVER_CERT,
+                                                     LB_SERVER_CERT_SZ,
+                                                     WOLFSSL_FILETYPE_ASN1);
+            if (ret == WOLFSSL_SUCCESS) {
+                ret = wolfSSL_CTX_use_PrivateKey_buffer(lb->server_ctx,
+                                                        LB_SERVER_KEY,
+                                                        LB_SERVER_KEY_SZ,
+                                                        WOLFSSL_FILETYPE_ASN1);
+            }
+        }
+    }
+
+    if (ret == WOLFSSL_SUCCESS && cfg->mutual_auth) {
+        /* the client test certificate is self-signed */
+        ret = wolfSSL_CTX_use_certificate_buffer(lb->client_ctx,
+                                                 LB_CLIENT_CERT,
+                                                 LB_CLIENT_CERT_SZ,
+                                                 WOLFSSL_FILETYPE_ASN1);
+        if (ret == WOLFSSL_SUCCESS) {
+            ret = wolfSSL_CTX_use_PrivateKey_buffer(lb->client_ctx,
+                                                    LB_CLIENT_KEY,
+                                                    LB_CLIENT_KEY_SZ,
+                                                    WOLFSSL_FILETYPE_ASN1);
+        }
+        if (ret == WOLFSSL_SUCCESS) {
+            ret = wolfSSL_CTX_load_verify_buffer(lb->server_ctx,
+                                                 LB_CLIENT_CERT,
+                                                 LB_CLIENT_CERT_SZ,
+                                                 WOLFSSL_FILETYPE_ASN1);
+        }
+        if (ret == WOLFSSL_SUCCESS) {
+            wolfSSL_CTX_set_verify(lb->server_ctx, WOLFSSL_VERIFY_PEER
+                                   | WOLFSSL_VERIFY_FAIL_IF_NO_PEER_CERT,
+                                   lb_verify_cb);
+        }
+    }
+
+    if (ret == WOLFSSL_SUCCESS && cfg->cipher_list != NULL) {
+        ret = wolfSSL_CTX_set_cipher_list(lb->client_ctx, cfg->cipher_list);
+        if (ret == WOLFSSL_SUCCESS) {
+            ret = wolfSSL_CTX_set_cipher_list(lb->server_ctx,
+                                              cfg->cipher_list);
+        }
+    }
+
+    if (ret == WOLFSSL_SUCCESS && cfg->ctx_setup != NULL) {
+        ret = cfg->ctx_setup(lb->client_ctx, 0);
+        if (ret == 0) {
+            ret = cfg->ctx_setup(lb->server_ctx, 1);
+        }
+        ret = (ret == 0) ? WOLFSSL_SUCCESS : ret;
+    }
+
+    if (ret != WOLFSSL_SUCCESS) {
+        ESP_LOGE(TAG, "context setup failed: %d", ret);
+        tls_loopback_free(lb);
+        return (ret < 0) ? ret : WOLFSSL_FATAL_ERROR;
+    }
+
+    return 0;
+}
+
+void tls_loopback_free(tls_loopback* lb)
+{
+    if (lb == NULL) {
+        return;
+    }
+    tls_loopback_close(lb);
+    wolfSSL_CTX_free(lb->client_ctx);
+    wolfSSL_CTX_free(lb->server_ctx);
+    XFREE(lb->to_server.buf, NULL, DYNAMIC_TYPE_TMP_BUFFER);
+    XFREE(lb->to_client.buf, NULL, DYNAMIC_TYPE_TMP_BUFFER);
+    memset(lb, 0, sizeof(*lb));
+}
+
+void tls_loopback_set_io(WOLFSSL_CTX* ctx, int server)
+{
+    wolfSSL_CTX_SetIORecv(ctx, server ? lb_server_recv : lb_client_recv);
+    wolfSSL_CTX_SetIOSend(ctx, server ? lb_server_send : lb_client_send);
+}
+
+int tls_loopback_connect(tls_loopback* lb)
+{
+    if (lb == NULL || lb->client_ctx == NULL) {
+        return BAD_FUNC_ARG;
+    }
+    return tls_loopback_connect_with(lb, NULL);
+}
+
+int tls_loopback_connect_with(tls_loopback* lb, WOLFSSL* client)
+{
+    int64_t start;
+    int client_done = 0;
+    int server_done = 0;
+    int rounds;
+    int ret;
+
+    if (lb == NULL) {
+        wolfSSL_free(client);
+        return BAD_FUNC_ARG;
+    }
+    tls_loopback_close(lb);
+    memset(&lb->stats, 0, sizeof(lb->stats));
+
+    lb->client = (client != NULL) ? client : wolfSSL_new(lb->client_ctx);
+    lb->server = wolfSSL_new(lb->server_ctx);
+    if (lb->client == NULL || lb->server == NULL) {
+        tls_loopback_close(lb);
+        return MEMORY_E;
+    }
+    wolfSSL_SetIOReadCtx(lb->client, lb);
+    wolfSSL_SetIOWriteCtx(lb->client, lb);
+    wolfSSL_SetIOReadCtx(lb->server, lb);
+    wolfSSL_SetIOWriteCtx(lb->server, lb);
+#ifdef WOLFSSL_DTLS
+    if (lb->datagram) {
+        /* the pipes never lose a datagram: WANT_READ is not a timeout */
+        wolfSSL_dtls_set_using_nonblock(lb->client, 1);
+        wolfSSL_dtls_set_using_nonblock(lb->server, 1);
+    }
+#endif
+    if (lb->setup != NULL) {
+        ret = lb->setup(lb->client, 0);
+        if (ret == 0) {
+            ret = lb->setup(lb->server, 1);
+        }
+        if (ret != 0) {
+            ESP_LOGE(TAG, "connection setup failed: %d", ret);
+            tls_loopback_close(lb);
+            return ret;
+        }
+    }
+
+    start = esp_timer_get_time();
+    for (rounds = 0; rounds < LB_MAX_ROUNDS
+                     && !(client_done && server_done); rounds++) {
+        if (!client_done) {
+            ret = wolfSSL_connect(lb->client);
+            if (ret == WOLFSSL_SUCCESS) {
+                client_done = 1;
+            }
+            else if (!lb_is_blocked(lb->client, ret)) {
+                ret = wolfSSL_get_error(lb->client, ret);
+                ESP_LOGE(TAG, "client handshake failed: %d", ret);
+                return ret;
+            }
+        }
+        if (!server_done) {
+            ret = wolfSSL_accept(lb->server);
+            if (ret == WOLFSSL_SUCCESS) {
+                server_done = 1;
+            }
+            else if (!lb_is_blocked(lb->server, ret)) {
+                ret = wolfSSL_get_error(lb->server, ret);
+                ESP_LOGE(TAG, "server handshake failed: %d", ret);
+                return ret;
+            }
+        }
+    }
+    lb->stats.handshake_us = esp_timer_get_time() - start;
+
+    return (client_done && server_done) ? 0 : WOLFSSL_FATAL_ERROR;
+}
+
+/* Moves up to sz bytes from one end to the other: from writes, to reads */
+static int lb_transfer(WOLFSSL* from, WOLFSSL* to, const byte* data,
+                       byte* out, int sz)
+{
+    int written = 0;
+    int got = 0;
+    int rounds;
+    int ret;
+
+    for (rounds = 0; rounds < LB_MAX_ROUNDS && got < sz; rounds++) {
+        if (written < sz) {
+            ret = wolfSSL_write(from, data + written, sz - written);
+            if (ret > 0) {
+                written += ret;
+            }
+            else if (!lb_is_blocked(from, ret)) {
+                return wolfSSL_get_error(from, ret);
+            }
+        }
+        ret = wolfSSL_read(to, out + got, sz - got);
+        if (ret > 0) {
+            got += ret;
+        }
+        else if (!lb_is_blocked(to, ret)) {
+            return wolfSSL_get_error(to, ret);
+        }
+    }
+
+    return (got == sz) ? 0 : WOLFSSL_FATAL_ERROR;
+}
+
+int tls_loopback_echo(tls_loopback* lb, size_t sz)
+{
+    byte* tx;
+    byte* rx;
+    size_t done = 0;
+    size_t max_chunk;
+    int chunk;
+    int ret = 0;
+
+    if (lb == NULL || lb->client == NULL || lb->server == NULL) {
+        return BAD_FUNC_ARG;
+    }
+
+    tx = (byte*)XMALLOC(TLS_LOOPBACK_MAX_WRITE * 2, NULL,
+                        DYNAMIC_TYPE_TMP_BUFFER);
+    if (tx == NULL) {
+        return MEMORY_E;
+    }
+    rx = tx + TLS_LOOPBACK_MAX_WRITE;
+    max_chunk = lb->datagram ? TLS_LOOPBACK_DTLS_MAX_WRITE :
+                               TLS_LOOPBACK_MAX_WRITE;
+
+    while (ret == 0 && done < sz) {
+        chunk = (sz - done > max_chunk) ? (int)max_chunk : (int)(sz - done);
+        memset(tx, (int)(done & 0xFF), chunk);
+
+        ret = lb_transfer(lb->client, lb->server, tx, rx, chunk);
+        if (ret == 0) {
+            /* server echoes what it received */
+            ret = lb_transfer(lb->server, lb->client, rx, tx, chunk);
+        }
+        if (ret == 0 && tx[chunk - 1] != (byte)(done & 0xFF)) {
+            ret = WOLFSSL_FATAL_ERROR;
+        }
+        done += (size_t)chunk;
+    }
+
+    XFREE(tx, NULL, DYNAMIC_TYPE_TMP_BUFFER);
+    return ret;
+}
+
+void tls_loopback_close(tls_loopback* lb)
+{
+    if (lb == NULL) {
+        return;
+    }
+    if (lb->client != NULL && lb->server != NULL) {
+        /* one round each way is enough for in-memory pipes */
+        (void)wolfSSL_shutdown(lb->client);
+        (void)wolfSSL_shutdown(lb->server);
+        (void)wolfSSL_shutdown(lb->client);
+    }
+    wolfSSL_free(lb->client);
+    wolfSSL_free(lb->server);
+    lb->client = NULL;
+    lb->server = NULL;
+    lb->last_sender = 0;
+    lb->to_server.head = lb->to_server.len = 0;
+    lb->to_client.head = lb->to_client.len = 0;
+}
+
+static int lb_bench_task(tls_loopback_measure* m, void* arg)
+{
+    tls_loopback_bench* b = (tls_loopback_bench*)arg;
+    tls_loopback lb;
+    int ret;
+    int i;
+
+    ret = tls_loopback_init(&lb, b->cfg);
+    if (ret != 0) {
+        return ret;
+    }
+    tls_loopback_heap_start(m);
+    for (i = 0; ret == 0 && i < b->warmup + b->count; i++) {
+    #ifdef ESP_PLATFORM
+        if (b->idle_ms > 0) {
+            vTaskDelay(pdMS_TO_TICKS(b->idle_ms));
+        }
+    #endif
+        ret = tls_loopback_connect(&lb);
+        if (ret == 0 && b->check != NULL) {
+            ret = b->check(&lb, b->arg);
+        }
+        if (ret == 0 && i >= b->warmup) {
+            tls_loopback_timing_add(&b->timing, lb.stats.handshake_us);
+            b->last = lb.stats;
+        }
+        tls_loopback_close(&lb);
+    }
+    tls_loopback_heap_stop(m);
+    tls_loopback_free(&lb);
+
+    return ret;
+}
+
+int tls_loopback_bench_run(tls_loopback_bench* b)
+{
+    if (b == NULL) {
+        return BAD_FUNC_ARG;
+    }
+    memset(&b->timing, 0, sizeof(b->timing));
+    memset(&b->last, 0, sizeof(b->last));
+    return tls_loopback_run_task("tls_loopback", b->stack_size,
+                                 lb_bench_task, b, &b->measure);
+}
+
+#endif /* !WOLFCRYPT_ONLY && !NO_WOLFSSL_CLIENT && !NO_WOLFSSL_SERVER */
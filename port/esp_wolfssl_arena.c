@@ -0,0 +1,418 @@
+/* esp_wolfssl_arena.c
+ *
+ * Copyright (C) 2006-2024 wolfSSL Inc.
+ *
+ * This file is part of wolfSSL.
+ *
+ * wolfSSL is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfSSL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335, USA
+ */
+
+#include <wolfssl/wolfcrypt/settings.h>
+
+#ifdef WOLFSSL_ESP_ARENA
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <wolfssl/wolfcrypt/types.h>
+
+#include "esp_wolfssl_arena.h"
+
+/* arenas are never accounted; everything else goes on to the record-buffer
+ * pool, the heap accounting or the heap */
+#ifdef WOLFSSL_ESPIDF
+    #include <freertos/FreeRTOS.h>
+
+    #define ARENA_NATIVE_MALLOC(n)    pvPortMalloc((n))
+    #define ARENA_NATIVE_FREE(p)      vPortFree((p))
+#else
+    #define ARENA_NATIVE_MALLOC(n)    malloc((n))
+    #define ARENA_NATIVE_FREE(p)      free((p))
+#endif
+
+#if defined(WOLFSSL_ESP_BUFPOOL)
+    #include "esp_wolfssl_bufpool.h"
+
+    #define ARENA_NEXT_MALLOC(n, h, t) \
+                esp_wolfssl_bufpool_malloc((n), (h), (t))
+    #define ARENA_NEXT_FREE(p, h, t)    esp_wolfssl_bufpool_free((p), (h), (t))
+    #define ARENA_NEXT_REALLOC(p, n, h, t) \
+                esp_wolfssl_bufpool_realloc((p), (n), (h), (t))
+#elif defined(WOLFSSL_ESP_MEM_ACCOUNTING)
+    #include "esp_wolfssl_mem.h"
+
+    #define ARENA_NEXT_MALLOC(n, h, t)  esp_wolfssl_malloc((n), (h), (t))
+    #define ARENA_NEXT_FREE(p, h, t)    esp_wolfssl_free((p), (h), (t))
+    #define ARENA_NEXT_REALLOC(p, n, h, t) \
+                esp_wolfssl_realloc((p), (n), (h), (t))
+#else
+    #define ARENA_NEXT_MALLOC(n, h, t)     ARENA_NATIVE_MALLOC((n))
+    #define ARENA_NEXT_FREE(p, h, t)       ARENA_NATIVE_FREE((p))
+    #define ARENA_NEXT_REALLOC(p, n, h, t) realloc((p), (n))
+#endif
+
+#if ESP_WOLFSSL_ARENA_TASKS < 1 || ESP_WOLFSSL_ARENA_TASKS > 32
+    #error "ESP_WOLFSSL_ARENA_TASKS must be between 1 and 32"
+#endif
+
+/* Every block is prefixed with this header. The header size keeps the
+ * alignment of the native allocator (8 on target, 16 on 64-bit hosts) */
+typedef struct arena_hdr {
+    uint32_t size;      /* rounded up to ARENA_ALIGN */
+    uint32_t prev;      /* offset of the block below, or ARENA_NONE */
+    uint16_t magic;
+    uint8_t  freed;
+    uint8_t  pad;
+} arena_hdr;
+
+#define ARENA_ALIGN     (sizeof(void*) > 4 ? 16 : 8)
+#define ARENA_HDR_SZ    16
+#define ARENA_MAGIC     0xA7E5
+#define ARENA_NONE      UINT32_MAX
+#define ARENA_ROUND(n)  (((n) + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1))
+
+typedef struct arena_t {
+    unsigned char* base;    /* NULL while the slot is unused */
+    uint32_t       top;     /* owner only, like last */
+    uint32_t       last;    /* offset of the topmost block, or ARENA_NONE */
+    uint32_t       live;    /* blocks not yet freed, by any task */
+} arena_t;
+
+static arena_t arena_tab[ESP_WOLFSSL_ARENA_TASKS];
+/* one bit per slot of arena_tab that a task owns */
+static uint32_t arena_used;
+static int arena_enabled = 1;
+
+static uint32_t arena_count;
+static uint32_t arena_allocs;
+static uint32_t arena_heap_allocs;
+static uint32_t arena_overflows;
+static uint32_t arena_peak;
+static uint32_t arena_held_over;
+
+/* of the calling task; the arena stays across scopes until released */
+static __thread arena_t* arena_mine;
+static __thread int arena_depth;
+static __thread int arena_active;
+
+static int arena_is_temp(int type)
+{
+    switch (type) {
+        case DYNAMIC_TYPE_TMP_BUFFER:
+        case DYNAMIC_TYPE_BIGINT:
+        case DYNAMIC_TYPE_DCERT:
+        case DYNAMIC_TYPE_SIGNATURE:
+        case DYNAMIC_TYPE_RSA_BUFFER:
+        case DYNAMIC_TYPE_ECC_BUFFER:
+        case DYNAMIC_TYPE_DH_BUFFER:
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+static arena_hdr* arena_hdr_at(arena_t* a, uint32_t off)
+{
+    return (arena_hdr*)(a->base + off);
+}
+
+/* the arena ptr was carved from, of any task, or NULL */
+static arena_t* arena_owner(const void* ptr)
+{
+    const unsigned char* p = (const unsigned char*)ptr;
+    const unsigned char* base;
+    int i;
+
+    if (arena_mine != NULL && p >= arena_mine->base
+            && p < arena_mine->base + ESP_WOLFSSL_ARENA_SZ) {
+        return arena_mine;
+    }
+    for (i = 0; i < ESP_WOLFSSL_ARENA_TASKS; i++) {
+        base = __atomic_load_n(&arena_tab[i].base, __ATOMIC_ACQUIRE);
+        if (base != NULL && p >= base && p < base + ESP_WOLFSSL_ARENA_SZ) {
+            return &arena_tab[i];
+        }
+    }
+    return NULL;
+}
+
+/* owner only: moves the top down over freed blocks */
+static void arena_pop(arena_t* a)
+{
+    arena_hdr* hdr;
+
+    while (a->last != ARENA_NONE) {
+        hdr = arena_hdr_at(a, a->last);
+        if (!__atomic_load_n(&hdr->freed, __ATOMIC_ACQUIRE)) {
+            break;
+        }
+        hdr->magic = 0;
+        a->top = a->last;
+        a->last = hdr->prev;
+    }
+}
+
+static void arena_note_peak(uint32_t top)
+{
+    uint32_t old = __atomic_load_n(&arena_peak, __ATOMIC_RELAXED);
+
+    while (top > old) {
+        if (__atomic_compare_exchange_n(&arena_peak, &old, top, 1,
+                                        __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+            break;
+        }
+    }
+}
+
+/* owner only */
+static void* arena_carve(arena_t* a, size_t size)
+{
+    arena_hdr* hdr;
+    size_t need;
+
+    if (size > ESP_WOLFSSL_ARENA_SZ - ARENA_HDR_SZ) {
+        return NULL;
+    }
+    arena_pop(a);
+    need = ARENA_HDR_SZ + ARENA_ROUND(size);
+    if (a->top + need > ESP_WOLFSSL_ARENA_SZ) {
+        return NULL;
+    }
+
+    hdr = arena_hdr_at(a, a->top);
+    hdr->size  = (uint32_t)ARENA_ROUND(size);
+    hdr->prev  = a->last;
+    hdr->magic = ARENA_MAGIC;
+    hdr->freed = 0;
+    a->last = a->top;
+    a->top += (uint32_t)need;
+    __atomic_add_fetch(&a->live, 1, __ATOMIC_RELAXED);
+    arena_note_peak(a->top);
+
+    return (unsigned char*)hdr + ARENA_HDR_SZ;
+}
+
+/* by any task; only the owner moves the top */
+static void arena_release_block(arena_t* a, void* ptr)
+{
+    arena_hdr* hdr = (arena_hdr*)((unsigned char*)ptr - ARENA_HDR_SZ);
+
+    if (hdr->magic != ARENA_MAGIC || hdr->freed) {
+        /* double free: nothing to give back */
+        return;
+    }
+    __atomic_store_n(&hdr->freed, 1, __ATOMIC_RELEASE);
+    __atomic_sub_fetch(&a->live, 1, __ATOMIC_RELAXED);
+    if (a == arena_mine) {
+        arena_pop(a);
+    }
+}
+
+void* esp_wolfssl_arena_malloc(size_t size, void* heap, int type)
+{
+    void* ptr;
+
+    (void)heap;
+
+    if (arena_active && arena_is_temp(type)) {
+        ptr = arena_carve(arena_mine, size);
+        if (ptr != NULL) {
+            __atomic_add_fetch(&arena_allocs, 1, __ATOMIC_RELAXED);
+            return ptr;
+        }
+        __atomic_add_fetch(&arena_overflows, 1, __ATOMIC_RELAXED);
+    }
+    __atomic_add_fetch(&arena_heap_allocs, 1, __ATOMIC_RELAXED);
+    return ARENA_NEXT_MALLOC(size, heap, type);
+}
+
+void esp_wolfssl_arena_free(void* ptr, void* heap, int type)
+{
+    arena_t* a;
+
+    (void)heap;
+    (void)type;
+
+    if (ptr == NULL) {
+        return;
+    }
+    a = arena_owner(ptr);
+    if (a != NULL) {
+        arena_release_block(a, ptr);
+        return;
+    }
+    ARENA_NEXT_FREE(ptr, heap, type);
+}
+
+void* esp_wolfssl_arena_realloc(void* ptr, size_t size, void* heap,
+                                int type)
+{
+    arena_hdr* hdr;
+    arena_t* a;
+    void* moved;
+    size_t need;
+
+    (void)heap;
+
+    if (ptr == NULL) {
+        return esp_wolfssl_arena_malloc(size, heap, type);
+    }
+    a = arena_owner(ptr);
+    if (a == NULL) {
+        __atomic_add_fetch(&arena_heap_allocs, 1, __ATOMIC_RELAXED);
+        return ARENA_NEXT_REALLOC(ptr, size, heap, type);
+    }
+    if (size == 0) {
+        arena_release_block(a, ptr);
+        return NULL;
+    }
+
+    hdr = (arena_hdr*)((unsigned char*)ptr - ARENA_HDR_SZ);
+    if (ARENA_ROUND(size) <= hdr->size) {
+        return ptr;
+    }
+    /* the topmost block of our own arena grows in place */
+    need = ARENA_HDR_SZ + ARENA_ROUND(size);
+    if (a == arena_mine && (unsigned char*)hdr == a->base + a->last
+            && size <= ESP_WOLFSSL_ARENA_SZ - ARENA_HDR_SZ
+            && a->last + need <= ESP_WOLFSSL_ARENA_SZ) {
+        hdr->size = (uint32_t)ARENA_ROUND(size);
+        a->top = a->last + (uint32_t)need;
+        arena_note_peak(a->top);
+        return ptr;
+    }
+
+    moved = esp_wolfssl_arena_malloc(size, heap, type);
+    if (moved != NULL) {
+        memcpy(moved, ptr, hdr->size);
+        arena_release_block(a, ptr);
+    }
+    return moved;
+}
+
+static arena_t* arena_attach(void)
+{
+    uint32_t used = __atomic_load_n(&arena_used, __ATOMIC_ACQUIRE);
+    unsigned char* base;
+    int i;
+
+    for (i = 0; i < ESP_WOLFSSL_ARENA_TASKS; i++) {
+        if (used & (1u << i)) {
+            continue;
+        }
+        if (!__atomic_compare_exchange_n(&arena_used, &used, used | (1u << i),
+                                         0, __ATOMIC_ACQ_REL,
+                                         __ATOMIC_ACQUIRE)) {
+            /* used was reloaded; look at this slot again */
+            i--;
+            continue;
+        }
+        base = (unsigned char*)ARENA_NATIVE_MALLOC(ESP_WOLFSSL_ARENA_SZ);
+        if (base == NULL) {
+            __atomic_and_fetch(&arena_used, ~(1u << i), __ATOMIC_RELEASE);
+            return NULL;
+        }
+        arena_tab[i].top = 0;
+        arena_tab[i].last = ARENA_NONE;
+        __atomic_store_n(&arena_tab[i].live, 0, __ATOMIC_RELAXED);
+        __atomic_store_n(&arena_tab[i].base, base, __ATOMIC_RELEASE);
+        __atomic_add_fetch(&arena_count, 1, __ATOMIC_RELAXED);
+        return &arena_tab[i];
+    }
+    return NULL;
+}
+
+int esp_wolfssl_arena_begin(void)
+{
+    if (arena_depth++ > 0) {
+        return arena_active ? 0 : -1;
+    }
+    if (__atomic_load_n(&arena_enabled, __ATOMIC_RELAXED)
+            && arena_mine == NULL) {
+        arena_mine = arena_attach();
+    }
+    arena_active = __atomic_load_n(&arena_enabled, __ATOMIC_RELAXED)
+                   && arena_mine != NULL;
+    return arena_active ? 0 : -1;
+}
+
+void esp_wolfssl_arena_end(void)
+{
+    if (arena_depth == 0 || --arena_depth > 0) {
+        return;
+    }
+    if (arena_active) {
+        arena_pop(arena_mine);
+        if (arena_mine->top != 0) {
+            __atomic_add_fetch(&arena_held_over, 1, __ATOMIC_RELAXED);
+        }
+    }
+    arena_active = 0;
+}
+
+int esp_wolfssl_arena_release(void)
+{
+    arena_t* a = arena_mine;
+    unsigned char* base;
+
+    if (arena_depth > 0) {
+        return -1;
+    }
+    if (a == NULL) {
+        return 0;
+    }
+    arena_pop(a);
+    if (a->top != 0 || __atomic_load_n(&a->live, __ATOMIC_ACQUIRE) != 0) {
+        return -1;
+    }
+    base = a->base;
+    __atomic_store_n(&a->base, NULL, __ATOMIC_RELEASE);
+    ARENA_NATIVE_FREE(base);
+    __atomic_and_fetch(&arena_used, ~(1u << (a - arena_tab)),
+                       __ATOMIC_RELEASE);
+    __atomic_sub_fetch(&arena_count, 1, __ATOMIC_RELAXED);
+    arena_mine = NULL;
+    return 0;
+}
+
+void esp_wolfssl_arena_set_enabled(int enabled)
+{
+    __atomic_store_n(&arena_enabled, enabled ? 1 : 0, __ATOMIC_RELAXED);
+}
+
+void esp_wolfssl_arena_get_stats(esp_wolfssl_arena_stats_t* stats)
+{
+    if (stats == NULL) {
+        return;
+    }
+    stats->arenas       = __atomic_load_n(&arena_count, __ATOMIC_RELAXED);
+    stats->arena_allocs = __atomic_load_n(&arena_allocs, __ATOMIC_RELAXED);
+    stats->heap_allocs  = __atomic_load_n(&arena_heap_allocs,
+                                          __ATOMIC_RELAXED);
+    stats->overflows    = __atomic_load_n(&arena_overflows, __ATOMIC_RELAXED);
+    stats->peak_bytes   = __atomic_load_n(&arena_peak, __ATOMIC_RELAXED);
+    stats->held_over    = __atomic_load_n(&arena_held_over, __ATOMIC_RELAXED);
+}
+
+void esp_wolfssl_arena_reset_stats(void)
+{
+    __atomic_store_n(&arena_allocs, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&arena_heap_allocs, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&arena_overflows, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&arena_peak, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&arena_held_over, 0, __ATOMIC_RELAXED);
+}
+
+#endif /* WOLFSSL_ESP_ARENA */
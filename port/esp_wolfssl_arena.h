@@ -0,0 +1,111 @@
+/* esp_wolfssl_arena.h
+ *
+ * Copyright (C) 2006-2024 wolfSSL Inc.
+ *
+ * This file is part of wolfSSL.
+ *
+ * wolfSSL is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfSSL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335, USA
+ */
+
+/* Per-task scratch arena for WOLFSSL_SMALL_STACK temporaries.
+ *
+ * Enabled with Kconfig WOLFSSL_ARENA, which routes XMALLOC, XFREE and
+ * XREALLOC through the functions below (see user_settings.h), on top of
+ * the record-buffer pool and the heap accounting when those are enabled
+ * too. For a Linux host build define WOLFSSL_ESP_ARENA and the same
+ * XMALLOC macros in the wolfSSL build.
+ *
+ * With WOLFSSL_SMALL_STACK every big-number, hash and decoded-certificate
+ * temporary is a malloc / free pair, thousands per handshake. Between
+ * esp_wolfssl_arena_begin() and esp_wolfssl_arena_end() the temporaries
+ * of the calling task (DYNAMIC_TYPE_TMP_BUFFER, _BIGINT, _DCERT,
+ * _SIGNATURE and the _BUFFER types of RSA, ECC and DH) are instead carved
+ * off the top of an arena of ESP_WOLFSSL_ARENA_SZ bytes owned by that
+ * task, and a free of the topmost block moves the top back down. A block
+ * freed out of order is marked and given back once the blocks above it
+ * are. When a temporary does not fit, it comes from the heap as before.
+ * Other types, and all allocations outside a begin / end pair, always go
+ * to the heap.
+ *
+ * The arena is never reset over live blocks: a temporary that outlives
+ * its operation, even one freed later by another task, keeps its place
+ * until freed. With all blocks freed the top is back at the start, so each
+ * operation reuses the same memory. Wrap whole operations:
+ *
+ *     esp_wolfssl_arena_begin();
+ *     ret = esp_tls_conn_new_sync(host, len, port, &cfg, tls);
+ *     esp_wolfssl_arena_end();
+ *
+ * Up to ESP_WOLFSSL_ARENA_TASKS tasks hold an arena at a time, allocated
+ * on their first begin; esp_wolfssl_arena_release() gives it back, e.g.
+ * before the task ends. The header carries no wolfSSL dependencies, as it
+ * is included from user_settings.h.
+ */
+
+#ifndef _ESP_WOLFSSL_ARENA_H_
+#define _ESP_WOLFSSL_ARENA_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* bytes per task; about the peak of the temporaries of a TLS 1.3
+ * handshake with P-256 */
+#ifndef ESP_WOLFSSL_ARENA_SZ
+    #define ESP_WOLFSSL_ARENA_SZ    8192
+#endif
+#ifndef ESP_WOLFSSL_ARENA_TASKS
+    #define ESP_WOLFSSL_ARENA_TASKS 4
+#endif
+
+typedef struct esp_wolfssl_arena_stats_t {
+    uint32_t arenas;        /* currently allocated */
+    uint32_t arena_allocs;  /* temporaries served from an arena */
+    uint32_t heap_allocs;   /* all allocations passed on to the heap */
+    uint32_t overflows;     /* temporaries in a scope that did not fit */
+    uint32_t peak_bytes;    /* highest top of any arena */
+    uint32_t held_over;     /* scopes ended with live arena blocks */
+} esp_wolfssl_arena_stats_t;
+
+/* XMALLOC / XFREE / XREALLOC replacements. */
+void* esp_wolfssl_arena_malloc(size_t size, void* heap, int type);
+void  esp_wolfssl_arena_free(void* ptr, void* heap, int type);
+void* esp_wolfssl_arena_realloc(void* ptr, size_t size, void* heap,
+                                int type);
+
+/* Opens a scope for the calling task, allocating its arena if needed.
+ * Scopes nest. Returns 0, or -1 when no arena is available, in which case
+ * temporaries go to the heap until the matching end. */
+int  esp_wolfssl_arena_begin(void);
+void esp_wolfssl_arena_end(void);
+
+/* Frees the arena of the calling task. Returns 0, or -1 while a scope is
+ * open or blocks are live. */
+int  esp_wolfssl_arena_release(void);
+
+/* With 0, scopes open no arena and everything goes to the heap. */
+void esp_wolfssl_arena_set_enabled(int enabled);
+
+void esp_wolfssl_arena_get_stats(esp_wolfssl_arena_stats_t* stats);
+void esp_wolfssl_arena_reset_stats(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _ESP_WOLFSSL_ARENA_H_ */
@@ -0,0 +1,266 @@
+/* esp_wolfssl_bufpool.c
+ *
+ * Copyright (C) 2006-2024 wolfSSL Inc.
+ *
+ * This file is part of wolfSSL.
+ *
+ * wolfSSL is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfSSL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335, USA
+ */
+
+#include <wolfssl/wolfcrypt/settings.h>
+
+#ifdef WOLFSSL_ESP_BUFPOOL
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <wolfssl/wolfcrypt/types.h>
+
+#include "esp_wolfssl_bufpool.h"
+
+/* pool buffers are never accounted; everything else goes on to the heap
+ * accounting or the heap */
+#ifdef WOLFSSL_ESPIDF
+    #include <freertos/FreeRTOS.h>
+
+    #define POOL_NATIVE_MALLOC(n)    pvPortMalloc((n))
+    #define POOL_NATIVE_FREE(p)      vPortFree((p))
+#else
+    #define POOL_NATIVE_MALLOC(n)    malloc((n))
+    #define POOL_NATIVE_FREE(p)      free((p))
+#endif
+
+#if defined(WOLFSSL_ESP_MEM_ACCOUNTING)
+    #include "esp_wolfssl_mem.h"
+
+    #define POOL_NEXT_MALLOC(n, h, t)     esp_wolfssl_malloc((n), (h), (t))
+    #define POOL_NEXT_FREE(p, h, t)       esp_wolfssl_free((p), (h), (t))
+    #define POOL_NEXT_REALLOC(p, n, h, t) esp_wolfssl_realloc((p), (n), (h), (t))
+#else
+    #define POOL_NEXT_MALLOC(n, h, t)     POOL_NATIVE_MALLOC((n))
+    #define POOL_NEXT_FREE(p, h, t)       POOL_NATIVE_FREE((p))
+    #define POOL_NEXT_REALLOC(p, n, h, t) realloc((p), (n))
+#endif
+
+#if ESP_WOLFSSL_BUFPOOL_BUFFERS < 1 || ESP_WOLFSSL_BUFPOOL_BUFFERS > 32
+    #error "ESP_WOLFSSL_BUFPOOL_BUFFERS must be between 1 and 32"
+#endif
+
+/* allocated on first borrow, freed by esp_wolfssl_bufpool_trim() */
+static unsigned char* pool_buf[ESP_WOLFSSL_BUFPOOL_BUFFERS];
+/* one bit per borrowed buffer; a set bit also owns pool_buf[i] */
+static uint32_t pool_used;
+static int pool_enabled = 1;
+
+static uint32_t pool_buffers;
+static uint32_t pool_peak;
+static uint32_t pool_borrows;
+static uint32_t pool_fallbacks;
+
+static int pool_is_record(int type)
+{
+    return type == DYNAMIC_TYPE_IN_BUFFER || type == DYNAMIC_TYPE_OUT_BUFFER;
+}
+
+/* claims a clear bit of pool_used; returns its index or -1 */
+static int pool_claim(void)
+{
+    uint32_t used = __atomic_load_n(&pool_used, __ATOMIC_ACQUIRE);
+    uint32_t bit;
+    int i;
+
+    for (i = 0; i < ESP_WOLFSSL_BUFPOOL_BUFFERS; i++) {
+        bit = 1u << i;
+        if (used & bit) {
+            continue;
+        }
+        if (__atomic_compare_exchange_n(&pool_used, &used, used | bit, 0,
+                                        __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+            return i;
+        }
+        /* used was reloaded; start over */
+        i = -1;
+    }
+    return -1;
+}
+
+static void pool_release(int i)
+{
+    __atomic_and_fetch(&pool_used, ~(1u << i), __ATOMIC_RELEASE);
+}
+
+static void pool_peak_update(void)
+{
+    uint32_t now = (uint32_t)__builtin_popcount(
+                        __atomic_load_n(&pool_used, __ATOMIC_RELAXED));
+    uint32_t old = __atomic_load_n(&pool_peak, __ATOMIC_RELAXED);
+
+    while (now > old) {
+        if (__atomic_compare_exchange_n(&pool_peak, &old, now, 1,
+                                        __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+            break;
+        }
+    }
+}
+
+static void* pool_borrow(void)
+{
+    unsigned char* buf;
+    int i = pool_claim();
+
+    if (i < 0) {
+        return NULL;
+    }
+    buf = __atomic_load_n(&pool_buf[i], __ATOMIC_ACQUIRE);
+    if (buf == NULL) {
+        buf = (unsigned char*)POOL_NATIVE_MALLOC(
+                                            ESP_WOLFSSL_BUFPOOL_BUFFER_SZ);
+        if (buf == NULL) {
+            pool_release(i);
+            return NULL;
+        }
+        __atomic_store_n(&pool_buf[i], buf, __ATOMIC_RELEASE);
+        __atomic_add_fetch(&pool_buffers, 1, __ATOMIC_RELAXED);
+    }
+    __atomic_add_fetch(&pool_borrows, 1, __ATOMIC_RELAXED);
+    pool_peak_update();
+    return buf;
+}
+
+static int pool_index(const void* ptr)
+{
+    int i;
+
+    for (i = 0; i < ESP_WOLFSSL_BUFPOOL_BUFFERS; i++) {
+        if (ptr == __atomic_load_n(&pool_buf[i], __ATOMIC_ACQUIRE)) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+void* esp_wolfssl_bufpool_malloc(size_t size, void* heap, int type)
+{
+    void* ptr;
+
+    (void)heap;
+
+    if (pool_is_record(type)
+            && __atomic_load_n(&pool_enabled, __ATOMIC_RELAXED)) {
+        if (size <= ESP_WOLFSSL_BUFPOOL_BUFFER_SZ) {
+            ptr = pool_borrow();
+            if (ptr != NULL) {
+                return ptr;
+            }
+        }
+        __atomic_add_fetch(&pool_fallbacks, 1, __ATOMIC_RELAXED);
+    }
+    return POOL_NEXT_MALLOC(size, heap, type);
+}
+
+void esp_wolfssl_bufpool_free(void* ptr, void* heap, int type)
+{
+    int i;
+
+    (void)heap;
+    (void)type;
+
+    if (ptr == NULL) {
+        return;
+    }
+    i = pool_index(ptr);
+    if (i >= 0) {
+        pool_release(i);
+        return;
+    }
+    POOL_NEXT_FREE(ptr, heap, type);
+}
+
+void* esp_wolfssl_bufpool_realloc(void* ptr, size_t size, void* heap,
+                                  int type)
+{
+    void* grown;
+    int i;
+
+    (void)heap;
+
+    if (ptr == NULL) {
+        return esp_wolfssl_bufpool_malloc(size, heap, type);
+    }
+    i = pool_index(ptr);
+    if (i < 0) {
+        return POOL_NEXT_REALLOC(ptr, size, heap, type);
+    }
+    if (size == 0) {
+        pool_release(i);
+        return NULL;
+    }
+    if (size <= ESP_WOLFSSL_BUFPOOL_BUFFER_SZ) {
+        return ptr;
+    }
+    grown = POOL_NEXT_MALLOC(size, heap, type);
+    if (grown != NULL) {
+        memcpy(grown, ptr, ESP_WOLFSSL_BUFPOOL_BUFFER_SZ);
+        pool_release(i);
+    }
+    return grown;
+}
+
+void esp_wolfssl_bufpool_set_enabled(int enabled)
+{
+    __atomic_store_n(&pool_enabled, enabled ? 1 : 0, __ATOMIC_RELAXED);
+}
+
+void esp_wolfssl_bufpool_trim(void)
+{
+    unsigned char* buf;
+    uint32_t claimed = 0;
+    int i;
+
+    /* claim every free buffer so none is borrowed while it is freed */
+    while ((i = pool_claim()) >= 0) {
+        claimed |= 1u << i;
+        buf = __atomic_exchange_n(&pool_buf[i], NULL, __ATOMIC_ACQ_REL);
+        if (buf != NULL) {
+            POOL_NATIVE_FREE(buf);
+            __atomic_sub_fetch(&pool_buffers, 1, __ATOMIC_RELAXED);
+        }
+    }
+    __atomic_and_fetch(&pool_used, ~claimed, __ATOMIC_RELEASE);
+}
+
+void esp_wolfssl_bufpool_get_stats(esp_wolfssl_bufpool_stats_t* stats)
+{
+    if (stats == NULL) {
+        return;
+    }
+    stats->buffers     = __atomic_load_n(&pool_buffers, __ATOMIC_RELAXED);
+    stats->in_use      = (uint32_t)__builtin_popcount(
+                            __atomic_load_n(&pool_used, __ATOMIC_RELAXED));
+    stats->peak_in_use = __atomic_load_n(&pool_peak, __ATOMIC_RELAXED);
+    stats->borrows     = __atomic_load_n(&pool_borrows, __ATOMIC_RELAXED);
+    stats->fallbacks   = __atomic_load_n(&pool_fallbacks, __ATOMIC_RELAXED);
+}
+
+void esp_wolfssl_bufpool_reset_stats(void)
+{
+    __atomic_store_n(&pool_peak, (uint32_t)__builtin_popcount(
+                        __atomic_load_n(&pool_used, __ATOMIC_RELAXED)),
+                     __ATOMIC_RELAXED);
+    __atomic_store_n(&pool_borrows, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&pool_fallbacks, 0, __ATOMIC_RELAXED);
+}
+
+#endif /* WOLFSSL_ESP_BUFPOOL */
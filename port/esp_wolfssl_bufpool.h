@@ -0,0 +1,92 @@
+/* esp_wolfssl_bufpool.h
+ *
+ * Copyright (C) 2006-2024 wolfSSL Inc.
+ *
+ * This file is part of wolfSSL.
+ *
+ * wolfSSL is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfSSL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335, USA
+ */
+
+/* Shared pool of TLS record buffers.
+ *
+ * Enabled with Kconfig WOLFSSL_BUFPOOL, which routes XMALLOC, XFREE and
+ * XREALLOC through the functions below (see user_settings.h), on top of
+ * the heap accounting of esp_wolfssl_mem.h when that is enabled too.
+ *
+ * wolfSSL allocates a connection's input buffer when a record does not fit
+ * the few bytes of its static buffer and frees it again once a read left
+ * no partial record behind; the output buffer likewise lives from a write
+ * until everything buffered is sent. An idle connection thus holds no
+ * record buffer, but every record costs a malloc / free pair of up to
+ * 17 KB, and many connections fragment the heap until a full record no
+ * longer fits. The pool serves these allocations from at most
+ * ESP_WOLFSSL_BUFPOOL_BUFFERS fixed buffers of ESP_WOLFSSL_BUFPOOL_BUFFER_SZ
+ * bytes that are borrowed per record and returned, not freed, so the
+ * record buffers of any number of connections take a bounded, unfragmented
+ * amount of heap. Buffers are allocated on first use; when all are
+ * borrowed, or a buffer is larger, the heap is used as before.
+ *
+ * The header carries no wolfSSL dependencies, as it is included from
+ * user_settings.h. For a Linux host build define WOLFSSL_ESP_BUFPOOL and
+ * the same XMALLOC macros in the host user_settings.h.
+ */
+
+#ifndef _ESP_WOLFSSL_BUFPOOL_H_
+#define _ESP_WOLFSSL_BUFPOOL_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef ESP_WOLFSSL_BUFPOOL_BUFFERS
+    #define ESP_WOLFSSL_BUFPOOL_BUFFERS   4
+#endif
+/* a full 16 KB record with header, MAC and padding */
+#ifndef ESP_WOLFSSL_BUFPOOL_BUFFER_SZ
+    #define ESP_WOLFSSL_BUFPOOL_BUFFER_SZ 17408
+#endif
+
+typedef struct esp_wolfssl_bufpool_stats_t {
+    uint32_t buffers;       /* allocated pool buffers */
+    uint32_t in_use;        /* currently borrowed */
+    uint32_t peak_in_use;
+    uint32_t borrows;       /* record buffers served from the pool */
+    uint32_t fallbacks;     /* record buffers served from the heap */
+} esp_wolfssl_bufpool_stats_t;
+
+/* XMALLOC / XFREE / XREALLOC replacements. */
+void* esp_wolfssl_bufpool_malloc(size_t size, void* heap, int type);
+void  esp_wolfssl_bufpool_free(void* ptr, void* heap, int type);
+void* esp_wolfssl_bufpool_realloc(void* ptr, size_t size, void* heap,
+                                  int type);
+
+/* With 0 new record buffers come from the heap; borrowed ones are still
+ * returned. On by default. */
+void esp_wolfssl_bufpool_set_enabled(int enabled);
+
+/* Frees the pool buffers that are not borrowed. */
+void esp_wolfssl_bufpool_trim(void);
+
+void esp_wolfssl_bufpool_get_stats(esp_wolfssl_bufpool_stats_t* stats);
+void esp_wolfssl_bufpool_reset_stats(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _ESP_WOLFSSL_BUFPOOL_H_ */
@@ -0,0 +1,586 @@
+/* esp_wolfssl_cert_view.c
+ *
+ * Copyright (C) 2006-2024 wolfSSL Inc.
+ *
+ * This file is part of wolfSSL.
+ *
+ * wolfSSL is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfSSL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335, USA
+ */
+
+#include <wolfssl/wolfcrypt/settings.h>
+
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+#include <wolfssl/wolfcrypt/types.h>
+#include <wolfssl/wolfcrypt/error-crypt.h>
+#include <wolfssl/wolfcrypt/hash.h>
+#include <wolfssl/wolfcrypt/signature.h>
+#ifdef HAVE_ECC
+    #include <wolfssl/wolfcrypt/ecc.h>
+#endif
+#ifndef NO_RSA
+    #include <wolfssl/wolfcrypt/rsa.h>
+#endif
+
+#include "esp_wolfssl_der.h"
+#include "esp_wolfssl_cert_view.h"
+
+/* dates are not checked before the clock was set: 2020-01-01 */
+#define CERT_VIEW_MIN_TIME  1577836800
+
+/* id-ce arcs, 2.5.29.n, are 0x55 0x1D n */
+#define CERT_VIEW_CE_KEY_USAGE          0x0F
+#define CERT_VIEW_CE_SUBJECT_ALT_NAME   0x11
+#define CERT_VIEW_CE_BASIC_CONSTRAINTS  0x13
+
+/* critical extensions the chain check understands or that do not affect
+ * it: subjectKeyIdentifier, keyUsage, subjectAltName, basicConstraints,
+ * certificatePolicies, authorityKeyIdentifier and extKeyUsage */
+static const uint8_t cert_view_known_ext[] = {
+    0x0E, 0x0F, 0x11, 0x13, 0x20, 0x23, 0x25
+};
+
+static const uint8_t cert_view_oid_cn[] = { 0x55, 0x04, 0x03 };
+
+typedef struct cert_view_sig_alg {
+    uint8_t oid[9];
+    uint8_t oid_sz;
+    uint8_t ecdsa;
+    enum wc_HashType hash;
+} cert_view_sig_alg;
+
+static const cert_view_sig_alg cert_view_sig_algs[] = {
+    { { 0x2A, 0x86, 0x48, 0xCE, 0x3D, 0x04, 0x03, 0x02 }, 8, 1,
+      WC_HASH_TYPE_SHA256 },
+    { { 0x2A, 0x86, 0x48, 0x86, 0xF7, 0x0D, 0x01, 0x01, 0x0B }, 9, 0,
+      WC_HASH_TYPE_SHA256 },
+#ifdef WOLFSSL_SHA384
+    { { 0x2A, 0x86, 0x48, 0xCE, 0x3D, 0x04, 0x03, 0x03 }, 8, 1,
+      WC_HASH_TYPE_SHA384 },
+    { { 0x2A, 0x86, 0x48, 0x86, 0xF7, 0x0D, 0x01, 0x01, 0x0C }, 9, 0,
+      WC_HASH_TYPE_SHA384 },
+#endif
+#ifdef WOLFSSL_SHA512
+    { { 0x2A, 0x86, 0x48, 0xCE, 0x3D, 0x04, 0x03, 0x04 }, 8, 1,
+      WC_HASH_TYPE_SHA512 },
+    { { 0x2A, 0x86, 0x48, 0x86, 0xF7, 0x0D, 0x01, 0x01, 0x0D }, 9, 0,
+      WC_HASH_TYPE_SHA512 },
+#endif
+};
+
+static int cert_view_eq(const esp_wolfssl_der_t* a, const uint8_t* p,
+                        size_t sz)
+{
+    return a->len == sz && XMEMCMP(a->p, p, sz) == 0;
+}
+
+static int cert_view_is_ce(const esp_wolfssl_der_t* oid, uint8_t arc)
+{
+    return oid->len == 3 && oid->p[0] == 0x55 && oid->p[1] == 0x1D
+        && oid->p[2] == arc;
+}
+
+int esp_wolfssl_cert_view_parse(const unsigned char* der, size_t sz,
+                                esp_wolfssl_cert_view_t* v)
+{
+    esp_wolfssl_der_t d;
+    esp_wolfssl_der_t tbs;
+    esp_wolfssl_der_t t;
+    uint8_t tag;
+
+    if (der == NULL || v == NULL) {
+        return BAD_FUNC_ARG;
+    }
+    XMEMSET(v, 0, sizeof(*v));
+    v->version = 1;
+
+    /* Certificate: tbsCertificate, signatureAlgorithm, signatureValue */
+    esp_wolfssl_der_init(&d, der, sz);
+    if (esp_wolfssl_der_next(&d, &tag, &d, &v->der) != 0
+        || tag != ESP_WOLFSSL_DER_SEQUENCE
+        || esp_wolfssl_der_next(&d, &tag, &tbs, &v->tbs) != 0
+        || tag != ESP_WOLFSSL_DER_SEQUENCE
+        || esp_wolfssl_der_expect(&d, ESP_WOLFSSL_DER_SEQUENCE, &t) != 0
+        || esp_wolfssl_der_expect(&t, ESP_WOLFSSL_DER_OID, &v->sig_oid) != 0
+        || esp_wolfssl_der_expect(&d, ESP_WOLFSSL_DER_BIT_STRING,
+                                  &v->sig) != 0
+        || v->sig.len < 2 || v->sig.p[0] != 0) {
+        return ASN_PARSE_E;
+    }
+    v->sig.p++;
+    v->sig.len--;
+
+    if (esp_wolfssl_der_peek(&tbs) == ESP_WOLFSSL_DER_CONTEXT(0)) {
+        if (esp_wolfssl_der_next(&tbs, NULL, &t, NULL) != 0
+            || esp_wolfssl_der_expect(&t, ESP_WOLFSSL_DER_INTEGER, &t) != 0
+            || t.len != 1 || t.p[0] > 2) {
+            return ASN_PARSE_E;
+        }
+        v->version = t.p[0] + 1;
+    }
+    /* serialNumber, signature, issuer, validity, subject, key */
+    if (esp_wolfssl_der_expect(&tbs, ESP_WOLFSSL_DER_INTEGER,
+                               &v->serial) != 0
+        || esp_wolfssl_der_expect(&tbs, ESP_WOLFSSL_DER_SEQUENCE, NULL) != 0
+        || esp_wolfssl_der_peek(&tbs) != ESP_WOLFSSL_DER_SEQUENCE
+        || esp_wolfssl_der_next(&tbs, NULL, NULL, &v->issuer) != 0
+        || esp_wolfssl_der_expect(&tbs, ESP_WOLFSSL_DER_SEQUENCE,
+                                  &v->validity) != 0
+        || esp_wolfssl_der_peek(&tbs) != ESP_WOLFSSL_DER_SEQUENCE
+        || esp_wolfssl_der_next(&tbs, NULL, NULL, &v->subject) != 0
+        || esp_wolfssl_der_peek(&tbs) != ESP_WOLFSSL_DER_SEQUENCE
+        || esp_wolfssl_der_next(&tbs, NULL, NULL, &v->spki) != 0) {
+        return ASN_PARSE_E;
+    }
+    /* issuerUniqueID, subjectUniqueID, extensions */
+    (void)esp_wolfssl_der_skip_optional(&tbs,
+                                        ESP_WOLFSSL_DER_CONTEXT_PRIM(1));
+    (void)esp_wolfssl_der_skip_optional(&tbs,
+                                        ESP_WOLFSSL_DER_CONTEXT_PRIM(2));
+    if (esp_wolfssl_der_peek(&tbs) == ESP_WOLFSSL_DER_CONTEXT(3)) {
+        if (esp_wolfssl_der_next(&tbs, NULL, &t, NULL) != 0
+            || esp_wolfssl_der_expect(&t, ESP_WOLFSSL_DER_SEQUENCE,
+                                      &v->extensions) != 0) {
+            return ASN_PARSE_E;
+        }
+    }
+    return 0;
+}
+
+int esp_wolfssl_cert_view_validity(const esp_wolfssl_cert_view_t* v,
+                                   int64_t* not_before, int64_t* not_after)
+{
+    esp_wolfssl_der_t d = v->validity;
+    esp_wolfssl_der_t t;
+    uint8_t tag;
+
+    if (esp_wolfssl_der_next(&d, &tag, &t, NULL) != 0
+        || esp_wolfssl_der_time(tag, &t, not_before) != 0
+        || esp_wolfssl_der_next(&d, &tag, &t, NULL) != 0
+        || esp_wolfssl_der_time(tag, &t, not_after) != 0) {
+        return ASN_PARSE_E;
+    }
+    return 0;
+}
+
+int esp_wolfssl_cert_view_name_attr(const esp_wolfssl_der_t* name,
+                                    const uint8_t* oid, size_t oid_sz,
+                                    esp_wolfssl_der_t* value)
+{
+    esp_wolfssl_der_t d = *name;
+    esp_wolfssl_der_t rdn;
+    esp_wolfssl_der_t atv;
+    esp_wolfssl_der_t type;
+    esp_wolfssl_der_t val;
+    int found = 0;
+
+    /* SEQUENCE OF SET OF { type, value } */
+    if (esp_wolfssl_der_expect(&d, ESP_WOLFSSL_DER_SEQUENCE, &d) != 0) {
+        return ASN_PARSE_E;
+    }
+    while (esp_wolfssl_der_peek(&d) >= 0) {
+        if (esp_wolfssl_der_expect(&d, ESP_WOLFSSL_DER_SET, &rdn) != 0) {
+            return ASN_PARSE_E;
+        }
+        while (esp_wolfssl_der_peek(&rdn) >= 0) {
+            if (esp_wolfssl_der_expect(&rdn, ESP_WOLFSSL_DER_SEQUENCE,
+                                       &atv) != 0
+                || esp_wolfssl_der_expect(&atv, ESP_WOLFSSL_DER_OID,
+                                          &type) != 0
+                || esp_wolfssl_der_next(&atv, NULL, &val, NULL) != 0) {
+                return ASN_PARSE_E;
+            }
+            if (cert_view_eq(&type, oid, oid_sz)) {
+                *value = val;
+                found = 1;
+            }
+        }
+    }
+    return found;
+}
+
+int esp_wolfssl_cert_view_ext(const esp_wolfssl_cert_view_t* v,
+                              const uint8_t* oid, size_t oid_sz,
+                              esp_wolfssl_der_t* value, int* critical)
+{
+    esp_wolfssl_der_t d = v->extensions;
+    esp_wolfssl_der_t ext;
+    esp_wolfssl_der_t id;
+    esp_wolfssl_der_t b;
+    esp_wolfssl_der_t val;
+    int crit;
+
+    /* Extension: extnID, critical DEFAULT FALSE, extnValue */
+    while (esp_wolfssl_der_peek(&d) >= 0) {
+        crit = 0;
+        if (esp_wolfssl_der_expect(&d, ESP_WOLFSSL_DER_SEQUENCE, &ext) != 0
+            || esp_wolfssl_der_expect(&ext, ESP_WOLFSSL_DER_OID, &id) != 0) {
+            return ASN_PARSE_E;
+        }
+        if (esp_wolfssl_der_peek(&ext) == ESP_WOLFSSL_DER_BOOLEAN) {
+            if (esp_wolfssl_der_expect(&ext, ESP_WOLFSSL_DER_BOOLEAN,
+                                       &b) != 0 || b.len != 1) {
+                return ASN_PARSE_E;
+            }
+            crit = (b.p[0] != 0);
+        }
+        if (esp_wolfssl_der_expect(&ext, ESP_WOLFSSL_DER_OCTET_STRING,
+                                   &val) != 0) {
+            return ASN_PARSE_E;
+        }
+        if (cert_view_eq(&id, oid, oid_sz)) {
+            if (value != NULL) {
+                *value = val;
+            }
+            if (critical != NULL) {
+                *critical = crit;
+            }
+            return 1;
+        }
+    }
+    return 0;
+}
+
+int esp_wolfssl_cert_view_basic_constraints(const esp_wolfssl_cert_view_t* v,
+                                            int* ca, int* path_len)
+{
+    const uint8_t oid[] = { 0x55, 0x1D, CERT_VIEW_CE_BASIC_CONSTRAINTS };
+    esp_wolfssl_der_t d;
+    esp_wolfssl_der_t t;
+    int ret;
+
+    *ca = 0;
+    *path_len = -1;
+    ret = esp_wolfssl_cert_view_ext(v, oid, sizeof(oid), &d, NULL);
+    if (ret != 1) {
+        return ret;
+    }
+    /* SEQUENCE { cA DEFAULT FALSE, pathLenConstraint OPTIONAL } */
+    if (esp_wolfssl_der_expect(&d, ESP_WOLFSSL_DER_SEQUENCE, &d) != 0) {
+        return ASN_PARSE_E;
+    }
+    if (esp_wolfssl_der_peek(&d) == ESP_WOLFSSL_DER_BOOLEAN) {
+        if (esp_wolfssl_der_expect(&d, ESP_WOLFSSL_DER_BOOLEAN, &t) != 0
+            || t.len != 1) {
+            return ASN_PARSE_E;
+        }
+        *ca = (t.p[0] != 0);
+    }
+    if (esp_wolfssl_der_peek(&d) == ESP_WOLFSSL_DER_INTEGER) {
+        if (esp_wolfssl_der_expect(&d, ESP_WOLFSSL_DER_INTEGER, &t) != 0
+            || t.len < 1 || t.len > 2 || (t.p[0] & 0x80)) {
+            return ASN_PARSE_E;
+        }
+        *path_len = (t.len == 1) ? t.p[0] : ((t.p[0] << 8) | t.p[1]);
+    }
+    return 1;
+}
+
+int esp_wolfssl_cert_view_key_usage(const esp_wolfssl_cert_view_t* v,
+                                    unsigned* usage)
+{
+    const uint8_t oid[] = { 0x55, 0x1D, CERT_VIEW_CE_KEY_USAGE };
+    esp_wolfssl_der_t d;
+    size_t i;
+    int ret;
+
+    *usage = 0;
+    ret = esp_wolfssl_cert_view_ext(v, oid, sizeof(oid), &d, NULL);
+    if (ret != 1) {
+        return ret;
+    }
+    /* BIT STRING, bit 0 is the most significant bit of the first byte */
+    if (esp_wolfssl_der_expect(&d, ESP_WOLFSSL_DER_BIT_STRING, &d) != 0
+        || d.len < 1 || d.p[0] > 7) {
+        return ASN_PARSE_E;
+    }
+    for (i = 0; i < 9 && 1 + i / 8 < d.len; i++) {
+        if (d.p[1 + i / 8] & (0x80 >> (i % 8))) {
+            *usage |= 1u << i;
+        }
+    }
+    return 1;
+}
+
+static int cert_view_lower(int c)
+{
+    return (c >= 'A' && c <= 'Z') ? c + ('a' - 'A') : c;
+}
+
+/* a dNSName or commonName against a host name */
+static int cert_view_match_name(const esp_wolfssl_der_t* name,
+                                const char* host)
+{
+    const uint8_t* p = name->p;
+    size_t len = name->len;
+    const char* dot;
+    size_t host_len;
+    size_t i;
+
+    if (len >= 3 && p[0] == '*' && p[1] == '.') {
+        /* the wildcard stands for exactly one non-empty label */
+        dot = strchr(host, '.');
+        if (dot == NULL || dot == host) {
+            return 0;
+        }
+        host = dot;
+        p++;
+        len--;
+    }
+    host_len = strlen(host);
+    if (len == 0 || len != host_len) {
+        return 0;
+    }
+    for (i = 0; i < len; i++) {
+        if (cert_view_lower(p[i]) != cert_view_lower((uint8_t)host[i])) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+int esp_wolfssl_cert_view_match_host(const esp_wolfssl_cert_view_t* v,
+                                     const char* host)
+{
+    const uint8_t oid[] = { 0x55, 0x1D, CERT_VIEW_CE_SUBJECT_ALT_NAME };
+    esp_wolfssl_der_t d;
+    esp_wolfssl_der_t name;
+    uint8_t tag;
+    int dns = 0;
+
+    if (v == NULL || host == NULL || host[0] == '\0') {
+        return 0;
+    }
+    if (esp_wolfssl_cert_view_ext(v, oid, sizeof(oid), &d, NULL) == 1
+        && esp_wolfssl_der_expect(&d, ESP_WOLFSSL_DER_SEQUENCE, &d) == 0) {
+        /* GeneralNames, dNSName is [2] IA5String */
+        while (esp_wolfssl_der_next(&d, &tag, &name, NULL) == 0) {
+            if (tag == ESP_WOLFSSL_DER_CONTEXT_PRIM(2)) {
+                if (cert_view_match_name(&name, host)) {
+                    return 1;
+                }
+                dns = 1;
+            }
+        }
+    }
+    if (!dns && esp_wolfssl_cert_view_name_attr(&v->subject,
+                                                cert_view_oid_cn,
+                                                sizeof(cert_view_oid_cn),
+                                                &name) == 1) {
+        return cert_view_match_name(&name, host);
+    }
+    return 0;
+}
+
+int esp_wolfssl_cert_view_verify_sig(const esp_wolfssl_der_t* spki,
+                                     const esp_wolfssl_der_t* tbs,
+                                     const esp_wolfssl_der_t* sig_oid,
+                                     const esp_wolfssl_der_t* sig)
+{
+    const cert_view_sig_alg* alg = NULL;
+    word32 idx = 0;
+    int ret = ASN_SIG_CONFIRM_E;
+    size_t i;
+
+    for (i = 0; i < sizeof(cert_view_sig_algs) / sizeof(*cert_view_sig_algs);
+         i++) {
+        if (cert_view_eq(sig_oid, cert_view_sig_algs[i].oid,
+                         cert_view_sig_algs[i].oid_sz)) {
+            alg = &cert_view_sig_algs[i];
+            break;
+        }
+    }
+    if (alg == NULL) {
+        return ASN_SIG_OID_E;
+    }
+
+    if (alg->ecdsa) {
+#ifdef HAVE_ECC
+        ecc_key* key = (ecc_key*)XMALLOC(sizeof(ecc_key), NULL,
+                                         DYNAMIC_TYPE_ECC);
+        if (key == NULL) {
+            return MEMORY_E;
+        }
+        if (wc_ecc_init(key) == 0) {
+            if (wc_EccPublicKeyDecode(spki->p, &idx, key,
+                                      (word32)spki->len) == 0
+                && wc_SignatureVerify(alg->hash, WC_SIGNATURE_TYPE_ECC,
+                                      tbs->p, (word32)tbs->len,
+                                      sig->p, (word32)sig->len,
+                                      key, sizeof(*key)) == 0) {
+                ret = 0;
+            }
+            wc_ecc_free(key);
+        }
+        XFREE(key, NULL, DYNAMIC_TYPE_ECC);
+#else
+        ret = ASN_SIG_OID_E;
+#endif
+    }
+    else {
+#ifndef NO_RSA
+        RsaKey* key = (RsaKey*)XMALLOC(sizeof(RsaKey), NULL,
+                                       DYNAMIC_TYPE_RSA);
+        if (key == NULL) {
+            return MEMORY_E;
+        }
+        if (wc_InitRsaKey(key, NULL) == 0) {
+            if (wc_RsaPublicKeyDecode(spki->p, &idx, key,
+                                      (word32)spki->len) == 0
+                && wc_SignatureVerify(alg->hash, WC_SIGNATURE_TYPE_RSA_W_ENC,
+                                      tbs->p, (word32)tbs->len,
+                                      sig->p, (word32)sig->len,
+                                      key, sizeof(*key)) == 0) {
+                ret = 0;
+            }
+            wc_FreeRsaKey(key);
+        }
+        XFREE(key, NULL, DYNAMIC_TYPE_RSA);
+#else
+        ret = ASN_SIG_OID_E;
+#endif
+    }
+
+    return ret;
+}
+
+static int cert_view_check_exts(const esp_wolfssl_cert_view_t* v)
+{
+    esp_wolfssl_der_t d = v->extensions;
+    esp_wolfssl_der_t ext;
+    esp_wolfssl_der_t id;
+    esp_wolfssl_der_t b;
+    size_t i;
+
+    while (esp_wolfssl_der_peek(&d) >= 0) {
+        if (esp_wolfssl_der_expect(&d, ESP_WOLFSSL_DER_SEQUENCE, &ext) != 0
+            || esp_wolfssl_der_expect(&ext, ESP_WOLFSSL_DER_OID, &id) != 0) {
+            return ASN_PARSE_E;
+        }
+        if (esp_wolfssl_der_expect(&ext, ESP_WOLFSSL_DER_BOOLEAN, &b) != 0
+            || b.len != 1 || b.p[0] == 0) {
+            continue;
+        }
+        for (i = 0; i < sizeof(cert_view_known_ext); i++) {
+            if (cert_view_is_ce(&id, cert_view_known_ext[i])) {
+                break;
+            }
+        }
+        if (i == sizeof(cert_view_known_ext)) {
+            return ASN_CRIT_EXT_E;
+        }
+    }
+    return 0;
+}
+
+static int cert_view_check_dates(const esp_wolfssl_cert_view_t* v,
+                                 int64_t now)
+{
+    int64_t not_before;
+    int64_t not_after;
+
+    if (now < CERT_VIEW_MIN_TIME) {
+        return 0;
+    }
+    if (esp_wolfssl_cert_view_validity(v, &not_before, &not_after) != 0) {
+        return ASN_PARSE_E;
+    }
+    if (now < not_before) {
+        return ASN_BEFORE_DATE_E;
+    }
+    if (now > not_after) {
+        return ASN_AFTER_DATE_E;
+    }
+    return 0;
+}
+
+/* issuer of a certificate with below CA certificates under it */
+static int cert_view_check_issuer(const esp_wolfssl_cert_view_t* issuer,
+                                  size_t below, int anchor)
+{
+    unsigned usage;
+    int path_len;
+    int ca;
+    int ret;
+
+    ret = esp_wolfssl_cert_view_basic_constraints(issuer, &ca, &path_len);
+    if (ret < 0) {
+        return ret;
+    }
+    /* an X.509 v1 trust anchor has no extensions to say it is a CA */
+    if (!ca && !(anchor && issuer->version < 3)) {
+        return ASN_NO_SIGNER_E;
+    }
+    if (path_len >= 0 && below > (size_t)path_len) {
+        return ASN_PATHLEN_INV_E;
+    }
+    ret = esp_wolfssl_cert_view_key_usage(issuer, &usage);
+    if (ret < 0) {
+        return ret;
+    }
+    if (ret == 1 && !(usage & ESP_WOLFSSL_KU_KEY_CERT_SIGN)) {
+        return KEYUSAGE_E;
+    }
+    return 0;
+}
+
+int esp_wolfssl_cert_view_verify_chain(const esp_wolfssl_cert_view_t* chain,
+                                       size_t n,
+                                       const esp_wolfssl_cert_view_t* anchor)
+{
+    const esp_wolfssl_cert_view_t* cert;
+    const esp_wolfssl_cert_view_t* issuer;
+    int64_t now = (int64_t)time(NULL);
+    int ret = 0;
+    size_t i;
+
+    if (chain == NULL || n == 0 || anchor == NULL) {
+        return BAD_FUNC_ARG;
+    }
+
+    for (i = 0; i < n && ret == 0; i++) {
+        cert = &chain[i];
+        if (cert_view_eq(&cert->der, anchor->der.p, anchor->der.len)) {
+            break;
+        }
+        issuer = (i + 1 < n) ? &chain[i + 1] : anchor;
+
+        ret = cert_view_check_exts(cert);
+        if (ret == 0) {
+            ret = cert_view_check_dates(cert, now);
+        }
+        if (ret == 0 && !cert_view_eq(&cert->issuer, issuer->subject.p,
+                                      issuer->subject.len)) {
+            ret = ASN_NO_SIGNER_E;
+        }
+        if (ret == 0) {
+            ret = cert_view_check_issuer(issuer, i,
+                                         cert_view_eq(&issuer->der,
+                                                      anchor->der.p,
+                                                      anchor->der.len));
+        }
+        if (ret == 0) {
+            ret = esp_wolfssl_cert_view_verify_sig(&issuer->spki, &cert->tbs,
+                                                   &cert->sig_oid,
+                                                   &cert->sig);
+        }
+    }
+    if (ret == 0) {
+        ret = cert_view_check_dates(anchor, now);
+    }
+    return ret;
+}
@@ -0,0 +1,148 @@
+/* esp_wolfssl_cert_view.h
+ *
+ * Copyright (C) 2006-2024 wolfSSL Inc.
+ *
+ * This file is part of wolfSSL.
+ *
+ * wolfSSL is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfSSL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335, USA
+ */
+
+/* Lazy, allocation-free view of a DER certificate.
+ *
+ * wolfSSL's ParseCert() decodes a whole certificate into a DecodedCert of
+ * over a KB, copying names, extensions and the public key, even when the
+ * caller only needs an issuer and a key. Parsing a view instead walks the
+ * certificate once and records where its fields are in the DER buffer;
+ * names, extensions and the key are decoded only when they are asked for,
+ * so checking a chain touches only what the checks need. The view points
+ * into the buffer, which must outlive it, e.g. a certificate in flash:
+ *
+ *   esp_wolfssl_cert_view_t leaf, ca;
+ *
+ *   esp_wolfssl_cert_view_parse(leaf_der, leaf_sz, &leaf);
+ *   esp_wolfssl_cert_view_parse(ca_der, ca_sz, &ca);
+ *   if (esp_wolfssl_cert_view_verify_chain(&leaf, 1, &ca) == 0
+ *       && esp_wolfssl_cert_view_match_host(&leaf, "example.com") == 1) {
+ *       ...
+ *   }
+ *
+ * The port's CRL index, raw public key pinning and PKCS#7 stream decoder
+ * use it to look into certificates. Handshake verification is unchanged:
+ * wolfSSL still decodes every certificate of a peer's chain into a full
+ * DecodedCert with ParseCertRelative(). Everything is a window into the
+ * buffer, nothing is checked for well-formedness until it is decoded.
+ */
+
+#ifndef _ESP_WOLFSSL_CERT_VIEW_H_
+#define _ESP_WOLFSSL_CERT_VIEW_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esp_wolfssl_der.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* KeyUsage bits, 1 << the bit number of RFC 5280 4.2.1.3 */
+#define ESP_WOLFSSL_KU_DIGITAL_SIGNATURE  0x0001
+#define ESP_WOLFSSL_KU_NON_REPUDIATION    0x0002
+#define ESP_WOLFSSL_KU_KEY_ENCIPHERMENT   0x0004
+#define ESP_WOLFSSL_KU_DATA_ENCIPHERMENT  0x0008
+#define ESP_WOLFSSL_KU_KEY_AGREEMENT      0x0010
+#define ESP_WOLFSSL_KU_KEY_CERT_SIGN      0x0020
+#define ESP_WOLFSSL_KU_CRL_SIGN           0x0040
+
+typedef struct esp_wolfssl_cert_view_t {
+    esp_wolfssl_der_t der;          /* whole certificate */
+    esp_wolfssl_der_t tbs;          /* whole encoding, what is signed */
+    esp_wolfssl_der_t serial;       /* INTEGER contents */
+    esp_wolfssl_der_t issuer;       /* whole Name encoding */
+    esp_wolfssl_der_t validity;     /* SEQUENCE contents */
+    esp_wolfssl_der_t subject;      /* whole Name encoding */
+    esp_wolfssl_der_t spki;         /* whole SubjectPublicKeyInfo */
+    esp_wolfssl_der_t extensions;   /* SEQUENCE OF contents, empty if none */
+    esp_wolfssl_der_t sig_oid;      /* outer signatureAlgorithm OID */
+    esp_wolfssl_der_t sig;          /* BIT STRING, without unused bits */
+    int               version;      /* 1, 2 or 3 */
+} esp_wolfssl_cert_view_t;
+
+/* Records the fields of a DER certificate. Returns 0, or BAD_FUNC_ARG or
+ * ASN_PARSE_E when the outer structure is not a certificate. */
+int esp_wolfssl_cert_view_parse(const unsigned char* der, size_t sz,
+                                esp_wolfssl_cert_view_t* v);
+
+/* notBefore and notAfter, seconds since 1970. Returns 0 or ASN_PARSE_E. */
+int esp_wolfssl_cert_view_validity(const esp_wolfssl_cert_view_t* v,
+                                   int64_t* not_before, int64_t* not_after);
+
+/* Value of the last attribute of the given type in a Name, e.g. the
+ * commonName 2.5.4.3 as { 0x55, 0x04, 0x03 }, as the contents of its
+ * string. Returns 1 when found, 0 when not, or ASN_PARSE_E. */
+int esp_wolfssl_cert_view_name_attr(const esp_wolfssl_der_t* name,
+                                    const uint8_t* oid, size_t oid_sz,
+                                    esp_wolfssl_der_t* value);
+
+/* extnValue OCTET STRING contents of an extension and whether it is
+ * critical; value and critical may be NULL. Returns 1 when found, 0 when
+ * not, or ASN_PARSE_E. */
+int esp_wolfssl_cert_view_ext(const esp_wolfssl_cert_view_t* v,
+                              const uint8_t* oid, size_t oid_sz,
+                              esp_wolfssl_der_t* value, int* critical);
+
+/* BasicConstraints: cA, and the pathLenConstraint or -1 without one.
+ * Returns 1 when present, 0 when not (ca is then 0), or ASN_PARSE_E. */
+int esp_wolfssl_cert_view_basic_constraints(const esp_wolfssl_cert_view_t* v,
+                                            int* ca, int* path_len);
+
+/* KeyUsage as ESP_WOLFSSL_KU_* bits. Returns 1 when present, 0 when not,
+ * or ASN_PARSE_E. */
+int esp_wolfssl_cert_view_key_usage(const esp_wolfssl_cert_view_t* v,
+                                    unsigned* usage);
+
+/* 1 if the host name matches a dNSName of the subjectAltName, or the
+ * commonName when there is no dNSName, 0 otherwise. A wildcard is only
+ * accepted as the whole leftmost label, "*.example.com"; names compare
+ * without regard to case. */
+int esp_wolfssl_cert_view_match_host(const esp_wolfssl_cert_view_t* v,
+                                     const char* host);
+
+/* Signature over tbs with signature algorithm sig_oid, checked with the
+ * SubjectPublicKeyInfo spki: ECDSA or RSA PKCS#1 v1.5 with SHA-256, -384
+ * or -512. Certificates, CRLs and OCSP responses are all signed this way.
+ * Returns 0, ASN_SIG_OID_E, ASN_SIG_CONFIRM_E or MEMORY_E. */
+int esp_wolfssl_cert_view_verify_sig(const esp_wolfssl_der_t* spki,
+                                     const esp_wolfssl_der_t* tbs,
+                                     const esp_wolfssl_der_t* sig_oid,
+                                     const esp_wolfssl_der_t* sig);
+
+/* Checks chain[0], the leaf, up to the trusted anchor: each certificate
+ * must be issued by the next one, by name and signature, and the issuers
+ * must be CAs allowed to sign certificates within their path length. The
+ * anchor may be the last certificate of the chain itself. Validity is
+ * checked once the clock is set, unknown critical extensions are refused.
+ * Returns 0, ASN_NO_SIGNER_E, ASN_SIG_CONFIRM_E, ASN_SIG_OID_E,
+ * ASN_BEFORE_DATE_E, ASN_AFTER_DATE_E, ASN_CRIT_EXT_E, KEYUSAGE_E,
+ * ASN_PATHLEN_INV_E, ASN_PARSE_E or MEMORY_E. */
+int esp_wolfssl_cert_view_verify_chain(const esp_wolfssl_cert_view_t* chain,
+                                       size_t n,
+                                       const esp_wolfssl_cert_view_t* anchor);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _ESP_WOLFSSL_CERT_VIEW_H_ */
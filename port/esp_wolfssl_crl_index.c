@@ -0,0 +1,525 @@
+/* esp_wolfssl_crl_index.c
+ *
+ * Copyright (C) 2006-2024 wolfSSL Inc.
+ *
+ * This file is part of wolfSSL.
+ *
+ * wolfSSL is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfSSL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335, USA
+ */
+
+#include <wolfssl/wolfcrypt/settings.h>
+
+#ifdef WOLFSSL_ESP_CRL_INDEX
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <wolfssl/ssl.h>
+#include <wolfssl/error-ssl.h>
+#include <wolfssl/wolfcrypt/types.h>
+#include <wolfssl/wolfcrypt/error-crypt.h>
+#include <wolfssl/wolfcrypt/hash.h>
+#include <wolfssl/wolfcrypt/wc_port.h>
+
+#include "esp_wolfssl_der.h"
+#include "esp_wolfssl_cert_view.h"
+#include "esp_wolfssl_crl_index.h"
+
+/* bytes per entry of an index built here */
+#ifndef ESP_WOLFSSL_CRL_INDEX_HASH_SZ
+    #define ESP_WOLFSSL_CRL_INDEX_HASH_SZ   4
+#endif
+#ifndef ESP_WOLFSSL_CRL_INDEX_MAX
+    #define ESP_WOLFSSL_CRL_INDEX_MAX       4
+#endif
+
+#if ESP_WOLFSSL_CRL_INDEX_HASH_SZ < 4 \
+    || ESP_WOLFSSL_CRL_INDEX_HASH_SZ > WC_SHA256_DIGEST_SIZE
+    #error ESP_WOLFSSL_CRL_INDEX_HASH_SZ must be 4 to 32
+#endif
+
+/* dates are not checked before the clock was set: 2020-01-01 */
+#define CRL_INDEX_MIN_TIME  1577836800
+
+struct esp_wolfssl_crl_index_t {
+    const byte* blob;
+    size_t      size;
+    const byte* entries;
+    uint32_t    count;
+    uint32_t    hash_sz;
+    int64_t     this_update;
+    int64_t     next_update;
+    byte*       owned;          /* blob built here, or NULL */
+};
+
+static esp_wolfssl_crl_index_t* crl_registry[ESP_WOLFSSL_CRL_INDEX_MAX];
+static wolfSSL_Mutex crl_mutex;
+static int crl_mutex_ok;
+
+static void __attribute__((constructor)) crl_index_init(void)
+{
+    crl_mutex_ok = (wc_InitMutex(&crl_mutex) == 0);
+}
+
+static int crl_lock(void)
+{
+    return crl_mutex_ok && wc_LockMutex(&crl_mutex) == 0;
+}
+
+static void crl_unlock(void)
+{
+    wc_UnLockMutex(&crl_mutex);
+}
+
+static void crl_put32(byte* p, uint32_t v)
+{
+    p[0] = (byte)v;
+    p[1] = (byte)(v >> 8);
+    p[2] = (byte)(v >> 16);
+    p[3] = (byte)(v >> 24);
+}
+
+static uint32_t crl_get32(const byte* p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16)
+         | ((uint32_t)p[3] << 24);
+}
+
+static void crl_put64(byte* p, int64_t v)
+{
+    crl_put32(p, (uint32_t)v);
+    crl_put32(p + 4, (uint32_t)((uint64_t)v >> 32));
+}
+
+static int64_t crl_get64(const byte* p)
+{
+    return (int64_t)((uint64_t)crl_get32(p)
+                     | ((uint64_t)crl_get32(p + 4) << 32));
+}
+
+static int crl_hash(const esp_wolfssl_der_t* d, byte* out, size_t out_sz)
+{
+    byte hash[WC_SHA256_DIGEST_SIZE];
+
+    if (wc_Sha256Hash(d->p, (word32)d->len, hash) != 0) {
+        return -1;
+    }
+    XMEMCPY(out, hash, out_sz);
+    return 0;
+}
+
+typedef struct crl_parsed {
+    esp_wolfssl_der_t tbs;      /* whole encoding, what is signed */
+    esp_wolfssl_der_t sig_oid;
+    esp_wolfssl_der_t sig;      /* BIT STRING contents */
+    esp_wolfssl_der_t issuer;   /* whole encoding */
+    esp_wolfssl_der_t revoked;  /* contents, empty if absent */
+    int64_t           this_update;
+    int64_t           next_update;
+} crl_parsed;
+
+/* CertificateList, RFC 5280 5.1 */
+static int crl_parse(const byte* der, size_t sz, crl_parsed* c)
+{
+    esp_wolfssl_der_t d;
+    esp_wolfssl_der_t tbs;
+    esp_wolfssl_der_t alg;
+    esp_wolfssl_der_t t;
+    uint8_t tag;
+    int next;
+
+    XMEMSET(c, 0, sizeof(*c));
+    esp_wolfssl_der_init(&d, der, sz);
+    if (esp_wolfssl_der_expect(&d, ESP_WOLFSSL_DER_SEQUENCE, &d) != 0
+        || esp_wolfssl_der_next(&d, &tag, &tbs, &c->tbs) != 0
+        || tag != ESP_WOLFSSL_DER_SEQUENCE
+        || esp_wolfssl_der_expect(&d, ESP_WOLFSSL_DER_SEQUENCE, &alg) != 0
+        || esp_wolfssl_der_expect(&alg, ESP_WOLFSSL_DER_OID,
+                                  &c->sig_oid) != 0
+        || esp_wolfssl_der_expect(&d, ESP_WOLFSSL_DER_BIT_STRING,
+                                  &c->sig) != 0
+        || c->sig.len < 2 || c->sig.p[0] != 0) {
+        return ASN_PARSE_E;
+    }
+    c->sig.p++;
+    c->sig.len--;
+
+    (void)esp_wolfssl_der_skip_optional(&tbs, ESP_WOLFSSL_DER_INTEGER);
+    if (esp_wolfssl_der_expect(&tbs, ESP_WOLFSSL_DER_SEQUENCE, NULL) != 0
+        || esp_wolfssl_der_next(&tbs, NULL, NULL, &c->issuer) != 0
+        || esp_wolfssl_der_next(&tbs, &tag, &t, NULL) != 0
+        || esp_wolfssl_der_time(tag, &t, &c->this_update) != 0) {
+        return ASN_PARSE_E;
+    }
+    next = esp_wolfssl_der_peek(&tbs);
+    if (next == ESP_WOLFSSL_DER_UTC_TIME
+        || next == ESP_WOLFSSL_DER_GENERALIZED_TIME) {
+        if (esp_wolfssl_der_next(&tbs, &tag, &t, NULL) != 0
+            || esp_wolfssl_der_time(tag, &t, &c->next_update) != 0) {
+            return ASN_PARSE_E;
+        }
+    }
+    if (esp_wolfssl_der_peek(&tbs) == ESP_WOLFSSL_DER_SEQUENCE
+        && esp_wolfssl_der_next(&tbs, NULL, &c->revoked, NULL) != 0) {
+        return ASN_PARSE_E;
+    }
+    return 0;
+}
+
+static int crl_entry_cmp(const void* a, const void* b)
+{
+    return XMEMCMP(a, b, ESP_WOLFSSL_CRL_INDEX_HASH_SZ);
+}
+
+/* revokedCertificates: count, and with out the serial hashes */
+static int crl_entries(const esp_wolfssl_der_t* revoked, byte* out,
+                       uint32_t* count)
+{
+    esp_wolfssl_der_t list = *revoked;
+    esp_wolfssl_der_t entry;
+    esp_wolfssl_der_t serial;
+    uint32_t n = 0;
+
+    while (list.len > 0) {
+        if (esp_wolfssl_der_expect(&list, ESP_WOLFSSL_DER_SEQUENCE,
+                                   &entry) != 0
+            || esp_wolfssl_der_expect(&entry, ESP_WOLFSSL_DER_INTEGER,
+                                      &serial) != 0) {
+            return ASN_PARSE_E;
+        }
+        if (out != NULL
+            && crl_hash(&serial, out + (size_t)n * ESP_WOLFSSL_CRL_INDEX_HASH_SZ,
+                        ESP_WOLFSSL_CRL_INDEX_HASH_SZ) != 0) {
+            return ASN_PARSE_E;
+        }
+        n++;
+    }
+    *count = n;
+    return 0;
+}
+
+static esp_wolfssl_crl_index_t* crl_index_new(const byte* blob, size_t sz)
+{
+    esp_wolfssl_crl_index_t* idx;
+
+    idx = (esp_wolfssl_crl_index_t*)XMALLOC(sizeof(*idx), NULL,
+                                            DYNAMIC_TYPE_CRL);
+    if (idx != NULL) {
+        XMEMSET(idx, 0, sizeof(*idx));
+        idx->blob = blob;
+        idx->size = sz;
+        idx->entries = blob + ESP_WOLFSSL_CRL_INDEX_HEADER_SZ;
+        idx->hash_sz = blob[5];
+        idx->count = crl_get32(blob + 8);
+        idx->this_update = crl_get64(blob + 16);
+        idx->next_update = crl_get64(blob + 24);
+    }
+    return idx;
+}
+
+int esp_wolfssl_crl_index_build(const unsigned char* crl, size_t crl_sz,
+                                const unsigned char* ca, size_t ca_sz,
+                                esp_wolfssl_crl_index_t** idx)
+{
+    crl_parsed c;
+    esp_wolfssl_cert_view_t issuer;
+    uint32_t count;
+    size_t sz;
+    byte* blob;
+    int ret;
+
+    if (crl == NULL || ca == NULL || idx == NULL) {
+        return BAD_FUNC_ARG;
+    }
+    *idx = NULL;
+
+    ret = crl_parse(crl, crl_sz, &c);
+    if (ret == 0) {
+        ret = esp_wolfssl_cert_view_parse(ca, ca_sz, &issuer);
+    }
+    if (ret == 0 && (issuer.subject.len != c.issuer.len
+                     || XMEMCMP(issuer.subject.p, c.issuer.p,
+                                c.issuer.len) != 0)) {
+        ret = ASN_CRL_NO_SIGNER_E;
+    }
+    if (ret == 0) {
+        ret = esp_wolfssl_cert_view_verify_sig(&issuer.spki, &c.tbs,
+                                               &c.sig_oid, &c.sig);
+        if (ret == ASN_SIG_CONFIRM_E) {
+            ret = ASN_CRL_CONFIRM_E;
+        }
+    }
+    if (ret == 0) {
+        ret = crl_entries(&c.revoked, NULL, &count);
+    }
+    if (ret != 0) {
+        return ret;
+    }
+
+    sz = ESP_WOLFSSL_CRL_INDEX_HEADER_SZ
+       + (size_t)count * ESP_WOLFSSL_CRL_INDEX_HASH_SZ;
+    blob = (byte*)XMALLOC(sz, NULL, DYNAMIC_TYPE_CRL);
+    if (blob == NULL) {
+        return MEMORY_E;
+    }
+    XMEMSET(blob, 0, ESP_WOLFSSL_CRL_INDEX_HEADER_SZ);
+    XMEMCPY(blob, ESP_WOLFSSL_CRL_INDEX_MAGIC, 4);
+    blob[4] = ESP_WOLFSSL_CRL_INDEX_VERSION;
+    blob[5] = ESP_WOLFSSL_CRL_INDEX_HASH_SZ;
+    crl_put32(blob + 8, count);
+    crl_put64(blob + 16, c.this_update);
+    crl_put64(blob + 24, c.next_update);
+    ret = crl_hash(&c.issuer, blob + 32, ESP_WOLFSSL_CRL_INDEX_ISSUER_SZ);
+    if (ret == 0) {
+        ret = crl_entries(&c.revoked, blob + ESP_WOLFSSL_CRL_INDEX_HEADER_SZ,
+                          &count);
+    }
+    if (ret == 0) {
+        qsort(blob + ESP_WOLFSSL_CRL_INDEX_HEADER_SZ, count,
+              ESP_WOLFSSL_CRL_INDEX_HASH_SZ, crl_entry_cmp);
+        *idx = crl_index_new(blob, sz);
+        if (*idx == NULL) {
+            ret = MEMORY_E;
+        }
+    }
+    if (ret != 0) {
+        XFREE(blob, NULL, DYNAMIC_TYPE_CRL);
+        return ret;
+    }
+
+    (*idx)->owned = blob;
+    return 0;
+}
+
+int esp_wolfssl_crl_index_open(const void* blob, size_t sz,
+                               esp_wolfssl_crl_index_t** idx)
+{
+    const byte* p = (const byte*)blob;
+    uint32_t hash_sz;
+    uint32_t count;
+    uint32_t i;
+
+    if (blob == NULL || idx == NULL) {
+        return BAD_FUNC_ARG;
+    }
+    *idx = NULL;
+
+    if (sz < ESP_WOLFSSL_CRL_INDEX_HEADER_SZ
+        || XMEMCMP(p, ESP_WOLFSSL_CRL_INDEX_MAGIC, 4) != 0
+        || p[4] != ESP_WOLFSSL_CRL_INDEX_VERSION) {
+        return ASN_PARSE_E;
+    }
+    hash_sz = p[5];
+    count = crl_get32(p + 8);
+    if (hash_sz < 4 || hash_sz > WC_SHA256_DIGEST_SIZE
+        || count > (sz - ESP_WOLFSSL_CRL_INDEX_HEADER_SZ) / hash_sz) {
+        return ASN_PARSE_E;
+    }
+    /* the binary search relies on it */
+    p += ESP_WOLFSSL_CRL_INDEX_HEADER_SZ;
+    for (i = 1; i < count; i++, p += hash_sz) {
+        if (XMEMCMP(p, p + hash_sz, hash_sz) > 0) {
+            return ASN_PARSE_E;
+        }
+    }
+
+    *idx = crl_index_new((const byte*)blob,
+                         ESP_WOLFSSL_CRL_INDEX_HEADER_SZ
+                         + (size_t)count * hash_sz);
+    return *idx != NULL ? 0 : MEMORY_E;
+}
+
+void esp_wolfssl_crl_index_free(esp_wolfssl_crl_index_t* idx)
+{
+    if (idx != NULL) {
+        XFREE(idx->owned, NULL, DYNAMIC_TYPE_CRL);
+        XFREE(idx, NULL, DYNAMIC_TYPE_CRL);
+    }
+}
+
+const void* esp_wolfssl_crl_index_blob(const esp_wolfssl_crl_index_t* idx,
+                                       size_t* sz)
+{
+    if (sz != NULL) {
+        *sz = idx != NULL ? idx->size : 0;
+    }
+    return idx != NULL ? idx->blob : NULL;
+}
+
+void esp_wolfssl_crl_index_get_info(const esp_wolfssl_crl_index_t* idx,
+                                    esp_wolfssl_crl_index_info_t* info)
+{
+    XMEMSET(info, 0, sizeof(*info));
+    if (idx != NULL) {
+        info->count = idx->count;
+        info->hash_sz = idx->hash_sz;
+        info->this_update = idx->this_update;
+        info->next_update = idx->next_update;
+        info->size = idx->size;
+    }
+}
+
+static int crl_index_find(const esp_wolfssl_crl_index_t* idx,
+                          const byte* hash)
+{
+    uint32_t lo = 0;
+    uint32_t hi = idx->count;
+
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        int cmp = XMEMCMP(idx->entries + (size_t)mid * idx->hash_sz, hash,
+                          idx->hash_sz);
+        if (cmp == 0) {
+            return 1;
+        }
+        if (cmp < 0) {
+            lo = mid + 1;
+        }
+        else {
+            hi = mid;
+        }
+    }
+    return 0;
+}
+
+int esp_wolfssl_crl_index_lookup(const esp_wolfssl_crl_index_t* idx,
+                                 const unsigned char* serial, size_t sz)
+{
+    esp_wolfssl_der_t d;
+    byte hash[WC_SHA256_DIGEST_SIZE];
+
+    if (idx == NULL || serial == NULL) {
+        return 0;
+    }
+    esp_wolfssl_der_init(&d, serial, sz);
+    if (crl_hash(&d, hash, sizeof(hash)) != 0) {
+        return 0;
+    }
+    return crl_index_find(idx, hash);
+}
+
+int esp_wolfssl_crl_index_register(esp_wolfssl_crl_index_t* idx)
+{
+    int slot = -1;
+    int i;
+
+    if (idx == NULL) {
+        return BAD_FUNC_ARG;
+    }
+    if (!crl_lock()) {
+        return BAD_MUTEX_E;
+    }
+    for (i = 0; i < ESP_WOLFSSL_CRL_INDEX_MAX; i++) {
+        if (crl_registry[i] != NULL
+            && XMEMCMP(crl_registry[i]->blob + 32, idx->blob + 32,
+                       ESP_WOLFSSL_CRL_INDEX_ISSUER_SZ) == 0) {
+            slot = i;
+            break;
+        }
+        if (crl_registry[i] == NULL && slot < 0) {
+            slot = i;
+        }
+    }
+    if (slot >= 0) {
+        crl_registry[slot] = idx;
+    }
+    crl_unlock();
+
+    return slot >= 0 ? 0 : MEMORY_E;
+}
+
+void esp_wolfssl_crl_index_unregister(esp_wolfssl_crl_index_t* idx)
+{
+    int i;
+
+    if (idx == NULL || !crl_lock()) {
+        return;
+    }
+    for (i = 0; i < ESP_WOLFSSL_CRL_INDEX_MAX; i++) {
+        if (crl_registry[i] == idx) {
+            crl_registry[i] = NULL;
+        }
+    }
+    crl_unlock();
+}
+
+int esp_wolfssl_crl_index_check_cert(const unsigned char* der, size_t sz)
+{
+    esp_wolfssl_cert_view_t v;
+    byte issuer_hash[ESP_WOLFSSL_CRL_INDEX_ISSUER_SZ];
+    byte hash[WC_SHA256_DIGEST_SIZE];
+    int64_t now = (int64_t)time(NULL);
+    int ret = 0;
+    int i;
+
+    if (der == NULL) {
+        return BAD_FUNC_ARG;
+    }
+    if (esp_wolfssl_cert_view_parse(der, sz, &v) != 0
+        || crl_hash(&v.issuer, issuer_hash, sizeof(issuer_hash)) != 0
+        || crl_hash(&v.serial, hash, sizeof(hash)) != 0) {
+        return ASN_PARSE_E;
+    }
+
+    if (!crl_lock()) {
+        return BAD_MUTEX_E;
+    }
+    for (i = 0; i < ESP_WOLFSSL_CRL_INDEX_MAX; i++) {
+        const esp_wolfssl_crl_index_t* idx = crl_registry[i];
+        if (idx == NULL || XMEMCMP(idx->blob + 32, issuer_hash,
+                                   sizeof(issuer_hash)) != 0) {
+            continue;
+        }
+        if (idx->next_update != 0 && now >= CRL_INDEX_MIN_TIME
+            && now >= idx->next_update) {
+            ret = CRL_CERT_DATE_ERR;
+        }
+        else if (crl_index_find(idx, hash)) {
+            ret = CRL_CERT_REVOKED;
+        }
+        break;
+    }
+    crl_unlock();
+
+    return ret;
+}
+
+#ifdef OPENSSL_EXTRA
+int esp_wolfssl_crl_index_verify_cb(int preverify,
+                                    WOLFSSL_X509_STORE_CTX* store)
+{
+    const unsigned char* der;
+    int sz = 0;
+    int ret;
+
+    if (!preverify || store == NULL || store->current_cert == NULL) {
+        return preverify;
+    }
+    der = wolfSSL_X509_get_der(store->current_cert, &sz);
+    if (der == NULL || sz <= 0) {
+        return preverify;
+    }
+    ret = esp_wolfssl_crl_index_check_cert(der, (size_t)sz);
+    if (ret != 0) {
+        store->error = ret;
+        return 0;
+    }
+    return 1;
+}
+#endif /* OPENSSL_EXTRA */
+
+#endif /* WOLFSSL_ESP_CRL_INDEX */
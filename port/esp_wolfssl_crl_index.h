@@ -0,0 +1,145 @@
+/* esp_wolfssl_crl_index.h
+ *
+ * Copyright (C) 2006-2024 wolfSSL Inc.
+ *
+ * This file is part of wolfSSL.
+ *
+ * wolfSSL is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfSSL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335, USA
+ */
+
+/* Compact revocation index for large CRLs.
+ *
+ * Enabled with Kconfig WOLFSSL_CRL_INDEX. wolfSSL's own CRL support keeps
+ * every revoked entry of a loaded CRL in a heap allocated list and walks it
+ * on each lookup. The index instead is one flat, sorted array of truncated
+ * SHA-256 hashes of the revoked serial numbers behind a small header:
+ * lookups are a binary search, and a 10000 entry CRL takes 40 KB with the
+ * default 4 byte hashes. A truncated hash can collide: with n entries and
+ * b byte hashes a good certificate is reported revoked with a chance of
+ * about n / 2^(8 b), a revoked one is never missed.
+ *
+ * An index is built from a DER CRL on the device, which verifies the CRL
+ * signature with its issuer's certificate, or ahead of time on a host with
+ * tools/wolfssl_crl_index.py. A host built index is not verified on the
+ * device: ship it in the signed firmware image or in an encrypted partition.
+ * The blob is used in place, so it can stay in flash, e.g.
+ *
+ *   const esp_partition_t* part = esp_partition_find_first(
+ *       ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, "crl");
+ *   esp_partition_mmap(part, 0, part->size, ESP_PARTITION_MMAP_DATA,
+ *                      &blob, &handle);
+ *   esp_wolfssl_crl_index_open(blob, part->size, &idx);
+ *   esp_wolfssl_crl_index_register(idx);
+ *   wolfSSL_CTX_set_verify(ctx, WOLFSSL_VERIFY_PEER,
+ *                          esp_wolfssl_crl_index_verify_cb);
+ *
+ * Blob layout, integers little endian:
+ *
+ *   0   "CRLX"
+ *   4   version (1), hash size in bytes (4..32), 2 reserved
+ *   8   entry count, 4 reserved
+ *   16  thisUpdate, nextUpdate (0 if absent), seconds since 1970
+ *   32  SHA-256 of the issuer Name DER, first 16 bytes
+ *   48  entries, ascending: SHA-256 of the serial number INTEGER contents,
+ *       first hash size bytes
+ */
+
+#ifndef _ESP_WOLFSSL_CRL_INDEX_H_
+#define _ESP_WOLFSSL_CRL_INDEX_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <wolfssl/wolfcrypt/settings.h>
+#include <wolfssl/ssl.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define ESP_WOLFSSL_CRL_INDEX_MAGIC       "CRLX"
+#define ESP_WOLFSSL_CRL_INDEX_VERSION     1
+#define ESP_WOLFSSL_CRL_INDEX_HEADER_SZ   48
+#define ESP_WOLFSSL_CRL_INDEX_ISSUER_SZ   16
+
+typedef struct esp_wolfssl_crl_index_t esp_wolfssl_crl_index_t;
+
+typedef struct esp_wolfssl_crl_index_info_t {
+    uint32_t count;             /* revoked entries */
+    uint32_t hash_sz;           /* bytes per entry */
+    int64_t  this_update;
+    int64_t  next_update;       /* 0 if the CRL has none */
+    size_t   size;              /* of the blob */
+} esp_wolfssl_crl_index_info_t;
+
+#ifdef WOLFSSL_ESP_CRL_INDEX
+
+/* Index of a DER CRL, whose signature is verified with the DER certificate
+ * of its issuer. Only the blob is kept, on the heap; crl can be freed.
+ * Returns 0, or ASN_PARSE_E, ASN_CRL_NO_SIGNER_E when ca is not the
+ * issuer, ASN_CRL_CONFIRM_E for a bad signature or MEMORY_E. */
+int esp_wolfssl_crl_index_build(const unsigned char* crl, size_t crl_sz,
+                                const unsigned char* ca, size_t ca_sz,
+                                esp_wolfssl_crl_index_t** idx);
+
+/* Index over a prebuilt blob, which must stay mapped while the index is
+ * in use. Header and order of the entries are checked. Returns 0 or
+ * ASN_PARSE_E. */
+int esp_wolfssl_crl_index_open(const void* blob, size_t sz,
+                               esp_wolfssl_crl_index_t** idx);
+
+/* Frees the index and, if it was built here, the blob. Unregister first. */
+void esp_wolfssl_crl_index_free(esp_wolfssl_crl_index_t* idx);
+
+/* The blob, e.g. to write an index built on the device to flash. */
+const void* esp_wolfssl_crl_index_blob(const esp_wolfssl_crl_index_t* idx,
+                                       size_t* sz);
+void esp_wolfssl_crl_index_get_info(const esp_wolfssl_crl_index_t* idx,
+                                    esp_wolfssl_crl_index_info_t* info);
+
+/* 1 if the serial number, the contents of the certificate's serialNumber
+ * INTEGER, is in the index, otherwise 0. */
+int esp_wolfssl_crl_index_lookup(const esp_wolfssl_crl_index_t* idx,
+                                 const unsigned char* serial, size_t sz);
+
+/* Indexes consulted by esp_wolfssl_crl_index_check_cert(), one per issuer;
+ * registering an index for an issuer that has one replaces it, e.g. when
+ * a newer CRL was loaded. Returns 0, BAD_FUNC_ARG or MEMORY_E when all
+ * ESP_WOLFSSL_CRL_INDEX_MAX slots are taken. */
+int  esp_wolfssl_crl_index_register(esp_wolfssl_crl_index_t* idx);
+void esp_wolfssl_crl_index_unregister(esp_wolfssl_crl_index_t* idx);
+
+/* Checks a DER certificate against the index of its issuer: 0 when it is
+ * not revoked or there is no index for its issuer, CRL_CERT_REVOKED,
+ * CRL_CERT_DATE_ERR when the index is past its nextUpdate, or
+ * ASN_PARSE_E. The dates are not checked while the clock is not set. */
+int esp_wolfssl_crl_index_check_cert(const unsigned char* der, size_t sz);
+
+#ifdef OPENSSL_EXTRA
+/* Verify callback for wolfSSL_CTX_set_verify() or wolfSSL_set_verify()
+ * that runs esp_wolfssl_crl_index_check_cert() on every certificate of
+ * the peer's chain; needs WOLFSSL_ALWAYS_VERIFY_CB, which Kconfig
+ * WOLFSSL_CRL_INDEX sets. */
+int esp_wolfssl_crl_index_verify_cb(int preverify,
+                                    WOLFSSL_X509_STORE_CTX* store);
+#endif
+
+#endif /* WOLFSSL_ESP_CRL_INDEX */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _ESP_WOLFSSL_CRL_INDEX_H_ */
@@ -0,0 +1,693 @@
+/* esp_wolfssl_ctx_cache.c
+ *
+ * Copyright (C) 2006-2024 wolfSSL Inc.
+ *
+ * This file is part of wolfSSL.
+ *
+ * wolfSSL is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfSSL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335, USA
+ */
+
+#include <wolfssl/wolfcrypt/settings.h>
+
+#ifdef WOLFSSL_ESP_CTX_CACHE
+
+#include <stdint.h>
+#include <string.h>
+
+#include <wolfssl/ssl.h>
+#include <wolfssl/wolfcrypt/types.h>
+#include <wolfssl/wolfcrypt/sha256.h>
+#include <wolfssl/wolfcrypt/error-crypt.h>
+#include <wolfssl/wolfcrypt/wc_port.h>
+
+#ifdef WOLFSSL_ESP_CTX_CACHE_STORES
+    /* the certificate manager of a context */
+    #include <wolfssl/internal.h>
+#endif
+
+#include "esp_wolfssl_ctx_cache.h"
+
+#define CC_KEY_SZ WC_SHA256_DIGEST_SIZE
+
+/* domain separation of the two kinds of keys */
+#define CC_CTX_TAG   0x01
+#define CC_STORE_TAG 0x02
+
+typedef struct cc_entry {
+    WOLFSSL_CTX*     ctx;
+    char*            alpn;      /* comma separated, for wolfSSL_UseALPN() */
+    uint32_t         users;
+    uint32_t         stamp;     /* of the last get, for LRU */
+    byte             key[CC_KEY_SZ];
+    struct cc_entry* next;      /* uncached contexts only */
+} cc_entry;
+
+static cc_entry cc_entries[ESP_WOLFSSL_CTX_CACHE_ENTRIES];
+/* built with all entries in use, or with the cache off; freed by put */
+static cc_entry* cc_uncached;
+static uint32_t cc_clock;
+static int cc_enabled = 1;
+static esp_wolfssl_ctx_cache_stats_t cc_stats;
+static wolfSSL_Mutex cc_mutex;
+static int cc_mutex_ok;
+
+#ifdef WOLFSSL_ESP_CTX_CACHE_STORES
+typedef struct cc_store {
+    WOLFSSL_X509_STORE* store;  /* one reference held by the cache */
+    byte*               ca;     /* the buffer, for a context leaving it */
+    long                ca_sz;
+    int                 format;
+    byte                key[CC_KEY_SZ];
+} cc_store;
+
+static cc_store cc_stores[ESP_WOLFSSL_CTX_CACHE_ENTRIES];
+
+int __real_wolfSSL_CTX_load_verify_buffer(WOLFSSL_CTX* ctx,
+                                          const unsigned char* in, long sz,
+                                          int format);
+int __wrap_wolfSSL_CTX_load_verify_buffer(WOLFSSL_CTX* ctx,
+                                          const unsigned char* in, long sz,
+                                          int format);
+#endif
+
+/* before any handshake, and before the scheduler starts on the device */
+static void __attribute__((constructor)) cc_init(void)
+{
+    cc_mutex_ok = (wc_InitMutex(&cc_mutex) == 0);
+}
+
+static int cc_lock(void)
+{
+    return cc_mutex_ok && wc_LockMutex(&cc_mutex) == 0;
+}
+
+static void cc_unlock(void)
+{
+    wc_UnLockMutex(&cc_mutex);
+}
+
+/* length prefixed, so that fields cannot run into each other */
+static int cc_hash_field(wc_Sha256* sha, const void* data, word32 sz)
+{
+    byte len[4];
+    int ret;
+
+    len[0] = (byte)(sz >> 24);
+    len[1] = (byte)(sz >> 16);
+    len[2] = (byte)(sz >> 8);
+    len[3] = (byte)sz;
+    ret = wc_Sha256Update(sha, len, sizeof(len));
+    if (ret == 0 && sz > 0) {
+        ret = wc_Sha256Update(sha, (const byte*)data, sz);
+    }
+    return ret;
+}
+
+static int cc_hash(byte tag, int format, const unsigned char* ca,
+                   word32 ca_sz, const char* cipher_list, const char* alpn,
+                   byte* key)
+{
+    wc_Sha256 sha;
+    byte head[2];
+    int ret;
+
+    head[0] = tag;
+    head[1] = (byte)format;
+    ret = wc_InitSha256(&sha);
+    if (ret != 0) {
+        return ret;
+    }
+    ret = cc_hash_field(&sha, head, sizeof(head));
+    if (ret == 0) {
+        ret = cc_hash_field(&sha, ca, ca_sz);
+    }
+    if (ret == 0 && tag == CC_CTX_TAG) {
+        ret = cc_hash_field(&sha, cipher_list,
+                            cipher_list ? (word32)XSTRLEN(cipher_list) : 0);
+        if (ret == 0) {
+            ret = cc_hash_field(&sha, alpn,
+                                alpn ? (word32)XSTRLEN(alpn) : 0);
+        }
+    }
+    if (ret == 0) {
+        ret = wc_Sha256Final(&sha, key);
+    }
+    wc_Sha256Free(&sha);
+    return ret;
+}
+
+/* the NULL terminated list of esp-tls as the comma separated one of
+ * wolfSSL_UseALPN(); NULL without protocols */
+static int cc_alpn_join(const char* const* protos, char** out)
+{
+#ifdef HAVE_ALPN
+    size_t len = 0;
+    size_t i;
+    char* s;
+#endif
+
+    *out = NULL;
+    if (protos == NULL || protos[0] == NULL) {
+        return 0;
+    }
+#ifndef HAVE_ALPN
+    return NOT_COMPILED_IN;
+#else
+    for (i = 0; protos[i] != NULL; i++) {
+        len += XSTRLEN(protos[i]) + 1;
+    }
+    s = (char*)XMALLOC(len, NULL, DYNAMIC_TYPE_ALPN);
+    if (s == NULL) {
+        return MEMORY_E;
+    }
+    len = 0;
+    for (i = 0; protos[i] != NULL; i++) {
+        if (i > 0) {
+            s[len++] = ',';
+        }
+        XMEMCPY(s + len, protos[i], XSTRLEN(protos[i]));
+        len += XSTRLEN(protos[i]);
+    }
+    s[len] = '\0';
+    *out = s;
+    return 0;
+#endif
+}
+
+/* under the lock */
+static cc_entry* cc_find_key(const byte* key)
+{
+    size_t i;
+
+    for (i = 0; i < ESP_WOLFSSL_CTX_CACHE_ENTRIES; i++) {
+        if (cc_entries[i].ctx != NULL &&
+            XMEMCMP(cc_entries[i].key, key, CC_KEY_SZ) == 0) {
+            return &cc_entries[i];
+        }
+    }
+    return NULL;
+}
+
+/* under the lock; link gets the pointer to the entry when it is in the
+ * uncached list, else NULL */
+static cc_entry* cc_find_ctx(const WOLFSSL_CTX* ctx, cc_entry*** link)
+{
+    cc_entry** p;
+    size_t i;
+
+    *link = NULL;
+    for (i = 0; i < ESP_WOLFSSL_CTX_CACHE_ENTRIES; i++) {
+        if (cc_entries[i].ctx == ctx) {
+            return &cc_entries[i];
+        }
+    }
+    for (p = &cc_uncached; *p != NULL; p = &(*p)->next) {
+        if ((*p)->ctx == ctx) {
+            *link = p;
+            return *p;
+        }
+    }
+    return NULL;
+}
+
+/* under the lock: a free entry, else the least recently used one without
+ * users, else NULL */
+static cc_entry* cc_slot(void)
+{
+    cc_entry* lru = NULL;
+    size_t i;
+
+    for (i = 0; i < ESP_WOLFSSL_CTX_CACHE_ENTRIES; i++) {
+        cc_entry* e = &cc_entries[i];
+
+        if (e->ctx == NULL) {
+            return e;
+        }
+        if (e->users == 0 && (lru == NULL ||
+                              (int32_t)(e->stamp - lru->stamp) < 0)) {
+            lru = e;
+        }
+    }
+    return lru;
+}
+
+static WOLFSSL_CTX* cc_build(const esp_wolfssl_ctx_cfg_t* cfg)
+{
+    WOLFSSL_CTX* ctx;
+    int ret = WOLFSSL_SUCCESS;
+
+    ctx = wolfSSL_CTX_new(wolfSSLv23_client_method());
+    if (ctx == NULL) {
+        return NULL;
+    }
+    if (cfg->ca != NULL) {
+        ret = wolfSSL_CTX_load_verify_buffer(ctx, cfg->ca, (long)cfg->ca_sz,
+                                             cfg->ca_format);
+        wolfSSL_CTX_set_verify(ctx, WOLFSSL_VERIFY_PEER, NULL);
+    }
+    else {
+        wolfSSL_CTX_set_verify(ctx, WOLFSSL_VERIFY_NONE, NULL);
+    }
+    if (ret == WOLFSSL_SUCCESS && cfg->cipher_list != NULL) {
+        ret = wolfSSL_CTX_set_cipher_list(ctx, cfg->cipher_list);
+    }
+    if (ret != WOLFSSL_SUCCESS) {
+        wolfSSL_CTX_free(ctx);
+        return NULL;
+    }
+    return ctx;
+}
+
+WOLFSSL_CTX* esp_wolfssl_ctx_cache_get(const esp_wolfssl_ctx_cfg_t* cfg)
+{
+    WOLFSSL_CTX* ctx;
+    WOLFSSL_CTX* old_ctx = NULL;
+    char* old_alpn = NULL;
+    char* alpn;
+    byte key[CC_KEY_SZ];
+    cc_entry* e;
+
+    if (cfg == NULL || (cfg->ca == NULL && cfg->ca_sz > 0)) {
+        return NULL;
+    }
+    if (cc_alpn_join(cfg->alpn, &alpn) != 0) {
+        return NULL;
+    }
+    if (cc_hash(CC_CTX_TAG, cfg->ca ? cfg->ca_format : 0, cfg->ca,
+                (word32)cfg->ca_sz, cfg->cipher_list, alpn, key) != 0 ||
+        !cc_lock()) {
+        XFREE(alpn, NULL, DYNAMIC_TYPE_ALPN);
+        return NULL;
+    }
+    e = cc_enabled ? cc_find_key(key) : NULL;
+    if (e != NULL) {
+        e->users++;
+        e->stamp = ++cc_clock;
+        cc_stats.hits++;
+        ctx = e->ctx;
+        cc_unlock();
+        XFREE(alpn, NULL, DYNAMIC_TYPE_ALPN);
+        return ctx;
+    }
+    cc_unlock();
+
+    /* decoding the CAs takes a while, other tasks go on meanwhile */
+    ctx = cc_build(cfg);
+    if (ctx == NULL || !cc_lock()) {
+        wolfSSL_CTX_free(ctx);
+        XFREE(alpn, NULL, DYNAMIC_TYPE_ALPN);
+        return NULL;
+    }
+    cc_stats.misses++;
+    e = cc_enabled ? cc_find_key(key) : NULL;
+    if (e != NULL) {
+        /* another task built the same context first */
+        e->users++;
+        e->stamp = ++cc_clock;
+        old_ctx = ctx;
+        old_alpn = alpn;
+        ctx = e->ctx;
+    }
+    else {
+        e = cc_enabled ? cc_slot() : NULL;
+        if (e != NULL && e->ctx != NULL) {
+            old_ctx = e->ctx;
+            old_alpn = e->alpn;
+            cc_stats.evictions++;
+        }
+        if (e == NULL) {
+            e = (cc_entry*)XMALLOC(sizeof(*e), NULL,
+                                   DYNAMIC_TYPE_TMP_BUFFER);
+            if (e != NULL) {
+                e->next = cc_uncached;
+                cc_uncached = e;
+                cc_stats.uncached++;
+            }
+            else {
+                old_ctx = ctx;
+                old_alpn = alpn;
+                ctx = NULL;
+            }
+        }
+        if (e != NULL) {
+            e->ctx = ctx;
+            e->alpn = alpn;
+            e->users = 1;
+            e->stamp = ++cc_clock;
+            XMEMCPY(e->key, key, CC_KEY_SZ);
+        }
+    }
+    cc_unlock();
+
+    wolfSSL_CTX_free(old_ctx);
+    XFREE(old_alpn, NULL, DYNAMIC_TYPE_ALPN);
+    return ctx;
+}
+
+WOLFSSL* esp_wolfssl_ctx_cache_new_ssl(WOLFSSL_CTX* ctx)
+{
+    WOLFSSL* ssl;
+    cc_entry** link;
+    cc_entry* e;
+    char* alpn = NULL;
+
+    if (ctx == NULL || !cc_lock()) {
+        return NULL;
+    }
+    /* stays until the put of the caller */
+    e = cc_find_ctx(ctx, &link);
+    if (e != NULL) {
+        alpn = e->alpn;
+    }
+    cc_unlock();
+
+    ssl = wolfSSL_new(ctx);
+#ifdef HAVE_ALPN
+    if (ssl != NULL && alpn != NULL &&
+        wolfSSL_UseALPN(ssl, alpn, (unsigned int)XSTRLEN(alpn),
+                        WOLFSSL_ALPN_FAILED_ON_MISMATCH) != WOLFSSL_SUCCESS) {
+        wolfSSL_free(ssl);
+        ssl = NULL;
+    }
+#else
+    (void)alpn;
+#endif
+    return ssl;
+}
+
+void esp_wolfssl_ctx_cache_put(WOLFSSL_CTX* ctx)
+{
+    cc_entry** link;
+    cc_entry* e;
+
+    if (ctx == NULL || !cc_lock()) {
+        return;
+    }
+    e = cc_find_ctx(ctx, &link);
+    if (e != NULL && link != NULL) {
+        *link = e->next;
+    }
+    else if (e != NULL && e->users > 0) {
+        e->users--;
+        e = NULL;
+    }
+    cc_unlock();
+
+    if (e != NULL && link != NULL) {
+        wolfSSL_CTX_free(e->ctx);
+        XFREE(e->alpn, NULL, DYNAMIC_TYPE_ALPN);
+        XFREE(e, NULL, DYNAMIC_TYPE_TMP_BUFFER);
+    }
+}
+
+void esp_wolfssl_ctx_cache_set_enabled(int enabled)
+{
+    cc_enabled = enabled;
+}
+
+void esp_wolfssl_ctx_cache_flush(void)
+{
+    WOLFSSL_CTX* ctx[ESP_WOLFSSL_CTX_CACHE_ENTRIES];
+    char* alpn[ESP_WOLFSSL_CTX_CACHE_ENTRIES];
+#ifdef WOLFSSL_ESP_CTX_CACHE_STORES
+    WOLFSSL_X509_STORE* store[ESP_WOLFSSL_CTX_CACHE_ENTRIES];
+    byte* ca[ESP_WOLFSSL_CTX_CACHE_ENTRIES];
+#endif
+    size_t i;
+
+    if (!cc_lock()) {
+        return;
+    }
+    for (i = 0; i < ESP_WOLFSSL_CTX_CACHE_ENTRIES; i++) {
+        ctx[i] = NULL;
+        alpn[i] = NULL;
+        if (cc_entries[i].ctx != NULL && cc_entries[i].users == 0) {
+            ctx[i] = cc_entries[i].ctx;
+            alpn[i] = cc_entries[i].alpn;
+            XMEMSET(&cc_entries[i], 0, sizeof(cc_entries[i]));
+        }
+    #ifdef WOLFSSL_ESP_CTX_CACHE_STORES
+        /* contexts hold their own references */
+        store[i] = cc_stores[i].store;
+        ca[i] = cc_stores[i].ca;
+        XMEMSET(&cc_stores[i], 0, sizeof(cc_stores[i]));
+    #endif
+    }
+    cc_unlock();
+
+    for (i = 0; i < ESP_WOLFSSL_CTX_CACHE_ENTRIES; i++) {
+        wolfSSL_CTX_free(ctx[i]);
+        XFREE(alpn[i], NULL, DYNAMIC_TYPE_ALPN);
+    #ifdef WOLFSSL_ESP_CTX_CACHE_STORES
+        wolfSSL_X509_STORE_free(store[i]);
+        XFREE(ca[i], NULL, DYNAMIC_TYPE_CA);
+    #endif
+    }
+}
+
+void esp_wolfssl_ctx_cache_get_stats(esp_wolfssl_ctx_cache_stats_t* stats)
+{
+    if (stats == NULL) {
+        return;
+    }
+    if (cc_lock()) {
+        *stats = cc_stats;
+        cc_unlock();
+    }
+    else {
+        XMEMSET(stats, 0, sizeof(*stats));
+    }
+}
+
+void esp_wolfssl_ctx_cache_reset_stats(void)
+{
+    if (cc_lock()) {
+        XMEMSET(&cc_stats, 0, sizeof(cc_stats));
+        cc_unlock();
+    }
+}
+
+#ifdef WOLFSSL_ESP_CTX_CACHE_STORES
+
+/* under the lock */
+static cc_store* cc_store_find(const byte* key)
+{
+    size_t i;
+
+    for (i = 0; i < ESP_WOLFSSL_CTX_CACHE_ENTRIES; i++) {
+        if (cc_stores[i].store != NULL &&
+            XMEMCMP(cc_stores[i].key, key, CC_KEY_SZ) == 0) {
+            return &cc_stores[i];
+        }
+    }
+    return NULL;
+}
+
+/* under the lock: a free slot, else NULL; a store is kept until the flush,
+ * as the cache cannot tell whether contexts still use it */
+static cc_store* cc_store_slot(void)
+{
+    size_t i;
+
+    for (i = 0; i < ESP_WOLFSSL_CTX_CACHE_ENTRIES; i++) {
+        if (cc_stores[i].store == NULL) {
+            return &cc_stores[i];
+        }
+    }
+    return NULL;
+}
+
+/* under the lock: the shared store ctx uses, or NULL */
+static cc_store* cc_store_of(WOLFSSL_CTX* ctx)
+{
+    WOLFSSL_X509_STORE* store = wolfSSL_CTX_get_cert_store(ctx);
+    size_t i;
+
+    for (i = 0; store != NULL && i < ESP_WOLFSSL_CTX_CACHE_ENTRIES; i++) {
+        if (cc_stores[i].store == store) {
+            return &cc_stores[i];
+        }
+    }
+    return NULL;
+}
+
+/* under the lock: whether the certificate manager of ctx is as
+ * wolfSSL_CTX_new() left it, so that a shared store can take its place
+ * without losing anything */
+static int cc_ctx_fresh(WOLFSSL_CTX* ctx)
+{
+    WOLFSSL_CERT_MANAGER* cm = ctx->cm;
+    int empty = 1;
+    int i;
+
+    if (cm == NULL || ctx->x509_store_pt != NULL) {
+        return 0;
+    }
+#ifdef HAVE_CRL
+    if (cm->crlEnabled) {
+        return 0;
+    }
+#endif
+#ifdef HAVE_OCSP
+    if (cm->ocspEnabled) {
+        return 0;
+    }
+#endif
+#ifndef NO_RSA
+    if (cm->minRsaKeySz != MIN_RSAKEY_SZ) {
+        return 0;
+    }
+#endif
+#ifdef HAVE_ECC
+    if (cm->minEccKeySz != MIN_ECCKEY_SZ) {
+        return 0;
+    }
+#endif
+    if (wc_LockMutex(&cm->caLock) != 0) {
+        return 0;
+    }
+    for (i = 0; empty && i < CA_TABLE_SIZE; i++) {
+        empty = (cm->caTable[i] == NULL);
+    }
+    wc_UnLockMutex(&cm->caLock);
+#ifdef WOLFSSL_TRUST_PEER_CERT
+    if (empty && wc_LockMutex(&cm->tpLock) == 0) {
+        for (i = 0; empty && i < TP_TABLE_SIZE; i++) {
+            empty = (cm->tpTable[i] == NULL);
+        }
+        wc_UnLockMutex(&cm->tpLock);
+    }
+    else {
+        empty = 0;
+    }
+#endif
+    return empty;
+}
+
+/* a new store with the certificates of in, or NULL */
+static WOLFSSL_X509_STORE* cc_store_new(const unsigned char* in, long sz,
+                                        int format)
+{
+    WOLFSSL_X509_STORE* store = wolfSSL_X509_STORE_new();
+
+    if (store != NULL &&
+        wolfSSL_CertManagerLoadCABuffer(store->cm, in, sz, format)
+            != WOLFSSL_SUCCESS) {
+        wolfSSL_X509_STORE_free(store);
+        store = NULL;
+    }
+    return store;
+}
+
+/* under the lock: a further load into a context sharing s must not add to
+ * the other contexts, so ctx moves to a store of its own with the shared
+ * certificates and those of in; returns what the load returns */
+static int cc_store_leave(WOLFSSL_CTX* ctx, const cc_store* s,
+                          const unsigned char* in, long sz, int format)
+{
+    WOLFSSL_X509_STORE* store = cc_store_new(s->ca, s->ca_sz, s->format);
+    int ret;
+
+    if (store == NULL) {
+        return MEMORY_E;
+    }
+    ret = wolfSSL_CertManagerLoadCABuffer(store->cm, in, sz, format);
+    /* the context takes over the reference */
+    wolfSSL_CTX_set_cert_store(ctx, store);
+    if (wolfSSL_CTX_get_cert_store(ctx) != store) {
+        wolfSSL_X509_STORE_free(store);
+        return MEMORY_E;
+    }
+    return ret;
+}
+
+int __wrap_wolfSSL_CTX_load_verify_buffer(WOLFSSL_CTX* ctx,
+                                          const unsigned char* in, long sz,
+                                          int format)
+{
+    WOLFSSL_X509_STORE* store = NULL;
+    WOLFSSL_X509_STORE* old;
+    byte key[CC_KEY_SZ];
+    byte* ca;
+    cc_store* s;
+    int ret;
+
+    if (!cc_enabled || ctx == NULL || in == NULL || sz <= 0 ||
+        cc_hash(CC_STORE_TAG, format, in, (word32)sz, NULL, NULL, key) != 0
+        || !cc_lock()) {
+        return __real_wolfSSL_CTX_load_verify_buffer(ctx, in, sz, format);
+    }
+    s = cc_store_of(ctx);
+    if (s != NULL) {
+        ret = cc_store_leave(ctx, s, in, sz, format);
+        cc_unlock();
+        return ret;
+    }
+    if (!cc_ctx_fresh(ctx)) {
+        cc_unlock();
+        return __real_wolfSSL_CTX_load_verify_buffer(ctx, in, sz, format);
+    }
+    s = cc_store_find(key);
+    if (s != NULL && wolfSSL_X509_STORE_up_ref(s->store) == WOLFSSL_SUCCESS) {
+        cc_stats.store_hits++;
+        store = s->store;
+    }
+    cc_unlock();
+
+    if (s == NULL) {
+        /* decoding the CAs takes a while, other tasks go on meanwhile */
+        old = cc_store_new(in, sz, format);
+        ca = (byte*)XMALLOC((size_t)sz, NULL, DYNAMIC_TYPE_CA);
+        if (old != NULL && ca != NULL && cc_lock()) {
+            s = cc_store_find(key);
+            if (s == NULL && (s = cc_store_slot()) != NULL) {
+                /* the cache takes over the reference */
+                cc_stats.store_misses++;
+                XMEMCPY(ca, in, (size_t)sz);
+                s->store = old;
+                s->ca = ca;
+                s->ca_sz = sz;
+                s->format = format;
+                XMEMCPY(s->key, key, CC_KEY_SZ);
+                old = NULL;
+                ca = NULL;
+            }
+            /* else another task decoded the same buffer first, or all
+             * slots are taken and this context loads on its own */
+            if (s != NULL &&
+                wolfSSL_X509_STORE_up_ref(s->store) == WOLFSSL_SUCCESS) {
+                store = s->store;
+            }
+            cc_unlock();
+        }
+        wolfSSL_X509_STORE_free(old);
+        XFREE(ca, NULL, DYNAMIC_TYPE_CA);
+    }
+    if (store == NULL) {
+        return __real_wolfSSL_CTX_load_verify_buffer(ctx, in, sz, format);
+    }
+
+    /* the context takes over the reference */
+    wolfSSL_CTX_set_cert_store(ctx, store);
+    if (wolfSSL_CTX_get_cert_store(ctx) != store) {
+        wolfSSL_X509_STORE_free(store);
+        return __real_wolfSSL_CTX_load_verify_buffer(ctx, in, sz, format);
+    }
+    return WOLFSSL_SUCCESS;
+}
+
+#endif /* WOLFSSL_ESP_CTX_CACHE_STORES */
+
+#endif /* WOLFSSL_ESP_CTX_CACHE */
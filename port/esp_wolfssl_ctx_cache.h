@@ -0,0 +1,136 @@
+/* esp_wolfssl_ctx_cache.h
+ *
+ * Copyright (C) 2006-2024 wolfSSL Inc.
+ *
+ * This file is part of wolfSSL.
+ *
+ * wolfSSL is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfSSL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335, USA
+ */
+
+/* Shared TLS client contexts and CA stores.
+ *
+ * Enabled with Kconfig WOLFSSL_CTX_CACHE. A WOLFSSL_CTX built for every
+ * connection decodes its CA certificates again and allocates a certificate
+ * manager for them, which an HTTPS or MQTT client pays on each reconnect.
+ * The cache keeps up to ESP_WOLFSSL_CTX_CACHE_ENTRIES client contexts,
+ * keyed by a SHA-256 hash of their configuration (CA set, cipher list,
+ * ALPN list), and hands the same context to every connection with that
+ * configuration:
+ *
+ *   WOLFSSL_CTX* ctx = esp_wolfssl_ctx_cache_get(&cfg);
+ *   WOLFSSL* ssl = esp_wolfssl_ctx_cache_new_ssl(ctx);
+ *   ...
+ *   wolfSSL_free(ssl);
+ *   esp_wolfssl_ctx_cache_put(ctx);
+ *
+ * Every get takes a reference and every put drops one; only a context
+ * without references is evicted, the least recently used first. With all
+ * entries in use a get builds a context that is not cached and freed by
+ * its put. Contexts are shared between tasks; configure connections on
+ * the WOLFSSL, not on the shared context.
+ *
+ * esp-tls builds its own context per connection. With Kconfig
+ * WOLFSSL_CTX_CACHE_ESP_TLS, wolfSSL_CTX_load_verify_buffer(), which is
+ * linker wrapped (see the component CMakeLists.txt), decodes a CA buffer
+ * once into a shared X509 store and attaches that store to every context
+ * that loads the same buffer, so esp-tls connections share the CA set
+ * without changes to esp-tls. The store replaces the certificate manager
+ * of the context, so a context takes it only when its own is still as
+ * wolfSSL_CTX_new() left it, without CAs, CRL or OCSP, or changed minimum
+ * key sizes; otherwise the load goes to wolfSSL as usual. A further load
+ * into a context sharing a store moves that context to a store of its own
+ * with both CA sets, decoded from a copy of the shared buffer the cache
+ * keeps, so the other contexts are not affected. Stores stay until
+ * esp_wolfssl_ctx_cache_flush(); with all ESP_WOLFSSL_CTX_CACHE_ENTRIES
+ * taken, new CA buffers are loaded per context.
+ *
+ * LIMITATION: contexts sharing a store also share its certificate
+ * manager. Only further CA loads are intercepted; any other call that
+ * writes the context's certificate manager after the store is attached,
+ * e.g. wolfSSL_CTX_SetMinEccKey_Sz(), wolfSSL_CTX_SetMinRsaKey_Sz(),
+ * wolfSSL_CTX_EnableOCSP() or wolfSSL_CTX_EnableCRL(), changes it for
+ * every context using that CA buffer. Make such calls before
+ * wolfSSL_CTX_load_verify_buffer(), which then leaves the context its own
+ * store, or do not enable this option.
+ *
+ * Needs the OpenSSL compatibility layer of esp-tls and the reference
+ * counted X509 stores of wolfSSL 5.
+ */
+
+#ifndef _ESP_WOLFSSL_CTX_CACHE_H_
+#define _ESP_WOLFSSL_CTX_CACHE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <wolfssl/wolfcrypt/settings.h>
+#include <wolfssl/ssl.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef ESP_WOLFSSL_CTX_CACHE_ENTRIES
+    #define ESP_WOLFSSL_CTX_CACHE_ENTRIES 4
+#endif
+
+typedef struct esp_wolfssl_ctx_cfg_t {
+    const unsigned char* ca;          /* NULL: peer not verified */
+    size_t               ca_sz;
+    int                  ca_format;   /* WOLFSSL_FILETYPE_PEM or _ASN1 */
+    const char*          cipher_list; /* NULL: library default */
+    const char* const*   alpn;        /* NULL terminated, or NULL */
+} esp_wolfssl_ctx_cfg_t;
+
+typedef struct esp_wolfssl_ctx_cache_stats_t {
+    uint32_t hits;
+    uint32_t misses;        /* contexts built */
+    uint32_t uncached;      /* built with all entries in use */
+    uint32_t evictions;
+    uint32_t store_hits;    /* CA loads served by a shared store */
+    uint32_t store_misses;  /* CA buffers decoded */
+} esp_wolfssl_ctx_cache_stats_t;
+
+#ifdef WOLFSSL_ESP_CTX_CACHE
+
+/* Returns a client context for cfg with a reference taken, or NULL. */
+WOLFSSL_CTX* esp_wolfssl_ctx_cache_get(const esp_wolfssl_ctx_cfg_t* cfg);
+
+/* New connection on ctx with the ALPN list of its configuration, or
+ * NULL. */
+WOLFSSL* esp_wolfssl_ctx_cache_new_ssl(WOLFSSL_CTX* ctx);
+
+/* Drops the reference of a get. */
+void esp_wolfssl_ctx_cache_put(WOLFSSL_CTX* ctx);
+
+/* 0 builds a context for every get and decodes every CA load, for
+ * comparison; on by default. */
+void esp_wolfssl_ctx_cache_set_enabled(int enabled);
+
+/* Frees the contexts nobody holds and drops the shared stores; contexts
+ * keep theirs, but a further CA load into them then adds to the store
+ * they share, so flush when such contexts are gone or done loading. */
+void esp_wolfssl_ctx_cache_flush(void);
+
+void esp_wolfssl_ctx_cache_get_stats(esp_wolfssl_ctx_cache_stats_t* stats);
+void esp_wolfssl_ctx_cache_reset_stats(void);
+
+#endif /* WOLFSSL_ESP_CTX_CACHE */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _ESP_WOLFSSL_CTX_CACHE_H_ */
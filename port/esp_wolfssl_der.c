@@ -0,0 +1,172 @@
+/* esp_wolfssl_der.c
+ *
+ * Copyright (C) 2006-2024 wolfSSL Inc.
+ *
+ * This file is part of wolfSSL.
+ *
+ * wolfSSL is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfSSL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335, USA
+ */
+
+#include <wolfssl/wolfcrypt/settings.h>
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esp_wolfssl_der.h"
+
+void esp_wolfssl_der_init(esp_wolfssl_der_t* d, const uint8_t* p, size_t len)
+{
+    d->p = p;
+    d->len = (p != NULL) ? len : 0;
+}
+
+int esp_wolfssl_der_peek(const esp_wolfssl_der_t* d)
+{
+    return (d->len > 0) ? d->p[0] : -1;
+}
+
+int esp_wolfssl_der_next(esp_wolfssl_der_t* d, uint8_t* tag,
+                         esp_wolfssl_der_t* val, esp_wolfssl_der_t* tlv)
+{
+    const uint8_t* start;
+    size_t hdr = 2;
+    size_t len;
+    size_t n;
+    size_t i;
+
+    if (d->len < 2 || (d->p[0] & 0x1F) == 0x1F) {
+        return -1;
+    }
+    len = d->p[1];
+    if (len & 0x80) {
+        n = len & 0x7F;
+        /* no indefinite lengths, nothing longer than 4 GB */
+        if (n == 0 || n > 4 || d->len < 2 + n) {
+            return -1;
+        }
+        len = 0;
+        for (i = 0; i < n; i++) {
+            len = (len << 8) | d->p[2 + i];
+        }
+        hdr += n;
+    }
+    if (len > d->len - hdr) {
+        return -1;
+    }
+
+    /* d may also be val or tlv: step into an element in place */
+    start = d->p;
+    d->p += hdr + len;
+    d->len -= hdr + len;
+    if (tag != NULL) {
+        *tag = start[0];
+    }
+    if (val != NULL) {
+        val->p = start + hdr;
+        val->len = len;
+    }
+    if (tlv != NULL) {
+        tlv->p = start;
+        tlv->len = hdr + len;
+    }
+
+    return 0;
+}
+
+int esp_wolfssl_der_expect(esp_wolfssl_der_t* d, uint8_t tag,
+                           esp_wolfssl_der_t* val)
+{
+    if (esp_wolfssl_der_peek(d) != tag) {
+        return -1;
+    }
+    return esp_wolfssl_der_next(d, NULL, val, NULL);
+}
+
+int esp_wolfssl_der_skip_optional(esp_wolfssl_der_t* d, uint8_t tag)
+{
+    return (esp_wolfssl_der_peek(d) == tag
+            && esp_wolfssl_der_next(d, NULL, NULL, NULL) == 0);
+}
+
+static int der_digits(const uint8_t* p, int n, int* out)
+{
+    int v = 0;
+    int i;
+
+    for (i = 0; i < n; i++) {
+        if (p[i] < '0' || p[i] > '9') {
+            return -1;
+        }
+        v = v * 10 + (p[i] - '0');
+    }
+    *out = v;
+    return 0;
+}
+
+/* days since 1970-01-01 of a proleptic Gregorian date */
+static int64_t der_days(int y, int m, int d)
+{
+    int64_t era;
+    int yoe;
+    int doy;
+
+    y -= (m <= 2);
+    era = (y >= 0 ? y : y - 399) / 400;
+    yoe = (int)(y - era * 400);
+    doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    return era * 146097 + (int64_t)yoe * 365 + yoe / 4 - yoe / 100 + doy
+           - 719468;
+}
+
+int esp_wolfssl_der_time(uint8_t tag, const esp_wolfssl_der_t* val,
+                         int64_t* epoch)
+{
+    const uint8_t* p = val->p;
+    int year;
+    int mon;
+    int day;
+    int hour;
+    int min;
+    int sec;
+
+    if (tag == ESP_WOLFSSL_DER_UTC_TIME && val->len == 13) {
+        if (der_digits(p, 2, &year) != 0) {
+            return -1;
+        }
+        /* RFC 5280: 50..99 is 19xx */
+        year += (year < 50) ? 2000 : 1900;
+        p += 2;
+    }
+    else if (tag == ESP_WOLFSSL_DER_GENERALIZED_TIME && val->len == 15) {
+        if (der_digits(p, 4, &year) != 0) {
+            return -1;
+        }
+        p += 4;
+    }
+    else {
+        return -1;
+    }
+
+    if (der_digits(p, 2, &mon) != 0 || der_digits(p + 2, 2, &day) != 0
+        || der_digits(p + 4, 2, &hour) != 0 || der_digits(p + 6, 2, &min) != 0
+        || der_digits(p + 8, 2, &sec) != 0 || p[10] != 'Z'
+        || mon < 1 || mon > 12 || day < 1 || day > 31 || hour > 23
+        || min > 59 || sec > 60) {
+        return -1;
+    }
+
+    *epoch = der_days(year, mon, day) * 86400 + hour * 3600 + min * 60 + sec;
+    return 0;
+}
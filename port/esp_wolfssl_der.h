@@ -0,0 +1,89 @@
+/* esp_wolfssl_der.h
+ *
+ * Copyright (C) 2006-2024 wolfSSL Inc.
+ *
+ * This file is part of wolfSSL.
+ *
+ * wolfSSL is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfSSL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335, USA
+ */
+
+/* Minimal DER reader for the port modules that look into certificates,
+ * OCSP responses and CRLs without a full decode by wolfSSL.
+ *
+ * A reader is a window over a buffer; reading an element moves the window
+ * past it and returns its contents as a new window, so nested structures
+ * are walked without copies or allocations. Only definite lengths up to
+ * 4 bytes and single byte tags, i.e. DER, are accepted.
+ */
+
+#ifndef _ESP_WOLFSSL_DER_H_
+#define _ESP_WOLFSSL_DER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define ESP_WOLFSSL_DER_BOOLEAN          0x01
+#define ESP_WOLFSSL_DER_INTEGER          0x02
+#define ESP_WOLFSSL_DER_BIT_STRING       0x03
+#define ESP_WOLFSSL_DER_OCTET_STRING     0x04
+#define ESP_WOLFSSL_DER_NULL             0x05
+#define ESP_WOLFSSL_DER_OID              0x06
+#define ESP_WOLFSSL_DER_ENUMERATED       0x0A
+#define ESP_WOLFSSL_DER_UTC_TIME         0x17
+#define ESP_WOLFSSL_DER_GENERALIZED_TIME 0x18
+#define ESP_WOLFSSL_DER_SEQUENCE         0x30
+#define ESP_WOLFSSL_DER_SET              0x31
+/* [n] EXPLICIT or constructed IMPLICIT, and primitive IMPLICIT */
+#define ESP_WOLFSSL_DER_CONTEXT(n)       (0xA0 | (n))
+#define ESP_WOLFSSL_DER_CONTEXT_PRIM(n)  (0x80 | (n))
+
+typedef struct esp_wolfssl_der_t {
+    const uint8_t* p;
+    size_t         len;
+} esp_wolfssl_der_t;
+
+void esp_wolfssl_der_init(esp_wolfssl_der_t* d, const uint8_t* p, size_t len);
+
+/* Tag of the next element, or -1 at the end. */
+int esp_wolfssl_der_peek(const esp_wolfssl_der_t* d);
+
+/* Reads the next element: its tag, its contents (val) and its whole
+ * encoding (tlv); each may be NULL. Returns 0, or -1 at the end or on
+ * malformed input, in which case d is not moved. */
+int esp_wolfssl_der_next(esp_wolfssl_der_t* d, uint8_t* tag,
+                         esp_wolfssl_der_t* val, esp_wolfssl_der_t* tlv);
+
+/* esp_wolfssl_der_next() that fails unless the element has the given tag. */
+int esp_wolfssl_der_expect(esp_wolfssl_der_t* d, uint8_t tag,
+                           esp_wolfssl_der_t* val);
+
+/* Skips the next element if it has the given tag, e.g. an OPTIONAL or
+ * DEFAULT field. Returns 1 when skipped, 0 otherwise. */
+int esp_wolfssl_der_skip_optional(esp_wolfssl_der_t* d, uint8_t tag);
+
+/* UTCTime or GeneralizedTime contents, "Z" form without fractions, to
+ * seconds since 1970-01-01. Returns 0 or -1. */
+int esp_wolfssl_der_time(uint8_t tag, const esp_wolfssl_der_t* val,
+                         int64_t* epoch);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _ESP_WOLFSSL_DER_H_ */
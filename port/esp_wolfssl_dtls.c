@@ -0,0 +1,128 @@
+/* esp_wolfssl_dtls.c
+ *
+ * Copyright (C) 2006-2024 wolfSSL Inc.
+ *
+ * This file is part of wolfSSL.
+ *
+ * wolfSSL is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfSSL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335, USA
+ */
+
+#include <wolfssl/wolfcrypt/settings.h>
+
+#ifdef WOLFSSL_DTLS
+
+#include <string.h>
+
+#include <wolfssl/ssl.h>
+#include <wolfssl/wolfcrypt/error-crypt.h>
+#include <wolfssl/wolfcrypt/random.h>
+
+#include "esp_wolfssl_dtls.h"
+
+/* host builds: ESP-IDF user_settings.h sets these from Kconfig */
+#ifndef ESP_WOLFSSL_DTLS_TIMEOUT_INIT
+    #define ESP_WOLFSSL_DTLS_TIMEOUT_INIT 1
+#endif
+#ifndef ESP_WOLFSSL_DTLS_TIMEOUT_MAX
+    #define ESP_WOLFSSL_DTLS_TIMEOUT_MAX  16
+#endif
+#ifndef ESP_WOLFSSL_DTLS_MTU
+    #define ESP_WOLFSSL_DTLS_MTU          1280
+#endif
+#ifndef ESP_WOLFSSL_DTLS_CID_LEN
+    #define ESP_WOLFSSL_DTLS_CID_LEN      4
+#endif
+
+#if ESP_WOLFSSL_DTLS_TIMEOUT_MAX < ESP_WOLFSSL_DTLS_TIMEOUT_INIT
+    #error "ESP_WOLFSSL_DTLS_TIMEOUT_MAX below ESP_WOLFSSL_DTLS_TIMEOUT_INIT"
+#endif
+
+#if defined(WOLFSSL_DTLS13) && defined(WOLFSSL_DTLS_CID)
+static int dtls_cid_setup(WOLFSSL* ssl, const unsigned char* cid,
+                          unsigned int cid_sz)
+{
+    unsigned char id[ESP_WOLFSSL_DTLS_CID_LEN];
+    WC_RNG rng;
+    int ret;
+
+    /* only sent in a DTLS 1.3 handshake, ignored on DTLS 1.2 */
+    ret = wolfSSL_dtls_cid_use(ssl);
+    if (ret != WOLFSSL_SUCCESS) {
+        return ret;
+    }
+
+    if (cid == NULL && wolfSSL_is_server(ssl)) {
+        ret = wc_InitRng(&rng);
+        if (ret == 0) {
+            ret = wc_RNG_GenerateBlock(&rng, id, sizeof(id));
+            wc_FreeRng(&rng);
+        }
+        if (ret != 0) {
+            return ret;
+        }
+        cid = id;
+        cid_sz = sizeof(id);
+    }
+    if (cid != NULL && cid_sz > 0) {
+        /* wolfSSL copies the ID */
+        ret = wolfSSL_dtls_cid_set(ssl, (unsigned char*)cid, cid_sz);
+        if (ret != WOLFSSL_SUCCESS) {
+            return ret;
+        }
+    }
+
+    return 0;
+}
+#endif
+
+int esp_wolfssl_dtls_setup(WOLFSSL* ssl, const unsigned char* cid,
+                           unsigned int cid_sz)
+{
+    int ret;
+
+    if (ssl == NULL || !wolfSSL_dtls(ssl)) {
+        return BAD_FUNC_ARG;
+    }
+
+    ret = wolfSSL_dtls_set_timeout_init(ssl, ESP_WOLFSSL_DTLS_TIMEOUT_INIT);
+    if (ret == WOLFSSL_SUCCESS) {
+        ret = wolfSSL_dtls_set_timeout_max(ssl, ESP_WOLFSSL_DTLS_TIMEOUT_MAX);
+    }
+#ifdef WOLFSSL_DTLS_MTU
+    if (ret == WOLFSSL_SUCCESS) {
+        ret = wolfSSL_dtls_set_mtu(ssl, ESP_WOLFSSL_DTLS_MTU);
+    }
+#endif
+    if (ret != WOLFSSL_SUCCESS) {
+        return (ret < 0) ? ret : WOLFSSL_FATAL_ERROR;
+    }
+
+#if defined(WOLFSSL_DTLS13) && defined(WOLFSSL_DTLS_CID)
+    return dtls_cid_setup(ssl, cid, cid_sz);
+#else
+    (void)cid;
+    (void)cid_sz;
+    return 0;
+#endif
+}
+
+int esp_wolfssl_dtls_timeout_ms(WOLFSSL* ssl)
+{
+    int s = wolfSSL_dtls_get_current_timeout(ssl);
+
+    return (s > 0) ? s * 1000 : 0;
+}
+
+#endif /* WOLFSSL_DTLS */
@@ -0,0 +1,69 @@
+/* esp_wolfssl_dtls.h
+ *
+ * Copyright (C) 2006-2024 wolfSSL Inc.
+ *
+ * This file is part of wolfSSL.
+ *
+ * wolfSSL is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfSSL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335, USA
+ */
+
+/* DTLS settings from Kconfig, applied per connection.
+ *
+ * Enabled with Kconfig WOLFSSL_HAVE_DTLS. A battery powered client that
+ * keeps its WOLFSSL object across sleep can keep using a DTLS 1.3
+ * connection with a Connection ID after its NAT binding or IP address
+ * changed: the server finds the connection by the ID in each record, not
+ * by the source address, so no new handshake is needed.
+ *
+ *   ssl = wolfSSL_new(ctx);   (ctx from wolfDTLSv1_3_client_method())
+ *   esp_wolfssl_dtls_setup(ssl, NULL, 0);
+ *   wolfSSL_set_fd(ssl, udp_socket);
+ *   wolfSSL_connect(ssl);
+ *
+ * Non-blocking sockets: wait at most esp_wolfssl_dtls_timeout_ms() for a
+ * datagram, then call wolfSSL_dtls_got_timeout() to retransmit.
+ */
+
+#ifndef _ESP_WOLFSSL_DTLS_H_
+#define _ESP_WOLFSSL_DTLS_H_
+
+#include <wolfssl/wolfcrypt/settings.h>
+#include <wolfssl/ssl.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifdef WOLFSSL_DTLS
+
+/* Applies the retransmission timeouts and the MTU and, on a DTLS 1.3
+ * connection with WOLFSSL_DTLS_CID, negotiates Connection IDs. cid is the ID
+ * the peer puts in records sent to us: a server generates a random
+ * ESP_WOLFSSL_DTLS_CID_LEN byte ID when cid is NULL, a client uses none by
+ * default, which is enough when only the client's address changes.
+ * Call before the handshake. Returns 0 or a negative wolfSSL error. */
+int esp_wolfssl_dtls_setup(WOLFSSL* ssl, const unsigned char* cid,
+                           unsigned int cid_sz);
+
+/* Current retransmission timeout in milliseconds. */
+int esp_wolfssl_dtls_timeout_ms(WOLFSSL* ssl);
+
+#endif /* WOLFSSL_DTLS */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _ESP_WOLFSSL_DTLS_H_ */
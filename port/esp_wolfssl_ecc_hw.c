@@ -0,0 +1,1291 @@
+/* esp_wolfssl_ecc_hw.c
+ *
+ * Copyright (C) 2006-2024 wolfSSL Inc.
+ *
+ * This file is part of wolfSSL.
+ *
+ * wolfSSL is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfSSL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335, USA
+ */
+
+#include <wolfssl/wolfcrypt/settings.h>
+
+#if defined(WOLFSSL_ESP_ECC_HW) && defined(HAVE_ECC)
+
+#include <stdint.h>
+#include <string.h>
+
+#include <wolfssl/wolfcrypt/types.h>
+#include <wolfssl/wolfcrypt/ecc.h>
+#include <wolfssl/wolfcrypt/random.h>
+#include <wolfssl/wolfcrypt/error-crypt.h>
+
+#include "esp_wolfssl_ecc_hw.h"
+
+#ifdef WOLFSSL_ESPIDF
+    #include <esp_idf_version.h>
+    #include <esp_crypto_lock.h>
+    #include <soc/soc_caps.h>
+    #include <hal/ecc_hal.h>
+    #if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 2, 0)
+        #include <hal/ecc_ll.h>
+        #include <esp_private/esp_crypto_lock_internal.h>
+    #else
+        #include <esp_private/periph_ctrl.h>
+    #endif
+#endif
+
+#ifdef WOLFSSL_ESP_TRACE
+    /* tracing wraps the same functions and calls the ones here */
+    #define EH_WRAP 0
+#else
+    #define EH_WRAP 1
+#endif
+
+/* largest curve, P-256 */
+#define EH_MAX_SZ       32
+#define EH_WORDS        (EH_MAX_SZ / 4)
+
+/*
+ * Curves, big-endian
+ */
+
+typedef struct eh_curve {
+    int         id;
+    word32      sz;
+    int         hw_curve;
+    const byte* p;
+    const byte* n;
+    const byte* b;
+    const byte* gx;
+    const byte* gy;
+} eh_curve;
+
+static const byte eh_p256_p[32] = {
+    0xFF, 0xFF, 0xFF, 0xFF, 0x00, 0x00, 0x00, 0x01,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF
+};
+static const byte eh_p256_n[32] = {
+    0xFF, 0xFF, 0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xBC, 0xE6, 0xFA, 0xAD, 0xA7, 0x17, 0x9E, 0x84,
+    0xF3, 0xB9, 0xCA, 0xC2, 0xFC, 0x63, 0x25, 0x51
+};
+static const byte eh_p256_b[32] = {
+    0x5A, 0xC6, 0x35, 0xD8, 0xAA, 0x3A, 0x93, 0xE7,
+    0xB3, 0xEB, 0xBD, 0x55, 0x76, 0x98, 0x86, 0xBC,
+    0x65, 0x1D, 0x06, 0xB0, 0xCC, 0x53, 0xB0, 0xF6,
+    0x3B, 0xCE, 0x3C, 0x3E, 0x27, 0xD2, 0x60, 0x4B
+};
+static const byte eh_p256_gx[32] = {
+    0x6B, 0x17, 0xD1, 0xF2, 0xE1, 0x2C, 0x42, 0x47,
+    0xF8, 0xBC, 0xE6, 0xE5, 0x63, 0xA4, 0x40, 0xF2,
+    0x77, 0x03, 0x7D, 0x81, 0x2D, 0xEB, 0x33, 0xA0,
+    0xF4, 0xA1, 0x39, 0x45, 0xD8, 0x98, 0xC2, 0x96
+};
+static const byte eh_p256_gy[32] = {
+    0x4F, 0xE3, 0x42, 0xE2, 0xFE, 0x1A, 0x7F, 0x9B,
+    0x8E, 0xE7, 0xEB, 0x4A, 0x7C, 0x0F, 0x9E, 0x16,
+    0x2B, 0xCE, 0x33, 0x57, 0x6B, 0x31, 0x5E, 0xCE,
+    0xCB, 0xB6, 0x40, 0x68, 0x37, 0xBF, 0x51, 0xF5
+};
+
+static const byte eh_p192_p[24] = {
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFE,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF
+};
+static const byte eh_p192_n[24] = {
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0x99, 0xDE, 0xF8, 0x36,
+    0x14, 0x6B, 0xC9, 0xB1, 0xB4, 0xD2, 0x28, 0x31
+};
+static const byte eh_p192_b[24] = {
+    0x64, 0x21, 0x05, 0x19, 0xE5, 0x9C, 0x80, 0xE7,
+    0x0F, 0xA7, 0xE9, 0xAB, 0x72, 0x24, 0x30, 0x49,
+    0xFE, 0xB8, 0xDE, 0xEC, 0xC1, 0x46, 0xB9, 0xB1
+};
+static const byte eh_p192_gx[24] = {
+    0x18, 0x8D, 0xA8, 0x0E, 0xB0, 0x30, 0x90, 0xF6,
+    0x7C, 0xBF, 0x20, 0xEB, 0x43, 0xA1, 0x88, 0x00,
+    0xF4, 0xFF, 0x0A, 0xFD, 0x82, 0xFF, 0x10, 0x12
+};
+static const byte eh_p192_gy[24] = {
+    0x07, 0x19, 0x2B, 0x95, 0xFF, 0xC8, 0xDA, 0x78,
+    0x63, 0x10, 0x11, 0xED, 0x6B, 0x24, 0xCD, 0xD5,
+    0x73, 0xF9, 0x77, 0xA1, 0x1E, 0x79, 0x48, 0x11
+};
+
+/*
+ * Register access: the ESP-IDF HAL on the device, a model of it on a host.
+ * Values in the peripheral's memory are little-endian.
+ */
+
+#ifdef WOLFSSL_ESPIDF
+
+#define EH_MODE_MUL         ECC_MODE_POINT_MUL
+#define EH_MODE_CHECK       ECC_MODE_VERIFY
+#define EH_MODE_CHECK_MUL   ECC_MODE_VERIFY_THEN_POINT_MUL
+#define EH_CURVE_P192       ECC_CURVE_SECP192R1
+#define EH_CURVE_P256       ECC_CURVE_SECP256R1
+
+#define eh_hal_write_mul_param      ecc_hal_write_mul_param
+#define eh_hal_write_verify_param   ecc_hal_write_verify_param
+#define eh_hal_set_mode             ecc_hal_set_mode
+#define eh_hal_set_curve            ecc_hal_set_curve
+#define eh_hal_start_calc           ecc_hal_start_calc
+#define eh_hal_is_calc_finished     ecc_hal_is_calc_finished
+#define eh_hal_read_mul_result      ecc_hal_read_mul_result
+#define eh_hal_read_verify_result   ecc_hal_read_verify_result
+
+#else
+
+/* the register model below, same values as the ECC peripheral */
+typedef enum {
+    EH_MODE_MUL       = 0,
+    EH_MODE_CHECK     = 2,
+    EH_MODE_CHECK_MUL = 3
+} eh_mode_t;
+
+enum {
+    EH_CURVE_P192 = 0,
+    EH_CURVE_P256 = 1
+};
+
+#endif /* WOLFSSL_ESPIDF */
+
+static const eh_curve eh_curves[] = {
+    { ECC_SECP192R1, 24, EH_CURVE_P192,
+      eh_p192_p, eh_p192_n, eh_p192_b, eh_p192_gx, eh_p192_gy },
+    { ECC_SECP256R1, 32, EH_CURVE_P256,
+      eh_p256_p, eh_p256_n, eh_p256_b, eh_p256_gx, eh_p256_gy },
+};
+
+#ifdef WOLFSSL_ESPIDF
+
+/* shared with the ECDSA peripheral and mbedTLS */
+static void eh_hw_acquire(void)
+{
+    esp_crypto_ecc_lock_acquire();
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 2, 0)
+    ECC_RCC_ATOMIC() {
+        ecc_ll_enable_bus_clock(true);
+        ecc_ll_reset_register();
+    }
+#else
+    periph_module_enable(PERIPH_ECC_MODULE);
+#endif
+#if SOC_ECC_CONSTANT_TIME_POINT_MUL
+    ecc_hal_enable_constant_time_point_mul(true);
+#endif
+}
+
+static void eh_hw_release(void)
+{
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 2, 0)
+    ECC_RCC_ATOMIC() {
+        ecc_ll_enable_bus_clock(false);
+    }
+#else
+    periph_module_disable(PERIPH_ECC_MODULE);
+#endif
+    esp_crypto_ecc_lock_release();
+}
+
+#endif /* WOLFSSL_ESPIDF */
+
+/*
+ * Little-endian 32-bit words, for the verification and the model. Apart
+ * from the range check of a new private key, with eh_bn_sub() and
+ * eh_bn_is_zero(), none of this sees private values; it need not be
+ * constant time.
+ */
+
+typedef struct eh_bn {
+    uint32_t w[EH_WORDS];
+} eh_bn;
+
+static void eh_bn_from_be(eh_bn* a, const byte* in, word32 sz)
+{
+    word32 i;
+
+    XMEMSET(a, 0, sizeof(*a));
+    for (i = 0; i < sz; i++) {
+        a->w[i / 4] |= (uint32_t)in[sz - 1 - i] << (8 * (i % 4));
+    }
+}
+
+static void eh_bn_to_be(byte* out, word32 sz, const eh_bn* a)
+{
+    word32 i;
+
+    for (i = 0; i < sz; i++) {
+        out[sz - 1 - i] = (byte)(a->w[i / 4] >> (8 * (i % 4)));
+    }
+}
+
+static int eh_bn_cmp(const eh_bn* a, const eh_bn* b)
+{
+    int i;
+
+    for (i = EH_WORDS - 1; i >= 0; i--) {
+        if (a->w[i] != b->w[i]) {
+            return (a->w[i] > b->w[i]) ? 1 : -1;
+        }
+    }
+    return 0;
+}
+
+static int eh_bn_is_zero(const eh_bn* a)
+{
+    uint32_t acc = 0;
+    int i;
+
+    for (i = 0; i < EH_WORDS; i++) {
+        acc |= a->w[i];
+    }
+    return acc == 0;
+}
+
+static int eh_bn_is_one(const eh_bn* a)
+{
+    uint32_t acc = a->w[0] ^ 1;
+    int i;
+
+    for (i = 1; i < EH_WORDS; i++) {
+        acc |= a->w[i];
+    }
+    return acc == 0;
+}
+
+/* r = a + b, returns the carry */
+static uint32_t eh_bn_add(eh_bn* r, const eh_bn* a, const eh_bn* b)
+{
+    uint64_t t = 0;
+    int i;
+
+    for (i = 0; i < EH_WORDS; i++) {
+        t += (uint64_t)a->w[i] + b->w[i];
+        r->w[i] = (uint32_t)t;
+        t >>= 32;
+    }
+    return (uint32_t)t;
+}
+
+/* r = a - b, returns the borrow */
+static uint32_t eh_bn_sub(eh_bn* r, const eh_bn* a, const eh_bn* b)
+{
+    int64_t t = 0;
+    int i;
+
+    for (i = 0; i < EH_WORDS; i++) {
+        t += (int64_t)a->w[i] - b->w[i];
+        r->w[i] = (uint32_t)t;
+        t >>= 32;
+    }
+    return (uint32_t)(t & 1);
+}
+
+/* a = (top:a) >> 1 */
+static void eh_bn_shr1(eh_bn* a, uint32_t top)
+{
+    int i;
+
+    for (i = 0; i < EH_WORDS - 1; i++) {
+        a->w[i] = (a->w[i] >> 1) | (a->w[i + 1] << 31);
+    }
+    a->w[EH_WORDS - 1] = (a->w[EH_WORDS - 1] >> 1) | (top << 31);
+}
+
+/* a and b below m */
+static void eh_mod_add(eh_bn* r, const eh_bn* a, const eh_bn* b,
+                       const eh_bn* m)
+{
+    uint32_t carry = eh_bn_add(r, a, b);
+
+    if (carry || eh_bn_cmp(r, m) >= 0) {
+        eh_bn_sub(r, r, m);
+    }
+}
+
+static void eh_mod_sub(eh_bn* r, const eh_bn* a, const eh_bn* b,
+                       const eh_bn* m)
+{
+    if (eh_bn_sub(r, a, b)) {
+        eh_bn_add(r, r, m);
+    }
+}
+
+/* double and add over the bits of b; r may be a or b */
+static void eh_mod_mul(eh_bn* r, const eh_bn* a, const eh_bn* b,
+                       const eh_bn* m)
+{
+    eh_bn acc;
+    eh_bn x = *a;
+    eh_bn y = *b;
+    int i;
+
+    XMEMSET(&acc, 0, sizeof(acc));
+    for (i = EH_WORDS * 32 - 1; i >= 0; i--) {
+        eh_mod_add(&acc, &acc, &acc, m);
+        if ((y.w[i / 32] >> (i % 32)) & 1) {
+            eh_mod_add(&acc, &acc, &x, m);
+        }
+    }
+    *r = acc;
+}
+
+/* binary extended Euclid; m odd, a in [1, m) */
+static void eh_mod_inv(eh_bn* r, const eh_bn* a, const eh_bn* m)
+{
+    eh_bn u = *a;
+    eh_bn v = *m;
+    eh_bn x1;
+    eh_bn x2;
+
+    XMEMSET(&x1, 0, sizeof(x1));
+    XMEMSET(&x2, 0, sizeof(x2));
+    x1.w[0] = 1;
+
+    while (!eh_bn_is_one(&u) && !eh_bn_is_one(&v)) {
+        while ((u.w[0] & 1) == 0) {
+            eh_bn_shr1(&u, 0);
+            eh_bn_shr1(&x1, (x1.w[0] & 1) ? eh_bn_add(&x1, &x1, m) : 0);
+        }
+        while ((v.w[0] & 1) == 0) {
+            eh_bn_shr1(&v, 0);
+            eh_bn_shr1(&x2, (x2.w[0] & 1) ? eh_bn_add(&x2, &x2, m) : 0);
+        }
+        if (eh_bn_cmp(&u, &v) >= 0) {
+            eh_bn_sub(&u, &u, &v);
+            eh_mod_sub(&x1, &x1, &x2, m);
+        }
+        else {
+            eh_bn_sub(&v, &v, &u);
+            eh_mod_sub(&x2, &x2, &x1, m);
+        }
+    }
+    *r = eh_bn_is_one(&u) ? x1 : x2;
+}
+
+/* y^2 = x^3 - 3x + b, with x and y below p */
+static int eh_on_curve(const eh_curve* c, const eh_bn* x, const eh_bn* y)
+{
+    eh_bn p;
+    eh_bn b;
+    eh_bn l;
+    eh_bn t;
+
+    eh_bn_from_be(&p, c->p, c->sz);
+    eh_bn_from_be(&b, c->b, c->sz);
+    if (eh_bn_cmp(x, &p) >= 0 || eh_bn_cmp(y, &p) >= 0) {
+        return 0;
+    }
+    eh_mod_mul(&l, y, y, &p);
+    eh_mod_mul(&t, x, x, &p);
+    eh_mod_mul(&t, &t, x, &p);
+    eh_mod_sub(&t, &t, x, &p);
+    eh_mod_sub(&t, &t, x, &p);
+    eh_mod_sub(&t, &t, x, &p);
+    eh_mod_add(&t, &t, &b, &p);
+    return eh_bn_cmp(&l, &t) == 0;
+}
+
+#ifndef WOLFSSL_ESPIDF
+/*
+ * Register model of the peripheral: parameter memories, mode, curve and
+ * the done flag, with the point multiplication in Jacobian coordinates.
+ */
+
+typedef struct eh_model_t {
+    int     mode;
+    int     curve;
+    uint8_t k[EH_MAX_SZ];
+    uint8_t px[EH_MAX_SZ];
+    uint8_t py[EH_MAX_SZ];
+    uint8_t qx[EH_MAX_SZ];
+    uint8_t qy[EH_MAX_SZ];
+    int     valid;
+    int     busy;   /* polls until done */
+} eh_model_t;
+
+static eh_model_t eh_model;
+
+typedef struct eh_jpoint {
+    eh_bn x;
+    eh_bn y;
+    eh_bn z;        /* zero at infinity */
+} eh_jpoint;
+
+static void eh_le_to_bn(eh_bn* a, const uint8_t* in, uint16_t len)
+{
+    uint16_t i;
+
+    XMEMSET(a, 0, sizeof(*a));
+    for (i = 0; i < len; i++) {
+        a->w[i / 4] |= (uint32_t)in[i] << (8 * (i % 4));
+    }
+}
+
+static void eh_bn_to_le(uint8_t* out, uint16_t len, const eh_bn* a)
+{
+    uint16_t i;
+
+    for (i = 0; i < len; i++) {
+        out[i] = (uint8_t)(a->w[i / 4] >> (8 * (i % 4)));
+    }
+}
+
+/* a = -3 */
+static void eh_jdouble(eh_jpoint* r, const eh_jpoint* a, const eh_bn* p)
+{
+    eh_bn delta;
+    eh_bn gamma;
+    eh_bn beta;
+    eh_bn alpha;
+    eh_bn t;
+    eh_bn u;
+
+    if (eh_bn_is_zero(&a->z) || eh_bn_is_zero(&a->y)) {
+        XMEMSET(r, 0, sizeof(*r));
+        return;
+    }
+    eh_mod_mul(&delta, &a->z, &a->z, p);
+    eh_mod_mul(&gamma, &a->y, &a->y, p);
+    eh_mod_mul(&beta, &a->x, &gamma, p);
+    eh_mod_sub(&t, &a->x, &delta, p);
+    eh_mod_add(&u, &a->x, &delta, p);
+    eh_mod_mul(&alpha, &t, &u, p);
+    eh_mod_add(&t, &alpha, &alpha, p);
+    eh_mod_add(&alpha, &alpha, &t, p);
+    /* z3 = (y + z)^2 - gamma - delta */
+    eh_mod_add(&t, &a->y, &a->z, p);
+    eh_mod_mul(&t, &t, &t, p);
+    eh_mod_sub(&t, &t, &gamma, p);
+    eh_mod_sub(&r->z, &t, &delta, p);
+    /* x3 = alpha^2 - 8 beta */
+    eh_mod_add(&beta, &beta, &beta, p);
+    eh_mod_add(&beta, &beta, &beta, p);
+    eh_mod_mul(&t, &alpha, &alpha, p);
+    eh_mod_sub(&t, &t, &beta, p);
+    eh_mod_sub(&r->x, &t, &beta, p);
+    /* y3 = alpha (4 beta - x3) - 8 gamma^2 */
+    eh_mod_sub(&u, &beta, &r->x, p);
+    eh_mod_mul(&u, &alpha, &u, p);
+    eh_mod_mul(&gamma, &gamma, &gamma, p);
+    eh_mod_add(&gamma, &gamma, &gamma, p);
+    eh_mod_add(&gamma, &gamma, &gamma, p);
+    eh_mod_add(&gamma, &gamma, &gamma, p);
+    eh_mod_sub(&r->y, &u, &gamma, p);
+}
+
+/* r = a + (qx, qy) */
+static void eh_jadd_affine(eh_jpoint* r, const eh_jpoint* a,
+                           const eh_bn* qx, const eh_bn* qy, const eh_bn* p)
+{
+    eh_bn z2;
+    eh_bn h;
+    eh_bn s;
+    eh_bn hh;
+    eh_bn hhh;
+    eh_bn v;
+    eh_bn t;
+
+    if (eh_bn_is_zero(&a->z)) {
+        r->x = *qx;
+        r->y = *qy;
+        XMEMSET(&r->z, 0, sizeof(r->z));
+        r->z.w[0] = 1;
+        return;
+    }
+    eh_mod_mul(&z2, &a->z, &a->z, p);
+    eh_mod_mul(&h, qx, &z2, p);
+    eh_mod_sub(&h, &h, &a->x, p);
+    eh_mod_mul(&s, &z2, &a->z, p);
+    eh_mod_mul(&s, &s, qy, p);
+    eh_mod_sub(&s, &s, &a->y, p);
+    if (eh_bn_is_zero(&h)) {
+        if (eh_bn_is_zero(&s)) {
+            eh_jdouble(r, a, p);
+        }
+        else {
+            XMEMSET(r, 0, sizeof(*r));
+        }
+        return;
+    }
+    eh_mod_mul(&hh, &h, &h, p);
+    eh_mod_mul(&hhh, &h, &hh, p);
+    eh_mod_mul(&v, &a->x, &hh, p);
+    eh_mod_mul(&r->z, &a->z, &h, p);
+    /* x3 = s^2 - hhh - 2 v */
+    eh_mod_mul(&t, &s, &s, p);
+    eh_mod_sub(&t, &t, &hhh, p);
+    eh_mod_sub(&t, &t, &v, p);
+    eh_mod_sub(&t, &t, &v, p);
+    /* y3 = s (v - x3) - y1 hhh */
+    eh_mod_sub(&v, &v, &t, p);
+    eh_mod_mul(&v, &s, &v, p);
+    eh_mod_mul(&hhh, &a->y, &hhh, p);
+    eh_mod_sub(&r->y, &v, &hhh, p);
+    r->x = t;
+}
+
+static void eh_model_run(void)
+{
+    const eh_curve* c;
+    eh_jpoint acc;
+    eh_bn k;
+    eh_bn x;
+    eh_bn y;
+    eh_bn p;
+    eh_bn zi;
+    eh_bn t;
+    uint16_t len;
+    int i;
+
+    c = &eh_curves[(eh_model.curve == EH_CURVE_P256) ? 1 : 0];
+    len = (uint16_t)c->sz;
+
+    eh_le_to_bn(&x, eh_model.px, len);
+    eh_le_to_bn(&y, eh_model.py, len);
+    eh_model.valid = eh_on_curve(c, &x, &y);
+    if (eh_model.mode == EH_MODE_CHECK
+            || (eh_model.mode == EH_MODE_CHECK_MUL && !eh_model.valid)) {
+        return;
+    }
+
+    eh_bn_from_be(&p, c->p, c->sz);
+    eh_le_to_bn(&k, eh_model.k, len);
+    XMEMSET(&acc, 0, sizeof(acc));
+    for (i = (int)len * 8 - 1; i >= 0; i--) {
+        eh_jdouble(&acc, &acc, &p);
+        if ((k.w[i / 32] >> (i % 32)) & 1) {
+            eh_jadd_affine(&acc, &acc, &x, &y, &p);
+        }
+    }
+    if (eh_bn_is_zero(&acc.z)) {
+        XMEMSET(eh_model.qx, 0, sizeof(eh_model.qx));
+        XMEMSET(eh_model.qy, 0, sizeof(eh_model.qy));
+        return;
+    }
+    eh_mod_inv(&zi, &acc.z, &p);
+    eh_mod_mul(&t, &zi, &zi, &p);
+    eh_mod_mul(&x, &acc.x, &t, &p);
+    eh_mod_mul(&t, &t, &zi, &p);
+    eh_mod_mul(&y, &acc.y, &t, &p);
+    eh_bn_to_le(eh_model.qx, len, &x);
+    eh_bn_to_le(eh_model.qy, len, &y);
+}
+
+static void eh_hal_write_mul_param(const uint8_t* k, const uint8_t* px,
+                                   const uint8_t* py, uint16_t len)
+{
+    XMEMCPY(eh_model.k, k, len);
+    XMEMCPY(eh_model.px, px, len);
+    XMEMCPY(eh_model.py, py, len);
+}
+
+static void eh_hal_write_verify_param(const uint8_t* px, const uint8_t* py,
+                                      uint16_t len)
+{
+    XMEMCPY(eh_model.px, px, len);
+    XMEMCPY(eh_model.py, py, len);
+}
+
+static void eh_hal_set_mode(eh_mode_t mode)
+{
+    eh_model.mode = mode;
+}
+
+static void eh_hal_set_curve(int curve)
+{
+    eh_model.curve = curve;
+}
+
+static void eh_hal_start_calc(void)
+{
+    eh_model_run();
+    eh_model.busy = 2;
+}
+
+static int eh_hal_is_calc_finished(void)
+{
+    if (eh_model.busy > 0) {
+        eh_model.busy--;
+        return 0;
+    }
+    return 1;
+}
+
+/* -1 when the point check of EH_MODE_CHECK_MUL failed */
+static int eh_hal_read_mul_result(uint8_t* rx, uint8_t* ry, uint16_t len)
+{
+    if (eh_model.mode == EH_MODE_CHECK_MUL && !eh_model.valid) {
+        return -1;
+    }
+    XMEMCPY(rx, eh_model.qx, len);
+    XMEMCPY(ry, eh_model.qy, len);
+    return 0;
+}
+
+static int eh_hal_read_verify_result(void)
+{
+    return eh_model.valid;
+}
+
+/* one operation at a time, as on the device */
+static wolfSSL_Mutex eh_model_mutex;
+static int eh_model_mutex_ok;
+
+static void __attribute__((constructor)) eh_model_init(void)
+{
+    eh_model_mutex_ok = (wc_InitMutex(&eh_model_mutex) == 0);
+}
+
+static void eh_hw_acquire(void)
+{
+    if (eh_model_mutex_ok) {
+        wc_LockMutex(&eh_model_mutex);
+    }
+}
+
+static void eh_hw_release(void)
+{
+    if (eh_model_mutex_ok) {
+        wc_UnLockMutex(&eh_model_mutex);
+    }
+}
+
+#endif /* !WOLFSSL_ESPIDF */
+
+/*
+ * Driver
+ */
+
+static int eh_enabled = 1;
+static esp_wolfssl_ecc_hw_stats_t eh_stats;
+
+#define EH_COUNT(field) \
+    ((void)__atomic_fetch_add(&eh_stats.field, 1, __ATOMIC_RELAXED))
+
+static const eh_curve* eh_find_curve(int curve_id)
+{
+    word32 i;
+
+    for (i = 0; i < sizeof(eh_curves) / sizeof(eh_curves[0]); i++) {
+        if (eh_curves[i].id == curve_id) {
+            return &eh_curves[i];
+        }
+    }
+    return NULL;
+}
+
+static void eh_reverse(uint8_t* out, const byte* in, word32 sz)
+{
+    word32 i;
+
+    for (i = 0; i < sz; i++) {
+        out[i] = in[sz - 1 - i];
+    }
+}
+
+/* private values; not optimised away like a memset before return */
+static void eh_zero(void* p, word32 sz)
+{
+    volatile byte* b = (volatile byte*)p;
+
+    while (sz-- > 0) {
+        *b++ = 0;
+    }
+}
+
+static void eh_hw_wait(void)
+{
+    while (!eh_hal_is_calc_finished()) {
+    }
+}
+
+int esp_wolfssl_ecc_hw_mul(int curve_id, const byte* k, const byte* px,
+                           const byte* py, byte* rx, byte* ry, int check)
+{
+    const eh_curve* c = eh_find_curve(curve_id);
+    uint8_t k_le[EH_MAX_SZ];
+    uint8_t x_le[EH_MAX_SZ];
+    uint8_t y_le[EH_MAX_SZ];
+    uint16_t len;
+    int ret;
+
+    if (c == NULL || k == NULL || px == NULL || py == NULL || rx == NULL
+            || ry == NULL) {
+        return BAD_FUNC_ARG;
+    }
+    len = (uint16_t)c->sz;
+    eh_reverse(k_le, k, c->sz);
+    eh_reverse(x_le, px, c->sz);
+    eh_reverse(y_le, py, c->sz);
+
+    eh_hw_acquire();
+    eh_hal_write_mul_param(k_le, x_le, y_le, len);
+    eh_hal_set_mode(check ? EH_MODE_CHECK_MUL : EH_MODE_MUL);
+    eh_hal_set_curve(c->hw_curve);
+    eh_hal_start_calc();
+    eh_hw_wait();
+    ret = eh_hal_read_mul_result(x_le, y_le, len);
+    eh_hw_release();
+
+    eh_zero(k_le, sizeof(k_le));
+    EH_COUNT(point_muls);
+    if (ret == 0) {
+        eh_reverse(rx, x_le, c->sz);
+        eh_reverse(ry, y_le, c->sz);
+    }
+    /* the result is the ECDH shared secret */
+    eh_zero(x_le, sizeof(x_le));
+    eh_zero(y_le, sizeof(y_le));
+    return (ret == 0) ? 0 : IS_POINT_E;
+}
+
+int esp_wolfssl_ecc_hw_check_point(int curve_id, const byte* px,
+                                   const byte* py)
+{
+    const eh_curve* c = eh_find_curve(curve_id);
+    uint8_t x_le[EH_MAX_SZ];
+    uint8_t y_le[EH_MAX_SZ];
+    int valid;
+
+    if (c == NULL || px == NULL || py == NULL) {
+        return BAD_FUNC_ARG;
+    }
+    eh_reverse(x_le, px, c->sz);
+    eh_reverse(y_le, py, c->sz);
+
+    eh_hw_acquire();
+    eh_hal_write_verify_param(x_le, y_le, (uint16_t)c->sz);
+    eh_hal_set_mode(EH_MODE_CHECK);
+    eh_hal_set_curve(c->hw_curve);
+    eh_hal_start_calc();
+    eh_hw_wait();
+    valid = eh_hal_read_verify_result();
+    eh_hw_release();
+
+    EH_COUNT(point_checks);
+    return valid ? 0 : IS_POINT_E;
+}
+
+int esp_wolfssl_ecc_hw_verify_rs(int curve_id, const byte* hash,
+                                 word32 hashlen, const byte* r,
+                                 const byte* s, const byte* qx,
+                                 const byte* qy, int* res)
+{
+    const eh_curve* c = eh_find_curve(curve_id);
+    byte k[EH_MAX_SZ];
+    byte x1[EH_MAX_SZ];
+    byte y1[EH_MAX_SZ];
+    byte x2[EH_MAX_SZ];
+    byte y2[EH_MAX_SZ];
+    eh_bn n;
+    eh_bn p;
+    eh_bn br;
+    eh_bn bs;
+    eh_bn e;
+    eh_bn w;
+    eh_bn u;
+    eh_bn a1;
+    eh_bn b1;
+    eh_bn a2;
+    eh_bn b2;
+    int ret;
+
+    if (c == NULL || hash == NULL || r == NULL || s == NULL || qx == NULL
+            || qy == NULL || res == NULL) {
+        return BAD_FUNC_ARG;
+    }
+    *res = 0;
+
+    eh_bn_from_be(&n, c->n, c->sz);
+    eh_bn_from_be(&br, r, c->sz);
+    eh_bn_from_be(&bs, s, c->sz);
+    if (eh_bn_is_zero(&br) || eh_bn_cmp(&br, &n) >= 0
+            || eh_bn_is_zero(&bs) || eh_bn_cmp(&bs, &n) >= 0) {
+        return NOT_COMPILED_IN;
+    }
+
+    /* leftmost bits of the hash, which for these sizes are whole bytes */
+    eh_bn_from_be(&e, hash, (hashlen < c->sz) ? hashlen : c->sz);
+    if (eh_bn_cmp(&e, &n) >= 0) {
+        eh_bn_sub(&e, &e, &n);
+    }
+
+    /* u1 = e / s, u2 = r / s */
+    eh_mod_inv(&w, &bs, &n);
+    eh_mod_mul(&u, &e, &w, &n);
+    if (eh_bn_is_zero(&u)) {
+        return NOT_COMPILED_IN;
+    }
+    eh_bn_to_be(k, c->sz, &u);
+    ret = esp_wolfssl_ecc_hw_mul(curve_id, k, c->gx, c->gy, x1, y1, 0);
+    if (ret != 0) {
+        return ret;
+    }
+    eh_mod_mul(&u, &br, &w, &n);
+    eh_bn_to_be(k, c->sz, &u);
+    ret = esp_wolfssl_ecc_hw_mul(curve_id, k, qx, qy, x2, y2, 1);
+    if (ret != 0) {
+        /* not on the curve: as software would treat it */
+        return (ret == IS_POINT_E) ? NOT_COMPILED_IN : ret;
+    }
+
+    /* u1 G + u2 Q in affine coordinates, unless a doubling or infinity */
+    eh_bn_from_be(&p, c->p, c->sz);
+    eh_bn_from_be(&a1, x1, c->sz);
+    eh_bn_from_be(&b1, y1, c->sz);
+    eh_bn_from_be(&a2, x2, c->sz);
+    eh_bn_from_be(&b2, y2, c->sz);
+    if (eh_bn_cmp(&a1, &a2) == 0) {
+        return NOT_COMPILED_IN;
+    }
+    eh_mod_sub(&w, &a2, &a1, &p);
+    eh_mod_inv(&w, &w, &p);
+    eh_mod_sub(&u, &b2, &b1, &p);
+    eh_mod_mul(&u, &u, &w, &p);
+    eh_mod_mul(&w, &u, &u, &p);
+    eh_mod_sub(&w, &w, &a1, &p);
+    eh_mod_sub(&w, &w, &a2, &p);
+    if (eh_bn_cmp(&w, &n) >= 0) {
+        eh_bn_sub(&w, &w, &n);
+    }
+
+    *res = (eh_bn_cmp(&w, &br) == 0);
+    EH_COUNT(verifies);
+    return 0;
+}
+
+/*
+ * Known answers: (x, y) = k G, and an ECDSA signature (r, s) of
+ * SHA-256("abc") by the key with public point (qx, qy).
+ */
+
+static const byte eh_kat_hash[32] = {
+    0xba, 0x78, 0x16, 0xbf, 0x8f, 0x01, 0xcf, 0xea,
+    0x41, 0x41, 0x40, 0xde, 0x5d, 0xae, 0x22, 0x23,
+    0xb0, 0x03, 0x61, 0xa3, 0x96, 0x17, 0x7a, 0x9c,
+    0xb4, 0x10, 0xff, 0x61, 0xf2, 0x00, 0x15, 0xad
+};
+
+typedef struct eh_kat {
+    int  curve_id;
+    byte k[EH_MAX_SZ];
+    byte x[EH_MAX_SZ];
+    byte y[EH_MAX_SZ];
+    byte qx[EH_MAX_SZ];
+    byte qy[EH_MAX_SZ];
+    byte r[EH_MAX_SZ];
+    byte s[EH_MAX_SZ];
+} eh_kat;
+
+static const eh_kat eh_kats[] = {
+    {
+        ECC_SECP256R1,
+        {
+            0x68, 0x80, 0xf4, 0x34, 0x8a, 0xf5, 0xad, 0x6d,
+            0xdc, 0x9b, 0xa1, 0x1e, 0xe4, 0x94, 0x67, 0x9b,
+            0x09, 0x62, 0x32, 0x88, 0xb8, 0xa5, 0x3f, 0x39,
+            0x33, 0xb2, 0xc1, 0x32, 0x10, 0x94, 0x2c, 0xa4
+        },
+        {
+            0x53, 0x2c, 0x7d, 0xc6, 0x1b, 0x58, 0xcf, 0x27,
+            0x5f, 0xfe, 0x92, 0x4f, 0xa2, 0xfc, 0x0e, 0x4f,
+            0x16, 0x2a, 0xc9, 0xc2, 0x20, 0xfd, 0xe6, 0x92,
+            0xb4, 0x07, 0xfe, 0x7e, 0x97, 0x69, 0x72, 0x45
+        },
+        {
+            0xe0, 0x11, 0x95, 0xfe, 0x47, 0xcc, 0x61, 0xd7,
+            0x99, 0x45, 0x71, 0xb9, 0xbc, 0xc9, 0x71, 0xea,
+            0x2b, 0x14, 0xcf, 0x06, 0x67, 0x89, 0xb7, 0xa8,
+            0x4e, 0x0a, 0x07, 0x90, 0xad, 0xce, 0x40, 0x86
+        },
+        {
+            0x83, 0xbf, 0x93, 0x3a, 0x36, 0xfc, 0xcc, 0xb5,
+            0xa6, 0x03, 0xb7, 0x98, 0x4f, 0x0c, 0xe0, 0x21,
+            0x2c, 0x66, 0x5c, 0xa3, 0x8e, 0x6e, 0x32, 0x31,
+            0x50, 0x1a, 0x98, 0x33, 0x94, 0x51, 0xe3, 0x22
+        },
+        {
+            0x91, 0x38, 0x59, 0x13, 0x5d, 0xb9, 0x5f, 0x99,
+            0x7c, 0xed, 0x3f, 0x58, 0xbe, 0xe7, 0x96, 0xb9,
+            0x3e, 0x32, 0x8b, 0xe7, 0x19, 0xf8, 0x63, 0x66,
+            0x5f, 0x88, 0xaf, 0x8c, 0x92, 0x60, 0xeb, 0xb5
+        },
+        {
+            0xfc, 0x46, 0xf3, 0xd9, 0xc6, 0x40, 0x4a, 0xb1,
+            0x55, 0xfc, 0xfd, 0x6f, 0x0c, 0x23, 0xd3, 0x6f,
+            0x6a, 0xd4, 0x3d, 0xf7, 0x94, 0xaa, 0xab, 0xd7,
+            0x2f, 0xf4, 0x91, 0xbe, 0x91, 0xfd, 0xd6, 0x64
+        },
+        {
+            0x37, 0x05, 0xad, 0xf3, 0xe1, 0xd1, 0x76, 0x8a,
+            0xb4, 0x2b, 0x46, 0xa9, 0x45, 0xb7, 0x84, 0xe3,
+            0xc9, 0x16, 0x4e, 0x71, 0x30, 0x19, 0x8a, 0x37,
+            0x84, 0x2f, 0x6f, 0x84, 0x6f, 0x88, 0x51, 0x15
+        }
+    },
+    {
+        ECC_SECP192R1,
+        {
+            0x29, 0xa2, 0xbc, 0xda, 0x6c, 0xc0, 0x88, 0x52,
+            0xaf, 0x4d, 0xc0, 0x70, 0xbf, 0xc1, 0x2c, 0x72,
+            0xa8, 0x7b, 0x83, 0x37, 0xed, 0x2b, 0x35, 0xb2
+        },
+        {
+            0x55, 0xa6, 0xc1, 0xfe, 0x9f, 0x02, 0x76, 0xba,
+            0xd3, 0x79, 0x85, 0x69, 0x35, 0xf1, 0x5c, 0x87,
+            0x85, 0xcc, 0x48, 0x17, 0xc0, 0x24, 0xf3, 0x85
+        },
+        {
+            0x0a, 0xe8, 0xec, 0x5f, 0x7b, 0x23, 0x48, 0x07,
+            0x8c, 0x02, 0x9f, 0x58, 0x3e, 0x79, 0x8c, 0xf7,
+            0x6e, 0x1c, 0x99, 0xe2, 0x1c, 0x2b, 0x76, 0x61
+        },
+        {
+            0x90, 0xf8, 0xa0, 0xac, 0x34, 0xcf, 0x39, 0x2a,
+            0x5f, 0x65, 0x4f, 0x1b, 0x18, 0xe2, 0xad, 0x8e,
+            0x7d, 0xcc, 0xf7, 0x96, 0xdd, 0xbc, 0xab, 0xf9
+        },
+        {
+            0xa1, 0xa9, 0xb9, 0xb5, 0x48, 0xac, 0x1d, 0xfa,
+            0x5d, 0x1b, 0x0a, 0x72, 0x5b, 0x5f, 0x2b, 0x26,
+            0x32, 0x34, 0xe6, 0x2b, 0x05, 0xd9, 0x2b, 0x4c
+        },
+        {
+            0x44, 0x51, 0xd8, 0x71, 0x70, 0x9e, 0x4c, 0x86,
+            0x8f, 0x6d, 0x40, 0x2f, 0x9b, 0xf3, 0x89, 0x22,
+            0x34, 0x1a, 0xca, 0x4d, 0x44, 0x0b, 0x71, 0xa9
+        },
+        {
+            0x04, 0xe0, 0x67, 0xb4, 0xc6, 0xbf, 0xab, 0x3f,
+            0xd9, 0xf3, 0x59, 0x0d, 0xc3, 0xdf, 0xa7, 0x7d,
+            0x3f, 0x48, 0x75, 0x02, 0xb0, 0xc7, 0x2e, 0xe1
+        }
+    }
+};
+
+int esp_wolfssl_ecc_hw_self_test(void)
+{
+    byte x[EH_MAX_SZ];
+    byte y[EH_MAX_SZ];
+    byte s[EH_MAX_SZ];
+    word32 i;
+    int res;
+    int ret;
+
+    for (i = 0; i < sizeof(eh_kats) / sizeof(eh_kats[0]); i++) {
+        const eh_kat* t = &eh_kats[i];
+        const eh_curve* c = eh_find_curve(t->curve_id);
+
+        ret = esp_wolfssl_ecc_hw_mul(t->curve_id, t->k, c->gx, c->gy, x, y,
+                                     1);
+        if (ret != 0) {
+            return ret;
+        }
+        if (XMEMCMP(x, t->x, c->sz) != 0 || XMEMCMP(y, t->y, c->sz) != 0) {
+            return WC_HW_E;
+        }
+
+        ret = esp_wolfssl_ecc_hw_check_point(t->curve_id, t->x, t->y);
+        if (ret != 0) {
+            return ret;
+        }
+        XMEMCPY(y, t->y, c->sz);
+        y[c->sz - 1] ^= 1;
+        if (esp_wolfssl_ecc_hw_check_point(t->curve_id, t->x, y)
+                != IS_POINT_E) {
+            return WC_HW_E;
+        }
+
+        ret = esp_wolfssl_ecc_hw_verify_rs(t->curve_id, eh_kat_hash,
+                                           sizeof(eh_kat_hash), t->r, t->s,
+                                           t->qx, t->qy, &res);
+        if (ret != 0) {
+            return ret;
+        }
+        if (res != 1) {
+            return WC_HW_E;
+        }
+        XMEMCPY(s, t->s, c->sz);
+        s[c->sz - 1] ^= 1;
+        ret = esp_wolfssl_ecc_hw_verify_rs(t->curve_id, eh_kat_hash,
+                                           sizeof(eh_kat_hash), t->r, s,
+                                           t->qx, t->qy, &res);
+        if (ret != 0) {
+            return ret;
+        }
+        if (res != 0) {
+            return WC_HW_E;
+        }
+    }
+    return 0;
+}
+
+/*
+ * wolfCrypt entry points
+ */
+
+int __real_wc_ecc_make_key_ex(WC_RNG* rng, int keysize, ecc_key* key,
+                              int curve_id);
+#ifdef HAVE_ECC_DHE
+int __real_wc_ecc_shared_secret(ecc_key* private_key, ecc_key* public_key,
+                                byte* out, word32* outlen);
+#endif
+#ifdef HAVE_ECC_VERIFY
+int __real_wc_ecc_verify_hash(const byte* sig, word32 siglen,
+                              const byte* hash, word32 hashlen, int* res,
+                              ecc_key* key);
+#endif
+
+/* a key this driver may take over: software, on a supported curve */
+static const eh_curve* eh_key_curve(const ecc_key* key)
+{
+    if (key == NULL || key->dp == NULL || key->idx < 0) {
+        return NULL;
+    }
+#ifdef WOLF_CRYPTO_CB
+    if (key->devId != INVALID_DEVID) {
+        return NULL;
+    }
+#endif
+    return eh_find_curve(key->dp->id);
+}
+
+int esp_wolfssl_ecc_hw_make_key(WC_RNG* rng, int keysize, ecc_key* key,
+                                int curve_id)
+{
+    const eh_curve* c = NULL;
+    byte d[EH_MAX_SZ];
+    byte qx[EH_MAX_SZ];
+    byte qy[EH_MAX_SZ];
+    eh_bn bd;
+    eh_bn n;
+    eh_bn t;
+    int id = curve_id;
+    int tries;
+    int ret;
+
+    if (id == ECC_CURVE_DEF) {
+        id = (keysize == 32) ? ECC_SECP256R1
+           : (keysize == 24) ? ECC_SECP192R1 : ECC_CURVE_INVALID;
+    }
+    if (ESP_WOLFSSL_ECC_HW_SECRET
+            && __atomic_load_n(&eh_enabled, __ATOMIC_RELAXED)
+            && rng != NULL && key != NULL) {
+        c = eh_find_curve(id);
+    }
+#ifdef WOLF_CRYPTO_CB
+    if (c != NULL && key->devId != INVALID_DEVID) {
+        c = NULL;
+    }
+#endif
+    if (c == NULL) {
+        EH_COUNT(fallbacks);
+        return __real_wc_ecc_make_key_ex(rng, keysize, key, curve_id);
+    }
+
+    /* d uniform in [1, n - 1] by rejection */
+    eh_bn_from_be(&n, c->n, c->sz);
+    ret = BAD_STATE_E;
+    for (tries = 0; tries < 8; tries++) {
+        ret = wc_RNG_GenerateBlock(rng, d, c->sz);
+        if (ret != 0) {
+            break;
+        }
+        eh_bn_from_be(&bd, d, c->sz);
+        /* borrow of d - n: d below n */
+        if ((eh_bn_sub(&t, &bd, &n) & !eh_bn_is_zero(&bd)) != 0) {
+            break;
+        }
+        ret = BAD_STATE_E;
+    }
+    eh_zero(&bd, sizeof(bd));
+    eh_zero(&t, sizeof(t));
+
+    if (ret == 0) {
+        ret = esp_wolfssl_ecc_hw_mul(c->id, d, c->gx, c->gy, qx, qy, 0);
+    }
+    if (ret == 0) {
+        ret = wc_ecc_import_unsigned(key, qx, qy, d, c->id);
+    }
+    eh_zero(d, sizeof(d));
+    if (ret == ECC_CURVE_OID_E || ret == NOT_COMPILED_IN) {
+        /* curve left out of this wolfCrypt build */
+        EH_COUNT(fallbacks);
+        return __real_wc_ecc_make_key_ex(rng, keysize, key, curve_id);
+    }
+    return ret;
+}
+
+#ifdef HAVE_ECC_DHE
+int esp_wolfssl_ecc_hw_shared_secret(ecc_key* private_key,
+                                     ecc_key* public_key, byte* out,
+                                     word32* outlen)
+{
+    const eh_curve* c = NULL;
+    byte d[EH_MAX_SZ];
+    byte qx[EH_MAX_SZ];
+    byte qy[EH_MAX_SZ];
+    byte ry[EH_MAX_SZ];
+    word32 dlen = sizeof(d);
+    word32 qxlen = sizeof(qx);
+    word32 qylen = sizeof(qy);
+    int ret;
+
+    if (ESP_WOLFSSL_ECC_HW_SECRET
+            && __atomic_load_n(&eh_enabled, __ATOMIC_RELAXED)
+            && out != NULL && outlen != NULL
+            && (c = eh_key_curve(private_key)) != NULL
+            && eh_key_curve(public_key) == c
+            && (private_key->type == ECC_PRIVATEKEY
+                || private_key->type == ECC_PRIVATEKEY_ONLY)
+            && wc_ecc_export_private_only(private_key, d, &dlen) == 0
+            && dlen == c->sz
+            && wc_ecc_export_public_raw(public_key, qx, &qxlen, qy,
+                                        &qylen) == 0
+            && qxlen == c->sz && qylen == c->sz) {
+        if (*outlen < c->sz) {
+            ret = BUFFER_E;
+        }
+        else {
+            /* the peer's point is checked in the same operation */
+            ret = esp_wolfssl_ecc_hw_mul(c->id, d, qx, qy, out, ry, 1);
+            if (ret == 0) {
+                *outlen = c->sz;
+            }
+        }
+        eh_zero(d, sizeof(d));
+        eh_zero(ry, sizeof(ry));
+        return ret;
+    }
+    eh_zero(d, sizeof(d));
+
+    EH_COUNT(fallbacks);
+    return __real_wc_ecc_shared_secret(private_key, public_key, out, outlen);
+}
+#endif /* HAVE_ECC_DHE */
+
+#ifdef HAVE_ECC_VERIFY
+int esp_wolfssl_ecc_hw_verify_hash(const byte* sig, word32 siglen,
+                                   const byte* hash, word32 hashlen,
+                                   int* res, ecc_key* key)
+{
+    const eh_curve* c = NULL;
+    byte r[MAX_ECC_BYTES];
+    byte s[MAX_ECC_BYTES];
+    byte pr[EH_MAX_SZ];
+    byte ps[EH_MAX_SZ];
+    byte qx[EH_MAX_SZ];
+    byte qy[EH_MAX_SZ];
+    word32 rlen = sizeof(r);
+    word32 slen = sizeof(s);
+    word32 qxlen = sizeof(qx);
+    word32 qylen = sizeof(qy);
+    int ret;
+
+    if (__atomic_load_n(&eh_enabled, __ATOMIC_RELAXED)
+            && sig != NULL && hash != NULL && res != NULL
+            && (c = eh_key_curve(key)) != NULL
+            && wc_ecc_sig_to_rs(sig, siglen, r, &rlen, s, &slen) == 0
+            && rlen <= c->sz && slen <= c->sz
+            && wc_ecc_export_public_raw(key, qx, &qxlen, qy, &qylen) == 0
+            && qxlen == c->sz && qylen == c->sz) {
+        XMEMSET(pr, 0, c->sz - rlen);
+        XMEMCPY(pr + c->sz - rlen, r, rlen);
+        XMEMSET(ps, 0, c->sz - slen);
+        XMEMCPY(ps + c->sz - slen, s, slen);
+        ret = esp_wolfssl_ecc_hw_verify_rs(c->id, hash, hashlen, pr, ps, qx,
+                                           qy, res);
+        if (ret != NOT_COMPILED_IN) {
+            return ret;
+        }
+    }
+
+    EH_COUNT(fallbacks);
+    return __real_wc_ecc_verify_hash(sig, siglen, hash, hashlen, res, key);
+}
+#endif /* HAVE_ECC_VERIFY */
+
+#if EH_WRAP
+#ifndef WOLFSSL_ESP_KEYPOOL
+/* the key pool wraps this one and generates its keys here */
+int __wrap_wc_ecc_make_key_ex(WC_RNG* rng, int keysize, ecc_key* key,
+                              int curve_id);
+int __wrap_wc_ecc_make_key_ex(WC_RNG* rng, int keysize, ecc_key* key,
+                              int curve_id)
+{
+    return esp_wolfssl_ecc_hw_make_key(rng, keysize, key, curve_id);
+}
+#endif
+
+#ifdef HAVE_ECC_DHE
+int __wrap_wc_ecc_shared_secret(ecc_key* private_key, ecc_key* public_key,
+                                byte* out, word32* outlen);
+int __wrap_wc_ecc_shared_secret(ecc_key* private_key, ecc_key* public_key,
+                                byte* out, word32* outlen)
+{
+    return esp_wolfssl_ecc_hw_shared_secret(private_key, public_key, out,
+                                            outlen);
+}
+#endif
+
+#ifdef HAVE_ECC_VERIFY
+int __wrap_wc_ecc_verify_hash(const byte* sig, word32 siglen,
+                              const byte* hash, word32 hashlen, int* res,
+                              ecc_key* key);
+int __wrap_wc_ecc_verify_hash(const byte* sig, word32 siglen,
+                              const byte* hash, word32 hashlen, int* res,
+                              ecc_key* key)
+{
+    return esp_wolfssl_ecc_hw_verify_hash(sig, siglen, hash, hashlen, res,
+                                          key);
+}
+#endif
+#endif /* EH_WRAP */
+
+void esp_wolfssl_ecc_hw_set_enabled(int enabled)
+{
+    __atomic_store_n(&eh_enabled, enabled ? 1 : 0, __ATOMIC_RELAXED);
+}
+
+void esp_wolfssl_ecc_hw_get_stats(esp_wolfssl_ecc_hw_stats_t* stats)
+{
+    if (stats == NULL) {
+        return;
+    }
+    stats->point_muls =
+        __atomic_load_n(&eh_stats.point_muls, __ATOMIC_RELAXED);
+    stats->point_checks =
+        __atomic_load_n(&eh_stats.point_checks, __ATOMIC_RELAXED);
+    stats->verifies = __atomic_load_n(&eh_stats.verifies, __ATOMIC_RELAXED);
+    stats->fallbacks =
+        __atomic_load_n(&eh_stats.fallbacks, __ATOMIC_RELAXED);
+}
+
+void esp_wolfssl_ecc_hw_reset_stats(void)
+{
+    __atomic_store_n(&eh_stats.point_muls, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&eh_stats.point_checks, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&eh_stats.verifies, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&eh_stats.fallbacks, 0, __ATOMIC_RELAXED);
+}
+
+#endif /* WOLFSSL_ESP_ECC_HW && HAVE_ECC */
@@ -0,0 +1,125 @@
+/* esp_wolfssl_ecc_hw.h
+ *
+ * Copyright (C) 2006-2024 wolfSSL Inc.
+ *
+ * This file is part of wolfSSL.
+ *
+ * wolfSSL is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfSSL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335, USA
+ */
+
+/* ECC point-multiplication peripheral of the ESP32-C2, C6 and H2.
+ *
+ * Enabled with Kconfig WOLFSSL_ECC_HW, on chips with SOC_ECC_SUPPORTED.
+ * The peripheral multiplies a point of P-192 or P-256 by a scalar, and
+ * checks that a point is on the curve. wc_ecc_verify_hash(),
+ * wc_ecc_shared_secret() and wc_ecc_make_key_ex(), which are linker
+ * wrapped, use it for these two curves:
+ *
+ *   - ECDSA verification computes u1 * G and u2 * Q on the peripheral
+ *     and adds the two points in software. Only public values are
+ *     involved.
+ *   - ECDH checks the peer's point and multiplies it by the private key
+ *     in one operation, and key generation multiplies G by a random
+ *     scalar. Both handle a private scalar, so they use the peripheral
+ *     only with ESP_WOLFSSL_ECC_HW_SECRET, by default on chips whose
+ *     peripheral has a constant-time point multiplication
+ *     (SOC_ECC_CONSTANT_TIME_POINT_MUL), which is then switched on.
+ *
+ * Everything else, such as signing, other curves, degenerate inputs and
+ * keys on a crypto callback device, goes to the constant-time software
+ * of ecc.c as before. With tracing or the key pool enabled, their
+ * wrappers of the same functions call the ones below.
+ *
+ * Off the device, for a Linux host build, a model of the peripheral's
+ * registers takes the place of the ESP-IDF HAL, so that the driver and
+ * esp_wolfssl_ecc_hw_self_test() run on the host.
+ */
+
+#ifndef _ESP_WOLFSSL_ECC_HW_H_
+#define _ESP_WOLFSSL_ECC_HW_H_
+
+#include <stdint.h>
+
+#include <wolfssl/wolfcrypt/settings.h>
+#include <wolfssl/wolfcrypt/types.h>
+#include <wolfssl/wolfcrypt/random.h>
+#ifdef HAVE_ECC
+    #include <wolfssl/wolfcrypt/ecc.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* private scalars on the peripheral: key generation and ECDH */
+#ifndef ESP_WOLFSSL_ECC_HW_SECRET
+    #define ESP_WOLFSSL_ECC_HW_SECRET 0
+#endif
+
+typedef struct esp_wolfssl_ecc_hw_stats_t {
+    uint32_t point_muls;    /* on the peripheral */
+    uint32_t point_checks;  /* on the peripheral, without multiplying */
+    uint32_t verifies;      /* ECDSA verifications on the peripheral */
+    uint32_t fallbacks;     /* wrapped calls left to software */
+} esp_wolfssl_ecc_hw_stats_t;
+
+#if defined(WOLFSSL_ESP_ECC_HW) && defined(HAVE_ECC)
+
+/* Big-endian, ECC_SECP192R1 or ECC_SECP256R1, coordinates and scalars
+ * of the curve size. Multiplies (px, py) by k into (rx, ry); with check,
+ * fails with IS_POINT_E unless (px, py) is on the curve. Returns 0 or an
+ * error. */
+int esp_wolfssl_ecc_hw_mul(int curve_id, const byte* k, const byte* px,
+                           const byte* py, byte* rx, byte* ry, int check);
+
+/* Returns 0 if (px, py) is on the curve, IS_POINT_E if not, or an error. */
+int esp_wolfssl_ecc_hw_check_point(int curve_id, const byte* px,
+                                   const byte* py);
+
+/* ECDSA verification of (r, s) over hash for the public key (qx, qy);
+ * *res is 1 if valid. Returns 0, NOT_COMPILED_IN for inputs left to
+ * software (r or s out of range, a degenerate sum), or an error. */
+int esp_wolfssl_ecc_hw_verify_rs(int curve_id, const byte* hash,
+                                 word32 hashlen, const byte* r,
+                                 const byte* s, const byte* qx,
+                                 const byte* qy, int* res);
+
+/* Known-answer tests of the peripheral, or the model, for both curves.
+ * Returns 0 or an error. */
+int esp_wolfssl_ecc_hw_self_test(void);
+
+/* Drop-in versions of the wolfCrypt functions, falling back to them. */
+int esp_wolfssl_ecc_hw_make_key(WC_RNG* rng, int keysize, ecc_key* key,
+                                int curve_id);
+int esp_wolfssl_ecc_hw_shared_secret(ecc_key* private_key,
+                                     ecc_key* public_key, byte* out,
+                                     word32* outlen);
+int esp_wolfssl_ecc_hw_verify_hash(const byte* sig, word32 siglen,
+                                   const byte* hash, word32 hashlen,
+                                   int* res, ecc_key* key);
+
+/* 0 leaves everything to software, for comparison; on by default */
+void esp_wolfssl_ecc_hw_set_enabled(int enabled);
+
+void esp_wolfssl_ecc_hw_get_stats(esp_wolfssl_ecc_hw_stats_t* stats);
+void esp_wolfssl_ecc_hw_reset_stats(void);
+
+#endif /* WOLFSSL_ESP_ECC_HW && HAVE_ECC */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _ESP_WOLFSSL_ECC_HW_H_ */
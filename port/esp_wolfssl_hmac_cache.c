@@ -0,0 +1,516 @@
+/* esp_wolfssl_hmac_cache.c
+ *
+ * Copyright (C) 2006-2024 wolfSSL Inc.
+ *
+ * This file is part of wolfSSL.
+ *
+ * wolfSSL is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfSSL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335, USA
+ */
+
+#include <wolfssl/wolfcrypt/settings.h>
+
+#ifdef WOLFSSL_ESP_HMAC_CACHE
+
+#include <stdint.h>
+#include <string.h>
+
+#include <wolfssl/wolfcrypt/types.h>
+#include <wolfssl/wolfcrypt/hmac.h>
+#include <wolfssl/wolfcrypt/error-crypt.h>
+#include <wolfssl/wolfcrypt/wc_port.h>
+#ifndef WOLFCRYPT_ONLY
+    /* the record MAC keys of a connection */
+    #include <wolfssl/ssl.h>
+    #include <wolfssl/internal.h>
+#endif
+
+#include "esp_wolfssl_hmac_cache.h"
+
+#ifdef WC_HMAC_INNER_HASH_KEYED_SW
+    #define HM_KEYED        WC_HMAC_INNER_HASH_KEYED_SW
+#else
+    #define HM_KEYED        1
+#endif
+
+#define HM_IPAD             0x36
+/* ipad XOR opad, per byte */
+#define HM_PAD_DIFF         (HM_IPAD ^ 0x5c)
+
+/* TLS_hmac() in tls.c starts a record MAC with the sequence number and
+ * record header; the other HMACs of the handshake start otherwise, and
+ * their keys stay out of the cache */
+#ifdef WOLFSSL_TLS_HMAC_INNER_SZ
+    #define HM_RECORD_HEADER_SZ WOLFSSL_TLS_HMAC_INNER_SZ
+#else
+    #define HM_RECORD_HEADER_SZ 13
+#endif
+
+typedef struct hm_entry {
+    int         type;       /* 0 while unused */
+    uint32_t    stamp;
+    byte        ipad[WC_HMAC_BLOCK_SIZE];
+    wc_HmacHash inner;      /* after the ipad block */
+    wc_HmacHash outer;      /* after the opad block */
+} hm_entry;
+
+static hm_entry hm_entries[ESP_WOLFSSL_HMAC_CACHE_KEYS];
+static uint32_t hm_clock;
+static int hm_enabled = 1;
+static esp_wolfssl_hmac_cache_stats_t hm_stats;
+/* entries, hm_clock and statistics; copying a state may read the SHA
+ * accelerator */
+static wolfSSL_Mutex hm_mutex;
+static int hm_mutex_ok;
+
+int __real_wc_HmacUpdate(Hmac* hmac, const byte* msg, word32 length);
+int __real_wc_HmacFinal(Hmac* hmac, byte* out);
+int __wrap_wc_HmacUpdate(Hmac* hmac, const byte* msg, word32 length);
+int __wrap_wc_HmacFinal(Hmac* hmac, byte* out);
+#if !defined(WOLFCRYPT_ONLY) && !defined(WOLFSSL_ESP_MEM_AUTO)
+void __real_wolfSSL_free(WOLFSSL* ssl);
+void __wrap_wolfSSL_free(WOLFSSL* ssl);
+#endif
+
+/* before any handshake, and before the scheduler starts on the device */
+static void __attribute__((constructor)) hm_init(void)
+{
+    hm_mutex_ok = (wc_InitMutex(&hm_mutex) == 0);
+}
+
+static int hm_lock(void)
+{
+    return hm_mutex_ok && wc_LockMutex(&hm_mutex) == 0;
+}
+
+static void hm_unlock(void)
+{
+    wc_UnLockMutex(&hm_mutex);
+}
+
+static void hm_zero(void* p, size_t sz)
+{
+    volatile byte* b = (volatile byte*)p;
+
+    while (sz-- > 0) {
+        *b++ = 0;
+    }
+}
+
+/* block size of the hashes the cache takes, otherwise 0 */
+static word32 hm_block_sz(int type)
+{
+    switch (type) {
+#ifndef NO_SHA
+        case WC_SHA:
+            return WC_SHA_BLOCK_SIZE;
+#endif
+#ifndef NO_SHA256
+        case WC_SHA256:
+            return WC_SHA256_BLOCK_SIZE;
+#endif
+#ifdef WOLFSSL_SHA384
+        case WC_SHA384:
+            return WC_SHA384_BLOCK_SIZE;
+#endif
+        default:
+            return 0;
+    }
+}
+
+static int hm_hash_init(int type, wc_HmacHash* h, void* heap)
+{
+    switch (type) {
+#ifndef NO_SHA
+        case WC_SHA:
+            return wc_InitSha_ex(&h->sha, heap, INVALID_DEVID);
+#endif
+#ifndef NO_SHA256
+        case WC_SHA256:
+            return wc_InitSha256_ex(&h->sha256, heap, INVALID_DEVID);
+#endif
+#ifdef WOLFSSL_SHA384
+        case WC_SHA384:
+            return wc_InitSha384_ex(&h->sha384, heap, INVALID_DEVID);
+#endif
+        default:
+            return BAD_FUNC_ARG;
+    }
+}
+
+static int hm_hash_update(int type, wc_HmacHash* h, const byte* data,
+                          word32 sz)
+{
+    switch (type) {
+#ifndef NO_SHA
+        case WC_SHA:
+            return wc_ShaUpdate(&h->sha, data, sz);
+#endif
+#ifndef NO_SHA256
+        case WC_SHA256:
+            return wc_Sha256Update(&h->sha256, data, sz);
+#endif
+#ifdef WOLFSSL_SHA384
+        case WC_SHA384:
+            return wc_Sha384Update(&h->sha384, data, sz);
+#endif
+        default:
+            return BAD_FUNC_ARG;
+    }
+}
+
+static int hm_hash_final(int type, wc_HmacHash* h, byte* out)
+{
+    switch (type) {
+#ifndef NO_SHA
+        case WC_SHA:
+            return wc_ShaFinal(&h->sha, out);
+#endif
+#ifndef NO_SHA256
+        case WC_SHA256:
+            return wc_Sha256Final(&h->sha256, out);
+#endif
+#ifdef WOLFSSL_SHA384
+        case WC_SHA384:
+            return wc_Sha384Final(&h->sha384, out);
+#endif
+        default:
+            return BAD_FUNC_ARG;
+    }
+}
+
+/* dst must not hold a state; see hm_hash_free() */
+static int hm_hash_copy(int type, wc_HmacHash* src, wc_HmacHash* dst)
+{
+    switch (type) {
+#ifndef NO_SHA
+        case WC_SHA:
+            return wc_ShaCopy(&src->sha, &dst->sha);
+#endif
+#ifndef NO_SHA256
+        case WC_SHA256:
+            return wc_Sha256Copy(&src->sha256, &dst->sha256);
+#endif
+#ifdef WOLFSSL_SHA384
+        case WC_SHA384:
+            return wc_Sha384Copy(&src->sha384, &dst->sha384);
+#endif
+        default:
+            return BAD_FUNC_ARG;
+    }
+}
+
+static void hm_hash_free(int type, wc_HmacHash* h)
+{
+    switch (type) {
+#ifndef NO_SHA
+        case WC_SHA:
+            wc_ShaFree(&h->sha);
+            break;
+#endif
+#ifndef NO_SHA256
+        case WC_SHA256:
+            wc_Sha256Free(&h->sha256);
+            break;
+#endif
+#ifdef WOLFSSL_SHA384
+        case WC_SHA384:
+            wc_Sha384Free(&h->sha384);
+            break;
+#endif
+        default:
+            break;
+    }
+}
+
+/* an HMAC the cache can take over: a hash it knows, in software or on the
+ * ESP accelerators, not on a crypto callback device */
+static int hm_usable(const Hmac* hmac)
+{
+    if (!__atomic_load_n(&hm_enabled, __ATOMIC_RELAXED)
+            || hm_block_sz(hmac->macType) == 0) {
+        return 0;
+    }
+#ifdef WOLF_CRYPTO_CB
+    if (hmac->devId != INVALID_DEVID) {
+        return 0;
+    }
+#endif
+    return 1;
+}
+
+/* pad is the ipad, or the opad with diff HM_PAD_DIFF. Compares in
+ * constant time, the pads being key material */
+static int hm_match(const hm_entry* e, const byte* pad, byte diff)
+{
+    word32 sz = hm_block_sz(e->type);
+    byte acc = 0;
+    word32 j;
+
+    for (j = 0; j < sz; j++) {
+        acc |= (byte)(e->ipad[j] ^ pad[j] ^ diff);
+    }
+    return acc == 0;
+}
+
+/* with the mutex held */
+static hm_entry* hm_find(int type, const byte* pad, byte diff)
+{
+    hm_entry* found = NULL;
+    int i;
+
+    for (i = 0; i < ESP_WOLFSSL_HMAC_CACHE_KEYS; i++) {
+        if (hm_entries[i].type == type && hm_match(&hm_entries[i], pad,
+                                                   diff)) {
+            found = &hm_entries[i];
+        }
+    }
+    if (found != NULL) {
+        found->stamp = ++hm_clock;
+    }
+    return found;
+}
+
+/* with the mutex held */
+static void hm_wipe(hm_entry* e)
+{
+    if (e->type != 0) {
+        hm_hash_free(e->type, &e->inner);
+        hm_hash_free(e->type, &e->outer);
+    }
+    hm_zero(e, sizeof(*e));
+}
+
+/* with the mutex held; an unused or the least recently used entry */
+static hm_entry* hm_victim(void)
+{
+    hm_entry* e = &hm_entries[0];
+    int i;
+
+    for (i = 0; i < ESP_WOLFSSL_HMAC_CACHE_KEYS; i++) {
+        if (hm_entries[i].type == 0) {
+            return &hm_entries[i];
+        }
+        if (hm_entries[i].stamp < e->stamp) {
+            e = &hm_entries[i];
+        }
+    }
+    hm_stats.evictions++;
+    return e;
+}
+
+/* Hashes the ipad block into hmac->hash as wolfSSL would on the first
+ * update, and caches the state together with the one after the opad. */
+static int hm_add(Hmac* hmac)
+{
+    int type = hmac->macType;
+    word32 sz = hm_block_sz(type);
+    wc_HmacHash outer;
+    hm_entry* e;
+    int ret;
+
+    ret = hm_hash_update(type, &hmac->hash, (const byte*)hmac->ipad, sz);
+    if (ret != 0) {
+        return ret;
+    }
+    hmac->innerHashKeyed = HM_KEYED;
+
+    /* the cache must stay usable without the accelerator, so the outer
+     * state is hashed here and copied in, as the inner one */
+    if (hm_hash_init(type, &outer, hmac->heap) != 0) {
+        return 0;
+    }
+    if (hm_hash_update(type, &outer, (const byte*)hmac->opad, sz) == 0
+            && hm_lock()) {
+        /* another task may have added the key meanwhile */
+        if (hm_find(type, (const byte*)hmac->ipad, 0) == NULL) {
+            e = hm_victim();
+            hm_wipe(e);
+            if (hm_hash_copy(type, &hmac->hash, &e->inner) == 0) {
+                if (hm_hash_copy(type, &outer, &e->outer) == 0) {
+                    XMEMCPY(e->ipad, hmac->ipad, sz);
+                    e->type = type;
+                    e->stamp = ++hm_clock;
+                    hm_stats.misses++;
+                }
+                else {
+                    hm_hash_free(type, &e->inner);
+                    hm_zero(e, sizeof(*e));
+                }
+            }
+        }
+        hm_unlock();
+    }
+    hm_hash_free(type, &outer);
+    hm_zero(&outer, sizeof(outer));
+    return 0;
+}
+
+int __wrap_wc_HmacUpdate(Hmac* hmac, const byte* msg, word32 length)
+{
+    hm_entry* e;
+    int ret;
+
+    if (hmac != NULL && !hmac->innerHashKeyed
+            && length == HM_RECORD_HEADER_SZ && hm_usable(hmac)
+            && hm_lock()) {
+        e = hm_find(hmac->macType, (const byte*)hmac->ipad, 0);
+        if (e != NULL) {
+            hm_hash_free(hmac->macType, &hmac->hash);
+            if (hm_hash_copy(hmac->macType, &e->inner, &hmac->hash) == 0) {
+                hmac->innerHashKeyed = HM_KEYED;
+                hm_stats.inner_hits++;
+            }
+            else {
+                /* wolfSSL keys it as usual */
+                hm_hash_init(hmac->macType, &hmac->hash, hmac->heap);
+            }
+        }
+        hm_unlock();
+        if (e == NULL) {
+            ret = hm_add(hmac);
+            if (ret != 0) {
+                return ret;
+            }
+        }
+    }
+    return __real_wc_HmacUpdate(hmac, msg, length);
+}
+
+int __wrap_wc_HmacFinal(Hmac* hmac, byte* out)
+{
+    wc_HmacHash outer;
+    hm_entry* e = NULL;
+    int type;
+    int ret;
+
+    if (hmac == NULL || out == NULL || !hmac->innerHashKeyed
+            || !hm_usable(hmac)) {
+        return __real_wc_HmacFinal(hmac, out);
+    }
+    type = hmac->macType;
+    if (hm_lock()) {
+        e = hm_find(type, (const byte*)hmac->opad, HM_PAD_DIFF);
+        if (e != NULL && hm_hash_copy(type, &e->outer, &outer) == 0) {
+            hm_stats.outer_hits++;
+        }
+        else {
+            e = NULL;
+        }
+        hm_unlock();
+    }
+    if (e == NULL) {
+        return __real_wc_HmacFinal(hmac, out);
+    }
+
+    ret = hm_hash_final(type, &hmac->hash, (byte*)hmac->innerHash);
+    if (ret == 0) {
+        ret = hm_hash_update(type, &outer, (const byte*)hmac->innerHash,
+                             (word32)wc_HmacSizeByType(type));
+    }
+    if (ret == 0) {
+        ret = hm_hash_final(type, &outer, out);
+    }
+    hm_hash_free(type, &outer);
+    hm_zero(&outer, sizeof(outer));
+    hmac->innerHashKeyed = 0;
+    return ret;
+}
+
+#ifndef WOLFCRYPT_ONLY
+/* with the mutex held: wipes the entries of key, whichever their hash */
+static void hm_forget(const byte* key, word32 key_sz)
+{
+    byte pad[WC_HMAC_BLOCK_SIZE];
+    word32 sz;
+    word32 j;
+    int i;
+
+    for (i = 0; i < ESP_WOLFSSL_HMAC_CACHE_KEYS; i++) {
+        sz = hm_block_sz(hm_entries[i].type);
+        if (sz == 0 || key_sz > sz) {
+            continue;
+        }
+        for (j = 0; j < sz; j++) {
+            pad[j] = (byte)(((j < key_sz) ? key[j] : 0) ^ HM_IPAD);
+        }
+        if (hm_match(&hm_entries[i], pad, 0)) {
+            hm_wipe(&hm_entries[i]);
+        }
+    }
+    hm_zero(pad, sizeof(pad));
+}
+
+void esp_wolfssl_hmac_cache_ssl_free(WOLFSSL* ssl)
+{
+#ifndef WOLFSSL_AEAD_ONLY
+    if (ssl == NULL || ssl->specs.hash_size == 0 || !hm_lock()) {
+        return;
+    }
+    hm_forget(ssl->keys.client_write_MAC_secret, ssl->specs.hash_size);
+    hm_forget(ssl->keys.server_write_MAC_secret, ssl->specs.hash_size);
+    hm_unlock();
+#else
+    (void)ssl;
+#endif
+}
+
+/* with accounting domains on, its wrapper of the same function calls the
+ * one above */
+#ifndef WOLFSSL_ESP_MEM_AUTO
+void __wrap_wolfSSL_free(WOLFSSL* ssl)
+{
+    esp_wolfssl_hmac_cache_ssl_free(ssl);
+    __real_wolfSSL_free(ssl);
+}
+#endif
+#endif /* !WOLFCRYPT_ONLY */
+
+void esp_wolfssl_hmac_cache_set_enabled(int enabled)
+{
+    __atomic_store_n(&hm_enabled, enabled ? 1 : 0, __ATOMIC_RELAXED);
+}
+
+void esp_wolfssl_hmac_cache_clear(void)
+{
+    int i;
+
+    if (!hm_lock()) {
+        return;
+    }
+    for (i = 0; i < ESP_WOLFSSL_HMAC_CACHE_KEYS; i++) {
+        hm_wipe(&hm_entries[i]);
+    }
+    hm_unlock();
+}
+
+void esp_wolfssl_hmac_cache_get_stats(esp_wolfssl_hmac_cache_stats_t* stats)
+{
+    if (stats == NULL || !hm_lock()) {
+        return;
+    }
+    *stats = hm_stats;
+    hm_unlock();
+}
+
+void esp_wolfssl_hmac_cache_reset_stats(void)
+{
+    if (!hm_lock()) {
+        return;
+    }
+    XMEMSET(&hm_stats, 0, sizeof(hm_stats));
+    hm_unlock();
+}
+
+#endif /* WOLFSSL_ESP_HMAC_CACHE */
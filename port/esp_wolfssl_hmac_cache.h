@@ -0,0 +1,95 @@
+/* esp_wolfssl_hmac_cache.h
+ *
+ * Copyright (C) 2006-2024 wolfSSL Inc.
+ *
+ * This file is part of wolfSSL.
+ *
+ * wolfSSL is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfSSL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335, USA
+ */
+
+/* Cache of keyed HMAC hash states.
+ *
+ * Enabled with Kconfig WOLFSSL_HMAC_CACHE. An HMAC hashes one block of the
+ * key XOR ipad before the message, and one block of the key XOR opad
+ * before the inner digest: two compression-function calls that depend
+ * only on the key. TLS 1.2 sets the MAC key again for every record of a
+ * CBC suite, with one key per direction and connection. The cache keeps,
+ * per key, the hash states after the ipad and after the opad block, for
+ * the last ESP_WOLFSSL_HMAC_CACHE_KEYS record MAC keys of SHA-1, SHA-256
+ * and SHA-384.
+ *
+ * wc_HmacUpdate() and wc_HmacFinal() are linker wrapped: the first update
+ * after wc_HmacSetKey() starts from the cached inner state, and the final
+ * step from the cached outer state, each saving one compression. Only an
+ * HMAC whose first update is the 13 byte sequence number and header of a
+ * record MAC is cached; other keys, such as the PRF's master secret or the
+ * TLS 1.3 secrets, never enter it. The TLS 1.3 key schedule and its
+ * transcript hashes are not sped up: this cache covers TLS 1.2 record MACs
+ * only.
+ * States are copied with wc_ShaCopy() and its SHA-256 and SHA-384
+ * counterparts, so they work with the hardware SHA paths, where the copy
+ * of a state held by the accelerator continues in software.
+ *
+ * The cached states are equivalent to the keys. They are wiped when
+ * replaced, by esp_wolfssl_hmac_cache_clear(), and when wolfSSL_free(),
+ * also linker wrapped, frees the connection the keys belong to.
+ */
+
+#ifndef _ESP_WOLFSSL_HMAC_CACHE_H_
+#define _ESP_WOLFSSL_HMAC_CACHE_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* keys kept, least recently used replaced first */
+#ifndef ESP_WOLFSSL_HMAC_CACHE_KEYS
+    #define ESP_WOLFSSL_HMAC_CACHE_KEYS 6
+#endif
+
+typedef struct esp_wolfssl_hmac_cache_stats_t {
+    uint32_t inner_hits;    /* ipad blocks not hashed */
+    uint32_t outer_hits;    /* opad blocks not hashed */
+    uint32_t misses;        /* keys added */
+    uint32_t evictions;     /* keys replaced by another */
+} esp_wolfssl_hmac_cache_stats_t;
+
+#ifdef WOLFSSL_ESP_HMAC_CACHE
+
+/* 0 hashes the pad blocks every time, for comparison; on by default */
+void esp_wolfssl_hmac_cache_set_enabled(int enabled);
+
+/* Wipes all cached states. */
+void esp_wolfssl_hmac_cache_clear(void);
+
+#ifndef WOLFCRYPT_ONLY
+struct WOLFSSL;
+/* Wipes the states of the record MAC keys of ssl; called from the
+ * wolfSSL_free() wrapper. */
+void esp_wolfssl_hmac_cache_ssl_free(struct WOLFSSL* ssl);
+#endif
+
+void esp_wolfssl_hmac_cache_get_stats(esp_wolfssl_hmac_cache_stats_t* stats);
+void esp_wolfssl_hmac_cache_reset_stats(void);
+
+#endif /* WOLFSSL_ESP_HMAC_CACHE */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _ESP_WOLFSSL_HMAC_CACHE_H_ */
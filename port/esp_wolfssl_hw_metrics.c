@@ -0,0 +1,435 @@
+/* esp_wolfssl_hw_metrics.c
+ *
+ * Copyright (C) 2006-2024 wolfSSL Inc.
+ *
+ * This file is part of wolfSSL.
+ *
+ * wolfSSL is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfSSL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335, USA
+ */
+
+#include <wolfssl/wolfcrypt/settings.h>
+
+#ifdef WOLFSSL_ESP_HW_METRICS
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#ifdef WOLFSSL_ESPIDF
+    #include <esp_log.h>
+    #include <esp_timer.h>
+    #include <freertos/FreeRTOS.h>
+    #include <freertos/semphr.h>
+    #include <wolfssl/wolfcrypt/types.h>
+    #include <wolfssl/wolfcrypt/wolfmath.h>
+    #include <wolfssl/wolfcrypt/port/Espressif/esp32-crypt.h>
+#else
+    #define ESP_LOGI(tag, fmt, ...) \
+                printf("I %s: " fmt "\n", tag, ##__VA_ARGS__)
+#endif
+
+#include "esp_wolfssl_hw_metrics.h"
+
+static const char* const TAG = "wolfssl_hw";
+
+static esp_wolfssl_hw_metrics_t hw_metrics;
+
+#define HW_INC(field)        __atomic_add_fetch(&(field), 1, __ATOMIC_RELAXED)
+#define HW_ADD(field, n)     __atomic_add_fetch(&(field), (n), __ATOMIC_RELAXED)
+#define HW_ALG(id)           (hw_metrics.alg[(id)])
+
+/* Keep in sync with esp_wolfssl_hw_alg_id_t */
+static const char* const hw_alg_names[ESP_WOLFSSL_HW_ALG_COUNT] = {
+    "sha",
+    "aes",
+    "mp_mul",
+    "mp_mulmod",
+    "mp_exptmod",
+};
+
+const char* esp_wolfssl_hw_alg_name(esp_wolfssl_hw_alg_id_t id)
+{
+    return ((unsigned)id < ESP_WOLFSSL_HW_ALG_COUNT) ?
+               hw_alg_names[id] : "unknown";
+}
+
+/* Which accelerators the Espressif port compiles in, from the same macros
+ * that guard esp32_sha.c, esp32_aes.c and esp32_mp.c */
+static void hw_metrics_set_enabled(esp_wolfssl_hw_metrics_t* m)
+{
+    (void)m;
+#if defined(WOLFSSL_ESPIDF) && !defined(NO_WOLFSSL_ESP32_CRYPT_HASH)
+    m->alg[ESP_WOLFSSL_HW_SHA].enabled = 1;
+#endif
+#if defined(WOLFSSL_ESPIDF) && !defined(NO_WOLFSSL_ESP32_CRYPT_AES)
+    m->alg[ESP_WOLFSSL_HW_AES].enabled = 1;
+#endif
+#if defined(WOLFSSL_ESP32_CRYPT_RSA_PRI) && \
+   !defined(NO_WOLFSSL_ESP32_CRYPT_RSA_PRI)
+    #ifndef NO_WOLFSSL_ESP32_CRYPT_RSA_PRI_MP_MUL
+    m->alg[ESP_WOLFSSL_HW_MP_MUL].enabled = 1;
+    #endif
+    #ifndef NO_WOLFSSL_ESP32_CRYPT_RSA_PRI_MULMOD
+    m->alg[ESP_WOLFSSL_HW_MP_MULMOD].enabled = 1;
+    #endif
+    #ifndef NO_WOLFSSL_ESP32_CRYPT_RSA_PRI_EXPTMOD
+    m->alg[ESP_WOLFSSL_HW_MP_EXPTMOD].enabled = 1;
+    #endif
+#endif
+}
+
+void esp_wolfssl_hw_metrics_get(esp_wolfssl_hw_metrics_t* out)
+{
+    int i;
+    esp_wolfssl_hw_alg_t* a;
+    esp_wolfssl_hw_lock_t* l = &hw_metrics.lock;
+
+    if (out == NULL) {
+        return;
+    }
+
+    memset(out, 0, sizeof(*out));
+    hw_metrics_set_enabled(out);
+    for (i = 0; i < ESP_WOLFSSL_HW_ALG_COUNT; i++) {
+        a = &hw_metrics.alg[i];
+        out->alg[i].hw            = __atomic_load_n(&a->hw, __ATOMIC_RELAXED);
+        out->alg[i].sw            = __atomic_load_n(&a->sw, __ATOMIC_RELAXED);
+        out->alg[i].fallback_busy =
+                         __atomic_load_n(&a->fallback_busy, __ATOMIC_RELAXED);
+        out->alg[i].fallback_size =
+                         __atomic_load_n(&a->fallback_size, __ATOMIC_RELAXED);
+        out->alg[i].errors    = __atomic_load_n(&a->errors, __ATOMIC_RELAXED);
+        out->alg[i].bytes     = __atomic_load_n(&a->bytes, __ATOMIC_RELAXED);
+    }
+
+    out->lock.acquired      = __atomic_load_n(&l->acquired, __ATOMIC_RELAXED);
+    out->lock.contended     = __atomic_load_n(&l->contended, __ATOMIC_RELAXED);
+    out->lock.failed        = __atomic_load_n(&l->failed, __ATOMIC_RELAXED);
+    out->lock.wait_max_us   = __atomic_load_n(&l->wait_max_us,
+                                              __ATOMIC_RELAXED);
+    out->lock.wait_total_us = __atomic_load_n(&l->wait_total_us,
+                                              __ATOMIC_RELAXED);
+    for (i = 0; i < ESP_WOLFSSL_HW_WAIT_BUCKETS; i++) {
+        out->lock.wait_hist[i] = __atomic_load_n(&l->wait_hist[i],
+                                                 __ATOMIC_RELAXED);
+    }
+}
+
+void esp_wolfssl_hw_metrics_reset(void)
+{
+    /* plain stores: a concurrent update may survive the reset */
+    memset(&hw_metrics, 0, sizeof(hw_metrics));
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+}
+
+void esp_wolfssl_hw_metrics_log(const esp_wolfssl_hw_metrics_t* m)
+{
+    esp_wolfssl_hw_metrics_t now;
+    const esp_wolfssl_hw_lock_t* l;
+    int i;
+
+    if (m == NULL) {
+        esp_wolfssl_hw_metrics_get(&now);
+        m = &now;
+    }
+    l = &m->lock;
+
+    for (i = 0; i < ESP_WOLFSSL_HW_ALG_COUNT; i++) {
+        if (!m->alg[i].enabled) {
+            ESP_LOGI(TAG, "%-10s: no hardware acceleration", hw_alg_names[i]);
+            continue;
+        }
+        ESP_LOGI(TAG, "%-10s: hw %lu, sw %lu (busy %lu, size %lu), "
+                      "errors %lu, hw bytes %llu", hw_alg_names[i],
+                 (unsigned long)m->alg[i].hw, (unsigned long)m->alg[i].sw,
+                 (unsigned long)m->alg[i].fallback_busy,
+                 (unsigned long)m->alg[i].fallback_size,
+                 (unsigned long)m->alg[i].errors,
+                 (unsigned long long)m->alg[i].bytes);
+    }
+    ESP_LOGI(TAG, "hw lock   : acquired %lu, contended %lu, failed %lu, "
+                  "wait total %llu us, max %lu us",
+             (unsigned long)l->acquired, (unsigned long)l->contended,
+             (unsigned long)l->failed, (unsigned long long)l->wait_total_us,
+             (unsigned long)l->wait_max_us);
+    ESP_LOGI(TAG, "hw lock wait <1us %lu, <10us %lu, <100us %lu, <1ms %lu, "
+                  "<10ms %lu, >=10ms %lu",
+             (unsigned long)l->wait_hist[0], (unsigned long)l->wait_hist[1],
+             (unsigned long)l->wait_hist[2], (unsigned long)l->wait_hist[3],
+             (unsigned long)l->wait_hist[4], (unsigned long)l->wait_hist[5]);
+}
+
+#ifdef WOLFSSL_ESPIDF
+
+/* Linker wrappers, see the component CMakeLists.txt. The __real_ symbols
+ * are weak: a port function that does not exist in this wolfSSL release or
+ * configuration has no callers, so its wrapper is never reached. */
+#define HW_REAL __attribute__((weak))
+
+static void hw_lock_record(uint32_t wait_us, int contended, int ok)
+{
+    esp_wolfssl_hw_lock_t* l = &hw_metrics.lock;
+    uint32_t bound = 1;
+    uint32_t old;
+    int b;
+
+    if (contended) {
+        HW_INC(l->contended);
+    }
+    if (!ok) {
+        HW_INC(l->failed);
+        return;
+    }
+
+    HW_INC(l->acquired);
+    HW_ADD(l->wait_total_us, wait_us);
+    for (b = 0; b < ESP_WOLFSSL_HW_WAIT_BUCKETS - 1; b++) {
+        if (wait_us < bound) {
+            break;
+        }
+        bound *= 10;
+    }
+    HW_INC(l->wait_hist[b]);
+
+    old = __atomic_load_n(&l->wait_max_us, __ATOMIC_RELAXED);
+    while (wait_us > old) {
+        if (__atomic_compare_exchange_n(&l->wait_max_us, &old, wait_us, 1,
+                                        __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+            break;
+        }
+    }
+}
+
+HW_REAL int __real_esp_CryptHwMutexLock(wolfSSL_Mutex* mutex,
+                                        TickType_t block_time);
+int __wrap_esp_CryptHwMutexLock(wolfSSL_Mutex* mutex, TickType_t block_time);
+int __wrap_esp_CryptHwMutexLock(wolfSSL_Mutex* mutex, TickType_t block_time)
+{
+    int64_t start;
+    int contended;
+    int ret;
+
+    /* a FreeRTOS mutex reads 0 while held */
+    contended = (mutex != NULL && *mutex != NULL
+                 && uxSemaphoreGetCount(*mutex) == 0);
+    start = esp_timer_get_time();
+    ret = __real_esp_CryptHwMutexLock(mutex, block_time);
+    hw_lock_record((uint32_t)(esp_timer_get_time() - start), contended,
+                   ret == 0);
+
+    return ret;
+}
+
+#ifndef NO_WOLFSSL_ESP32_CRYPT_HASH
+/* SHA: the mode is decided once per hash object, by a non-blocking
+ * try-lock; a busy accelerator switches the object to software. */
+HW_REAL int __real_esp_sha_try_hw_lock(WC_ESP32SHA* ctx);
+int __wrap_esp_sha_try_hw_lock(WC_ESP32SHA* ctx);
+int __wrap_esp_sha_try_hw_lock(WC_ESP32SHA* ctx)
+{
+    int ret = __real_esp_sha_try_hw_lock(ctx);
+
+    if (ctx != NULL && ctx->mode == ESP32_SHA_HW) {
+        HW_INC(HW_ALG(ESP_WOLFSSL_HW_SHA).hw);
+    }
+    else if (ctx != NULL && ctx->mode == ESP32_SHA_SW) {
+        HW_INC(HW_ALG(ESP_WOLFSSL_HW_SHA).sw);
+        HW_INC(HW_ALG(ESP_WOLFSSL_HW_SHA).fallback_busy);
+    }
+    else if (ret != 0) {
+        HW_INC(HW_ALG(ESP_WOLFSSL_HW_SHA).errors);
+    }
+
+    return ret;
+}
+
+#define HW_SHA_BLOCK(real, blockSz)                                     \
+    do {                                                                \
+        ret = (real);                                                   \
+        if (ret == 0) {                                                 \
+            HW_ADD(HW_ALG(ESP_WOLFSSL_HW_SHA).bytes, (blockSz));        \
+        }                                                               \
+        else {                                                          \
+            HW_INC(HW_ALG(ESP_WOLFSSL_HW_SHA).errors);                  \
+        }                                                               \
+    } while (0)
+
+HW_REAL int __real_esp_sha_process(struct wc_Sha* sha, const byte* data);
+int __wrap_esp_sha_process(struct wc_Sha* sha, const byte* data);
+int __wrap_esp_sha_process(struct wc_Sha* sha, const byte* data)
+{
+    int ret;
+    HW_SHA_BLOCK(__real_esp_sha_process(sha, data), 64);
+    return ret;
+}
+
+HW_REAL int __real_esp_sha256_process(struct wc_Sha256* sha,
+                                      const byte* data);
+int __wrap_esp_sha256_process(struct wc_Sha256* sha, const byte* data);
+int __wrap_esp_sha256_process(struct wc_Sha256* sha, const byte* data)
+{
+    int ret;
+    HW_SHA_BLOCK(__real_esp_sha256_process(sha, data), 64);
+    return ret;
+}
+
+HW_REAL int __real_esp_sha512_process(struct wc_Sha512* sha);
+int __wrap_esp_sha512_process(struct wc_Sha512* sha);
+int __wrap_esp_sha512_process(struct wc_Sha512* sha)
+{
+    int ret;
+    HW_SHA_BLOCK(__real_esp_sha512_process(sha), 128);
+    return ret;
+}
+#endif /* !NO_WOLFSSL_ESP32_CRYPT_HASH */
+
+#ifndef NO_WOLFSSL_ESP32_CRYPT_AES
+/* Asked before each block on targets lacking some key sizes (e.g. AES-192
+ * on the ESP32-S3); 0 means the block is done in software. */
+HW_REAL int __real_wc_esp32AesSupportedKeyLen(struct Aes* aes);
+int __wrap_wc_esp32AesSupportedKeyLen(struct Aes* aes);
+int __wrap_wc_esp32AesSupportedKeyLen(struct Aes* aes)
+{
+    int ret = __real_wc_esp32AesSupportedKeyLen(aes);
+
+    if (ret == 0) {
+        HW_INC(HW_ALG(ESP_WOLFSSL_HW_AES).sw);
+        HW_INC(HW_ALG(ESP_WOLFSSL_HW_AES).fallback_size);
+    }
+    return ret;
+}
+
+#define HW_AES_BLOCK_SZ 16
+
+static int hw_aes_record(int ret, word32 sz)
+{
+    if (ret == 0) {
+        HW_INC(HW_ALG(ESP_WOLFSSL_HW_AES).hw);
+        HW_ADD(HW_ALG(ESP_WOLFSSL_HW_AES).bytes, sz);
+    }
+    else {
+        HW_INC(HW_ALG(ESP_WOLFSSL_HW_AES).errors);
+    }
+    return ret;
+}
+
+HW_REAL int __real_wc_esp32AesEncrypt(struct Aes* aes, const byte* in,
+                                      byte* out);
+int __wrap_wc_esp32AesEncrypt(struct Aes* aes, const byte* in, byte* out);
+int __wrap_wc_esp32AesEncrypt(struct Aes* aes, const byte* in, byte* out)
+{
+    return hw_aes_record(__real_wc_esp32AesEncrypt(aes, in, out),
+                         HW_AES_BLOCK_SZ);
+}
+
+HW_REAL int __real_wc_esp32AesDecrypt(struct Aes* aes, const byte* in,
+                                      byte* out);
+int __wrap_wc_esp32AesDecrypt(struct Aes* aes, const byte* in, byte* out);
+int __wrap_wc_esp32AesDecrypt(struct Aes* aes, const byte* in, byte* out)
+{
+    return hw_aes_record(__real_wc_esp32AesDecrypt(aes, in, out),
+                         HW_AES_BLOCK_SZ);
+}
+
+HW_REAL int __real_wc_esp32AesCbcEncrypt(struct Aes* aes, byte* out,
+                                         const byte* in, word32 sz);
+int __wrap_wc_esp32AesCbcEncrypt(struct Aes* aes, byte* out, const byte* in,
+                                 word32 sz);
+int __wrap_wc_esp32AesCbcEncrypt(struct Aes* aes, byte* out, const byte* in,
+                                 word32 sz)
+{
+    return hw_aes_record(__real_wc_esp32AesCbcEncrypt(aes, out, in, sz), sz);
+}
+
+HW_REAL int __real_wc_esp32AesCbcDecrypt(struct Aes* aes, byte* out,
+                                         const byte* in, word32 sz);
+int __wrap_wc_esp32AesCbcDecrypt(struct Aes* aes, byte* out, const byte* in,
+                                 word32 sz);
+int __wrap_wc_esp32AesCbcDecrypt(struct Aes* aes, byte* out, const byte* in,
+                                 word32 sz)
+{
+    return hw_aes_record(__real_wc_esp32AesCbcDecrypt(aes, out, in, sz), sz);
+}
+#endif /* !NO_WOLFSSL_ESP32_CRYPT_AES */
+
+#if defined(WOLFSSL_ESP32_CRYPT_RSA_PRI) && \
+   !defined(NO_WOLFSSL_ESP32_CRYPT_RSA_PRI)
+/* esp_mp_*() return MP_OKAY when done in hardware. The fallback codes ask
+ * the caller (tfm.c / sp_int.c) to compute the result in software. */
+static int hw_mp_record(esp_wolfssl_hw_alg_id_t id, int ret)
+{
+    esp_wolfssl_hw_alg_t* a = &HW_ALG(id);
+
+    if (ret == MP_OKAY) {
+        HW_INC(a->hw);
+    }
+#ifdef MP_HW_BUSY
+    else if (ret == MP_HW_BUSY) {
+        HW_INC(a->sw);
+        HW_INC(a->fallback_busy);
+    }
+#endif
+#ifdef MP_HW_FALLBACK
+    else if (ret == MP_HW_FALLBACK) {
+        HW_INC(a->sw);
+        HW_INC(a->fallback_size);
+    }
+#endif
+#ifdef MP_HW_VALIDATION_ACTIVE
+    else if (ret == MP_HW_VALIDATION_ACTIVE) {
+        HW_INC(a->sw);
+    }
+#endif
+    else {
+        HW_INC(a->errors);
+    }
+    return ret;
+}
+
+/* The MATH_INT_T layout depends on the math library; only pointers are
+ * passed through. */
+#ifndef NO_WOLFSSL_ESP32_CRYPT_RSA_PRI_MP_MUL
+HW_REAL int __real_esp_mp_mul(void* X, void* Y, void* Z);
+int __wrap_esp_mp_mul(void* X, void* Y, void* Z);
+int __wrap_esp_mp_mul(void* X, void* Y, void* Z)
+{
+    return hw_mp_record(ESP_WOLFSSL_HW_MP_MUL, __real_esp_mp_mul(X, Y, Z));
+}
+#endif
+
+#ifndef NO_WOLFSSL_ESP32_CRYPT_RSA_PRI_MULMOD
+HW_REAL int __real_esp_mp_mulmod(void* X, void* Y, void* M, void* Z);
+int __wrap_esp_mp_mulmod(void* X, void* Y, void* M, void* Z);
+int __wrap_esp_mp_mulmod(void* X, void* Y, void* M, void* Z)
+{
+    return hw_mp_record(ESP_WOLFSSL_HW_MP_MULMOD,
+                        __real_esp_mp_mulmod(X, Y, M, Z));
+}
+#endif
+
+#ifndef NO_WOLFSSL_ESP32_CRYPT_RSA_PRI_EXPTMOD
+HW_REAL int __real_esp_mp_exptmod(void* X, void* Y, void* M, void* Z);
+int __wrap_esp_mp_exptmod(void* X, void* Y, void* M, void* Z);
+int __wrap_esp_mp_exptmod(void* X, void* Y, void* M, void* Z)
+{
+    return hw_mp_record(ESP_WOLFSSL_HW_MP_EXPTMOD,
+                        __real_esp_mp_exptmod(X, Y, M, Z));
+}
+#endif
+#endif /* WOLFSSL_ESP32_CRYPT_RSA_PRI */
+
+#endif /* WOLFSSL_ESPIDF */
+
+#endif /* WOLFSSL_ESP_HW_METRICS */
@@ -0,0 +1,91 @@
+/* esp_wolfssl_hw_metrics.h
+ *
+ * Copyright (C) 2006-2024 wolfSSL Inc.
+ *
+ * This file is part of wolfSSL.
+ *
+ * wolfSSL is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfSSL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335, USA
+ */
+
+/* Runtime counters for the SHA, AES and MPI (RSA) accelerators.
+ *
+ * Enabled with Kconfig WOLFSSL_HW_METRICS_API. The counters are updated by
+ * linker wrappers (-Wl,--wrap, see the component CMakeLists.txt) around the
+ * Espressif port functions, with relaxed atomics only, so
+ * esp_wolfssl_hw_metrics_get() is cheap enough to call periodically from a
+ * telemetry task. On a Linux host build all counters stay zero.
+ */
+
+#ifndef _ESP_WOLFSSL_HW_METRICS_H_
+#define _ESP_WOLFSSL_HW_METRICS_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum esp_wolfssl_hw_alg_id_t {
+    ESP_WOLFSSL_HW_SHA = 0,
+    ESP_WOLFSSL_HW_AES,
+    ESP_WOLFSSL_HW_MP_MUL,      /* Z = X * Y */
+    ESP_WOLFSSL_HW_MP_MULMOD,   /* Z = X * Y mod M */
+    ESP_WOLFSSL_HW_MP_EXPTMOD,  /* Z = X ^ Y mod M */
+    ESP_WOLFSSL_HW_ALG_COUNT
+} esp_wolfssl_hw_alg_id_t;
+
+/* Lock wait histogram upper bounds: <1us, <10us, <100us, <1ms, <10ms, more */
+#define ESP_WOLFSSL_HW_WAIT_BUCKETS 6
+
+typedef struct esp_wolfssl_hw_alg_t {
+    uint32_t enabled;       /* accelerator compiled in for this target */
+    uint32_t hw;            /* operations run on the accelerator */
+    uint32_t sw;            /* operations that fell back to software */
+    uint32_t fallback_busy; /* ... because the accelerator was in use */
+    uint32_t fallback_size; /* ... because the key or operand size is not
+                             * supported by the accelerator */
+    uint32_t errors;        /* accelerator returned an error */
+    uint64_t bytes;         /* data processed on the accelerator (SHA, AES) */
+} esp_wolfssl_hw_alg_t;
+
+typedef struct esp_wolfssl_hw_lock_t {
+    uint32_t acquired;      /* successful lock calls */
+    uint32_t contended;     /* lock was held by another task on entry */
+    uint32_t failed;        /* not acquired, e.g. SHA try-lock */
+    uint32_t wait_max_us;
+    uint64_t wait_total_us;
+    uint32_t wait_hist[ESP_WOLFSSL_HW_WAIT_BUCKETS];
+} esp_wolfssl_hw_lock_t;
+
+typedef struct esp_wolfssl_hw_metrics_t {
+    esp_wolfssl_hw_alg_t  alg[ESP_WOLFSSL_HW_ALG_COUNT];
+    esp_wolfssl_hw_lock_t lock;     /* all accelerator mutexes */
+} esp_wolfssl_hw_metrics_t;
+
+/* Copies the current counters. Individual counters are consistent, the
+ * snapshot as a whole is not taken atomically. */
+void esp_wolfssl_hw_metrics_get(esp_wolfssl_hw_metrics_t* out);
+void esp_wolfssl_hw_metrics_reset(void);
+
+/* Logs a snapshot; pass NULL for the current counters. */
+void esp_wolfssl_hw_metrics_log(const esp_wolfssl_hw_metrics_t* m);
+
+const char* esp_wolfssl_hw_alg_name(esp_wolfssl_hw_alg_id_t id);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _ESP_WOLFSSL_HW_METRICS_H_ */
@@ -0,0 +1,676 @@
+/* esp_wolfssl_hw_order.c
+ *
+ * Copyright (C) 2006-2024 wolfSSL Inc.
+ *
+ * This file is part of wolfSSL.
+ *
+ * wolfSSL is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfSSL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335, USA
+ */
+
+#include <wolfssl/wolfcrypt/settings.h>
+
+#ifdef WOLFSSL_ESP_HW_ORDER
+
+#include <stdint.h>
+#include <string.h>
+
+#include <wolfssl/ssl.h>
+#include <wolfssl/wolfcrypt/types.h>
+#include <wolfssl/wolfcrypt/random.h>
+#include <wolfssl/wolfcrypt/error-crypt.h>
+#include <wolfssl/wolfcrypt/wc_port.h>
+#ifdef HAVE_AESGCM
+    #include <wolfssl/wolfcrypt/aes.h>
+#endif
+#if defined(HAVE_CHACHA) && defined(HAVE_POLY1305)
+    #include <wolfssl/wolfcrypt/chacha20_poly1305.h>
+#endif
+#ifdef HAVE_ECC
+    #include <wolfssl/wolfcrypt/ecc.h>
+#endif
+#ifdef HAVE_CURVE25519
+    #include <wolfssl/wolfcrypt/curve25519.h>
+#endif
+
+#include "esp_wolfssl_hw_order.h"
+
+#ifdef WOLFSSL_ESPIDF
+    #include <esp_timer.h>
+#else
+    #include <time.h>
+#endif
+
+/* one TLS record of application data is about this size on a device */
+#define HO_RECORD_SZ   1024
+#define HO_AEAD_ROUNDS 8
+#define HO_PK_ROUNDS   2
+
+/* AES-256-GCM: more rounds and SHA-384, never ahead of the other two */
+#define HO_AES256 3
+
+typedef struct ho_suite {
+    int         aead;
+    const char* name;
+} ho_suite;
+
+static const ho_suite ho_suites[] = {
+#ifdef WOLFSSL_TLS13
+    #ifdef HAVE_AESGCM
+    { ESP_WOLFSSL_HW_ORDER_AES_GCM, "TLS13-AES128-GCM-SHA256" },
+    #endif
+    #if defined(HAVE_CHACHA) && defined(HAVE_POLY1305)
+    { ESP_WOLFSSL_HW_ORDER_CHACHA,  "TLS13-CHACHA20-POLY1305-SHA256" },
+    #endif
+    #if defined(HAVE_AESGCM) && defined(WOLFSSL_SHA384)
+    { HO_AES256,                    "TLS13-AES256-GCM-SHA384" },
+    #endif
+#endif
+#if !defined(WOLFSSL_NO_TLS12) && \
+    (defined(HAVE_ECC) || defined(HAVE_CURVE25519))
+    #ifdef HAVE_AESGCM
+        #ifdef HAVE_ECC
+    { ESP_WOLFSSL_HW_ORDER_AES_GCM, "ECDHE-ECDSA-AES128-GCM-SHA256" },
+        #endif
+        #ifndef NO_RSA
+    { ESP_WOLFSSL_HW_ORDER_AES_GCM, "ECDHE-RSA-AES128-GCM-SHA256" },
+        #endif
+    #endif
+    #if defined(HAVE_CHACHA) && defined(HAVE_POLY1305)
+        #ifdef HAVE_ECC
+    { ESP_WOLFSSL_HW_ORDER_CHACHA,  "ECDHE-ECDSA-CHACHA20-POLY1305" },
+        #endif
+        #ifndef NO_RSA
+    { ESP_WOLFSSL_HW_ORDER_CHACHA,  "ECDHE-RSA-CHACHA20-POLY1305" },
+        #endif
+    #endif
+    #if defined(HAVE_AESGCM) && defined(WOLFSSL_SHA384)
+        #ifdef HAVE_ECC
+    { HO_AES256,                    "ECDHE-ECDSA-AES256-GCM-SHA384" },
+        #endif
+        #ifndef NO_RSA
+    { HO_AES256,                    "ECDHE-RSA-AES256-GCM-SHA384" },
+        #endif
+    #endif
+#endif
+};
+
+#define HO_SUITES (sizeof(ho_suites) / sizeof(ho_suites[0]))
+
+/* The groups wolfSSL offers when none are set, in its order of preference
+ * (preferredGroup in tls.c); they follow the two ordered here. */
+static const int ho_groups[] = {
+#if defined(HAVE_ECC) && ECC_MIN_KEY_SZ <= 256
+    WOLFSSL_ECC_SECP256R1,
+#endif
+#ifdef HAVE_CURVE25519
+    WOLFSSL_ECC_X25519,
+#endif
+#ifdef HAVE_CURVE448
+    WOLFSSL_ECC_X448,
+#endif
+#if defined(HAVE_ECC) && (defined(HAVE_ECC384) || defined(HAVE_ALL_CURVES)) \
+    && ECC_MIN_KEY_SZ <= 384
+    WOLFSSL_ECC_SECP384R1,
+#endif
+#if defined(HAVE_ECC) && (defined(HAVE_ECC521) || defined(HAVE_ALL_CURVES)) \
+    && ECC_MIN_KEY_SZ <= 521
+    WOLFSSL_ECC_SECP521R1,
+#endif
+#ifdef HAVE_FFDHE_2048
+    WOLFSSL_FFDHE_2048,
+#endif
+#ifdef HAVE_FFDHE_3072
+    WOLFSSL_FFDHE_3072,
+#endif
+#ifdef HAVE_FFDHE_4096
+    WOLFSSL_FFDHE_4096,
+#endif
+#ifdef HAVE_FFDHE_6144
+    WOLFSSL_FFDHE_6144,
+#endif
+#ifdef HAVE_FFDHE_8192
+    WOLFSSL_FFDHE_8192,
+#endif
+};
+
+#define HO_GROUPS (sizeof(ho_groups) / sizeof(ho_groups[0]))
+
+static esp_wolfssl_hw_order_t ho_order;
+static int ho_ready;
+/* the cipher list per AEAD first, ':' separated; built on first use and
+ * kept, as contexts may be reading them */
+static char* ho_lists[2];
+static wolfSSL_Mutex ho_mutex;
+static int ho_mutex_ok;
+
+/* before any handshake, and before the scheduler starts on the device */
+static void __attribute__((constructor)) ho_init(void)
+{
+    ho_mutex_ok = (wc_InitMutex(&ho_mutex) == 0);
+}
+
+static int64_t ho_now(void)
+{
+#ifdef WOLFSSL_ESPIDF
+    return esp_timer_get_time();
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+#endif
+}
+
+/* From the chipset block of user_settings.h: AES-GCM first only where
+ * AES runs in hardware, X25519 first while ECC runs in software too. */
+static void ho_table(esp_wolfssl_hw_order_t* order)
+{
+#if defined(HAVE_AESGCM) && \
+    (!defined(HAVE_CHACHA) || !defined(HAVE_POLY1305) || \
+     (defined(WOLFSSL_ESPIDF) && !defined(NO_ESP32_CRYPT) && \
+      !defined(NO_WOLFSSL_ESP32_CRYPT_AES)))
+    order->aead_first = ESP_WOLFSSL_HW_ORDER_AES_GCM;
+#else
+    order->aead_first = ESP_WOLFSSL_HW_ORDER_CHACHA;
+#endif
+#ifdef HAVE_CURVE25519
+    order->group_first = WOLFSSL_ECC_X25519;
+#else
+    order->group_first = WOLFSSL_ECC_SECP256R1;
+#endif
+}
+
+#ifdef WOLFSSL_ESP_HW_ORDER_MEASURE
+
+#ifdef HAVE_AESGCM
+static int ho_time_aes_gcm(byte* buf, uint32_t* us)
+{
+    static const byte key[16] = { 0 };
+    static const byte iv[GCM_NONCE_MID_SZ] = { 0 };
+    byte tag[AES_BLOCK_SIZE];
+    Aes* aes;
+    int64_t start = 0;
+    int ret;
+    int i;
+
+    aes = (Aes*)XMALLOC(sizeof(Aes), NULL, DYNAMIC_TYPE_AES);
+    if (aes == NULL) {
+        return MEMORY_E;
+    }
+    ret = wc_AesInit(aes, NULL, INVALID_DEVID);
+    if (ret == 0) {
+        ret = wc_AesGcmSetKey(aes, key, sizeof(key));
+    }
+    /* the first round warms the cache and the accelerator */
+    for (i = 0; ret == 0 && i <= HO_AEAD_ROUNDS; i++) {
+        if (i == 1) {
+            start = ho_now();
+        }
+        ret = wc_AesGcmEncrypt(aes, buf, buf, HO_RECORD_SZ, iv, sizeof(iv),
+                               tag, sizeof(tag), NULL, 0);
+    }
+    if (ret == 0) {
+        *us = (uint32_t)((ho_now() - start) / HO_AEAD_ROUNDS);
+    }
+    wc_AesFree(aes);
+    XFREE(aes, NULL, DYNAMIC_TYPE_AES);
+    return ret;
+}
+#endif
+
+#if defined(HAVE_CHACHA) && defined(HAVE_POLY1305)
+static int ho_time_chacha(byte* buf, uint32_t* us)
+{
+    static const byte key[CHACHA20_POLY1305_AEAD_KEYSIZE] = { 0 };
+    static const byte iv[CHACHA20_POLY1305_AEAD_IV_SIZE] = { 0 };
+    byte tag[CHACHA20_POLY1305_AEAD_AUTHTAG_SIZE];
+    int64_t start = 0;
+    int ret = 0;
+    int i;
+
+    for (i = 0; ret == 0 && i <= HO_AEAD_ROUNDS; i++) {
+        if (i == 1) {
+            start = ho_now();
+        }
+        ret = wc_ChaCha20Poly1305_Encrypt(key, iv, NULL, 0, buf, HO_RECORD_SZ,
+                                          buf, tag);
+    }
+    if (ret == 0) {
+        *us = (uint32_t)((ho_now() - start) / HO_AEAD_ROUNDS);
+    }
+    return ret;
+}
+#endif
+
+/* The shared secret only: key generation costs about the same again for
+ * both groups, and with the key pool it is off the connect path anyway. */
+#ifdef HAVE_ECC
+static int ho_time_p256(WC_RNG* rng, uint32_t* us)
+{
+    byte secret[32];
+    word32 len;
+    ecc_key* key;
+    int64_t start;
+    int ret;
+    int i;
+
+    key = (ecc_key*)XMALLOC(2 * sizeof(ecc_key), NULL, DYNAMIC_TYPE_ECC);
+    if (key == NULL) {
+        return MEMORY_E;
+    }
+    ret = wc_ecc_init(&key[0]);
+    if (ret == 0) {
+        ret = wc_ecc_init(&key[1]);
+        if (ret != 0) {
+            wc_ecc_free(&key[0]);
+        }
+    }
+    if (ret != 0) {
+        XFREE(key, NULL, DYNAMIC_TYPE_ECC);
+        return ret;
+    }
+    ret = wc_ecc_make_key_ex(rng, 32, &key[0], ECC_SECP256R1);
+    if (ret == 0) {
+        ret = wc_ecc_make_key_ex(rng, 32, &key[1], ECC_SECP256R1);
+    }
+#ifdef ECC_TIMING_RESISTANT
+    if (ret == 0) {
+        ret = wc_ecc_set_rng(&key[0], rng);
+    }
+#endif
+    start = ho_now();
+    for (i = 0; ret == 0 && i < HO_PK_ROUNDS; i++) {
+        len = sizeof(secret);
+        ret = wc_ecc_shared_secret(&key[0], &key[1], secret, &len);
+    }
+    if (ret == 0) {
+        *us = (uint32_t)((ho_now() - start) / HO_PK_ROUNDS);
+    }
+    wc_ecc_free(&key[1]);
+    wc_ecc_free(&key[0]);
+    XFREE(key, NULL, DYNAMIC_TYPE_ECC);
+    return ret;
+}
+#endif
+
+#ifdef HAVE_CURVE25519
+static int ho_time_x25519(WC_RNG* rng, uint32_t* us)
+{
+    byte secret[CURVE25519_KEYSIZE];
+    word32 len;
+    curve25519_key* key;
+    int64_t start;
+    int ret;
+    int i;
+
+    key = (curve25519_key*)XMALLOC(2 * sizeof(curve25519_key), NULL,
+                                   DYNAMIC_TYPE_CURVE25519);
+    if (key == NULL) {
+        return MEMORY_E;
+    }
+    ret = wc_curve25519_init(&key[0]);
+    if (ret == 0) {
+        ret = wc_curve25519_init(&key[1]);
+    }
+    if (ret == 0) {
+        ret = wc_curve25519_make_key(rng, CURVE25519_KEYSIZE, &key[0]);
+    }
+    if (ret == 0) {
+        ret = wc_curve25519_make_key(rng, CURVE25519_KEYSIZE, &key[1]);
+    }
+    start = ho_now();
+    for (i = 0; ret == 0 && i < HO_PK_ROUNDS; i++) {
+        len = sizeof(secret);
+        ret = wc_curve25519_shared_secret(&key[0], &key[1], secret, &len);
+    }
+    if (ret == 0) {
+        *us = (uint32_t)((ho_now() - start) / HO_PK_ROUNDS);
+    }
+    wc_curve25519_free(&key[1]);
+    wc_curve25519_free(&key[0]);
+    XFREE(key, NULL, DYNAMIC_TYPE_CURVE25519);
+    return ret;
+}
+#endif
+
+static int ho_measure(esp_wolfssl_hw_order_t* order)
+{
+    WC_RNG rng;
+    byte* buf;
+    int ret;
+
+    buf = (byte*)XMALLOC(HO_RECORD_SZ, NULL, DYNAMIC_TYPE_TMP_BUFFER);
+    if (buf == NULL) {
+        return MEMORY_E;
+    }
+    XMEMSET(buf, 0, HO_RECORD_SZ);
+    ret = wc_InitRng(&rng);
+    if (ret != 0) {
+        XFREE(buf, NULL, DYNAMIC_TYPE_TMP_BUFFER);
+        return ret;
+    }
+#ifdef HAVE_AESGCM
+    if (ret == 0) {
+        ret = ho_time_aes_gcm(buf, &order->aes_gcm_us);
+    }
+#endif
+#if defined(HAVE_CHACHA) && defined(HAVE_POLY1305)
+    if (ret == 0) {
+        ret = ho_time_chacha(buf, &order->chacha_us);
+    }
+#endif
+#ifdef HAVE_ECC
+    if (ret == 0) {
+        ret = ho_time_p256(&rng, &order->p256_us);
+    }
+#endif
+#ifdef HAVE_CURVE25519
+    if (ret == 0) {
+        ret = ho_time_x25519(&rng, &order->x25519_us);
+    }
+#endif
+    wc_FreeRng(&rng);
+    XFREE(buf, NULL, DYNAMIC_TYPE_TMP_BUFFER);
+    if (ret != 0) {
+        return ret;
+    }
+
+    order->measured = 1;
+    if (order->aes_gcm_us != 0 && order->chacha_us != 0) {
+        order->aead_first = (order->aes_gcm_us <= order->chacha_us)
+                            ? ESP_WOLFSSL_HW_ORDER_AES_GCM
+                            : ESP_WOLFSSL_HW_ORDER_CHACHA;
+    }
+    if (order->p256_us != 0 && order->x25519_us != 0) {
+        order->group_first = (order->p256_us < order->x25519_us)
+                             ? WOLFSSL_ECC_SECP256R1 : WOLFSSL_ECC_X25519;
+    }
+    return 0;
+}
+
+#endif /* WOLFSSL_ESP_HW_ORDER_MEASURE */
+
+static int ho_ours(const char* name)
+{
+    size_t i;
+
+    for (i = 0; i < HO_SUITES; i++) {
+        if (strcmp(ho_suites[i].name, name) == 0) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/* The suites of the library's own list not ordered above: the ones built,
+ * less the NULL ciphers, integrity-only TLS 1.3 and anonymous suites it
+ * leaves out unless asked for by name. */
+static int ho_library(const char* name)
+{
+    return strstr(name, "NULL") == NULL &&
+           strncmp(name, "TLS13-SHA", 9) != 0 &&
+           strncmp(name, "ADH-", 4) != 0 && !ho_ours(name);
+}
+
+static void ho_append(char* list, size_t* len, const char* name)
+{
+    size_t sz = strlen(name);
+
+    if (*len > 0) {
+        list[(*len)++] = ':';
+    }
+    XMEMCPY(list + *len, name, sz);
+    *len += sz;
+}
+
+/* The suites above first, TLS 1.3 ahead of TLS 1.2, each by rank of the
+ * AEAD; then the rest of the library's list in its order. */
+static char* ho_build_list(int aead_first)
+{
+    const char* name;
+    char* list;
+    int rank[3];
+    size_t len = 0;
+    size_t sz = 1;
+    size_t i;
+    int tls13;
+    int r;
+
+    for (i = 0; i < HO_SUITES; i++) {
+        sz += strlen(ho_suites[i].name) + 1;
+    }
+    for (i = 0; (name = wolfSSL_get_cipher_list((int)i)) != NULL; i++) {
+        sz += strlen(name) + 1;
+    }
+    list = (char*)XMALLOC(sz, NULL, DYNAMIC_TYPE_TMP_BUFFER);
+    if (list == NULL) {
+        return NULL;
+    }
+
+    rank[0] = aead_first;
+    rank[1] = (aead_first == ESP_WOLFSSL_HW_ORDER_AES_GCM)
+              ? ESP_WOLFSSL_HW_ORDER_CHACHA : ESP_WOLFSSL_HW_ORDER_AES_GCM;
+    rank[2] = HO_AES256;
+    for (tls13 = 1; tls13 >= 0; tls13--) {
+        for (r = 0; r < 3; r++) {
+            for (i = 0; i < HO_SUITES; i++) {
+                if (ho_suites[i].aead == rank[r] &&
+                    (strncmp(ho_suites[i].name, "TLS13-", 6) == 0)
+                        == tls13) {
+                    ho_append(list, &len, ho_suites[i].name);
+                }
+            }
+        }
+    }
+    for (i = 0; (name = wolfSSL_get_cipher_list((int)i)) != NULL; i++) {
+        if (ho_library(name)) {
+            ho_append(list, &len, name);
+        }
+    }
+    list[len] = '\0';
+    return list;
+}
+
+/* under the lock: the table order until esp_wolfssl_hw_order_init() */
+static void ho_ensure(void)
+{
+    if (!ho_ready) {
+        XMEMSET(&ho_order, 0, sizeof(ho_order));
+        ho_table(&ho_order);
+        ho_ready = 1;
+    }
+}
+
+static int ho_lock(void)
+{
+    return ho_mutex_ok && wc_LockMutex(&ho_mutex) == 0;
+}
+
+int esp_wolfssl_hw_order_init(void)
+{
+    int ret = 0;
+#ifdef WOLFSSL_ESP_HW_ORDER_MEASURE
+    esp_wolfssl_hw_order_t order;
+
+    if (!ho_lock()) {
+        return BAD_MUTEX_E;
+    }
+    ho_ensure();
+    order = ho_order;
+    wc_UnLockMutex(&ho_mutex);
+    if (order.measured) {
+        return 0;
+    }
+
+    /* contexts made meanwhile get the table order */
+    ret = ho_measure(&order);
+    if (ret != 0) {
+        return ret;
+    }
+    if (!ho_lock()) {
+        return BAD_MUTEX_E;
+    }
+    ho_order = order;
+    wc_UnLockMutex(&ho_mutex);
+#else
+    if (!ho_lock()) {
+        return BAD_MUTEX_E;
+    }
+    ho_ensure();
+    wc_UnLockMutex(&ho_mutex);
+#endif
+    return ret;
+}
+
+void esp_wolfssl_hw_order_get(esp_wolfssl_hw_order_t* order)
+{
+    if (order == NULL) {
+        return;
+    }
+    if (!ho_lock()) {
+        XMEMSET(order, 0, sizeof(*order));
+        ho_table(order);
+        return;
+    }
+    ho_ensure();
+    *order = ho_order;
+    wc_UnLockMutex(&ho_mutex);
+}
+
+const char* esp_wolfssl_hw_order_cipher_list(void)
+{
+    char** list;
+
+    if (!ho_lock()) {
+        return NULL;
+    }
+    ho_ensure();
+    list = &ho_lists[ho_order.aead_first == ESP_WOLFSSL_HW_ORDER_CHACHA];
+    if (*list == NULL) {
+        *list = ho_build_list(ho_order.aead_first);
+    }
+    wc_UnLockMutex(&ho_mutex);
+    return *list;
+}
+
+static int ho_listed(const int* groups, int n, int group)
+{
+    int i;
+
+    for (i = 0; i < n; i++) {
+        if (groups[i] == group) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+int esp_wolfssl_hw_order_groups(int* groups, int max)
+{
+    esp_wolfssl_hw_order_t order;
+    int n = 0;
+    size_t i;
+
+    if (groups == NULL) {
+        return 0;
+    }
+    esp_wolfssl_hw_order_get(&order);
+#ifdef HAVE_CURVE25519
+    if (n < max && order.group_first == WOLFSSL_ECC_X25519) {
+        groups[n++] = WOLFSSL_ECC_X25519;
+    }
+#endif
+#ifdef HAVE_ECC
+    if (n < max) {
+        groups[n++] = WOLFSSL_ECC_SECP256R1;
+    }
+#endif
+#ifdef HAVE_CURVE25519
+    if (n < max && order.group_first != WOLFSSL_ECC_X25519) {
+        groups[n++] = WOLFSSL_ECC_X25519;
+    }
+#endif
+    for (i = 0; i < HO_GROUPS && n < max; i++) {
+        if (!ho_listed(groups, n, ho_groups[i])) {
+            groups[n++] = ho_groups[i];
+        }
+    }
+    return n;
+}
+
+int esp_wolfssl_hw_order_ctx_set_ciphers(WOLFSSL_CTX* ctx)
+{
+    const char* list;
+
+    if (ctx == NULL) {
+        return BAD_FUNC_ARG;
+    }
+    list = esp_wolfssl_hw_order_cipher_list();
+    if (list == NULL) {
+        return MEMORY_E;
+    }
+    if (list[0] == '\0') {
+        /* none of the suites is built: keep the library's */
+        return WOLFSSL_SUCCESS;
+    }
+    return wolfSSL_CTX_set_cipher_list(ctx, list);
+}
+
+int esp_wolfssl_hw_order_ctx_set(WOLFSSL_CTX* ctx)
+{
+    int groups[ESP_WOLFSSL_HW_ORDER_MAX_GROUPS];
+    int ret;
+    int n;
+
+    ret = esp_wolfssl_hw_order_ctx_set_ciphers(ctx);
+#ifdef WOLFSSL_TLS13
+    if (ret == WOLFSSL_SUCCESS) {
+        n = esp_wolfssl_hw_order_groups(groups,
+                                        ESP_WOLFSSL_HW_ORDER_MAX_GROUPS);
+        if (n > 0) {
+            ret = wolfSSL_CTX_set_groups(ctx, groups, n);
+        }
+    }
+#else
+    (void)groups;
+    (void)n;
+#endif
+    return ret;
+}
+
+/* With WOLFSSL_MLKEM_DEFAULT the wrapper in esp_wolfssl_pq.c applies the
+ * cipher list and, through esp_wolfssl_hw_order_groups(), the groups. */
+#if defined(WOLFSSL_ESP_HW_ORDER_DEFAULT) && !defined(WOLFSSL_ESP_PQ_DEFAULT)
+extern WOLFSSL_CTX* __real_wolfSSL_CTX_new(WOLFSSL_METHOD* method);
+WOLFSSL_CTX* __wrap_wolfSSL_CTX_new(WOLFSSL_METHOD* method);
+
+WOLFSSL_CTX* __wrap_wolfSSL_CTX_new(WOLFSSL_METHOD* method)
+{
+#ifdef WOLFSSL_ESP_MEM_AUTO
+    /* also the context's accounting domain, see esp_wolfssl_mem.h */
+    WOLFSSL_CTX* ctx = esp_wolfssl_mem_ctx_new(method);
+#else
+    WOLFSSL_CTX* ctx = __real_wolfSSL_CTX_new(method);
+#endif
+
+    if (ctx != NULL) {
+        /* the groups fail for a context without TLS 1.3, which keeps its
+         * defaults for them */
+        (void)esp_wolfssl_hw_order_ctx_set(ctx);
+    }
+    return ctx;
+}
+#endif
+
+#endif /* WOLFSSL_ESP_HW_ORDER */
@@ -0,0 +1,109 @@
+/* esp_wolfssl_hw_order.h
+ *
+ * Copyright (C) 2006-2024 wolfSSL Inc.
+ *
+ * This file is part of wolfSSL.
+ *
+ * wolfSSL is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfSSL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335, USA
+ */
+
+/* Cipher-suite and group preference for the running chip.
+ *
+ * Enabled with Kconfig WOLFSSL_HW_ORDER. Which primitives are fast differs
+ * per target: the chipset block of user_settings.h leaves AES in software
+ * on the C2 and H2 and SHA-384 in software on the C2, C3 and C6, where
+ * ChaCha20-Poly1305 can beat AES-GCM, while the ESP32 and S3 do AES in
+ * hardware. With WOLFSSL_HW_ORDER_MEASURE, esp_wolfssl_hw_order_init()
+ * times a 1 KB AES-128-GCM and ChaCha20-Poly1305 record and one P-256 and
+ * X25519 shared secret, which takes a few tens of ms; until it has run,
+ * and with WOLFSSL_HW_ORDER_TABLE, the order comes from the chipset
+ * settings. The faster AEAD leads the ECDHE-AEAD suites, for TLS 1.3 and
+ * 1.2 alike, with AES-256-GCM last, and the rest of the library's cipher
+ * list follows in its own order; the faster of X25519 and P-256 leads the
+ * groups and gets the key share of a TLS 1.3 ClientHello, and the other
+ * groups wolfSSL offers by default follow. Nothing is taken out.
+ *
+ * With Kconfig WOLFSSL_HW_ORDER_DEFAULT every new WOLFSSL_CTX gets this
+ * preference (a linker wrapper around wolfSSL_CTX_new, shared with
+ * WOLFSSL_MLKEM_DEFAULT, see the component CMakeLists.txt), so esp-tls
+ * connections use it too. With ML-KEM the hybrid group stays first and
+ * the measured order applies to the classical fallbacks. A cipher list
+ * set on the context later replaces the one from here.
+ */
+
+#ifndef _ESP_WOLFSSL_HW_ORDER_H_
+#define _ESP_WOLFSSL_HW_ORDER_H_
+
+#include <stdint.h>
+
+#include <wolfssl/wolfcrypt/settings.h>
+#include <wolfssl/ssl.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifdef WOLFSSL_ESP_HW_ORDER
+
+/* Most groups a context takes, WOLFSSL_MAX_GROUP_COUNT in internal.h
+ * unless configured otherwise */
+#ifdef WOLFSSL_MAX_GROUP_COUNT
+    #define ESP_WOLFSSL_HW_ORDER_MAX_GROUPS WOLFSSL_MAX_GROUP_COUNT
+#else
+    #define ESP_WOLFSSL_HW_ORDER_MAX_GROUPS 10
+#endif
+
+typedef struct esp_wolfssl_hw_order_t {
+    int      measured;      /* 0 when the order comes from the table */
+    int      aead_first;    /* ESP_WOLFSSL_HW_ORDER_AES_GCM or _CHACHA */
+    int      group_first;   /* WOLFSSL_ECC_X25519 or WOLFSSL_ECC_SECP256R1 */
+    /* per 1 KB record, encrypt and tag; 0 when not built or not measured */
+    uint32_t aes_gcm_us;
+    uint32_t chacha_us;
+    /* per shared secret, one scalar multiplication */
+    uint32_t p256_us;
+    uint32_t x25519_us;
+} esp_wolfssl_hw_order_t;
+
+#define ESP_WOLFSSL_HW_ORDER_AES_GCM 1
+#define ESP_WOLFSSL_HW_ORDER_CHACHA  2
+
+/* Measures the order with WOLFSSL_HW_ORDER_MEASURE, e.g. at boot before
+ * the first connection; contexts made before use the table order. Returns
+ * 0 or an error; on an error the table order stays. */
+int esp_wolfssl_hw_order_init(void);
+
+/* The order in use */
+void esp_wolfssl_hw_order_get(esp_wolfssl_hw_order_t* order);
+
+/* wolfSSL cipher list, TLS 1.3 suites first; kept until reboot, NULL
+ * without memory */
+const char* esp_wolfssl_hw_order_cipher_list(void);
+
+/* Fills up to max groups in preference order; returns how many. */
+int esp_wolfssl_hw_order_groups(int* groups, int max);
+
+/* Cipher list, and cipher list plus groups, for a context. Return
+ * WOLFSSL_SUCCESS or an error. */
+int esp_wolfssl_hw_order_ctx_set_ciphers(WOLFSSL_CTX* ctx);
+int esp_wolfssl_hw_order_ctx_set(WOLFSSL_CTX* ctx);
+
+#endif /* WOLFSSL_ESP_HW_ORDER */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _ESP_WOLFSSL_HW_ORDER_H_ */
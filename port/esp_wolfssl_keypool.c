@@ -0,0 +1,448 @@
+/* esp_wolfssl_keypool.c
+ *
+ * Copyright (C) 2006-2024 wolfSSL Inc.
+ *
+ * This file is part of wolfSSL.
+ *
+ * wolfSSL is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfSSL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335, USA
+ */
+
+#include <wolfssl/wolfcrypt/settings.h>
+
+#ifdef WOLFSSL_ESP_KEYPOOL
+
+#include <stdint.h>
+#include <string.h>
+
+#include <wolfssl/wolfcrypt/types.h>
+#include <wolfssl/wolfcrypt/random.h>
+#include <wolfssl/wolfcrypt/error-crypt.h>
+#include <wolfssl/wolfcrypt/wc_port.h>
+
+#include "esp_wolfssl_keypool.h"
+#include "esp_wolfssl_lock.h"
+#ifdef WOLFSSL_ESP_ECC_HW
+    #include "esp_wolfssl_ecc_hw.h"
+#endif
+
+#ifdef WOLFSSL_ESPIDF
+    #include <freertos/FreeRTOS.h>
+    #include <freertos/task.h>
+#endif
+
+#ifndef ESP_WOLFSSL_KEYPOOL_X25519
+    #define ESP_WOLFSSL_KEYPOOL_X25519 1
+#endif
+#ifndef ESP_WOLFSSL_KEYPOOL_P256
+    #define ESP_WOLFSSL_KEYPOOL_P256   1
+#endif
+
+#if defined(HAVE_CURVE25519) && ESP_WOLFSSL_KEYPOOL_X25519
+    #define KP_HAVE_X25519
+#endif
+#if defined(HAVE_ECC) && ESP_WOLFSSL_KEYPOOL_P256
+    #define KP_HAVE_P256
+#endif
+
+/* ECC keygen of the SP code plus the TLS free stack margin */
+#define KP_TASK_STACK   6144
+
+enum {
+    KP_X25519,
+    KP_P256,
+    KP_GROUPS
+};
+
+/* X25519: private, public; P-256: d, x, y */
+#define KP_FIELD_SZ     32
+#define KP_DATA_SZ      (3 * KP_FIELD_SZ)
+
+typedef struct kp_slot {
+    byte ready;
+    byte data[KP_DATA_SZ];
+} kp_slot;
+
+static kp_slot kp_slots[KP_GROUPS][ESP_WOLFSSL_KEYPOOL_KEYS];
+static int kp_enabled = 1;
+static esp_wolfssl_keypool_stats_t kp_stats;
+/* slots, statistics and kp_enabled */
+static esp_wolfssl_spin_t kp_spin;
+static int kp_spin_ok;
+
+#ifdef WOLFSSL_ESPIDF
+static TaskHandle_t kp_task;
+/* starting the refill task, which blocks */
+static wolfSSL_Mutex kp_task_mutex;
+static int kp_task_mutex_ok;
+#endif
+
+#ifdef HAVE_ECC
+int __real_wc_ecc_make_key_ex(WC_RNG* rng, int keysize, ecc_key* key,
+                              int curve_id);
+/* the ECC peripheral driver wraps the same function */
+#ifdef WOLFSSL_ESP_ECC_HW
+    #define KP_ECC_MAKE_KEY esp_wolfssl_ecc_hw_make_key
+#else
+    #define KP_ECC_MAKE_KEY __real_wc_ecc_make_key_ex
+#endif
+#endif
+#ifdef HAVE_CURVE25519
+int __real_wc_curve25519_make_key(WC_RNG* rng, int keysize,
+                                  curve25519_key* key);
+#endif
+
+/* before any handshake, and before the scheduler starts on the device */
+static void __attribute__((constructor)) kp_init(void)
+{
+    kp_spin_ok = (esp_wolfssl_spin_init(&kp_spin) == 0);
+#ifdef WOLFSSL_ESPIDF
+    kp_task_mutex_ok = (wc_InitMutex(&kp_task_mutex) == 0);
+#endif
+}
+
+static int kp_lock(void)
+{
+    return kp_spin_ok && esp_wolfssl_spin_lock(&kp_spin);
+}
+
+static void kp_unlock(void)
+{
+    esp_wolfssl_spin_unlock(&kp_spin);
+}
+
+static int kp_group_on(int group)
+{
+    switch (group) {
+#ifdef KP_HAVE_X25519
+        case KP_X25519:
+            return 1;
+#endif
+#ifdef KP_HAVE_P256
+        case KP_P256:
+            return 1;
+#endif
+        default:
+            return 0;
+    }
+}
+
+#ifdef WOLFSSL_ESPIDF
+static void kp_refill_task(void* arg)
+{
+    (void)arg;
+
+    for (;;) {
+        (void)esp_wolfssl_keypool_fill();
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    }
+}
+#endif
+
+/* not under the lock: starting the task allocates */
+static int kp_refill_wake(void)
+{
+#ifdef WOLFSSL_ESPIDF
+    TaskHandle_t task = __atomic_load_n(&kp_task, __ATOMIC_ACQUIRE);
+    int ret = 0;
+
+    if (task != NULL) {
+        xTaskNotifyGive(task);
+        return 0;
+    }
+    if (!kp_task_mutex_ok || wc_LockMutex(&kp_task_mutex) != 0) {
+        return BAD_MUTEX_E;
+    }
+    if (kp_task == NULL) {
+        if (xTaskGetSchedulerState() != taskSCHEDULER_RUNNING
+                || xTaskCreate(kp_refill_task, "wolfssl_keypool",
+                               KP_TASK_STACK, NULL, tskIDLE_PRIORITY + 1,
+                               &task) != pdPASS) {
+            ret = MEMORY_E;
+        }
+        else {
+            __atomic_store_n(&kp_task, task, __ATOMIC_RELEASE);
+        }
+    }
+    wc_UnLockMutex(&kp_task_mutex);
+    return ret;
+#else
+    return 0;
+#endif
+}
+
+/* 1 with a key pair of the group in data, its slot wiped */
+static int kp_take(int group, byte* data)
+{
+    int found = 0;
+    int wake;
+    int i;
+
+    if (!kp_group_on(group) || !kp_lock()) {
+        return 0;
+    }
+    wake = kp_enabled;
+    if (kp_enabled) {
+        for (i = 0; i < ESP_WOLFSSL_KEYPOOL_KEYS; i++) {
+            kp_slot* s = &kp_slots[group][i];
+
+            if (s->ready) {
+                XMEMCPY(data, s->data, KP_DATA_SZ);
+                XMEMSET(s, 0, sizeof(*s));
+                found = 1;
+                break;
+            }
+        }
+        if (found) {
+            kp_stats.hits++;
+        }
+        else {
+            kp_stats.misses++;
+        }
+    }
+    kp_unlock();
+    if (wake) {
+        (void)kp_refill_wake();
+    }
+    return found;
+}
+
+/* 1 when the group has a free slot, which data, if not NULL, went into */
+static int kp_put(int group, const byte* data)
+{
+    int placed = 0;
+    int i;
+
+    if (!kp_lock()) {
+        return 0;
+    }
+    for (i = 0; kp_enabled && i < ESP_WOLFSSL_KEYPOOL_KEYS; i++) {
+        kp_slot* s = &kp_slots[group][i];
+
+        if (!s->ready) {
+            if (data != NULL) {
+                XMEMCPY(s->data, data, KP_DATA_SZ);
+                s->ready = 1;
+                kp_stats.generated++;
+            }
+            placed = 1;
+            break;
+        }
+    }
+    kp_unlock();
+    return placed;
+}
+
+static int kp_generate(int group, WC_RNG* rng, byte* data)
+{
+    word32 a = KP_FIELD_SZ;
+    word32 b = KP_FIELD_SZ;
+    word32 c = KP_FIELD_SZ;
+    int ret = BAD_FUNC_ARG;
+
+    (void)a;
+    (void)b;
+    (void)c;
+    (void)rng;
+    (void)data;
+
+#ifdef KP_HAVE_X25519
+    if (group == KP_X25519) {
+        curve25519_key key;
+
+        ret = wc_curve25519_init(&key);
+        if (ret == 0) {
+            ret = __real_wc_curve25519_make_key(rng, CURVE25519_KEYSIZE,
+                                                &key);
+            if (ret == 0) {
+                ret = wc_curve25519_export_key_raw(&key, data, &a,
+                                                   data + KP_FIELD_SZ, &b);
+            }
+            wc_curve25519_free(&key);
+        }
+    }
+#endif
+#ifdef KP_HAVE_P256
+    if (group == KP_P256) {
+        ecc_key* key = (ecc_key*)XMALLOC(sizeof(ecc_key), NULL,
+                                         DYNAMIC_TYPE_ECC);
+
+        if (key == NULL) {
+            return MEMORY_E;
+        }
+        ret = wc_ecc_init_ex(key, NULL, INVALID_DEVID);
+        if (ret == 0) {
+            ret = KP_ECC_MAKE_KEY(rng, KP_FIELD_SZ, key, ECC_SECP256R1);
+            if (ret == 0) {
+                ret = wc_ecc_export_private_raw(key, data + KP_FIELD_SZ, &a,
+                                                data + 2 * KP_FIELD_SZ, &b,
+                                                data, &c);
+            }
+            wc_ecc_free(key);
+        }
+        XFREE(key, NULL, DYNAMIC_TYPE_ECC);
+    }
+#endif
+    return ret;
+}
+
+int esp_wolfssl_keypool_fill(void)
+{
+    byte data[KP_DATA_SZ];
+    WC_RNG rng;
+    int group;
+    int ret;
+
+    ret = wc_InitRng(&rng);
+    if (ret != 0) {
+        return ret;
+    }
+    for (group = 0; ret == 0 && group < KP_GROUPS; group++) {
+        if (!kp_group_on(group)) {
+            continue;
+        }
+        /* generated without the lock; a key that finds the pool full
+         * again is dropped */
+        while (ret == 0 && kp_put(group, NULL)) {
+            ret = kp_generate(group, &rng, data);
+            if (ret == 0) {
+                (void)kp_put(group, data);
+            }
+            XMEMSET(data, 0, sizeof(data));
+        }
+    }
+    wc_FreeRng(&rng);
+    return ret;
+}
+
+int esp_wolfssl_keypool_start(void)
+{
+#ifdef WOLFSSL_ESPIDF
+    return kp_refill_wake();
+#else
+    return esp_wolfssl_keypool_fill();
+#endif
+}
+
+void esp_wolfssl_keypool_set_enabled(int enabled)
+{
+    if (!kp_lock()) {
+        return;
+    }
+    kp_enabled = enabled;
+    if (!enabled) {
+        XMEMSET(kp_slots, 0, sizeof(kp_slots));
+    }
+    kp_unlock();
+}
+
+void esp_wolfssl_keypool_clear(void)
+{
+    if (!kp_lock()) {
+        return;
+    }
+    XMEMSET(kp_slots, 0, sizeof(kp_slots));
+    kp_unlock();
+}
+
+void esp_wolfssl_keypool_get_stats(esp_wolfssl_keypool_stats_t* stats)
+{
+    if (stats == NULL) {
+        return;
+    }
+    if (!kp_lock()) {
+        XMEMSET(stats, 0, sizeof(*stats));
+        return;
+    }
+    *stats = kp_stats;
+    kp_unlock();
+}
+
+void esp_wolfssl_keypool_reset_stats(void)
+{
+    if (!kp_lock()) {
+        return;
+    }
+    XMEMSET(&kp_stats, 0, sizeof(kp_stats));
+    kp_unlock();
+}
+
+#ifdef HAVE_ECC
+int esp_wolfssl_keypool_ecc_make_key(WC_RNG* rng, int keysize, ecc_key* key,
+                                     int curve_id)
+{
+    byte data[KP_DATA_SZ];
+    int ret;
+
+    if (key != NULL
+            && (curve_id == ECC_SECP256R1
+                || (curve_id == ECC_CURVE_DEF && keysize == KP_FIELD_SZ))
+            && kp_take(KP_P256, data)) {
+        ret = wc_ecc_import_unsigned(key, data + KP_FIELD_SZ,
+                                     data + 2 * KP_FIELD_SZ, data,
+                                     ECC_SECP256R1);
+        XMEMSET(data, 0, sizeof(data));
+        if (ret == 0) {
+            return 0;
+        }
+    }
+    return KP_ECC_MAKE_KEY(rng, keysize, key, curve_id);
+}
+#endif
+
+#ifdef HAVE_CURVE25519
+int esp_wolfssl_keypool_x25519_make_key(WC_RNG* rng, int keysize,
+                                        curve25519_key* key)
+{
+    byte data[KP_DATA_SZ];
+    int ret;
+
+    if (key != NULL && keysize == CURVE25519_KEYSIZE
+            && kp_take(KP_X25519, data)) {
+        ret = wc_curve25519_import_private_raw(data, KP_FIELD_SZ,
+                                               data + KP_FIELD_SZ,
+                                               KP_FIELD_SZ, key);
+        XMEMSET(data, 0, sizeof(data));
+        if (ret == 0) {
+            return 0;
+        }
+    }
+    return __real_wc_curve25519_make_key(rng, keysize, key);
+}
+#endif
+
+/* with tracing on, its wrappers of the same functions call the ones above */
+#ifndef WOLFSSL_ESP_TRACE
+#ifdef HAVE_ECC
+int __wrap_wc_ecc_make_key_ex(WC_RNG* rng, int keysize, ecc_key* key,
+                              int curve_id);
+int __wrap_wc_ecc_make_key_ex(WC_RNG* rng, int keysize, ecc_key* key,
+                              int curve_id)
+{
+    return esp_wolfssl_keypool_ecc_make_key(rng, keysize, key, curve_id);
+}
+#endif
+
+#ifdef HAVE_CURVE25519
+int __wrap_wc_curve25519_make_key(WC_RNG* rng, int keysize,
+                                  curve25519_key* key);
+int __wrap_wc_curve25519_make_key(WC_RNG* rng, int keysize,
+                                  curve25519_key* key)
+{
+    return esp_wolfssl_keypool_x25519_make_key(rng, keysize, key);
+}
+#endif
+#endif /* !WOLFSSL_ESP_TRACE */
+
+#endif /* WOLFSSL_ESP_KEYPOOL */
@@ -0,0 +1,106 @@
+/* esp_wolfssl_keypool.h
+ *
+ * Copyright (C) 2006-2024 wolfSSL Inc.
+ *
+ * This file is part of wolfSSL.
+ *
+ * wolfSSL is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfSSL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335, USA
+ */
+
+/* Pool of pre-generated ephemeral key pairs.
+ *
+ * Enabled with Kconfig WOLFSSL_KEYPOOL. Every (EC)DHE handshake generates
+ * an ephemeral key pair on each side, for TLS 1.3 while building the
+ * ClientHello, which puts a scalar multiplication on the critical path of
+ * every connect. The pool keeps ESP_WOLFSSL_KEYPOOL_KEYS key pairs per
+ * group (X25519, P-256) generated ahead of time by a task just above the
+ * idle priority, and wc_curve25519_make_key() and wc_ecc_make_key_ex(),
+ * which are linker wrapped, hand out one of them instead of generating a
+ * key. A key pair is removed from the pool and its slot wiped when it is
+ * handed out, so no key is used twice; with the pool empty a key is
+ * generated as before. The refill task starts on first use, or earlier
+ * with esp_wolfssl_keypool_start(), so a device that idles before it
+ * connects has the pool full.
+ *
+ * Any key generated with these two functions comes from the pool, also
+ * one the application makes; a pooled key is as fresh as one generated on
+ * the spot, as it was never handed out before.
+ */
+
+#ifndef _ESP_WOLFSSL_KEYPOOL_H_
+#define _ESP_WOLFSSL_KEYPOOL_H_
+
+#include <stdint.h>
+
+#include <wolfssl/wolfcrypt/settings.h>
+#include <wolfssl/wolfcrypt/random.h>
+#ifdef HAVE_ECC
+    #include <wolfssl/wolfcrypt/ecc.h>
+#endif
+#ifdef HAVE_CURVE25519
+    #include <wolfssl/wolfcrypt/curve25519.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* key pairs kept per group */
+#ifndef ESP_WOLFSSL_KEYPOOL_KEYS
+    #define ESP_WOLFSSL_KEYPOOL_KEYS 2
+#endif
+
+typedef struct esp_wolfssl_keypool_stats_t {
+    uint32_t hits;          /* keys handed out from the pool */
+    uint32_t misses;        /* generated on the spot, pool empty */
+    uint32_t generated;     /* ahead of time */
+} esp_wolfssl_keypool_stats_t;
+
+#ifdef WOLFSSL_ESP_KEYPOOL
+
+/* Starts the refill task, which fills the pool right away.
+ * Returns 0 or an error. */
+int esp_wolfssl_keypool_start(void);
+
+/* Fills the pool in the calling task. Returns 0 or an error. */
+int esp_wolfssl_keypool_fill(void);
+
+/* 0 generates every key on the spot, for comparison; on by default */
+void esp_wolfssl_keypool_set_enabled(int enabled);
+
+/* Wipes all pooled keys. */
+void esp_wolfssl_keypool_clear(void);
+
+void esp_wolfssl_keypool_get_stats(esp_wolfssl_keypool_stats_t* stats);
+void esp_wolfssl_keypool_reset_stats(void);
+
+/* what the wrapped key generation functions run; for other wrappers of
+ * the same functions, see esp_wolfssl_trace.c */
+#ifdef HAVE_ECC
+int esp_wolfssl_keypool_ecc_make_key(WC_RNG* rng, int keysize, ecc_key* key,
+                                     int curve_id);
+#endif
+#ifdef HAVE_CURVE25519
+int esp_wolfssl_keypool_x25519_make_key(WC_RNG* rng, int keysize,
+                                        curve25519_key* key);
+#endif
+
+#endif /* WOLFSSL_ESP_KEYPOOL */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _ESP_WOLFSSL_KEYPOOL_H_ */
@@ -0,0 +1,161 @@
+/* esp_wolfssl_lock.h
+ *
+ * Copyright (C) 2006-2024 wolfSSL Inc.
+ *
+ * This file is part of wolfSSL.
+ *
+ * wolfSSL is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfSSL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335, USA
+ */
+
+/* Locks for critical sections of a few instructions.
+ *
+ * wolfSSL maps every wolfSSL_Mutex onto a FreeRTOS semaphore, so a
+ * counter update or a slot claim costs two kernel calls and, under
+ * contention, a context switch. With Kconfig WOLFSSL_LIGHT_LOCKS an
+ * esp_wolfssl_spin_t is a critical section with a spinlock instead
+ * (portENTER_CRITICAL, which also holds off interrupts on this core) and
+ * wolfSSL's reference counts of contexts, sessions and certificates use
+ * atomics (WOLFSSL_ATOMIC_OPS). Without it an esp_wolfssl_spin_t is a
+ * wolfSSL mutex, so the code using it is the same either way.
+ *
+ * A spin-locked region must not block, allocate, log or call into
+ * wolfCrypt, and should be over within a microsecond or so: copy in or
+ * out, bump a counter, claim a slot. Anything longer, such as a DRBG
+ * refill, an AEAD or a certificate decode, stays on a wolfSSL mutex.
+ */
+
+#ifndef _ESP_WOLFSSL_LOCK_H_
+#define _ESP_WOLFSSL_LOCK_H_
+
+#include <wolfssl/wolfcrypt/settings.h>
+#include <wolfssl/wolfcrypt/wc_port.h>
+
+#ifdef WOLFSSL_ESP_LIGHT_LOCKS
+    #ifdef WOLFSSL_ESPIDF
+        #include <freertos/FreeRTOS.h>
+        #include <freertos/task.h>
+    #else
+        #include <sched.h>
+    #endif
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if !defined(WOLFSSL_ESP_LIGHT_LOCKS)
+
+typedef wolfSSL_Mutex esp_wolfssl_spin_t;
+
+static inline int esp_wolfssl_spin_init(esp_wolfssl_spin_t* s)
+{
+    return wc_InitMutex(s);
+}
+
+/* 1 when held */
+static inline int esp_wolfssl_spin_lock(esp_wolfssl_spin_t* s)
+{
+    return wc_LockMutex(s) == 0;
+}
+
+static inline void esp_wolfssl_spin_unlock(esp_wolfssl_spin_t* s)
+{
+    wc_UnLockMutex(s);
+}
+
+#elif defined(WOLFSSL_ESPIDF) && defined(CONFIG_IDF_TARGET_ESP8266)
+
+/* single core: the critical section alone */
+typedef int esp_wolfssl_spin_t;
+
+static inline int esp_wolfssl_spin_init(esp_wolfssl_spin_t* s)
+{
+    *s = 0;
+    return 0;
+}
+
+static inline int esp_wolfssl_spin_lock(esp_wolfssl_spin_t* s)
+{
+    (void)s;
+    taskENTER_CRITICAL();
+    return 1;
+}
+
+static inline void esp_wolfssl_spin_unlock(esp_wolfssl_spin_t* s)
+{
+    (void)s;
+    taskEXIT_CRITICAL();
+}
+
+#elif defined(WOLFSSL_ESPIDF)
+
+typedef portMUX_TYPE esp_wolfssl_spin_t;
+
+static inline int esp_wolfssl_spin_init(esp_wolfssl_spin_t* s)
+{
+    portMUX_INITIALIZE(s);
+    return 0;
+}
+
+static inline int esp_wolfssl_spin_lock(esp_wolfssl_spin_t* s)
+{
+    portENTER_CRITICAL(s);
+    return 1;
+}
+
+static inline void esp_wolfssl_spin_unlock(esp_wolfssl_spin_t* s)
+{
+    portEXIT_CRITICAL(s);
+}
+
+#else
+
+/* host builds: test-and-set, yielding to a preempted holder now and then */
+typedef struct esp_wolfssl_spin_t {
+    unsigned char locked;
+} esp_wolfssl_spin_t;
+
+static inline int esp_wolfssl_spin_init(esp_wolfssl_spin_t* s)
+{
+    __atomic_clear(&s->locked, __ATOMIC_RELAXED);
+    return 0;
+}
+
+static inline int esp_wolfssl_spin_lock(esp_wolfssl_spin_t* s)
+{
+    unsigned spins = 0;
+
+    while (__atomic_test_and_set(&s->locked, __ATOMIC_ACQUIRE)) {
+        while (__atomic_load_n(&s->locked, __ATOMIC_RELAXED)) {
+            if (++spins % 64 == 0) {
+                sched_yield();
+            }
+        }
+    }
+    return 1;
+}
+
+static inline void esp_wolfssl_spin_unlock(esp_wolfssl_spin_t* s)
+{
+    __atomic_clear(&s->locked, __ATOMIC_RELEASE);
+}
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _ESP_WOLFSSL_LOCK_H_ */
@@ -0,0 +1,774 @@
+/* esp_wolfssl_mem.c
+ *
+ * Copyright (C) 2006-2024 wolfSSL Inc.
+ *
+ * This file is part of wolfSSL.
+ *
+ * wolfSSL is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfSSL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335, USA
+ */
+
+#include <wolfssl/wolfcrypt/settings.h>
+
+#ifdef WOLFSSL_ESP_MEM_ACCOUNTING
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef WOLFSSL_ESPIDF
+    #include <esp_log.h>
+    #include <freertos/FreeRTOS.h>
+
+    /* same native heap as the default ESP-IDF XMALLOC in settings.h */
+    #define MEM_NATIVE_MALLOC(n)     pvPortMalloc((n))
+    #define MEM_NATIVE_FREE(p)       vPortFree((p))
+    #define MEM_NATIVE_REALLOC(p, n) realloc((p), (n))
+#else
+    #define MEM_NATIVE_MALLOC(n)     malloc((n))
+    #define MEM_NATIVE_FREE(p)       free((p))
+    #define MEM_NATIVE_REALLOC(p, n) realloc((p), (n))
+
+    #define ESP_LOGE(tag, fmt, ...) \
+                fprintf(stderr, "E %s: " fmt "\n", tag, ##__VA_ARGS__)
+    #define ESP_LOGW(tag, fmt, ...) \
+                fprintf(stderr, "W %s: " fmt "\n", tag, ##__VA_ARGS__)
+    #define ESP_LOGI(tag, fmt, ...) \
+                printf("I %s: " fmt "\n", tag, ##__VA_ARGS__)
+#endif
+
+#include "esp_wolfssl_mem.h"
+
+#ifdef WOLFSSL_ESP_MEM_AUTO
+    #include <wolfssl/ssl.h>
+    #include <wolfssl/internal.h>
+    #ifdef WOLFSSL_ESP_HMAC_CACHE
+        #include "esp_wolfssl_hmac_cache.h"
+    #endif
+#endif
+
+#if ESP_WOLFSSL_MEM_DOMAINS < 1 || ESP_WOLFSSL_MEM_DOMAINS > 254
+    #error "ESP_WOLFSSL_MEM_DOMAINS must be between 1 and 254"
+#endif
+
+static const char* const TAG = "wolfssl_mem";
+
+/* Every allocation is prefixed with this header. The header size keeps the
+ * alignment of the native allocator (4 or 8 on target, 16 on 64-bit hosts) */
+typedef struct mem_hdr {
+    uint32_t size;
+    uint16_t type;
+    uint8_t  domain;
+    uint8_t  magic;
+} mem_hdr;
+
+#define MEM_HDR_SZ     (sizeof(void*) > 4 ? 16 : sizeof(mem_hdr))
+#define MEM_HDR_MAGIC  0x5A
+#define MEM_MAX_DEPTH  4
+
+#define MEM_DOMAIN_FREE     0
+#define MEM_DOMAIN_ACTIVE   1
+#define MEM_DOMAIN_RELEASED 2
+#define MEM_DOMAIN_CLAIMED  3   /* being reset by _create() */
+
+typedef struct mem_type_slot {
+    uint32_t key;       /* (uint16_t)type + 1; 0 while unused */
+    uint32_t current;
+    uint32_t peak;
+    uint32_t allocs;
+} mem_type_slot;
+
+typedef struct mem_domain {
+    uint32_t    state;
+    int         parent;
+    const char* name;
+    const void* owner;  /* WOLFSSL_CTX or WOLFSSL of an automatic domain */
+    uint32_t    current;
+    uint32_t    peak;
+    uint32_t    allocs;
+    uint32_t    frees;
+    uint32_t    failures;
+    mem_type_slot types[ESP_WOLFSSL_MEM_TYPE_SLOTS];
+} mem_domain;
+
+static mem_domain mem_domains[ESP_WOLFSSL_MEM_DOMAINS + 1] = {
+    [ESP_WOLFSSL_MEM_DOMAIN_GLOBAL] = {
+        .state  = MEM_DOMAIN_ACTIVE,
+        .parent = -1,
+        .name   = "global",
+    },
+};
+
+/* current domain of the calling task */
+static __thread int mem_current_domain = ESP_WOLFSSL_MEM_DOMAIN_GLOBAL;
+
+static void mem_add_peak(uint32_t* current, uint32_t* peak, uint32_t n)
+{
+    uint32_t now = __atomic_add_fetch(current, n, __ATOMIC_RELAXED);
+    uint32_t old = __atomic_load_n(peak, __ATOMIC_RELAXED);
+
+    while (now > old) {
+        if (__atomic_compare_exchange_n(peak, &old, now, 1,
+                                        __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+            break;
+        }
+    }
+}
+
+static mem_type_slot* mem_type_slot_get(mem_domain* d, int type)
+{
+    uint32_t key = (uint32_t)(uint16_t)type + 1;
+    uint32_t expected;
+    uint32_t k;
+    int i;
+    mem_type_slot* slot;
+
+    for (i = 0; i < ESP_WOLFSSL_MEM_TYPE_SLOTS; i++) {
+        slot = &d->types[(key + i) % ESP_WOLFSSL_MEM_TYPE_SLOTS];
+        k = __atomic_load_n(&slot->key, __ATOMIC_ACQUIRE);
+        if (k == key) {
+            return slot;
+        }
+        if (k == 0) {
+            expected = 0;
+            if (__atomic_compare_exchange_n(&slot->key, &expected, key, 0,
+                                            __ATOMIC_ACQ_REL,
+                                            __ATOMIC_ACQUIRE)
+                || expected == key) {
+                return slot;
+            }
+        }
+    }
+
+    return NULL;
+}
+
+static void mem_charge(int id, int type, uint32_t size, uint32_t count)
+{
+    int depth;
+    mem_domain* d;
+    mem_type_slot* slot;
+
+    for (depth = 0; id >= 0 && depth <= MEM_MAX_DEPTH; depth++) {
+        d = &mem_domains[id];
+        mem_add_peak(&d->current, &d->peak, size);
+        __atomic_add_fetch(&d->allocs, count, __ATOMIC_RELAXED);
+
+        slot = mem_type_slot_get(d, type);
+        if (slot != NULL) {
+            mem_add_peak(&slot->current, &slot->peak, size);
+            __atomic_add_fetch(&slot->allocs, count, __ATOMIC_RELAXED);
+        }
+        id = d->parent;
+    }
+}
+
+static void mem_credit(int id, int type, uint32_t size, uint32_t count)
+{
+    int depth;
+    mem_domain* d;
+    mem_type_slot* slot;
+
+    for (depth = 0; id >= 0 && depth <= MEM_MAX_DEPTH; depth++) {
+        d = &mem_domains[id];
+        __atomic_sub_fetch(&d->current, size, __ATOMIC_RELAXED);
+        __atomic_add_fetch(&d->frees, count, __ATOMIC_RELAXED);
+
+        slot = mem_type_slot_get(d, type);
+        if (slot != NULL) {
+            __atomic_sub_fetch(&slot->current, size, __ATOMIC_RELAXED);
+        }
+        id = d->parent;
+    }
+}
+
+static void mem_fail(int id, int type, size_t size)
+{
+    int depth;
+
+    for (depth = 0; id >= 0 && depth <= MEM_MAX_DEPTH; depth++) {
+        __atomic_add_fetch(&mem_domains[id].failures, 1, __ATOMIC_RELAXED);
+        id = mem_domains[id].parent;
+    }
+
+#ifdef DEBUG_WOLFSSL_MALLOC
+    ESP_LOGE(TAG, "malloc failed: %u bytes, type %d", (unsigned)size, type);
+#else
+    (void)type;
+    (void)size;
+#endif
+}
+
+static int mem_domain_valid(int id)
+{
+    uint32_t state;
+
+    if (id < 0 || id > ESP_WOLFSSL_MEM_DOMAINS) {
+        return 0;
+    }
+    state = __atomic_load_n(&mem_domains[id].state, __ATOMIC_ACQUIRE);
+    return state == MEM_DOMAIN_ACTIVE || state == MEM_DOMAIN_RELEASED;
+}
+
+/* An owner is allocated inside its own domain, so the header in front of
+ * it names the domain; the owner field confirms it, as any other pointer
+ * can come in as a heap hint. */
+int esp_wolfssl_mem_domain_of(const void* obj)
+{
+    const mem_hdr* hdr;
+    int id;
+
+    if (obj == NULL) {
+        return -1;
+    }
+    hdr = (const mem_hdr*)((const unsigned char*)obj - MEM_HDR_SZ);
+    if (hdr->magic != MEM_HDR_MAGIC) {
+        return -1;
+    }
+    id = hdr->domain;
+    if (id < 1 || id > ESP_WOLFSSL_MEM_DOMAINS
+        || __atomic_load_n(&mem_domains[id].owner, __ATOMIC_ACQUIRE)
+               != obj) {
+        return -1;
+    }
+    return id;
+}
+
+void* esp_wolfssl_malloc(size_t size, void* heap, int type)
+{
+    int id = mem_current_domain;
+    mem_hdr* hdr;
+
+#ifdef WOLFSSL_ESP_MEM_AUTO
+    /* wolfSSL passes ctx->heap, which is the context itself, with every
+     * allocation it makes for the context and its connections; the
+     * connection's own work runs with its domain entered */
+    if (id == ESP_WOLFSSL_MEM_DOMAIN_GLOBAL && heap != NULL) {
+        int owner = esp_wolfssl_mem_domain_of(heap);
+        if (owner > 0) {
+            id = owner;
+        }
+    }
+#else
+    (void)heap;
+#endif
+
+    if (size > UINT32_MAX - MEM_HDR_SZ) {
+        mem_fail(id, type, size);
+        return NULL;
+    }
+
+    hdr = (mem_hdr*)MEM_NATIVE_MALLOC(size + MEM_HDR_SZ);
+    if (hdr == NULL) {
+        mem_fail(id, type, size);
+        return NULL;
+    }
+
+    hdr->size   = (uint32_t)size;
+    hdr->type   = (uint16_t)type;
+    hdr->domain = (uint8_t)id;
+    hdr->magic  = MEM_HDR_MAGIC;
+    mem_charge(id, type, (uint32_t)size, 1);
+
+    return (unsigned char*)hdr + MEM_HDR_SZ;
+}
+
+void esp_wolfssl_free(void* ptr, void* heap, int type)
+{
+    mem_hdr* hdr;
+
+    (void)heap;
+    (void)type;
+
+    if (ptr == NULL) {
+        return;
+    }
+
+    hdr = (mem_hdr*)((unsigned char*)ptr - MEM_HDR_SZ);
+    if (hdr->magic != MEM_HDR_MAGIC) {
+        /* not ours, or double free: leave the heap to catch it */
+        ESP_LOGE(TAG, "free of unknown block %p", ptr);
+        return;
+    }
+    /* credit the type recorded at allocation time; callers do not always
+     * free with the same DYNAMIC_TYPE_* */
+    mem_credit(hdr->domain, hdr->type, hdr->size, 1);
+    hdr->magic = 0;
+    MEM_NATIVE_FREE(hdr);
+}
+
+void* esp_wolfssl_realloc(void* ptr, size_t size, void* heap, int type)
+{
+    mem_hdr* hdr;
+    mem_hdr* newHdr;
+    uint32_t oldSize;
+    int id;
+
+    if (ptr == NULL) {
+        return esp_wolfssl_malloc(size, heap, type);
+    }
+    if (size == 0) {
+        esp_wolfssl_free(ptr, heap, type);
+        return NULL;
+    }
+
+    hdr = (mem_hdr*)((unsigned char*)ptr - MEM_HDR_SZ);
+    id = hdr->domain;
+    if (size > UINT32_MAX - MEM_HDR_SZ) {
+        mem_fail(id, type, size);
+        return NULL;
+    }
+
+    oldSize = hdr->size;
+    newHdr = (mem_hdr*)MEM_NATIVE_REALLOC(hdr, size + MEM_HDR_SZ);
+    if (newHdr == NULL) {
+        mem_fail(id, type, size);
+        return NULL;
+    }
+
+    /* a resize keeps the original domain and type */
+    mem_credit(id, newHdr->type, oldSize, 0);
+    mem_charge(id, newHdr->type, (uint32_t)size, 0);
+    newHdr->size = (uint32_t)size;
+
+    return (unsigned char*)newHdr + MEM_HDR_SZ;
+}
+
+int esp_wolfssl_mem_domain_create(const char* name, int parent)
+{
+    int id;
+    int i;
+    uint32_t expected;
+    mem_domain* d;
+
+    if (!mem_domain_valid(parent)) {
+        parent = ESP_WOLFSSL_MEM_DOMAIN_GLOBAL;
+    }
+
+    for (id = 1; id <= ESP_WOLFSSL_MEM_DOMAINS; id++) {
+        d = &mem_domains[id];
+
+        /* claimed, not yet active: nothing is charged to the slot while
+         * it is reset */
+        expected = MEM_DOMAIN_FREE;
+        if (!__atomic_compare_exchange_n(&d->state, &expected,
+                                         MEM_DOMAIN_CLAIMED, 0,
+                                         __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+            /* a released domain is reusable once fully drained */
+            if (expected != MEM_DOMAIN_RELEASED
+                || __atomic_load_n(&d->current, __ATOMIC_ACQUIRE) != 0
+                || !__atomic_compare_exchange_n(&d->state, &expected,
+                                                MEM_DOMAIN_CLAIMED, 0,
+                                                __ATOMIC_ACQ_REL,
+                                                __ATOMIC_ACQUIRE)) {
+                continue;
+            }
+        }
+
+        d->parent = parent;
+        d->name   = (name != NULL) ? name : "";
+        __atomic_store_n(&d->owner, NULL, __ATOMIC_RELAXED);
+        __atomic_store_n(&d->current, 0, __ATOMIC_RELAXED);
+        __atomic_store_n(&d->peak, 0, __ATOMIC_RELAXED);
+        __atomic_store_n(&d->allocs, 0, __ATOMIC_RELAXED);
+        __atomic_store_n(&d->frees, 0, __ATOMIC_RELAXED);
+        __atomic_store_n(&d->failures, 0, __ATOMIC_RELAXED);
+        for (i = 0; i < ESP_WOLFSSL_MEM_TYPE_SLOTS; i++) {
+            __atomic_store_n(&d->types[i].key, 0, __ATOMIC_RELAXED);
+            __atomic_store_n(&d->types[i].current, 0, __ATOMIC_RELAXED);
+            __atomic_store_n(&d->types[i].peak, 0, __ATOMIC_RELAXED);
+            __atomic_store_n(&d->types[i].allocs, 0, __ATOMIC_RELAXED);
+        }
+        __atomic_store_n(&d->state, MEM_DOMAIN_ACTIVE, __ATOMIC_RELEASE);
+        return id;
+    }
+
+    return -1;
+}
+
+void esp_wolfssl_mem_domain_release(int id)
+{
+    if (id > ESP_WOLFSSL_MEM_DOMAIN_GLOBAL && mem_domain_valid(id)) {
+        __atomic_store_n(&mem_domains[id].owner, NULL, __ATOMIC_RELEASE);
+        __atomic_store_n(&mem_domains[id].state, MEM_DOMAIN_RELEASED,
+                         __ATOMIC_RELEASE);
+    }
+}
+
+int esp_wolfssl_mem_domain_enter(int id)
+{
+    int prev = mem_current_domain;
+
+    if (mem_domain_valid(id) && __atomic_load_n(&mem_domains[id].state,
+                                    __ATOMIC_ACQUIRE) == MEM_DOMAIN_ACTIVE) {
+        mem_current_domain = id;
+    }
+    return prev;
+}
+
+void esp_wolfssl_mem_domain_leave(int prev)
+{
+    mem_current_domain = mem_domain_valid(prev) ?
+                             prev : ESP_WOLFSSL_MEM_DOMAIN_GLOBAL;
+}
+
+int esp_wolfssl_mem_get_stats(int id, esp_wolfssl_mem_stats_t* stats)
+{
+    mem_domain* d;
+    uint32_t key;
+    int i;
+
+    if (stats == NULL || !mem_domain_valid(id)) {
+        return -1;
+    }
+
+    d = &mem_domains[id];
+    memset(stats, 0, sizeof(*stats));
+    stats->name     = d->name;
+    stats->parent   = d->parent;
+    stats->current  = __atomic_load_n(&d->current,  __ATOMIC_RELAXED);
+    stats->peak     = __atomic_load_n(&d->peak,     __ATOMIC_RELAXED);
+    stats->allocs   = __atomic_load_n(&d->allocs,   __ATOMIC_RELAXED);
+    stats->frees    = __atomic_load_n(&d->frees,    __ATOMIC_RELAXED);
+    stats->failures = __atomic_load_n(&d->failures, __ATOMIC_RELAXED);
+
+    for (i = 0; i < ESP_WOLFSSL_MEM_TYPE_SLOTS; i++) {
+        key = __atomic_load_n(&d->types[i].key, __ATOMIC_ACQUIRE);
+        if (key == 0) {
+            continue;
+        }
+        stats->types[stats->type_count].type    = (int)(key - 1);
+        stats->types[stats->type_count].current =
+                  __atomic_load_n(&d->types[i].current, __ATOMIC_RELAXED);
+        stats->types[stats->type_count].peak    =
+                  __atomic_load_n(&d->types[i].peak,    __ATOMIC_RELAXED);
+        stats->types[stats->type_count].allocs  =
+                  __atomic_load_n(&d->types[i].allocs,  __ATOMIC_RELAXED);
+        stats->type_count++;
+    }
+
+    return 0;
+}
+
+void esp_wolfssl_mem_reset_peak(int id)
+{
+    mem_domain* d;
+    int i;
+
+    if (!mem_domain_valid(id)) {
+        return;
+    }
+
+    d = &mem_domains[id];
+    __atomic_store_n(&d->peak, __atomic_load_n(&d->current, __ATOMIC_RELAXED),
+                     __ATOMIC_RELAXED);
+    for (i = 0; i < ESP_WOLFSSL_MEM_TYPE_SLOTS; i++) {
+        __atomic_store_n(&d->types[i].peak,
+                         __atomic_load_n(&d->types[i].current,
+                                         __ATOMIC_RELAXED),
+                         __ATOMIC_RELAXED);
+    }
+}
+
+/* snprintf into buf at *pos, failing once the buffer is exhausted */
+static int mem_json_put(char* buf, size_t bufSz, size_t* pos,
+                        const char* fmt, ...)
+    __attribute__((format(printf, 4, 5)));
+
+static int mem_json_put(char* buf, size_t bufSz, size_t* pos,
+                        const char* fmt, ...)
+{
+    va_list args;
+    int n;
+
+    if (*pos >= bufSz) {
+        return -1;
+    }
+    va_start(args, fmt);
+    n = vsnprintf(buf + *pos, bufSz - *pos, fmt, args);
+    va_end(args);
+    if (n < 0 || (size_t)n >= bufSz - *pos) {
+        return -1;
+    }
+    *pos += (size_t)n;
+    return 0;
+}
+
+static int mem_domain_json(int id, char* buf, size_t bufSz, size_t* pos)
+{
+    esp_wolfssl_mem_stats_t stats;
+    int ret;
+    int i;
+
+    if (esp_wolfssl_mem_get_stats(id, &stats) != 0) {
+        return -1;
+    }
+
+    ret = mem_json_put(buf, bufSz, pos,
+              "{\"id\":%d,\"name\":\"%s\",\"parent\":%d,"
+              "\"current\":%u,\"peak\":%u,\"allocs\":%u,\"frees\":%u,"
+              "\"failures\":%u,\"types\":[",
+              id, stats.name, stats.parent,
+              (unsigned)stats.current, (unsigned)stats.peak,
+              (unsigned)stats.allocs, (unsigned)stats.frees,
+              (unsigned)stats.failures);
+
+    for (i = 0; ret == 0 && i < stats.type_count; i++) {
+        ret = mem_json_put(buf, bufSz, pos,
+                  "%s{\"type\":%d,\"current\":%u,\"peak\":%u,\"allocs\":%u}",
+                  (i == 0) ? "" : ",", stats.types[i].type,
+                  (unsigned)stats.types[i].current,
+                  (unsigned)stats.types[i].peak,
+                  (unsigned)stats.types[i].allocs);
+    }
+
+    if (ret == 0) {
+        ret = mem_json_put(buf, bufSz, pos, "]}");
+    }
+    return ret;
+}
+
+int esp_wolfssl_mem_to_json(int id, char* buf, size_t bufSz)
+{
+    size_t pos = 0;
+    int ret = 0;
+    int first = 1;
+    int i;
+
+    if (buf == NULL || bufSz == 0) {
+        return -1;
+    }
+
+    if (id != ESP_WOLFSSL_MEM_DOMAIN_ALL) {
+        ret = mem_domain_json(id, buf, bufSz, &pos);
+    }
+    else {
+        ret = mem_json_put(buf, bufSz, &pos, "[");
+        for (i = 0; ret == 0 && i <= ESP_WOLFSSL_MEM_DOMAINS; i++) {
+            if (__atomic_load_n(&mem_domains[i].state, __ATOMIC_ACQUIRE)
+                                                    != MEM_DOMAIN_ACTIVE) {
+                continue;
+            }
+            if (!first) {
+                ret = mem_json_put(buf, bufSz, &pos, ",");
+            }
+            if (ret == 0) {
+                ret = mem_domain_json(i, buf, bufSz, &pos);
+            }
+            first = 0;
+        }
+        if (ret == 0) {
+            ret = mem_json_put(buf, bufSz, &pos, "]");
+        }
+    }
+
+    return (ret == 0) ? (int)pos : -1;
+}
+
+void esp_wolfssl_mem_log(int id)
+{
+    /* static: the log task usually has little stack to spare */
+    static char json[1024];
+
+    if (esp_wolfssl_mem_to_json(id, json, sizeof(json)) < 0) {
+        ESP_LOGW(TAG, "domain %d: invalid or JSON truncated", id);
+        return;
+    }
+    ESP_LOGI(TAG, "%s", json);
+}
+
+#ifdef WOLFSSL_ESP_MEM_AUTO
+/*
+ * A domain per WOLFSSL_CTX and per WOLFSSL, made by the wrappers of their
+ * constructors. The object is allocated inside its domain. What wolfSSL
+ * allocates for a context later carries it as the heap hint; a connection
+ * shares its context's hint, so the wrappers of its handshake and I/O
+ * functions enter its domain instead.
+ */
+
+extern WOLFSSL_CTX* __real_wolfSSL_CTX_new(WOLFSSL_METHOD* method);
+extern WOLFSSL* __real_wolfSSL_new(WOLFSSL_CTX* ctx);
+extern void __real_wolfSSL_CTX_free(WOLFSSL_CTX* ctx);
+extern void __real_wolfSSL_free(WOLFSSL* ssl);
+extern int __real_wolfSSL_read(WOLFSSL* ssl, void* data, int sz);
+extern int __real_wolfSSL_write(WOLFSSL* ssl, const void* data, int sz);
+extern int __real_wolfSSL_shutdown(WOLFSSL* ssl);
+
+WOLFSSL_CTX* esp_wolfssl_mem_ctx_new(WOLFSSL_METHOD* method)
+{
+    WOLFSSL_CTX* ctx;
+    int id;
+    int prev;
+
+    id = esp_wolfssl_mem_domain_create("ctx", mem_current_domain);
+    if (id < 0) {
+        /* all domains in use: charged as without them */
+        return __real_wolfSSL_CTX_new(method);
+    }
+    prev = esp_wolfssl_mem_domain_enter(id);
+    ctx = __real_wolfSSL_CTX_new(method);
+    esp_wolfssl_mem_domain_leave(prev);
+
+    if (ctx == NULL) {
+        esp_wolfssl_mem_domain_release(id);
+        return NULL;
+    }
+    __atomic_store_n(&mem_domains[id].owner, (const void*)ctx,
+                     __ATOMIC_RELEASE);
+    return ctx;
+}
+
+WOLFSSL* esp_wolfssl_mem_ssl_new(WOLFSSL_CTX* ctx)
+{
+    WOLFSSL* ssl;
+    int parent = esp_wolfssl_mem_domain_of(ctx);
+    int id;
+    int prev;
+
+    id = esp_wolfssl_mem_domain_create("ssl", (parent > 0) ? parent
+                                                 : mem_current_domain);
+    if (id < 0) {
+        return __real_wolfSSL_new(ctx);
+    }
+    prev = esp_wolfssl_mem_domain_enter(id);
+    ssl = __real_wolfSSL_new(ctx);
+    esp_wolfssl_mem_domain_leave(prev);
+
+    if (ssl == NULL) {
+        esp_wolfssl_mem_domain_release(id);
+        return NULL;
+    }
+    __atomic_store_n(&mem_domains[id].owner, (const void*)ssl,
+                     __ATOMIC_RELEASE);
+    return ssl;
+}
+
+int esp_wolfssl_mem_ssl_enter(const WOLFSSL* ssl)
+{
+    /* a domain the task entered itself takes precedence */
+    if (mem_current_domain != ESP_WOLFSSL_MEM_DOMAIN_GLOBAL) {
+        return mem_current_domain;
+    }
+    return esp_wolfssl_mem_domain_enter(esp_wolfssl_mem_domain_of(ssl));
+}
+
+/* One wrapper per symbol: with WOLFSSL_MLKEM_DEFAULT or
+ * WOLFSSL_HW_ORDER_DEFAULT the one in esp_wolfssl_pq.c or
+ * esp_wolfssl_hw_order.c calls esp_wolfssl_mem_ctx_new(), and with
+ * WOLFSSL_RPK_DEFAULT the one in esp_wolfssl_rpk.c calls
+ * esp_wolfssl_mem_ssl_new(). */
+#if !defined(WOLFSSL_ESP_PQ_DEFAULT) && !defined(WOLFSSL_ESP_HW_ORDER_DEFAULT)
+WOLFSSL_CTX* __wrap_wolfSSL_CTX_new(WOLFSSL_METHOD* method);
+WOLFSSL_CTX* __wrap_wolfSSL_CTX_new(WOLFSSL_METHOD* method)
+{
+    return esp_wolfssl_mem_ctx_new(method);
+}
+#endif
+
+#ifndef WOLFSSL_ESP_RPK_DEFAULT
+WOLFSSL* __wrap_wolfSSL_new(WOLFSSL_CTX* ctx);
+WOLFSSL* __wrap_wolfSSL_new(WOLFSSL_CTX* ctx)
+{
+    return esp_wolfssl_mem_ssl_new(ctx);
+}
+#endif
+
+/* with WOLFSSL_TRACE the wrappers in esp_wolfssl_trace.c enter the domain */
+#ifndef WOLFSSL_ESP_TRACE
+extern int __real_wolfSSL_connect(WOLFSSL* ssl);
+int __wrap_wolfSSL_connect(WOLFSSL* ssl);
+int __wrap_wolfSSL_connect(WOLFSSL* ssl)
+{
+    int prev = esp_wolfssl_mem_ssl_enter(ssl);
+    int ret = __real_wolfSSL_connect(ssl);
+
+    esp_wolfssl_mem_domain_leave(prev);
+    return ret;
+}
+
+#ifndef NO_WOLFSSL_SERVER
+extern int __real_wolfSSL_accept(WOLFSSL* ssl);
+int __wrap_wolfSSL_accept(WOLFSSL* ssl);
+int __wrap_wolfSSL_accept(WOLFSSL* ssl)
+{
+    int prev = esp_wolfssl_mem_ssl_enter(ssl);
+    int ret = __real_wolfSSL_accept(ssl);
+
+    esp_wolfssl_mem_domain_leave(prev);
+    return ret;
+}
+#endif
+#endif /* !WOLFSSL_ESP_TRACE */
+
+int __wrap_wolfSSL_read(WOLFSSL* ssl, void* data, int sz);
+int __wrap_wolfSSL_read(WOLFSSL* ssl, void* data, int sz)
+{
+    int prev = esp_wolfssl_mem_ssl_enter(ssl);
+    int ret = __real_wolfSSL_read(ssl, data, sz);
+
+    esp_wolfssl_mem_domain_leave(prev);
+    return ret;
+}
+
+int __wrap_wolfSSL_write(WOLFSSL* ssl, const void* data, int sz);
+int __wrap_wolfSSL_write(WOLFSSL* ssl, const void* data, int sz)
+{
+    int prev = esp_wolfssl_mem_ssl_enter(ssl);
+    int ret = __real_wolfSSL_write(ssl, data, sz);
+
+    esp_wolfssl_mem_domain_leave(prev);
+    return ret;
+}
+
+int __wrap_wolfSSL_shutdown(WOLFSSL* ssl);
+int __wrap_wolfSSL_shutdown(WOLFSSL* ssl)
+{
+    int prev = esp_wolfssl_mem_ssl_enter(ssl);
+    int ret = __real_wolfSSL_shutdown(ssl);
+
+    esp_wolfssl_mem_domain_leave(prev);
+    return ret;
+}
+
+/* the domain stays until the last of its allocations, such as a session
+ * kept in the cache, is freed */
+void __wrap_wolfSSL_CTX_free(WOLFSSL_CTX* ctx);
+void __wrap_wolfSSL_CTX_free(WOLFSSL_CTX* ctx)
+{
+    int id = esp_wolfssl_mem_domain_of(ctx);
+
+    __real_wolfSSL_CTX_free(ctx);
+    if (id > 0) {
+        esp_wolfssl_mem_domain_release(id);
+    }
+}
+
+void __wrap_wolfSSL_free(WOLFSSL* ssl);
+void __wrap_wolfSSL_free(WOLFSSL* ssl)
+{
+    int id = esp_wolfssl_mem_domain_of(ssl);
+
+#ifdef WOLFSSL_ESP_HMAC_CACHE
+    /* the HMAC cache wraps the same function */
+    esp_wolfssl_hmac_cache_ssl_free(ssl);
+#endif
+    __real_wolfSSL_free(ssl);
+    if (id > 0) {
+        esp_wolfssl_mem_domain_release(id);
+    }
+}
+#endif /* WOLFSSL_ESP_MEM_AUTO */
+
+#endif /* WOLFSSL_ESP_MEM_ACCOUNTING */
@@ -0,0 +1,156 @@
+/* esp_wolfssl_mem.h
+ *
+ * Copyright (C) 2006-2024 wolfSSL Inc.
+ *
+ * This file is part of wolfSSL.
+ *
+ * wolfSSL is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfSSL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335, USA
+ */
+
+/* Heap accounting for wolfSSL allocations, tagged by DYNAMIC_TYPE_*.
+ *
+ * Enabled with Kconfig WOLFSSL_MEM_ACCOUNTING, which routes XMALLOC, XFREE
+ * and XREALLOC through the functions below (see user_settings.h). For a
+ * Linux host build define WOLFSSL_ESP_MEM_ACCOUNTING and the same XMALLOC
+ * macros in the host user_settings.h.
+ *
+ * Allocations are charged to an accounting domain and to all of its parents
+ * up to the global domain. Frees are credited to the domain that made the
+ * allocation, regardless of which task frees it.
+ *
+ * With Kconfig WOLFSSL_MEM_ACCOUNTING_AUTO (WOLFSSL_ESP_MEM_AUTO), the
+ * default, the link-wrapped wolfSSL_CTX_new() and wolfSSL_new() create a
+ * domain "ctx" for every context and a domain "ssl" for every connection,
+ * with the context's domain as parent, and wolfSSL_CTX_free() and
+ * wolfSSL_free() release them. What wolfSSL allocates for a context is
+ * charged to its domain, whichever task does it; so is what it allocates
+ * for a connection in wolfSSL_new(), _connect(), _accept(), _read(),
+ * _write() and _shutdown(), which are wrapped as well. Allocations of
+ * other calls on a connection go to its context. esp-tls connections are
+ * attributed without changes to the application:
+ *
+ *     WOLFSSL* ssl = esp_tls_get_ssl_context(tls);
+ *     esp_wolfssl_mem_log(esp_wolfssl_mem_domain_of(ssl));
+ *
+ * When all domains are in use, new objects are charged as without them.
+ *
+ * A domain entered by the calling task takes precedence, for allocations
+ * with no such owner or without WOLFSSL_ESP_MEM_AUTO:
+ *
+ *     int dom = esp_wolfssl_mem_domain_create("ota", 0);
+ *
+ *     prev = esp_wolfssl_mem_domain_enter(dom);
+ *     ret = esp_wolfssl_ota_verify(...);
+ *     esp_wolfssl_mem_domain_leave(prev);
+ *
+ * The header carries no wolfSSL dependencies, as it is included from
+ * user_settings.h.
+ */
+
+#ifndef _ESP_WOLFSSL_MEM_H_
+#define _ESP_WOLFSSL_MEM_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Number of accounting domains, excluding the global domain. */
+#ifndef ESP_WOLFSSL_MEM_DOMAINS
+    #define ESP_WOLFSSL_MEM_DOMAINS 8
+#endif
+
+/* Number of distinct DYNAMIC_TYPE_* values tracked per domain. Types seen
+ * after the table is full are only counted in the domain totals. */
+#ifndef ESP_WOLFSSL_MEM_TYPE_SLOTS
+    #define ESP_WOLFSSL_MEM_TYPE_SLOTS 24
+#endif
+
+/* The global domain always exists and sees every wolfSSL allocation. */
+#define ESP_WOLFSSL_MEM_DOMAIN_GLOBAL 0
+/* Pass to esp_wolfssl_mem_to_json() to dump every active domain. */
+#define ESP_WOLFSSL_MEM_DOMAIN_ALL    (-1)
+
+typedef struct esp_wolfssl_mem_type_stats_t {
+    int      type;      /* DYNAMIC_TYPE_* from wolfssl/wolfcrypt/types.h */
+    uint32_t current;   /* bytes currently allocated */
+    uint32_t peak;      /* highest value of current */
+    uint32_t allocs;    /* number of allocations */
+} esp_wolfssl_mem_type_stats_t;
+
+typedef struct esp_wolfssl_mem_stats_t {
+    const char* name;
+    int         parent;
+    uint32_t    current;
+    uint32_t    peak;
+    uint32_t    allocs;
+    uint32_t    frees;
+    uint32_t    failures;
+    int         type_count;
+    esp_wolfssl_mem_type_stats_t types[ESP_WOLFSSL_MEM_TYPE_SLOTS];
+} esp_wolfssl_mem_stats_t;
+
+/* XMALLOC / XFREE / XREALLOC replacements. */
+void* esp_wolfssl_malloc(size_t size, void* heap, int type);
+void  esp_wolfssl_free(void* ptr, void* heap, int type);
+void* esp_wolfssl_realloc(void* ptr, size_t size, void* heap, int type);
+
+/* Returns a domain id > 0, or -1 when all domains are in use. */
+int  esp_wolfssl_mem_domain_create(const char* name, int parent);
+
+/* The domain slot is reused once all of its allocations have been freed. */
+void esp_wolfssl_mem_domain_release(int id);
+
+/* Make id current for the calling task; returns the previous domain, to be
+ * passed to esp_wolfssl_mem_domain_leave(). */
+int  esp_wolfssl_mem_domain_enter(int id);
+void esp_wolfssl_mem_domain_leave(int prev);
+
+int  esp_wolfssl_mem_get_stats(int id, esp_wolfssl_mem_stats_t* stats);
+void esp_wolfssl_mem_reset_peak(int id);
+
+/* Writes a JSON object (or an array for ESP_WOLFSSL_MEM_DOMAIN_ALL).
+ * Returns the length written, or -1 when buf is too small. */
+int  esp_wolfssl_mem_to_json(int id, char* buf, size_t bufSz);
+
+/* Logs the JSON dump of id. */
+void esp_wolfssl_mem_log(int id);
+
+/* The automatic domain of a WOLFSSL_CTX or WOLFSSL, or -1. */
+int  esp_wolfssl_mem_domain_of(const void* obj);
+
+#ifdef WOLFSSL_ESP_MEM_AUTO
+struct WOLFSSL_METHOD;
+struct WOLFSSL_CTX;
+struct WOLFSSL;
+
+/* wolfSSL_CTX_new() and wolfSSL_new() in a new domain; for the other
+ * wrappers of the same functions. */
+struct WOLFSSL_CTX* esp_wolfssl_mem_ctx_new(struct WOLFSSL_METHOD* method);
+struct WOLFSSL* esp_wolfssl_mem_ssl_new(struct WOLFSSL_CTX* ctx);
+
+/* Enters the domain of ssl unless the task entered one itself; returns
+ * the previous domain for esp_wolfssl_mem_domain_leave(). For the other
+ * wrappers of wolfSSL_connect() and wolfSSL_accept(). */
+int esp_wolfssl_mem_ssl_enter(const struct WOLFSSL* ssl);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _ESP_WOLFSSL_MEM_H_ */
@@ -0,0 +1,707 @@
+/* esp_wolfssl_nonblock.c
+ *
+ * Copyright (C) 2006-2024 wolfSSL Inc.
+ *
+ * This file is part of wolfSSL.
+ *
+ * wolfSSL is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfSSL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335, USA
+ */
+
+#include <wolfssl/wolfcrypt/settings.h>
+
+#ifdef WOLFSSL_ESP_NONBLOCK
+
+#include <stdint.h>
+#include <string.h>
+
+#include <wolfssl/wolfcrypt/types.h>
+#include <wolfssl/wolfcrypt/random.h>
+#include <wolfssl/wolfcrypt/hash.h>
+#include <wolfssl/wolfcrypt/asn_public.h>
+#include <wolfssl/wolfcrypt/error-crypt.h>
+#include <wolfssl/wolfcrypt/wc_port.h>
+
+#include "esp_wolfssl_nonblock.h"
+#include "esp_wolfssl_lock.h"
+
+#ifdef WOLFSSL_ESPIDF
+    #include <esp_timer.h>
+    #include <freertos/FreeRTOS.h>
+    #include <freertos/task.h>
+#else
+    #include <sched.h>
+    #include <time.h>
+#endif
+
+typedef int (*nb_step_t)(void* op);
+
+static esp_wolfssl_nb_hook_t nb_hook;
+static void* nb_hook_arg;
+static uint32_t nb_slice_us = ESP_WOLFSSL_NB_SLICE_US;
+static esp_wolfssl_nb_stats_t nb_stats;
+/* the statistics only */
+static esp_wolfssl_spin_t nb_spin;
+static int nb_spin_ok;
+
+/* before any handshake, and before the scheduler starts on the device */
+static void __attribute__((constructor)) nb_init(void)
+{
+    nb_spin_ok = (esp_wolfssl_spin_init(&nb_spin) == 0);
+}
+
+static int nb_lock(void)
+{
+    return nb_spin_ok && esp_wolfssl_spin_lock(&nb_spin);
+}
+
+static void nb_unlock(void)
+{
+    esp_wolfssl_spin_unlock(&nb_spin);
+}
+
+static int64_t nb_now(void)
+{
+#ifdef WOLFSSL_ESPIDF
+    return esp_timer_get_time();
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+#endif
+}
+
+static void nb_default_hook(void* arg)
+{
+    (void)arg;
+#ifdef WOLFSSL_ESPIDF
+    taskYIELD();
+#else
+    (void)sched_yield();
+#endif
+}
+
+void esp_wolfssl_nb_set_hook(esp_wolfssl_nb_hook_t hook, void* arg)
+{
+    nb_hook = hook;
+    nb_hook_arg = arg;
+}
+
+void esp_wolfssl_nb_set_slice_us(uint32_t us)
+{
+    nb_slice_us = (us != 0) ? us : ESP_WOLFSSL_NB_SLICE_US;
+}
+
+void esp_wolfssl_nb_get_stats(esp_wolfssl_nb_stats_t* stats)
+{
+    if (stats == NULL) {
+        return;
+    }
+    if (nb_lock()) {
+        *stats = nb_stats;
+        nb_unlock();
+    }
+    else {
+        XMEMSET(stats, 0, sizeof(*stats));
+    }
+}
+
+void esp_wolfssl_nb_reset_stats(void)
+{
+    if (nb_lock()) {
+        XMEMSET(&nb_stats, 0, sizeof(nb_stats));
+        nb_unlock();
+    }
+}
+
+/* Runs step until it returns something else than FP_WOULDBLOCK, and calls
+ * the hook whenever a slice has used up its time. */
+static int nb_run(nb_step_t step, void* op)
+{
+    esp_wolfssl_nb_hook_t hook = nb_hook ? nb_hook : nb_default_hook;
+    void* hook_arg = nb_hook ? nb_hook_arg : NULL;
+    uint32_t slice_us = nb_slice_us;
+    uint32_t slices = 1;
+    uint32_t max_us = 0;
+    uint64_t busy_us = 0;
+    int64_t start = nb_now();
+    int64_t now;
+    int ret;
+
+    for (;;) {
+        ret = step(op);
+        now = nb_now();
+        if (ret != FP_WOULDBLOCK || now - start >= (int64_t)slice_us) {
+            if ((uint32_t)(now - start) > max_us) {
+                max_us = (uint32_t)(now - start);
+            }
+            busy_us += (uint64_t)(now - start);
+            if (ret != FP_WOULDBLOCK) {
+                break;
+            }
+            hook(hook_arg);
+            slices++;
+            start = nb_now();
+        }
+    }
+
+    if (nb_lock()) {
+        nb_stats.ops++;
+        nb_stats.slices += slices;
+        nb_stats.busy_us += busy_us;
+        if (max_us > nb_stats.max_slice_us) {
+            nb_stats.max_slice_us = max_us;
+        }
+        nb_unlock();
+    }
+    return ret;
+}
+
+#ifdef WC_ECC_NONBLOCK
+
+typedef struct nb_ecc_op {
+    int         type;
+    const byte* in;
+    word32      in_sz;
+    const byte* sig;
+    word32      sig_sz;
+    byte*       out;
+    word32*     out_sz;
+    int*        res;
+    WC_RNG*     rng;
+    ecc_key*    key;
+    ecc_key*    pub;
+} nb_ecc_op;
+
+enum {
+    NB_ECC_SIGN,
+    NB_ECC_VERIFY,
+    NB_ECC_SECRET
+};
+
+static int nb_ecc_step(void* arg)
+{
+    nb_ecc_op* op = (nb_ecc_op*)arg;
+
+    switch (op->type) {
+        case NB_ECC_SIGN:
+            return wc_ecc_sign_hash(op->in, op->in_sz, op->out, op->out_sz,
+                                    op->rng, op->key);
+        case NB_ECC_VERIFY:
+            return wc_ecc_verify_hash(op->sig, op->sig_sz, op->in, op->in_sz,
+                                      op->res, op->key);
+        default:
+            return wc_ecc_shared_secret(op->key, op->pub, op->out,
+                                        op->out_sz);
+    }
+}
+
+/* the SP code has incremental paths for P-256 only */
+static int nb_ecc_run(nb_ecc_op* op)
+{
+    ecc_nb_ctx_t* nb = NULL;
+    int ret;
+
+    if (op->key == NULL) {
+        return BAD_FUNC_ARG;
+    }
+    if (wc_ecc_get_curve_id(op->key->idx) == ECC_SECP256R1) {
+        nb = (ecc_nb_ctx_t*)XMALLOC(sizeof(*nb), NULL, DYNAMIC_TYPE_ECC);
+        if (nb == NULL) {
+            return MEMORY_E;
+        }
+        ret = wc_ecc_set_nonblock(op->key, nb);
+        if (ret != 0) {
+            XFREE(nb, NULL, DYNAMIC_TYPE_ECC);
+            return ret;
+        }
+    }
+
+    ret = nb_run(nb_ecc_step, op);
+
+    if (nb != NULL) {
+        (void)wc_ecc_set_nonblock(op->key, NULL);
+        /* holds the intermediate values of the nonce */
+        XMEMSET(nb, 0, sizeof(*nb));
+        XFREE(nb, NULL, DYNAMIC_TYPE_ECC);
+    }
+    return ret;
+}
+
+int esp_wolfssl_nb_ecc_sign_hash(const byte* hash, word32 hash_sz, byte* sig,
+                                 word32* sig_sz, WC_RNG* rng, ecc_key* key)
+{
+    nb_ecc_op op;
+
+    XMEMSET(&op, 0, sizeof(op));
+    op.type = NB_ECC_SIGN;
+    op.in = hash;
+    op.in_sz = hash_sz;
+    op.out = sig;
+    op.out_sz = sig_sz;
+    op.rng = rng;
+    op.key = key;
+    return nb_ecc_run(&op);
+}
+
+int esp_wolfssl_nb_ecc_verify_hash(const byte* sig, word32 sig_sz,
+                                   const byte* hash, word32 hash_sz,
+                                   int* res, ecc_key* key)
+{
+    nb_ecc_op op;
+
+    XMEMSET(&op, 0, sizeof(op));
+    op.type = NB_ECC_VERIFY;
+    op.sig = sig;
+    op.sig_sz = sig_sz;
+    op.in = hash;
+    op.in_sz = hash_sz;
+    op.res = res;
+    op.key = key;
+    return nb_ecc_run(&op);
+}
+
+int esp_wolfssl_nb_ecc_shared_secret(ecc_key* priv, ecc_key* pub, byte* out,
+                                     word32* out_sz)
+{
+    nb_ecc_op op;
+
+    XMEMSET(&op, 0, sizeof(op));
+    op.type = NB_ECC_SECRET;
+    op.out = out;
+    op.out_sz = out_sz;
+    op.key = priv;
+    op.pub = pub;
+    return nb_ecc_run(&op);
+}
+
+#endif /* WC_ECC_NONBLOCK */
+
+#ifdef WC_RSA_NONBLOCK
+
+typedef struct nb_rsa_op {
+    int         type;
+    const byte* in;
+    word32      in_sz;
+    byte*       inout;
+    byte*       out;
+    word32      out_sz;
+    byte**      out_ptr;
+    int         hash;
+    int         mgf;
+    RsaKey*     key;
+    WC_RNG*     rng;
+} nb_rsa_op;
+
+enum {
+    NB_RSA_SIGN,
+    NB_RSA_VERIFY,
+    NB_RSA_PSS_SIGN,
+    NB_RSA_PSS_VERIFY
+};
+
+static int nb_rsa_step(void* arg)
+{
+    nb_rsa_op* op = (nb_rsa_op*)arg;
+
+    switch (op->type) {
+        case NB_RSA_SIGN:
+            return wc_RsaSSL_Sign(op->in, op->in_sz, op->out, op->out_sz,
+                                  op->key, op->rng);
+        case NB_RSA_VERIFY:
+            return wc_RsaSSL_VerifyInline(op->inout, op->in_sz, op->out_ptr,
+                                          op->key);
+    #ifdef WC_RSA_PSS
+        case NB_RSA_PSS_SIGN:
+            return wc_RsaPSS_Sign(op->in, op->in_sz, op->out, op->out_sz,
+                                  (enum wc_HashType)op->hash, op->mgf,
+                                  op->key, op->rng);
+        case NB_RSA_PSS_VERIFY:
+            return wc_RsaPSS_VerifyInline(op->inout, op->in_sz, op->out_ptr,
+                                          (enum wc_HashType)op->hash,
+                                          op->mgf, op->key);
+    #endif
+        default:
+            return BAD_FUNC_ARG;
+    }
+}
+
+static int nb_rsa_run(nb_rsa_op* op)
+{
+    RsaNb* nb;
+    int ret;
+
+    if (op->key == NULL) {
+        return BAD_FUNC_ARG;
+    }
+    nb = (RsaNb*)XMALLOC(sizeof(*nb), NULL, DYNAMIC_TYPE_RSA);
+    if (nb == NULL) {
+        return MEMORY_E;
+    }
+    ret = wc_RsaSetNonBlock(op->key, nb);
+    if (ret == 0) {
+        ret = nb_run(nb_rsa_step, op);
+        (void)wc_RsaSetNonBlock(op->key, NULL);
+    }
+    /* holds the intermediate values of the exponentiation */
+    XMEMSET(nb, 0, sizeof(*nb));
+    XFREE(nb, NULL, DYNAMIC_TYPE_RSA);
+    return ret;
+}
+
+int esp_wolfssl_nb_rsa_sign(const byte* in, word32 in_sz, byte* out,
+                            word32 out_sz, RsaKey* key, WC_RNG* rng)
+{
+    nb_rsa_op op;
+
+    XMEMSET(&op, 0, sizeof(op));
+    op.type = NB_RSA_SIGN;
+    op.in = in;
+    op.in_sz = in_sz;
+    op.out = out;
+    op.out_sz = out_sz;
+    op.key = key;
+    op.rng = rng;
+    return nb_rsa_run(&op);
+}
+
+int esp_wolfssl_nb_rsa_verify_inline(byte* in, word32 in_sz, byte** out,
+                                     RsaKey* key)
+{
+    nb_rsa_op op;
+
+    XMEMSET(&op, 0, sizeof(op));
+    op.type = NB_RSA_VERIFY;
+    op.inout = in;
+    op.in_sz = in_sz;
+    op.out_ptr = out;
+    op.key = key;
+    return nb_rsa_run(&op);
+}
+
+#endif /* WC_RSA_NONBLOCK */
+
+#if !defined(WOLFCRYPT_ONLY) && defined(HAVE_PK_CALLBACKS)
+
+/* The keys of ECC and RSA hold a few KB of big numbers with fast math,
+ * too much for the stack of a TLS task. */
+
+#ifdef WC_ECC_NONBLOCK
+
+static int nb_pk_ecc_sign(WOLFSSL* ssl, const unsigned char* in,
+                          unsigned int in_sz, unsigned char* out,
+                          word32* out_sz, const unsigned char* key_der,
+                          unsigned int key_sz, void* ctx)
+{
+    ecc_key* key;
+    WC_RNG rng;
+    word32 idx = 0;
+    int ret;
+
+    (void)ssl;
+    (void)ctx;
+
+    key = (ecc_key*)XMALLOC(sizeof(*key), NULL, DYNAMIC_TYPE_ECC);
+    if (key == NULL) {
+        return MEMORY_E;
+    }
+    ret = wc_ecc_init(key);
+    if (ret == 0) {
+        ret = wc_EccPrivateKeyDecode(key_der, &idx, key, key_sz);
+        if (ret == 0) {
+            ret = wc_InitRng(&rng);
+            if (ret == 0) {
+                ret = esp_wolfssl_nb_ecc_sign_hash(in, in_sz, out, out_sz,
+                                                   &rng, key);
+                wc_FreeRng(&rng);
+            }
+        }
+        wc_ecc_free(key);
+    }
+    XFREE(key, NULL, DYNAMIC_TYPE_ECC);
+    return ret;
+}
+
+static int nb_pk_ecc_verify(WOLFSSL* ssl, const unsigned char* sig,
+                            unsigned int sig_sz, const unsigned char* hash,
+                            unsigned int hash_sz,
+                            const unsigned char* key_der,
+                            unsigned int key_sz, int* result, void* ctx)
+{
+    ecc_key* key;
+    word32 idx = 0;
+    int ret;
+
+    (void)ssl;
+    (void)ctx;
+
+    key = (ecc_key*)XMALLOC(sizeof(*key), NULL, DYNAMIC_TYPE_ECC);
+    if (key == NULL) {
+        return MEMORY_E;
+    }
+    ret = wc_ecc_init(key);
+    if (ret == 0) {
+        /* DER public key, or the bare point from older wolfSSL versions */
+        ret = wc_EccPublicKeyDecode(key_der, &idx, key, key_sz);
+        if (ret != 0) {
+            ret = wc_ecc_import_x963(key_der, key_sz, key);
+        }
+        if (ret == 0) {
+            ret = esp_wolfssl_nb_ecc_verify_hash(sig, sig_sz, hash, hash_sz,
+                                                 result, key);
+        }
+        wc_ecc_free(key);
+    }
+    XFREE(key, NULL, DYNAMIC_TYPE_ECC);
+    return ret;
+}
+
+#endif /* WC_ECC_NONBLOCK */
+
+#ifdef WC_RSA_NONBLOCK
+
+/* the key of a signature check is the own private key */
+static int nb_pk_rsa_run(nb_rsa_op* op, const unsigned char* key_der,
+                         unsigned int key_sz, int priv)
+{
+    RsaKey* key;
+    WC_RNG rng;
+    int have_rng = 0;
+    word32 idx = 0;
+    int ret;
+
+    key = (RsaKey*)XMALLOC(sizeof(*key), NULL, DYNAMIC_TYPE_RSA);
+    if (key == NULL) {
+        return MEMORY_E;
+    }
+    ret = wc_InitRsaKey(key, NULL);
+    if (ret == 0) {
+        if (priv) {
+            ret = wc_RsaPrivateKeyDecode(key_der, &idx, key, key_sz);
+        }
+        else {
+            ret = wc_RsaPublicKeyDecode(key_der, &idx, key, key_sz);
+        }
+        if (ret == 0 && (op->type == NB_RSA_SIGN ||
+                         op->type == NB_RSA_PSS_SIGN)) {
+            ret = wc_InitRng(&rng);
+            have_rng = (ret == 0);
+            op->rng = &rng;
+        #ifdef WC_RSA_BLINDING
+            if (ret == 0) {
+                ret = wc_RsaSetRNG(key, &rng);
+            }
+        #endif
+        }
+        if (ret == 0) {
+            op->key = key;
+            ret = nb_rsa_run(op);
+        }
+        if (have_rng) {
+            wc_FreeRng(&rng);
+        }
+        wc_FreeRsaKey(key);
+    }
+    XFREE(key, NULL, DYNAMIC_TYPE_RSA);
+    return ret;
+}
+
+static int nb_pk_rsa_sign(WOLFSSL* ssl, const unsigned char* in,
+                          unsigned int in_sz, unsigned char* out,
+                          word32* out_sz, const unsigned char* key_der,
+                          unsigned int key_sz, void* ctx)
+{
+    nb_rsa_op op;
+    int ret;
+
+    (void)ssl;
+    (void)ctx;
+
+    XMEMSET(&op, 0, sizeof(op));
+    op.type = NB_RSA_SIGN;
+    op.in = in;
+    op.in_sz = in_sz;
+    op.out = out;
+    op.out_sz = *out_sz;
+    ret = nb_pk_rsa_run(&op, key_der, key_sz, 1);
+    if (ret > 0) {
+        *out_sz = (word32)ret;
+        ret = 0;
+    }
+    return ret;
+}
+
+static int nb_pk_rsa_verify_ex(unsigned char* sig, unsigned int sig_sz,
+                               unsigned char** out,
+                               const unsigned char* key_der,
+                               unsigned int key_sz, int priv)
+{
+    nb_rsa_op op;
+
+    XMEMSET(&op, 0, sizeof(op));
+    op.type = NB_RSA_VERIFY;
+    op.inout = sig;
+    op.in_sz = sig_sz;
+    op.out_ptr = out;
+    return nb_pk_rsa_run(&op, key_der, key_sz, priv);
+}
+
+static int nb_pk_rsa_verify(WOLFSSL* ssl, unsigned char* sig,
+                            unsigned int sig_sz, unsigned char** out,
+                            const unsigned char* key_der,
+                            unsigned int key_sz, void* ctx)
+{
+    (void)ssl;
+    (void)ctx;
+    return nb_pk_rsa_verify_ex(sig, sig_sz, out, key_der, key_sz, 0);
+}
+
+static int nb_pk_rsa_sign_check(WOLFSSL* ssl, unsigned char* sig,
+                                unsigned int sig_sz, unsigned char** out,
+                                const unsigned char* key_der,
+                                unsigned int key_sz, void* ctx)
+{
+    (void)ssl;
+    (void)ctx;
+    return nb_pk_rsa_verify_ex(sig, sig_sz, out, key_der, key_sz, 1);
+}
+
+#ifdef WC_RSA_PSS
+/* the hash of the PSS callbacks is a MAC algorithm of the TLS layer */
+static int nb_pk_pss_hash(int mac, int* hash)
+{
+    switch (mac) {
+    #ifndef NO_SHA256
+        case sha256_mac:
+            *hash = WC_HASH_TYPE_SHA256;
+            return 0;
+    #endif
+    #ifdef WOLFSSL_SHA384
+        case sha384_mac:
+            *hash = WC_HASH_TYPE_SHA384;
+            return 0;
+    #endif
+    #ifdef WOLFSSL_SHA512
+        case sha512_mac:
+            *hash = WC_HASH_TYPE_SHA512;
+            return 0;
+    #endif
+        default:
+            return BAD_FUNC_ARG;
+    }
+}
+
+static int nb_pk_rsa_pss_sign(WOLFSSL* ssl, const unsigned char* in,
+                              unsigned int in_sz, unsigned char* out,
+                              unsigned int* out_sz, int hash, int mgf,
+                              const unsigned char* key_der,
+                              unsigned int key_sz, void* ctx)
+{
+    nb_rsa_op op;
+    int ret;
+
+    (void)ssl;
+    (void)ctx;
+
+    XMEMSET(&op, 0, sizeof(op));
+    op.type = NB_RSA_PSS_SIGN;
+    op.in = in;
+    op.in_sz = in_sz;
+    op.out = out;
+    op.out_sz = *out_sz;
+    op.mgf = mgf;
+    ret = nb_pk_pss_hash(hash, &op.hash);
+    if (ret == 0) {
+        ret = nb_pk_rsa_run(&op, key_der, key_sz, 1);
+    }
+    if (ret > 0) {
+        *out_sz = (unsigned int)ret;
+        ret = 0;
+    }
+    return ret;
+}
+
+static int nb_pk_rsa_pss_verify_ex(unsigned char* sig, unsigned int sig_sz,
+                                   unsigned char** out, int hash, int mgf,
+                                   const unsigned char* key_der,
+                                   unsigned int key_sz, int priv)
+{
+    nb_rsa_op op;
+    int ret;
+
+    XMEMSET(&op, 0, sizeof(op));
+    op.type = NB_RSA_PSS_VERIFY;
+    op.inout = sig;
+    op.in_sz = sig_sz;
+    op.out_ptr = out;
+    op.mgf = mgf;
+    ret = nb_pk_pss_hash(hash, &op.hash);
+    if (ret == 0) {
+        ret = nb_pk_rsa_run(&op, key_der, key_sz, priv);
+    }
+    return ret;
+}
+
+static int nb_pk_rsa_pss_verify(WOLFSSL* ssl, unsigned char* sig,
+                                unsigned int sig_sz, unsigned char** out,
+                                int hash, int mgf,
+                                const unsigned char* key_der,
+                                unsigned int key_sz, void* ctx)
+{
+    (void)ssl;
+    (void)ctx;
+    return nb_pk_rsa_pss_verify_ex(sig, sig_sz, out, hash, mgf, key_der,
+                                   key_sz, 0);
+}
+
+static int nb_pk_rsa_pss_sign_check(WOLFSSL* ssl, unsigned char* sig,
+                                    unsigned int sig_sz, unsigned char** out,
+                                    int hash, int mgf,
+                                    const unsigned char* key_der,
+                                    unsigned int key_sz, void* ctx)
+{
+    (void)ssl;
+    (void)ctx;
+    return nb_pk_rsa_pss_verify_ex(sig, sig_sz, out, hash, mgf, key_der,
+                                   key_sz, 1);
+}
+#endif /* WC_RSA_PSS */
+
+#endif /* WC_RSA_NONBLOCK */
+
+int esp_wolfssl_nb_ctx_setup(WOLFSSL_CTX* ctx)
+{
+    if (ctx == NULL) {
+        return BAD_FUNC_ARG;
+    }
+#ifdef WC_ECC_NONBLOCK
+    wolfSSL_CTX_SetEccSignCb(ctx, nb_pk_ecc_sign);
+    wolfSSL_CTX_SetEccVerifyCb(ctx, nb_pk_ecc_verify);
+#endif
+#ifdef WC_RSA_NONBLOCK
+    wolfSSL_CTX_SetRsaSignCb(ctx, nb_pk_rsa_sign);
+    wolfSSL_CTX_SetRsaSignCheckCb(ctx, nb_pk_rsa_sign_check);
+    wolfSSL_CTX_SetRsaVerifyCb(ctx, nb_pk_rsa_verify);
+    #ifdef WC_RSA_PSS
+    wolfSSL_CTX_SetRsaPssSignCb(ctx, nb_pk_rsa_pss_sign);
+    wolfSSL_CTX_SetRsaPssSignCheckCb(ctx, nb_pk_rsa_pss_sign_check);
+    wolfSSL_CTX_SetRsaPssVerifyCb(ctx, nb_pk_rsa_pss_verify);
+    #endif
+#endif
+    return 0;
+}
+
+#endif /* !WOLFCRYPT_ONLY && HAVE_PK_CALLBACKS */
+
+#endif /* WOLFSSL_ESP_NONBLOCK */
@@ -0,0 +1,140 @@
+/* esp_wolfssl_nonblock.h
+ *
+ * Copyright (C) 2006-2024 wolfSSL Inc.
+ *
+ * This file is part of wolfSSL.
+ *
+ * wolfSSL is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfSSL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335, USA
+ */
+
+/* Time-sliced ECC and RSA.
+ *
+ * Enabled with Kconfig WOLFSSL_NONBLOCK_PK, which builds the incremental
+ * paths of wolfCrypt: WC_ECC_NONBLOCK on the SP code for P-256 and
+ * WC_RSA_NONBLOCK on fast math. With a context set on the key, an ECC or
+ * RSA operation returns FP_WOULDBLOCK after each small step instead of
+ * running to the end. The functions here drive such an operation in
+ * slices of about ESP_WOLFSSL_NB_SLICE_US and call a hook between two
+ * slices; the default hook yields the CPU, an application with a control
+ * loop in the same task runs one step of it there. The longest stretch
+ * without a call of the hook is a slice plus one step of the operation.
+ *
+ * esp_wolfssl_nb_ctx_setup() installs PK callbacks on a WOLFSSL_CTX that
+ * sign and verify in slices, so a handshake calls the hook between slices
+ * as well: the CertificateVerify or ServerKeyExchange signature, its
+ * verification, and the verification of the peer's certificate chain.
+ * The handshake itself cannot return WANT_READ between slices, which takes
+ * wolfSSL's asynchronous crypto framework; the hook is where the caller
+ * gets control back.
+ *
+ * Still blocking are ephemeral key generation (see esp_wolfssl_keypool.h,
+ * which takes it off the connect path) and the (EC)DH shared secret of the
+ * handshake, and keys on other curves than P-256. A sliced RSA private key
+ * operation exponentiates with d, without CRT and, in the wolfSSL versions
+ * this was written against, without blinding; it takes several times as
+ * long in total as the blocking one and runs the exponentiation in
+ * software.
+ *
+ * The SP code is selected at build time, not per key: with this option
+ * every P-256 operation, the blocking ones and those of contexts without
+ * esp_wolfssl_nb_ctx_setup() included, runs in SP software instead of on
+ * the big-number accelerator. Other curves keep their existing path.
+ */
+
+#ifndef _ESP_WOLFSSL_NONBLOCK_H_
+#define _ESP_WOLFSSL_NONBLOCK_H_
+
+#include <stdint.h>
+
+#include <wolfssl/wolfcrypt/settings.h>
+#include <wolfssl/wolfcrypt/types.h>
+#include <wolfssl/wolfcrypt/random.h>
+#ifdef WC_ECC_NONBLOCK
+    #include <wolfssl/wolfcrypt/ecc.h>
+#endif
+#ifdef WC_RSA_NONBLOCK
+    #include <wolfssl/wolfcrypt/rsa.h>
+#endif
+#ifndef WOLFCRYPT_ONLY
+    #include <wolfssl/ssl.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* computing time between two calls of the hook */
+#ifndef ESP_WOLFSSL_NB_SLICE_US
+    #define ESP_WOLFSSL_NB_SLICE_US 5000
+#endif
+
+/* called between two slices with the argument given to
+ * esp_wolfssl_nb_set_hook() */
+typedef void (*esp_wolfssl_nb_hook_t)(void* arg);
+
+typedef struct esp_wolfssl_nb_stats_t {
+    uint32_t ops;           /* completed sliced operations */
+    uint32_t slices;
+    uint32_t max_slice_us;  /* longest stretch without the hook */
+    uint64_t busy_us;       /* computing time of all slices */
+} esp_wolfssl_nb_stats_t;
+
+#ifdef WOLFSSL_ESP_NONBLOCK
+
+/* NULL restores the default, which yields the CPU. Set it before the
+ * first handshake; it applies to all tasks. */
+void esp_wolfssl_nb_set_hook(esp_wolfssl_nb_hook_t hook, void* arg);
+
+/* 0 restores ESP_WOLFSSL_NB_SLICE_US */
+void esp_wolfssl_nb_set_slice_us(uint32_t us);
+
+void esp_wolfssl_nb_get_stats(esp_wolfssl_nb_stats_t* stats);
+void esp_wolfssl_nb_reset_stats(void);
+
+/* Like wc_ecc_sign_hash(), wc_ecc_verify_hash() and wc_ecc_shared_secret(),
+ * in slices; keys on other curves than P-256 take one slice. */
+#ifdef WC_ECC_NONBLOCK
+int esp_wolfssl_nb_ecc_sign_hash(const byte* hash, word32 hash_sz, byte* sig,
+                                 word32* sig_sz, WC_RNG* rng, ecc_key* key);
+int esp_wolfssl_nb_ecc_verify_hash(const byte* sig, word32 sig_sz,
+                                   const byte* hash, word32 hash_sz,
+                                   int* res, ecc_key* key);
+int esp_wolfssl_nb_ecc_shared_secret(ecc_key* priv, ecc_key* pub, byte* out,
+                                     word32* out_sz);
+#endif
+
+/* Like wc_RsaSSL_Sign() and wc_RsaSSL_VerifyInline(), in slices. Return
+ * the length of the signature or of the verified message, or an error. */
+#ifdef WC_RSA_NONBLOCK
+int esp_wolfssl_nb_rsa_sign(const byte* in, word32 in_sz, byte* out,
+                            word32 out_sz, RsaKey* key, WC_RNG* rng);
+int esp_wolfssl_nb_rsa_verify_inline(byte* in, word32 in_sz, byte** out,
+                                     RsaKey* key);
+#endif
+
+#if !defined(WOLFCRYPT_ONLY) && defined(HAVE_PK_CALLBACKS)
+/* Installs the PK callbacks that sign and verify in slices on ctx; they
+ * replace other PK callbacks for ECC and RSA signatures. Returns 0 or an
+ * error. */
+int esp_wolfssl_nb_ctx_setup(WOLFSSL_CTX* ctx);
+#endif
+
+#endif /* WOLFSSL_ESP_NONBLOCK */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _ESP_WOLFSSL_NONBLOCK_H_ */
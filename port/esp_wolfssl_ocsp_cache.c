@@ -0,0 +1,467 @@
+/* esp_wolfssl_ocsp_cache.c
+ *
+ * Copyright (C) 2006-2024 wolfSSL Inc.
+ *
+ * This file is part of wolfSSL.
+ *
+ * wolfSSL is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfSSL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335, USA
+ */
+
+#include <wolfssl/wolfcrypt/settings.h>
+
+#ifdef WOLFSSL_ESP_OCSP_CACHE
+
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+#include <wolfssl/ssl.h>
+#include <wolfssl/version.h>
+#include <wolfssl/wolfio.h>
+#include <wolfssl/wolfcrypt/types.h>
+#include <wolfssl/wolfcrypt/asn.h>
+#include <wolfssl/wolfcrypt/error-crypt.h>
+#include <wolfssl/wolfcrypt/hash.h>
+#include <wolfssl/wolfcrypt/wc_port.h>
+
+#include "esp_wolfssl_der.h"
+#include "esp_wolfssl_ocsp_cache.h"
+
+#ifndef ESP_WOLFSSL_OCSP_CACHE_ENTRIES
+    #define ESP_WOLFSSL_OCSP_CACHE_ENTRIES  8
+#endif
+/* largest response kept for stapling, 0 keeps none */
+#ifndef ESP_WOLFSSL_OCSP_CACHE_RESP_MAX
+    #define ESP_WOLFSSL_OCSP_CACHE_RESP_MAX 2048
+#endif
+
+/* nothing is reused before the clock was set: 2020-01-01 */
+#define OCSP_CACHE_MIN_TIME 1577836800
+
+#define OCSP_KEY_SZ         16
+
+typedef struct ocsp_cache_entry {
+    byte     key[OCSP_KEY_SZ];  /* SHA-256 of the CertID, truncated */
+    byte     digest[WC_SHA256_DIGEST_SIZE];     /* of the response */
+    int64_t  next_update;
+    uint32_t lru;
+    byte     used;
+    byte     verified;
+    byte*    raw;               /* response for stapling, may be NULL */
+    word32   raw_sz;
+} ocsp_cache_entry;
+
+static ocsp_cache_entry ocsp_cache[ESP_WOLFSSL_OCSP_CACHE_ENTRIES];
+static esp_wolfssl_ocsp_cache_stats_t ocsp_stats;
+static uint32_t ocsp_lru;
+static int ocsp_enabled = 1;
+static wolfSSL_Mutex ocsp_mutex;
+static int ocsp_mutex_ok;
+
+static CbOCSPIO       ocsp_fetch;
+static CbOCSPRespFree ocsp_fetch_free;
+static void*          ocsp_fetch_ctx;
+
+/* before any handshake, and before the scheduler starts on the device */
+static void __attribute__((constructor)) ocsp_cache_init(void)
+{
+    ocsp_mutex_ok = (wc_InitMutex(&ocsp_mutex) == 0);
+}
+
+static int ocsp_lock(void)
+{
+    return ocsp_mutex_ok && wc_LockMutex(&ocsp_mutex) == 0;
+}
+
+static void ocsp_unlock(void)
+{
+    wc_UnLockMutex(&ocsp_mutex);
+}
+
+static int64_t ocsp_now(void)
+{
+    return (int64_t)time(NULL);
+}
+
+static int ocsp_key(const esp_wolfssl_der_t* cert_id, byte* key)
+{
+    byte hash[WC_SHA256_DIGEST_SIZE];
+
+    if (wc_Sha256Hash(cert_id->p, (word32)cert_id->len, hash) != 0) {
+        return -1;
+    }
+    XMEMCPY(key, hash, OCSP_KEY_SZ);
+    return 0;
+}
+
+/* OCSPResponse: the CertID and nextUpdate of the first SingleResponse */
+static int ocsp_parse_response(const byte* p, word32 sz, byte* key,
+                               int64_t* next_update)
+{
+    esp_wolfssl_der_t d;
+    esp_wolfssl_der_t x;
+    esp_wolfssl_der_t cert_id;
+    uint8_t tag;
+
+    esp_wolfssl_der_init(&d, p, sz);
+    /* OCSPResponse, responseStatus, responseBytes */
+    if (esp_wolfssl_der_expect(&d, ESP_WOLFSSL_DER_SEQUENCE, &d) != 0
+        || esp_wolfssl_der_expect(&d, ESP_WOLFSSL_DER_ENUMERATED, NULL) != 0
+        || esp_wolfssl_der_expect(&d, ESP_WOLFSSL_DER_CONTEXT(0), &d) != 0
+        || esp_wolfssl_der_expect(&d, ESP_WOLFSSL_DER_SEQUENCE, &d) != 0
+        || esp_wolfssl_der_expect(&d, ESP_WOLFSSL_DER_OID, NULL) != 0
+        || esp_wolfssl_der_expect(&d, ESP_WOLFSSL_DER_OCTET_STRING, &d) != 0
+        /* BasicOCSPResponse, ResponseData */
+        || esp_wolfssl_der_expect(&d, ESP_WOLFSSL_DER_SEQUENCE, &d) != 0
+        || esp_wolfssl_der_expect(&d, ESP_WOLFSSL_DER_SEQUENCE, &d) != 0) {
+        return -1;
+    }
+    (void)esp_wolfssl_der_skip_optional(&d, ESP_WOLFSSL_DER_CONTEXT(0));
+    /* responderID, producedAt, responses, first SingleResponse */
+    if (esp_wolfssl_der_next(&d, NULL, NULL, NULL) != 0
+        || esp_wolfssl_der_next(&d, NULL, NULL, NULL) != 0
+        || esp_wolfssl_der_expect(&d, ESP_WOLFSSL_DER_SEQUENCE, &d) != 0
+        || esp_wolfssl_der_expect(&d, ESP_WOLFSSL_DER_SEQUENCE, &d) != 0
+        /* certID, certStatus, thisUpdate */
+        || esp_wolfssl_der_next(&d, NULL, NULL, &cert_id) != 0
+        || esp_wolfssl_der_next(&d, NULL, NULL, NULL) != 0
+        || esp_wolfssl_der_next(&d, NULL, NULL, NULL) != 0
+        /* nextUpdate [0] EXPLICIT GeneralizedTime, optional */
+        || esp_wolfssl_der_expect(&d, ESP_WOLFSSL_DER_CONTEXT(0), &x) != 0
+        || esp_wolfssl_der_next(&x, &tag, &x, NULL) != 0
+        || esp_wolfssl_der_time(tag, &x, next_update) != 0) {
+        return -1;
+    }
+
+    return ocsp_key(&cert_id, key);
+}
+
+/* OCSPRequest: the CertID of the first Request */
+static int ocsp_parse_request(const byte* p, word32 sz, byte* key)
+{
+    esp_wolfssl_der_t d;
+    esp_wolfssl_der_t cert_id;
+
+    esp_wolfssl_der_init(&d, p, sz);
+    if (esp_wolfssl_der_expect(&d, ESP_WOLFSSL_DER_SEQUENCE, &d) != 0
+        || esp_wolfssl_der_expect(&d, ESP_WOLFSSL_DER_SEQUENCE, &d) != 0) {
+        return -1;
+    }
+    (void)esp_wolfssl_der_skip_optional(&d, ESP_WOLFSSL_DER_CONTEXT(0));
+    (void)esp_wolfssl_der_skip_optional(&d, ESP_WOLFSSL_DER_CONTEXT(1));
+    if (esp_wolfssl_der_expect(&d, ESP_WOLFSSL_DER_SEQUENCE, &d) != 0
+        || esp_wolfssl_der_expect(&d, ESP_WOLFSSL_DER_SEQUENCE, &d) != 0
+        || esp_wolfssl_der_next(&d, NULL, NULL, &cert_id) != 0) {
+        return -1;
+    }
+
+    return ocsp_key(&cert_id, key);
+}
+
+static void ocsp_entry_free(ocsp_cache_entry* e)
+{
+    XFREE(e->raw, NULL, DYNAMIC_TYPE_OCSP);
+    XMEMSET(e, 0, sizeof(*e));
+}
+
+/* call locked */
+static ocsp_cache_entry* ocsp_find(const byte* key)
+{
+    int64_t now = ocsp_now();
+    int i;
+
+    for (i = 0; i < ESP_WOLFSSL_OCSP_CACHE_ENTRIES; i++) {
+        ocsp_cache_entry* e = &ocsp_cache[i];
+        if (e->used && XMEMCMP(e->key, key, OCSP_KEY_SZ) == 0) {
+            if (now < OCSP_CACHE_MIN_TIME || now >= e->next_update) {
+                ocsp_entry_free(e);
+                ocsp_stats.entries--;
+                return NULL;
+            }
+            e->lru = ++ocsp_lru;
+            return e;
+        }
+    }
+    return NULL;
+}
+
+/* Entry for key, replacing the least recently used one. Call locked. */
+static ocsp_cache_entry* ocsp_slot(const byte* key)
+{
+    ocsp_cache_entry* e = ocsp_find(key);
+    ocsp_cache_entry* victim = &ocsp_cache[0];
+    int i;
+
+    if (e != NULL) {
+        return e;
+    }
+    for (i = 0; i < ESP_WOLFSSL_OCSP_CACHE_ENTRIES; i++) {
+        if (!ocsp_cache[i].used) {
+            victim = &ocsp_cache[i];
+            break;
+        }
+        if (ocsp_cache[i].lru < victim->lru) {
+            victim = &ocsp_cache[i];
+        }
+    }
+    if (victim->used) {
+        ocsp_entry_free(victim);
+        ocsp_stats.evictions++;
+    }
+    else {
+        ocsp_stats.entries++;
+    }
+    XMEMCPY(victim->key, key, OCSP_KEY_SZ);
+    victim->used = 1;
+    victim->lru = ++ocsp_lru;
+    return victim;
+}
+
+/* A response for the entry: a different one resets what is known. Call
+ * locked. */
+static void ocsp_entry_set(ocsp_cache_entry* e, const byte* digest,
+                           int64_t next_update)
+{
+    if (XMEMCMP(e->digest, digest, sizeof(e->digest)) != 0) {
+        XFREE(e->raw, NULL, DYNAMIC_TYPE_OCSP);
+        e->raw = NULL;
+        e->raw_sz = 0;
+        e->verified = 0;
+        XMEMCPY(e->digest, digest, sizeof(e->digest));
+    }
+    e->next_update = next_update;
+}
+
+/* OcspResponseDecode() is internal to wolfSSL; stop the build on a release
+ * this wrapper was not written against instead of misbehaving at run time */
+#if !defined(LIBWOLFSSL_VERSION_HEX) || LIBWOLFSSL_VERSION_HEX < 0x05007000 \
+    || LIBWOLFSSL_VERSION_HEX >= 0x05008000
+    #error "WOLFSSL_OCSP_CACHE wraps OcspResponseDecode() of wolfSSL 5.7.x"
+#endif
+/* conflicts with the declaration in wolfssl/wolfcrypt/asn.h if it changed */
+int OcspResponseDecode(OcspResponse* resp, void* cm, void* heap,
+                       int noVerify);
+
+extern int __real_OcspResponseDecode(OcspResponse* resp, void* cm,
+                                     void* heap, int noVerify);
+int __wrap_OcspResponseDecode(OcspResponse* resp, void* cm, void* heap,
+                              int noVerify);
+
+int __wrap_OcspResponseDecode(OcspResponse* resp, void* cm, void* heap,
+                              int noVerify)
+{
+    byte key[OCSP_KEY_SZ];
+    byte digest[WC_SHA256_DIGEST_SIZE];
+    int64_t next_update;
+    ocsp_cache_entry* e;
+    int cached = 0;
+    int ret;
+
+    if (noVerify || !ocsp_enabled || resp == NULL || resp->source == NULL
+        || ocsp_now() < OCSP_CACHE_MIN_TIME
+        || ocsp_parse_response(resp->source, resp->maxIdx, key,
+                               &next_update) != 0
+        || wc_Sha256Hash(resp->source, resp->maxIdx, digest) != 0) {
+        return __real_OcspResponseDecode(resp, cm, heap, noVerify);
+    }
+
+    if (ocsp_lock()) {
+        e = ocsp_find(key);
+        cached = (e != NULL && e->verified
+                  && XMEMCMP(e->digest, digest, sizeof(digest)) == 0);
+        ocsp_unlock();
+    }
+    if (cached) {
+        /* same bytes as a response that verified: parse, dates and status
+         * are still checked by wolfSSL */
+        ret = __real_OcspResponseDecode(resp, cm, heap, 1);
+        if (ret == 0) {
+            __atomic_add_fetch(&ocsp_stats.verify_skipped, 1,
+                               __ATOMIC_RELAXED);
+        }
+        return ret;
+    }
+
+    ret = __real_OcspResponseDecode(resp, cm, heap, 0);
+    if (ret == 0 && resp->responseStatus == OCSP_SUCCESSFUL
+        && ocsp_now() < next_update && ocsp_lock()) {
+        e = ocsp_slot(key);
+        ocsp_entry_set(e, digest, next_update);
+        e->verified = 1;
+        ocsp_stats.verified++;
+        ocsp_unlock();
+    }
+
+    return ret;
+}
+
+static void ocsp_cache_io_free(void* ctx, unsigned char* resp)
+{
+    (void)ctx;
+    XFREE(resp, NULL, DYNAMIC_TYPE_OCSP);
+}
+
+/* Copy of the cached response for the request, or 0 */
+static int ocsp_cache_io_hit(const byte* key, unsigned char** resp)
+{
+    ocsp_cache_entry* e;
+    byte* copy = NULL;
+    int sz = 0;
+
+    if (!ocsp_lock()) {
+        return 0;
+    }
+    e = ocsp_find(key);
+    if (e != NULL && e->raw != NULL) {
+        copy = (byte*)XMALLOC(e->raw_sz, NULL, DYNAMIC_TYPE_OCSP);
+        if (copy != NULL) {
+            XMEMCPY(copy, e->raw, e->raw_sz);
+            sz = (int)e->raw_sz;
+            ocsp_stats.staple_hits++;
+        }
+    }
+    ocsp_unlock();
+
+    *resp = copy;
+    return sz;
+}
+
+static void ocsp_cache_io_store(const byte* req_key, const byte* resp,
+                                int sz)
+{
+    byte key[OCSP_KEY_SZ];
+    byte digest[WC_SHA256_DIGEST_SIZE];
+    int64_t next_update;
+    ocsp_cache_entry* e;
+    byte* raw;
+
+    if (sz > ESP_WOLFSSL_OCSP_CACHE_RESP_MAX
+        || ocsp_parse_response(resp, (word32)sz, key, &next_update) != 0
+        || XMEMCMP(key, req_key, OCSP_KEY_SZ) != 0
+        || ocsp_now() >= next_update
+        || wc_Sha256Hash(resp, (word32)sz, digest) != 0) {
+        return;
+    }
+    raw = (byte*)XMALLOC(sz, NULL, DYNAMIC_TYPE_OCSP);
+    if (raw == NULL) {
+        return;
+    }
+    XMEMCPY(raw, resp, sz);
+
+    if (!ocsp_lock()) {
+        XFREE(raw, NULL, DYNAMIC_TYPE_OCSP);
+        return;
+    }
+    e = ocsp_slot(key);
+    ocsp_entry_set(e, digest, next_update);
+    XFREE(e->raw, NULL, DYNAMIC_TYPE_OCSP);
+    e->raw = raw;
+    e->raw_sz = (word32)sz;
+    ocsp_unlock();
+}
+
+static int ocsp_cache_io(void* ctx, const char* url, int urlSz,
+                         unsigned char* req, int reqSz, unsigned char** resp)
+{
+    byte key[OCSP_KEY_SZ];
+    unsigned char* fetched = NULL;
+    int have_key;
+    int sz;
+
+    (void)ctx;
+    *resp = NULL;
+    have_key = (ocsp_enabled && ocsp_now() >= OCSP_CACHE_MIN_TIME
+                && ocsp_parse_request(req, (word32)reqSz, key) == 0);
+    if (have_key) {
+        sz = ocsp_cache_io_hit(key, resp);
+        if (sz > 0) {
+            return sz;
+        }
+    }
+
+    if (ocsp_fetch == NULL) {
+        return WOLFSSL_CBIO_ERR_GENERAL;
+    }
+    sz = ocsp_fetch(ocsp_fetch_ctx, url, urlSz, req, reqSz, &fetched);
+    __atomic_add_fetch(&ocsp_stats.fetches, 1, __ATOMIC_RELAXED);
+    if (sz > 0 && fetched != NULL) {
+        /* hand out our own copy, so one free callback fits all */
+        *resp = (unsigned char*)XMALLOC(sz, NULL, DYNAMIC_TYPE_OCSP);
+        if (*resp != NULL) {
+            XMEMCPY(*resp, fetched, sz);
+            if (have_key) {
+                ocsp_cache_io_store(key, fetched, sz);
+            }
+        }
+        else {
+            sz = MEMORY_E;
+        }
+    }
+    if (fetched != NULL && ocsp_fetch_free != NULL) {
+        ocsp_fetch_free(ocsp_fetch_ctx, fetched);
+    }
+
+    return sz;
+}
+
+int esp_wolfssl_ocsp_cache_set_io(WOLFSSL_CTX* ctx, CbOCSPIO fetch,
+                                  CbOCSPRespFree fetch_free, void* fetch_ctx)
+{
+    if (ctx == NULL) {
+        return BAD_FUNC_ARG;
+    }
+    if (fetch == NULL) {
+#ifndef WOLFSSL_USER_IO
+        fetch = EmbedOcspLookup;
+        fetch_free = EmbedOcspRespFree;
+#else
+        return BAD_FUNC_ARG;
+#endif
+    }
+    ocsp_fetch = fetch;
+    ocsp_fetch_free = fetch_free;
+    ocsp_fetch_ctx = fetch_ctx;
+
+    return wolfSSL_CTX_SetOCSP_Cb(ctx, ocsp_cache_io, ocsp_cache_io_free,
+                                  NULL);
+}
+
+void esp_wolfssl_ocsp_cache_set_enabled(int enabled)
+{
+    ocsp_enabled = enabled;
+}
+
+void esp_wolfssl_ocsp_cache_clear(void)
+{
+    int i;
+
+    if (!ocsp_lock()) {
+        return;
+    }
+    for (i = 0; i < ESP_WOLFSSL_OCSP_CACHE_ENTRIES; i++) {
+        ocsp_entry_free(&ocsp_cache[i]);
+    }
+    XMEMSET(&ocsp_stats, 0, sizeof(ocsp_stats));
+    ocsp_unlock();
+}
+
+void esp_wolfssl_ocsp_cache_get_stats(esp_wolfssl_ocsp_cache_stats_t* stats)
+{
+    if (stats != NULL) {
+        XMEMCPY(stats, &ocsp_stats, sizeof(*stats));
+    }
+}
+
+#endif /* WOLFSSL_ESP_OCSP_CACHE */
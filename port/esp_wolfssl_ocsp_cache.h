@@ -0,0 +1,88 @@
+/* esp_wolfssl_ocsp_cache.h
+ *
+ * Copyright (C) 2006-2024 wolfSSL Inc.
+ *
+ * This file is part of wolfSSL.
+ *
+ * wolfSSL is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfSSL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335, USA
+ */
+
+/* Cache of verified OCSP responses, reused until their nextUpdate.
+ *
+ * Enabled with Kconfig WOLFSSL_OCSP_CACHE. Every OCSP response wolfSSL
+ * decodes, stapled or fetched, goes through a linker wrapper around
+ * OcspResponseDecode() (-Wl,--wrap, see the component CMakeLists.txt),
+ * an internal function whose signature is checked at build time against
+ * wolfSSL 5.7.x.
+ * After the first successful verification of a response, a byte identical
+ * response for the same certificate ID is decoded without verifying its
+ * signature again, until its nextUpdate time. The CertID contains the
+ * issuer's key hash, so a cached verification holds for every context that
+ * trusts the issuer; the certificate chain itself is still verified on
+ * every handshake.
+ *
+ * A TLS server that staples can also serve responses from memory instead of
+ * asking the responder on every handshake:
+ *
+ *   wolfSSL_CTX_EnableOCSPStapling(ctx);
+ *   esp_wolfssl_ocsp_cache_set_io(ctx, NULL, NULL, NULL);
+ *
+ * Responses without nextUpdate are never cached, and nothing is reused
+ * while the system clock is not set.
+ */
+
+#ifndef _ESP_WOLFSSL_OCSP_CACHE_H_
+#define _ESP_WOLFSSL_OCSP_CACHE_H_
+
+#include <stdint.h>
+
+#include <wolfssl/wolfcrypt/settings.h>
+#include <wolfssl/ssl.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct esp_wolfssl_ocsp_cache_stats_t {
+    uint32_t verify_skipped;    /* responses decoded from a cached verification */
+    uint32_t verified;          /* responses verified and stored */
+    uint32_t staple_hits;       /* responses served from memory */
+    uint32_t fetches;           /* responses fetched from the responder */
+    uint32_t evictions;
+    uint32_t entries;           /* currently cached */
+} esp_wolfssl_ocsp_cache_stats_t;
+
+#ifdef WOLFSSL_ESP_OCSP_CACHE
+
+/* Installs the OCSP lookup of ctx: responses are served from the cache while
+ * valid, otherwise fetched with fetch / fetch_free (NULL for wolfSSL's HTTP
+ * lookup, EmbedOcspLookup) and cached. The fetch callbacks are shared by all
+ * contexts. Returns WOLFSSL_SUCCESS or an error. */
+int esp_wolfssl_ocsp_cache_set_io(WOLFSSL_CTX* ctx, CbOCSPIO fetch,
+                                  CbOCSPRespFree fetch_free, void* fetch_ctx);
+
+/* Off: every response is verified and fetched again, e.g. to compare. */
+void esp_wolfssl_ocsp_cache_set_enabled(int enabled);
+
+void esp_wolfssl_ocsp_cache_clear(void);
+void esp_wolfssl_ocsp_cache_get_stats(esp_wolfssl_ocsp_cache_stats_t* stats);
+
+#endif /* WOLFSSL_ESP_OCSP_CACHE */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _ESP_WOLFSSL_OCSP_CACHE_H_ */
@@ -0,0 +1,283 @@
+/* esp_wolfssl_ota_verify.c
+ *
+ * Copyright (C) 2006-2024 wolfSSL Inc.
+ *
+ * This file is part of wolfSSL.
+ *
+ * wolfSSL is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfSSL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335, USA
+ */
+
+#include <wolfssl/wolfcrypt/settings.h>
+
+#ifdef WOLFSSL_ESP_OTA_VERIFY
+
+#include <stdint.h>
+#include <string.h>
+
+#include <wolfssl/wolfcrypt/types.h>
+#include <wolfssl/wolfcrypt/error-crypt.h>
+#include <wolfssl/wolfcrypt/sha256.h>
+#include <wolfssl/wolfcrypt/signature.h>
+#include <wolfssl/wolfcrypt/wc_port.h>
+#ifdef HAVE_ECC
+    #include <wolfssl/wolfcrypt/ecc.h>
+    #include <wolfssl/wolfcrypt/asn_public.h>
+#endif
+#ifdef WOLFSSL_HAVE_LMS
+    #include <wolfssl/wolfcrypt/lms.h>
+    #include <wolfssl/wolfcrypt/wc_lms.h>
+#endif
+
+#include "esp_wolfssl_ota_verify.h"
+
+struct esp_wolfssl_ota_verify_t {
+    wc_Sha256             sha;
+    esp_wolfssl_ota_sig_t type;
+    uint64_t              size;
+    int                   done;
+    union {
+#ifdef HAVE_ECC
+        ecc_key ecc;
+#endif
+#ifdef WOLFSSL_HAVE_LMS
+        LmsKey  lms;
+#endif
+        int     none;
+    } key;
+};
+
+#ifdef WOLFSSL_HAVE_LMS
+/* HSS public key: levels, LMS type, LM-OTS type, I, T[1] */
+#define OTA_LMS_PUB_SZ  60
+
+static word32 ota_be32(const unsigned char* p)
+{
+    return ((word32)p[0] << 24) | ((word32)p[1] << 16) |
+           ((word32)p[2] << 8) | p[3];
+}
+
+/* the parameter set of an HSS public key, LMS_SHA256_M32_* and
+ * LMOTS_SHA256_N32_* of RFC 8554 */
+static int ota_lms_import(LmsKey* key, const unsigned char* pub,
+                          size_t pub_sz)
+{
+    static const byte heights[] = { 5, 10, 15, 20, 25 };
+    static const byte widths[] = { 1, 2, 4, 8 };
+    word32 levels;
+    word32 lms_type;
+    word32 ots_type;
+    int ret;
+
+    if (pub_sz != OTA_LMS_PUB_SZ) {
+        return BUFFER_E;
+    }
+    levels = ota_be32(pub);
+    lms_type = ota_be32(pub + 4);
+    ots_type = ota_be32(pub + 8);
+    if (levels < 1 || levels > 8 || lms_type < 5 || lms_type > 9 ||
+        ots_type < 1 || ots_type > 4) {
+        return ASN_PARSE_E;
+    }
+
+    ret = wc_LmsKey_Init(key, NULL, INVALID_DEVID);
+    if (ret == 0) {
+        ret = wc_LmsKey_SetParameters(key, (int)levels,
+                                      heights[lms_type - 5],
+                                      widths[ots_type - 1]);
+        if (ret == 0) {
+            ret = wc_LmsKey_ImportPubRaw(key, pub, (word32)pub_sz);
+        }
+        if (ret != 0) {
+            wc_LmsKey_Free(key);
+        }
+    }
+    return ret;
+}
+#endif
+
+int esp_wolfssl_ota_verify_new(esp_wolfssl_ota_sig_t type,
+                               const unsigned char* pub, size_t pub_sz,
+                               esp_wolfssl_ota_verify_t** v)
+{
+    esp_wolfssl_ota_verify_t* ota;
+    int ret;
+
+    if (pub == NULL || pub_sz == 0 || v == NULL) {
+        return BAD_FUNC_ARG;
+    }
+    *v = NULL;
+
+    ota = (esp_wolfssl_ota_verify_t*)XMALLOC(sizeof(*ota), NULL,
+                                             DYNAMIC_TYPE_SIGNATURE);
+    if (ota == NULL) {
+        return MEMORY_E;
+    }
+    memset(ota, 0, sizeof(*ota));
+    ota->type = type;
+
+    switch (type) {
+#ifdef HAVE_ECC
+    case ESP_WOLFSSL_OTA_SIG_ECDSA: {
+        word32 idx = 0;
+
+        ret = wc_ecc_init(&ota->key.ecc);
+        if (ret == 0) {
+            ret = wc_EccPublicKeyDecode(pub, &idx, &ota->key.ecc,
+                                        (word32)pub_sz);
+            if (ret != 0) {
+                wc_ecc_free(&ota->key.ecc);
+            }
+        }
+        break;
+    }
+#endif
+#ifdef WOLFSSL_HAVE_LMS
+    case ESP_WOLFSSL_OTA_SIG_LMS:
+        ret = ota_lms_import(&ota->key.lms, pub, pub_sz);
+        break;
+#endif
+#ifndef HAVE_ECC
+    case ESP_WOLFSSL_OTA_SIG_ECDSA:
+#endif
+#ifndef WOLFSSL_HAVE_LMS
+    case ESP_WOLFSSL_OTA_SIG_LMS:
+#endif
+        ret = NOT_COMPILED_IN;
+        break;
+    default:
+        ret = BAD_FUNC_ARG;
+        break;
+    }
+    if (ret != 0) {
+        XFREE(ota, NULL, DYNAMIC_TYPE_SIGNATURE);
+        return ret;
+    }
+
+    /* the accelerator is taken on the first block, if it is free */
+    ret = wc_InitSha256_ex(&ota->sha, NULL, INVALID_DEVID);
+    if (ret != 0) {
+        ota->done = 1;
+        esp_wolfssl_ota_verify_free(ota);
+        return ret;
+    }
+
+    *v = ota;
+    return 0;
+}
+
+int esp_wolfssl_ota_verify_update(esp_wolfssl_ota_verify_t* v,
+                                  const void* chunk, size_t len)
+{
+    const byte* p = (const byte*)chunk;
+    int ret = 0;
+
+    if (v == NULL || (chunk == NULL && len > 0)) {
+        return BAD_FUNC_ARG;
+    }
+    if (v->done) {
+        return BAD_STATE_E;
+    }
+
+    /* word32 lengths in wolfCrypt */
+    while (ret == 0 && len > 0) {
+        word32 n = (len > 0x40000000) ? 0x40000000 : (word32)len;
+
+        ret = wc_Sha256Update(&v->sha, p, n);
+        p += n;
+        len -= n;
+        v->size += n;
+    }
+    return ret;
+}
+
+int esp_wolfssl_ota_verify_final(esp_wolfssl_ota_verify_t* v,
+                                 const unsigned char* sig, size_t sig_sz,
+                                 unsigned char* digest)
+{
+    byte hash[WC_SHA256_DIGEST_SIZE];
+    int ret;
+
+    if (v == NULL || sig == NULL || sig_sz == 0) {
+        return BAD_FUNC_ARG;
+    }
+    if (v->done) {
+        return BAD_STATE_E;
+    }
+    v->done = 1;
+
+    /* also releases the accelerator */
+    ret = wc_Sha256Final(&v->sha, hash);
+    wc_Sha256Free(&v->sha);
+    if (ret != 0) {
+        return ret;
+    }
+    if (digest != NULL) {
+        memcpy(digest, hash, sizeof(hash));
+    }
+
+    switch (v->type) {
+#ifdef HAVE_ECC
+    case ESP_WOLFSSL_OTA_SIG_ECDSA:
+        ret = wc_SignatureVerifyHash(WC_HASH_TYPE_SHA256,
+                                     WC_SIGNATURE_TYPE_ECC,
+                                     hash, sizeof(hash),
+                                     sig, (word32)sig_sz,
+                                     &v->key.ecc, sizeof(v->key.ecc));
+        break;
+#endif
+#ifdef WOLFSSL_HAVE_LMS
+    case ESP_WOLFSSL_OTA_SIG_LMS:
+        ret = wc_LmsKey_Verify(&v->key.lms, sig, (word32)sig_sz,
+                               hash, sizeof(hash));
+        break;
+#endif
+    default:
+        ret = BAD_STATE_E;
+        break;
+    }
+    return ret;
+}
+
+uint64_t esp_wolfssl_ota_verify_size(const esp_wolfssl_ota_verify_t* v)
+{
+    return (v != NULL) ? v->size : 0;
+}
+
+void esp_wolfssl_ota_verify_free(esp_wolfssl_ota_verify_t* v)
+{
+    if (v == NULL) {
+        return;
+    }
+    if (!v->done) {
+        wc_Sha256Free(&v->sha);
+    }
+    switch (v->type) {
+#ifdef HAVE_ECC
+    case ESP_WOLFSSL_OTA_SIG_ECDSA:
+        wc_ecc_free(&v->key.ecc);
+        break;
+#endif
+#ifdef WOLFSSL_HAVE_LMS
+    case ESP_WOLFSSL_OTA_SIG_LMS:
+        wc_LmsKey_Free(&v->key.lms);
+        break;
+#endif
+    default:
+        break;
+    }
+    XFREE(v, NULL, DYNAMIC_TYPE_SIGNATURE);
+}
+
+#endif /* WOLFSSL_ESP_OTA_VERIFY */
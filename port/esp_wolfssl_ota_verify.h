@@ -0,0 +1,111 @@
+/* esp_wolfssl_ota_verify.h
+ *
+ * Copyright (C) 2006-2024 wolfSSL Inc.
+ *
+ * This file is part of wolfSSL.
+ *
+ * wolfSSL is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfSSL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335, USA
+ */
+
+/* Streaming verification of firmware images.
+ *
+ * Enabled with Kconfig WOLFSSL_OTA_VERIFY. Feed the image to
+ * esp_wolfssl_ota_verify_update() in the chunks it is downloaded in, next
+ * to esp_ota_write(), and check the signature with
+ * esp_wolfssl_ota_verify_final() when the last chunk arrived: the image is
+ * hashed once while it streams by and never read back from flash.
+ *
+ *   esp_wolfssl_ota_verify_new(ESP_WOLFSSL_OTA_SIG_ECDSA, pub, pub_sz, &v);
+ *   while ((n = read_chunk(buf, sizeof(buf))) > 0) {
+ *       esp_ota_write(ota, buf, n);
+ *       esp_wolfssl_ota_verify_update(v, buf, n);
+ *   }
+ *   if (esp_wolfssl_ota_verify_final(v, sig, sig_sz, NULL) == 0) {
+ *       esp_ota_end(ota);
+ *       esp_ota_set_boot_partition(part);
+ *   }
+ *   esp_wolfssl_ota_verify_free(v);
+ *
+ * The signature is detached and covers the SHA-256 digest of the image:
+ *
+ * - ECDSA: a DER encoded signature of the digest, checked with a DER
+ *   SubjectPublicKeyInfo public key, as made by
+ *     openssl ec -in key.pem -pubout -outform DER -out pub.der
+ *     openssl dgst -sha256 -sign key.pem -out image.sig image.bin
+ * - LMS (Kconfig WOLFSSL_OTA_VERIFY_LMS): an HSS/LMS signature (RFC 8554)
+ *   whose message is the 32 byte digest itself, checked with the 60 byte
+ *   HSS public key. The parameter set is taken from the public key; all
+ *   levels must use the same one. LMS is hash based and not broken by a
+ *   quantum computer.
+ *
+ * The digest runs on the SHA accelerator when it is free at the first
+ * update, and the context keeps it until esp_wolfssl_ota_verify_final();
+ * other SHA users, e.g. the TLS connection the image arrives on, fall back
+ * to software meanwhile.
+ */
+
+#ifndef _ESP_WOLFSSL_OTA_VERIFY_H_
+#define _ESP_WOLFSSL_OTA_VERIFY_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <wolfssl/wolfcrypt/settings.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum esp_wolfssl_ota_sig_t {
+    ESP_WOLFSSL_OTA_SIG_ECDSA = 1,      /* ECDSA with SHA-256 */
+    ESP_WOLFSSL_OTA_SIG_LMS   = 2,      /* HSS/LMS of the SHA-256 digest */
+} esp_wolfssl_ota_sig_t;
+
+typedef struct esp_wolfssl_ota_verify_t esp_wolfssl_ota_verify_t;
+
+#ifdef WOLFSSL_ESP_OTA_VERIFY
+
+/* Starts a verification with the public key of the image signer. Returns
+ * 0, BAD_FUNC_ARG, NOT_COMPILED_IN for a signature type not built in,
+ * ASN_PARSE_E or BUFFER_E for a bad key, or MEMORY_E. */
+int esp_wolfssl_ota_verify_new(esp_wolfssl_ota_sig_t type,
+                               const unsigned char* pub, size_t pub_sz,
+                               esp_wolfssl_ota_verify_t** v);
+
+/* Hashes the next chunk of the image. Returns 0 or a wolfCrypt error. */
+int esp_wolfssl_ota_verify_update(esp_wolfssl_ota_verify_t* v,
+                                  const void* chunk, size_t len);
+
+/* Checks the signature over all chunks so far; the verification is over
+ * afterwards and only _free() remains. Returns 0 for a good signature,
+ * SIG_VERIFY_E for a bad one, BAD_STATE_E when called twice, or another
+ * wolfCrypt error, e.g. for a malformed signature. digest, if not NULL,
+ * receives the 32 byte SHA-256 of the image either way. */
+int esp_wolfssl_ota_verify_final(esp_wolfssl_ota_verify_t* v,
+                                 const unsigned char* sig, size_t sig_sz,
+                                 unsigned char* digest);
+
+/* Bytes hashed so far. */
+uint64_t esp_wolfssl_ota_verify_size(const esp_wolfssl_ota_verify_t* v);
+
+void esp_wolfssl_ota_verify_free(esp_wolfssl_ota_verify_t* v);
+
+#endif /* WOLFSSL_ESP_OTA_VERIFY */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _ESP_WOLFSSL_OTA_VERIFY_H_ */
@@ -0,0 +1,904 @@
+/* esp_wolfssl_pkcs7_stream.c
+ *
+ * Copyright (C) 2006-2024 wolfSSL Inc.
+ *
+ * This file is part of wolfSSL.
+ *
+ * wolfSSL is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfSSL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335, USA
+ */
+
+#include <wolfssl/wolfcrypt/settings.h>
+
+#ifdef WOLFSSL_ESP_PKCS7_STREAM
+
+#include <stdint.h>
+#include <string.h>
+
+#include <wolfssl/ssl.h>
+#include <wolfssl/wolfcrypt/types.h>
+#include <wolfssl/wolfcrypt/error-crypt.h>
+#include <wolfssl/wolfcrypt/hash.h>
+#include <wolfssl/wolfcrypt/pkcs7.h>
+#include <wolfssl/wolfcrypt/random.h>
+#if !defined(NO_RSA) && !defined(NO_AES) && defined(HAVE_AES_CBC) && \
+    defined(HAVE_AES_DECRYPT)
+    #include <wolfssl/wolfcrypt/aes.h>
+    #include <wolfssl/wolfcrypt/rsa.h>
+    #define P7_HAVE_DECRYPT
+#endif
+
+#include "esp_wolfssl_cert_view.h"
+#include "esp_wolfssl_der.h"
+#include "esp_wolfssl_pkcs7_stream.h"
+
+#ifndef ESP_WOLFSSL_PKCS7_HEAD_MAX
+    #define ESP_WOLFSSL_PKCS7_HEAD_MAX  2048
+#endif
+#ifndef ESP_WOLFSSL_PKCS7_TAIL_MAX
+    #define ESP_WOLFSSL_PKCS7_TAIL_MAX  8192
+#endif
+
+/* ciphertext decrypted at a time, whole AES blocks */
+#define P7_WORK     256
+/* p7_hdr() and the parsers: the element is not complete yet */
+#define P7_MORE     1
+
+enum {
+    P7_VERIFY,
+    P7_DECRYPT
+};
+
+enum {
+    P7_HEAD,                    /* buffering up to the content */
+    P7_CONTENT,
+    P7_TAIL,                    /* after the content, to the end */
+    P7_DONE
+};
+
+struct esp_wolfssl_pkcs7_stream_t {
+    int                      mode;
+    int                      state;
+    int                      error;
+    esp_wolfssl_pkcs7_out_cb out;
+    void*                    arg;
+    byte*                    head;
+    size_t                   head_fill;
+    size_t                   head_sz;        /* parsed: up to the content */
+    byte*                    tail;
+    size_t                   tail_sz;        /* allocated */
+    size_t                   tail_fill;
+    uint64_t                 end;            /* of the ContentInfo */
+    uint64_t                 content_left;
+    uint64_t                 tail_left;
+    uint64_t                 in;
+    uint64_t                 content;
+    size_t                   mem;
+    size_t                   mem_peak;
+    /* P7_VERIFY */
+    const byte*              ca;
+    size_t                   ca_sz;
+    enum wc_HashType         hash_type;
+    wc_HashAlg               hash;
+#ifdef P7_HAVE_DECRYPT
+    /* P7_DECRYPT */
+    const byte*              cert;
+    size_t                   cert_sz;
+    const byte*              key;
+    size_t                   key_sz;
+    esp_wolfssl_der_t        recipients;     /* in head */
+    esp_wolfssl_der_t        alg;            /* in head */
+    Aes                      aes;
+    int                      aes_init;
+    byte                     ct[P7_WORK];
+    size_t                   ct_fill;
+#endif
+};
+
+static const byte p7_oid_signed[] = {
+    0x2A, 0x86, 0x48, 0x86, 0xF7, 0x0D, 0x01, 0x07, 0x02
+};
+static const byte p7_oid_enveloped[] = {
+    0x2A, 0x86, 0x48, 0x86, 0xF7, 0x0D, 0x01, 0x07, 0x03
+};
+
+static const struct {
+    byte             oid[9];
+    byte             oid_sz;
+    enum wc_HashType type;
+} p7_hashes[] = {
+    { { 0x2B, 0x0E, 0x03, 0x02, 0x1A }, 5, WC_HASH_TYPE_SHA },
+    { { 0x60, 0x86, 0x48, 0x01, 0x65, 0x03, 0x04, 0x02, 0x01 }, 9,
+      WC_HASH_TYPE_SHA256 },
+    { { 0x60, 0x86, 0x48, 0x01, 0x65, 0x03, 0x04, 0x02, 0x02 }, 9,
+      WC_HASH_TYPE_SHA384 },
+    { { 0x60, 0x86, 0x48, 0x01, 0x65, 0x03, 0x04, 0x02, 0x03 }, 9,
+      WC_HASH_TYPE_SHA512 },
+};
+
+static void* p7_alloc(esp_wolfssl_pkcs7_stream_t* s, size_t sz)
+{
+    void* p = XMALLOC(sz, NULL, DYNAMIC_TYPE_PKCS7);
+
+    if (p != NULL && s != NULL) {
+        s->mem += sz;
+        if (s->mem > s->mem_peak) {
+            s->mem_peak = s->mem;
+        }
+    }
+    return p;
+}
+
+static void p7_free(esp_wolfssl_pkcs7_stream_t* s, void* p, size_t sz)
+{
+    if (p != NULL) {
+        XFREE(p, NULL, DYNAMIC_TYPE_PKCS7);
+        s->mem -= sz;
+    }
+}
+
+static int p7_oid_is(const esp_wolfssl_der_t* oid, const byte* want,
+                     size_t sz)
+{
+    return oid->len == sz && memcmp(oid->p, want, sz) == 0;
+}
+
+/* Tag and definite length at *pos of a partly received buffer; moves *pos
+ * to the contents. Returns 0, P7_MORE or ASN_PARSE_E. */
+static int p7_hdr(const byte* b, size_t n, size_t* pos, byte* tag,
+                  word32* len)
+{
+    size_t i = *pos;
+    word32 l;
+    int k;
+
+    if (i + 2 > n) {
+        return P7_MORE;
+    }
+    if ((b[i] & 0x1F) == 0x1F) {
+        return ASN_PARSE_E;
+    }
+    *tag = b[i];
+    l = b[i + 1];
+    i += 2;
+    if (l & 0x80) {
+        /* 0x80 is an indefinite length, i.e. BER */
+        k = l & 0x7F;
+        if (k == 0 || k > 4) {
+            return ASN_PARSE_E;
+        }
+        if (i + k > n) {
+            return P7_MORE;
+        }
+        for (l = 0; k > 0; k--) {
+            l = (l << 8) | b[i++];
+        }
+    }
+    *len = l;
+    *pos = i;
+    return 0;
+}
+
+/* the header of a constructed element to step into */
+static int p7_open(const byte* b, size_t n, size_t* pos, byte tag,
+                   word32* len)
+{
+    byte t = 0;
+    int ret = p7_hdr(b, n, pos, &t, len);
+
+    return (ret == 0 && t != tag) ? ASN_PARSE_E : ret;
+}
+
+/* a whole element, which must have been received */
+static int p7_elem(const byte* b, size_t n, size_t* pos, byte tag,
+                   esp_wolfssl_der_t* val)
+{
+    size_t i = *pos;
+    word32 len = 0;
+    int ret = p7_open(b, n, &i, tag, &len);
+
+    if (ret == 0 && len > n - i) {
+        ret = P7_MORE;
+    }
+    if (ret == 0) {
+        esp_wolfssl_der_init(val, b + i, len);
+        *pos = i + len;
+    }
+    return ret;
+}
+
+/* ContentInfo, contentType and the [0] and SEQUENCE of the content */
+static int p7_parse_content_info(esp_wolfssl_pkcs7_stream_t* s, size_t* pos,
+                                 const byte* oid, size_t oid_sz)
+{
+    const byte* b = s->head;
+    size_t n = s->head_fill;
+    esp_wolfssl_der_t val;
+    word32 len = 0;
+    int ret;
+
+    ret = p7_open(b, n, pos, ESP_WOLFSSL_DER_SEQUENCE, &len);
+    if (ret == 0) {
+        s->end = (uint64_t)*pos + len;
+        ret = p7_elem(b, n, pos, ESP_WOLFSSL_DER_OID, &val);
+    }
+    if (ret == 0 && !p7_oid_is(&val, oid, oid_sz)) {
+        ret = ASN_PARSE_E;
+    }
+    if (ret == 0) {
+        ret = p7_open(b, n, pos, ESP_WOLFSSL_DER_CONTEXT(0), &len);
+    }
+    if (ret == 0) {
+        ret = p7_open(b, n, pos, ESP_WOLFSSL_DER_SEQUENCE, &len);
+    }
+    if (ret == 0) {
+        /* version */
+        ret = p7_elem(b, n, pos, ESP_WOLFSSL_DER_INTEGER, &val);
+    }
+    return ret;
+}
+
+static int p7_parse_signed(esp_wolfssl_pkcs7_stream_t* s)
+{
+    const byte* b = s->head;
+    size_t n = s->head_fill;
+    esp_wolfssl_der_t val;
+    esp_wolfssl_der_t alg;
+    size_t pos = 0;
+    word32 len = 0;
+    size_t i;
+    int ret;
+
+    ret = p7_parse_content_info(s, &pos, p7_oid_signed,
+                                sizeof(p7_oid_signed));
+    if (ret == 0) {
+        /* digestAlgorithms: the content is hashed with the first */
+        ret = p7_elem(b, n, &pos, ESP_WOLFSSL_DER_SET, &val);
+    }
+    if (ret == 0 &&
+        (esp_wolfssl_der_expect(&val, ESP_WOLFSSL_DER_SEQUENCE, &alg) != 0 ||
+         esp_wolfssl_der_expect(&alg, ESP_WOLFSSL_DER_OID, &alg) != 0)) {
+        ret = ASN_PARSE_E;
+    }
+    if (ret == 0) {
+        ret = ASN_SIG_HASH_E;
+        for (i = 0; i < sizeof(p7_hashes) / sizeof(p7_hashes[0]); i++) {
+            if (p7_oid_is(&alg, p7_hashes[i].oid, p7_hashes[i].oid_sz)) {
+                s->hash_type = p7_hashes[i].type;
+                ret = 0;
+            }
+        }
+    }
+    /* encapContentInfo: eContentType, [0] EXPLICIT OCTET STRING */
+    if (ret == 0) {
+        ret = p7_open(b, n, &pos, ESP_WOLFSSL_DER_SEQUENCE, &len);
+    }
+    if (ret == 0) {
+        ret = p7_elem(b, n, &pos, ESP_WOLFSSL_DER_OID, &val);
+    }
+    if (ret == 0) {
+        ret = p7_open(b, n, &pos, ESP_WOLFSSL_DER_CONTEXT(0), &len);
+    }
+    if (ret == 0) {
+        /* a constructed OCTET STRING is BER */
+        ret = p7_open(b, n, &pos, ESP_WOLFSSL_DER_OCTET_STRING, &len);
+    }
+    if (ret == 0) {
+        s->head_sz = pos;
+        s->content_left = len;
+    }
+    return ret;
+}
+
+#ifdef P7_HAVE_DECRYPT
+static void p7_zero(void* p, size_t n)
+{
+    volatile byte* v = (volatile byte*)p;
+
+    while (n-- > 0) {
+        *v++ = 0;
+    }
+}
+
+static int p7_parse_enveloped(esp_wolfssl_pkcs7_stream_t* s)
+{
+    const byte* b = s->head;
+    size_t n = s->head_fill;
+    esp_wolfssl_der_t val;
+    size_t pos = 0;
+    word32 len = 0;
+    byte tag = 0;
+    int ret;
+
+    ret = p7_parse_content_info(s, &pos, p7_oid_enveloped,
+                                sizeof(p7_oid_enveloped));
+    if (ret == 0 && pos < n && b[pos] == ESP_WOLFSSL_DER_CONTEXT(0)) {
+        /* originatorInfo */
+        ret = p7_elem(b, n, &pos, ESP_WOLFSSL_DER_CONTEXT(0), &val);
+    }
+    if (ret == 0) {
+        ret = p7_elem(b, n, &pos, ESP_WOLFSSL_DER_SET, &s->recipients);
+    }
+    /* encryptedContentInfo: contentType, contentEncryptionAlgorithm,
+     * [0] IMPLICIT OCTET STRING */
+    if (ret == 0) {
+        ret = p7_open(b, n, &pos, ESP_WOLFSSL_DER_SEQUENCE, &len);
+    }
+    if (ret == 0) {
+        ret = p7_elem(b, n, &pos, ESP_WOLFSSL_DER_OID, &val);
+    }
+    if (ret == 0) {
+        ret = p7_elem(b, n, &pos, ESP_WOLFSSL_DER_SEQUENCE, &s->alg);
+    }
+    if (ret == 0) {
+        ret = p7_hdr(b, n, &pos, &tag, &len);
+    }
+    if (ret == 0 && (tag != ESP_WOLFSSL_DER_CONTEXT_PRIM(0) || len == 0 ||
+                     len % AES_BLOCK_SIZE != 0)) {
+        ret = ASN_PARSE_E;
+    }
+    if (ret == 0) {
+        s->head_sz = pos;
+        s->content_left = len;
+    }
+    return ret;
+}
+
+static int p7_der_eq(const esp_wolfssl_der_t* a, const esp_wolfssl_der_t* b)
+{
+    return a->len == b->len && memcmp(a->p, b->p, a->len) == 0;
+}
+
+/* encryptedKey of the KeyTransRecipientInfo for our certificate */
+static int p7_find_recipient(esp_wolfssl_pkcs7_stream_t* s,
+                             esp_wolfssl_der_t* ek)
+{
+    static const byte rsa_oid[] = {
+        0x2A, 0x86, 0x48, 0x86, 0xF7, 0x0D, 0x01, 0x01, 0x01
+    };
+    esp_wolfssl_cert_view_t cert;
+    esp_wolfssl_der_t set = s->recipients;
+    esp_wolfssl_der_t ri;
+    esp_wolfssl_der_t ias;
+    esp_wolfssl_der_t a;
+    esp_wolfssl_der_t b;
+    esp_wolfssl_der_t alg;
+    int ret;
+
+    ret = esp_wolfssl_cert_view_parse(s->cert, s->cert_sz, &cert);
+    if (ret != 0) {
+        return ret;
+    }
+
+    while (esp_wolfssl_der_peek(&set) >= 0) {
+        uint8_t tag = 0;
+
+        if (esp_wolfssl_der_next(&set, &tag, &ri, NULL) != 0) {
+            return ASN_PARSE_E;
+        }
+        /* KeyTransRecipientInfo with an IssuerAndSerialNumber; the other
+         * kinds are [1].. [4] */
+        if (tag != ESP_WOLFSSL_DER_SEQUENCE ||
+            esp_wolfssl_der_expect(&ri, ESP_WOLFSSL_DER_INTEGER, NULL) != 0 ||
+            esp_wolfssl_der_expect(&ri, ESP_WOLFSSL_DER_SEQUENCE, &ias) != 0) {
+            continue;
+        }
+        if (esp_wolfssl_der_next(&ias, NULL, NULL, &a) != 0 ||
+            esp_wolfssl_der_expect(&ias, ESP_WOLFSSL_DER_INTEGER, &b) != 0 ||
+            !p7_der_eq(&a, &cert.issuer) || !p7_der_eq(&b, &cert.serial)) {
+            continue;
+        }
+        if (esp_wolfssl_der_expect(&ri, ESP_WOLFSSL_DER_SEQUENCE, &alg) != 0 ||
+            esp_wolfssl_der_expect(&alg, ESP_WOLFSSL_DER_OID, &alg) != 0 ||
+            esp_wolfssl_der_expect(&ri, ESP_WOLFSSL_DER_OCTET_STRING,
+                                   ek) != 0) {
+            return ASN_PARSE_E;
+        }
+        return p7_oid_is(&alg, rsa_oid, sizeof(rsa_oid)) ? 0
+                                                          : ASN_PARSE_E;
+    }
+    return PKCS7_RECIP_E;
+}
+
+/* Unwraps the content encryption key and sets up AES-CBC. A key that does
+ * not unwrap is replaced by a random one, so that a wrong key or a forged
+ * encryptedKey both end in BAD_PADDING_E and tell an attacker nothing
+ * about the RSA padding (RFC 3218). */
+static int p7_start_decrypt(esp_wolfssl_pkcs7_stream_t* s)
+{
+    static const byte aes_oid[] = {
+        0x60, 0x86, 0x48, 0x01, 0x65, 0x03, 0x04, 0x01
+    };
+    esp_wolfssl_der_t alg = s->alg;
+    esp_wolfssl_der_t oid;
+    esp_wolfssl_der_t iv;
+    esp_wolfssl_der_t ek;
+    byte cek[AES_256_KEY_SIZE];
+    word32 key_sz = 0;
+    word32 idx = 0;
+    RsaKey* rsa;
+    WC_RNG rng;
+    int ret;
+
+    if (esp_wolfssl_der_expect(&alg, ESP_WOLFSSL_DER_OID, &oid) != 0 ||
+        esp_wolfssl_der_expect(&alg, ESP_WOLFSSL_DER_OCTET_STRING,
+                               &iv) != 0 ||
+        iv.len != AES_BLOCK_SIZE || oid.len != sizeof(aes_oid) + 1 ||
+        memcmp(oid.p, aes_oid, sizeof(aes_oid)) != 0) {
+        return ASN_PARSE_E;
+    }
+    /* aes128-CBC, aes192-CBC, aes256-CBC */
+    switch (oid.p[sizeof(aes_oid)]) {
+    case 0x02: key_sz = AES_128_KEY_SIZE; break;
+    case 0x16: key_sz = AES_192_KEY_SIZE; break;
+    case 0x2A: key_sz = AES_256_KEY_SIZE; break;
+    default:   return ALGO_ID_E;
+    }
+
+    ret = p7_find_recipient(s, &ek);
+    if (ret != 0) {
+        return ret;
+    }
+
+    ret = wc_InitRng(&rng);
+    if (ret != 0) {
+        return ret;
+    }
+    rsa = (RsaKey*)p7_alloc(s, sizeof(RsaKey));
+    if (rsa == NULL) {
+        ret = MEMORY_E;
+    }
+    else {
+        ret = wc_InitRsaKey(rsa, NULL);
+        if (ret == 0) {
+            ret = wc_RsaPrivateKeyDecode(s->key, &idx, rsa,
+                                         (word32)s->key_sz);
+        #ifdef WC_RSA_BLINDING
+            if (ret == 0) {
+                ret = wc_RsaSetRNG(rsa, &rng);
+            }
+        #endif
+            if (ret == 0 &&
+                wc_RsaPrivateDecrypt(ek.p, (word32)ek.len, cek, sizeof(cek),
+                                     rsa) != (int)key_sz) {
+                ret = wc_RNG_GenerateBlock(&rng, cek, key_sz);
+            }
+            wc_FreeRsaKey(rsa);
+        }
+        p7_free(s, rsa, sizeof(RsaKey));
+    }
+    wc_FreeRng(&rng);
+
+    if (ret == 0) {
+        ret = wc_AesInit(&s->aes, NULL, INVALID_DEVID);
+    }
+    if (ret == 0) {
+        s->aes_init = 1;
+        ret = wc_AesSetKey(&s->aes, cek, key_sz, iv.p, AES_DECRYPTION);
+    }
+    p7_zero(cek, sizeof(cek));
+    return ret;
+}
+
+/* decrypts and passes on ct[0..sz); the last call strips the padding */
+static int p7_decrypt(esp_wolfssl_pkcs7_stream_t* s, size_t sz, int last)
+{
+    byte pt[P7_WORK];
+    byte pad;
+    size_t i;
+    int ret;
+
+    ret = wc_AesCbcDecrypt(&s->aes, pt, s->ct, (word32)sz);
+    if (ret == 0 && last) {
+        pad = pt[sz - 1];
+        if (pad == 0 || pad > AES_BLOCK_SIZE) {
+            ret = BAD_PADDING_E;
+        }
+        for (i = 1; ret == 0 && i <= pad; i++) {
+            if (pt[sz - i] != pad) {
+                ret = BAD_PADDING_E;
+            }
+        }
+        sz -= pad;
+    }
+    if (ret == 0 && sz > 0 && s->out != NULL) {
+        ret = s->out(s->arg, pt, sz);
+    }
+    if (ret == 0) {
+        s->content += sz;
+    }
+    p7_zero(pt, sizeof(pt));
+    return ret;
+}
+#endif /* P7_HAVE_DECRYPT */
+
+/* n bytes of content, at most content_left */
+static int p7_content(esp_wolfssl_pkcs7_stream_t* s, const byte* in,
+                      size_t n)
+{
+    int ret = 0;
+
+    if (s->mode == P7_VERIFY) {
+        s->content_left -= n;
+        ret = wc_HashUpdate(&s->hash, s->hash_type, in, (word32)n);
+        if (ret == 0 && s->out != NULL) {
+            ret = s->out(s->arg, in, n);
+        }
+        if (ret == 0) {
+            s->content += n;
+        }
+        return ret;
+    }
+
+#ifdef P7_HAVE_DECRYPT
+    while (ret == 0 && n > 0) {
+        size_t take = P7_WORK - s->ct_fill;
+
+        if (take > n) {
+            take = n;
+        }
+        memcpy(s->ct + s->ct_fill, in, take);
+        s->ct_fill += take;
+        s->content_left -= take;
+        in += take;
+        n -= take;
+        if (s->ct_fill == P7_WORK && s->content_left > 0) {
+            /* hold back the last block, it may be the padding */
+            ret = p7_decrypt(s, P7_WORK - AES_BLOCK_SIZE, 0);
+            memmove(s->ct, s->ct + P7_WORK - AES_BLOCK_SIZE, AES_BLOCK_SIZE);
+            s->ct_fill = AES_BLOCK_SIZE;
+        }
+    }
+    if (ret == 0 && s->content_left == 0) {
+        ret = p7_decrypt(s, s->ct_fill, 1);
+        s->ct_fill = 0;
+    }
+#endif
+    return ret;
+}
+
+static void p7_next_state(esp_wolfssl_pkcs7_stream_t* s)
+{
+    if (s->state == P7_CONTENT && s->content_left == 0) {
+        s->state = P7_TAIL;
+    }
+    if (s->state == P7_TAIL && s->tail_left == 0) {
+        s->state = P7_DONE;
+    }
+}
+
+static int p7_consume(esp_wolfssl_pkcs7_stream_t* s, const byte* in,
+                      size_t n)
+{
+    int ret = 0;
+
+    while (ret == 0 && n > 0) {
+        size_t take = n;
+
+        if (s->state == P7_CONTENT) {
+            if (take > s->content_left) {
+                take = (size_t)s->content_left;
+            }
+            ret = p7_content(s, in, take);
+        }
+        else if (s->state == P7_TAIL) {
+            if (take > s->tail_left) {
+                take = (size_t)s->tail_left;
+            }
+            /* the unprotectedAttrs of enveloped data are skipped */
+            if (s->tail != NULL) {
+                memcpy(s->tail + s->tail_fill, in, take);
+                s->tail_fill += take;
+            }
+            s->tail_left -= take;
+        }
+        else {
+            /* past the end of the ContentInfo */
+            ret = ASN_PARSE_E;
+        }
+        in += take;
+        n -= take;
+        p7_next_state(s);
+    }
+    return ret;
+}
+
+/* the head is complete: set up for the content and the tail */
+static int p7_start(esp_wolfssl_pkcs7_stream_t* s)
+{
+    uint64_t content_end = s->head_sz + s->content_left;
+    int ret = 0;
+
+    if (s->end < content_end) {
+        return ASN_PARSE_E;
+    }
+    s->tail_left = s->end - content_end;
+
+    if (s->mode == P7_VERIFY) {
+        if (s->tail_left > ESP_WOLFSSL_PKCS7_TAIL_MAX) {
+            return BUFFER_E;
+        }
+        /* + 1: not NULL when empty */
+        s->tail_sz = (size_t)s->tail_left + 1;
+        s->tail = (byte*)p7_alloc(s, s->tail_sz);
+        if (s->tail == NULL) {
+            return MEMORY_E;
+        }
+        ret = wc_HashInit(&s->hash, s->hash_type);
+    }
+#ifdef P7_HAVE_DECRYPT
+    else {
+        ret = p7_start_decrypt(s);
+    }
+#endif
+
+    if (ret == 0) {
+        s->state = P7_CONTENT;
+        p7_next_state(s);
+    }
+    return ret;
+}
+
+static int p7_new(int mode, esp_wolfssl_pkcs7_out_cb out, void* arg,
+                  esp_wolfssl_pkcs7_stream_t** s)
+{
+    esp_wolfssl_pkcs7_stream_t* p7;
+
+    p7 = (esp_wolfssl_pkcs7_stream_t*)XMALLOC(sizeof(*p7), NULL,
+                                              DYNAMIC_TYPE_PKCS7);
+    if (p7 == NULL) {
+        return MEMORY_E;
+    }
+    memset(p7, 0, sizeof(*p7));
+    p7->mode = mode;
+    p7->out = out;
+    p7->arg = arg;
+    p7->mem = p7->mem_peak = sizeof(*p7);
+
+    p7->head = (byte*)p7_alloc(p7, ESP_WOLFSSL_PKCS7_HEAD_MAX);
+    if (p7->head == NULL) {
+        XFREE(p7, NULL, DYNAMIC_TYPE_PKCS7);
+        return MEMORY_E;
+    }
+
+    *s = p7;
+    return 0;
+}
+
+int esp_wolfssl_pkcs7_stream_verify_new(const unsigned char* ca,
+                                        size_t ca_sz,
+                                        esp_wolfssl_pkcs7_out_cb out,
+                                        void* arg,
+                                        esp_wolfssl_pkcs7_stream_t** s)
+{
+    int ret;
+
+    if (ca == NULL || ca_sz == 0 || s == NULL) {
+        return BAD_FUNC_ARG;
+    }
+    ret = p7_new(P7_VERIFY, out, arg, s);
+    if (ret == 0) {
+        (*s)->ca = ca;
+        (*s)->ca_sz = ca_sz;
+    }
+    return ret;
+}
+
+int esp_wolfssl_pkcs7_stream_decrypt_new(const unsigned char* cert,
+                                         size_t cert_sz,
+                                         const unsigned char* key,
+                                         size_t key_sz,
+                                         esp_wolfssl_pkcs7_out_cb out,
+                                         void* arg,
+                                         esp_wolfssl_pkcs7_stream_t** s)
+{
+    int ret;
+
+    if (cert == NULL || cert_sz == 0 || key == NULL || key_sz == 0 ||
+        s == NULL) {
+        return BAD_FUNC_ARG;
+    }
+#ifdef P7_HAVE_DECRYPT
+    ret = p7_new(P7_DECRYPT, out, arg, s);
+    if (ret == 0) {
+        (*s)->cert = cert;
+        (*s)->cert_sz = cert_sz;
+        (*s)->key = key;
+        (*s)->key_sz = key_sz;
+    }
+#else
+    (void)out;
+    (void)arg;
+    ret = NOT_COMPILED_IN;
+#endif
+    return ret;
+}
+
+int esp_wolfssl_pkcs7_stream_update(esp_wolfssl_pkcs7_stream_t* s,
+                                    const void* in, size_t len)
+{
+    const byte* p = (const byte*)in;
+    int ret = 0;
+
+    if (s == NULL || (in == NULL && len > 0)) {
+        return BAD_FUNC_ARG;
+    }
+    if (s->error != 0) {
+        return s->error;
+    }
+    s->in += len;
+
+    if (s->state == P7_HEAD && len > 0) {
+        size_t take = ESP_WOLFSSL_PKCS7_HEAD_MAX - s->head_fill;
+
+        if (take > len) {
+            take = len;
+        }
+        memcpy(s->head + s->head_fill, p, take);
+        s->head_fill += take;
+        p += take;
+        len -= take;
+
+    #ifdef P7_HAVE_DECRYPT
+        if (s->mode == P7_DECRYPT) {
+            ret = p7_parse_enveloped(s);
+        }
+        else
+    #endif
+        {
+            ret = p7_parse_signed(s);
+        }
+        if (ret == P7_MORE) {
+            ret = (s->head_fill == ESP_WOLFSSL_PKCS7_HEAD_MAX) ? BUFFER_E : 0;
+        }
+        else if (ret == 0) {
+            ret = p7_start(s);
+            if (ret == 0) {
+                /* what came after the head */
+                ret = p7_consume(s, s->head + s->head_sz,
+                                 s->head_fill - s->head_sz);
+            }
+            if (s->mode == P7_DECRYPT) {
+                p7_free(s, s->head, ESP_WOLFSSL_PKCS7_HEAD_MAX);
+                s->head = NULL;
+            }
+        }
+    }
+    if (ret == 0 && len > 0) {
+        ret = p7_consume(s, p, len);
+    }
+
+    s->error = ret;
+    return ret;
+}
+
+int esp_wolfssl_pkcs7_stream_chain(void* s, const unsigned char* data,
+                                   size_t len)
+{
+    return esp_wolfssl_pkcs7_stream_update((esp_wolfssl_pkcs7_stream_t*)s,
+                                           data, len);
+}
+
+static int p7_verify(esp_wolfssl_pkcs7_stream_t* s)
+{
+    byte digest[WC_MAX_DIGEST_SIZE];
+    WOLFSSL_CERT_MANAGER* cm;
+    PKCS7* pkcs7;
+    int sz = wc_HashGetDigestSize(s->hash_type);
+    int ret;
+
+    ret = wc_HashFinal(&s->hash, s->hash_type, digest);
+    if (ret != 0) {
+        return ret;
+    }
+
+    pkcs7 = wc_PKCS7_New(NULL, INVALID_DEVID);
+    if (pkcs7 == NULL) {
+        return MEMORY_E;
+    }
+    /* the signer when the bundle carries no certificates */
+    ret = wc_PKCS7_InitWithCert(pkcs7, (byte*)s->ca, (word32)s->ca_sz);
+    if (ret == 0) {
+        ret = wc_PKCS7_VerifySignedData_ex(pkcs7, digest, (word32)sz,
+                                           s->head, (word32)s->head_sz,
+                                           s->tail, (word32)s->tail_fill);
+    }
+    if (ret == 0 && (pkcs7->verifyCert == NULL || pkcs7->verifyCertSz == 0)) {
+        ret = SIG_VERIFY_E;
+    }
+
+    /* the signer's certificate must be or be issued by the CA */
+    if (ret == 0) {
+        cm = wolfSSL_CertManagerNew();
+        if (cm == NULL) {
+            ret = MEMORY_E;
+        }
+        else {
+            ret = wolfSSL_CertManagerLoadCABuffer(cm, s->ca, (long)s->ca_sz,
+                                                  WOLFSSL_FILETYPE_ASN1);
+            if (ret == WOLFSSL_SUCCESS) {
+                ret = wolfSSL_CertManagerVerifyBuffer(cm, pkcs7->verifyCert,
+                                                      pkcs7->verifyCertSz,
+                                                      WOLFSSL_FILETYPE_ASN1);
+            }
+            ret = (ret == WOLFSSL_SUCCESS) ? 0 : ret;
+            wolfSSL_CertManagerFree(cm);
+        }
+    }
+
+    wc_PKCS7_Free(pkcs7);
+    return ret;
+}
+
+int esp_wolfssl_pkcs7_stream_final(esp_wolfssl_pkcs7_stream_t* s)
+{
+    int ret;
+
+    if (s == NULL) {
+        return BAD_FUNC_ARG;
+    }
+    if (s->error != 0) {
+        return s->error;
+    }
+    if (s->state != P7_DONE) {
+        ret = BUFFER_E;
+    }
+    else if (s->mode == P7_VERIFY) {
+        ret = p7_verify(s);
+    }
+    else {
+        /* the padding was checked with the last block */
+        ret = 0;
+    }
+
+    /* a stream is decoded once */
+    s->error = (ret != 0) ? ret : BAD_STATE_E;
+    return ret;
+}
+
+void esp_wolfssl_pkcs7_stream_get_stats(const esp_wolfssl_pkcs7_stream_t* s,
+                                  esp_wolfssl_pkcs7_stream_stats_t* stats)
+{
+    if (stats == NULL) {
+        return;
+    }
+    memset(stats, 0, sizeof(*stats));
+    if (s != NULL) {
+        stats->in = s->in;
+        stats->content = s->content;
+        stats->mem = s->mem;
+        stats->mem_peak = s->mem_peak;
+    }
+}
+
+void esp_wolfssl_pkcs7_stream_free(esp_wolfssl_pkcs7_stream_t* s)
+{
+    if (s == NULL) {
+        return;
+    }
+    if (s->mode == P7_VERIFY && s->state != P7_HEAD) {
+        wc_HashFree(&s->hash, s->hash_type);
+    }
+#ifdef P7_HAVE_DECRYPT
+    if (s->aes_init) {
+        wc_AesFree(&s->aes);
+    }
+#endif
+    p7_free(s, s->head, ESP_WOLFSSL_PKCS7_HEAD_MAX);
+    p7_free(s, s->tail, s->tail_sz);
+    memset(s, 0, sizeof(*s));
+    XFREE(s, NULL, DYNAMIC_TYPE_PKCS7);
+}
+
+#endif /* WOLFSSL_ESP_PKCS7_STREAM */
@@ -0,0 +1,145 @@
+/* esp_wolfssl_pkcs7_stream.h
+ *
+ * Copyright (C) 2006-2024 wolfSSL Inc.
+ *
+ * This file is part of wolfSSL.
+ *
+ * wolfSSL is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfSSL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335, USA
+ */
+
+/* Streaming decoding of large PKCS#7 / CMS bundles.
+ *
+ * Enabled with Kconfig WOLFSSL_PKCS7_STREAM. wc_PKCS7_VerifySignedData()
+ * and wc_PKCS7_DecodeEnvelopedData() need the whole bundle, and for
+ * enveloped data a second buffer for the content, in RAM. A stream takes
+ * the bundle in chunks of any size and passes the content to a callback
+ * as it is decoded, so a bundle can be far larger than free heap:
+ *
+ * - SignedData: the content is hashed on the fly, and only the part
+ *   before it and the certificates and signer infos after it are
+ *   buffered, for wc_PKCS7_VerifySignedData_ex() at the end. The signer's
+ *   certificate must verify against a given CA certificate (or be it).
+ * - EnvelopedData for an RSA key transport recipient (rsaEncryption, as
+ *   from openssl cms -encrypt) with AES-CBC: the content encryption key
+ *   is unwrapped once the recipient infos are in, and the content is
+ *   decrypted block by block.
+ *
+ * The heap held is bounded by ESP_WOLFSSL_PKCS7_HEAD_MAX and, for signed
+ * data, ESP_WOLFSSL_PKCS7_TAIL_MAX plus about 1 KB, whatever the content
+ * size; esp_wolfssl_pkcs7_stream_get_stats() reports the peak.
+ * wc_PKCS7_VerifySignedData_ex() allocates a few KB more during _final().
+ *
+ * Content is passed on before the signature is checked: write it where
+ * it does no harm until esp_wolfssl_pkcs7_stream_final() returned 0, e.g.
+ * to the inactive OTA partition. A signed bundle whose content is an
+ * encrypted one is decoded by chaining two streams:
+ *
+ *   esp_wolfssl_pkcs7_stream_decrypt_new(cert, cert_sz, key, key_sz,
+ *                                        write_cb, ota, &inner);
+ *   esp_wolfssl_pkcs7_stream_verify_new(ca, ca_sz,
+ *                                       esp_wolfssl_pkcs7_stream_chain,
+ *                                       inner, &outer);
+ *   while ((n = read_chunk(buf, sizeof(buf))) > 0
+ *          && esp_wolfssl_pkcs7_stream_update(outer, buf, n) == 0) {
+ *   }
+ *   ok = esp_wolfssl_pkcs7_stream_final(outer) == 0
+ *        && esp_wolfssl_pkcs7_stream_final(inner) == 0;
+ *
+ * Only DER with definite lengths is accepted, as openssl cms writes it
+ * without -stream; an indefinite length BER bundle fails with
+ * ASN_PARSE_E. Certificate dates are checked, so set the clock first.
+ */
+
+#ifndef _ESP_WOLFSSL_PKCS7_STREAM_H_
+#define _ESP_WOLFSSL_PKCS7_STREAM_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <wolfssl/wolfcrypt/settings.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Receives decoded content; a non-zero return fails the stream with it. */
+typedef int (*esp_wolfssl_pkcs7_out_cb)(void* arg, const unsigned char* data,
+                                        size_t len);
+
+typedef struct esp_wolfssl_pkcs7_stream_t esp_wolfssl_pkcs7_stream_t;
+
+typedef struct esp_wolfssl_pkcs7_stream_stats_t {
+    uint64_t in;                /* bundle bytes consumed */
+    uint64_t content;           /* bytes passed to the callback */
+    size_t   mem;               /* heap held by the stream now */
+    size_t   mem_peak;
+} esp_wolfssl_pkcs7_stream_stats_t;
+
+#ifdef WOLFSSL_ESP_PKCS7_STREAM
+
+/* A stream for SignedData. ca, the DER certificate that must have issued
+ * the signer's certificate, or be it, must stay valid until _free(); out
+ * may be NULL to only verify. Returns 0, BAD_FUNC_ARG or MEMORY_E. */
+int esp_wolfssl_pkcs7_stream_verify_new(const unsigned char* ca,
+                                        size_t ca_sz,
+                                        esp_wolfssl_pkcs7_out_cb out,
+                                        void* arg,
+                                        esp_wolfssl_pkcs7_stream_t** s);
+
+/* A stream for EnvelopedData addressed to the DER certificate cert, with
+ * its DER RSA private key (PKCS#1 or PKCS#8); both must stay valid until
+ * _free(). Returns 0, BAD_FUNC_ARG, NOT_COMPILED_IN without RSA or
+ * AES-CBC, or MEMORY_E. */
+int esp_wolfssl_pkcs7_stream_decrypt_new(const unsigned char* cert,
+                                         size_t cert_sz,
+                                         const unsigned char* key,
+                                         size_t key_sz,
+                                         esp_wolfssl_pkcs7_out_cb out,
+                                         void* arg,
+                                         esp_wolfssl_pkcs7_stream_t** s);
+
+/* Decodes the next chunk of the bundle. Returns 0, or the error that
+ * failed the stream, which every later call returns too: ASN_PARSE_E for
+ * an unexpected structure, BUFFER_E when the part before the content
+ * does not fit ESP_WOLFSSL_PKCS7_HEAD_MAX or the part after it
+ * ESP_WOLFSSL_PKCS7_TAIL_MAX, PKCS7_RECIP_E when no recipient info is for
+ * the certificate, BAD_PADDING_E for a wrong key or corrupt content, or
+ * the error of the callback. */
+int esp_wolfssl_pkcs7_stream_update(esp_wolfssl_pkcs7_stream_t* s,
+                                    const void* in, size_t len);
+
+/* esp_wolfssl_pkcs7_stream_update() as an esp_wolfssl_pkcs7_out_cb, with
+ * the stream as arg, to decode the content of one bundle with another. */
+int esp_wolfssl_pkcs7_stream_chain(void* s, const unsigned char* data,
+                                   size_t len);
+
+/* Ends the bundle: 0 when it was complete and, for signed data, the
+ * signature and the signer's certificate verified. Otherwise BUFFER_E for
+ * a truncated bundle, the stream's error, or the error of the signature
+ * or certificate verification. */
+int esp_wolfssl_pkcs7_stream_final(esp_wolfssl_pkcs7_stream_t* s);
+
+void esp_wolfssl_pkcs7_stream_get_stats(const esp_wolfssl_pkcs7_stream_t* s,
+                                  esp_wolfssl_pkcs7_stream_stats_t* stats);
+
+void esp_wolfssl_pkcs7_stream_free(esp_wolfssl_pkcs7_stream_t* s);
+
+#endif /* WOLFSSL_ESP_PKCS7_STREAM */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _ESP_WOLFSSL_PKCS7_STREAM_H_ */
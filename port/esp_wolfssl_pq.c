@@ -0,0 +1,277 @@
+/* esp_wolfssl_pq.c
+ *
+ * Copyright (C) 2006-2024 wolfSSL Inc.
+ *
+ * This file is part of wolfSSL.
+ *
+ * wolfSSL is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfSSL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335, USA
+ */
+
+#include <wolfssl/wolfcrypt/settings.h>
+
+#ifdef WOLFSSL_ESP_PQ
+
+#include <wolfssl/ssl.h>
+#include <wolfssl/wolfcrypt/types.h>
+#include <wolfssl/wolfcrypt/error-crypt.h>
+#ifdef HAVE_ECC
+    #include <wolfssl/wolfcrypt/ecc.h>
+#endif
+
+#include "esp_wolfssl_pq.h"
+#ifdef WOLFSSL_ESP_HW_ORDER
+    #include "esp_wolfssl_hw_order.h"
+#endif
+
+static const int pq_candidates[] = {
+#ifdef HAVE_CURVE25519
+    ESP_WOLFSSL_GROUP_X25519MLKEM768,
+#endif
+#ifdef HAVE_ECC
+    ESP_WOLFSSL_GROUP_SECP256R1MLKEM768,
+#endif
+};
+
+/* The groups wolfSSL offers when none are set, in its order of preference
+ * (preferredGroup in tls.c); they follow the hybrid group so that servers
+ * limited to any of them still complete the handshake. */
+static const int pq_classical[] = {
+#if defined(HAVE_ECC) && ECC_MIN_KEY_SZ <= 256
+    ESP_WOLFSSL_GROUP_SECP256R1,
+#endif
+#ifdef HAVE_CURVE25519
+    ESP_WOLFSSL_GROUP_X25519,
+#endif
+#ifdef HAVE_CURVE448
+    ESP_WOLFSSL_GROUP_X448,
+#endif
+#if defined(HAVE_ECC) && (defined(HAVE_ECC384) || defined(HAVE_ALL_CURVES)) \
+    && ECC_MIN_KEY_SZ <= 384
+    ESP_WOLFSSL_GROUP_SECP384R1,
+#endif
+#if defined(HAVE_ECC) && (defined(HAVE_ECC521) || defined(HAVE_ALL_CURVES)) \
+    && ECC_MIN_KEY_SZ <= 521
+    ESP_WOLFSSL_GROUP_SECP521R1,
+#endif
+#ifdef HAVE_FFDHE_2048
+    ESP_WOLFSSL_GROUP_FFDHE_2048,
+#endif
+#ifdef HAVE_FFDHE_3072
+    ESP_WOLFSSL_GROUP_FFDHE_3072,
+#endif
+#ifdef HAVE_FFDHE_4096
+    ESP_WOLFSSL_GROUP_FFDHE_4096,
+#endif
+#ifdef HAVE_FFDHE_6144
+    ESP_WOLFSSL_GROUP_FFDHE_6144,
+#endif
+#ifdef HAVE_FFDHE_8192
+    ESP_WOLFSSL_GROUP_FFDHE_8192,
+#endif
+};
+
+/* WOLFSSL_MAX_GROUP_COUNT in internal.h, unless configured otherwise */
+#ifndef WOLFSSL_MAX_GROUP_COUNT
+    #define WOLFSSL_MAX_GROUP_COUNT 10
+#endif
+#define PQ_MAX_GROUPS WOLFSSL_MAX_GROUP_COUNT
+
+/* 0 until probed */
+static int pq_group;
+
+#ifdef WOLFSSL_ESP_PQ_DEFAULT
+extern WOLFSSL_CTX* __real_wolfSSL_CTX_new(WOLFSSL_METHOD* method);
+WOLFSSL_CTX* __wrap_wolfSSL_CTX_new(WOLFSSL_METHOD* method);
+
+WOLFSSL_CTX* __wrap_wolfSSL_CTX_new(WOLFSSL_METHOD* method)
+{
+#ifdef WOLFSSL_ESP_MEM_AUTO
+    /* also the context's accounting domain, see esp_wolfssl_mem.h */
+    WOLFSSL_CTX* ctx = esp_wolfssl_mem_ctx_new(method);
+#else
+    WOLFSSL_CTX* ctx = __real_wolfSSL_CTX_new(method);
+#endif
+
+    if (ctx != NULL) {
+        /* fails for a context without TLS 1.3, which keeps its defaults */
+        (void)esp_wolfssl_pq_ctx_set_groups(ctx);
+    #ifdef WOLFSSL_ESP_HW_ORDER_DEFAULT
+        /* one wrapper for both, see esp_wolfssl_hw_order.h */
+        (void)esp_wolfssl_hw_order_ctx_set_ciphers(ctx);
+    #endif
+    }
+    return ctx;
+}
+    #define PQ_CTX_NEW __real_wolfSSL_CTX_new
+#else
+    #define PQ_CTX_NEW wolfSSL_CTX_new
+#endif
+
+/* wolfSSL_UseKeyShare() refuses groups it does not support; the key it
+ * makes on success is thrown away with the connection */
+static int pq_probe(void)
+{
+    WOLFSSL_CTX* ctx;
+    WOLFSSL* ssl = NULL;
+    int group = NOT_COMPILED_IN;
+    size_t i;
+
+#ifndef NO_WOLFSSL_CLIENT
+    ctx = PQ_CTX_NEW(wolfTLSv1_3_client_method());
+#else
+    ctx = PQ_CTX_NEW(wolfTLSv1_3_server_method());
+#endif
+    if (ctx != NULL) {
+        ssl = wolfSSL_new(ctx);
+    }
+    if (ssl == NULL) {
+        wolfSSL_CTX_free(ctx);
+        return MEMORY_E;
+    }
+    for (i = 0; i < sizeof(pq_candidates) / sizeof(pq_candidates[0]); i++) {
+        if (wolfSSL_UseKeyShare(ssl, (word16)pq_candidates[i])
+                == WOLFSSL_SUCCESS) {
+            group = pq_candidates[i];
+            break;
+        }
+    }
+    wolfSSL_free(ssl);
+    wolfSSL_CTX_free(ctx);
+
+    return group;
+}
+
+int esp_wolfssl_pq_hybrid_group(void)
+{
+    int group = __atomic_load_n(&pq_group, __ATOMIC_ACQUIRE);
+
+    if (group == 0) {
+        /* two tasks may both probe, with the same result */
+        group = pq_probe();
+        if (group != MEMORY_E) {
+            __atomic_store_n(&pq_group, group, __ATOMIC_RELEASE);
+        }
+    }
+    return group;
+}
+
+static int pq_listed(const int* groups, int n, int group)
+{
+    int i;
+
+    for (i = 0; i < n; i++) {
+        if (groups[i] == group) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static int pq_groups(int* groups)
+{
+    int hybrid = esp_wolfssl_pq_hybrid_group();
+    int n = 0;
+    size_t i;
+
+    if (hybrid > 0) {
+        groups[n++] = hybrid;
+    }
+#ifdef WOLFSSL_ESP_HW_ORDER
+    /* the classical fallbacks, faster first on this chip */
+    n += esp_wolfssl_hw_order_groups(groups + n, PQ_MAX_GROUPS - n);
+#endif
+    for (i = 0; i < sizeof(pq_classical) / sizeof(pq_classical[0])
+                && n < PQ_MAX_GROUPS; i++) {
+        if (!pq_listed(groups, n, pq_classical[i])) {
+            groups[n++] = pq_classical[i];
+        }
+    }
+    return n;
+}
+
+int esp_wolfssl_pq_ctx_set_groups(WOLFSSL_CTX* ctx)
+{
+    int groups[PQ_MAX_GROUPS];
+    int n;
+
+    if (ctx == NULL) {
+        return BAD_FUNC_ARG;
+    }
+    n = pq_groups(groups);
+    return n > 0 ? wolfSSL_CTX_set_groups(ctx, groups, n) : NOT_COMPILED_IN;
+}
+
+int esp_wolfssl_pq_set_groups(WOLFSSL* ssl)
+{
+    int groups[PQ_MAX_GROUPS];
+    int n;
+
+    if (ssl == NULL) {
+        return BAD_FUNC_ARG;
+    }
+    n = pq_groups(groups);
+    return n > 0 ? wolfSSL_set_groups(ssl, groups, n) : NOT_COMPILED_IN;
+}
+
+int esp_wolfssl_pq_use_hybrid(WOLFSSL* ssl)
+{
+    int group = esp_wolfssl_pq_hybrid_group();
+    int ret;
+
+    if (group < 0) {
+        return group;
+    }
+    ret = esp_wolfssl_pq_set_groups(ssl);
+    if (ret == WOLFSSL_SUCCESS && !wolfSSL_is_server(ssl)) {
+        ret = wolfSSL_UseKeyShare(ssl, (word16)group);
+    }
+    return ret;
+}
+
+const char* esp_wolfssl_pq_group_name(int group)
+{
+    switch (group) {
+        case ESP_WOLFSSL_GROUP_SECP256R1:
+            return "SECP256R1";
+        case ESP_WOLFSSL_GROUP_X25519:
+            return "X25519";
+        case ESP_WOLFSSL_GROUP_SECP384R1:
+            return "SECP384R1";
+        case ESP_WOLFSSL_GROUP_SECP521R1:
+            return "SECP521R1";
+        case ESP_WOLFSSL_GROUP_X448:
+            return "X448";
+        case ESP_WOLFSSL_GROUP_FFDHE_2048:
+            return "FFDHE2048";
+        case ESP_WOLFSSL_GROUP_FFDHE_3072:
+            return "FFDHE3072";
+        case ESP_WOLFSSL_GROUP_FFDHE_4096:
+            return "FFDHE4096";
+        case ESP_WOLFSSL_GROUP_FFDHE_6144:
+            return "FFDHE6144";
+        case ESP_WOLFSSL_GROUP_FFDHE_8192:
+            return "FFDHE8192";
+        case ESP_WOLFSSL_GROUP_SECP256R1MLKEM768:
+            return "SecP256r1MLKEM768";
+        case ESP_WOLFSSL_GROUP_X25519MLKEM768:
+            return "X25519MLKEM768";
+        case ESP_WOLFSSL_GROUP_X25519KYBER768DRAFT00:
+            return "X25519Kyber768Draft00";
+        default:
+            return "unknown";
+    }
+}
+
+#endif /* WOLFSSL_ESP_PQ */
@@ -0,0 +1,89 @@
+/* esp_wolfssl_pq.h
+ *
+ * Copyright (C) 2006-2024 wolfSSL Inc.
+ *
+ * This file is part of wolfSSL.
+ *
+ * wolfSSL is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfSSL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335, USA
+ */
+
+/* Hybrid post-quantum key exchange for TLS 1.3.
+ *
+ * Enabled with Kconfig WOLFSSL_HAVE_MLKEM, which builds wolfSSL's ML-KEM
+ * with only the 768 parameter set. The hybrid groups combine it with a
+ * classical key share, so a connection is at least as strong as with the
+ * classical group alone. Which hybrid groups exist depends on the wolfSSL
+ * version; the helpers below use the first one the library supports, in
+ * the order X25519MLKEM768, SecP256r1MLKEM768. The pre-standard
+ * X25519Kyber768Draft00 codepoint is not used.
+ *
+ * With Kconfig WOLFSSL_MLKEM_DEFAULT every new WOLFSSL_CTX gets the hybrid
+ * group as its first preference (a linker wrapper around wolfSSL_CTX_new,
+ * see the component CMakeLists.txt), so esp-tls connections use it too.
+ * The groups wolfSSL offers by default follow it (P-256, X25519, P-384,
+ * P-521, FFDHE, as far as built in): a server without ML-KEM answers the
+ * hybrid key share with a HelloRetryRequest for one of them.
+ */
+
+#ifndef _ESP_WOLFSSL_PQ_H_
+#define _ESP_WOLFSSL_PQ_H_
+
+#include <wolfssl/wolfcrypt/settings.h>
+#include <wolfssl/ssl.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* TLS named groups, IANA registry */
+#define ESP_WOLFSSL_GROUP_SECP256R1             23
+#define ESP_WOLFSSL_GROUP_SECP384R1             24
+#define ESP_WOLFSSL_GROUP_SECP521R1             25
+#define ESP_WOLFSSL_GROUP_X25519                29
+#define ESP_WOLFSSL_GROUP_X448                  30
+#define ESP_WOLFSSL_GROUP_FFDHE_2048            256
+#define ESP_WOLFSSL_GROUP_FFDHE_3072            257
+#define ESP_WOLFSSL_GROUP_FFDHE_4096            258
+#define ESP_WOLFSSL_GROUP_FFDHE_6144            259
+#define ESP_WOLFSSL_GROUP_FFDHE_8192            260
+#define ESP_WOLFSSL_GROUP_SECP256R1MLKEM768     0x11EB
+#define ESP_WOLFSSL_GROUP_X25519MLKEM768        0x11EC
+#define ESP_WOLFSSL_GROUP_X25519KYBER768DRAFT00 0x6399
+
+#ifdef WOLFSSL_ESP_PQ
+
+/* The hybrid group this wolfSSL supports, found once with a throwaway
+ * connection, or NOT_COMPILED_IN. */
+int esp_wolfssl_pq_hybrid_group(void);
+
+/* Group preference: the hybrid group, then wolfSSL's default groups.
+ * Returns WOLFSSL_SUCCESS or an error. */
+int esp_wolfssl_pq_ctx_set_groups(WOLFSSL_CTX* ctx);
+int esp_wolfssl_pq_set_groups(WOLFSSL* ssl);
+
+/* esp_wolfssl_pq_set_groups() and, for a client, the hybrid key share in
+ * the ClientHello instead of a classical one. */
+int esp_wolfssl_pq_use_hybrid(WOLFSSL* ssl);
+
+/* "X25519MLKEM768", ... or "unknown" */
+const char* esp_wolfssl_pq_group_name(int group);
+
+#endif /* WOLFSSL_ESP_PQ */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _ESP_WOLFSSL_PQ_H_ */
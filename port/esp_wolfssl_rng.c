@@ -0,0 +1,248 @@
+/* esp_wolfssl_rng.c
+ *
+ * Copyright (C) 2006-2024 wolfSSL Inc.
+ *
+ * This file is part of wolfSSL.
+ *
+ * wolfSSL is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfSSL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335, USA
+ */
+
+#include <wolfssl/wolfcrypt/settings.h>
+
+#ifdef WOLFSSL_ESP_RNG_POOL
+
+#include <stdint.h>
+#include <string.h>
+
+#include <wolfssl/wolfcrypt/types.h>
+#include <wolfssl/wolfcrypt/random.h>
+#include <wolfssl/wolfcrypt/error-crypt.h>
+#include <wolfssl/wolfcrypt/wc_port.h>
+
+#include "esp_wolfssl_rng.h"
+
+#ifdef WOLFSSL_ESPIDF
+    #include <freertos/FreeRTOS.h>
+    #include <freertos/task.h>
+#endif
+
+#define RNG_REFILL_STACK 3072
+
+/* DRBG_OK in random.c: the caller's generator works */
+#define RNG_DRBG_OK 1
+
+static byte rng_pool[ESP_WOLFSSL_RNG_POOL_SZ];
+static word32 rng_avail;                /* ready bytes, at the front */
+static WC_RNG rng_drbg;                 /* fills the pool */
+static int rng_drbg_ok;
+static int rng_enabled = 1;
+static esp_wolfssl_rng_stats_t rng_stats;
+static wolfSSL_Mutex rng_mutex;
+static int rng_mutex_ok;
+
+#ifdef WOLFSSL_ESP_RNG_REFILL_TASK
+static TaskHandle_t rng_task;
+#endif
+
+/* the function wolfCrypt had before the wrapper below */
+int __real_wc_RNG_GenerateBlock(WC_RNG* rng, byte* b, word32 sz);
+
+/* before any handshake, and before the scheduler starts on the device */
+static void __attribute__((constructor)) rng_init(void)
+{
+    rng_mutex_ok = (wc_InitMutex(&rng_mutex) == 0);
+}
+
+static int rng_lock(void)
+{
+    return rng_mutex_ok && wc_LockMutex(&rng_mutex) == 0;
+}
+
+static void rng_unlock(void)
+{
+    wc_UnLockMutex(&rng_mutex);
+}
+
+/* under the lock: the pool's own Hash_DRBG, seeded by wolfCrypt from the
+ * hardware RNG on first use, with its health test */
+static int rng_drbg_get(void)
+{
+    int ret = 0;
+
+    if (!rng_drbg_ok) {
+        ret = wc_InitRng(&rng_drbg);
+        rng_drbg_ok = (ret == 0);
+    }
+    return ret;
+}
+
+/* under the lock: one large request to the Hash_DRBG for all of it */
+static int rng_fill(void)
+{
+    int ret = 0;
+
+    if (rng_avail < sizeof(rng_pool)) {
+        ret = rng_drbg_get();
+        if (ret == 0) {
+            ret = __real_wc_RNG_GenerateBlock(&rng_drbg,
+                                              rng_pool + rng_avail,
+                                              (word32)sizeof(rng_pool)
+                                              - rng_avail);
+        }
+        if (ret == 0) {
+            rng_avail = (word32)sizeof(rng_pool);
+        }
+    }
+    return ret;
+}
+
+#ifdef WOLFSSL_ESP_RNG_REFILL_TASK
+static void rng_refill_task(void* arg)
+{
+    (void)arg;
+
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        if (rng_lock()) {
+            if (rng_enabled && rng_avail < sizeof(rng_pool)
+                    && rng_fill() == 0) {
+                rng_stats.bg_refills++;
+            }
+            rng_unlock();
+        }
+    }
+}
+
+/* under the lock; the task is started on first need, as the pool is used
+ * from wolfCrypt calls that may come before the scheduler runs */
+static void rng_refill_wake(void)
+{
+    if (rng_task == NULL) {
+        if (xTaskGetSchedulerState() != taskSCHEDULER_RUNNING
+                || xTaskCreate(rng_refill_task, "wolfssl_rng",
+                               RNG_REFILL_STACK, NULL, tskIDLE_PRIORITY + 1,
+                               &rng_task) != pdPASS) {
+            rng_task = NULL;
+            return;
+        }
+    }
+    xTaskNotifyGive(rng_task);
+}
+#endif
+
+int esp_wolfssl_rng_generate_block(WC_RNG* rng, unsigned char* out,
+                                   unsigned int sz)
+{
+    word32 n;
+    int ret = 0;
+
+    if (rng == NULL || out == NULL || !rng_lock()) {
+        return __real_wc_RNG_GenerateBlock(rng, out, sz);
+    }
+    rng_stats.requests++;
+    rng_stats.bytes += sz;
+
+    /* a disabled pool, a request the pool gains nothing for and a caller
+     * whose generator failed are left to the caller's Hash_DRBG */
+    if (!rng_enabled || sz == 0 || sz >= sizeof(rng_pool)
+#ifdef HAVE_HASHDRBG
+            || rng->status != RNG_DRBG_OK
+#endif
+            ) {
+        rng_unlock();
+        return __real_wc_RNG_GenerateBlock(rng, out, sz);
+    }
+
+    while (ret == 0 && sz > 0) {
+        if (rng_avail == 0) {
+            ret = rng_fill();
+            rng_stats.refills++;
+            continue;
+        }
+        /* from the end of the ready bytes, which are wiped */
+        n = (sz < rng_avail) ? sz : rng_avail;
+        rng_avail -= n;
+        XMEMCPY(out, rng_pool + rng_avail, n);
+        XMEMSET(rng_pool + rng_avail, 0, n);
+        out += n;
+        sz -= n;
+    }
+
+#ifdef WOLFSSL_ESP_RNG_REFILL_TASK
+    if (ret == 0 && rng_avail < sizeof(rng_pool) / 2) {
+        rng_refill_wake();
+    }
+#endif
+    rng_unlock();
+    return ret;
+}
+
+/* with tracing on, its wrapper of the same function calls the one above */
+#ifndef WOLFSSL_ESP_TRACE
+int __wrap_wc_RNG_GenerateBlock(WC_RNG* rng, byte* b, word32 sz);
+int __wrap_wc_RNG_GenerateBlock(WC_RNG* rng, byte* b, word32 sz)
+{
+    return esp_wolfssl_rng_generate_block(rng, b, sz);
+}
+#endif
+
+int esp_wolfssl_rng_refill(void)
+{
+    int ret;
+
+    if (!rng_lock()) {
+        return BAD_MUTEX_E;
+    }
+    ret = rng_fill();
+    rng_unlock();
+    return ret;
+}
+
+void esp_wolfssl_rng_set_enabled(int enabled)
+{
+    if (!rng_lock()) {
+        return;
+    }
+    rng_enabled = enabled;
+    if (!enabled) {
+        XMEMSET(rng_pool, 0, sizeof(rng_pool));
+        rng_avail = 0;
+    }
+    rng_unlock();
+}
+
+void esp_wolfssl_rng_get_stats(esp_wolfssl_rng_stats_t* stats)
+{
+    if (stats == NULL) {
+        return;
+    }
+    if (!rng_lock()) {
+        XMEMSET(stats, 0, sizeof(*stats));
+        return;
+    }
+    *stats = rng_stats;
+    rng_unlock();
+}
+
+void esp_wolfssl_rng_reset_stats(void)
+{
+    if (!rng_lock()) {
+        return;
+    }
+    XMEMSET(&rng_stats, 0, sizeof(rng_stats));
+    rng_unlock();
+}
+
+#endif /* WOLFSSL_ESP_RNG_POOL */
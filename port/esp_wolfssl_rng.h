@@ -0,0 +1,84 @@
+/* esp_wolfssl_rng.h
+ *
+ * Copyright (C) 2006-2024 wolfSSL Inc.
+ *
+ * This file is part of wolfSSL.
+ *
+ * wolfSSL is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfSSL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335, USA
+ */
+
+/* Buffered random number pool.
+ *
+ * Enabled with Kconfig WOLFSSL_RNG_POOL, which wraps wc_RNG_GenerateBlock()
+ * at link time. A handshake asks for random bytes a few dozen times, mostly
+ * 32 bytes or less for nonces, blinding and ephemeral keys, and each request
+ * runs the Hash_DRBG's generate and state update. The pool instead keeps
+ * ESP_WOLFSSL_RNG_POOL_SZ bytes ready and hands them out with a copy;
+ * bytes handed out are wiped from it.
+ *
+ * The pool is filled by one large request to a Hash_DRBG of its own, which
+ * wolfCrypt seeds from the hardware RNG and health tests like any other
+ * WC_RNG, so the bytes are the DRBG's output. Requests as large as the
+ * pool, and those whose own WC_RNG is not working, go to the caller's
+ * Hash_DRBG as before. With WOLFSSL_ESP_RNG_REFILL_TASK the pool is topped
+ * up by a task just above the idle priority once it is half empty, so
+ * handshakes rarely wait for a refill; without it, or when the pool runs
+ * dry, the caller refills. One pool serves all tasks under a mutex.
+ */
+
+#ifndef _ESP_WOLFSSL_RNG_H_
+#define _ESP_WOLFSSL_RNG_H_
+
+#include <stdint.h>
+
+#include <wolfssl/wolfcrypt/random.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef ESP_WOLFSSL_RNG_POOL_SZ
+    #define ESP_WOLFSSL_RNG_POOL_SZ 512
+#endif
+
+typedef struct esp_wolfssl_rng_stats_t {
+    uint32_t requests;
+    uint32_t bytes;
+    uint32_t refills;       /* by the caller */
+    uint32_t bg_refills;    /* by the refill task */
+} esp_wolfssl_rng_stats_t;
+
+/* wc_RNG_GenerateBlock() through the pool: fills out with sz random bytes,
+ * from rng when the pool is off or the request is as large as it.
+ * Returns 0 or an error. */
+int esp_wolfssl_rng_generate_block(WC_RNG* rng, unsigned char* out,
+                                   unsigned int sz);
+
+/* Fills the pool up now, e.g. before a burst of handshakes. Returns 0 or
+ * an error. */
+int esp_wolfssl_rng_refill(void);
+
+/* 0 sends every request to the caller's Hash_DRBG, without the pool, for
+ * comparison; the pool is on by default. */
+void esp_wolfssl_rng_set_enabled(int enabled);
+
+void esp_wolfssl_rng_get_stats(esp_wolfssl_rng_stats_t* stats);
+void esp_wolfssl_rng_reset_stats(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _ESP_WOLFSSL_RNG_H_ */
@@ -0,0 +1,368 @@
+/* esp_wolfssl_rpk.c
+ *
+ * Copyright (C) 2006-2024 wolfSSL Inc.
+ *
+ * This file is part of wolfSSL.
+ *
+ * wolfSSL is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfSSL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335, USA
+ */
+
+#include <wolfssl/wolfcrypt/settings.h>
+
+#ifdef WOLFSSL_ESP_RPK
+
+#include <string.h>
+
+#include <wolfssl/ssl.h>
+#include <wolfssl/wolfcrypt/types.h>
+#include <wolfssl/wolfcrypt/error-crypt.h>
+#include <wolfssl/wolfcrypt/hash.h>
+#include <wolfssl/wolfcrypt/wc_port.h>
+
+#include "esp_wolfssl_der.h"
+#include "esp_wolfssl_cert_view.h"
+#include "esp_wolfssl_rpk.h"
+
+/* types this end accepts from its peer, in order of preference */
+static const char rpk_peer_types[] = {
+    ESP_WOLFSSL_CERT_TYPE_RPK,
+#ifdef WOLFSSL_ESP_RPK_X509_FALLBACK
+    ESP_WOLFSSL_CERT_TYPE_X509,
+#endif
+};
+static const char rpk_own_rpk[] = { ESP_WOLFSSL_CERT_TYPE_RPK };
+static const char rpk_own_x509[] = { ESP_WOLFSSL_CERT_TYPE_X509 };
+
+static byte rpk_pins[ESP_WOLFSSL_RPK_PINS][WC_SHA256_DIGEST_SIZE];
+static int rpk_pin_count;
+static wolfSSL_Mutex rpk_mutex;
+static int rpk_mutex_ok;
+
+static const unsigned char* rpk_default_key;
+static size_t rpk_default_key_sz;
+
+/* before any handshake, and before the scheduler starts on the device */
+static void __attribute__((constructor)) rpk_init(void)
+{
+    rpk_mutex_ok = (wc_InitMutex(&rpk_mutex) == 0);
+}
+
+static int rpk_lock(void)
+{
+    return rpk_mutex_ok && wc_LockMutex(&rpk_mutex) == 0;
+}
+
+static void rpk_unlock(void)
+{
+    wc_UnLockMutex(&rpk_mutex);
+}
+
+/* SubjectPublicKeyInfo ::= SEQUENCE { AlgorithmIdentifier, BIT STRING },
+ * where a certificate has three elements */
+static int rpk_is_spki(const unsigned char* der, size_t sz)
+{
+    esp_wolfssl_der_t d;
+    esp_wolfssl_der_t seq;
+
+    esp_wolfssl_der_init(&d, der, sz);
+    if (esp_wolfssl_der_expect(&d, ESP_WOLFSSL_DER_SEQUENCE, &seq) != 0
+            || esp_wolfssl_der_peek(&d) != -1
+            || esp_wolfssl_der_expect(&seq, ESP_WOLFSSL_DER_SEQUENCE,
+                                      NULL) != 0
+            || esp_wolfssl_der_expect(&seq, ESP_WOLFSSL_DER_BIT_STRING,
+                                      NULL) != 0) {
+        return 0;
+    }
+    return esp_wolfssl_der_peek(&seq) == -1;
+}
+
+int esp_wolfssl_rpk_spki(const unsigned char* der, size_t sz,
+                         const unsigned char** spki, size_t* spki_sz)
+{
+    esp_wolfssl_cert_view_t v;
+
+    if (der == NULL || spki == NULL || spki_sz == NULL) {
+        return BAD_FUNC_ARG;
+    }
+    if (rpk_is_spki(der, sz)) {
+        *spki = der;
+        *spki_sz = sz;
+        return 0;
+    }
+    if (esp_wolfssl_cert_view_parse(der, sz, &v) != 0) {
+        return ASN_PARSE_E;
+    }
+    *spki = v.spki.p;
+    *spki_sz = v.spki.len;
+    return 0;
+}
+
+static int rpk_hash(const unsigned char* der, size_t sz, byte* hash)
+{
+    const unsigned char* spki;
+    size_t spki_sz;
+    int ret;
+
+    ret = esp_wolfssl_rpk_spki(der, sz, &spki, &spki_sz);
+    if (ret == 0) {
+        ret = wc_Sha256Hash(spki, (word32)spki_sz, hash);
+    }
+    return ret;
+}
+
+int esp_wolfssl_rpk_pin_add_hash(const unsigned char* sha256)
+{
+    int ret = BUFFER_E;
+
+    if (sha256 == NULL) {
+        return BAD_FUNC_ARG;
+    }
+    if (!rpk_lock()) {
+        return BAD_MUTEX_E;
+    }
+    if (rpk_pin_count < ESP_WOLFSSL_RPK_PINS) {
+        memcpy(rpk_pins[rpk_pin_count++], sha256, WC_SHA256_DIGEST_SIZE);
+        ret = 0;
+    }
+    rpk_unlock();
+    return ret;
+}
+
+int esp_wolfssl_rpk_pin_add(const unsigned char* der, size_t sz)
+{
+    byte hash[WC_SHA256_DIGEST_SIZE];
+    int ret = rpk_hash(der, sz, hash);
+
+    if (ret == 0) {
+        ret = esp_wolfssl_rpk_pin_add_hash(hash);
+    }
+    return ret;
+}
+
+void esp_wolfssl_rpk_pin_clear(void)
+{
+    if (rpk_lock()) {
+        rpk_pin_count = 0;
+        rpk_unlock();
+    }
+}
+
+int esp_wolfssl_rpk_pinned(const unsigned char* der, size_t sz)
+{
+    byte hash[WC_SHA256_DIGEST_SIZE];
+    int found = 0;
+    int ret;
+    int i;
+
+    ret = rpk_hash(der, sz, hash);
+    if (ret != 0) {
+        return ret;
+    }
+    if (!rpk_lock()) {
+        return BAD_MUTEX_E;
+    }
+    for (i = 0; i < rpk_pin_count && !found; i++) {
+        found = (memcmp(rpk_pins[i], hash, sizeof(hash)) == 0);
+    }
+    rpk_unlock();
+    return found;
+}
+
+int esp_wolfssl_rpk_ctx_use(WOLFSSL_CTX* ctx, int server,
+                            const unsigned char* own, size_t own_sz)
+{
+    const unsigned char* spki;
+    size_t spki_sz;
+    const char* own_types = rpk_own_x509;
+    int ret;
+
+    if (ctx == NULL) {
+        return BAD_FUNC_ARG;
+    }
+    if (own != NULL) {
+        ret = esp_wolfssl_rpk_spki(own, own_sz, &spki, &spki_sz);
+        if (ret != 0) {
+            return ret;
+        }
+        ret = wolfSSL_CTX_use_certificate_buffer(ctx, spki, (long)spki_sz,
+                                                 WOLFSSL_FILETYPE_ASN1);
+        if (ret != WOLFSSL_SUCCESS) {
+            return ret;
+        }
+        own_types = rpk_own_rpk;
+    }
+
+    if (server) {
+        ret = wolfSSL_CTX_set_server_cert_type(ctx, own_types, 1);
+        if (ret == WOLFSSL_SUCCESS) {
+            ret = wolfSSL_CTX_set_client_cert_type(ctx, rpk_peer_types,
+                                                   sizeof(rpk_peer_types));
+        }
+    }
+    else {
+        ret = wolfSSL_CTX_set_client_cert_type(ctx, own_types, 1);
+        if (ret == WOLFSSL_SUCCESS) {
+            ret = wolfSSL_CTX_set_server_cert_type(ctx, rpk_peer_types,
+                                                   sizeof(rpk_peer_types));
+        }
+    }
+    return ret;
+}
+
+int esp_wolfssl_rpk_use(WOLFSSL* ssl, const unsigned char* own,
+                        size_t own_sz)
+{
+    const unsigned char* spki;
+    size_t spki_sz;
+    const char* own_types = rpk_own_x509;
+    int ret;
+
+    if (ssl == NULL) {
+        return BAD_FUNC_ARG;
+    }
+    if (own != NULL) {
+        ret = esp_wolfssl_rpk_spki(own, own_sz, &spki, &spki_sz);
+        if (ret != 0) {
+            return ret;
+        }
+        ret = wolfSSL_use_certificate_buffer(ssl, spki, (long)spki_sz,
+                                             WOLFSSL_FILETYPE_ASN1);
+        if (ret != WOLFSSL_SUCCESS) {
+            return ret;
+        }
+        own_types = rpk_own_rpk;
+    }
+
+    if (wolfSSL_is_server(ssl)) {
+        ret = wolfSSL_set_server_cert_type(ssl, own_types, 1);
+        if (ret == WOLFSSL_SUCCESS) {
+            ret = wolfSSL_set_client_cert_type(ssl, rpk_peer_types,
+                                               sizeof(rpk_peer_types));
+        }
+    }
+    else {
+        ret = wolfSSL_set_client_cert_type(ssl, own_types, 1);
+        if (ret == WOLFSSL_SUCCESS) {
+            ret = wolfSSL_set_server_cert_type(ssl, rpk_peer_types,
+                                               sizeof(rpk_peer_types));
+        }
+    }
+    return ret;
+}
+
+int esp_wolfssl_rpk_verify_cb(int preverify, WOLFSSL_X509_STORE_CTX* store)
+{
+    const unsigned char* der;
+    size_t sz;
+    int rpk;
+    int ret;
+
+    /* intermediates of an X.509 chain are left to wolfSSL */
+    if (store == NULL || store->error_depth != 0) {
+        return preverify;
+    }
+    if (store->certs == NULL || store->totalCerts < 1) {
+        return 0;
+    }
+    /* the peer's leaf, or its raw public key as the only "certificate" */
+    der = store->certs[0].buffer;
+    sz = store->certs[0].length;
+    rpk = rpk_is_spki(der, sz);
+    if (!rpk && !preverify) {
+        return 0;
+    }
+
+    ret = esp_wolfssl_rpk_pinned(der, sz);
+    if (ret != 1) {
+        store->error = (ret < 0) ? ret : ASN_NO_SIGNER_E;
+        return 0;
+    }
+    return 1;
+}
+
+int esp_wolfssl_rpk_set_default_key(const unsigned char* der, size_t sz)
+{
+    const unsigned char* spki;
+    size_t spki_sz;
+    int ret;
+
+    if (der == NULL) {
+        rpk_default_key = NULL;
+        rpk_default_key_sz = 0;
+        return 0;
+    }
+    ret = esp_wolfssl_rpk_spki(der, sz, &spki, &spki_sz);
+    if (ret == 0) {
+        rpk_default_key = spki;
+        rpk_default_key_sz = spki_sz;
+    }
+    return ret;
+}
+
+int esp_wolfssl_rpk_peer_type(WOLFSSL* ssl)
+{
+    int type = -1;
+    int ret;
+
+    if (ssl == NULL) {
+        return BAD_FUNC_ARG;
+    }
+    if (wolfSSL_is_server(ssl)) {
+        ret = wolfSSL_get_negotiated_client_cert_type(ssl, &type);
+    }
+    else {
+        ret = wolfSSL_get_negotiated_server_cert_type(ssl, &type);
+    }
+    if (ret != WOLFSSL_SUCCESS) {
+        return ret;
+    }
+    /* no extension negotiated: X.509 */
+    return (type < 0) ? ESP_WOLFSSL_CERT_TYPE_X509 : type;
+}
+
+#ifdef WOLFSSL_ESP_RPK_DEFAULT
+extern WOLFSSL* __real_wolfSSL_new(WOLFSSL_CTX* ctx);
+WOLFSSL* __wrap_wolfSSL_new(WOLFSSL_CTX* ctx);
+
+/* esp-tls sets the verify mode on the context without a callback before
+ * it makes the connection; an application's own callback is kept */
+WOLFSSL* __wrap_wolfSSL_new(WOLFSSL_CTX* ctx)
+{
+#ifdef WOLFSSL_ESP_MEM_AUTO
+    /* also the connection's accounting domain, see esp_wolfssl_mem.h */
+    WOLFSSL* ssl = esp_wolfssl_mem_ssl_new(ctx);
+#else
+    WOLFSSL* ssl = __real_wolfSSL_new(ctx);
+#endif
+    int mode;
+
+    if (ssl == NULL) {
+        return NULL;
+    }
+    if (esp_wolfssl_rpk_use(ssl, rpk_default_key, rpk_default_key_sz)
+            != WOLFSSL_SUCCESS) {
+        wolfSSL_free(ssl);
+        return NULL;
+    }
+    mode = wolfSSL_get_verify_mode(ssl);
+    if (mode != WOLFSSL_VERIFY_NONE
+            && wolfSSL_get_verify_callback(ssl) == NULL) {
+        wolfSSL_set_verify(ssl, mode, esp_wolfssl_rpk_verify_cb);
+    }
+    return ssl;
+}
+#endif /* WOLFSSL_ESP_RPK_DEFAULT */
+
+#endif /* WOLFSSL_ESP_RPK */
@@ -0,0 +1,116 @@
+/* esp_wolfssl_rpk.h
+ *
+ * Copyright (C) 2006-2024 wolfSSL Inc.
+ *
+ * This file is part of wolfSSL.
+ *
+ * wolfSSL is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfSSL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335, USA
+ */
+
+/* Raw public keys (RFC 7250) with key pinning.
+ *
+ * Enabled with Kconfig WOLFSSL_RPK. With the client_certificate_type and
+ * server_certificate_type extensions both ends agree to send a bare
+ * SubjectPublicKeyInfo instead of an X.509 certificate, so the handshake
+ * carries a 91 byte P-256 key instead of a chain, and the peer's key is
+ * neither parsed as a certificate nor checked against a CA. It is trusted
+ * when its SHA-256 hash is one of the pinned ones, which suits a closed
+ * fleet whose gateway keys are known at provisioning time:
+ *
+ *   esp_wolfssl_rpk_pin_add(gateway_spki, gateway_spki_sz);
+ *   esp_wolfssl_rpk_ctx_use(ctx, 0, NULL, 0);
+ *   wolfSSL_CTX_set_verify(ctx, WOLFSSL_VERIFY_PEER,
+ *                          esp_wolfssl_rpk_verify_cb);
+ *
+ * A pin may be given as a SubjectPublicKeyInfo or as a certificate, whose
+ * key is pinned. With Kconfig WOLFSSL_RPK_X509_FALLBACK a peer may still
+ * send an X.509 chain; it is verified as usual and its leaf key must be
+ * pinned too.
+ *
+ * With Kconfig WOLFSSL_RPK_DEFAULT every new WOLFSSL, including the ones of
+ * esp-tls, offers raw public keys (a linker wrapper around wolfSSL_new, see
+ * the component CMakeLists.txt) and checks the pins when it verifies its
+ * peer. An esp-tls client that authenticates itself sends the key set with
+ * esp_wolfssl_rpk_set_default_key() instead of its certificate.
+ */
+
+#ifndef _ESP_WOLFSSL_RPK_H_
+#define _ESP_WOLFSSL_RPK_H_
+
+#include <stddef.h>
+
+#include <wolfssl/wolfcrypt/settings.h>
+#include <wolfssl/ssl.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* TLS certificate types, IANA registry */
+#define ESP_WOLFSSL_CERT_TYPE_X509  0
+#define ESP_WOLFSSL_CERT_TYPE_RPK   2
+
+#ifndef ESP_WOLFSSL_RPK_PINS
+    #define ESP_WOLFSSL_RPK_PINS    4
+#endif
+
+#ifdef WOLFSSL_ESP_RPK
+
+/* The SubjectPublicKeyInfo of der, which is either one or a certificate;
+ * points into der. Returns 0 or ASN_PARSE_E. */
+int esp_wolfssl_rpk_spki(const unsigned char* der, size_t sz,
+                         const unsigned char** spki, size_t* spki_sz);
+
+/* Pins the key of a SubjectPublicKeyInfo or certificate, or a SHA-256 hash
+ * of a SubjectPublicKeyInfo. Returns 0, ASN_PARSE_E or BUFFER_E when all
+ * ESP_WOLFSSL_RPK_PINS are taken. */
+int esp_wolfssl_rpk_pin_add(const unsigned char* der, size_t sz);
+int esp_wolfssl_rpk_pin_add_hash(const unsigned char* sha256);
+void esp_wolfssl_rpk_pin_clear(void);
+
+/* 1 when the key of der is pinned, 0 when not, or ASN_PARSE_E. */
+int esp_wolfssl_rpk_pinned(const unsigned char* der, size_t sz);
+
+/* Offers raw public keys for the peer, and X.509 with
+ * WOLFSSL_RPK_X509_FALLBACK. With own, a SubjectPublicKeyInfo or a
+ * certificate, its key is loaded and sent as this end's raw public key;
+ * the private key is loaded as usual. Without, this end sends X.509.
+ * Returns WOLFSSL_SUCCESS or an error. */
+int esp_wolfssl_rpk_ctx_use(WOLFSSL_CTX* ctx, int server,
+                            const unsigned char* own, size_t own_sz);
+int esp_wolfssl_rpk_use(WOLFSSL* ssl, const unsigned char* own,
+                        size_t own_sz);
+
+/* Verify callback: a raw public key peer is accepted when its key is
+ * pinned, an X.509 peer when wolfSSL verified the chain and the leaf key
+ * is pinned. Needs WOLFSSL_ALWAYS_VERIFY_CB, which Kconfig sets. */
+int esp_wolfssl_rpk_verify_cb(int preverify, WOLFSSL_X509_STORE_CTX* store);
+
+/* This end's key for WOLFSSL_RPK_DEFAULT, a SubjectPublicKeyInfo or a
+ * certificate that stays valid while it is set; NULL for none. Returns 0
+ * or ASN_PARSE_E. */
+int esp_wolfssl_rpk_set_default_key(const unsigned char* der, size_t sz);
+
+/* ESP_WOLFSSL_CERT_TYPE_* the peer sent, after the handshake, or an
+ * error. */
+int esp_wolfssl_rpk_peer_type(WOLFSSL* ssl);
+
+#endif /* WOLFSSL_ESP_RPK */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _ESP_WOLFSSL_RPK_H_ */
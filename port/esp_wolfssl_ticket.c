@@ -0,0 +1,357 @@
+/* esp_wolfssl_ticket.c
+ *
+ * Copyright (C) 2006-2024 wolfSSL Inc.
+ *
+ * This file is part of wolfSSL.
+ *
+ * wolfSSL is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfSSL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335, USA
+ */
+
+#include <wolfssl/wolfcrypt/settings.h>
+
+#ifdef WOLFSSL_ESP_TICKET
+
+#include <stdint.h>
+#include <string.h>
+
+#include <wolfssl/ssl.h>
+#include <wolfssl/wolfcrypt/types.h>
+#include <wolfssl/wolfcrypt/aes.h>
+#include <wolfssl/wolfcrypt/random.h>
+#include <wolfssl/wolfcrypt/error-crypt.h>
+#include <wolfssl/wolfcrypt/wc_port.h>
+
+#include "esp_wolfssl_ticket.h"
+
+#ifdef WOLFSSL_ESPIDF
+    #include <esp_timer.h>
+#else
+    #include <time.h>
+#endif
+
+#define TICKET_KEY_SZ   32
+#define TICKET_NONCE_SZ GCM_NONCE_MID_SZ
+#define TICKET_TAG_SZ   AES_BLOCK_SIZE
+
+/* the name tells the key apart and must not repeat across reboots, so it
+ * is random like the key */
+typedef struct ticket_key {
+    byte    name[WOLFSSL_TICKET_NAME_SZ];
+    Aes     aes;
+    int64_t created;
+    int64_t retired;            /* when it stopped sealing, if previous */
+    byte    used;
+} ticket_key;
+
+static ticket_key ticket_keys[2];
+static int ticket_cur;                  /* the other one is previous */
+static WC_RNG ticket_rng;
+static int ticket_rng_ok;
+static esp_wolfssl_ticket_stats_t ticket_stats;
+static wolfSSL_Mutex ticket_mutex;
+static int ticket_mutex_ok;
+
+#if ESP_WOLFSSL_TICKET_REPLAY > 0
+/* first bytes of the tags of accepted tickets; 0 marks a free slot */
+static uint64_t ticket_seen[ESP_WOLFSSL_TICKET_REPLAY];
+static uint32_t ticket_seen_next;
+#endif
+
+/* before any handshake, and before the scheduler starts on the device */
+static void __attribute__((constructor)) ticket_init(void)
+{
+    ticket_mutex_ok = (wc_InitMutex(&ticket_mutex) == 0);
+}
+
+static int ticket_lock(void)
+{
+    return ticket_mutex_ok && wc_LockMutex(&ticket_mutex) == 0;
+}
+
+static void ticket_unlock(void)
+{
+    wc_UnLockMutex(&ticket_mutex);
+}
+
+/* monotonic, rotation must not follow changes of the wall clock */
+static int64_t ticket_now(void)
+{
+#ifdef WOLFSSL_ESPIDF
+    return esp_timer_get_time() / 1000000;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec;
+#endif
+}
+
+static void ticket_key_free(ticket_key* k)
+{
+    if (k->used) {
+        wc_AesFree(&k->aes);
+    }
+    XMEMSET(k, 0, sizeof(*k));
+}
+
+/* under the lock */
+static int ticket_key_new(void)
+{
+    byte key[TICKET_KEY_SZ];
+    ticket_key* k = &ticket_keys[ticket_cur ^ 1];
+    int ret;
+
+    if (!ticket_rng_ok) {
+        ret = wc_InitRng(&ticket_rng);
+        if (ret != 0) {
+            return ret;
+        }
+        ticket_rng_ok = 1;
+    }
+
+    ticket_key_free(k);
+    ret = wc_RNG_GenerateBlock(&ticket_rng, k->name, sizeof(k->name));
+    if (ret == 0) {
+        ret = wc_RNG_GenerateBlock(&ticket_rng, key, sizeof(key));
+    }
+    if (ret == 0) {
+        ret = wc_AesInit(&k->aes, NULL, INVALID_DEVID);
+    }
+    if (ret == 0) {
+        k->used = 1;
+        ret = wc_AesGcmSetKey(&k->aes, key, sizeof(key));
+    }
+    XMEMSET(key, 0, sizeof(key));
+    if (ret != 0) {
+        ticket_key_free(k);
+        return ret;
+    }
+    k->created = ticket_now();
+    /* the current key becomes previous */
+    ticket_keys[ticket_cur].retired = k->created;
+    ticket_cur ^= 1;
+    ticket_stats.rotations++;
+    return 0;
+}
+
+/* under the lock: a current key no older than one period, and a previous
+ * key kept for one period after it stopped sealing, so every ticket lives
+ * at least that long */
+static int ticket_keys_update(void)
+{
+    ticket_key* cur = &ticket_keys[ticket_cur];
+    ticket_key* prev = &ticket_keys[ticket_cur ^ 1];
+    int64_t now = ticket_now();
+
+    if (prev->used
+        && now - prev->retired >= ESP_WOLFSSL_TICKET_ROTATE_S) {
+        ticket_key_free(prev);
+    }
+    if (!cur->used || now - cur->created >= ESP_WOLFSSL_TICKET_ROTATE_S) {
+        return ticket_key_new();
+    }
+    return 0;
+}
+
+#if ESP_WOLFSSL_TICKET_REPLAY > 0
+/* under the lock; 1 when the tag was seen before, otherwise remembers it */
+static int ticket_replayed(const byte* tag)
+{
+    uint64_t v;
+    int i;
+
+    XMEMCPY(&v, tag, sizeof(v));
+    v |= 1;
+    for (i = 0; i < ESP_WOLFSSL_TICKET_REPLAY; i++) {
+        if (ticket_seen[i] == v) {
+            return 1;
+        }
+    }
+    ticket_seen[ticket_seen_next] = v;
+    ticket_seen_next = (ticket_seen_next + 1) % ESP_WOLFSSL_TICKET_REPLAY;
+    return 0;
+}
+#endif
+
+/* key_name and the nonce in iv are authenticated along with the ticket */
+static int ticket_seal(unsigned char key_name[WOLFSSL_TICKET_NAME_SZ],
+                       unsigned char iv[WOLFSSL_TICKET_IV_SZ],
+                       unsigned char mac[WOLFSSL_TICKET_MAC_SZ],
+                       unsigned char* ticket, int in_len, int* out_len)
+{
+    byte aad[WOLFSSL_TICKET_NAME_SZ + TICKET_NONCE_SZ];
+    ticket_key* k;
+    int ret;
+
+    ret = ticket_keys_update();
+    k = &ticket_keys[ticket_cur];
+    if (ret == 0) {
+        XMEMCPY(key_name, k->name, WOLFSSL_TICKET_NAME_SZ);
+        XMEMSET(iv, 0, WOLFSSL_TICKET_IV_SZ);
+        XMEMSET(mac, 0, WOLFSSL_TICKET_MAC_SZ);
+        ret = wc_RNG_GenerateBlock(&ticket_rng, iv, TICKET_NONCE_SZ);
+    }
+    if (ret == 0) {
+        XMEMCPY(aad, key_name, WOLFSSL_TICKET_NAME_SZ);
+        XMEMCPY(aad + WOLFSSL_TICKET_NAME_SZ, iv, TICKET_NONCE_SZ);
+        ret = wc_AesGcmEncrypt(&k->aes, ticket, ticket, (word32)in_len,
+                               iv, TICKET_NONCE_SZ, mac, TICKET_TAG_SZ,
+                               aad, sizeof(aad));
+    }
+    if (ret != 0) {
+        return WOLFSSL_TICKET_RET_FATAL;
+    }
+    *out_len = in_len;
+    ticket_stats.issued++;
+    return WOLFSSL_TICKET_RET_OK;
+}
+
+static int ticket_open(unsigned char key_name[WOLFSSL_TICKET_NAME_SZ],
+                       unsigned char iv[WOLFSSL_TICKET_IV_SZ],
+                       unsigned char mac[WOLFSSL_TICKET_MAC_SZ],
+                       unsigned char* ticket, int in_len, int* out_len)
+{
+    byte aad[WOLFSSL_TICKET_NAME_SZ + TICKET_NONCE_SZ];
+    ticket_key* k = NULL;
+    int i;
+
+    if (ticket_keys_update() != 0) {
+        return WOLFSSL_TICKET_RET_FATAL;
+    }
+    for (i = 0; i < 2; i++) {
+        if (ticket_keys[i].used
+            && XMEMCMP(ticket_keys[i].name, key_name,
+                       WOLFSSL_TICKET_NAME_SZ) == 0) {
+            k = &ticket_keys[i];
+            break;
+        }
+    }
+    if (k == NULL) {
+        ticket_stats.unknown_key++;
+        return WOLFSSL_TICKET_RET_REJECT;
+    }
+
+    XMEMCPY(aad, key_name, WOLFSSL_TICKET_NAME_SZ);
+    XMEMCPY(aad + WOLFSSL_TICKET_NAME_SZ, iv, TICKET_NONCE_SZ);
+    if (wc_AesGcmDecrypt(&k->aes, ticket, ticket, (word32)in_len,
+                         iv, TICKET_NONCE_SZ, mac, TICKET_TAG_SZ,
+                         aad, sizeof(aad)) != 0) {
+        ticket_stats.bad_tag++;
+        return WOLFSSL_TICKET_RET_REJECT;
+    }
+#if ESP_WOLFSSL_TICKET_REPLAY > 0
+    /* only authentic tickets take a slot, so made-up ones cannot flush
+     * the window */
+    if (ticket_replayed(mac)) {
+        ticket_stats.replayed++;
+        return WOLFSSL_TICKET_RET_REJECT;
+    }
+#endif
+    *out_len = in_len;
+    ticket_stats.accepted++;
+    if (k != &ticket_keys[ticket_cur]) {
+        ticket_stats.renewed++;
+        return WOLFSSL_TICKET_RET_CREATE;
+    }
+#if ESP_WOLFSSL_TICKET_REPLAY > 0
+    /* the ticket is spent: hand out a new one, or the next resumption
+     * would present this one again and get a full handshake */
+    return WOLFSSL_TICKET_RET_CREATE;
+#else
+    return WOLFSSL_TICKET_RET_OK;
+#endif
+}
+
+static int ticket_cb(WOLFSSL* ssl, unsigned char key_name[WOLFSSL_TICKET_NAME_SZ],
+                     unsigned char iv[WOLFSSL_TICKET_IV_SZ],
+                     unsigned char mac[WOLFSSL_TICKET_MAC_SZ],
+                     int enc, unsigned char* ticket, int in_len, int* out_len,
+                     void* ctx)
+{
+    int ret;
+
+    (void)ssl;
+    (void)ctx;
+
+    if (ticket == NULL || in_len < 0 || out_len == NULL) {
+        return WOLFSSL_TICKET_RET_FATAL;
+    }
+    if (!ticket_lock()) {
+        return WOLFSSL_TICKET_RET_FATAL;
+    }
+    if (enc) {
+        ret = ticket_seal(key_name, iv, mac, ticket, in_len, out_len);
+    }
+    else {
+        ret = ticket_open(key_name, iv, mac, ticket, in_len, out_len);
+    }
+    ticket_unlock();
+    return ret;
+}
+
+int esp_wolfssl_ticket_ctx_setup(WOLFSSL_CTX* ctx)
+{
+    int ret;
+
+    if (ctx == NULL) {
+        return BAD_FUNC_ARG;
+    }
+    ret = wolfSSL_CTX_set_TicketEncCb(ctx, ticket_cb);
+    if (ret == WOLFSSL_SUCCESS) {
+        /* the shortest life of a ticket, sealed just before rotation */
+        ret = wolfSSL_CTX_set_TicketHint(ctx, ESP_WOLFSSL_TICKET_ROTATE_S);
+    }
+    return ret;
+}
+
+int esp_wolfssl_ticket_rotate(void)
+{
+    int ret;
+
+    if (!ticket_lock()) {
+        return BAD_MUTEX_E;
+    }
+    ret = ticket_key_new();
+    ticket_unlock();
+    return ret;
+}
+
+void esp_wolfssl_ticket_clear(void)
+{
+    if (!ticket_lock()) {
+        return;
+    }
+    ticket_key_free(&ticket_keys[0]);
+    ticket_key_free(&ticket_keys[1]);
+#if ESP_WOLFSSL_TICKET_REPLAY > 0
+    XMEMSET(ticket_seen, 0, sizeof(ticket_seen));
+    ticket_seen_next = 0;
+#endif
+    ticket_unlock();
+}
+
+void esp_wolfssl_ticket_get_stats(esp_wolfssl_ticket_stats_t* stats)
+{
+    if (stats == NULL) {
+        return;
+    }
+    if (!ticket_lock()) {
+        XMEMSET(stats, 0, sizeof(*stats));
+        return;
+    }
+    *stats = ticket_stats;
+    ticket_unlock();
+}
+
+#endif /* WOLFSSL_ESP_TICKET */
@@ -0,0 +1,101 @@
+/* esp_wolfssl_ticket.h
+ *
+ * Copyright (C) 2006-2024 wolfSSL Inc.
+ *
+ * This file is part of wolfSSL.
+ *
+ * wolfSSL is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfSSL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335, USA
+ */
+
+/* Server session tickets with rotating keys.
+ *
+ * Enabled with Kconfig WOLFSSL_SESSION_TICKETS. The component builds with
+ * NO_SESSION_CACHE, so a server keeps no state to resume a session from;
+ * with tickets the client brings that state back, encrypted under a key
+ * only the server knows, and a resumed handshake skips the certificate
+ * and its signature. Install the engine on a server context with
+ *
+ *   esp_wolfssl_ticket_ctx_setup(ctx);
+ *
+ * Tickets are sealed with AES-256-GCM, on the AES accelerator where the
+ * chip has one, under a random key that is replaced every
+ * ESP_WOLFSSL_TICKET_ROTATE_S seconds. Tickets of the previous key are
+ * still accepted for one more period from the rotation and answered with a
+ * ticket under the current key; older ones lead to a full handshake. Every
+ * ticket thus lives between one and two periods. A ticket is the 16 byte
+ * key name, a random 12 byte nonce and the 16 byte tag, which also cover
+ * the key name and nonce, around the state wolfSSL puts in it.
+ *
+ * Each ticket is accepted once: the tags of the last
+ * ESP_WOLFSSL_TICKET_REPLAY accepted tickets are remembered and a ticket
+ * seen again gets a full handshake, so a captured ticket cannot be
+ * replayed while it is in that window. Every resumption then also gets a
+ * fresh ticket for the next one. Keys and replay state are in RAM
+ * only; after a reboot every client does a full handshake.
+ */
+
+#ifndef _ESP_WOLFSSL_TICKET_H_
+#define _ESP_WOLFSSL_TICKET_H_
+
+#include <stdint.h>
+
+#include <wolfssl/wolfcrypt/settings.h>
+#include <wolfssl/ssl.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef ESP_WOLFSSL_TICKET_ROTATE_S
+    #define ESP_WOLFSSL_TICKET_ROTATE_S 3600
+#endif
+/* 0 turns the replay check off */
+#ifndef ESP_WOLFSSL_TICKET_REPLAY
+    #define ESP_WOLFSSL_TICKET_REPLAY   64
+#endif
+
+typedef struct esp_wolfssl_ticket_stats_t {
+    uint32_t issued;
+    uint32_t accepted;
+    uint32_t renewed;       /* accepted under the previous key */
+    uint32_t unknown_key;   /* rotated out, or from before a reboot */
+    uint32_t bad_tag;
+    uint32_t replayed;
+    uint32_t rotations;
+} esp_wolfssl_ticket_stats_t;
+
+#ifdef WOLFSSL_ESP_TICKET
+
+/* Ticket callback and a ticket lifetime hint of one rotation period.
+ * Returns WOLFSSL_SUCCESS or an error. */
+int esp_wolfssl_ticket_ctx_setup(WOLFSSL_CTX* ctx);
+
+/* Replaces the current key now, e.g. after a suspected compromise of a
+ * client; tickets under the current key stay valid for one more period.
+ * Returns 0 or an error. */
+int esp_wolfssl_ticket_rotate(void);
+
+/* Wipes both keys and the replay state, invalidating every ticket. */
+void esp_wolfssl_ticket_clear(void);
+
+void esp_wolfssl_ticket_get_stats(esp_wolfssl_ticket_stats_t* stats);
+
+#endif /* WOLFSSL_ESP_TICKET */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _ESP_WOLFSSL_TICKET_H_ */
@@ -0,0 +1,673 @@
+/* esp_wolfssl_trace.c
+ *
+ * Copyright (C) 2006-2024 wolfSSL Inc.
+ *
+ * This file is part of wolfSSL.
+ *
+ * wolfSSL is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfSSL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335, USA
+ */
+
+#include <wolfssl/wolfcrypt/settings.h>
+
+#ifdef WOLFSSL_ESP_TRACE
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/types.h>
+
+#include <wolfssl/ssl.h>
+#ifdef OPENSSL_EXTRA
+    #include <wolfssl/internal.h>
+#endif
+#include <wolfssl/wolfcrypt/random.h>
+#ifdef HAVE_ECC
+    #include <wolfssl/wolfcrypt/ecc.h>
+#endif
+#ifdef HAVE_CURVE25519
+    #include <wolfssl/wolfcrypt/curve25519.h>
+#endif
+#ifndef NO_RSA
+    #include <wolfssl/wolfcrypt/rsa.h>
+#endif
+
+#ifdef WOLFSSL_ESPIDF
+    #include <esp_log.h>
+    #include <esp_cpu.h>
+    #include <esp_rom_sys.h>
+    #ifdef CONFIG_APPTRACE_ENABLE
+        #include <esp_app_trace.h>
+    #endif
+
+    #define TRACE_CYCLES()  ((uint32_t)esp_cpu_get_cycle_count())
+    #define TRACE_CORE()    ((uint8_t)esp_cpu_get_core_id())
+    #define TRACE_HZ()      (esp_rom_get_cpu_ticks_per_us() * 1000000UL)
+
+    /* wolfio.c reaches lwIP through the recv()/send() inlines */
+    #define TRACE_RECV      lwip_recv
+    #define TRACE_SEND      lwip_send
+#else
+    #include <time.h>
+
+    /* host: nanoseconds stand in for cycles */
+    static uint32_t trace_host_ns(void)
+    {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return (uint32_t)((uint64_t)ts.tv_sec * 1000000000ULL
+                          + (uint64_t)ts.tv_nsec);
+    }
+    #define TRACE_CYCLES()  trace_host_ns()
+    #define TRACE_CORE()    ((uint8_t)0)
+    #define TRACE_HZ()      1000000000UL
+
+    #define TRACE_RECV      recv
+    #define TRACE_SEND      send
+
+    #define ESP_LOGW(tag, fmt, ...) \
+                fprintf(stderr, "W %s: " fmt "\n", tag, ##__VA_ARGS__)
+    #define ESP_LOGI(tag, fmt, ...) \
+                printf("I %s: " fmt "\n", tag, ##__VA_ARGS__)
+#endif
+
+#include "esp_wolfssl_trace.h"
+#ifdef WOLFSSL_ESP_KEYPOOL
+    #include "esp_wolfssl_keypool.h"
+#endif
+#ifdef WOLFSSL_ESP_ECC_HW
+    #include "esp_wolfssl_ecc_hw.h"
+#endif
+#ifdef WOLFSSL_ESP_RNG_POOL
+    #include "esp_wolfssl_rng.h"
+#endif
+
+#if (ESP_WOLFSSL_TRACE_EVENTS & (ESP_WOLFSSL_TRACE_EVENTS - 1)) != 0
+    #error "ESP_WOLFSSL_TRACE_EVENTS must be a power of two"
+#endif
+
+#define TRACE_MASK (ESP_WOLFSSL_TRACE_EVENTS - 1)
+
+static const char* const TAG = "wolfssl_trace";
+
+/* Keep in sync with esp_wolfssl_trace_id_t */
+static const char* const trace_names[ESP_WOLFSSL_TRACE_ID_COUNT] = {
+    "handshake",
+    "msg_in",
+    "msg_out",
+    "net_recv",
+    "net_send",
+    "cert_parse",
+    "sig_verify",
+    "sign",
+    "keygen",
+    "ecdh",
+    "rng",
+    "user",
+};
+
+static esp_wolfssl_trace_event_t trace_ring[ESP_WOLFSSL_TRACE_EVENTS];
+static uint32_t trace_head;
+static uint32_t trace_base;     /* value of trace_head at the last clear */
+static int      trace_on = 1;
+
+/* connection in a handshake call on the calling task, 0 if none */
+static __thread uint32_t trace_conn;
+
+/* Slot generation for write index i; never 0, so a zeroed slot is empty */
+#define TRACE_SEQ(i) ((uint8_t)(((i) / ESP_WOLFSSL_TRACE_EVENTS) % 255 + 1))
+
+void esp_wolfssl_trace_event(esp_wolfssl_trace_id_t id, char phase,
+                             uint32_t arg)
+{
+    uint32_t i;
+    esp_wolfssl_trace_event_t* ev;
+
+    if (!__atomic_load_n(&trace_on, __ATOMIC_RELAXED)) {
+        return;
+    }
+
+    i = __atomic_fetch_add(&trace_head, 1, __ATOMIC_RELAXED);
+    ev = &trace_ring[i & TRACE_MASK];
+
+    /* invalidate first, so a concurrent reader skips a half written slot */
+    __atomic_store_n(&ev->seq, 0, __ATOMIC_RELAXED);
+    ev->cycles = TRACE_CYCLES();
+    ev->id     = (uint8_t)id;
+    ev->phase  = (uint8_t)phase;
+    ev->core   = TRACE_CORE();
+    ev->conn   = trace_conn;
+    ev->arg    = arg;
+    __atomic_store_n(&ev->seq, TRACE_SEQ(i), __ATOMIC_RELEASE);
+}
+
+void esp_wolfssl_trace_start(void)
+{
+    __atomic_store_n(&trace_on, 1, __ATOMIC_RELAXED);
+}
+
+void esp_wolfssl_trace_stop(void)
+{
+    __atomic_store_n(&trace_on, 0, __ATOMIC_RELAXED);
+}
+
+void esp_wolfssl_trace_clear(void)
+{
+    __atomic_store_n(&trace_base, __atomic_load_n(&trace_head,
+                     __ATOMIC_RELAXED), __ATOMIC_RELAXED);
+}
+
+int esp_wolfssl_trace_read(esp_wolfssl_trace_event_t* out, int max,
+                           uint32_t* dropped)
+{
+    uint32_t head = __atomic_load_n(&trace_head, __ATOMIC_ACQUIRE);
+    uint32_t base = __atomic_load_n(&trace_base, __ATOMIC_RELAXED);
+    uint32_t count = head - base;
+    uint32_t i;
+    int n = 0;
+    const esp_wolfssl_trace_event_t* ev;
+
+    if (count > ESP_WOLFSSL_TRACE_EVENTS) {
+        base = head - ESP_WOLFSSL_TRACE_EVENTS;
+    }
+    if (dropped != NULL) {
+        *dropped = (count > ESP_WOLFSSL_TRACE_EVENTS) ?
+                       count - ESP_WOLFSSL_TRACE_EVENTS : 0;
+    }
+    if (out == NULL) {
+        return 0;
+    }
+
+    for (i = base; i != head && n < max; i++) {
+        ev = &trace_ring[i & TRACE_MASK];
+        if (__atomic_load_n(&ev->seq, __ATOMIC_ACQUIRE) != TRACE_SEQ(i)) {
+            continue; /* not yet written or already overwritten */
+        }
+        out[n] = *ev;
+        if (out[n].seq == TRACE_SEQ(i)) {
+            n++;
+        }
+    }
+
+    return n;
+}
+
+/* One line per event: WTRC <cycles> <core> <phase> <conn> <name> <arg> */
+static int trace_format(const esp_wolfssl_trace_event_t* ev,
+                        char* line, size_t lineSz)
+{
+    const char* name = (ev->id < ESP_WOLFSSL_TRACE_ID_COUNT) ?
+                           trace_names[ev->id] : "unknown";
+
+    return snprintf(line, lineSz, "WTRC %u %u %c %08x %s %u",
+                    (unsigned)ev->cycles, (unsigned)ev->core,
+                    (char)ev->phase, (unsigned)ev->conn, name,
+                    (unsigned)ev->arg);
+}
+
+void esp_wolfssl_trace_dump(void)
+{
+    esp_wolfssl_trace_event_t ev;
+    uint32_t head = __atomic_load_n(&trace_head, __ATOMIC_ACQUIRE);
+    uint32_t base = __atomic_load_n(&trace_base, __ATOMIC_RELAXED);
+    uint32_t dropped = 0;
+    uint32_t i;
+    char line[80];
+
+    if (head - base > ESP_WOLFSSL_TRACE_EVENTS) {
+        dropped = head - base - ESP_WOLFSSL_TRACE_EVENTS;
+        base = head - ESP_WOLFSSL_TRACE_EVENTS;
+    }
+
+    ESP_LOGI(TAG, "WTRC-START hz=%lu events=%u dropped=%u",
+             (unsigned long)TRACE_HZ(), (unsigned)(head - base),
+             (unsigned)dropped);
+    /* one event at a time: a full copy of the ring does not fit the stack */
+    for (i = base; i != head; i++) {
+        ev = trace_ring[i & TRACE_MASK];
+        if (ev.seq != TRACE_SEQ(i)) {
+            continue;
+        }
+        trace_format(&ev, line, sizeof(line));
+        ESP_LOGI(TAG, "%s", line);
+    }
+    ESP_LOGI(TAG, "WTRC-END");
+}
+
+int esp_wolfssl_trace_dump_apptrace(void)
+{
+#if defined(WOLFSSL_ESPIDF) && defined(CONFIG_APPTRACE_ENABLE)
+    esp_wolfssl_trace_event_t ev;
+    uint32_t head = __atomic_load_n(&trace_head, __ATOMIC_ACQUIRE);
+    uint32_t base = __atomic_load_n(&trace_base, __ATOMIC_RELAXED);
+    uint32_t dropped = 0;
+    uint32_t i;
+    char line[80];
+    int n;
+    esp_err_t err;
+
+    if (!esp_apptrace_host_is_connected(ESP_APPTRACE_DEST_JTAG)) {
+        ESP_LOGW(TAG, "app_trace: no host connected");
+        return -1;
+    }
+    if (head - base > ESP_WOLFSSL_TRACE_EVENTS) {
+        dropped = head - base - ESP_WOLFSSL_TRACE_EVENTS;
+        base = head - ESP_WOLFSSL_TRACE_EVENTS;
+    }
+
+    n = snprintf(line, sizeof(line), "WTRC-START hz=%lu events=%u "
+                 "dropped=%u\n", (unsigned long)TRACE_HZ(),
+                 (unsigned)(head - base), (unsigned)dropped);
+    err = esp_apptrace_write(ESP_APPTRACE_DEST_JTAG, line, n,
+                             ESP_APPTRACE_TMO_INFINITE);
+    for (i = base; err == ESP_OK && i != head; i++) {
+        ev = trace_ring[i & TRACE_MASK];
+        if (ev.seq != TRACE_SEQ(i)) {
+            continue;
+        }
+        n = trace_format(&ev, line, sizeof(line) - 1);
+        line[n++] = '\n';
+        err = esp_apptrace_write(ESP_APPTRACE_DEST_JTAG, line, n,
+                                 ESP_APPTRACE_TMO_INFINITE);
+    }
+    if (err == ESP_OK) {
+        err = esp_apptrace_write(ESP_APPTRACE_DEST_JTAG, "WTRC-END\n", 9,
+                                 ESP_APPTRACE_TMO_INFINITE);
+    }
+    if (err == ESP_OK) {
+        err = esp_apptrace_flush(ESP_APPTRACE_DEST_JTAG, 1000);
+    }
+
+    return (err == ESP_OK) ? 0 : -1;
+#else
+    ESP_LOGW(TAG, "app_trace not enabled, use esp_wolfssl_trace_dump()");
+    return -1;
+#endif
+}
+
+/* Linker wrappers, see the component CMakeLists.txt. Crypto and network
+ * events are only recorded inside a traced handshake call. */
+
+#define TRACE_IN_HANDSHAKE() (trace_conn != 0)
+
+#define TRACE_SPAN(id, arg, call)                                   \
+    do {                                                            \
+        if (TRACE_IN_HANDSHAKE()) {                                 \
+            esp_wolfssl_trace_event((id), ESP_WOLFSSL_TRACE_BEGIN,  \
+                                    (uint32_t)(arg));               \
+            ret = call;                                             \
+            esp_wolfssl_trace_event((id), ESP_WOLFSSL_TRACE_END,    \
+                                    (uint32_t)ret);                 \
+        }                                                           \
+        else {                                                      \
+            ret = call;                                             \
+        }                                                           \
+    } while (0)
+
+#ifdef OPENSSL_EXTRA
+/* the application's message callback, called after ours */
+typedef struct trace_msg_chain {
+    SSL_Msg_Cb cb;
+    void*      arg;
+} trace_msg_chain;
+
+static void trace_msg_cb(int write_p, int version, int content_type,
+                         const void* buf, size_t len, WOLFSSL* ssl,
+                         void* arg)
+{
+    const trace_msg_chain* chain = (const trace_msg_chain*)arg;
+    const unsigned char* msg = (const unsigned char*)buf;
+    uint8_t type = 0;
+
+    /* handshake: message type; alert: description */
+    if (msg != NULL && len > 1) {
+        type = (content_type == 21) ? msg[1] : msg[0];
+    }
+    esp_wolfssl_trace_event(write_p ? ESP_WOLFSSL_TRACE_MSG_OUT :
+                                      ESP_WOLFSSL_TRACE_MSG_IN,
+                            ESP_WOLFSSL_TRACE_INSTANT,
+                            ESP_WOLFSSL_TRACE_MSG_ARG(content_type, type,
+                                                      len));
+    if (chain != NULL && chain->cb != NULL) {
+        chain->cb(write_p, version, content_type, buf, len, ssl,
+                  chain->arg);
+    }
+}
+#endif
+
+static int trace_handshake(WOLFSSL* ssl, int (*real)(WOLFSSL*), int server)
+{
+    uint32_t prev = trace_conn;
+    int ret;
+#ifdef WOLFSSL_ESP_MEM_AUTO
+    int mem_prev;
+#endif
+#ifdef OPENSSL_EXTRA
+    trace_msg_chain chain;
+#endif
+
+    if (ssl == NULL) {
+        return real(ssl);
+    }
+#ifdef OPENSSL_EXTRA
+    /* installed for this call only, in front of the application's own
+     * callback, which is restored afterwards */
+    chain.cb  = ssl->protoMsgCb;
+    chain.arg = ssl->protoMsgCtx;
+    wolfSSL_set_msg_callback(ssl, trace_msg_cb);
+    wolfSSL_set_msg_callback_arg(ssl, &chain);
+#endif
+
+    trace_conn = (uint32_t)(uintptr_t)ssl;
+    esp_wolfssl_trace_event(ESP_WOLFSSL_TRACE_HANDSHAKE,
+                            ESP_WOLFSSL_TRACE_BEGIN, (uint32_t)server);
+#ifdef WOLFSSL_ESP_MEM_AUTO
+    /* heap accounting wraps the same functions */
+    mem_prev = esp_wolfssl_mem_ssl_enter(ssl);
+#endif
+    ret = real(ssl);
+#ifdef WOLFSSL_ESP_MEM_AUTO
+    esp_wolfssl_mem_domain_leave(mem_prev);
+#endif
+    esp_wolfssl_trace_event(ESP_WOLFSSL_TRACE_HANDSHAKE,
+                            ESP_WOLFSSL_TRACE_END, (uint32_t)ret);
+    trace_conn = prev;
+
+#ifdef OPENSSL_EXTRA
+    /* unless the application replaced it during the handshake */
+    if (ssl->protoMsgCb == trace_msg_cb && ssl->protoMsgCtx == &chain) {
+        ssl->protoMsgCb  = chain.cb;
+        ssl->protoMsgCtx = chain.arg;
+    }
+#endif
+
+    return ret;
+}
+
+int __real_wolfSSL_connect(WOLFSSL* ssl);
+int __wrap_wolfSSL_connect(WOLFSSL* ssl);
+int __wrap_wolfSSL_connect(WOLFSSL* ssl)
+{
+    return trace_handshake(ssl, __real_wolfSSL_connect, 0);
+}
+
+#ifndef NO_WOLFSSL_SERVER
+int __real_wolfSSL_accept(WOLFSSL* ssl);
+int __wrap_wolfSSL_accept(WOLFSSL* ssl);
+int __wrap_wolfSSL_accept(WOLFSSL* ssl)
+{
+    return trace_handshake(ssl, __real_wolfSSL_accept, 1);
+}
+#endif
+
+/* TRACE_RECV / TRACE_SEND expand before the ## paste */
+#define TRACE_WRAP_(sym)  __wrap_##sym
+#define TRACE_REAL_(sym)  __real_##sym
+#define TRACE_WRAP(sym)   TRACE_WRAP_(sym)
+#define TRACE_REAL(sym)   TRACE_REAL_(sym)
+
+ssize_t TRACE_REAL(TRACE_RECV)(int s, void* mem, size_t len, int flags);
+ssize_t TRACE_WRAP(TRACE_RECV)(int s, void* mem, size_t len, int flags);
+ssize_t TRACE_WRAP(TRACE_RECV)(int s, void* mem, size_t len, int flags)
+{
+    ssize_t ret;
+    TRACE_SPAN(ESP_WOLFSSL_TRACE_NET_RECV, len,
+               TRACE_REAL(TRACE_RECV)(s, mem, len, flags));
+    return ret;
+}
+
+ssize_t TRACE_REAL(TRACE_SEND)(int s, const void* data, size_t size,
+                               int flags);
+ssize_t TRACE_WRAP(TRACE_SEND)(int s, const void* data, size_t size,
+                               int flags);
+ssize_t TRACE_WRAP(TRACE_SEND)(int s, const void* data, size_t size,
+                               int flags)
+{
+    ssize_t ret;
+    TRACE_SPAN(ESP_WOLFSSL_TRACE_NET_SEND, size,
+               TRACE_REAL(TRACE_SEND)(s, data, size, flags));
+    return ret;
+}
+
+/* ParseCertRelative() is internal to wolfSSL and its argument list differs
+ * between releases. Only pointers and ints are passed in registers, so the
+ * wrapper forwards five without depending on the exact prototype. */
+int __real_ParseCertRelative(void* cert, int type, int verify, void* cm,
+                             void* extra);
+int __wrap_ParseCertRelative(void* cert, int type, int verify, void* cm,
+                             void* extra);
+int __wrap_ParseCertRelative(void* cert, int type, int verify, void* cm,
+                             void* extra)
+{
+    int ret;
+    TRACE_SPAN(ESP_WOLFSSL_TRACE_CERT_PARSE, type,
+               __real_ParseCertRelative(cert, type, verify, cm, extra));
+    return ret;
+}
+
+int __real_wc_RNG_GenerateBlock(WC_RNG* rng, byte* b, word32 sz);
+int __wrap_wc_RNG_GenerateBlock(WC_RNG* rng, byte* b, word32 sz);
+int __wrap_wc_RNG_GenerateBlock(WC_RNG* rng, byte* b, word32 sz)
+{
+    int ret;
+#ifdef WOLFSSL_ESP_RNG_POOL
+    /* the random pool wraps the same function */
+    TRACE_SPAN(ESP_WOLFSSL_TRACE_RNG, sz,
+               esp_wolfssl_rng_generate_block(rng, b, sz));
+#else
+    TRACE_SPAN(ESP_WOLFSSL_TRACE_RNG, sz,
+               __real_wc_RNG_GenerateBlock(rng, b, sz));
+#endif
+    return ret;
+}
+
+#ifdef HAVE_ECC
+int __real_wc_ecc_make_key_ex(WC_RNG* rng, int keysize, ecc_key* key,
+                              int curve_id);
+int __wrap_wc_ecc_make_key_ex(WC_RNG* rng, int keysize, ecc_key* key,
+                              int curve_id);
+int __wrap_wc_ecc_make_key_ex(WC_RNG* rng, int keysize, ecc_key* key,
+                              int curve_id)
+{
+    int ret;
+#ifdef WOLFSSL_ESP_KEYPOOL
+    /* the key pool wraps the same function */
+    TRACE_SPAN(ESP_WOLFSSL_TRACE_KEYGEN, curve_id,
+               esp_wolfssl_keypool_ecc_make_key(rng, keysize, key, curve_id));
+#elif defined(WOLFSSL_ESP_ECC_HW)
+    /* and so does the ECC peripheral driver */
+    TRACE_SPAN(ESP_WOLFSSL_TRACE_KEYGEN, curve_id,
+               esp_wolfssl_ecc_hw_make_key(rng, keysize, key, curve_id));
+#else
+    TRACE_SPAN(ESP_WOLFSSL_TRACE_KEYGEN, curve_id,
+               __real_wc_ecc_make_key_ex(rng, keysize, key, curve_id));
+#endif
+    return ret;
+}
+
+#ifdef HAVE_ECC_DHE
+int __real_wc_ecc_shared_secret(ecc_key* private_key, ecc_key* public_key,
+                                byte* out, word32* outlen);
+int __wrap_wc_ecc_shared_secret(ecc_key* private_key, ecc_key* public_key,
+                                byte* out, word32* outlen);
+int __wrap_wc_ecc_shared_secret(ecc_key* private_key, ecc_key* public_key,
+                                byte* out, word32* outlen)
+{
+    int ret;
+#ifdef WOLFSSL_ESP_ECC_HW
+    TRACE_SPAN(ESP_WOLFSSL_TRACE_ECDH, 0,
+               esp_wolfssl_ecc_hw_shared_secret(private_key, public_key, out,
+                                                outlen));
+#else
+    TRACE_SPAN(ESP_WOLFSSL_TRACE_ECDH, 0,
+               __real_wc_ecc_shared_secret(private_key, public_key, out,
+                                           outlen));
+#endif
+    return ret;
+}
+#endif /* HAVE_ECC_DHE */
+
+#ifdef HAVE_ECC_SIGN
+int __real_wc_ecc_sign_hash(const byte* in, word32 inlen, byte* out,
+                            word32* outlen, WC_RNG* rng, ecc_key* key);
+int __wrap_wc_ecc_sign_hash(const byte* in, word32 inlen, byte* out,
+                            word32* outlen, WC_RNG* rng, ecc_key* key);
+int __wrap_wc_ecc_sign_hash(const byte* in, word32 inlen, byte* out,
+                            word32* outlen, WC_RNG* rng, ecc_key* key)
+{
+    int ret;
+    TRACE_SPAN(ESP_WOLFSSL_TRACE_SIGN, inlen,
+               __real_wc_ecc_sign_hash(in, inlen, out, outlen, rng, key));
+    return ret;
+}
+#endif /* HAVE_ECC_SIGN */
+
+#ifdef HAVE_ECC_VERIFY
+int __real_wc_ecc_verify_hash(const byte* sig, word32 siglen,
+                              const byte* hash, word32 hashlen, int* res,
+                              ecc_key* key);
+int __wrap_wc_ecc_verify_hash(const byte* sig, word32 siglen,
+                              const byte* hash, word32 hashlen, int* res,
+                              ecc_key* key);
+int __wrap_wc_ecc_verify_hash(const byte* sig, word32 siglen,
+                              const byte* hash, word32 hashlen, int* res,
+                              ecc_key* key)
+{
+    int ret;
+#ifdef WOLFSSL_ESP_ECC_HW
+    TRACE_SPAN(ESP_WOLFSSL_TRACE_SIG_VERIFY, hashlen,
+               esp_wolfssl_ecc_hw_verify_hash(sig, siglen, hash, hashlen,
+                                              res, key));
+#else
+    TRACE_SPAN(ESP_WOLFSSL_TRACE_SIG_VERIFY, hashlen,
+               __real_wc_ecc_verify_hash(sig, siglen, hash, hashlen, res,
+                                         key));
+#endif
+    return ret;
+}
+#endif /* HAVE_ECC_VERIFY */
+#endif /* HAVE_ECC */
+
+#ifdef HAVE_CURVE25519
+/* keygen / ecdh argument for X25519; otherwise the ECC curve id */
+#define TRACE_X25519 25519
+
+int __real_wc_curve25519_make_key(WC_RNG* rng, int keysize,
+                                  curve25519_key* key);
+int __wrap_wc_curve25519_make_key(WC_RNG* rng, int keysize,
+                                  curve25519_key* key);
+int __wrap_wc_curve25519_make_key(WC_RNG* rng, int keysize,
+                                  curve25519_key* key)
+{
+    int ret;
+#ifdef WOLFSSL_ESP_KEYPOOL
+    TRACE_SPAN(ESP_WOLFSSL_TRACE_KEYGEN, TRACE_X25519,
+               esp_wolfssl_keypool_x25519_make_key(rng, keysize, key));
+#else
+    TRACE_SPAN(ESP_WOLFSSL_TRACE_KEYGEN, TRACE_X25519,
+               __real_wc_curve25519_make_key(rng, keysize, key));
+#endif
+    return ret;
+}
+
+int __real_wc_curve25519_shared_secret_ex(curve25519_key* private_key,
+                                          curve25519_key* public_key,
+                                          byte* out, word32* outlen,
+                                          int endian);
+int __wrap_wc_curve25519_shared_secret_ex(curve25519_key* private_key,
+                                          curve25519_key* public_key,
+                                          byte* out, word32* outlen,
+                                          int endian);
+int __wrap_wc_curve25519_shared_secret_ex(curve25519_key* private_key,
+                                          curve25519_key* public_key,
+                                          byte* out, word32* outlen,
+                                          int endian)
+{
+    int ret;
+    TRACE_SPAN(ESP_WOLFSSL_TRACE_ECDH, TRACE_X25519,
+               __real_wc_curve25519_shared_secret_ex(private_key, public_key,
+                                                     out, outlen, endian));
+    return ret;
+}
+#endif /* HAVE_CURVE25519 */
+
+#ifndef NO_RSA
+int __real_wc_RsaSSL_VerifyInline(byte* in, word32 inLen, byte** out,
+                                  RsaKey* key);
+int __wrap_wc_RsaSSL_VerifyInline(byte* in, word32 inLen, byte** out,
+                                  RsaKey* key);
+int __wrap_wc_RsaSSL_VerifyInline(byte* in, word32 inLen, byte** out,
+                                  RsaKey* key)
+{
+    int ret;
+    TRACE_SPAN(ESP_WOLFSSL_TRACE_SIG_VERIFY, inLen,
+               __real_wc_RsaSSL_VerifyInline(in, inLen, out, key));
+    return ret;
+}
+
+#if !defined(WOLFSSL_RSA_PUBLIC_ONLY) && !defined(WOLFSSL_RSA_VERIFY_ONLY)
+int __real_wc_RsaSSL_Sign(const byte* in, word32 inLen, byte* out,
+                          word32 outLen, RsaKey* key, WC_RNG* rng);
+int __wrap_wc_RsaSSL_Sign(const byte* in, word32 inLen, byte* out,
+                          word32 outLen, RsaKey* key, WC_RNG* rng);
+int __wrap_wc_RsaSSL_Sign(const byte* in, word32 inLen, byte* out,
+                          word32 outLen, RsaKey* key, WC_RNG* rng)
+{
+    int ret;
+    TRACE_SPAN(ESP_WOLFSSL_TRACE_SIGN, inLen,
+               __real_wc_RsaSSL_Sign(in, inLen, out, outLen, key, rng));
+    return ret;
+}
+#endif
+
+#ifdef WC_RSA_PSS
+int __real_wc_RsaPSS_VerifyInline(byte* in, word32 inLen, byte** out,
+                                  enum wc_HashType hash, int mgf,
+                                  RsaKey* key);
+int __wrap_wc_RsaPSS_VerifyInline(byte* in, word32 inLen, byte** out,
+                                  enum wc_HashType hash, int mgf,
+                                  RsaKey* key);
+int __wrap_wc_RsaPSS_VerifyInline(byte* in, word32 inLen, byte** out,
+                                  enum wc_HashType hash, int mgf,
+                                  RsaKey* key)
+{
+    int ret;
+    TRACE_SPAN(ESP_WOLFSSL_TRACE_SIG_VERIFY, inLen,
+               __real_wc_RsaPSS_VerifyInline(in, inLen, out, hash, mgf,
+                                             key));
+    return ret;
+}
+
+#if !defined(WOLFSSL_RSA_PUBLIC_ONLY) && !defined(WOLFSSL_RSA_VERIFY_ONLY)
+int __real_wc_RsaPSS_Sign(const byte* in, word32 inLen, byte* out,
+                          word32 outLen, enum wc_HashType hash, int mgf,
+                          RsaKey* key, WC_RNG* rng);
+int __wrap_wc_RsaPSS_Sign(const byte* in, word32 inLen, byte* out,
+                          word32 outLen, enum wc_HashType hash, int mgf,
+                          RsaKey* key, WC_RNG* rng);
+int __wrap_wc_RsaPSS_Sign(const byte* in, word32 inLen, byte* out,
+                          word32 outLen, enum wc_HashType hash, int mgf,
+                          RsaKey* key, WC_RNG* rng)
+{
+    int ret;
+    TRACE_SPAN(ESP_WOLFSSL_TRACE_SIGN, inLen,
+               __real_wc_RsaPSS_Sign(in, inLen, out, outLen, hash, mgf, key,
+                                     rng));
+    return ret;
+}
+#endif
+#endif /* WC_RSA_PSS */
+#endif /* !NO_RSA */
+
+#endif /* WOLFSSL_ESP_TRACE */
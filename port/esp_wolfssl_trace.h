@@ -0,0 +1,145 @@
+/* esp_wolfssl_trace.h
+ *
+ * Copyright (C) 2006-2024 wolfSSL Inc.
+ *
+ * This file is part of wolfSSL.
+ *
+ * wolfSSL is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfSSL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335, USA
+ */
+
+/* Handshake phase tracing.
+ *
+ * Enabled with Kconfig WOLFSSL_TRACE. Events are stamped with the CPU cycle
+ * counter and stored in a fixed ring buffer; the oldest events are
+ * overwritten once it is full. Recorded automatically, without changes to
+ * the wolfSSL sources:
+ *
+ *   - every handshake message sent and received (wolfSSL message callback).
+ *     These events need OPENSSL_EXTRA, which user_settings.h sets when
+ *     wolfSSL is the esp-tls stack; without it only the other events are
+ *     recorded. The callback is installed for the duration of each
+ *     wolfSSL_connect() / wolfSSL_accept() call and passes every message
+ *     on to a callback set by the application, which is restored after the
+ *     call.
+ *   - each wolfSSL_connect() / wolfSSL_accept() call
+ *   - socket receive / send during a handshake (network waits)
+ *   - certificate parsing, signing and signature verification, ECDHE /
+ *     X25519 key generation and shared secret, RNG
+ *
+ * The automatic events come from linker wrappers (-Wl,--wrap, see the
+ * component CMakeLists.txt), so they also cover connections made by esp-tls.
+ * Crypto and network events are only recorded inside a handshake call.
+ *
+ * Dump the buffer with esp_wolfssl_trace_dump() (logs) or
+ * esp_wolfssl_trace_dump_apptrace() (ESP-IDF app_trace over JTAG), then
+ * convert the captured text with tools/wolfssl_trace.py to a Chrome trace
+ * JSON file, which opens in chrome://tracing or https://ui.perfetto.dev
+ *
+ * Cycle counters are per core and are not synchronized; pin the task that
+ * runs the handshake to one core for a consistent timeline.
+ */
+
+#ifndef _ESP_WOLFSSL_TRACE_H_
+#define _ESP_WOLFSSL_TRACE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Number of events kept, must be a power of two. 16 bytes per event. */
+#ifndef ESP_WOLFSSL_TRACE_EVENTS
+    #define ESP_WOLFSSL_TRACE_EVENTS 512
+#endif
+
+/* Event ids. Keep in sync with the names in esp_wolfssl_trace.c */
+typedef enum esp_wolfssl_trace_id_t {
+    ESP_WOLFSSL_TRACE_HANDSHAKE = 0, /* wolfSSL_connect / wolfSSL_accept   */
+    ESP_WOLFSSL_TRACE_MSG_IN,        /* arg: content type, msg type, len   */
+    ESP_WOLFSSL_TRACE_MSG_OUT,       /* arg: content type, msg type, len   */
+    ESP_WOLFSSL_TRACE_NET_RECV,      /* end arg: socket return value       */
+    ESP_WOLFSSL_TRACE_NET_SEND,      /* end arg: socket return value       */
+    ESP_WOLFSSL_TRACE_CERT_PARSE,
+    ESP_WOLFSSL_TRACE_SIG_VERIFY,
+    ESP_WOLFSSL_TRACE_SIGN,
+    ESP_WOLFSSL_TRACE_KEYGEN,
+    ESP_WOLFSSL_TRACE_ECDH,
+    ESP_WOLFSSL_TRACE_RNG,           /* begin arg: bytes                   */
+    ESP_WOLFSSL_TRACE_USER,          /* application defined                */
+    ESP_WOLFSSL_TRACE_ID_COUNT
+} esp_wolfssl_trace_id_t;
+
+/* Event phases, as in the Chrome trace format. */
+#define ESP_WOLFSSL_TRACE_BEGIN   'B'
+#define ESP_WOLFSSL_TRACE_END     'E'
+#define ESP_WOLFSSL_TRACE_INSTANT 'i'
+
+/* MSG_IN / MSG_OUT argument */
+#define ESP_WOLFSSL_TRACE_MSG_ARG(content, msg, len)        \
+    (((uint32_t)(uint8_t)(content) << 24) |                 \
+     ((uint32_t)(uint8_t)(msg) << 16) |                     \
+     ((uint32_t)(len) > 0xFFFF ? 0xFFFF : (uint32_t)(len)))
+
+typedef struct esp_wolfssl_trace_event_t {
+    uint32_t cycles;    /* CPU cycle counter, wraps */
+    uint8_t  id;        /* esp_wolfssl_trace_id_t */
+    uint8_t  phase;     /* ESP_WOLFSSL_TRACE_BEGIN / _END / _INSTANT */
+    uint8_t  core;
+    uint8_t  seq;       /* slot generation, lets readers skip stale slots */
+    uint32_t conn;      /* connection tag, 0 outside a handshake */
+    uint32_t arg;
+} esp_wolfssl_trace_event_t;
+
+/* Recording is on after boot; stop it before dumping to get a consistent
+ * snapshot. */
+void esp_wolfssl_trace_start(void);
+void esp_wolfssl_trace_stop(void);
+void esp_wolfssl_trace_clear(void);
+
+/* Record an event for the connection in the current handshake, if any. */
+void esp_wolfssl_trace_event(esp_wolfssl_trace_id_t id, char phase,
+                             uint32_t arg);
+
+/* Copies up to max events, oldest first. Returns the number copied and, if
+ * dropped is not NULL, the number of events overwritten since the last
+ * clear. */
+int  esp_wolfssl_trace_read(esp_wolfssl_trace_event_t* out, int max,
+                            uint32_t* dropped);
+
+/* Writes the buffer as text lines for tools/wolfssl_trace.py */
+void esp_wolfssl_trace_dump(void);
+int  esp_wolfssl_trace_dump_apptrace(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+/* For other port modules: no code unless tracing is enabled. */
+#ifdef WOLFSSL_ESP_TRACE
+    #define ESP_WOLFSSL_TRACE_B(id, arg) \
+        esp_wolfssl_trace_event((id), ESP_WOLFSSL_TRACE_BEGIN, (arg))
+    #define ESP_WOLFSSL_TRACE_E(id, arg) \
+        esp_wolfssl_trace_event((id), ESP_WOLFSSL_TRACE_END, (arg))
+    #define ESP_WOLFSSL_TRACE_I(id, arg) \
+        esp_wolfssl_trace_event((id), ESP_WOLFSSL_TRACE_INSTANT, (arg))
+#else
+    #define ESP_WOLFSSL_TRACE_B(id, arg) do { } while (0)
+    #define ESP_WOLFSSL_TRACE_E(id, arg) do { } while (0)
+    #define ESP_WOLFSSL_TRACE_I(id, arg) do { } while (0)
+#endif
+
+#endif /* _ESP_WOLFSSL_TRACE_H_ */
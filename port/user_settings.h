@@ -143,8 +143,112 @@
 /* #define DEBUG_WOLFSSL */
 #define DEBUG_WOLFSSL_MALLOC
 
-/* RSA_LOW_MEM: Half as much memory but twice as slow. */
-#define RSA_LOW_MEM
+/* Optional heap accounting per connection and per DYNAMIC_TYPE_*.
+ * XMALLOC_USER keeps settings.h from mapping XMALLOC to pvPortMalloc;
+ * see port/esp_wolfssl_mem.h */
+#ifdef CONFIG_WOLFSSL_MEM_ACCOUNTING
+    #define WOLFSSL_ESP_MEM_ACCOUNTING
+    #define ESP_WOLFSSL_MEM_DOMAINS    CONFIG_WOLFSSL_MEM_ACCOUNTING_DOMAINS
+    #define ESP_WOLFSSL_MEM_TYPE_SLOTS CONFIG_WOLFSSL_MEM_ACCOUNTING_TYPES
+    #ifdef CONFIG_WOLFSSL_MEM_ACCOUNTING_AUTO
+        #define WOLFSSL_ESP_MEM_AUTO
+    #endif
+    #include "esp_wolfssl_mem.h"
+
+    #define XMALLOC_USER
+    #define XMALLOC  esp_wolfssl_malloc
+    #define XFREE    esp_wolfssl_free
+    #define XREALLOC esp_wolfssl_realloc
+#endif
+
+/* Optional shared record-buffer pool, on top of the heap accounting when
+ * both are enabled; see port/esp_wolfssl_bufpool.h */
+#ifdef CONFIG_WOLFSSL_BUFPOOL
+    #define WOLFSSL_ESP_BUFPOOL
+    #define ESP_WOLFSSL_BUFPOOL_BUFFERS   CONFIG_WOLFSSL_BUFPOOL_BUFFERS
+    #define ESP_WOLFSSL_BUFPOOL_BUFFER_SZ CONFIG_WOLFSSL_BUFPOOL_BUFFER_SZ
+    #include "esp_wolfssl_bufpool.h"
+
+    #undef  XMALLOC
+    #undef  XFREE
+    #undef  XREALLOC
+    #define XMALLOC_USER
+    #define XMALLOC  esp_wolfssl_bufpool_malloc
+    #define XFREE    esp_wolfssl_bufpool_free
+    #define XREALLOC esp_wolfssl_bufpool_realloc
+#endif
+
+/* Optional per-task scratch arena for the small-stack temporaries, on top
+ * of the record-buffer pool and the heap accounting; see
+ * port/esp_wolfssl_arena.h */
+#ifdef CONFIG_WOLFSSL_ARENA
+    #define WOLFSSL_ESP_ARENA
+    #define ESP_WOLFSSL_ARENA_SZ    CONFIG_WOLFSSL_ARENA_SZ
+    #define ESP_WOLFSSL_ARENA_TASKS CONFIG_WOLFSSL_ARENA_TASKS
+    #include "esp_wolfssl_arena.h"
+
+    #undef  XMALLOC
+    #undef  XFREE
+    #undef  XREALLOC
+    #define XMALLOC_USER
+    #define XMALLOC  esp_wolfssl_arena_malloc
+    #define XFREE    esp_wolfssl_arena_free
+    #define XREALLOC esp_wolfssl_arena_realloc
+#endif
+
+/* Optional buffered random pool in front of the Hash_DRBG, see
+ * port/esp_wolfssl_rng.h */
+#ifdef CONFIG_WOLFSSL_RNG_POOL
+    #define WOLFSSL_ESP_RNG_POOL
+    #define ESP_WOLFSSL_RNG_POOL_SZ CONFIG_WOLFSSL_RNG_POOL_SZ
+    #ifdef CONFIG_WOLFSSL_RNG_POOL_REFILL_TASK
+        #define WOLFSSL_ESP_RNG_REFILL_TASK
+    #endif
+#endif
+
+#ifdef CONFIG_WOLFSSL_HW_METRICS_API
+    #define WOLFSSL_ESP_HW_METRICS
+#endif
+
+#ifdef CONFIG_WOLFSSL_TRACE
+    #define WOLFSSL_ESP_TRACE
+    /* largest power of two not above the Kconfig value */
+    #if CONFIG_WOLFSSL_TRACE_EVENTS >= 8192
+        #define ESP_WOLFSSL_TRACE_EVENTS 8192
+    #elif CONFIG_WOLFSSL_TRACE_EVENTS >= 4096
+        #define ESP_WOLFSSL_TRACE_EVENTS 4096
+    #elif CONFIG_WOLFSSL_TRACE_EVENTS >= 2048
+        #define ESP_WOLFSSL_TRACE_EVENTS 2048
+    #elif CONFIG_WOLFSSL_TRACE_EVENTS >= 1024
+        #define ESP_WOLFSSL_TRACE_EVENTS 1024
+    #elif CONFIG_WOLFSSL_TRACE_EVENTS >= 512
+        #define ESP_WOLFSSL_TRACE_EVENTS 512
+    #elif CONFIG_WOLFSSL_TRACE_EVENTS >= 256
+        #define ESP_WOLFSSL_TRACE_EVENTS 256
+    #elif CONFIG_WOLFSSL_TRACE_EVENTS >= 128
+        #define ESP_WOLFSSL_TRACE_EVENTS 128
+    #else
+        #define ESP_WOLFSSL_TRACE_EVENTS 64
+    #endif
+#endif
+
+/* RSA private-key profile, see Kconfig "RSA private-key performance profile".
+ *
+ * RSA_LOW_MEM: Half as much memory but twice as slow.
+ *
+ * Otherwise the CRT parameters are used: two half-size exponentiations
+ * (1024 bits each for RSA-2048), which the MPI accelerator handles through
+ * esp_mp_exptmod(). WC_RSA_BLINDING randomizes the base of every private
+ * operation; keep it enabled whenever CRT is used. The blinding value and
+ * its inverse are computed inside rsa.c for each operation and are not
+ * cached: that would need changes to wolfcrypt/src/rsa.c itself, whose
+ * calls to the big-number code cannot be intercepted from the port. */
+#if defined(CONFIG_WOLFSSL_RSA_PROFILE_SPEED)
+    #undef  WC_RSA_BLINDING
+    #define WC_RSA_BLINDING
+#else
+    #define RSA_LOW_MEM
+#endif
 
 /* Uncommon settings for testing only */
 #define TEST_ESPIDF_ALL_WOLFSSL
@@ -284,6 +388,60 @@
 #define WOLFSSL_TLS13
 #endif
 
+/* DTLS, see port/esp_wolfssl_dtls.h       */
+#ifdef CONFIG_WOLFSSL_HAVE_DTLS
+    #define WOLFSSL_DTLS
+    #define WOLFSSL_DTLS_MTU
+    #define ESP_WOLFSSL_DTLS_MTU          CONFIG_WOLFSSL_DTLS_MTU
+    #define ESP_WOLFSSL_DTLS_TIMEOUT_INIT CONFIG_WOLFSSL_DTLS_TIMEOUT_INIT
+    #define ESP_WOLFSSL_DTLS_TIMEOUT_MAX  CONFIG_WOLFSSL_DTLS_TIMEOUT_MAX
+    #ifdef CONFIG_WOLFSSL_HAVE_DTLS_13
+        #define WOLFSSL_DTLS13
+        /* stateless cookie exchange before the server commits state */
+        #define WOLFSSL_SEND_HRR_COOKIE
+        /* a ClientHello with a large key share may not fit one datagram */
+        #define WOLFSSL_DTLS_CH_FRAG
+    #endif
+    #ifdef CONFIG_WOLFSSL_HAVE_DTLS_CID
+        #define WOLFSSL_DTLS_CID
+        #define ESP_WOLFSSL_DTLS_CID_LEN  CONFIG_WOLFSSL_DTLS_CID_LEN
+    #endif
+#endif
+
+/* Hybrid ML-KEM key exchange, see port/esp_wolfssl_pq.h */
+#ifdef CONFIG_WOLFSSL_HAVE_MLKEM
+    #define WOLFSSL_HAVE_KYBER
+    #define WOLFSSL_WC_KYBER
+    /* ML-KEM-768 only; the names differ between wolfSSL releases */
+    #define WOLFSSL_KYBER768
+    #define WOLFSSL_NO_KYBER512
+    #define WOLFSSL_NO_KYBER1024
+    #define WOLFSSL_NO_ML_KEM_512
+    #define WOLFSSL_NO_ML_KEM_1024
+    #ifdef CONFIG_WOLFSSL_MLKEM_SMALL
+        #define WOLFSSL_KYBER_SMALL
+    #endif
+    #ifndef WOLFSSL_SHA3
+        #define WOLFSSL_SHA3
+    #endif
+    #define WOLFSSL_SHAKE128
+    #define WOLFSSL_SHAKE256
+    #define WOLFSSL_ESP_PQ
+    #ifdef CONFIG_WOLFSSL_MLKEM_DEFAULT
+        #define WOLFSSL_ESP_PQ_DEFAULT
+    #endif
+#endif
+
+/* Streaming OTA image verification, see port/esp_wolfssl_ota_verify.h */
+#ifdef CONFIG_WOLFSSL_OTA_VERIFY
+    #define WOLFSSL_ESP_OTA_VERIFY
+    #ifdef CONFIG_WOLFSSL_OTA_VERIFY_LMS
+        #define WOLFSSL_HAVE_LMS
+        #define WOLFSSL_WC_LMS
+        #define WOLFSSL_LMS_VERIFY_ONLY
+    #endif
+#endif
+
 #ifndef CONFIG_WOLFSSL_HAVE_RSA
 #define NO_RSA
 #endif
@@ -342,7 +500,9 @@
 /* #define OPENSSL_EXTRA */
 
 /* #Optional HAVE_PKCS7 */
-/* #define HAVE_PKCS7 */
+#ifdef CONFIG_WOLFSSL_HAVE_PKCS7
+    #define HAVE_PKCS7
+#endif
 
 #if defined(HAVE_PKCS7)
     /* HAVE_PKCS7 may enable HAVE_PBKDF2 see settings.h */
@@ -353,6 +513,111 @@
     #define WOLFSSL_AES_DIRECT
 #endif
 
+/* Streaming PKCS#7 decoding, see port/esp_wolfssl_pkcs7_stream.h */
+#ifdef CONFIG_WOLFSSL_PKCS7_STREAM
+    #define WOLFSSL_ESP_PKCS7_STREAM
+    #define ESP_WOLFSSL_PKCS7_HEAD_MAX CONFIG_WOLFSSL_PKCS7_STREAM_HEAD_MAX
+    #define ESP_WOLFSSL_PKCS7_TAIL_MAX CONFIG_WOLFSSL_PKCS7_STREAM_TAIL_MAX
+#endif
+
+/* Raw public keys (RFC 7250), see port/esp_wolfssl_rpk.h; the pins are
+ * checked in a verify callback that also runs when wolfSSL found no error */
+#ifdef CONFIG_WOLFSSL_RPK
+    #define HAVE_RPK
+    #define WOLFSSL_ESP_RPK
+    #ifndef WOLFSSL_ALWAYS_VERIFY_CB
+        #define WOLFSSL_ALWAYS_VERIFY_CB
+    #endif
+    #ifdef CONFIG_WOLFSSL_RPK_X509_FALLBACK
+        #define WOLFSSL_ESP_RPK_X509_FALLBACK
+    #endif
+    #ifdef CONFIG_WOLFSSL_RPK_DEFAULT
+        #define WOLFSSL_ESP_RPK_DEFAULT
+    #endif
+    #define ESP_WOLFSSL_RPK_PINS CONFIG_WOLFSSL_RPK_PINS
+#endif
+
+/* Session tickets without a session cache, see port/esp_wolfssl_ticket.h;
+ * servers issue tickets only with its callback installed */
+#ifdef CONFIG_WOLFSSL_SESSION_TICKETS
+    #define HAVE_SESSION_TICKET
+    #define WOLFSSL_NO_DEF_TICKET_ENC_CB
+    #define WOLFSSL_ESP_TICKET
+    #define ESP_WOLFSSL_TICKET_ROTATE_S CONFIG_WOLFSSL_SESSION_TICKET_ROTATE_S
+    #define ESP_WOLFSSL_TICKET_REPLAY   CONFIG_WOLFSSL_SESSION_TICKET_REPLAY
+#endif
+
+/* Pre-generated ephemeral keys, see port/esp_wolfssl_keypool.h */
+#ifdef CONFIG_WOLFSSL_KEYPOOL
+    #define WOLFSSL_ESP_KEYPOOL
+    #define ESP_WOLFSSL_KEYPOOL_KEYS CONFIG_WOLFSSL_KEYPOOL_KEYS
+    #ifdef CONFIG_WOLFSSL_KEYPOOL_X25519
+        #define ESP_WOLFSSL_KEYPOOL_X25519 1
+    #else
+        #define ESP_WOLFSSL_KEYPOOL_X25519 0
+    #endif
+    #ifdef CONFIG_WOLFSSL_KEYPOOL_P256
+        #define ESP_WOLFSSL_KEYPOOL_P256 1
+    #else
+        #define ESP_WOLFSSL_KEYPOOL_P256 0
+    #endif
+#endif
+
+/* Time-sliced ECC and RSA, see port/esp_wolfssl_nonblock.h; the RSA path
+ * needs USE_FAST_MATH, the default below */
+#ifdef CONFIG_WOLFSSL_NONBLOCK_PK
+    #define WOLFSSL_ESP_NONBLOCK
+    #define ESP_WOLFSSL_NB_SLICE_US CONFIG_WOLFSSL_NONBLOCK_SLICE_US
+    #define HAVE_PK_CALLBACKS
+    #define WC_RSA_NONBLOCK
+    /* all of P-256 moves to SP software, blocking operations included */
+    #define WOLFSSL_HAVE_SP_ECC
+    #define WOLFSSL_SP_SMALL
+    #define WOLFSSL_SP_NONBLOCK
+    #define WC_ECC_NONBLOCK
+#endif
+
+/* Shared TLS client contexts, see port/esp_wolfssl_ctx_cache.h */
+#ifdef CONFIG_WOLFSSL_CTX_CACHE
+    #define WOLFSSL_ESP_CTX_CACHE
+    #define ESP_WOLFSSL_CTX_CACHE_ENTRIES CONFIG_WOLFSSL_CTX_CACHE_ENTRIES
+    #ifdef CONFIG_WOLFSSL_CTX_CACHE_ESP_TLS
+        #define WOLFSSL_ESP_CTX_CACHE_STORES
+    #endif
+#endif
+
+/* Cipher-suite and group order per chip, see port/esp_wolfssl_hw_order.h */
+#ifdef CONFIG_WOLFSSL_HW_ORDER
+    #define WOLFSSL_ESP_HW_ORDER
+    #ifdef CONFIG_WOLFSSL_HW_ORDER_MEASURE
+        #define WOLFSSL_ESP_HW_ORDER_MEASURE
+    #endif
+    #ifdef CONFIG_WOLFSSL_HW_ORDER_DEFAULT
+        #define WOLFSSL_ESP_HW_ORDER_DEFAULT
+    #endif
+#endif
+
+/* Spinlocks and atomic reference counts, see port/esp_wolfssl_lock.h */
+#ifdef CONFIG_WOLFSSL_LIGHT_LOCKS
+    #define WOLFSSL_ESP_LIGHT_LOCKS
+    #define HAVE_C___ATOMIC 1
+    #define WOLFSSL_ATOMIC_OPS
+#endif
+
+/* Keyed HMAC hash states cached per key, see port/esp_wolfssl_hmac_cache.h */
+#ifdef CONFIG_WOLFSSL_HMAC_CACHE
+    #define WOLFSSL_ESP_HMAC_CACHE
+    #define ESP_WOLFSSL_HMAC_CACHE_KEYS CONFIG_WOLFSSL_HMAC_CACHE_KEYS
+#endif
+
+/* ECC peripheral of the C2, C6 and H2, see port/esp_wolfssl_ecc_hw.h */
+#ifdef CONFIG_WOLFSSL_ECC_HW
+    #define WOLFSSL_ESP_ECC_HW
+    #ifdef CONFIG_WOLFSSL_ECC_HW_SECRET
+        #define ESP_WOLFSSL_ECC_HW_SECRET 1
+    #endif
+#endif
+
 /* when you want to use AES counter mode */
 /* #define WOLFSSL_AES_DIRECT */
 /* #define WOLFSSL_AES_COUNTER */
@@ -409,13 +674,11 @@
     defined(WOLFSSL_SP_RISCV32)
 #endif
 
-#define WOLFSSL_SMALL_STACK
-
 
 #define HAVE_VERSION_EXTENDED_INFO
 /* #define HAVE_WC_INTROSPECTION */
 
-#ifndef NO_SESSION_CACHE
+#if !defined(NO_SESSION_CACHE) && !defined(HAVE_SESSION_TICKET)
     #define  HAVE_SESSION_TICKET
 #endif
 
@@ -855,6 +1118,12 @@ Turn on timer debugging (used when CPU cycles not available)
     #ifndef CONFIG_WOLFSSL_HAVE_TLS_13
         #define HAVE_CERTIFICATE_STATUS_REQUEST_V2
     #endif
+    #ifdef CONFIG_WOLFSSL_OCSP_CACHE
+        /* see port/esp_wolfssl_ocsp_cache.h */
+        #define WOLFSSL_ESP_OCSP_CACHE
+        #define ESP_WOLFSSL_OCSP_CACHE_ENTRIES  CONFIG_WOLFSSL_OCSP_CACHE_ENTRIES
+        #define ESP_WOLFSSL_OCSP_CACHE_RESP_MAX CONFIG_WOLFSSL_OCSP_CACHE_RESP_MAX
+    #endif
     #include <sys/socket.h>
     #include <netdb.h>
 #else
@@ -863,6 +1132,20 @@ Turn on timer debugging (used when CPU cycles not available)
     #endif
 #endif
 
+/** Optionally enable CRLs
+  */
+#ifdef CONFIG_WOLFSSL_HAVE_CRL
+    #define HAVE_CRL
+#endif
+#ifdef CONFIG_WOLFSSL_CRL_INDEX
+    /* see port/esp_wolfssl_crl_index.h; its verify callback runs for every
+     * certificate, not only on errors */
+    #define WOLFSSL_ESP_CRL_INDEX
+    #define WOLFSSL_ALWAYS_VERIFY_CB
+    #define ESP_WOLFSSL_CRL_INDEX_HASH_SZ CONFIG_WOLFSSL_CRL_INDEX_HASH_SZ
+    #define ESP_WOLFSSL_CRL_INDEX_MAX     CONFIG_WOLFSSL_CRL_INDEX_MAX
+#endif
+
 /** Only requires the peer certificate to validate to a trusted certificate.
   * If peer sends additional certificates not in the chain they are allowed,
   * but not trusted
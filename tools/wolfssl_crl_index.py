@@ -0,0 +1,184 @@
+#!/usr/bin/env python3
+#
+# Build a compact revocation index (port/esp_wolfssl_crl_index.h) from a CRL
+# ahead of time, for esp_wolfssl_crl_index_open() on the device.
+#
+# The device does not verify a prebuilt index, so give the issuer's
+# certificate with --ca to have the CRL signature checked here by openssl.
+# The output is the raw blob, e.g. to flash to a data partition, or with
+# --c-array a C header to compile into the firmware.
+#
+#   tools/wolfssl_crl_index.py ca.crl --ca ca.pem -o crl_index.bin
+#   tools/wolfssl_crl_index.py ca.crl --ca ca.pem --c-array crl_index \
+#       -o main/include/crl_index.h
+#
+
+import argparse
+import base64
+import calendar
+import hashlib
+import re
+import struct
+import subprocess
+import sys
+
+MAGIC = b'CRLX'
+VERSION = 1
+ISSUER_SZ = 16
+
+SEQUENCE = 0x30
+INTEGER = 0x02
+UTC_TIME = 0x17
+GENERALIZED_TIME = 0x18
+
+
+class DerError(Exception):
+    pass
+
+
+def der_next(buf, pos, end):
+    """Returns tag, start of contents, end of element."""
+    if pos + 2 > end:
+        raise DerError('truncated at %d' % pos)
+    tag = buf[pos]
+    length = buf[pos + 1]
+    pos += 2
+    if length & 0x80:
+        n = length & 0x7F
+        if n == 0 or n > 4 or pos + n > end:
+            raise DerError('bad length at %d' % pos)
+        length = int.from_bytes(buf[pos:pos + n], 'big')
+        pos += n
+    if pos + length > end:
+        raise DerError('truncated at %d' % pos)
+    return tag, pos, pos + length
+
+
+def der_time(tag, value):
+    text = value.decode('ascii')
+    if tag == UTC_TIME:
+        year = int(text[0:2])
+        text = ('19' if year >= 50 else '20') + text
+    elif tag != GENERALIZED_TIME:
+        raise DerError('not a time')
+    m = re.fullmatch(r'(\d{4})(\d\d)(\d\d)(\d\d)(\d\d)(\d\d)Z', text)
+    if not m:
+        raise DerError('unsupported time %s' % text)
+    return calendar.timegm(tuple(int(x) for x in m.groups()))
+
+
+def parse_crl(der):
+    """Issuer Name encoding, thisUpdate, nextUpdate or 0, serials."""
+    tag, pos, end = der_next(der, 0, len(der))
+    if tag != SEQUENCE:
+        raise DerError('not a CRL')
+    tag, pos, end = der_next(der, pos, end)     # tbsCertList
+    if tag != SEQUENCE:
+        raise DerError('not a CRL')
+
+    tag, start, stop = der_next(der, pos, end)
+    if tag == INTEGER:                          # version
+        pos = stop
+    pos = der_next(der, pos, end)[2]            # signature
+    issuer_start = pos
+    pos = der_next(der, pos, end)[2]
+    issuer = der[issuer_start:pos]
+
+    tag, start, pos = der_next(der, pos, end)
+    this_update = der_time(tag, der[start:pos])
+    next_update = 0
+    serials = []
+    if pos < end:
+        tag, start, stop = der_next(der, pos, end)
+        if tag in (UTC_TIME, GENERALIZED_TIME):
+            next_update = der_time(tag, der[start:stop])
+            pos = stop
+    if pos < end:
+        tag, start, stop = der_next(der, pos, end)
+        if tag == SEQUENCE:                     # revokedCertificates
+            while start < stop:
+                tag, e_start, e_stop = der_next(der, start, stop)
+                tag, s_start, s_stop = der_next(der, e_start, e_stop)
+                if tag != INTEGER:
+                    raise DerError('bad revoked entry at %d' % start)
+                serials.append(der[s_start:s_stop])
+                start = e_stop
+    return issuer, this_update, next_update, serials
+
+
+def build_index(der, hash_sz):
+    issuer, this_update, next_update, serials = parse_crl(der)
+    entries = sorted(hashlib.sha256(s).digest()[:hash_sz] for s in serials)
+    header = MAGIC + struct.pack('<BBHII qq', VERSION, hash_sz, 0,
+                                 len(entries), 0, this_update, next_update)
+    header += hashlib.sha256(issuer).digest()[:ISSUER_SZ]
+    return header + b''.join(entries), len(entries)
+
+
+def read_crl(path):
+    with open(path, 'rb') as f:
+        data = f.read()
+    m = re.search(rb'-----BEGIN X509 CRL-----(.*?)-----END X509 CRL-----',
+                  data, re.S)
+    if m:
+        return base64.b64decode(b''.join(m.group(1).split())), 'PEM'
+    return data, 'DER'
+
+
+def verify(path, form, ca):
+    result = subprocess.run(['openssl', 'crl', '-in', path, '-inform', form,
+                             '-CAfile', ca, '-noout'],
+                            stdout=subprocess.PIPE, stderr=subprocess.STDOUT)
+    if result.returncode != 0:
+        sys.exit('CRL does not verify with %s:\n%s'
+                 % (ca, result.stdout.decode(errors='replace')))
+
+
+def c_array(name, blob, out):
+    out.write('/* generated by tools/wolfssl_crl_index.py */\n\n')
+    out.write('static const unsigned char %s[] =\n{\n' % name)
+    for i in range(0, len(blob), 12):
+        out.write('    %s,\n' % ', '.join('0x%02X' % b
+                                          for b in blob[i:i + 12]))
+    out.write('};\nstatic const int sizeof_%s = sizeof(%s);\n' % (name, name))
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description='Build a compact CRL index for esp_wolfssl_crl_index')
+    parser.add_argument('crl', help='CRL, DER or PEM')
+    parser.add_argument('-o', '--output', required=True)
+    parser.add_argument('--ca',
+                        help='issuer certificate, PEM; verifies the CRL')
+    parser.add_argument('--hash-size', type=int, default=4,
+                        help='bytes per entry, 4 to 32 (default 4)')
+    parser.add_argument('--c-array', metavar='NAME',
+                        help='write a C header with the array NAME')
+    args = parser.parse_args()
+
+    if not 4 <= args.hash_size <= 32:
+        sys.exit('--hash-size must be 4 to 32')
+
+    der, form = read_crl(args.crl)
+    if args.ca:
+        verify(args.crl, form, args.ca)
+    else:
+        sys.stderr.write('warning: CRL signature not verified, use --ca\n')
+
+    try:
+        blob, count = build_index(der, args.hash_size)
+    except DerError as e:
+        sys.exit('%s: %s' % (args.crl, e))
+
+    if args.c_array:
+        with open(args.output, 'w') as out:
+            c_array(args.c_array, blob, out)
+    else:
+        with open(args.output, 'wb') as out:
+            out.write(blob)
+
+    sys.stderr.write('%d entries, %d bytes\n' % (count, len(blob)))
+
+
+if __name__ == '__main__':
+    main()
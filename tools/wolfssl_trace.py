@@ -0,0 +1,215 @@
+#!/usr/bin/env python3
+#
+# Convert a wolfSSL handshake trace (port/esp_wolfssl_trace.h) to the Chrome
+# trace event format, for chrome://tracing or https://ui.perfetto.dev
+#
+# The input is the idf.py monitor log with the output of
+# esp_wolfssl_trace_dump(), or the file written by OpenOCD for
+# esp_wolfssl_trace_dump_apptrace(). Everything outside the
+# WTRC-START / WTRC-END lines is ignored; the last dump in the input is used.
+#
+#   tools/wolfssl_trace.py monitor.log -o handshake.json --summary
+#
+
+import argparse
+import json
+import re
+import sys
+
+START_RE = re.compile(r'WTRC-START hz=(\d+) events=(\d+) dropped=(\d+)')
+EVENT_RE = re.compile(r'WTRC (\d+) (\d+) ([BEi]) ([0-9a-fA-F]{8}) (\w+) (\d+)')
+
+CONTENT_TYPES = {
+    20: 'ChangeCipherSpec',
+    21: 'Alert',
+    22: 'Handshake',
+    23: 'ApplicationData',
+}
+
+HANDSHAKE_TYPES = {
+    0: 'HelloRequest',
+    1: 'ClientHello',
+    2: 'ServerHello',
+    3: 'HelloVerifyRequest',
+    4: 'NewSessionTicket',
+    5: 'EndOfEarlyData',
+    8: 'EncryptedExtensions',
+    11: 'Certificate',
+    12: 'ServerKeyExchange',
+    13: 'CertificateRequest',
+    14: 'ServerHelloDone',
+    15: 'CertificateVerify',
+    16: 'ClientKeyExchange',
+    20: 'Finished',
+    22: 'CertificateStatus',
+    24: 'KeyUpdate',
+    254: 'MessageHash',
+}
+
+# keygen / ecdh argument: wolfSSL ecc_curve_id, or 25519 for X25519
+CURVES = {
+    7: 'SECP256R1',
+    15: 'SECP384R1',
+    16: 'SECP521R1',
+    25519: 'X25519',
+}
+
+
+def read_dump(lines):
+    hz = None
+    events = []
+    dropped = 0
+    inside = False
+    for line in lines:
+        m = START_RE.search(line)
+        if m:
+            hz = int(m.group(1))
+            dropped = int(m.group(3))
+            events = []
+            inside = True
+            continue
+        if not inside:
+            continue
+        if 'WTRC-END' in line:
+            inside = False
+            continue
+        m = EVENT_RE.search(line)
+        if m:
+            events.append((int(m.group(1)), int(m.group(2)), m.group(3),
+                           int(m.group(4), 16), m.group(5), int(m.group(6))))
+    return hz, events, dropped
+
+
+def unwrap(events):
+    """32-bit cycle counters wrap; assume less than one wrap between two
+    consecutive events on the same core."""
+    last = {}
+    high = {}
+    out = []
+    for cycles, core, phase, conn, name, arg in events:
+        if core in last and cycles < last[core]:
+            high[core] = high.get(core, 0) + (1 << 32)
+        last[core] = cycles
+        out.append((cycles + high.get(core, 0), core, phase, conn, name, arg))
+    return out
+
+
+def signed(value):
+    return value - (1 << 32) if value & 0x80000000 else value
+
+
+def msg_name(name, arg):
+    content = (arg >> 24) & 0xFF
+    msg = (arg >> 16) & 0xFF
+    arrow = '->' if name == 'msg_out' else '<-'
+    if content == 22:
+        label = HANDSHAKE_TYPES.get(msg, 'Handshake(%d)' % msg)
+    elif content == 21:
+        label = 'Alert(%d)' % msg
+    else:
+        label = CONTENT_TYPES.get(content, 'Record(%d)' % content)
+    return '%s %s' % (arrow, label), arg & 0xFFFF
+
+
+def to_chrome(hz, events):
+    trace = []
+    origin = events[0][0] if events else 0
+    conns = set()
+
+    for cycles, core, phase, conn, name, arg in events:
+        ts = (cycles - origin) * 1e6 / hz
+        conns.add(conn)
+        ev = {'pid': 1, 'tid': conn, 'ts': ts, 'ph': phase,
+              'args': {'core': core}}
+        if name in ('msg_in', 'msg_out'):
+            ev['name'], ev['args']['len'] = msg_name(name, arg)
+            ev['cat'] = 'msg'
+            ev['s'] = 't'
+        else:
+            ev['name'] = name
+            if name.startswith('net_'):
+                ev['cat'] = 'net'
+            elif name in ('handshake', 'user'):
+                ev['cat'] = 'tls'
+            else:
+                ev['cat'] = 'crypto'
+            if phase == 'E':
+                ev['args']['ret'] = signed(arg)
+            elif name in ('keygen', 'ecdh'):
+                ev['args']['curve'] = CURVES.get(arg, str(arg))
+            else:
+                ev['args']['arg'] = arg
+        trace.append(ev)
+
+    trace.append({'pid': 1, 'ph': 'M', 'name': 'process_name',
+                  'args': {'name': 'wolfSSL'}})
+    for conn in sorted(conns):
+        label = 'conn %08x' % conn if conn else 'no connection'
+        trace.append({'pid': 1, 'tid': conn, 'ph': 'M',
+                      'name': 'thread_name', 'args': {'name': label}})
+
+    return {'traceEvents': trace, 'displayTimeUnit': 'ns'}
+
+
+def summary(hz, events, out):
+    """Exclusive time per event name and connection."""
+    stacks = {}
+    totals = {}
+    for cycles, core, phase, conn, name, arg in events:
+        stack = stacks.setdefault(conn, [])
+        if phase == 'B':
+            if stack:
+                stack[-1][2] += cycles - stack[-1][3]
+            stack.append([name, cycles, 0, cycles])
+        elif phase == 'E' and stack and stack[-1][0] == name:
+            top = stack.pop()
+            top[2] += cycles - top[3]
+            key = (conn, name)
+            count, excl = totals.get(key, (0, 0))
+            totals[key] = (count + 1, excl + top[2])
+            if stack:
+                stack[-1][3] = cycles
+
+    for (conn, name), (count, excl) in sorted(totals.items()):
+        out.write('conn %08x  %-12s %5d x  %10.3f ms\n'
+                  % (conn, name, count, excl * 1e3 / hz))
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description='Convert a wolfSSL trace dump to Chrome trace JSON')
+    parser.add_argument('input', nargs='?', default='-',
+                        help='log file, default stdin')
+    parser.add_argument('-o', '--output', default='-',
+                        help='JSON output file, default stdout')
+    parser.add_argument('--hz', type=int,
+                        help='override the cycle counter frequency')
+    parser.add_argument('--summary', action='store_true',
+                        help='print exclusive time per phase to stderr')
+    args = parser.parse_args()
+
+    src = sys.stdin if args.input == '-' else open(args.input, errors='replace')
+    with src:
+        hz, events, dropped = read_dump(src)
+
+    if hz is None:
+        sys.exit('no WTRC-START line found')
+    if args.hz:
+        hz = args.hz
+    if dropped:
+        sys.stderr.write('warning: %d events were overwritten, increase '
+                         'WOLFSSL_TRACE_EVENTS\n' % dropped)
+
+    events = unwrap(events)
+    result = to_chrome(hz, events)
+
+    dst = sys.stdout if args.output == '-' else open(args.output, 'w')
+    with dst:
+        json.dump(result, dst)
+
+    if args.summary:
+        summary(hz, events, sys.stderr)
+
+
+if __name__ == '__main__':
+    main()